@@ -22,6 +22,10 @@ namespace {
 base::LazyInstance<base::ThreadLocalPointer<MessagePumpMojo> >::Leaky
     g_tls_current_pump = LAZY_INSTANCE_INITIALIZER;
 
+// The maximum number of ready handles retrieved (and dispatched) per call to
+// DoInternalWork().
+const uint32_t kMaxReadyHandles = 16;
+
 MojoDeadline TimeTicksToMojoDeadline(base::TimeTicks time_ticks,
                                      base::TimeTicks now) {
   // The is_null() check matches that of HandleWatcher as well as how
@@ -35,13 +39,6 @@ MojoDeadline TimeTicksToMojoDeadline(base::TimeTicks time_ticks,
 
 }  // namespace
 
-// State needed for one iteration of WaitMany. The first handle and flags
-// corresponds to that of the control pipe.
-struct MessagePumpMojo::WaitState {
-  std::vector<Handle> handles;
-  std::vector<MojoHandleSignals> wait_signals;
-};
-
 struct MessagePumpMojo::RunState {
   RunState() : should_quit(false) {
     CreateMessagePipe(NULL, &read_handle, &write_handle);
@@ -53,17 +50,20 @@ struct MessagePumpMojo::RunState {
   ScopedMessagePipeHandle read_handle;
   ScopedMessagePipeHandle write_handle;
 
-  // Cached structures to avoid the heap allocation cost of std::vector<>.
-  scoped_ptr<WaitState> wait_state;
+  // Cached structure to avoid the heap allocation cost of std::vector<>.
   scoped_ptr<HandleToHandlerList> cloned_handlers;
 
   bool should_quit;
 };
 
-MessagePumpMojo::MessagePumpMojo() : run_state_(NULL), next_handler_id_(0) {
+MessagePumpMojo::MessagePumpMojo()
+    : run_state_(NULL), num_handlers_with_deadline_(0), next_handler_id_(0) {
   DCHECK(!current())
       << "There is already a MessagePumpMojo instance on this thread.";
   g_tls_current_pump.Pointer()->Set(this);
+
+  // TODO: better deal with error handling.
+  CHECK_EQ(MOJO_RESULT_OK, CreateWaitSet(&wait_set_));
 }
 
 MessagePumpMojo::~MessagePumpMojo() {
@@ -94,11 +94,16 @@ void MessagePumpMojo::AddHandler(MessagePumpMojoHandler* handler,
   handler_data.wait_signals = wait_signals;
   handler_data.deadline = deadline;
   handler_data.id = next_handler_id_++;
+  CHECK_EQ(MOJO_RESULT_OK, AddHandle(wait_set_.get(), handle, wait_signals));
   handlers_[handle] = handler_data;
+  if (!deadline.is_null())
+    num_handlers_with_deadline_++;
 }
 
 void MessagePumpMojo::RemoveHandler(const Handle& handle) {
-  handlers_.erase(handle);
+  HandleToHandler::iterator it = handlers_.find(handle);
+  if (it != handlers_.end())
+    EraseHandler(it);
 }
 
 void MessagePumpMojo::AddObserver(Observer* observer) {
@@ -120,7 +125,23 @@ void MessagePumpMojo::Run(Delegate* delegate) {
     old_state = run_state_;
     run_state_ = &run_state;
   }
+  // Only the control pipe of the innermost Run() is waited on (since only it is
+  // signalled).
+  if (old_state) {
+    CHECK_EQ(MOJO_RESULT_OK,
+             RemoveHandle(wait_set_.get(), old_state->read_handle.get()));
+  }
+  CHECK_EQ(MOJO_RESULT_OK,
+           AddHandle(wait_set_.get(), run_state.read_handle.get(),
+                     MOJO_HANDLE_SIGNAL_READABLE));
   DoRunLoop(&run_state, delegate);
+  CHECK_EQ(MOJO_RESULT_OK,
+           RemoveHandle(wait_set_.get(), run_state.read_handle.get()));
+  if (old_state) {
+    CHECK_EQ(MOJO_RESULT_OK,
+             AddHandle(wait_set_.get(), old_state->read_handle.get(),
+                       MOJO_HANDLE_SIGNAL_READABLE));
+  }
   {
     base::AutoLock auto_lock(run_state_lock_);
     run_state_ = old_state;
@@ -175,57 +196,27 @@ void MessagePumpMojo::DoRunLoop(RunState* run_state, Delegate* delegate) {
 }
 
 bool MessagePumpMojo::DoInternalWork(const RunState& run_state, bool block) {
-  const MojoDeadline deadline = block ? GetDeadlineForWait(run_state) : 0;
-  if (!run_state_->wait_state)
-    run_state_->wait_state.reset(new WaitState);
-  GetWaitState(run_state, run_state_->wait_state.get());
-
-  const WaitManyResult wait_many_result =
-      WaitMany(run_state_->wait_state->handles,
-               run_state_->wait_state->wait_signals, deadline, nullptr);
-  const MojoResult result = wait_many_result.result;
-  bool did_work = true;
-  if (result == MOJO_RESULT_OK) {
-    if (wait_many_result.index == 0) {
-      // Control pipe was written to.
-      ReadMessageRaw(run_state.read_handle.get(), NULL, NULL, NULL, NULL,
-                     MOJO_READ_MESSAGE_FLAG_MAY_DISCARD);
-    } else {
-      DCHECK(handlers_.find(
-                 run_state_->wait_state->handles[wait_many_result.index]) !=
-             handlers_.end());
-      WillSignalHandler();
-      handlers_[run_state_->wait_state->handles[wait_many_result.index]]
-          .handler->OnHandleReady(
-              run_state_->wait_state->handles[wait_many_result.index]);
-      DidSignalHandler();
-    }
-  } else {
-    switch (result) {
-      case MOJO_RESULT_CANCELLED:
-      case MOJO_RESULT_FAILED_PRECONDITION:
-        RemoveInvalidHandle(*run_state_->wait_state, result,
-                            wait_many_result.index);
-        break;
-      case MOJO_RESULT_DEADLINE_EXCEEDED:
-        did_work = false;
-        break;
-      default:
-        base::debug::Alias(&result);
-        // Unexpected result is likely fatal, crash so we can determine cause.
-        CHECK(false);
-    }
+  bool did_work = false;
+  MojoResult result = MOJO_RESULT_OK;
+  if (block) {
+    result = Wait(wait_set_.get(), MOJO_HANDLE_SIGNAL_READABLE,
+                  GetDeadlineForWait(run_state), nullptr);
   }
-  // To keep memory usage under control, delete the WaitState object at the end
-  // if it's vectors are too big by a factor of 2. Pre-C++11 doesn't have a way
-  // to shrink vectors, so just get rid of them and re-create on the next round.
-  if (run_state_->wait_state->handles.capacity() >
-      2 * run_state_->wait_state->handles.size()) {
-    // NOTE: |handles| and |wait_signals| are always in sync, so it's reasonable
-    // to only check one of those.
-    run_state_->wait_state.reset();
+  switch (result) {
+    case MOJO_RESULT_OK:
+      did_work = DispatchReadyHandles(run_state);
+      break;
+    case MOJO_RESULT_DEADLINE_EXCEEDED:
+      break;
+    default:
+      base::debug::Alias(&result);
+      // Unexpected result is likely fatal, crash so we can determine cause.
+      CHECK(false);
   }
 
+  if (!num_handlers_with_deadline_)
+    return did_work;
+
   // Notify and remove any handlers whose time has expired. Make a copy in case
   // someone tries to add/remove new handlers from notification.
   if (!run_state_->cloned_handlers) {
@@ -249,7 +240,7 @@ bool MessagePumpMojo::DoInternalWork(const RunState& run_state, bool block) {
       WillSignalHandler();
       i->second.handler->OnHandleError(i->first, MOJO_RESULT_DEADLINE_EXCEEDED);
       DidSignalHandler();
-      handlers_.erase(i->first);
+      RemoveHandler(i->first);
       did_work = true;
     }
   }
@@ -260,25 +251,80 @@ bool MessagePumpMojo::DoInternalWork(const RunState& run_state, bool block) {
   return did_work;
 }
 
-void MessagePumpMojo::RemoveInvalidHandle(const WaitState& wait_state,
-                                          MojoResult result,
-                                          uint32_t index) {
-  // TODO(sky): deal with control pipe going bad.
+bool MessagePumpMojo::DispatchReadyHandles(const RunState& run_state) {
+  uint32_t num_ready = kMaxReadyHandles;
+  Handle handles[kMaxReadyHandles];
+  MojoResult results[kMaxReadyHandles];
+  MojoResult result = GetReadyHandles(wait_set_.get(), &num_ready, handles,
+                                      results, nullptr);
+  if (result == MOJO_RESULT_SHOULD_WAIT)
+    return false;
+  if (result != MOJO_RESULT_OK) {
+    base::debug::Alias(&result);
+    // Unexpected result is likely fatal, crash so we can determine cause.
+    CHECK(false);
+  }
+
+  // Notifying a handler may add/remove handlers, so first record the id of the
+  // handler for each handle, and then only notify handlers whose id matches.
+  int ids[kMaxReadyHandles];
+  for (uint32_t i = 0; i < num_ready; i++) {
+    ids[i] = -1;
+    if (handles[i].value() == run_state.read_handle.get().value()) {
+      // TODO(sky): deal with control pipe going bad.
+      CHECK_EQ(MOJO_RESULT_OK, results[i]);
+      // Control pipe was written to.
+      ReadMessageRaw(run_state.read_handle.get(), NULL, NULL, NULL, NULL,
+                     MOJO_READ_MESSAGE_FLAG_MAY_DISCARD);
+      continue;
+    }
+    HandleToHandler::const_iterator it = handlers_.find(handles[i]);
+    DCHECK(it != handlers_.end());
+    if (it != handlers_.end())
+      ids[i] = it->second.id;
+  }
+
+  for (uint32_t i = 0; i < num_ready; i++) {
+    const Handle& handle = handles[i];
+    HandleToHandler::const_iterator it = handlers_.find(handle);
+    if (ids[i] == -1 || it == handlers_.end() || it->second.id != ids[i])
+      continue;
+    if (results[i] == MOJO_RESULT_OK) {
+      WillSignalHandler();
+      it->second.handler->OnHandleReady(handle);
+      DidSignalHandler();
+    } else {
+      RemoveInvalidHandle(results[i], handle);
+    }
+  }
+  return true;
+}
+
+void MessagePumpMojo::RemoveInvalidHandle(MojoResult result,
+                                          const Handle& handle) {
   CHECK(result == MOJO_RESULT_FAILED_PRECONDITION ||
         result == MOJO_RESULT_CANCELLED);
-  CHECK_NE(index, 0u);  // Indicates the control pipe went bad.
 
   // Remove the handle first, this way if OnHandleError() tries to remove the
   // handle our iterator isn't invalidated.
-  CHECK(handlers_.find(wait_state.handles[index]) != handlers_.end());
-  MessagePumpMojoHandler* handler =
-      handlers_[wait_state.handles[index]].handler;
-  handlers_.erase(wait_state.handles[index]);
+  HandleToHandler::iterator it = handlers_.find(handle);
+  CHECK(it != handlers_.end());
+  MessagePumpMojoHandler* handler = it->second.handler;
+  EraseHandler(it);
   WillSignalHandler();
-  handler->OnHandleError(wait_state.handles[index], result);
+  handler->OnHandleError(handle, result);
   DidSignalHandler();
 }
 
+void MessagePumpMojo::EraseHandler(HandleToHandler::iterator it) {
+  // If the handle was closed, the wait set will already have dropped it after
+  // reporting it (as cancelled), in which case this fails harmlessly.
+  RemoveHandle(wait_set_.get(), it->first);
+  if (!it->second.deadline.is_null())
+    num_handlers_with_deadline_--;
+  handlers_.erase(it);
+}
+
 void MessagePumpMojo::SignalControlPipe(const RunState& run_state) {
   const MojoResult result =
       WriteMessageRaw(run_state.write_handle.get(), NULL, 0, NULL, 0,
@@ -288,29 +334,13 @@ void MessagePumpMojo::SignalControlPipe(const RunState& run_state) {
   CHECK_EQ(MOJO_RESULT_OK, result);
 }
 
-void MessagePumpMojo::GetWaitState(
-    const RunState& run_state,
-    MessagePumpMojo::WaitState* wait_state) const {
-  const size_t num_handles = handlers_.size() + 1;
-  wait_state->handles.clear();
-  wait_state->handles.reserve(num_handles);
-  wait_state->wait_signals.clear();
-  wait_state->wait_signals.reserve(num_handles);
-  wait_state->handles.push_back(run_state.read_handle.get());
-  wait_state->wait_signals.push_back(MOJO_HANDLE_SIGNAL_READABLE);
-
-  for (HandleToHandler::const_iterator i = handlers_.begin();
-       i != handlers_.end(); ++i) {
-    wait_state->handles.push_back(i->first);
-    wait_state->wait_signals.push_back(i->second.wait_signals);
-  }
-}
-
 MojoDeadline MessagePumpMojo::GetDeadlineForWait(
     const RunState& run_state) const {
   const base::TimeTicks now(internal::NowTicks());
   MojoDeadline deadline = TimeTicksToMojoDeadline(run_state.delayed_work_time,
                                                   now);
+  if (!num_handlers_with_deadline_)
+    return deadline;
   for (HandleToHandler::const_iterator i = handlers_.begin();
        i != handlers_.end(); ++i) {
     deadline = std::min(
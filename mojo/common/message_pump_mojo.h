@@ -5,6 +5,8 @@
 #ifndef MOJO_COMMON_MESSAGE_PUMP_MOJO_H_
 #define MOJO_COMMON_MESSAGE_PUMP_MOJO_H_
 
+#include <stddef.h>
+
 #include <map>
 #include <utility>
 #include <vector>
@@ -22,7 +24,9 @@ namespace common {
 
 class MessagePumpMojoHandler;
 
-// Mojo implementation of MessagePump.
+// Mojo implementation of MessagePump. Handles are kept in a wait set (see
+// mojo/public/c/system/wait_set.h), so the cost of each iteration depends on
+// the number of ready handles rather than on the number of registered ones.
 class MessagePumpMojo : public base::MessagePump {
  public:
   class Observer {
@@ -69,7 +73,6 @@ class MessagePumpMojo : public base::MessagePump {
 
  private:
   struct RunState;
-  struct WaitState;
 
   // Contains the data needed to track a request to AddHandler().
   struct Handler {
@@ -93,17 +96,21 @@ class MessagePumpMojo : public base::MessagePump {
   // handle has become ready, |false| otherwise.
   bool DoInternalWork(const RunState& run_state, bool block);
 
-  // Removes the given invalid handle. This is called if MojoWaitMany finds an
-  // invalid handle.
-  void RemoveInvalidHandle(const WaitState& wait_state,
-                           MojoResult result,
-                           uint32_t result_index);
+  // Notifies the handlers of (some of) the ready handles in |wait_set_|.
+  // Returns |true| if any handle was ready, |false| otherwise.
+  bool DispatchReadyHandles(const RunState& run_state);
 
-  void SignalControlPipe(const RunState& run_state);
+  // Removes the given invalid handle. This is called if MojoGetReadyHandles
+  // reports an invalid handle.
+  void RemoveInvalidHandle(MojoResult result, const Handle& handle);
+
+  // Removes the handler at |it| from |handlers_| and its handle from
+  // |wait_set_|.
+  void EraseHandler(HandleToHandler::iterator it);
 
-  void GetWaitState(const RunState& run_state, WaitState* wait_state) const;
+  void SignalControlPipe(const RunState& run_state);
 
-  // Returns the deadline for the call to MojoWaitMany().
+  // Returns the deadline for the call to MojoWait() on |wait_set_|.
   MojoDeadline GetDeadlineForWait(const RunState& run_state) const;
 
   void WillSignalHandler();
@@ -120,6 +127,14 @@ class MessagePumpMojo : public base::MessagePump {
 
   HandleToHandler handlers_;
 
+  // Contains the handles of |handlers_|, plus the control pipe of the innermost
+  // Run().
+  ScopedWaitSetHandle wait_set_;
+
+  // The number of handlers in |handlers_| with a (non-null) deadline. Handler
+  // deadlines are only scanned if this is nonzero.
+  size_t num_handlers_with_deadline_;
+
   // An ever increasing value assigned to each Handler::id. Used to detect
   // uniqueness while notifying. That is, while notifying expired timers we copy
   // |handlers_| and only notify handlers whose id match. If the id does not
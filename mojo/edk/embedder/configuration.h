@@ -38,6 +38,10 @@ struct Configuration {
   // message pipes. The default is 10,000.
   size_t max_message_num_handles;
 
+  // Maximum number of messages that can be written at once using
+  // |MojoWriteMessages()|. The default is 10,000.
+  size_t max_write_messages_num_messages;
+
   // Maximum capacity of a data pipe, in bytes. The default is 256MB. This value
   // must fit into a |uint32_t|. WARNING: If you bump it closer to 2^32, you
   // must audit all the code to check that we don't overflow (2^31 would
@@ -60,6 +64,26 @@ struct Configuration {
   // (This will also entail some auditing to make sure I'm not messing up my
   // checks anywhere.)
   size_t max_shared_memory_num_bytes;
+
+  // Minimum capacity, in bytes, of data pipes whose data is passed between
+  // processes through a ring buffer in shared memory (mapped by both the
+  // producer and the consumer) instead of in messages; only small
+  // notifications of how much data was written/consumed then go over the OS
+  // channel, and two-phase reads/writes operate directly on the ring. The
+  // other process retains write access to the ring, so this should only be
+  // enabled between processes that trust each other. Must be nonzero to have
+  // any effect. The default is 0 (disabled).
+  size_t min_shared_memory_data_pipe_capacity_bytes;
+
+  // Maximum number of iterations for which a thread waiting for a handle
+  // (e.g., in |MojoWait()|) spins, checking whether it has been woken up,
+  // before blocking. When the wake-up comes soon enough (e.g., a ping-pong
+  // between threads), this saves putting the thread to sleep and waking it
+  // again. The waiting thread yields periodically while spinning. The number of
+  // iterations actually used adapts (between 1/16 of this value and this
+  // value): it grows when spinning ends in a wake-up and shrinks when it
+  // doesn't. Must be nonzero to have any effect. The default is 0 (never spin).
+  size_t max_waiter_spin_iterations;
 };
 
 }  // namespace embedder
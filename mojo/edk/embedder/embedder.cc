@@ -13,6 +13,7 @@
 #include "base/task_runner.h"
 #include "mojo/edk/embedder/embedder_internal.h"
 #include "mojo/edk/embedder/master_process_delegate.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
 #include "mojo/edk/embedder/platform_support.h"
 #include "mojo/edk/embedder/process_delegate.h"
 #include "mojo/edk/embedder/slave_process_delegate.h"
@@ -24,6 +25,7 @@
 #include "mojo/edk/system/message_pipe_dispatcher.h"
 #include "mojo/edk/system/platform_handle_dispatcher.h"
 #include "mojo/edk/system/raw_channel.h"
+#include "mojo/edk/system/shared_buffer_dispatcher.h"
 
 namespace mojo {
 namespace embedder {
@@ -138,6 +140,31 @@ MojoResult PassWrappedPlatformHandle(MojoHandle platform_handle_wrapper_handle,
   return MOJO_RESULT_OK;
 }
 
+MojoResult CreateSharedBufferWrapper(
+    scoped_refptr<PlatformSharedBuffer> shared_buffer,
+    MojoHandle* shared_buffer_handle) {
+  DCHECK(shared_buffer);
+  DCHECK(shared_buffer_handle);
+
+  scoped_refptr<system::SharedBufferDispatcher> dispatcher;
+  MojoResult result =
+      system::SharedBufferDispatcher::CreateFromPlatformSharedBuffer(
+          shared_buffer, &dispatcher);
+  if (result != MOJO_RESULT_OK)
+    return result;
+
+  DCHECK(internal::g_core);
+  MojoHandle h = internal::g_core->AddDispatcher(dispatcher);
+  if (h == MOJO_HANDLE_INVALID) {
+    LOG(ERROR) << "Handle table full";
+    dispatcher->Close();
+    return MOJO_RESULT_RESOURCE_EXHAUSTED;
+  }
+
+  *shared_buffer_handle = h;
+  return MOJO_RESULT_OK;
+}
+
 void InitIPCSupport(ProcessType process_type,
                     scoped_refptr<base::TaskRunner> delegate_thread_task_runner,
                     ProcessDelegate* process_delegate,
@@ -22,6 +22,7 @@ namespace mojo {
 namespace embedder {
 
 struct Configuration;
+class PlatformSharedBuffer;
 class PlatformSupport;
 class ProcessDelegate;
 
@@ -68,6 +69,14 @@ MOJO_SYSTEM_IMPL_EXPORT MojoResult
 PassWrappedPlatformHandle(MojoHandle platform_handle_wrapper_handle,
                           ScopedPlatformHandle* platform_handle);
 
+// Creates a shared buffer |MojoHandle| that wraps the given (non-null)
+// |PlatformSharedBuffer|. This allows the embedder to hand out shared buffers
+// that it created itself, e.g., ones backed by a file (see
+// |FilePlatformSharedBuffer|).
+MOJO_SYSTEM_IMPL_EXPORT MojoResult
+CreateSharedBufferWrapper(scoped_refptr<PlatformSharedBuffer> shared_buffer,
+                          MojoHandle* shared_buffer_handle);
+
 // Initialialization/shutdown for interprocess communication (IPC) -------------
 
 // |InitIPCSupport()| sets up the subsystem for interprocess communication,
@@ -4,14 +4,19 @@
 
 #include "mojo/edk/embedder/embedder.h"
 
+#include <fcntl.h>
 #include <string.h>
 
 #include "base/bind.h"
 #include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/message_loop/message_loop.h"
+#include "base/posix/eintr_wrapper.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/test/test_io_thread.h"
 #include "base/test/test_timeouts.h"
@@ -23,6 +28,7 @@
 #include "mojo/public/c/system/core.h"
 #include "mojo/public/cpp/system/handle.h"
 #include "mojo/public/cpp/system/message_pipe.h"
+#include "mojo/public/platform/native/platform_handle_private.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace mojo {
@@ -377,6 +383,118 @@ TEST_F(EmbedderTest, ChannelsHandlePassing) {
   EXPECT_TRUE(client_channel.channel_info());
 }
 
+#if !defined(OS_ANDROID)
+// Tests that a shared buffer backed by a file can be created, passed over a
+// channel, and mapped (read-write) on the other side, but that one backed by a
+// read-only file isn't accepted on the other side.
+TEST_F(EmbedderTest, FileBackedSharedBuffer) {
+  mojo::test::ScopedIPCSupport ipc_support(test_io_task_runner());
+
+  static const char kContents[] = "file contents";
+  const uint32_t kNumBytes = static_cast<uint32_t>(sizeof(kContents));
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath path = temp_dir.path().Append("file");
+  ASSERT_EQ(static_cast<int>(kNumBytes),
+            base::WriteFile(path, kContents, static_cast<int>(kNumBytes)));
+
+  PlatformChannelPair channel_pair;
+  ScopedTestChannel server_channel(channel_pair.PassServerHandle());
+  MojoHandle server_mp = server_channel.bootstrap_message_pipe();
+  EXPECT_NE(server_mp, MOJO_HANDLE_INVALID);
+  ScopedTestChannel client_channel(channel_pair.PassClientHandle());
+  MojoHandle client_mp = client_channel.bootstrap_message_pipe();
+  EXPECT_NE(client_mp, MOJO_HANDLE_INVALID);
+
+  // Read-write:
+  {
+    int fd = HANDLE_EINTR(open(path.value().c_str(), O_RDWR));
+    ASSERT_GE(fd, 0);
+    MojoHandle buffer_handle = MOJO_HANDLE_INVALID;
+    EXPECT_EQ(MOJO_RESULT_OK, MojoCreateSharedBufferFromPlatformHandle(
+                                  fd, kNumBytes, &buffer_handle));
+    EXPECT_NE(buffer_handle, MOJO_HANDLE_INVALID);
+
+    // Send the shared buffer handle from |server_mp| to |client_mp|.
+    EXPECT_EQ(MOJO_RESULT_OK,
+              MojoWriteMessage(server_mp, nullptr, 0, &buffer_handle, 1,
+                               MOJO_WRITE_MESSAGE_FLAG_NONE));
+    buffer_handle = MOJO_HANDLE_INVALID;
+    EXPECT_EQ(MOJO_RESULT_OK, MojoWait(client_mp, MOJO_HANDLE_SIGNAL_READABLE,
+                                       MOJO_DEADLINE_INDEFINITE, nullptr));
+    uint32_t num_handles = 1;
+    EXPECT_EQ(MOJO_RESULT_OK,
+              MojoReadMessage(client_mp, nullptr, nullptr, &buffer_handle,
+                              &num_handles, MOJO_READ_MESSAGE_FLAG_NONE));
+    EXPECT_EQ(1u, num_handles);
+    EXPECT_NE(buffer_handle, MOJO_HANDLE_INVALID);
+
+    // Map it, check its contents, and write to it.
+    void* pointer = nullptr;
+    EXPECT_EQ(MOJO_RESULT_OK,
+              MojoMapBuffer(buffer_handle, 0, kNumBytes, &pointer,
+                            MOJO_MAP_BUFFER_FLAG_NONE));
+    ASSERT_TRUE(pointer);
+    EXPECT_STREQ(kContents, static_cast<const char*>(pointer));
+    static_cast<char*>(pointer)[0] = 'F';
+    EXPECT_EQ(MOJO_RESULT_OK, MojoUnmapBuffer(pointer));
+    EXPECT_EQ(MOJO_RESULT_OK, MojoClose(buffer_handle));
+
+    char contents[kNumBytes] = {};
+    ASSERT_EQ(static_cast<int>(kNumBytes),
+              base::ReadFile(path, contents, static_cast<int>(kNumBytes)));
+    EXPECT_STREQ("File contents", contents);
+  }
+
+  // Read-only:
+  {
+    int fd = HANDLE_EINTR(open(path.value().c_str(), O_RDONLY));
+    ASSERT_GE(fd, 0);
+    MojoHandle buffer_handle = MOJO_HANDLE_INVALID;
+    EXPECT_EQ(MOJO_RESULT_OK, MojoCreateSharedBufferFromPlatformHandle(
+                                  fd, kNumBytes, &buffer_handle));
+    EXPECT_NE(buffer_handle, MOJO_HANDLE_INVALID);
+
+    // It can be mapped locally.
+    void* pointer = nullptr;
+    EXPECT_EQ(MOJO_RESULT_OK,
+              MojoMapBuffer(buffer_handle, 0, kNumBytes, &pointer,
+                            MOJO_MAP_BUFFER_FLAG_NONE));
+    ASSERT_TRUE(pointer);
+    EXPECT_STREQ("File contents", static_cast<const char*>(pointer));
+    EXPECT_EQ(MOJO_RESULT_OK, MojoUnmapBuffer(pointer));
+
+    // But the receiver won't accept it.
+    EXPECT_EQ(MOJO_RESULT_OK,
+              MojoWriteMessage(server_mp, nullptr, 0, &buffer_handle, 1,
+                               MOJO_WRITE_MESSAGE_FLAG_NONE));
+    buffer_handle = MOJO_HANDLE_INVALID;
+    EXPECT_EQ(MOJO_RESULT_OK, MojoWait(client_mp, MOJO_HANDLE_SIGNAL_READABLE,
+                                       MOJO_DEADLINE_INDEFINITE, nullptr));
+    uint32_t num_handles = 1;
+    EXPECT_EQ(MOJO_RESULT_OK,
+              MojoReadMessage(client_mp, nullptr, nullptr, &buffer_handle,
+                              &num_handles, MOJO_READ_MESSAGE_FLAG_NONE));
+    EXPECT_EQ(1u, num_handles);
+    EXPECT_EQ(MOJO_HANDLE_INVALID, buffer_handle);
+  }
+
+  EXPECT_EQ(MOJO_RESULT_OK, MojoClose(server_mp));
+  EXPECT_EQ(MOJO_RESULT_OK, MojoClose(client_mp));
+
+  // A file of the wrong size isn't accepted (and the handle is still taken).
+  MojoHandle buffer_handle = MOJO_HANDLE_INVALID;
+  int fd = HANDLE_EINTR(open(path.value().c_str(), O_RDONLY));
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            MojoCreateSharedBufferFromPlatformHandle(fd, kNumBytes + 1,
+                                                     &buffer_handle));
+
+  server_channel.WaitForChannelCreationCompletion();
+  client_channel.WaitForChannelCreationCompletion();
+}
+#endif  // !defined(OS_ANDROID)
+
 #if defined(OS_ANDROID)
 // Android multi-process tests are not executing the new process. This is flaky.
 // TODO(vtl): I'm guessing this is true of this test too?
@@ -8,6 +8,7 @@
 #include "mojo/public/c/system/data_pipe.h"
 #include "mojo/public/c/system/functions.h"
 #include "mojo/public/c/system/message_pipe.h"
+#include "mojo/public/c/system/wait_set.h"
 
 using mojo::embedder::internal::g_core;
 using mojo::system::MakeUserPointer;
@@ -71,6 +72,60 @@ MojoResult MojoReadMessage(MojoHandle message_pipe_handle,
       MakeUserPointer(handles), MakeUserPointer(num_handles), flags);
 }
 
+MojoResult MojoWriteMessages(MojoHandle message_pipe_handle,
+                             const void* bytes,
+                             uint32_t num_bytes,
+                             const MojoHandle* handles,
+                             uint32_t num_handles,
+                             const uint32_t* message_num_bytes,
+                             const uint32_t* message_num_handles,
+                             uint32_t num_messages,
+                             MojoWriteMessageFlags flags) {
+  return g_core->WriteMessages(
+      message_pipe_handle, MakeUserPointer(bytes), num_bytes,
+      MakeUserPointer(handles), num_handles, MakeUserPointer(message_num_bytes),
+      MakeUserPointer(message_num_handles), num_messages, flags);
+}
+
+MojoResult MojoReadMessages(MojoHandle message_pipe_handle,
+                            void* bytes,
+                            uint32_t* num_bytes,
+                            MojoHandle* handles,
+                            uint32_t* num_handles,
+                            uint32_t* message_num_bytes,
+                            uint32_t* message_num_handles,
+                            uint32_t* num_messages,
+                            MojoReadMessageFlags flags) {
+  return g_core->ReadMessages(
+      message_pipe_handle, MakeUserPointer(bytes), MakeUserPointer(num_bytes),
+      MakeUserPointer(handles), MakeUserPointer(num_handles),
+      MakeUserPointer(message_num_bytes), MakeUserPointer(message_num_handles),
+      MakeUserPointer(num_messages), flags);
+}
+
+MojoResult MojoWriteMessageContext(
+    MojoHandle message_pipe_handle,
+    uintptr_t context,
+    const struct MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  return g_core->WriteMessageContext(message_pipe_handle, context, thunks,
+                                     flags);
+}
+
+MojoResult MojoReadMessageContext(MojoHandle message_pipe_handle,
+                                  const struct MojoMessageContextThunks* thunks,
+                                  uintptr_t* context,
+                                  void* bytes,
+                                  uint32_t* num_bytes,
+                                  MojoHandle* handles,
+                                  uint32_t* num_handles,
+                                  MojoReadMessageFlags flags) {
+  return g_core->ReadMessageContext(
+      message_pipe_handle, thunks, MakeUserPointer(context),
+      MakeUserPointer(bytes), MakeUserPointer(num_bytes),
+      MakeUserPointer(handles), MakeUserPointer(num_handles), flags);
+}
+
 MojoResult MojoCreateDataPipe(const MojoCreateDataPipeOptions* options,
                               MojoHandle* data_pipe_producer_handle,
                               MojoHandle* data_pipe_consumer_handle) {
@@ -123,6 +178,36 @@ MojoResult MojoEndReadData(MojoHandle data_pipe_consumer_handle,
   return g_core->EndReadData(data_pipe_consumer_handle, num_elements_read);
 }
 
+MojoResult MojoSetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    const struct MojoDataPipeProducerOptions* options) {
+  return g_core->SetDataPipeProducerOptions(data_pipe_producer_handle,
+                                            MakeUserPointer(options));
+}
+
+MojoResult MojoGetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    struct MojoDataPipeProducerOptions* options,
+    uint32_t options_num_bytes) {
+  return g_core->GetDataPipeProducerOptions(
+      data_pipe_producer_handle, MakeUserPointer(options), options_num_bytes);
+}
+
+MojoResult MojoSetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    const struct MojoDataPipeConsumerOptions* options) {
+  return g_core->SetDataPipeConsumerOptions(data_pipe_consumer_handle,
+                                            MakeUserPointer(options));
+}
+
+MojoResult MojoGetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    struct MojoDataPipeConsumerOptions* options,
+    uint32_t options_num_bytes) {
+  return g_core->GetDataPipeConsumerOptions(
+      data_pipe_consumer_handle, MakeUserPointer(options), options_num_bytes);
+}
+
 MojoResult MojoCreateSharedBuffer(
     const struct MojoCreateSharedBufferOptions* options,
     uint64_t num_bytes,
@@ -152,4 +237,29 @@ MojoResult MojoUnmapBuffer(void* buffer) {
   return g_core->UnmapBuffer(MakeUserPointer(buffer));
 }
 
+MojoResult MojoCreateWaitSet(MojoHandle* wait_set_handle) {
+  return g_core->CreateWaitSet(MakeUserPointer(wait_set_handle));
+}
+
+MojoResult MojoAddHandle(MojoHandle wait_set_handle,
+                         MojoHandle handle,
+                         MojoHandleSignals signals) {
+  return g_core->AddHandle(wait_set_handle, handle, signals);
+}
+
+MojoResult MojoRemoveHandle(MojoHandle wait_set_handle, MojoHandle handle) {
+  return g_core->RemoveHandle(wait_set_handle, handle);
+}
+
+MojoResult MojoGetReadyHandles(MojoHandle wait_set_handle,
+                               uint32_t* count,
+                               MojoHandle* handles,
+                               MojoResult* results,
+                               MojoHandleSignalsState* signals_states) {
+  return g_core->GetReadyHandles(wait_set_handle, MakeUserPointer(count),
+                                 MakeUserPointer(handles),
+                                 MakeUserPointer(results),
+                                 MakeUserPointer(signals_states));
+}
+
 }  // extern "C"
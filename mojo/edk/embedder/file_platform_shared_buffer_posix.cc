@@ -0,0 +1,139 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/embedder/file_platform_shared_buffer_posix.h"
+
+#include <fcntl.h>  // For |fcntl()|.
+#include <stdint.h>
+#include <sys/mman.h>  // For |mmap()|.
+#include <sys/stat.h>
+#include <sys/types.h>  // For |off_t|.
+
+#include <limits>
+
+#include "base/logging.h"
+#include "base/sys_info.h"
+#include "mojo/edk/embedder/platform_handle.h"
+#include "mojo/edk/embedder/platform_handle_utils.h"
+#include "mojo/edk/embedder/simple_platform_shared_buffer.h"
+
+namespace mojo {
+namespace embedder {
+
+// static
+FilePlatformSharedBuffer* FilePlatformSharedBuffer::Create(
+    size_t num_bytes,
+    ScopedPlatformHandle platform_handle) {
+  DCHECK_GT(num_bytes, 0u);
+  DCHECK(platform_handle.is_valid());
+
+  if (static_cast<uint64_t>(num_bytes) >
+      static_cast<uint64_t>(std::numeric_limits<off_t>::max())) {
+    return nullptr;
+  }
+
+  struct stat sb = {};
+  // Note: |fstat()| isn't interruptible.
+  if (fstat(platform_handle.get().fd, &sb) != 0) {
+    PLOG(ERROR) << "fstat";
+    return nullptr;
+  }
+
+  if (!S_ISREG(sb.st_mode)) {
+    LOG(ERROR) << "Platform handle not to a regular file";
+    return nullptr;
+  }
+
+  if (sb.st_size != static_cast<off_t>(num_bytes)) {
+    LOG(ERROR) << "File has the wrong size";
+    return nullptr;
+  }
+
+  // Note: |fcntl()| isn't interruptible for |F_GETFL|.
+  int flags = fcntl(platform_handle.get().fd, F_GETFL);
+  if (flags == -1) {
+    PLOG(ERROR) << "fcntl";
+    return nullptr;
+  }
+  if ((flags & O_ACCMODE) == O_WRONLY) {
+    LOG(ERROR) << "Platform handle not readable";
+    return nullptr;
+  }
+
+  return new FilePlatformSharedBuffer(num_bytes,
+                                      (flags & O_ACCMODE) == O_RDONLY,
+                                      platform_handle.Pass());
+}
+
+size_t FilePlatformSharedBuffer::GetNumBytes() const {
+  return num_bytes_;
+}
+
+scoped_ptr<PlatformSharedBufferMapping> FilePlatformSharedBuffer::Map(
+    size_t offset,
+    size_t length) {
+  if (!IsValidMap(offset, length))
+    return nullptr;
+
+  return MapNoCheck(offset, length);
+}
+
+bool FilePlatformSharedBuffer::IsValidMap(size_t offset, size_t length) {
+  if (offset > num_bytes_ || length == 0)
+    return false;
+
+  // Note: This is an overflow-safe check of |offset + length > num_bytes_|
+  // (that |num_bytes >= offset| is verified above).
+  if (length > num_bytes_ - offset)
+    return false;
+
+  return true;
+}
+
+scoped_ptr<PlatformSharedBufferMapping> FilePlatformSharedBuffer::MapNoCheck(
+    size_t offset,
+    size_t length) {
+  DCHECK(IsValidMap(offset, length));
+
+  size_t offset_rounding = offset % base::SysInfo::VMAllocationGranularity();
+  size_t real_offset = offset - offset_rounding;
+  size_t real_length = length + offset_rounding;
+
+  void* real_base = mmap(nullptr, real_length,
+                         read_only_ ? PROT_READ : (PROT_READ | PROT_WRITE),
+                         MAP_SHARED, handle_.get().fd,
+                         static_cast<off_t>(real_offset));
+  // |mmap()| should return |MAP_FAILED| (a.k.a. -1) on error. But it shouldn't
+  // return null either.
+  if (real_base == MAP_FAILED || !real_base) {
+    PLOG(ERROR) << "mmap";
+    return nullptr;
+  }
+
+  void* base = static_cast<char*>(real_base) + offset_rounding;
+  return make_scoped_ptr(new SimplePlatformSharedBufferMapping(
+      base, length, real_base, real_length));
+}
+
+ScopedPlatformHandle FilePlatformSharedBuffer::DuplicatePlatformHandle() {
+  return mojo::embedder::DuplicatePlatformHandle(handle_.get());
+}
+
+ScopedPlatformHandle FilePlatformSharedBuffer::PassPlatformHandle() {
+  DCHECK(HasOneRef());
+  return handle_.Pass();
+}
+
+FilePlatformSharedBuffer::FilePlatformSharedBuffer(
+    size_t num_bytes,
+    bool read_only,
+    ScopedPlatformHandle handle)
+    : num_bytes_(num_bytes), read_only_(read_only), handle_(handle.Pass()) {
+}
+
+FilePlatformSharedBuffer::~FilePlatformSharedBuffer() {
+}
+
+}  // namespace embedder
+}  // namespace mojo
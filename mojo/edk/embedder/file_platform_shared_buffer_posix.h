@@ -0,0 +1,71 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_EDK_EMBEDDER_FILE_PLATFORM_SHARED_BUFFER_POSIX_H_
+#define MOJO_EDK_EMBEDDER_FILE_PLATFORM_SHARED_BUFFER_POSIX_H_
+
+#include <stddef.h>
+
+#include "base/macros.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
+#include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/system/system_impl_export.h"
+
+namespace mojo {
+namespace embedder {
+
+// An implementation of |PlatformSharedBuffer| backed by an existing (regular)
+// file, so that writes to mappings are writes to the file. Unlike
+// |SimplePlatformSharedBuffer| (which is what's used for buffers received from
+// other processes, and which always requires a read-write file), the file may
+// be read-only, in which case mappings are read-only too.
+//
+// This is only created explicitly (by the owner of the file), never by
+// deserialization. Note that when one of these is sent to another process, it
+// is received as a |SimplePlatformSharedBuffer|, so a read-only one can't be
+// (it'll be rejected by the receiver). Also note that accessing a mapping
+// beyond the end of the file (e.g., if it's truncated by someone else) will
+// crash.
+class MOJO_SYSTEM_IMPL_EXPORT FilePlatformSharedBuffer
+    : public PlatformSharedBuffer {
+ public:
+  // Creates a shared buffer backed by the regular file |platform_handle|, which
+  // must be readable and exactly |num_bytes| bytes in size. |num_bytes| must be
+  // nonzero. Returns null on failure.
+  static FilePlatformSharedBuffer* Create(size_t num_bytes,
+                                          ScopedPlatformHandle platform_handle);
+
+  // Whether mappings are read-only (i.e., |platform_handle| wasn't writable).
+  bool is_read_only() const { return read_only_; }
+
+  // |PlatformSharedBuffer| implementation:
+  size_t GetNumBytes() const override;
+  scoped_ptr<PlatformSharedBufferMapping> Map(size_t offset,
+                                              size_t length) override;
+  bool IsValidMap(size_t offset, size_t length) override;
+  scoped_ptr<PlatformSharedBufferMapping> MapNoCheck(size_t offset,
+                                                     size_t length) override;
+  ScopedPlatformHandle DuplicatePlatformHandle() override;
+  ScopedPlatformHandle PassPlatformHandle() override;
+
+ private:
+  FilePlatformSharedBuffer(size_t num_bytes,
+                           bool read_only,
+                           ScopedPlatformHandle handle);
+  ~FilePlatformSharedBuffer() override;
+
+  const size_t num_bytes_;
+  const bool read_only_;
+
+  // This is set on creation and never modified (except by
+  // |PassPlatformHandle()|), hence does not need to be protected by a lock.
+  ScopedPlatformHandle handle_;
+
+  DISALLOW_COPY_AND_ASSIGN(FilePlatformSharedBuffer);
+};
+
+}  // namespace embedder
+}  // namespace mojo
+
+#endif  // MOJO_EDK_EMBEDDER_FILE_PLATFORM_SHARED_BUFFER_POSIX_H_
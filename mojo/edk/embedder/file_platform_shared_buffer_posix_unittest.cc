@@ -0,0 +1,141 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/embedder/file_platform_shared_buffer_posix.h"
+
+#include <fcntl.h>
+#include <string.h>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/posix/eintr_wrapper.h"
+#include "mojo/edk/embedder/platform_handle.h"
+#include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/embedder/simple_platform_shared_buffer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace embedder {
+namespace {
+
+const char kContents[] = "hello world";
+
+class FilePlatformSharedBufferTest : public testing::Test {
+ public:
+  FilePlatformSharedBufferTest() {}
+  ~FilePlatformSharedBufferTest() override {}
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.path().Append("file");
+    ASSERT_EQ(static_cast<int>(sizeof(kContents)),
+              base::WriteFile(path_, kContents,
+                              static_cast<int>(sizeof(kContents))));
+  }
+
+ protected:
+  ScopedPlatformHandle Open(int flags) {
+    return ScopedPlatformHandle(
+        PlatformHandle(HANDLE_EINTR(open(path_.value().c_str(), flags))));
+  }
+
+  const base::FilePath& path() const { return path_; }
+
+ private:
+  base::ScopedTempDir temp_dir_;
+  base::FilePath path_;
+
+  DISALLOW_COPY_AND_ASSIGN(FilePlatformSharedBufferTest);
+};
+
+TEST_F(FilePlatformSharedBufferTest, ReadOnly) {
+  ScopedPlatformHandle handle(Open(O_RDONLY));
+  ASSERT_TRUE(handle.is_valid());
+  scoped_refptr<FilePlatformSharedBuffer> buffer(
+      FilePlatformSharedBuffer::Create(sizeof(kContents), handle.Pass()));
+  ASSERT_TRUE(buffer);
+  EXPECT_TRUE(buffer->is_read_only());
+  EXPECT_EQ(sizeof(kContents), buffer->GetNumBytes());
+
+  scoped_ptr<PlatformSharedBufferMapping> mapping(
+      buffer->Map(0, sizeof(kContents)));
+  ASSERT_TRUE(mapping);
+  EXPECT_STREQ(kContents, static_cast<const char*>(mapping->GetBase()));
+
+  // Its platform handle isn't acceptable as an ordinary shared buffer (e.g., if
+  // it were sent to another process).
+  EXPECT_FALSE(SimplePlatformSharedBuffer::CreateFromPlatformHandle(
+      sizeof(kContents), buffer->DuplicatePlatformHandle()));
+}
+
+TEST_F(FilePlatformSharedBufferTest, ReadWrite) {
+  {
+    ScopedPlatformHandle handle(Open(O_RDWR));
+    ASSERT_TRUE(handle.is_valid());
+    scoped_refptr<FilePlatformSharedBuffer> buffer(
+        FilePlatformSharedBuffer::Create(sizeof(kContents), handle.Pass()));
+    ASSERT_TRUE(buffer);
+    EXPECT_FALSE(buffer->is_read_only());
+
+    // Writes to the mapping should be writes to the file.
+    scoped_ptr<PlatformSharedBufferMapping> mapping(buffer->Map(6, 5));
+    ASSERT_TRUE(mapping);
+    memcpy(mapping->GetBase(), "mojo!", 5);
+
+    // Its platform handle is acceptable as an ordinary shared buffer.
+    scoped_refptr<SimplePlatformSharedBuffer> other_buffer(
+        SimplePlatformSharedBuffer::CreateFromPlatformHandle(
+            sizeof(kContents), buffer->DuplicatePlatformHandle()));
+    ASSERT_TRUE(other_buffer);
+    scoped_ptr<PlatformSharedBufferMapping> other_mapping(
+        other_buffer->Map(0, sizeof(kContents)));
+    ASSERT_TRUE(other_mapping);
+    EXPECT_STREQ("hello mojo!",
+                 static_cast<const char*>(other_mapping->GetBase()));
+  }
+
+  char contents[sizeof(kContents)] = {};
+  ASSERT_EQ(static_cast<int>(sizeof(kContents)),
+            base::ReadFile(path(), contents,
+                           static_cast<int>(sizeof(kContents))));
+  EXPECT_STREQ("hello mojo!", contents);
+}
+
+TEST_F(FilePlatformSharedBufferTest, InvalidArguments) {
+  // The size must match.
+  {
+    ScopedPlatformHandle handle(Open(O_RDONLY));
+    ASSERT_TRUE(handle.is_valid());
+    EXPECT_FALSE(FilePlatformSharedBuffer::Create(sizeof(kContents) + 1,
+                                                  handle.Pass()));
+  }
+
+  // It must not be write-only.
+  {
+    ScopedPlatformHandle handle(Open(O_WRONLY));
+    ASSERT_TRUE(handle.is_valid());
+    EXPECT_FALSE(
+        FilePlatformSharedBuffer::Create(sizeof(kContents), handle.Pass()));
+  }
+
+  // Maps must be within range.
+  {
+    ScopedPlatformHandle handle(Open(O_RDONLY));
+    ASSERT_TRUE(handle.is_valid());
+    scoped_refptr<FilePlatformSharedBuffer> buffer(
+        FilePlatformSharedBuffer::Create(sizeof(kContents), handle.Pass()));
+    ASSERT_TRUE(buffer);
+    EXPECT_FALSE(buffer->Map(0, sizeof(kContents) + 1));
+    EXPECT_FALSE(buffer->Map(1, sizeof(kContents)));
+    EXPECT_FALSE(buffer->Map(0, 0));
+  }
+}
+
+}  // namespace
+}  // namespace embedder
+}  // namespace mojo
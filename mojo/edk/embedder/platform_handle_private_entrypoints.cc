@@ -0,0 +1,46 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/ref_counted.h"
+#include "mojo/edk/embedder/embedder.h"
+#include "mojo/edk/embedder/file_platform_shared_buffer_posix.h"
+#include "mojo/edk/embedder/platform_handle.h"
+#include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/system/configuration.h"
+#include "mojo/public/platform/native/platform_handle_private.h"
+
+using mojo::embedder::FilePlatformSharedBuffer;
+using mojo::embedder::PlatformHandle;
+using mojo::embedder::ScopedPlatformHandle;
+
+// Definitions of the (private) platform handle functions.
+extern "C" {
+
+MojoResult MojoCreateSharedBufferFromPlatformHandle(
+    MojoPlatformHandle platform_handle,
+    uint64_t num_bytes,
+    MojoHandle* shared_buffer_handle) {
+  // Take ownership first, so that it's closed on failure.
+  ScopedPlatformHandle handle((PlatformHandle(platform_handle)));
+  if (!handle.is_valid() || !shared_buffer_handle)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  if (!num_bytes)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  if (num_bytes > mojo::system::GetConfiguration().max_shared_memory_num_bytes)
+    return MOJO_RESULT_RESOURCE_EXHAUSTED;
+
+  // Note: This is deliberately not |PlatformSupport::
+  // CreateSharedBufferFromHandle()|, which is for buffers received from
+  // (untrusted) peers and only accepts (and maps) read-write handles.
+  scoped_refptr<FilePlatformSharedBuffer> shared_buffer(
+      FilePlatformSharedBuffer::Create(static_cast<size_t>(num_bytes),
+                                       handle.Pass()));
+  if (!shared_buffer)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return mojo::embedder::CreateSharedBufferWrapper(shared_buffer,
+                                                   shared_buffer_handle);
+}
+
+}  // extern "C"
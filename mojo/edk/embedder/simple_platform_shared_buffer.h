@@ -64,7 +64,7 @@ class MOJO_SYSTEM_IMPL_EXPORT SimplePlatformSharedBuffer
 };
 
 // An implementation of |PlatformSharedBufferMapping|, produced by
-// |SimplePlatformSharedBuffer|.
+// |SimplePlatformSharedBuffer| (and |FilePlatformSharedBuffer|).
 class MOJO_SYSTEM_IMPL_EXPORT SimplePlatformSharedBufferMapping
     : public PlatformSharedBufferMapping {
  public:
@@ -74,6 +74,7 @@ class MOJO_SYSTEM_IMPL_EXPORT SimplePlatformSharedBufferMapping
   size_t GetLength() const override;
 
  private:
+  friend class FilePlatformSharedBuffer;
   friend class SimplePlatformSharedBuffer;
 
   SimplePlatformSharedBufferMapping(void* base,
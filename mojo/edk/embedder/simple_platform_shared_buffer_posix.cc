@@ -4,6 +4,7 @@
 
 #include "mojo/edk/embedder/simple_platform_shared_buffer.h"
 
+#include <fcntl.h>     // For |fcntl()|.
 #include <stdint.h>
 #include <stdio.h>     // For |fileno()|.
 #include <sys/mman.h>  // For |mmap()|/|munmap()|.
@@ -113,6 +114,19 @@ bool SimplePlatformSharedBuffer::InitFromPlatformHandle(
     return false;
   }
 
+  // Mappings are always read-write, so the file must be too (otherwise a peer
+  // could give us something that we'd only be able to map read-only).
+  // Note: |fcntl()| isn't interruptible for |F_GETFL|.
+  int flags = fcntl(platform_handle.get().fd, F_GETFL);
+  if (flags == -1) {
+    PLOG(ERROR) << "fcntl";
+    return false;
+  }
+  if ((flags & O_ACCMODE) != O_RDWR) {
+    LOG(ERROR) << "Platform handle not readable and writable";
+    return false;
+  }
+
   // TODO(vtl): More checks?
 
   handle_ = platform_handle.Pass();
@@ -257,4 +257,151 @@ MojoResult MojoSystemImplUnmapBuffer(MojoSystemImpl system, void* buffer) {
   return core->UnmapBuffer(MakeUserPointer(buffer));
 }
 
+MojoResult MojoSystemImplCreateWaitSet(MojoSystemImpl system,
+                                       MojoHandle* wait_set_handle) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->CreateWaitSet(MakeUserPointer(wait_set_handle));
+}
+
+MojoResult MojoSystemImplAddHandle(MojoSystemImpl system,
+                                   MojoHandle wait_set_handle,
+                                   MojoHandle handle,
+                                   MojoHandleSignals signals) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->AddHandle(wait_set_handle, handle, signals);
+}
+
+MojoResult MojoSystemImplRemoveHandle(MojoSystemImpl system,
+                                      MojoHandle wait_set_handle,
+                                      MojoHandle handle) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->RemoveHandle(wait_set_handle, handle);
+}
+
+MojoResult MojoSystemImplGetReadyHandles(
+    MojoSystemImpl system,
+    MojoHandle wait_set_handle,
+    uint32_t* count,
+    MojoHandle* handles,
+    MojoResult* results,
+    MojoHandleSignalsState* signals_states) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->GetReadyHandles(wait_set_handle, MakeUserPointer(count),
+                               MakeUserPointer(handles),
+                               MakeUserPointer(results),
+                               MakeUserPointer(signals_states));
+}
+
+MojoResult MojoSystemImplReadMessages(MojoSystemImpl system,
+                                      MojoHandle message_pipe_handle,
+                                      void* bytes,
+                                      uint32_t* num_bytes,
+                                      MojoHandle* handles,
+                                      uint32_t* num_handles,
+                                      uint32_t* message_num_bytes,
+                                      uint32_t* message_num_handles,
+                                      uint32_t* num_messages,
+                                      MojoReadMessageFlags flags) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->ReadMessages(
+      message_pipe_handle, MakeUserPointer(bytes), MakeUserPointer(num_bytes),
+      MakeUserPointer(handles), MakeUserPointer(num_handles),
+      MakeUserPointer(message_num_bytes), MakeUserPointer(message_num_handles),
+      MakeUserPointer(num_messages), flags);
+}
+
+MojoResult MojoSystemImplWriteMessages(MojoSystemImpl system,
+                                       MojoHandle message_pipe_handle,
+                                       const void* bytes,
+                                       uint32_t num_bytes,
+                                       const MojoHandle* handles,
+                                       uint32_t num_handles,
+                                       const uint32_t* message_num_bytes,
+                                       const uint32_t* message_num_handles,
+                                       uint32_t num_messages,
+                                       MojoWriteMessageFlags flags) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->WriteMessages(
+      message_pipe_handle, MakeUserPointer(bytes), num_bytes,
+      MakeUserPointer(handles), num_handles, MakeUserPointer(message_num_bytes),
+      MakeUserPointer(message_num_handles), num_messages, flags);
+}
+
+MojoResult MojoSystemImplWriteMessageContext(
+    MojoSystemImpl system,
+    MojoHandle message_pipe_handle,
+    uintptr_t context,
+    const struct MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->WriteMessageContext(message_pipe_handle, context, thunks, flags);
+}
+
+MojoResult MojoSystemImplReadMessageContext(
+    MojoSystemImpl system,
+    MojoHandle message_pipe_handle,
+    const struct MojoMessageContextThunks* thunks,
+    uintptr_t* context,
+    void* bytes,
+    uint32_t* num_bytes,
+    MojoHandle* handles,
+    uint32_t* num_handles,
+    MojoReadMessageFlags flags) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->ReadMessageContext(
+      message_pipe_handle, thunks, MakeUserPointer(context),
+      MakeUserPointer(bytes), MakeUserPointer(num_bytes),
+      MakeUserPointer(handles), MakeUserPointer(num_handles), flags);
+}
+
+MojoResult MojoSystemImplSetDataPipeProducerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_producer_handle,
+    const struct MojoDataPipeProducerOptions* options) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->SetDataPipeProducerOptions(data_pipe_producer_handle,
+                                          MakeUserPointer(options));
+}
+
+MojoResult MojoSystemImplGetDataPipeProducerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_producer_handle,
+    struct MojoDataPipeProducerOptions* options,
+    uint32_t options_num_bytes) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->GetDataPipeProducerOptions(
+      data_pipe_producer_handle, MakeUserPointer(options), options_num_bytes);
+}
+
+MojoResult MojoSystemImplSetDataPipeConsumerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_consumer_handle,
+    const struct MojoDataPipeConsumerOptions* options) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->SetDataPipeConsumerOptions(data_pipe_consumer_handle,
+                                          MakeUserPointer(options));
+}
+
+MojoResult MojoSystemImplGetDataPipeConsumerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_consumer_handle,
+    struct MojoDataPipeConsumerOptions* options,
+    uint32_t options_num_bytes) {
+  mojo::system::Core* core = static_cast<mojo::system::Core*>(system);
+  DCHECK(core);
+  return core->GetDataPipeConsumerOptions(
+      data_pipe_consumer_handle, MakeUserPointer(options), options_num_bytes);
+}
+
 }  // extern "C"
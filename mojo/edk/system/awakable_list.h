@@ -36,6 +36,8 @@ class MOJO_SYSTEM_IMPL_EXPORT AwakableList {
   void Add(Awakable* awakable, MojoHandleSignals signals, uint32_t context);
   void Remove(Awakable* awakable);
 
+  bool IsEmpty() const { return awakables_.empty(); }
+
  private:
   struct AwakeInfo {
     AwakeInfo(Awakable* awakable, MojoHandleSignals signals, uint32_t context)
@@ -29,8 +29,37 @@ struct SerializedEndpoint {
 
 }  // namespace
 
+class Channel::AutoLockWithStats {
+ public:
+  explicit AutoLockWithStats(Channel* channel) : channel_(channel) {
+    // Only time the acquisition if we actually have to wait.
+    if (channel_->lock_.Try()) {
+      channel_->lock_stats_.num_acquisitions++;
+      return;
+    }
+
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    channel_->lock_.Acquire();
+    channel_->lock_stats_.num_acquisitions++;
+    channel_->lock_stats_.num_contended_acquisitions++;
+    channel_->lock_stats_.total_wait_time +=
+        base::TimeTicks::Now() - start_time;
+  }
+
+  ~AutoLockWithStats() {
+    channel_->lock_.AssertAcquired();
+    channel_->lock_.Release();
+  }
+
+ private:
+  Channel* const channel_;
+
+  DISALLOW_COPY_AND_ASSIGN(AutoLockWithStats);
+};
+
 Channel::Channel(embedder::PlatformSupport* platform_support)
     : platform_support_(platform_support),
+      has_changed_local_ids_(0),
       is_running_(false),
       is_shutting_down_(false),
       channel_manager_(nullptr) {
@@ -51,7 +80,7 @@ void Channel::Init(scoped_ptr<RawChannel> raw_channel) {
 void Channel::SetChannelManager(ChannelManager* channel_manager) {
   DCHECK(channel_manager);
 
-  base::AutoLock locker(lock_);
+  AutoLockWithStats locker(this);
   DCHECK(!is_shutting_down_);
   DCHECK(!channel_manager_);
   channel_manager_ = channel_manager;
@@ -62,7 +91,7 @@ void Channel::Shutdown() {
 
   IdToEndpointMap to_destroy;
   {
-    base::AutoLock locker(lock_);
+    AutoLockWithStats locker(this);
     if (!is_running_)
       return;
 
@@ -73,7 +102,16 @@ void Channel::Shutdown() {
 
     // We need to deal with it outside the lock.
     std::swap(to_destroy, local_id_to_endpoint_map_);
+    changed_local_ids_.clear();
+    base::subtle::NoBarrier_Store(&has_changed_local_ids_, 0);
+
+    DVLOG_IF(1, lock_stats_.num_contended_acquisitions)
+        << "Shutting down Channel: lock was contended for "
+        << lock_stats_.num_contended_acquisitions << " of "
+        << lock_stats_.num_acquisitions << " acquisitions, waiting "
+        << lock_stats_.total_wait_time.InMillisecondsF() << " ms in all";
   }
+  creation_thread_endpoint_map_.clear();
 
   size_t num_live = 0;
   size_t num_zombies = 0;
@@ -92,7 +130,7 @@ void Channel::Shutdown() {
 }
 
 void Channel::WillShutdownSoon() {
-  base::AutoLock locker(lock_);
+  AutoLockWithStats locker(this);
   is_shutting_down_ = true;
   channel_manager_ = nullptr;
 }
@@ -110,7 +148,7 @@ void Channel::SetBootstrapEndpointWithIds(
   DCHECK(endpoint);
 
   {
-    base::AutoLock locker(lock_);
+    AutoLockWithStats locker(this);
 
     DLOG_IF(WARNING, is_shutting_down_)
         << "SetBootstrapEndpoint() while shutting down";
@@ -120,26 +158,49 @@ void Channel::SetBootstrapEndpointWithIds(
            local_id_to_endpoint_map_.end());
 
     local_id_to_endpoint_map_[local_id] = endpoint;
+    EndpointChangedNoLock(local_id);
   }
 
   endpoint->AttachAndRun(this, local_id, remote_id);
 }
 
 bool Channel::WriteMessage(scoped_ptr<MessageInTransit> message) {
-  base::AutoLock locker(lock_);
-  if (!is_running_) {
-    // TODO(vtl): I think this is probably not an error condition, but I should
-    // think about it (and the shutdown sequence) more carefully.
-    LOG(WARNING) << "WriteMessage() after shutdown";
-    return false;
+  {
+    AutoLockWithStats locker(this);
+    if (!is_running_) {
+      // TODO(vtl): I think this is probably not an error condition, but I
+      // should think about it (and the shutdown sequence) more carefully.
+      LOG(WARNING) << "WriteMessage() after shutdown";
+      return false;
+    }
+
+    DLOG_IF(WARNING, is_shutting_down_) << "WriteMessage() while shutting down";
   }
 
-  DLOG_IF(WARNING, is_shutting_down_) << "WriteMessage() while shutting down";
+  // Write outside |lock_| (which may take a while). |raw_channel_| is
+  // thread-safe and never reset, and if it's shut down in the meantime this
+  // simply fails.
   return raw_channel_->WriteMessage(message.Pass());
 }
 
+bool Channel::WriteMessages(MessageInTransitQueue* messages) {
+  {
+    AutoLockWithStats locker(this);
+    if (!is_running_) {
+      LOG(WARNING) << "WriteMessages() after shutdown";
+      return false;
+    }
+
+    DLOG_IF(WARNING, is_shutting_down_)
+        << "WriteMessages() while shutting down";
+  }
+
+  // As in |WriteMessage()|, write outside |lock_|.
+  return raw_channel_->WriteMessages(messages);
+}
+
 bool Channel::IsWriteBufferEmpty() {
-  base::AutoLock locker(lock_);
+  AutoLockWithStats locker(this);
   if (!is_running_)
     return true;
   return raw_channel_->IsWriteBufferEmpty();
@@ -155,7 +216,7 @@ void Channel::DetachEndpoint(ChannelEndpoint* endpoint,
     return;  // Nothing to do.
 
   {
-    base::AutoLock locker_(lock_);
+    AutoLockWithStats locker(this);
     if (!is_running_)
       return;
 
@@ -169,6 +230,7 @@ void Channel::DetachEndpoint(ChannelEndpoint* endpoint,
 
     DCHECK(it->second);
     it->second = nullptr;
+    EndpointChangedNoLock(local_id);
 
     // Send a remove message outside the lock.
   }
@@ -248,7 +310,7 @@ scoped_refptr<IncomingEndpoint> Channel::DeserializeEndpoint(
   DVLOG_IF(2, !local_id.is_valid() || !local_id.is_remote())
       << "Attempt to get incoming endpoint for invalid ID " << local_id;
 
-  base::AutoLock locker(lock_);
+  AutoLockWithStats locker(this);
 
   auto it = incoming_endpoints_.find(local_id);
   if (it == incoming_endpoints_.end()) {
@@ -268,6 +330,11 @@ size_t Channel::GetSerializedPlatformHandleSize() const {
   return raw_channel_->GetSerializedPlatformHandleSize();
 }
 
+Channel::LockStats Channel::GetLockStats() {
+  AutoLockWithStats locker(this);
+  return lock_stats_;
+}
+
 Channel::~Channel() {
   // The channel should have been shut down first.
   DCHECK(!is_running_);
@@ -278,6 +345,12 @@ void Channel::OnReadMessage(
     embedder::ScopedPlatformHandleVectorPtr platform_handles) {
   DCHECK(creation_thread_checker_.CalledOnValidThread());
 
+  // Only take |lock_| if |creation_thread_endpoint_map_| is out of date.
+  if (base::subtle::Acquire_Load(&has_changed_local_ids_)) {
+    AutoLockWithStats locker(this);
+    UpdateCreationThreadEndpointMapNoLock();
+  }
+
   switch (message_view.type()) {
     case MessageInTransit::Type::ENDPOINT_CLIENT:
     case MessageInTransit::Type::ENDPOINT:
@@ -303,7 +376,7 @@ void Channel::OnError(Error error) {
       DVLOG(1) << "RawChannel read error (shutdown)";
       break;
     case ERROR_READ_BROKEN: {
-      base::AutoLock locker(lock_);
+      AutoLockWithStats locker(this);
       LOG_IF(ERROR, !is_shutting_down_)
           << "RawChannel read error (connection broken)";
       break;
@@ -338,28 +411,26 @@ void Channel::OnReadMessageForEndpoint(
     return;
   }
 
-  scoped_refptr<ChannelEndpoint> endpoint;
-  {
-    base::AutoLock locker(lock_);
-
-    // Since we own |raw_channel_|, and this method and |Shutdown()| should only
-    // be called from the creation thread, |raw_channel_| should never be null
-    // here.
-    DCHECK(is_running_);
+  // Since we own |raw_channel_|, and this method and |Shutdown()| should only
+  // be called from the creation thread, |raw_channel_| should never be null
+  // here. (For the same reason, |is_running_| may be checked without |lock_|.)
+  DCHECK(is_running_);
 
-    IdToEndpointMap::const_iterator it =
-        local_id_to_endpoint_map_.find(local_id);
-    if (it != local_id_to_endpoint_map_.end()) {
-      // Ignore messages for zombie endpoints (not an error).
-      if (!it->second) {
-        DVLOG(2) << "Ignoring downstream message for zombie endpoint (local ID "
-                    "= " << local_id
-                 << ", remote ID = " << message_view.source_id() << ")";
-        return;
-      }
-
-      endpoint = it->second;
+  // |OnReadMessage()| has already brought |creation_thread_endpoint_map_| up to
+  // date, so this doesn't need |lock_|.
+  scoped_refptr<ChannelEndpoint> endpoint;
+  IdToEndpointMap::const_iterator it =
+      creation_thread_endpoint_map_.find(local_id);
+  if (it != creation_thread_endpoint_map_.end()) {
+    // Ignore messages for zombie endpoints (not an error).
+    if (!it->second) {
+      DVLOG(2) << "Ignoring downstream message for zombie endpoint (local ID "
+                  "= " << local_id
+               << ", remote ID = " << message_view.source_id() << ")";
+      return;
     }
+
+    endpoint = it->second;
   }
   if (!endpoint) {
     HandleRemoteError(base::StringPrintf(
@@ -458,7 +529,7 @@ bool Channel::OnAttachAndRunEndpoint(ChannelEndpointId local_id,
 
   bool success = true;
   {
-    base::AutoLock locker(lock_);
+    AutoLockWithStats locker(this);
 
     if (local_id_to_endpoint_map_.find(local_id) ==
         local_id_to_endpoint_map_.end()) {
@@ -467,6 +538,7 @@ bool Channel::OnAttachAndRunEndpoint(ChannelEndpointId local_id,
       // TODO(vtl): Use emplace when we move to C++11 unordered_maps. (It'll
       // avoid some refcount churn.)
       local_id_to_endpoint_map_[local_id] = endpoint;
+      EndpointChangedNoLock(local_id);
       incoming_endpoints_[local_id] = incoming_endpoint;
     } else {
       // We need to call |Close()| outside the lock.
@@ -489,7 +561,7 @@ bool Channel::OnRemoveEndpoint(ChannelEndpointId local_id,
 
   scoped_refptr<ChannelEndpoint> endpoint;
   {
-    base::AutoLock locker(lock_);
+    AutoLockWithStats locker(this);
 
     IdToEndpointMap::iterator it = local_id_to_endpoint_map_.find(local_id);
     if (it == local_id_to_endpoint_map_.end()) {
@@ -504,6 +576,7 @@ bool Channel::OnRemoveEndpoint(ChannelEndpointId local_id,
 
     endpoint = it->second;
     local_id_to_endpoint_map_.erase(it);
+    EndpointChangedNoLock(local_id);
     // Detach and send the remove ack message outside the lock.
   }
 
@@ -525,7 +598,7 @@ bool Channel::OnRemoveEndpoint(ChannelEndpointId local_id,
 bool Channel::OnRemoveEndpointAck(ChannelEndpointId local_id) {
   DCHECK(creation_thread_checker_.CalledOnValidThread());
 
-  base::AutoLock locker(lock_);
+  AutoLockWithStats locker(this);
 
   IdToEndpointMap::iterator it = local_id_to_endpoint_map_.find(local_id);
   if (it == local_id_to_endpoint_map_.end()) {
@@ -539,6 +612,7 @@ bool Channel::OnRemoveEndpointAck(ChannelEndpointId local_id) {
   }
 
   local_id_to_endpoint_map_.erase(it);
+  EndpointChangedNoLock(local_id);
   return true;
 }
 
@@ -568,7 +642,7 @@ ChannelEndpointId Channel::AttachAndRunEndpoint(
   ChannelEndpointId local_id;
   ChannelEndpointId remote_id;
   {
-    base::AutoLock locker(lock_);
+    AutoLockWithStats locker(this);
 
     DLOG_IF(WARNING, is_shutting_down_)
         << "AttachAndRunEndpoint() while shutting down";
@@ -582,6 +656,7 @@ ChannelEndpointId Channel::AttachAndRunEndpoint(
     remote_id = remote_id_generator_.GetNext();
 
     local_id_to_endpoint_map_[local_id] = endpoint;
+    EndpointChangedNoLock(local_id);
   }
 
   if (!SendControlMessage(
@@ -611,5 +686,28 @@ bool Channel::SendControlMessage(MessageInTransit::Subtype subtype,
   return WriteMessage(message.Pass());
 }
 
+void Channel::EndpointChangedNoLock(ChannelEndpointId local_id) {
+  lock_.AssertAcquired();
+
+  changed_local_ids_.push_back(local_id);
+  base::subtle::Release_Store(&has_changed_local_ids_, 1);
+}
+
+void Channel::UpdateCreationThreadEndpointMapNoLock() {
+  DCHECK(creation_thread_checker_.CalledOnValidThread());
+  lock_.AssertAcquired();
+
+  for (ChannelEndpointId local_id : changed_local_ids_) {
+    IdToEndpointMap::const_iterator it =
+        local_id_to_endpoint_map_.find(local_id);
+    if (it == local_id_to_endpoint_map_.end())
+      creation_thread_endpoint_map_.erase(local_id);
+    else
+      creation_thread_endpoint_map_[local_id] = it->second;
+  }
+  changed_local_ids_.clear();
+  base::subtle::NoBarrier_Store(&has_changed_local_ids_, 0);
+}
+
 }  // namespace system
 }  // namespace mojo
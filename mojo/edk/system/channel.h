@@ -7,6 +7,9 @@
 
 #include <stdint.h>
 
+#include <vector>
+
+#include "base/atomicops.h"
 #include "base/containers/hash_tables.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
@@ -14,6 +17,7 @@
 #include "base/strings/string_piece.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/thread_checker.h"
+#include "base/time/time.h"
 #include "mojo/edk/embedder/scoped_platform_handle.h"
 #include "mojo/edk/system/channel_endpoint.h"
 #include "mojo/edk/system/channel_endpoint_id.h"
@@ -101,6 +105,8 @@ class MOJO_SYSTEM_IMPL_EXPORT Channel
 
   // This forwards |message| verbatim to |raw_channel_|.
   bool WriteMessage(scoped_ptr<MessageInTransit> message);
+  // Likewise, for |RawChannel::WriteMessages()|.
+  bool WriteMessages(MessageInTransitQueue* messages);
 
   // See |RawChannel::IsWriteBufferEmpty()|.
   // TODO(vtl): Maybe we shouldn't expose this, and instead have a
@@ -176,7 +182,22 @@ class MOJO_SYSTEM_IMPL_EXPORT Channel
     return platform_support_;
   }
 
+  // Statistics on acquisitions of this channel's lock, for diagnosing
+  // contention: of the |num_acquisitions|, |num_contended_acquisitions| found
+  // it held by another thread, and had to wait for |total_wait_time| in all.
+  struct LockStats {
+    LockStats() : num_acquisitions(0), num_contended_acquisitions(0) {}
+
+    uint64_t num_acquisitions;
+    uint64_t num_contended_acquisitions;
+    base::TimeDelta total_wait_time;
+  };
+  LockStats GetLockStats();
+
  private:
+  // Like |base::AutoLock| (for |lock_|), but also updates |lock_stats_|.
+  class AutoLockWithStats;
+
   friend class base::RefCountedThreadSafe<Channel>;
   ~Channel() override;
 
@@ -227,10 +248,30 @@ class MOJO_SYSTEM_IMPL_EXPORT Channel
                           ChannelEndpointId source_id,
                           ChannelEndpointId destination_id);
 
+  // Must be called (with |lock_| held) after |local_id_to_endpoint_map_|'s
+  // entry for |local_id| is changed (added, modified, or erased).
+  void EndpointChangedNoLock(ChannelEndpointId local_id);
+  // Copies changes to |local_id_to_endpoint_map_| (see above) to
+  // |creation_thread_endpoint_map_|. Only called on the creation thread, with
+  // |lock_| held.
+  void UpdateCreationThreadEndpointMapNoLock();
+
   base::ThreadChecker creation_thread_checker_;
 
   embedder::PlatformSupport* const platform_support_;
 
+  using IdToEndpointMap =
+      base::hash_map<ChannelEndpointId, scoped_refptr<ChannelEndpoint>>;
+  // The creation thread's copy of |local_id_to_endpoint_map_| (below), used
+  // (only on the creation thread) to look up the endpoints that incoming
+  // messages are for without taking |lock_|. It's brought up to date (under
+  // |lock_|) before each lookup, but only if |has_changed_local_ids_| is set,
+  // which it's only while |changed_local_ids_| is nonempty. (So it may hold
+  // references to endpoints that have since been removed from the channel, but
+  // only until the next message is read.)
+  IdToEndpointMap creation_thread_endpoint_map_;
+  base::subtle::Atomic32 has_changed_local_ids_;
+
   // Note: |ChannelEndpointClient|s (in particular, |MessagePipe|s) MUST NOT be
   // used under |lock_|. E.g., |lock_| can only be acquired after
   // |MessagePipe::lock_|, never before. Thus to call into a
@@ -246,11 +287,15 @@ class MOJO_SYSTEM_IMPL_EXPORT Channel
   // Has a reference to us.
   ChannelManager* channel_manager_;
 
-  using IdToEndpointMap =
-      base::hash_map<ChannelEndpointId, scoped_refptr<ChannelEndpoint>>;
+  LockStats lock_stats_;
+
   // Map from local IDs to endpoints. If the endpoint is null, this means that
   // we're just waiting for the remove ack before removing the entry.
   IdToEndpointMap local_id_to_endpoint_map_;
+  // Local IDs whose entries in |local_id_to_endpoint_map_| have changed since
+  // |creation_thread_endpoint_map_| was last updated (possibly with
+  // duplicates).
+  std::vector<ChannelEndpointId> changed_local_ids_;
   // Note: The IDs generated by this should be checked for existence before use.
   LocalChannelEndpointIdGenerator local_id_generator_;
 
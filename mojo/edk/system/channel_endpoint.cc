@@ -48,6 +48,33 @@ bool ChannelEndpoint::EnqueueMessage(scoped_ptr<MessageInTransit> message) {
   return false;
 }
 
+bool ChannelEndpoint::EnqueueMessages(MessageInTransitQueue* messages) {
+  DCHECK(!messages->IsEmpty());
+
+  base::AutoLock locker(lock_);
+
+  switch (channel_state_) {
+    case ChannelState::NOT_YET_ATTACHED:
+    case ChannelState::DETACHED:
+      // See |EnqueueMessage()|.
+      while (!messages->IsEmpty())
+        channel_message_queue_.AddMessage(messages->GetMessage());
+      return true;
+    case ChannelState::ATTACHED: {
+      MessageInTransitQueue prepared_messages;
+      while (!messages->IsEmpty()) {
+        scoped_ptr<MessageInTransit> message = messages->GetMessage();
+        PrepareMessageForChannelNoLock(message.get());
+        prepared_messages.AddMessage(message.Pass());
+      }
+      return channel_->WriteMessages(&prepared_messages);
+    }
+  }
+
+  NOTREACHED();
+  return false;
+}
+
 bool ChannelEndpoint::ReplaceClient(ChannelEndpointClient* client,
                                     unsigned client_port) {
   DCHECK(client);
@@ -154,6 +181,12 @@ ChannelEndpoint::~ChannelEndpoint() {
 bool ChannelEndpoint::WriteMessageNoLock(scoped_ptr<MessageInTransit> message) {
   DCHECK(message);
 
+  PrepareMessageForChannelNoLock(message.get());
+  return channel_->WriteMessage(message.Pass());
+}
+
+void ChannelEndpoint::PrepareMessageForChannelNoLock(
+    MessageInTransit* message) {
   lock_.AssertAcquired();
 
   DCHECK(channel_);
@@ -163,7 +196,6 @@ bool ChannelEndpoint::WriteMessageNoLock(scoped_ptr<MessageInTransit> message) {
   message->SerializeAndCloseDispatchers(channel_);
   message->set_source_id(local_id_);
   message->set_destination_id(remote_id_);
-  return channel_->WriteMessage(message.Pass());
 }
 
 void ChannelEndpoint::OnReadMessageForClient(
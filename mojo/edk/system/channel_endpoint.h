@@ -129,6 +129,10 @@ class MOJO_SYSTEM_IMPL_EXPORT ChannelEndpoint
   // been called, the message will be enqueued and sent when |AttachAndRun()| is
   // called.)
   bool EnqueueMessage(scoped_ptr<MessageInTransit> message);
+  // Like |EnqueueMessage()|, but for all the messages in |*messages| (which
+  // will be left empty). If attached, they're written to the |Channel|
+  // together.
+  bool EnqueueMessages(MessageInTransitQueue* messages);
 
   // Called to *replace* current client with a new client (which must differ
   // from the existing client). This must not be called after
@@ -164,6 +168,9 @@ class MOJO_SYSTEM_IMPL_EXPORT ChannelEndpoint
 
   // Must be called with |lock_| held.
   bool WriteMessageNoLock(scoped_ptr<MessageInTransit> message);
+  // Prepares |message| to be written to |channel_|. Must be called with |lock_|
+  // held.
+  void PrepareMessageForChannelNoLock(MessageInTransit* message);
 
   // Helper for |OnReadMessage()|, handling messages for the client.
   void OnReadMessageForClient(scoped_ptr<MessageInTransit> message);
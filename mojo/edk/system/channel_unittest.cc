@@ -114,6 +114,67 @@ TEST_F(ChannelTest, WaitAfterAttachRunAndShutdown) {
   EXPECT_TRUE(channel(0)->HasOneRef());
 }
 
+// ChannelTest.LockStats -------------------------------------------------------
+
+TEST_F(ChannelTest, LockStats) {
+  static const char kHello[] = "hello";
+
+  PostMethodToIOThreadAndWait(FROM_HERE,
+                              &ChannelTest::CreateAndInitChannelOnIOThread, 0);
+  PostMethodToIOThreadAndWait(FROM_HERE,
+                              &ChannelTest::CreateAndInitChannelOnIOThread, 1);
+
+  Channel::LockStats stats = channel(0)->GetLockStats();
+  EXPECT_EQ(0u, stats.num_contended_acquisitions);
+  EXPECT_EQ(base::TimeDelta(), stats.total_wait_time);
+  const uint64_t initial_num_acquisitions = stats.num_acquisitions;
+
+  scoped_refptr<ChannelEndpoint> ep0;
+  scoped_refptr<MessagePipe> mp0(MessagePipe::CreateLocalProxy(&ep0));
+  channel(0)->SetBootstrapEndpoint(ep0);
+  scoped_refptr<ChannelEndpoint> ep1;
+  scoped_refptr<MessagePipe> mp1(MessagePipe::CreateLocalProxy(&ep1));
+  channel(1)->SetBootstrapEndpoint(ep1);
+
+  // Messages should still get to the (bootstrap) endpoint, which is looked up
+  // without taking the lock.
+  Waiter waiter;
+  waiter.Init();
+  ASSERT_EQ(
+      MOJO_RESULT_OK,
+      mp1->AddAwakable(0, &waiter, MOJO_HANDLE_SIGNAL_READABLE, 123, nullptr));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            mp0->WriteMessage(0, UserPointer<const void>(kHello),
+                              sizeof(kHello), nullptr,
+                              MOJO_WRITE_MESSAGE_FLAG_NONE));
+  uint32_t context = 0;
+  EXPECT_EQ(MOJO_RESULT_OK, waiter.Wait(test::ActionDeadline(), &context));
+  EXPECT_EQ(123u, context);
+  mp1->RemoveAwakable(0, &waiter, nullptr);
+
+  char buffer[100] = {};
+  uint32_t buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            mp1->ReadMessage(0, UserPointer<void>(buffer),
+                             MakeUserPointer(&buffer_size), nullptr, nullptr,
+                             MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(sizeof(kHello), static_cast<size_t>(buffer_size));
+  EXPECT_STREQ(kHello, buffer);
+
+  // We can't tell if there was contention, but acquisitions were counted.
+  stats = channel(0)->GetLockStats();
+  EXPECT_GT(stats.num_acquisitions, initial_num_acquisitions);
+  EXPECT_LE(stats.num_contended_acquisitions, stats.num_acquisitions);
+
+  mp0->Close(0);
+  mp1->Close(0);
+
+  PostMethodToIOThreadAndWait(FROM_HERE,
+                              &ChannelTest::ShutdownChannelOnIOThread, 0);
+  PostMethodToIOThreadAndWait(FROM_HERE,
+                              &ChannelTest::ShutdownChannelOnIOThread, 1);
+}
+
 // TODO(vtl): More. ------------------------------------------------------------
 
 }  // namespace
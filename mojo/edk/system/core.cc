@@ -21,6 +21,7 @@
 #include "mojo/edk/system/message_pipe.h"
 #include "mojo/edk/system/message_pipe_dispatcher.h"
 #include "mojo/edk/system/shared_buffer_dispatcher.h"
+#include "mojo/edk/system/wait_set_dispatcher.h"
 #include "mojo/edk/system/waiter.h"
 #include "mojo/public/c/system/macros.h"
 
@@ -56,19 +57,23 @@ namespace system {
 // Thread-safety notes
 //
 // Mojo primitives calls are thread-safe. We achieve this with relatively
-// fine-grained locking. There is a global handle table lock. This lock should
-// be held as briefly as possible (TODO(vtl): a future improvement would be to
-// switch it to a reader-writer lock). Each |Dispatcher| object then has a lock
+// fine-grained locking. The global handle table is split into shards, each with
+// its own lock (see handle_table.h); these locks should be held as briefly as
+// possible, and at most one at a time. Each |Dispatcher| object then has a lock
 // (which subclasses can use to protect their data).
 //
 // The lock ordering is as follows:
-//   1. global handle table lock, global mapping table lock
-//   2. |Dispatcher| locks
+//   1. |Dispatcher| locks
+//   2. handle table shard locks, global mapping table lock
 //   3. secondary object locks
 //   ...
 //   INF. |Waiter| locks
 //
 // Notes:
+//    - |HandleTable::MarkBusyAndStartTransport()| takes a shard lock while
+//      holding the locks of the dispatchers it has already started transport
+//      on. While holding a shard lock, a |Dispatcher| lock may only be taken
+//      with |Try()| (which can't deadlock).
 //    - While holding a |Dispatcher| lock, you may not unconditionally attempt
 //      to take another |Dispatcher| lock. (This has consequences on the
 //      concurrency semantics of |MojoWriteMessage()| when passing handles.)
@@ -76,6 +81,15 @@ namespace system {
 //    - Locks at the "INF" level may not have any locks taken while they are
 //      held.
 
+namespace {
+
+bool IsValidMessageContextThunks(const MojoMessageContextThunks* thunks) {
+  return thunks && thunks->struct_size >= sizeof(MojoMessageContextThunks) &&
+         thunks->GetSerializedSize && thunks->Serialize && thunks->Destroy;
+}
+
+}  // namespace
+
 // TODO(vtl): This should take a |scoped_ptr<PlatformSupport>| as a parameter.
 Core::Core(embedder::PlatformSupport* platform_support)
     : platform_support_(platform_support) {
@@ -85,7 +99,6 @@ Core::~Core() {
 }
 
 MojoHandle Core::AddDispatcher(const scoped_refptr<Dispatcher>& dispatcher) {
-  base::AutoLock locker(handle_table_lock_);
   return handle_table_.AddDispatcher(dispatcher);
 }
 
@@ -93,7 +106,6 @@ scoped_refptr<Dispatcher> Core::GetDispatcher(MojoHandle handle) {
   if (handle == MOJO_HANDLE_INVALID)
     return nullptr;
 
-  base::AutoLock locker(handle_table_lock_);
   return handle_table_.GetDispatcher(handle);
 }
 
@@ -102,7 +114,6 @@ MojoResult Core::GetAndRemoveDispatcher(MojoHandle handle,
   if (handle == MOJO_HANDLE_INVALID)
     return MOJO_RESULT_INVALID_ARGUMENT;
 
-  base::AutoLock locker(handle_table_lock_);
   return handle_table_.GetAndRemoveDispatcher(handle, dispatcher);
 }
 
@@ -128,17 +139,13 @@ MojoResult Core::Close(MojoHandle handle) {
     return MOJO_RESULT_INVALID_ARGUMENT;
 
   scoped_refptr<Dispatcher> dispatcher;
-  {
-    base::AutoLock locker(handle_table_lock_);
-    MojoResult result =
-        handle_table_.GetAndRemoveDispatcher(handle, &dispatcher);
-    if (result != MOJO_RESULT_OK)
-      return result;
-  }
+  MojoResult result = handle_table_.GetAndRemoveDispatcher(handle, &dispatcher);
+  if (result != MOJO_RESULT_OK)
+    return result;
 
   // The dispatcher doesn't have a say in being closed, but gets notified of it.
-  // Note: This is done outside of |handle_table_lock_|. As a result, there's a
-  // race condition that the dispatcher must handle; see the comment in
+  // Note: This is done outside of the handle table's locks. As a result, there's
+  // a race condition that the dispatcher must handle; see the comment in
   // |Dispatcher| in dispatcher.h.
   return dispatcher->Close();
 }
@@ -208,11 +215,8 @@ MojoResult Core::CreateMessagePipe(
   scoped_refptr<MessagePipeDispatcher> dispatcher1(
       new MessagePipeDispatcher(validated_options));
 
-  std::pair<MojoHandle, MojoHandle> handle_pair;
-  {
-    base::AutoLock locker(handle_table_lock_);
-    handle_pair = handle_table_.AddDispatcherPair(dispatcher0, dispatcher1);
-  }
+  std::pair<MojoHandle, MojoHandle> handle_pair =
+      handle_table_.AddDispatcherPair(dispatcher0, dispatcher1);
   if (handle_pair.first == MOJO_HANDLE_INVALID) {
     DCHECK_EQ(handle_pair.second, MOJO_HANDLE_INVALID);
     LOG(ERROR) << "Handle table full";
@@ -252,8 +256,8 @@ MojoResult Core::WriteMessage(MojoHandle message_pipe_handle,
     return dispatcher->WriteMessage(bytes, num_bytes, nullptr, flags);
 
   // We have to handle |handles| here, since we have to mark them busy in the
-  // global handle table. We can't delegate this to the dispatcher, since the
-  // handle table lock must be acquired before the dispatcher lock.
+  // global handle table. We can't delegate this to the dispatcher, since its
+  // lock would then be held while the handles' dispatcher locks are taken.
   //
   // (This leads to an oddity: |handles|/|num_handles| are always verified for
   // validity, even for dispatchers that don't support |WriteMessage()| and will
@@ -274,33 +278,109 @@ MojoResult Core::WriteMessage(MojoHandle message_pipe_handle,
   // When we pass handles, we have to try to take all their dispatchers' locks
   // and mark the handles as busy. If the call succeeds, we then remove the
   // handles from the handle table.
-  {
-    base::AutoLock locker(handle_table_lock_);
-    MojoResult result = handle_table_.MarkBusyAndStartTransport(
-        message_pipe_handle, handles_reader.GetPointer(), num_handles,
-        &transports);
-    if (result != MOJO_RESULT_OK)
-      return result;
-  }
+  MojoResult result = handle_table_.MarkBusyAndStartTransport(
+      message_pipe_handle, handles_reader.GetPointer(), num_handles,
+      &transports);
+  if (result != MOJO_RESULT_OK)
+    return result;
 
   MojoResult rv =
       dispatcher->WriteMessage(bytes, num_bytes, &transports, flags);
 
   // We need to release the dispatcher locks before we take the handle table
-  // lock.
+  // locks.
   for (uint32_t i = 0; i < num_handles; i++)
     transports[i].End();
 
-  {
-    base::AutoLock locker(handle_table_lock_);
-    if (rv == MOJO_RESULT_OK) {
-      handle_table_.RemoveBusyHandles(handles_reader.GetPointer(), num_handles);
-    } else {
-      handle_table_.RestoreBusyHandles(handles_reader.GetPointer(),
-                                       num_handles);
+  if (rv == MOJO_RESULT_OK)
+    handle_table_.RemoveBusyHandles(handles_reader.GetPointer(), num_handles);
+  else
+    handle_table_.RestoreBusyHandles(handles_reader.GetPointer(), num_handles);
+
+  return rv;
+}
+
+MojoResult Core::WriteMessages(MojoHandle message_pipe_handle,
+                               UserPointer<const void> bytes,
+                               uint32_t num_bytes,
+                               UserPointer<const MojoHandle> handles,
+                               uint32_t num_handles,
+                               UserPointer<const uint32_t> message_num_bytes,
+                               UserPointer<const uint32_t> message_num_handles,
+                               uint32_t num_messages,
+                               MojoWriteMessageFlags flags) {
+  scoped_refptr<Dispatcher> dispatcher(GetDispatcher(message_pipe_handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  if (num_messages == 0)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  if (num_handles > 0 && message_num_handles.IsNull())
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  // We copy the per-message sizes (and the handles) before looking at them, so
+  // bound their numbers up front. (The handles must all be distinct, so there
+  // can't be more of them than fit in the handle table.)
+  if (num_messages > GetConfiguration().max_write_messages_num_messages)
+    return MOJO_RESULT_RESOURCE_EXHAUSTED;
+  if (num_handles > GetConfiguration().max_handle_table_size)
+    return MOJO_RESULT_RESOURCE_EXHAUSTED;
+
+  // Each message must be within the limits for a single message (see
+  // |WriteMessage()|), and the per-message sizes must add up to the totals.
+  UserPointer<const uint32_t>::Reader message_num_bytes_reader(
+      message_num_bytes, num_messages);
+  uint64_t total_num_bytes = 0;
+  for (uint32_t i = 0; i < num_messages; i++) {
+    uint32_t size = message_num_bytes_reader.GetPointer()[i];
+    if (size > GetConfiguration().max_message_num_bytes)
+      return MOJO_RESULT_RESOURCE_EXHAUSTED;
+    total_num_bytes += size;
+  }
+  if (total_num_bytes != num_bytes)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  std::vector<uint32_t> message_num_handles_values;
+  if (!message_num_handles.IsNull()) {
+    message_num_handles_values.resize(num_messages);
+    message_num_handles.GetArray(&message_num_handles_values[0], num_messages);
+    uint64_t total_num_handles = 0;
+    for (uint32_t i = 0; i < num_messages; i++) {
+      if (message_num_handles_values[i] >
+          GetConfiguration().max_message_num_handles)
+        return MOJO_RESULT_RESOURCE_EXHAUSTED;
+      total_num_handles += message_num_handles_values[i];
     }
+    if (total_num_handles != num_handles)
+      return MOJO_RESULT_INVALID_ARGUMENT;
   }
 
+  // Easy case: not sending any handles.
+  if (num_handles == 0) {
+    return dispatcher->WriteMessages(bytes,
+                                     message_num_bytes_reader.GetPointer(),
+                                     nullptr, nullptr, num_messages, flags);
+  }
+
+  // See |WriteMessage()|.
+  UserPointer<const MojoHandle>::Reader handles_reader(handles, num_handles);
+  std::vector<DispatcherTransport> transports(num_handles);
+  MojoResult result = handle_table_.MarkBusyAndStartTransport(
+      message_pipe_handle, handles_reader.GetPointer(), num_handles,
+      &transports);
+  if (result != MOJO_RESULT_OK)
+    return result;
+
+  MojoResult rv = dispatcher->WriteMessages(
+      bytes, message_num_bytes_reader.GetPointer(), &transports,
+      &message_num_handles_values[0], num_messages, flags);
+
+  for (uint32_t i = 0; i < num_handles; i++)
+    transports[i].End();
+
+  if (rv == MOJO_RESULT_OK)
+    handle_table_.RemoveBusyHandles(handles_reader.GetPointer(), num_handles);
+  else
+    handle_table_.RestoreBusyHandles(handles_reader.GetPointer(), num_handles);
+
   return rv;
 }
 
@@ -330,27 +410,8 @@ MojoResult Core::ReadMessage(MojoHandle message_pipe_handle,
       DCHECK(!num_handles.IsNull());
       DCHECK_LE(dispatchers.size(), static_cast<size_t>(num_handles_value));
 
-      bool success;
-      UserPointer<MojoHandle>::Writer handles_writer(handles,
-                                                     dispatchers.size());
-      {
-        base::AutoLock locker(handle_table_lock_);
-        success = handle_table_.AddDispatcherVector(
-            dispatchers, handles_writer.GetPointer());
-      }
-      if (success) {
-        handles_writer.Commit();
-      } else {
-        LOG(ERROR) << "Received message with " << dispatchers.size()
-                   << " handles, but handle table full";
-        // Close dispatchers (outside the lock).
-        for (size_t i = 0; i < dispatchers.size(); i++) {
-          if (dispatchers[i])
-            dispatchers[i]->Close();
-        }
-        if (rv == MOJO_RESULT_OK)
-          rv = MOJO_RESULT_RESOURCE_EXHAUSTED;
-      }
+      if (!AddReceivedDispatchers(dispatchers, handles))
+        rv = MOJO_RESULT_RESOURCE_EXHAUSTED;
     }
   }
 
@@ -359,6 +420,98 @@ MojoResult Core::ReadMessage(MojoHandle message_pipe_handle,
   return rv;
 }
 
+MojoResult Core::ReadMessages(MojoHandle message_pipe_handle,
+                              UserPointer<void> bytes,
+                              UserPointer<uint32_t> num_bytes,
+                              UserPointer<MojoHandle> handles,
+                              UserPointer<uint32_t> num_handles,
+                              UserPointer<uint32_t> message_num_bytes,
+                              UserPointer<uint32_t> message_num_handles,
+                              UserPointer<uint32_t> num_messages,
+                              MojoReadMessageFlags flags) {
+  scoped_refptr<Dispatcher> dispatcher(GetDispatcher(message_pipe_handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  if (num_messages.IsNull() || num_messages.Get() == 0 ||
+      message_num_bytes.IsNull())
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  uint32_t num_handles_value = num_handles.IsNull() ? 0 : num_handles.Get();
+
+  // As in |ReadMessage()|, don't bother with a |DispatcherVector| if no handles
+  // can be received.
+  DispatcherVector dispatchers;
+  MojoResult rv = dispatcher->ReadMessages(
+      bytes, num_bytes, num_handles_value ? &dispatchers : nullptr,
+      &num_handles_value, message_num_bytes, message_num_handles, num_messages,
+      flags);
+  if (!dispatchers.empty()) {
+    DCHECK_EQ(rv, MOJO_RESULT_OK);
+    DCHECK(!num_handles.IsNull());
+    DCHECK_EQ(dispatchers.size(), static_cast<size_t>(num_handles_value));
+
+    if (!AddReceivedDispatchers(dispatchers, handles))
+      rv = MOJO_RESULT_RESOURCE_EXHAUSTED;
+  }
+
+  if (!num_handles.IsNull())
+    num_handles.Put(num_handles_value);
+  return rv;
+}
+
+MojoResult Core::WriteMessageContext(MojoHandle message_pipe_handle,
+                                     uintptr_t context,
+                                     const MojoMessageContextThunks* thunks,
+                                     MojoWriteMessageFlags flags) {
+  scoped_refptr<Dispatcher> dispatcher(GetDispatcher(message_pipe_handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  if (!IsValidMessageContextThunks(thunks))
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return dispatcher->WriteMessageContext(context, thunks, flags);
+}
+
+MojoResult Core::ReadMessageContext(MojoHandle message_pipe_handle,
+                                    const MojoMessageContextThunks* thunks,
+                                    UserPointer<uintptr_t> context,
+                                    UserPointer<void> bytes,
+                                    UserPointer<uint32_t> num_bytes,
+                                    UserPointer<MojoHandle> handles,
+                                    UserPointer<uint32_t> num_handles,
+                                    MojoReadMessageFlags flags) {
+  scoped_refptr<Dispatcher> dispatcher(GetDispatcher(message_pipe_handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  if (!IsValidMessageContextThunks(thunks) || context.IsNull())
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  uint32_t num_handles_value = num_handles.IsNull() ? 0 : num_handles.Get();
+
+  // This is like |ReadMessage()|.
+  uintptr_t context_value = 0;
+  DispatcherVector dispatchers;
+  MojoResult rv = dispatcher->ReadMessageContext(
+      thunks, &context_value, bytes, num_bytes,
+      num_handles_value ? &dispatchers : nullptr, &num_handles_value, flags);
+  if (!dispatchers.empty()) {
+    DCHECK_EQ(rv, MOJO_RESULT_OK);
+    DCHECK(!num_handles.IsNull());
+    DCHECK_LE(dispatchers.size(), static_cast<size_t>(num_handles_value));
+
+    if (!AddReceivedDispatchers(dispatchers, handles))
+      rv = MOJO_RESULT_RESOURCE_EXHAUSTED;
+  }
+
+  context.Put(context_value);
+  if (!num_handles.IsNull())
+    num_handles.Put(num_handles_value);
+  return rv;
+}
+
 MojoResult Core::CreateDataPipe(
     UserPointer<const MojoCreateDataPipeOptions> options,
     UserPointer<MojoHandle> data_pipe_producer_handle,
@@ -374,12 +527,8 @@ MojoResult Core::CreateDataPipe(
   scoped_refptr<DataPipeConsumerDispatcher> consumer_dispatcher(
       new DataPipeConsumerDispatcher());
 
-  std::pair<MojoHandle, MojoHandle> handle_pair;
-  {
-    base::AutoLock locker(handle_table_lock_);
-    handle_pair = handle_table_.AddDispatcherPair(producer_dispatcher,
-                                                  consumer_dispatcher);
-  }
+  std::pair<MojoHandle, MojoHandle> handle_pair =
+      handle_table_.AddDispatcherPair(producer_dispatcher, consumer_dispatcher);
   if (handle_pair.first == MOJO_HANDLE_INVALID) {
     DCHECK_EQ(handle_pair.second, MOJO_HANDLE_INVALID);
     LOG(ERROR) << "Handle table full";
@@ -398,6 +547,29 @@ MojoResult Core::CreateDataPipe(
   return MOJO_RESULT_OK;
 }
 
+MojoResult Core::SetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    UserPointer<const MojoDataPipeProducerOptions> options) {
+  scoped_refptr<Dispatcher> dispatcher(
+      GetDispatcher(data_pipe_producer_handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return dispatcher->SetDataPipeProducerOptions(options);
+}
+
+MojoResult Core::GetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    UserPointer<MojoDataPipeProducerOptions> options,
+    uint32_t options_num_bytes) {
+  scoped_refptr<Dispatcher> dispatcher(
+      GetDispatcher(data_pipe_producer_handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return dispatcher->GetDataPipeProducerOptions(options, options_num_bytes);
+}
+
 MojoResult Core::WriteData(MojoHandle data_pipe_producer_handle,
                            UserPointer<const void> elements,
                            UserPointer<uint32_t> num_bytes,
@@ -432,6 +604,29 @@ MojoResult Core::EndWriteData(MojoHandle data_pipe_producer_handle,
   return dispatcher->EndWriteData(num_bytes_written);
 }
 
+MojoResult Core::SetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    UserPointer<const MojoDataPipeConsumerOptions> options) {
+  scoped_refptr<Dispatcher> dispatcher(
+      GetDispatcher(data_pipe_consumer_handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return dispatcher->SetDataPipeConsumerOptions(options);
+}
+
+MojoResult Core::GetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    UserPointer<MojoDataPipeConsumerOptions> options,
+    uint32_t options_num_bytes) {
+  scoped_refptr<Dispatcher> dispatcher(
+      GetDispatcher(data_pipe_consumer_handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return dispatcher->GetDataPipeConsumerOptions(options, options_num_bytes);
+}
+
 MojoResult Core::ReadData(MojoHandle data_pipe_consumer_handle,
                           UserPointer<void> elements,
                           UserPointer<uint32_t> num_bytes,
@@ -553,6 +748,78 @@ MojoResult Core::UnmapBuffer(UserPointer<void> buffer) {
   return mapping_table_.RemoveMapping(buffer.GetPointerValue());
 }
 
+MojoResult Core::CreateWaitSet(UserPointer<MojoHandle> wait_set_handle) {
+  scoped_refptr<WaitSetDispatcher> dispatcher(new WaitSetDispatcher());
+  MojoHandle handle = AddDispatcher(dispatcher);
+  if (handle == MOJO_HANDLE_INVALID) {
+    LOG(ERROR) << "Handle table full";
+    dispatcher->Close();
+    return MOJO_RESULT_RESOURCE_EXHAUSTED;
+  }
+
+  wait_set_handle.Put(handle);
+  return MOJO_RESULT_OK;
+}
+
+MojoResult Core::AddHandle(MojoHandle wait_set_handle,
+                           MojoHandle handle,
+                           MojoHandleSignals signals) {
+  scoped_refptr<Dispatcher> wait_set_dispatcher(GetDispatcher(wait_set_handle));
+  if (!wait_set_dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  scoped_refptr<Dispatcher> dispatcher(GetDispatcher(handle));
+  if (!dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return wait_set_dispatcher->AddWaitingDispatcher(dispatcher, handle,
+                                                   signals);
+}
+
+MojoResult Core::RemoveHandle(MojoHandle wait_set_handle, MojoHandle handle) {
+  scoped_refptr<Dispatcher> wait_set_dispatcher(GetDispatcher(wait_set_handle));
+  if (!wait_set_dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return wait_set_dispatcher->RemoveWaitingDispatcher(handle);
+}
+
+MojoResult Core::GetReadyHandles(
+    MojoHandle wait_set_handle,
+    UserPointer<uint32_t> count,
+    UserPointer<MojoHandle> handles,
+    UserPointer<MojoResult> results,
+    UserPointer<MojoHandleSignalsState> signals_states) {
+  scoped_refptr<Dispatcher> wait_set_dispatcher(GetDispatcher(wait_set_handle));
+  if (!wait_set_dispatcher)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  uint32_t max_count = count.Get();
+  if (max_count == 0)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  // Note: We deliberately don't use |UserPointer<...>::Writer|s here, since
+  // they'd cost O(|max_count|) instead of O(number of ready handles).
+  std::vector<MojoHandle> ready_handles;
+  std::vector<MojoResult> ready_results;
+  std::vector<HandleSignalsState> ready_signals_states;
+  MojoResult rv = wait_set_dispatcher->GetReadyHandles(
+      max_count, &ready_handles, &ready_results, &ready_signals_states);
+  if (rv != MOJO_RESULT_OK)
+    return rv;
+
+  DCHECK(!ready_handles.empty());
+  DCHECK_LE(ready_handles.size(), max_count);
+  handles.PutArray(&ready_handles[0], ready_handles.size());
+  results.PutArray(&ready_results[0], ready_results.size());
+  if (!signals_states.IsNull()) {
+    // Note: This is safe, since |HandleSignalsState| is a subclass of
+    // |MojoHandleSignalsState| that doesn't add any data members.
+    signals_states.PutArray(&ready_signals_states[0],
+                            ready_signals_states.size());
+  }
+  count.Put(static_cast<uint32_t>(ready_handles.size()));
+  return MOJO_RESULT_OK;
+}
+
 // Note: We allow |handles| to repeat the same handle multiple times, since
 // different flags may be specified.
 // TODO(vtl): This incurs a performance cost in |Remove()|. Analyze this
@@ -613,5 +880,24 @@ MojoResult Core::WaitManyInternal(const MojoHandle* handles,
   return rv;
 }
 
+bool Core::AddReceivedDispatchers(const DispatcherVector& dispatchers,
+                                  UserPointer<MojoHandle> handles) {
+  UserPointer<MojoHandle>::Writer handles_writer(handles, dispatchers.size());
+  if (handle_table_.AddDispatcherVector(dispatchers,
+                                        handles_writer.GetPointer())) {
+    handles_writer.Commit();
+    return true;
+  }
+
+  LOG(ERROR) << "Received message with " << dispatchers.size()
+             << " handles, but handle table full";
+  // Close dispatchers (outside the handle table's locks).
+  for (size_t i = 0; i < dispatchers.size(); i++) {
+    if (dispatchers[i])
+      dispatchers[i]->Close();
+  }
+  return false;
+}
+
 }  // namespace system
 }  // namespace mojo
@@ -108,12 +108,44 @@ class MOJO_SYSTEM_IMPL_EXPORT Core {
                           UserPointer<const MojoHandle> handles,
                           uint32_t num_handles,
                           MojoWriteMessageFlags flags);
+  MojoResult WriteMessages(MojoHandle message_pipe_handle,
+                           UserPointer<const void> bytes,
+                           uint32_t num_bytes,
+                           UserPointer<const MojoHandle> handles,
+                           uint32_t num_handles,
+                           UserPointer<const uint32_t> message_num_bytes,
+                           UserPointer<const uint32_t> message_num_handles,
+                           uint32_t num_messages,
+                           MojoWriteMessageFlags flags);
   MojoResult ReadMessage(MojoHandle message_pipe_handle,
                          UserPointer<void> bytes,
                          UserPointer<uint32_t> num_bytes,
                          UserPointer<MojoHandle> handles,
                          UserPointer<uint32_t> num_handles,
                          MojoReadMessageFlags flags);
+  MojoResult ReadMessages(MojoHandle message_pipe_handle,
+                          UserPointer<void> bytes,
+                          UserPointer<uint32_t> num_bytes,
+                          UserPointer<MojoHandle> handles,
+                          UserPointer<uint32_t> num_handles,
+                          UserPointer<uint32_t> message_num_bytes,
+                          UserPointer<uint32_t> message_num_handles,
+                          UserPointer<uint32_t> num_messages,
+                          MojoReadMessageFlags flags);
+  // Note: |thunks| is not a |UserPointer|, since the functions it points to
+  // are called anyway.
+  MojoResult WriteMessageContext(MojoHandle message_pipe_handle,
+                                 uintptr_t context,
+                                 const MojoMessageContextThunks* thunks,
+                                 MojoWriteMessageFlags flags);
+  MojoResult ReadMessageContext(MojoHandle message_pipe_handle,
+                                const MojoMessageContextThunks* thunks,
+                                UserPointer<uintptr_t> context,
+                                UserPointer<void> bytes,
+                                UserPointer<uint32_t> num_bytes,
+                                UserPointer<MojoHandle> handles,
+                                UserPointer<uint32_t> num_handles,
+                                MojoReadMessageFlags flags);
 
   // These methods correspond to the API functions defined in
   // "mojo/public/c/system/data_pipe.h":
@@ -121,6 +153,13 @@ class MOJO_SYSTEM_IMPL_EXPORT Core {
       UserPointer<const MojoCreateDataPipeOptions> options,
       UserPointer<MojoHandle> data_pipe_producer_handle,
       UserPointer<MojoHandle> data_pipe_consumer_handle);
+  MojoResult SetDataPipeProducerOptions(
+      MojoHandle data_pipe_producer_handle,
+      UserPointer<const MojoDataPipeProducerOptions> options);
+  MojoResult GetDataPipeProducerOptions(
+      MojoHandle data_pipe_producer_handle,
+      UserPointer<MojoDataPipeProducerOptions> options,
+      uint32_t options_num_bytes);
   MojoResult WriteData(MojoHandle data_pipe_producer_handle,
                        UserPointer<const void> elements,
                        UserPointer<uint32_t> num_bytes,
@@ -131,6 +170,13 @@ class MOJO_SYSTEM_IMPL_EXPORT Core {
                             MojoWriteDataFlags flags);
   MojoResult EndWriteData(MojoHandle data_pipe_producer_handle,
                           uint32_t num_bytes_written);
+  MojoResult SetDataPipeConsumerOptions(
+      MojoHandle data_pipe_consumer_handle,
+      UserPointer<const MojoDataPipeConsumerOptions> options);
+  MojoResult GetDataPipeConsumerOptions(
+      MojoHandle data_pipe_consumer_handle,
+      UserPointer<MojoDataPipeConsumerOptions> options,
+      uint32_t options_num_bytes);
   MojoResult ReadData(MojoHandle data_pipe_consumer_handle,
                       UserPointer<void> elements,
                       UserPointer<uint32_t> num_bytes,
@@ -159,6 +205,19 @@ class MOJO_SYSTEM_IMPL_EXPORT Core {
                        MojoMapBufferFlags flags);
   MojoResult UnmapBuffer(UserPointer<void> buffer);
 
+  // These methods correspond to the API functions defined in
+  // "mojo/public/c/system/wait_set.h":
+  MojoResult CreateWaitSet(UserPointer<MojoHandle> wait_set_handle);
+  MojoResult AddHandle(MojoHandle wait_set_handle,
+                       MojoHandle handle,
+                       MojoHandleSignals signals);
+  MojoResult RemoveHandle(MojoHandle wait_set_handle, MojoHandle handle);
+  MojoResult GetReadyHandles(MojoHandle wait_set_handle,
+                             UserPointer<uint32_t> count,
+                             UserPointer<MojoHandle> handles,
+                             UserPointer<MojoResult> results,
+                             UserPointer<MojoHandleSignalsState> signals_states);
+
  private:
   friend bool internal::ShutdownCheckNoLeaks(Core*);
 
@@ -173,12 +232,16 @@ class MOJO_SYSTEM_IMPL_EXPORT Core {
                               uint32_t* result_index,
                               HandleSignalsState* signals_states);
 
+  // Used by |ReadMessage()| and |ReadMessages()| to add the received
+  // |dispatchers| to the handle table, writing their handles to |handles|. On
+  // failure (if the handle table is full), closes the dispatchers and returns
+  // false.
+  bool AddReceivedDispatchers(const DispatcherVector& dispatchers,
+                              UserPointer<MojoHandle> handles);
+
   embedder::PlatformSupport* const platform_support_;
 
-  // TODO(vtl): |handle_table_lock_| should be a reader-writer lock (if only we
-  // had them).
-  base::Lock handle_table_lock_;  // Protects |handle_table_|.
-  HandleTable handle_table_;
+  HandleTable handle_table_;  // Thread-safe.
 
   base::Lock mapping_table_lock_;  // Protects |mapping_table_|.
   MappingTable mapping_table_;
@@ -0,0 +1,252 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/core.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/scoped_vector.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/sys_info.h"
+#include "base/test/perf_log.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "mojo/edk/embedder/simple_platform_support.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace system {
+namespace {
+
+// The number of write/wait/read iterations each thread does.
+const size_t kNumIterationsPerThread = 50000;
+
+// Each iteration writes a message to its own message pipe, waits for it to be
+// readable, and reads the message (i.e., does three handle lookups in |Core|).
+class WriteWaitReadThread : public base::SimpleThread {
+ public:
+  WriteWaitReadThread(Core* core, base::WaitableEvent* start_event)
+      : base::SimpleThread("write_wait_read_thread"),
+        core_(core),
+        start_event_(start_event) {
+    CHECK_EQ(core_->CreateMessagePipe(NullUserPointer(),
+                                      MakeUserPointer(&handles_[0]),
+                                      MakeUserPointer(&handles_[1])),
+             MOJO_RESULT_OK);
+  }
+  ~WriteWaitReadThread() override {
+    Join();
+    CHECK_EQ(core_->Close(handles_[0]), MOJO_RESULT_OK);
+    CHECK_EQ(core_->Close(handles_[1]), MOJO_RESULT_OK);
+  }
+
+ private:
+  void Run() override {
+    start_event_->Wait();
+
+    const char kMessage[] = "hello";
+    char buffer[sizeof(kMessage)];
+    for (size_t i = 0; i < kNumIterationsPerThread; i++) {
+      CHECK_EQ(core_->WriteMessage(handles_[0], UserPointer<const void>(kMessage),
+                                   static_cast<uint32_t>(sizeof(kMessage)),
+                                   NullUserPointer(), 0,
+                                   MOJO_WRITE_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_OK);
+      CHECK_EQ(core_->Wait(handles_[1], MOJO_HANDLE_SIGNAL_READABLE,
+                           MOJO_DEADLINE_INDEFINITE, NullUserPointer()),
+               MOJO_RESULT_OK);
+      uint32_t num_bytes = static_cast<uint32_t>(sizeof(buffer));
+      CHECK_EQ(core_->ReadMessage(handles_[1], UserPointer<void>(buffer),
+                                  MakeUserPointer(&num_bytes),
+                                  NullUserPointer(), NullUserPointer(),
+                                  MOJO_READ_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_OK);
+    }
+  }
+
+  Core* const core_;
+  base::WaitableEvent* const start_event_;
+  MojoHandle handles_[2];
+
+  DISALLOW_COPY_AND_ASSIGN(WriteWaitReadThread);
+};
+
+// Measures the throughput of |Core| calls (which all go through the handle
+// table) on separate message pipes, from a varying number of threads.
+TEST(CorePerfTest, HandleTableContention) {
+  embedder::SimplePlatformSupport platform_support;
+  Core core(&platform_support);
+
+  size_t max_num_threads =
+      std::max(2 * static_cast<size_t>(base::SysInfo::NumberOfProcessors()),
+               static_cast<size_t>(8));
+  for (size_t num_threads = 1; num_threads <= max_num_threads;
+       num_threads *= 2) {
+    base::WaitableEvent start_event(true, false);  // Manual reset.
+    base::TimeTicks start_time;
+    {
+      ScopedVector<WriteWaitReadThread> threads;
+      for (size_t i = 0; i < num_threads; i++) {
+        threads.push_back(new WriteWaitReadThread(&core, &start_event));
+        threads.back()->Start();
+      }
+      start_time = base::TimeTicks::Now();
+      start_event.Signal();
+    }  // Joins all the threads.
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+
+    std::string test_name = base::StringPrintf(
+        "Core_HandleTableContention_%uThreads",
+        static_cast<unsigned>(num_threads));
+    base::LogPerfResult(test_name.c_str(),
+                        3.0 * num_threads * kNumIterationsPerThread /
+                            elapsed.InSecondsF(),
+                        "ops/s");
+  }
+}
+
+// Message pipes, one end of each of which is waited on (for readability), for
+// |WaitMany()| vs. wait set comparisons.
+class WaitablePipes {
+ public:
+  WaitablePipes(Core* core, size_t num_pipes)
+      : core_(core), wait_handles_(num_pipes), peer_handles_(num_pipes) {
+    for (size_t i = 0; i < num_pipes; i++) {
+      CHECK_EQ(core_->CreateMessagePipe(NullUserPointer(),
+                                        MakeUserPointer(&wait_handles_[i]),
+                                        MakeUserPointer(&peer_handles_[i])),
+               MOJO_RESULT_OK);
+    }
+  }
+  ~WaitablePipes() {
+    for (size_t i = 0; i < wait_handles_.size(); i++) {
+      CHECK_EQ(core_->Close(wait_handles_[i]), MOJO_RESULT_OK);
+      CHECK_EQ(core_->Close(peer_handles_[i]), MOJO_RESULT_OK);
+    }
+  }
+
+  // Makes the |i|-th waited-on handle readable.
+  void Write(size_t i) {
+    const char kMessage[] = "x";
+    CHECK_EQ(core_->WriteMessage(peer_handles_[i],
+                                 UserPointer<const void>(kMessage), 1u,
+                                 NullUserPointer(), 0,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE),
+             MOJO_RESULT_OK);
+  }
+
+  // Reads the message that made |handle| readable.
+  void Read(MojoHandle handle) {
+    char buffer[1];
+    uint32_t num_bytes = static_cast<uint32_t>(sizeof(buffer));
+    CHECK_EQ(core_->ReadMessage(handle, UserPointer<void>(buffer),
+                                MakeUserPointer(&num_bytes), NullUserPointer(),
+                                NullUserPointer(), MOJO_READ_MESSAGE_FLAG_NONE),
+             MOJO_RESULT_OK);
+  }
+
+  const std::vector<MojoHandle>& wait_handles() const {
+    return wait_handles_;
+  }
+
+ private:
+  Core* const core_;
+  std::vector<MojoHandle> wait_handles_;
+  std::vector<MojoHandle> peer_handles_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaitablePipes);
+};
+
+// The number of (write, wait, read) iterations done by the |WaitMany()| vs.
+// wait set tests.
+const size_t kNumWaitIterations = 2000;
+
+// Measures the rate at which a single ready handle among |num_handles| can be
+// found using |WaitMany()| vs. a wait set. The former is linear in the number
+// of handles, the latter should be independent of it.
+TEST(CorePerfTest, WaitManyVsWaitSet) {
+  embedder::SimplePlatformSupport platform_support;
+  Core core(&platform_support);
+
+  for (size_t num_handles = 10; num_handles <= 10000; num_handles *= 10) {
+    WaitablePipes pipes(&core, num_handles);
+    const std::vector<MojoHandle>& handles = pipes.wait_handles();
+
+    // |WaitMany()|:
+    {
+      std::vector<MojoHandleSignals> signals(num_handles,
+                                             MOJO_HANDLE_SIGNAL_READABLE);
+      base::TimeTicks start_time = base::TimeTicks::Now();
+      for (size_t i = 0; i < kNumWaitIterations; i++) {
+        size_t ready = (i * 7919) % num_handles;
+        pipes.Write(ready);
+        uint32_t result_index = static_cast<uint32_t>(-1);
+        CHECK_EQ(core.WaitMany(MakeUserPointer(&handles[0]),
+                               MakeUserPointer(&signals[0]),
+                               static_cast<uint32_t>(num_handles),
+                               MOJO_DEADLINE_INDEFINITE,
+                               MakeUserPointer(&result_index),
+                               NullUserPointer()),
+                 MOJO_RESULT_OK);
+        CHECK_EQ(result_index, ready);
+        pipes.Read(handles[result_index]);
+      }
+      base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+      std::string test_name = base::StringPrintf(
+          "Core_WaitMany_%uHandles", static_cast<unsigned>(num_handles));
+      base::LogPerfResult(test_name.c_str(),
+                          kNumWaitIterations / elapsed.InSecondsF(),
+                          "wakeups/s");
+    }
+
+    // Wait set:
+    {
+      MojoHandle wait_set = MOJO_HANDLE_INVALID;
+      CHECK_EQ(core.CreateWaitSet(MakeUserPointer(&wait_set)),
+               MOJO_RESULT_OK);
+      for (size_t i = 0; i < num_handles; i++) {
+        CHECK_EQ(core.AddHandle(wait_set, handles[i],
+                                MOJO_HANDLE_SIGNAL_READABLE),
+                 MOJO_RESULT_OK);
+      }
+      base::TimeTicks start_time = base::TimeTicks::Now();
+      for (size_t i = 0; i < kNumWaitIterations; i++) {
+        size_t ready = (i * 7919) % num_handles;
+        pipes.Write(ready);
+        CHECK_EQ(core.Wait(wait_set, MOJO_HANDLE_SIGNAL_READABLE,
+                           MOJO_DEADLINE_INDEFINITE, NullUserPointer()),
+                 MOJO_RESULT_OK);
+        uint32_t count = 1;
+        MojoHandle ready_handle = MOJO_HANDLE_INVALID;
+        MojoResult result = MOJO_RESULT_INTERNAL;
+        CHECK_EQ(core.GetReadyHandles(wait_set, MakeUserPointer(&count),
+                                      MakeUserPointer(&ready_handle),
+                                      MakeUserPointer(&result),
+                                      NullUserPointer()),
+                 MOJO_RESULT_OK);
+        CHECK_EQ(ready_handle, handles[ready]);
+        CHECK_EQ(result, MOJO_RESULT_OK);
+        pipes.Read(ready_handle);
+      }
+      base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+      CHECK_EQ(core.Close(wait_set), MOJO_RESULT_OK);
+      std::string test_name = base::StringPrintf(
+          "Core_WaitSet_%uHandles", static_cast<unsigned>(num_handles));
+      base::LogPerfResult(test_name.c_str(),
+                          kNumWaitIterations / elapsed.InSecondsF(),
+                          "wakeups/s");
+    }
+  }
+}
+
+}  // namespace
+}  // namespace system
+}  // namespace mojo
@@ -7,11 +7,18 @@
 #include <stdint.h>
 
 #include <limits>
+#include <string>
+#include <vector>
 
 #include "base/bind.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/scoped_vector.h"
 #include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "mojo/edk/system/awakable.h"
+#include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/core_test_base.h"
 
 namespace mojo {
@@ -701,6 +708,733 @@ TEST_F(CoreTest, MessagePipe) {
   EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
 }
 
+TEST_F(CoreTest, ReadMessages) {
+  MojoHandle h[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+
+  char buffer[10];
+  uint32_t buffer_size;
+  uint32_t message_sizes[3];
+  uint32_t message_num_handles[3];
+  uint32_t num_messages;
+
+  // Nothing to read yet.
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  num_messages = 3;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 NullUserPointer(), NullUserPointer(),
+                                 MakeUserPointer(message_sizes),
+                                 NullUserPointer(),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+
+  // Can't read zero messages.
+  num_messages = 0;
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 NullUserPointer(), NullUserPointer(),
+                                 MakeUserPointer(message_sizes),
+                                 NullUserPointer(),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+
+  // Write "a", "bc", "def", "ghij" and "klmnopqrs" to |h[1]|.
+  const char* const kMessages[] = {"a", "bc", "def", "ghij", "klmnopqrs"};
+  for (const char* message : kMessages) {
+    EXPECT_EQ(MOJO_RESULT_OK,
+              core()->WriteMessage(h[1], UserPointer<const void>(message),
+                                   static_cast<uint32_t>(strlen(message)),
+                                   NullUserPointer(), 0,
+                                   MOJO_WRITE_MESSAGE_FLAG_NONE));
+  }
+
+  // Read at most 3 messages.
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  num_messages = 3;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 NullUserPointer(), NullUserPointer(),
+                                 MakeUserPointer(message_sizes),
+                                 MakeUserPointer(message_num_handles),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(3u, num_messages);
+  EXPECT_EQ(6u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "abcdef", 6));
+  EXPECT_EQ(1u, message_sizes[0]);
+  EXPECT_EQ(2u, message_sizes[1]);
+  EXPECT_EQ(3u, message_sizes[2]);
+  EXPECT_EQ(0u, message_num_handles[0]);
+  EXPECT_EQ(0u, message_num_handles[1]);
+  EXPECT_EQ(0u, message_num_handles[2]);
+
+  // Read only as many messages as will fit: "ghij", but not "klmnopqrs".
+  buffer_size = 12;
+  num_messages = 3;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 NullUserPointer(), NullUserPointer(),
+                                 MakeUserPointer(message_sizes),
+                                 NullUserPointer(),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1u, num_messages);
+  EXPECT_EQ(4u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "ghij", 4));
+  EXPECT_EQ(4u, message_sizes[0]);
+
+  // The next message doesn't fit at all.
+  buffer_size = 5;
+  num_messages = 3;
+  EXPECT_EQ(MOJO_RESULT_RESOURCE_EXHAUSTED,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 NullUserPointer(), NullUserPointer(),
+                                 MakeUserPointer(message_sizes),
+                                 NullUserPointer(),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(0u, num_messages);
+  EXPECT_EQ(9u, buffer_size);
+
+  // Read it, then close |h[1]|.
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  num_messages = 3;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 NullUserPointer(), NullUserPointer(),
+                                 MakeUserPointer(message_sizes),
+                                 NullUserPointer(),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1u, num_messages);
+  EXPECT_EQ(9u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "klmnopqrs", 9));
+  EXPECT_EQ(9u, message_sizes[0]);
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  num_messages = 3;
+  EXPECT_EQ(MOJO_RESULT_FAILED_PRECONDITION,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 NullUserPointer(), NullUserPointer(),
+                                 MakeUserPointer(message_sizes),
+                                 NullUserPointer(),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+}
+
+TEST_F(CoreTest, ReadMessagesWithHandles) {
+  MojoHandle h[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+  MojoHandle h_passed[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(),
+                                      MakeUserPointer(&h_passed[0]),
+                                      MakeUserPointer(&h_passed[1])));
+
+  // Write "a" (with |h_passed[0]|), "b", and "c" (with |h_passed[1]|).
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessage(h[1], UserPointer<const void>("a"), 1,
+                                 MakeUserPointer(&h_passed[0]), 1,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessage(h[1], UserPointer<const void>("b"), 1,
+                                 NullUserPointer(), 0,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessage(h[1], UserPointer<const void>("c"), 1,
+                                 MakeUserPointer(&h_passed[1]), 1,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+
+  char buffer[10];
+  uint32_t buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  MojoHandle handles[2] = {MOJO_HANDLE_INVALID, MOJO_HANDLE_INVALID};
+  uint32_t num_handles = 1;
+  uint32_t message_sizes[3];
+  uint32_t message_num_handles[3];
+  uint32_t num_messages = 3;
+
+  // Only one handle fits, so "c" isn't read.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 MakeUserPointer(handles),
+                                 MakeUserPointer(&num_handles),
+                                 MakeUserPointer(message_sizes),
+                                 MakeUserPointer(message_num_handles),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(2u, num_messages);
+  EXPECT_EQ(2u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "ab", 2));
+  EXPECT_EQ(1u, num_handles);
+  EXPECT_NE(MOJO_HANDLE_INVALID, handles[0]);
+  EXPECT_EQ(1u, message_num_handles[0]);
+  EXPECT_EQ(0u, message_num_handles[1]);
+
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  num_handles = 1;
+  num_messages = 3;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 MakeUserPointer(&handles[1]),
+                                 MakeUserPointer(&num_handles),
+                                 MakeUserPointer(message_sizes),
+                                 MakeUserPointer(message_num_handles),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1u, num_messages);
+  EXPECT_EQ(1u, buffer_size);
+  EXPECT_EQ('c', buffer[0]);
+  EXPECT_EQ(1u, num_handles);
+  EXPECT_NE(MOJO_HANDLE_INVALID, handles[1]);
+  EXPECT_EQ(1u, message_num_handles[0]);
+
+  // The received handles should be the two ends of a message pipe.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessage(handles[0], UserPointer<const void>("d"), 1,
+                                 NullUserPointer(), 0,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessage(handles[1], UserPointer<void>(buffer),
+                                MakeUserPointer(&buffer_size),
+                                NullUserPointer(), NullUserPointer(),
+                                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1u, buffer_size);
+  EXPECT_EQ('d', buffer[0]);
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(handles[0]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(handles[1]));
+}
+
+TEST_F(CoreTest, WriteMessages) {
+  MojoHandle h[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+
+  // Write "a", "bc" and "def" (with nothing else) to |h[1]|.
+  const uint32_t kMessageSizes[] = {1, 2, 3};
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessages(h[1], UserPointer<const void>("abcdef"), 6,
+                                  NullUserPointer(), 0,
+                                  MakeUserPointer(kMessageSizes),
+                                  NullUserPointer(), 3,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+
+  // Invalid arguments: no messages, and sizes that don't add up.
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->WriteMessages(h[1], UserPointer<const void>("abcdef"), 6,
+                                  NullUserPointer(), 0,
+                                  MakeUserPointer(kMessageSizes),
+                                  NullUserPointer(), 0,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->WriteMessages(h[1], UserPointer<const void>("abcdef"), 5,
+                                  NullUserPointer(), 0,
+                                  MakeUserPointer(kMessageSizes),
+                                  NullUserPointer(), 3,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+  const uint32_t kMessageNumHandles[] = {0, 1, 0};
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->WriteMessages(h[1], UserPointer<const void>("abcdef"), 6,
+                                  NullUserPointer(), 0,
+                                  MakeUserPointer(kMessageSizes),
+                                  MakeUserPointer(kMessageNumHandles), 3,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+
+  // Too many messages, or a message that's too big or has too many handles
+  // (even if the total is small enough for a single message).
+  EXPECT_EQ(MOJO_RESULT_RESOURCE_EXHAUSTED,
+            core()->WriteMessages(
+                h[1], NullUserPointer(), 0, NullUserPointer(), 0,
+                NullUserPointer(), NullUserPointer(),
+                static_cast<uint32_t>(
+                    GetConfiguration().max_write_messages_num_messages + 1),
+                MOJO_WRITE_MESSAGE_FLAG_NONE));
+  const uint32_t kTooBigMessageSizes[] = {
+      0, static_cast<uint32_t>(GetConfiguration().max_message_num_bytes + 1)};
+  EXPECT_EQ(MOJO_RESULT_RESOURCE_EXHAUSTED,
+            core()->WriteMessages(h[1], NullUserPointer(),
+                                  kTooBigMessageSizes[1], NullUserPointer(), 0,
+                                  MakeUserPointer(kTooBigMessageSizes),
+                                  NullUserPointer(), 2,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+  const uint32_t kTooManyMessageNumHandles[] = {
+      static_cast<uint32_t>(GetConfiguration().max_message_num_handles + 1), 0,
+      0};
+  EXPECT_EQ(MOJO_RESULT_RESOURCE_EXHAUSTED,
+            core()->WriteMessages(h[1], UserPointer<const void>("abcdef"), 6,
+                                  NullUserPointer(),
+                                  kTooManyMessageNumHandles[0],
+                                  MakeUserPointer(kMessageSizes),
+                                  MakeUserPointer(kTooManyMessageNumHandles), 3,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+
+  // Only the valid write's messages should be there.
+  char buffer[10];
+  uint32_t buffer_size;
+  for (uint32_t i = 0; i < 3; i++) {
+    buffer_size = static_cast<uint32_t>(sizeof(buffer));
+    EXPECT_EQ(MOJO_RESULT_OK,
+              core()->ReadMessage(h[0], UserPointer<void>(buffer),
+                                  MakeUserPointer(&buffer_size),
+                                  NullUserPointer(), NullUserPointer(),
+                                  MOJO_READ_MESSAGE_FLAG_NONE));
+    EXPECT_EQ(kMessageSizes[i], buffer_size);
+    EXPECT_EQ(0, memcmp(buffer, &"abcdef"[i * (i + 1) / 2], buffer_size));
+  }
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->ReadMessage(h[0], UserPointer<void>(buffer),
+                                MakeUserPointer(&buffer_size),
+                                NullUserPointer(), NullUserPointer(),
+                                MOJO_READ_MESSAGE_FLAG_NONE));
+
+  // Can't write to a pipe whose other end has been closed.
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+  EXPECT_EQ(MOJO_RESULT_FAILED_PRECONDITION,
+            core()->WriteMessages(h[1], UserPointer<const void>("abcdef"), 6,
+                                  NullUserPointer(), 0,
+                                  MakeUserPointer(kMessageSizes),
+                                  NullUserPointer(), 3,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+}
+
+TEST_F(CoreTest, WriteMessagesWithHandles) {
+  MojoHandle h[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+  MojoHandle h_passed[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(),
+                                      MakeUserPointer(&h_passed[0]),
+                                      MakeUserPointer(&h_passed[1])));
+
+  const uint32_t kMessageSizes[] = {1, 1, 1};
+  const uint32_t kMessageNumHandles[] = {1, 0, 1};
+
+  // Can't send the pipe's own handle, or the same handle twice. Nothing should
+  // be written (or closed) in either case.
+  MojoHandle bad_handles[2] = {h_passed[0], h[1]};
+  EXPECT_EQ(MOJO_RESULT_BUSY,
+            core()->WriteMessages(h[1], UserPointer<const void>("abc"), 3,
+                                  MakeUserPointer(bad_handles), 2,
+                                  MakeUserPointer(kMessageSizes),
+                                  MakeUserPointer(kMessageNumHandles), 3,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+  bad_handles[1] = h_passed[0];
+  EXPECT_EQ(MOJO_RESULT_BUSY,
+            core()->WriteMessages(h[1], UserPointer<const void>("abc"), 3,
+                                  MakeUserPointer(bad_handles), 2,
+                                  MakeUserPointer(kMessageSizes),
+                                  MakeUserPointer(kMessageNumHandles), 3,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+
+  // Write "a" (with |h_passed[0]|), "b", and "c" (with |h_passed[1]|).
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessages(h[1], UserPointer<const void>("abc"), 3,
+                                  MakeUserPointer(h_passed), 2,
+                                  MakeUserPointer(kMessageSizes),
+                                  MakeUserPointer(kMessageNumHandles), 3,
+                                  MOJO_WRITE_MESSAGE_FLAG_NONE));
+  // The handles should no longer be valid.
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT, core()->Close(h_passed[0]));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT, core()->Close(h_passed[1]));
+
+  char buffer[10];
+  uint32_t buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  MojoHandle handles[2] = {MOJO_HANDLE_INVALID, MOJO_HANDLE_INVALID};
+  uint32_t num_handles = 2;
+  uint32_t message_sizes[3];
+  uint32_t message_num_handles[3];
+  uint32_t num_messages = 3;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessages(h[0], UserPointer<void>(buffer),
+                                 MakeUserPointer(&buffer_size),
+                                 MakeUserPointer(handles),
+                                 MakeUserPointer(&num_handles),
+                                 MakeUserPointer(message_sizes),
+                                 MakeUserPointer(message_num_handles),
+                                 MakeUserPointer(&num_messages),
+                                 MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(3u, num_messages);
+  EXPECT_EQ(3u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "abc", 3));
+  EXPECT_EQ(2u, num_handles);
+  EXPECT_EQ(1u, message_num_handles[0]);
+  EXPECT_EQ(0u, message_num_handles[1]);
+  EXPECT_EQ(1u, message_num_handles[2]);
+
+  // The received handles should be the two ends of a message pipe.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessage(handles[0], UserPointer<const void>("d"), 1,
+                                 NullUserPointer(), 0,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessage(handles[1], UserPointer<void>(buffer),
+                                MakeUserPointer(&buffer_size),
+                                NullUserPointer(), NullUserPointer(),
+                                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1u, buffer_size);
+  EXPECT_EQ('d', buffer[0]);
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(handles[0]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(handles[1]));
+}
+
+// A message context for testing |WriteMessageContext()| and
+// |ReadMessageContext()|, which counts the number of contexts destroyed.
+struct TestMessageContext {
+  explicit TestMessageContext(const std::string& data) : data(data) {}
+
+  std::string data;
+
+  static int num_destroyed;
+};
+
+int TestMessageContext::num_destroyed = 0;
+
+uint32_t TestMessageContextGetSerializedSize(uintptr_t context) {
+  return static_cast<uint32_t>(
+      reinterpret_cast<TestMessageContext*>(context)->data.size());
+}
+
+void TestMessageContextSerialize(uintptr_t context,
+                                 void* bytes,
+                                 uint32_t num_bytes) {
+  const std::string& data =
+      reinterpret_cast<TestMessageContext*>(context)->data;
+  CHECK_EQ(data.size(), num_bytes);
+  memcpy(bytes, data.data(), num_bytes);
+}
+
+void TestMessageContextDestroy(uintptr_t context) {
+  delete reinterpret_cast<TestMessageContext*>(context);
+  TestMessageContext::num_destroyed++;
+}
+
+const MojoMessageContextThunks kTestMessageContextThunks = {
+    static_cast<uint32_t>(sizeof(MojoMessageContextThunks)),
+    &TestMessageContextGetSerializedSize, &TestMessageContextSerialize,
+    &TestMessageContextDestroy};
+
+uintptr_t MakeTestMessageContext(const std::string& data) {
+  return reinterpret_cast<uintptr_t>(new TestMessageContext(data));
+}
+
+TEST_F(CoreTest, MessageContext) {
+  TestMessageContext::num_destroyed = 0;
+
+  MojoHandle h[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+
+  // Invalid arguments.
+  MojoMessageContextThunks bad_thunks = kTestMessageContextThunks;
+  bad_thunks.struct_size = 0;
+  uintptr_t context = 0;
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->WriteMessageContext(h[1], 1, nullptr,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->WriteMessageContext(h[1], 1, &bad_thunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->ReadMessageContext(
+                h[0], &bad_thunks, MakeUserPointer(&context), NullUserPointer(),
+                NullUserPointer(), NullUserPointer(), NullUserPointer(),
+                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->ReadMessageContext(
+                h[0], &kTestMessageContextThunks, NullUserPointer(),
+                NullUserPointer(), NullUserPointer(), NullUserPointer(),
+                NullUserPointer(), MOJO_READ_MESSAGE_FLAG_NONE));
+
+  // Nothing has read |h[0]| using |ReadMessageContext()| yet, so this should
+  // be serialized (and destroyed) immediately.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessageContext(h[1], MakeTestMessageContext("abc"),
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1, TestMessageContext::num_destroyed);
+
+  char buffer[10];
+  uint32_t buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  context = 123;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessageContext(
+                h[0], &kTestMessageContextThunks, MakeUserPointer(&context),
+                UserPointer<void>(buffer), MakeUserPointer(&buffer_size),
+                NullUserPointer(), NullUserPointer(),
+                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(0u, context);
+  EXPECT_EQ(3u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "abc", 3));
+
+  // Now that it has, the context should be passed through.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessageContext(h[1], MakeTestMessageContext("de"),
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1, TestMessageContext::num_destroyed);
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessageContext(
+                h[0], &kTestMessageContextThunks, MakeUserPointer(&context),
+                UserPointer<void>(buffer), MakeUserPointer(&buffer_size),
+                NullUserPointer(), NullUserPointer(),
+                MOJO_READ_MESSAGE_FLAG_NONE));
+  ASSERT_NE(0u, context);
+  EXPECT_EQ(0u, buffer_size);
+  EXPECT_EQ("de", reinterpret_cast<TestMessageContext*>(context)->data);
+  TestMessageContextDestroy(context);
+  EXPECT_EQ(2, TestMessageContext::num_destroyed);
+
+  // Messages written normally should be read normally.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessage(h[1], UserPointer<const void>("f"), 1,
+                                 NullUserPointer(), 0,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  context = 123;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessageContext(
+                h[0], &kTestMessageContextThunks, MakeUserPointer(&context),
+                UserPointer<void>(buffer), MakeUserPointer(&buffer_size),
+                NullUserPointer(), NullUserPointer(),
+                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(0u, context);
+  EXPECT_EQ(1u, buffer_size);
+  EXPECT_EQ('f', buffer[0]);
+
+  // A context should be serialized if it's read using |ReadMessage()|, or
+  // using other thunks.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessageContext(h[1], MakeTestMessageContext("gh"),
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(2, TestMessageContext::num_destroyed);
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessage(h[0], UserPointer<void>(buffer),
+                                MakeUserPointer(&buffer_size),
+                                NullUserPointer(), NullUserPointer(),
+                                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(3, TestMessageContext::num_destroyed);
+  EXPECT_EQ(2u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "gh", 2));
+  // (Reading using |ReadMessage()| stopped contexts from being passed through,
+  // so read using |kTestMessageContextThunks| again first.)
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->ReadMessageContext(
+                h[0], &kTestMessageContextThunks, MakeUserPointer(&context),
+                NullUserPointer(), NullUserPointer(), NullUserPointer(),
+                NullUserPointer(), MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessageContext(h[1], MakeTestMessageContext("ij"),
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(3, TestMessageContext::num_destroyed);
+  MojoMessageContextThunks other_thunks = kTestMessageContextThunks;
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  context = 123;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessageContext(
+                h[0], &other_thunks, MakeUserPointer(&context),
+                UserPointer<void>(buffer), MakeUserPointer(&buffer_size),
+                NullUserPointer(), NullUserPointer(),
+                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(4, TestMessageContext::num_destroyed);
+  EXPECT_EQ(0u, context);
+  EXPECT_EQ(2u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "ij", 2));
+
+  // Unread contexts should be destroyed when the reader is closed. (Reading
+  // using |other_thunks| stopped contexts from being passed through, so read
+  // using |kTestMessageContextThunks| again first.)
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->ReadMessageContext(
+                h[0], &kTestMessageContextThunks, MakeUserPointer(&context),
+                NullUserPointer(), NullUserPointer(), NullUserPointer(),
+                NullUserPointer(), MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessageContext(h[1], MakeTestMessageContext("kl"),
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(4, TestMessageContext::num_destroyed);
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+  EXPECT_EQ(5, TestMessageContext::num_destroyed);
+
+  // The writer still owns the context if the write fails.
+  uintptr_t unwritten_context = MakeTestMessageContext("mn");
+  EXPECT_EQ(MOJO_RESULT_FAILED_PRECONDITION,
+            core()->WriteMessageContext(h[1], unwritten_context,
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(5, TestMessageContext::num_destroyed);
+  TestMessageContextDestroy(unwritten_context);
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+}
+
+// Tests that a context whose serialized message would be too large is rejected
+// when it's written, whether or not it would be serialized.
+TEST_F(CoreTest, MessageContextTooLarge) {
+  TestMessageContext::num_destroyed = 0;
+
+  MojoHandle h[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+  const std::string too_large(GetConfiguration().max_message_num_bytes + 1,
+                              'x');
+
+  // |h[0]| isn't being read using |ReadMessageContext()|, so the message would
+  // be serialized right away.
+  uintptr_t context = MakeTestMessageContext(too_large);
+  EXPECT_EQ(MOJO_RESULT_RESOURCE_EXHAUSTED,
+            core()->WriteMessageContext(h[1], context,
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(0, TestMessageContext::num_destroyed);
+  TestMessageContextDestroy(context);
+
+  // Now it is, so the context would be passed through.
+  uintptr_t read_context = 123;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->ReadMessageContext(
+                h[0], &kTestMessageContextThunks, MakeUserPointer(&read_context),
+                NullUserPointer(), NullUserPointer(), NullUserPointer(),
+                NullUserPointer(), MOJO_READ_MESSAGE_FLAG_NONE));
+  context = MakeTestMessageContext(too_large);
+  EXPECT_EQ(MOJO_RESULT_RESOURCE_EXHAUSTED,
+            core()->WriteMessageContext(h[1], context,
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1, TestMessageContext::num_destroyed);
+  TestMessageContextDestroy(context);
+
+  // Nothing was enqueued.
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->ReadMessage(h[0], NullUserPointer(), NullUserPointer(),
+                                NullUserPointer(), NullUserPointer(),
+                                MOJO_READ_MESSAGE_FLAG_NONE));
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+  EXPECT_EQ(2, TestMessageContext::num_destroyed);
+}
+
+// Tests that contexts that are queued when a message pipe handle is transferred
+// are serialized.
+TEST_F(CoreTest, MessageContextTransfer) {
+  TestMessageContext::num_destroyed = 0;
+
+  MojoHandle h[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+  MojoHandle h_passed[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(),
+                                      MakeUserPointer(&h_passed[0]),
+                                      MakeUserPointer(&h_passed[1])));
+
+  uintptr_t context = 123;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->ReadMessageContext(
+                h_passed[0], &kTestMessageContextThunks,
+                MakeUserPointer(&context), NullUserPointer(), NullUserPointer(),
+                NullUserPointer(), NullUserPointer(),
+                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessageContext(h_passed[1],
+                                        MakeTestMessageContext("abc"),
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(0, TestMessageContext::num_destroyed);
+
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessage(h[1], UserPointer<const void>("x"), 1,
+                                 MakeUserPointer(&h_passed[0]), 1,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1, TestMessageContext::num_destroyed);
+
+  char buffer[10];
+  uint32_t buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  MojoHandle h_received = MOJO_HANDLE_INVALID;
+  uint32_t num_handles = 1;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessage(
+                h[0], UserPointer<void>(buffer), MakeUserPointer(&buffer_size),
+                MakeUserPointer(&h_received), MakeUserPointer(&num_handles),
+                MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(1u, num_handles);
+
+  // The transferred endpoint must be read with |ReadMessageContext()| again
+  // before contexts are passed through to it.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessageContext(h_passed[1],
+                                        MakeTestMessageContext("de"),
+                                        &kTestMessageContextThunks,
+                                        MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(2, TestMessageContext::num_destroyed);
+
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessageContext(
+                h_received, &kTestMessageContextThunks,
+                MakeUserPointer(&context), UserPointer<void>(buffer),
+                MakeUserPointer(&buffer_size), NullUserPointer(),
+                NullUserPointer(), MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(0u, context);
+  EXPECT_EQ(3u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "abc", 3));
+  buffer_size = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->ReadMessageContext(
+                h_received, &kTestMessageContextThunks,
+                MakeUserPointer(&context), UserPointer<void>(buffer),
+                MakeUserPointer(&buffer_size), NullUserPointer(),
+                NullUserPointer(), MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(0u, context);
+  EXPECT_EQ(2u, buffer_size);
+  EXPECT_EQ(0, memcmp(buffer, "de", 2));
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h_passed[1]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h_received));
+  EXPECT_EQ(2, TestMessageContext::num_destroyed);
+}
+
 // Tests passing a message pipe handle.
 TEST_F(CoreTest, MessagePipeBasicLocalHandlePassing1) {
   const char kHello[] = "hello";
@@ -865,14 +1599,18 @@ TEST_F(CoreTest, DataPipe) {
   EXPECT_EQ(
       MOJO_RESULT_FAILED_PRECONDITION,
       core()->Wait(ph, MOJO_HANDLE_SIGNAL_READABLE, 0, MakeUserPointer(&hss)));
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_WRITABLE, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD,
+            hss.satisfied_signals);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD,
             hss.satisfiable_signals);
   hss = kEmptyMojoHandleSignalsState;
   EXPECT_EQ(MOJO_RESULT_OK, core()->Wait(ph, MOJO_HANDLE_SIGNAL_WRITABLE, 0,
                                          MakeUserPointer(&hss)));
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_WRITABLE, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD,
+            hss.satisfied_signals);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD,
             hss.satisfiable_signals);
 
   // Consumer should be never-writable, and not yet readable.
@@ -881,14 +1619,16 @@ TEST_F(CoreTest, DataPipe) {
       MOJO_RESULT_FAILED_PRECONDITION,
       core()->Wait(ch, MOJO_HANDLE_SIGNAL_WRITABLE, 0, MakeUserPointer(&hss)));
   EXPECT_EQ(0u, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
             hss.satisfiable_signals);
   hss = kFullMojoHandleSignalsState;
   EXPECT_EQ(
       MOJO_RESULT_DEADLINE_EXCEEDED,
       core()->Wait(ch, MOJO_HANDLE_SIGNAL_READABLE, 0, MakeUserPointer(&hss)));
   EXPECT_EQ(0u, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
             hss.satisfiable_signals);
 
   // Write.
@@ -904,8 +1644,10 @@ TEST_F(CoreTest, DataPipe) {
   hss = kEmptyMojoHandleSignalsState;
   EXPECT_EQ(MOJO_RESULT_OK, core()->Wait(ch, MOJO_HANDLE_SIGNAL_READABLE, 0,
                                          MakeUserPointer(&hss)));
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
+            hss.satisfied_signals);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
             hss.satisfiable_signals);
 
   // Peek one character.
@@ -1023,7 +1765,8 @@ TEST_F(CoreTest, DataPipe) {
       MOJO_RESULT_DEADLINE_EXCEEDED,
       core()->Wait(ch, MOJO_HANDLE_SIGNAL_READABLE, 0, MakeUserPointer(&hss)));
   EXPECT_EQ(0u, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
             hss.satisfiable_signals);
 
   // TODO(vtl): More.
@@ -1043,6 +1786,125 @@ TEST_F(CoreTest, DataPipe) {
 }
 
 // Tests passing data pipe producer and consumer handles.
+TEST_F(CoreTest, DataPipeOptions) {
+  const MojoCreateDataPipeOptions options = {
+      static_cast<uint32_t>(sizeof(MojoCreateDataPipeOptions)),
+      MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,
+      2u,    // |element_num_bytes|.
+      100u,  // |capacity_num_bytes|.
+      4u,    // |read_threshold_num_bytes|.
+      0u     // |write_threshold_num_bytes|.
+  };
+  MojoHandle ph, ch;  // p is for producer and c is for consumer.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateDataPipe(MakeUserPointer(&options),
+                                   MakeUserPointer(&ph), MakeUserPointer(&ch)));
+
+  MojoDataPipeProducerOptions producer_options = {};
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->GetDataPipeProducerOptions(
+                ph, MakeUserPointer(&producer_options),
+                static_cast<uint32_t>(sizeof(producer_options))));
+  EXPECT_EQ(static_cast<uint32_t>(sizeof(producer_options)),
+            producer_options.struct_size);
+  EXPECT_EQ(0u, producer_options.write_threshold_num_bytes);
+  MojoDataPipeConsumerOptions consumer_options = {};
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->GetDataPipeConsumerOptions(
+                ch, MakeUserPointer(&consumer_options),
+                static_cast<uint32_t>(sizeof(consumer_options))));
+  EXPECT_EQ(static_cast<uint32_t>(sizeof(consumer_options)),
+            consumer_options.struct_size);
+  EXPECT_EQ(4u, consumer_options.read_threshold_num_bytes);
+
+  // Invalid handles, and handles of the wrong type.
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->SetDataPipeProducerOptions(MOJO_HANDLE_INVALID,
+                                               NullUserPointer()));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->SetDataPipeProducerOptions(ch, NullUserPointer()));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->GetDataPipeProducerOptions(
+                ch, MakeUserPointer(&producer_options),
+                static_cast<uint32_t>(sizeof(producer_options))));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->SetDataPipeConsumerOptions(MOJO_HANDLE_INVALID,
+                                               NullUserPointer()));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->SetDataPipeConsumerOptions(ph, NullUserPointer()));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->GetDataPipeConsumerOptions(
+                ph, MakeUserPointer(&consumer_options),
+                static_cast<uint32_t>(sizeof(consumer_options))));
+
+  // Too small a buffer for the options.
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->GetDataPipeConsumerOptions(
+                ch, MakeUserPointer(&consumer_options), 4u));
+
+  // Invalid thresholds.
+  producer_options.write_threshold_num_bytes = 3u;
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->SetDataPipeProducerOptions(
+                ph, MakeUserPointer(&producer_options)));
+  consumer_options.read_threshold_num_bytes = 102u;
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->SetDataPipeConsumerOptions(
+                ch, MakeUserPointer(&consumer_options)));
+
+  producer_options.write_threshold_num_bytes = 10u;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->SetDataPipeProducerOptions(
+                ph, MakeUserPointer(&producer_options)));
+  producer_options = MojoDataPipeProducerOptions();
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->GetDataPipeProducerOptions(
+                ph, MakeUserPointer(&producer_options),
+                static_cast<uint32_t>(sizeof(producer_options))));
+  EXPECT_EQ(10u, producer_options.write_threshold_num_bytes);
+
+  // Null options reset to the default.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->SetDataPipeConsumerOptions(ch, NullUserPointer()));
+  consumer_options = MojoDataPipeConsumerOptions();
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->GetDataPipeConsumerOptions(
+                ch, MakeUserPointer(&consumer_options),
+                static_cast<uint32_t>(sizeof(consumer_options))));
+  EXPECT_EQ(0u, consumer_options.read_threshold_num_bytes);
+
+  // With a read threshold of two elements, one element isn't enough.
+  consumer_options.read_threshold_num_bytes = 4u;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->SetDataPipeConsumerOptions(
+                ch, MakeUserPointer(&consumer_options)));
+  const char kData[] = "abcd";
+  uint32_t num_bytes = 2u;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteData(ph, UserPointer<const void>(kData),
+                              MakeUserPointer(&num_bytes),
+                              MOJO_WRITE_DATA_FLAG_NONE));
+  MojoHandleSignalsState hss = kFullMojoHandleSignalsState;
+  EXPECT_EQ(MOJO_RESULT_DEADLINE_EXCEEDED,
+            core()->Wait(ch, MOJO_HANDLE_SIGNAL_READ_THRESHOLD, 0,
+                         MakeUserPointer(&hss)));
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE, hss.satisfied_signals);
+  num_bytes = 2u;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteData(ph, UserPointer<const void>(kData + 2),
+                              MakeUserPointer(&num_bytes),
+                              MOJO_WRITE_DATA_FLAG_NONE));
+  hss = kEmptyMojoHandleSignalsState;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->Wait(ch, MOJO_HANDLE_SIGNAL_READ_THRESHOLD, 0,
+                         MakeUserPointer(&hss)));
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
+            hss.satisfied_signals);
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(ph));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(ch));
+}
+
 TEST_F(CoreTest, MessagePipeBasicLocalHandlePassing2) {
   const char kHello[] = "hello";
   const uint32_t kHelloSize = static_cast<uint32_t>(sizeof(kHello));
@@ -1111,8 +1973,10 @@ TEST_F(CoreTest, MessagePipeBasicLocalHandlePassing2) {
   EXPECT_EQ(MOJO_RESULT_OK,
             core()->Wait(ch_received, MOJO_HANDLE_SIGNAL_READABLE, 1000000000,
                          MakeUserPointer(&hss)));
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
+            hss.satisfied_signals);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
             hss.satisfiable_signals);
   num_bytes = kBufferSize;
   EXPECT_EQ(MOJO_RESULT_OK,
@@ -1167,8 +2031,10 @@ TEST_F(CoreTest, MessagePipeBasicLocalHandlePassing2) {
   EXPECT_EQ(MOJO_RESULT_OK,
             core()->Wait(ch_received, MOJO_HANDLE_SIGNAL_READABLE, 1000000000,
                          MakeUserPointer(&hss)));
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
+            hss.satisfied_signals);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
             hss.satisfiable_signals);
   num_bytes = kBufferSize;
   EXPECT_EQ(MOJO_RESULT_OK,
@@ -1226,8 +2092,10 @@ TEST_F(CoreTest, MessagePipeBasicLocalHandlePassing2) {
   hss = kEmptyMojoHandleSignalsState;
   EXPECT_EQ(MOJO_RESULT_OK, core()->Wait(ch, MOJO_HANDLE_SIGNAL_READABLE,
                                          1000000000, MakeUserPointer(&hss)));
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE, hss.satisfied_signals);
-  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
+            hss.satisfied_signals);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED |
+                MOJO_HANDLE_SIGNAL_READ_THRESHOLD,
             hss.satisfiable_signals);
 
   // Make sure that |ch| can't be sent if it's in a two-phase read.
@@ -1310,6 +2178,184 @@ TEST_F(CoreTest, AsyncWait) {
   EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h));
 }
 
+// Repeatedly creates message pipes, sends one end of a pipe over another pipe,
+// and closes everything, checking that every handle it gets is valid.
+class HandleChurnThread : public base::SimpleThread {
+ public:
+  HandleChurnThread(Core* core, size_t num_iterations)
+      : base::SimpleThread("handle_churn_thread"),
+        core_(core),
+        num_iterations_(num_iterations) {}
+  ~HandleChurnThread() override { Join(); }
+
+ private:
+  void Run() override {
+    for (size_t i = 0; i < num_iterations_; i++) {
+      MojoHandle h[2] = {MOJO_HANDLE_INVALID, MOJO_HANDLE_INVALID};
+      MojoHandle t[2] = {MOJO_HANDLE_INVALID, MOJO_HANDLE_INVALID};
+      CHECK_EQ(core_->CreateMessagePipe(NullUserPointer(),
+                                        MakeUserPointer(&h[0]),
+                                        MakeUserPointer(&h[1])),
+               MOJO_RESULT_OK);
+      CHECK_EQ(core_->CreateMessagePipe(NullUserPointer(),
+                                        MakeUserPointer(&t[0]),
+                                        MakeUserPointer(&t[1])),
+               MOJO_RESULT_OK);
+
+      // Sending a handle to its own pipe (or twice) is not allowed.
+      MojoHandle bad_handles[2] = {t[0], t[0]};
+      CHECK_EQ(core_->WriteMessage(h[0], UserPointer<const void>("x"), 1,
+                                   MakeUserPointer(bad_handles), 2,
+                                   MOJO_WRITE_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_BUSY);
+      CHECK_EQ(core_->WriteMessage(h[0], UserPointer<const void>("x"), 1,
+                                   MakeUserPointer(&h[0]), 1,
+                                   MOJO_WRITE_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_BUSY);
+
+      CHECK_EQ(core_->WriteMessage(h[0], UserPointer<const void>("x"), 1,
+                                   MakeUserPointer(&t[0]), 1,
+                                   MOJO_WRITE_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_OK);
+      // |t[0]| was transferred, so it's no longer valid.
+      CHECK_EQ(core_->Close(t[0]), MOJO_RESULT_INVALID_ARGUMENT);
+
+      char buffer[10];
+      uint32_t num_bytes = static_cast<uint32_t>(sizeof(buffer));
+      MojoHandle received = MOJO_HANDLE_INVALID;
+      uint32_t num_handles = 1;
+      CHECK_EQ(core_->ReadMessage(
+                   h[1], UserPointer<void>(buffer), MakeUserPointer(&num_bytes),
+                   MakeUserPointer(&received), MakeUserPointer(&num_handles),
+                   MOJO_READ_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_OK);
+      CHECK_EQ(num_bytes, 1u);
+      CHECK_EQ(num_handles, 1u);
+      CHECK_NE(received, MOJO_HANDLE_INVALID);
+
+      CHECK_EQ(core_->Close(received), MOJO_RESULT_OK);
+      CHECK_EQ(core_->Close(t[1]), MOJO_RESULT_OK);
+      CHECK_EQ(core_->Close(h[0]), MOJO_RESULT_OK);
+      CHECK_EQ(core_->Close(h[1]), MOJO_RESULT_OK);
+    }
+  }
+
+  Core* const core_;
+  const size_t num_iterations_;
+
+  DISALLOW_COPY_AND_ASSIGN(HandleChurnThread);
+};
+
+TEST_F(CoreTest, ConcurrentHandleTableAccess) {
+  const size_t kNumThreads = 8;
+  const size_t kNumIterations = 500;
+
+  {
+    ScopedVector<HandleChurnThread> threads;
+    for (size_t i = 0; i < kNumThreads; i++)
+      threads.push_back(new HandleChurnThread(core(), kNumIterations));
+    for (size_t i = 0; i < kNumThreads; i++)
+      threads[i]->Start();
+  }  // Joins all the threads.
+
+  // Handles that were never valid (or are no longer valid) are still rejected.
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT, core()->Close(1));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->Close(static_cast<MojoHandle>(-1)));
+}
+
+TEST_F(CoreTest, WaitSet) {
+  MojoHandle ws;
+  ASSERT_EQ(MOJO_RESULT_OK, core()->CreateWaitSet(MakeUserPointer(&ws)));
+  MojoHandle h[2];
+  ASSERT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->AddHandle(MOJO_HANDLE_INVALID, h[0],
+                              MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->AddHandle(ws, MOJO_HANDLE_INVALID,
+                              MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->AddHandle(ws, ws, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->AddHandle(h[0], h[1], MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->AddHandle(ws, h[0], MOJO_HANDLE_SIGNAL_READABLE));
+
+  uint32_t count = 0;
+  MojoHandle handles[2] = {MOJO_HANDLE_INVALID, MOJO_HANDLE_INVALID};
+  MojoResult results[2] = {MOJO_RESULT_UNKNOWN, MOJO_RESULT_UNKNOWN};
+  MojoHandleSignalsState signals_states[2] = {kFullMojoHandleSignalsState,
+                                              kFullMojoHandleSignalsState};
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->GetReadyHandles(ws, MakeUserPointer(&count),
+                                    MakeUserPointer(handles),
+                                    MakeUserPointer(results), NullUserPointer()));
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->GetReadyHandles(ws, MakeUserPointer(&count),
+                                    MakeUserPointer(handles),
+                                    MakeUserPointer(results), NullUserPointer()));
+  EXPECT_EQ(MOJO_RESULT_DEADLINE_EXCEEDED,
+            core()->Wait(ws, MOJO_HANDLE_SIGNAL_READABLE, 0, NullUserPointer()));
+
+  // Make |h[0]| readable; the wait set becomes readable, and reports |h[0]|.
+  const char kHello[] = "hello";
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteMessage(h[1], UserPointer<const void>(kHello),
+                                 sizeof(kHello), NullUserPointer(), 0,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->Wait(ws, MOJO_HANDLE_SIGNAL_READABLE, 1000000000,
+                         NullUserPointer()));
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->GetReadyHandles(ws, MakeUserPointer(&count),
+                                    MakeUserPointer(handles),
+                                    MakeUserPointer(results),
+                                    MakeUserPointer(signals_states)));
+  EXPECT_EQ(1u, count);
+  EXPECT_EQ(h[0], handles[0]);
+  EXPECT_EQ(MOJO_RESULT_OK, results[0]);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_WRITABLE,
+            signals_states[0].satisfied_signals);
+  EXPECT_EQ(kAllSignals, signals_states[0].satisfiable_signals);
+
+  // Wait sets can't be sent over message pipes.
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            core()->WriteMessage(h[1], UserPointer<const void>(kHello),
+                                 sizeof(kHello), MakeUserPointer(&ws), 1,
+                                 MOJO_WRITE_MESSAGE_FLAG_NONE));
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->RemoveHandle(ws, h[0]));
+  EXPECT_EQ(MOJO_RESULT_NOT_FOUND, core()->RemoveHandle(ws, h[0]));
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            core()->GetReadyHandles(ws, MakeUserPointer(&count),
+                                    MakeUserPointer(handles),
+                                    MakeUserPointer(results), NullUserPointer()));
+
+  // Closing a member reports it (once) as cancelled.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->AddHandle(ws, h[1], MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->GetReadyHandles(ws, MakeUserPointer(&count),
+                                    MakeUserPointer(handles),
+                                    MakeUserPointer(results), NullUserPointer()));
+  EXPECT_EQ(1u, count);
+  EXPECT_EQ(h[1], handles[0]);
+  EXPECT_EQ(MOJO_RESULT_CANCELLED, results[0]);
+  EXPECT_EQ(MOJO_RESULT_NOT_FOUND, core()->RemoveHandle(ws, h[1]));
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(ws));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+}
+
 // TODO(vtl): Test |DuplicateBufferHandle()| and |MapBuffer()|.
 
 }  // namespace
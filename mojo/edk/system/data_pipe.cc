@@ -11,6 +11,8 @@
 
 #include "base/logging.h"
 #include "base/memory/aligned_memory.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
+#include "mojo/edk/embedder/platform_support.h"
 #include "mojo/edk/system/awakable_list.h"
 #include "mojo/edk/system/channel.h"
 #include "mojo/edk/system/configuration.h"
@@ -25,6 +27,71 @@
 namespace mojo {
 namespace system {
 
+namespace {
+
+// Gets the shared ring (if any) for a serialized data pipe producer/consumer,
+// taking ownership of its platform handle. Returns false if the serialized
+// data is invalid (in which case |*shared_ring| is left alone).
+bool DeserializeSharedRing(
+    Channel* channel,
+    const MojoCreateDataPipeOptions& validated_options,
+    uint32_t platform_handle_index,
+    embedder::PlatformHandleVector* platform_handles,
+    scoped_refptr<embedder::PlatformSharedBuffer>* shared_ring) {
+  if (platform_handle_index == kNoSharedRingPlatformHandleIndex)
+    return true;
+
+  if (!platform_handles || platform_handle_index >= platform_handles->size()) {
+    LOG(ERROR) << "Invalid serialized data pipe (missing shared ring handle)";
+    return false;
+  }
+
+  // Starts off invalid, which is what we want.
+  embedder::PlatformHandle platform_handle;
+  // We take ownership of the handle, so we have to invalidate the one in
+  // |platform_handles|.
+  std::swap(platform_handle, (*platform_handles)[platform_handle_index]);
+
+  // Wrapping |platform_handle| in a |ScopedPlatformHandle| means that it'll be
+  // closed even if creation fails.
+  scoped_refptr<embedder::PlatformSharedBuffer> new_shared_ring(
+      channel->platform_support()->CreateSharedBufferFromHandle(
+          validated_options.capacity_num_bytes,
+          embedder::ScopedPlatformHandle(platform_handle)));
+  if (!new_shared_ring) {
+    LOG(ERROR) << "Invalid serialized data pipe (invalid shared ring)";
+    return false;
+  }
+
+  *shared_ring = new_shared_ring;
+  return true;
+}
+
+// Maps all of |shared_ring| (which may be null, in which case this does
+// nothing and succeeds). Returns false on failure.
+bool MapSharedRing(
+    embedder::PlatformSharedBuffer* shared_ring,
+    scoped_ptr<embedder::PlatformSharedBufferMapping>* shared_ring_mapping) {
+  if (!shared_ring)
+    return true;
+  *shared_ring_mapping = shared_ring->Map(0, shared_ring->GetNumBytes());
+  if (!*shared_ring_mapping) {
+    LOG(ERROR) << "Failed to map data pipe shared ring";
+    return false;
+  }
+  return true;
+}
+
+// Returns true if |threshold_num_bytes| is a valid read or write threshold for
+// a data pipe with the given (validated) options.
+bool IsValidThreshold(uint32_t threshold_num_bytes,
+                      const MojoCreateDataPipeOptions& validated_options) {
+  return threshold_num_bytes % validated_options.element_num_bytes == 0 &&
+         threshold_num_bytes <= validated_options.capacity_num_bytes;
+}
+
+}  // namespace
+
 // static
 MojoCreateDataPipeOptions DataPipe::GetDefaultCreateOptions() {
   MojoCreateDataPipeOptions result = {
@@ -32,7 +99,9 @@ MojoCreateDataPipeOptions DataPipe::GetDefaultCreateOptions() {
       MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,
       1u,
       static_cast<uint32_t>(
-          GetConfiguration().default_data_pipe_capacity_bytes)};
+          GetConfiguration().default_data_pipe_capacity_bytes),
+      0u,
+      0u};
   return result;
 }
 
@@ -78,14 +147,36 @@ MojoResult DataPipe::ValidateCreateOptions(
                                        (default_data_pipe_capacity_bytes %
                                         out_options->element_num_bytes)),
                  out_options->element_num_bytes);
-    return MOJO_RESULT_OK;
+    if (!OPTIONS_STRUCT_HAS_MEMBER(MojoCreateDataPipeOptions,
+                                   capacity_num_bytes, reader))
+      return MOJO_RESULT_OK;
+  } else {
+    if (reader.options().capacity_num_bytes % out_options->element_num_bytes !=
+        0)
+      return MOJO_RESULT_INVALID_ARGUMENT;
+    if (reader.options().capacity_num_bytes >
+        GetConfiguration().max_data_pipe_capacity_bytes)
+      return MOJO_RESULT_RESOURCE_EXHAUSTED;
+    out_options->capacity_num_bytes = reader.options().capacity_num_bytes;
   }
-  if (reader.options().capacity_num_bytes % out_options->element_num_bytes != 0)
+
+  if (!OPTIONS_STRUCT_HAS_MEMBER(MojoCreateDataPipeOptions,
+                                 read_threshold_num_bytes, reader))
+    return MOJO_RESULT_OK;
+  if (!IsValidThreshold(reader.options().read_threshold_num_bytes,
+                        *out_options))
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  out_options->read_threshold_num_bytes =
+      reader.options().read_threshold_num_bytes;
+
+  if (!OPTIONS_STRUCT_HAS_MEMBER(MojoCreateDataPipeOptions,
+                                 write_threshold_num_bytes, reader))
+    return MOJO_RESULT_OK;
+  if (!IsValidThreshold(reader.options().write_threshold_num_bytes,
+                        *out_options))
     return MOJO_RESULT_INVALID_ARGUMENT;
-  if (reader.options().capacity_num_bytes >
-      GetConfiguration().max_data_pipe_capacity_bytes)
-    return MOJO_RESULT_RESOURCE_EXHAUSTED;
-  out_options->capacity_num_bytes = reader.options().capacity_num_bytes;
+  out_options->write_threshold_num_bytes =
+      reader.options().write_threshold_num_bytes;
 
   return MOJO_RESULT_OK;
 }
@@ -100,13 +191,36 @@ DataPipe* DataPipe::CreateLocal(
 // static
 DataPipe* DataPipe::CreateRemoteProducerFromExisting(
     const MojoCreateDataPipeOptions& validated_options,
+    scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+    size_t shared_ring_start_index,
+    size_t shared_ring_num_bytes,
     MessageInTransitQueue* message_queue,
     ChannelEndpoint* channel_endpoint) {
-  scoped_ptr<char, base::AlignedFreeDeleter> buffer;
-  size_t buffer_num_bytes = 0;
-  if (!RemoteProducerDataPipeImpl::ProcessMessagesFromIncomingEndpoint(
-          validated_options, message_queue, &buffer, &buffer_num_bytes))
-    return nullptr;
+  scoped_ptr<DataPipeImpl> impl;
+  if (shared_ring) {
+    scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping;
+    if (!MapSharedRing(shared_ring.get(), &shared_ring_mapping)) {
+      if (message_queue)
+        message_queue->Clear();
+      return nullptr;
+    }
+    if (!RemoteProducerDataPipeImpl::
+            ProcessSharedRingMessagesFromIncomingEndpoint(
+                validated_options, message_queue, &shared_ring_num_bytes))
+      return nullptr;
+    impl.reset(new RemoteProducerDataPipeImpl(
+        channel_endpoint, shared_ring, shared_ring_mapping.Pass(),
+        shared_ring_start_index, shared_ring_num_bytes));
+  } else {
+    DCHECK_EQ(shared_ring_num_bytes, 0u);
+    scoped_ptr<char, base::AlignedFreeDeleter> buffer;
+    size_t buffer_num_bytes = 0;
+    if (!RemoteProducerDataPipeImpl::ProcessMessagesFromIncomingEndpoint(
+            validated_options, message_queue, &buffer, &buffer_num_bytes))
+      return nullptr;
+    impl.reset(new RemoteProducerDataPipeImpl(channel_endpoint, buffer.Pass(),
+                                              0, buffer_num_bytes));
+  }
 
   // Important: This is called under |IncomingEndpoint|'s (which is a
   // |ChannelEndpointClient|) lock, in particular from
@@ -116,9 +230,7 @@ DataPipe* DataPipe::CreateRemoteProducerFromExisting(
   // make |ChannelEndpoint::OnReadMessage()| retry, until its |ReplaceClient()|
   // is called.
   DataPipe* data_pipe =
-      new DataPipe(false, true, validated_options,
-                   make_scoped_ptr(new RemoteProducerDataPipeImpl(
-                       channel_endpoint, buffer.Pass(), 0, buffer_num_bytes)));
+      new DataPipe(false, true, validated_options, impl.Pass());
   if (channel_endpoint) {
     if (!channel_endpoint->ReplaceClient(data_pipe, 0))
       data_pipe->OnDetachFromChannel(0);
@@ -132,12 +244,30 @@ DataPipe* DataPipe::CreateRemoteProducerFromExisting(
 DataPipe* DataPipe::CreateRemoteConsumerFromExisting(
     const MojoCreateDataPipeOptions& validated_options,
     size_t consumer_num_bytes,
+    scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+    size_t shared_ring_write_index,
     MessageInTransitQueue* message_queue,
     ChannelEndpoint* channel_endpoint) {
+  scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping;
+  if (!MapSharedRing(shared_ring.get(), &shared_ring_mapping)) {
+    if (message_queue)
+      message_queue->Clear();
+    return nullptr;
+  }
   if (!RemoteConsumerDataPipeImpl::ProcessMessagesFromIncomingEndpoint(
           validated_options, &consumer_num_bytes, message_queue))
     return nullptr;
 
+  scoped_ptr<DataPipeImpl> impl;
+  if (shared_ring) {
+    impl.reset(new RemoteConsumerDataPipeImpl(
+        channel_endpoint, consumer_num_bytes, shared_ring,
+        shared_ring_mapping.Pass(), shared_ring_write_index));
+  } else {
+    impl.reset(
+        new RemoteConsumerDataPipeImpl(channel_endpoint, consumer_num_bytes));
+  }
+
   // Important: This is called under |IncomingEndpoint|'s (which is a
   // |ChannelEndpointClient|) lock, in particular from
   // |IncomingEndpoint::ConvertToDataPipeProducer()|. Before releasing that
@@ -146,9 +276,7 @@ DataPipe* DataPipe::CreateRemoteConsumerFromExisting(
   // make |ChannelEndpoint::OnReadMessage()| retry, until its |ReplaceClient()|
   // is called.
   DataPipe* data_pipe =
-      new DataPipe(true, false, validated_options,
-                   make_scoped_ptr(new RemoteConsumerDataPipeImpl(
-                       channel_endpoint, consumer_num_bytes)));
+      new DataPipe(true, false, validated_options, impl.Pass());
   if (channel_endpoint) {
     if (!channel_endpoint->ReplaceClient(data_pipe, 0))
       data_pipe->OnDetachFromChannel(0);
@@ -159,10 +287,12 @@ DataPipe* DataPipe::CreateRemoteConsumerFromExisting(
 }
 
 // static
-bool DataPipe::ProducerDeserialize(Channel* channel,
-                                   const void* source,
-                                   size_t size,
-                                   scoped_refptr<DataPipe>* data_pipe) {
+bool DataPipe::ProducerDeserialize(
+    Channel* channel,
+    const void* source,
+    size_t size,
+    embedder::PlatformHandleVector* platform_handles,
+    scoped_refptr<DataPipe>* data_pipe) {
   DCHECK(!*data_pipe);  // Not technically wrong, but unlikely.
 
   bool consumer_open = false;
@@ -208,6 +338,20 @@ bool DataPipe::ProducerDeserialize(Channel* channel,
     return false;
   }
 
+  scoped_refptr<embedder::PlatformSharedBuffer> shared_ring;
+  if (!DeserializeSharedRing(channel, revalidated_options,
+                             s->shared_ring_platform_handle_index,
+                             platform_handles, &shared_ring))
+    return false;
+  if (shared_ring &&
+      (s->shared_ring_write_index >= revalidated_options.capacity_num_bytes ||
+       s->shared_ring_write_index % revalidated_options.element_num_bytes !=
+           0)) {
+    LOG(ERROR) << "Invalid serialized data pipe producer (bad "
+                  "shared_ring_write_index)";
+    return false;
+  }
+
   const void* endpoint_source = static_cast<const char*>(source) +
                                 sizeof(SerializedDataPipeProducerDispatcher);
   scoped_refptr<IncomingEndpoint> incoming_endpoint =
@@ -216,7 +360,8 @@ bool DataPipe::ProducerDeserialize(Channel* channel,
     return false;
 
   *data_pipe = incoming_endpoint->ConvertToDataPipeProducer(
-      revalidated_options, s->consumer_num_bytes);
+      revalidated_options, s->consumer_num_bytes, shared_ring,
+      s->shared_ring_write_index);
   if (!*data_pipe)
     return false;
 
@@ -224,10 +369,12 @@ bool DataPipe::ProducerDeserialize(Channel* channel,
 }
 
 // static
-bool DataPipe::ConsumerDeserialize(Channel* channel,
-                                   const void* source,
-                                   size_t size,
-                                   scoped_refptr<DataPipe>* data_pipe) {
+bool DataPipe::ConsumerDeserialize(
+    Channel* channel,
+    const void* source,
+    size_t size,
+    embedder::PlatformHandleVector* platform_handles,
+    scoped_refptr<DataPipe>* data_pipe) {
   DCHECK(!*data_pipe);  // Not technically wrong, but unlikely.
 
   if (size !=
@@ -246,6 +393,29 @@ bool DataPipe::ConsumerDeserialize(Channel* channel,
     return false;
   }
 
+  scoped_refptr<embedder::PlatformSharedBuffer> shared_ring;
+  if (!DeserializeSharedRing(channel, revalidated_options,
+                             s->shared_ring_platform_handle_index,
+                             platform_handles, &shared_ring))
+    return false;
+  if (shared_ring) {
+    if (s->shared_ring_start_index >= revalidated_options.capacity_num_bytes ||
+        s->shared_ring_start_index % revalidated_options.element_num_bytes !=
+            0 ||
+        s->shared_ring_num_bytes > revalidated_options.capacity_num_bytes ||
+        s->shared_ring_num_bytes % revalidated_options.element_num_bytes !=
+            0) {
+      LOG(ERROR) << "Invalid serialized data pipe consumer (bad shared ring "
+                    "indices)";
+      return false;
+    }
+  } else if (s->shared_ring_start_index != 0 ||
+             s->shared_ring_num_bytes != 0) {
+    LOG(ERROR) << "Invalid serialized data pipe consumer (unexpected shared "
+                  "ring indices)";
+    return false;
+  }
+
   const void* endpoint_source = static_cast<const char*>(source) +
                                 sizeof(SerializedDataPipeConsumerDispatcher);
   scoped_refptr<IncomingEndpoint> incoming_endpoint =
@@ -253,8 +423,9 @@ bool DataPipe::ConsumerDeserialize(Channel* channel,
   if (!incoming_endpoint)
     return false;
 
-  *data_pipe =
-      incoming_endpoint->ConvertToDataPipeConsumer(revalidated_options);
+  *data_pipe = incoming_endpoint->ConvertToDataPipeConsumer(
+      revalidated_options, shared_ring, s->shared_ring_start_index,
+      s->shared_ring_num_bytes);
   if (!*data_pipe)
     return false;
 
@@ -369,6 +540,29 @@ MojoResult DataPipe::ProducerEndWriteData(uint32_t num_bytes_written) {
   return rv;
 }
 
+MojoResult DataPipe::ProducerSetOptions(uint32_t write_threshold_num_bytes) {
+  base::AutoLock locker(lock_);
+  DCHECK(has_local_producer_no_lock());
+
+  if (!IsValidThreshold(write_threshold_num_bytes, validated_options_))
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  HandleSignalsState old_producer_state =
+      impl_->ProducerGetHandleSignalsState();
+  producer_write_threshold_num_bytes_ = write_threshold_num_bytes;
+  HandleSignalsState new_producer_state =
+      impl_->ProducerGetHandleSignalsState();
+  if (!new_producer_state.equals(old_producer_state))
+    AwakeProducerAwakablesForStateChangeNoLock(new_producer_state);
+  return MOJO_RESULT_OK;
+}
+
+void DataPipe::ProducerGetOptions(uint32_t* write_threshold_num_bytes) {
+  base::AutoLock locker(lock_);
+  DCHECK(has_local_producer_no_lock());
+  *write_threshold_num_bytes = producer_write_threshold_num_bytes_;
+}
+
 HandleSignalsState DataPipe::ProducerGetHandleSignalsState() {
   base::AutoLock locker(lock_);
   DCHECK(has_local_producer_no_lock());
@@ -585,6 +779,29 @@ MojoResult DataPipe::ConsumerEndReadData(uint32_t num_bytes_read) {
   return rv;
 }
 
+MojoResult DataPipe::ConsumerSetOptions(uint32_t read_threshold_num_bytes) {
+  base::AutoLock locker(lock_);
+  DCHECK(has_local_consumer_no_lock());
+
+  if (!IsValidThreshold(read_threshold_num_bytes, validated_options_))
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  HandleSignalsState old_consumer_state =
+      impl_->ConsumerGetHandleSignalsState();
+  consumer_read_threshold_num_bytes_ = read_threshold_num_bytes;
+  HandleSignalsState new_consumer_state =
+      impl_->ConsumerGetHandleSignalsState();
+  if (!new_consumer_state.equals(old_consumer_state))
+    AwakeConsumerAwakablesForStateChangeNoLock(new_consumer_state);
+  return MOJO_RESULT_OK;
+}
+
+void DataPipe::ConsumerGetOptions(uint32_t* read_threshold_num_bytes) {
+  base::AutoLock locker(lock_);
+  DCHECK(has_local_consumer_no_lock());
+  *read_threshold_num_bytes = consumer_read_threshold_num_bytes_;
+}
+
 HandleSignalsState DataPipe::ConsumerGetHandleSignalsState() {
   base::AutoLock locker(lock_);
   DCHECK(has_local_consumer_no_lock());
@@ -675,6 +892,10 @@ DataPipe::DataPipe(bool has_local_producer,
                                                  : nullptr),
       producer_two_phase_max_num_bytes_written_(0),
       consumer_two_phase_max_num_bytes_read_(0),
+      producer_write_threshold_num_bytes_(
+          validated_options.write_threshold_num_bytes),
+      consumer_read_threshold_num_bytes_(
+          validated_options.read_threshold_num_bytes),
       impl_(impl.Pass()) {
   impl_->set_owner(this);
 
@@ -693,6 +914,14 @@ DataPipe::~DataPipe() {
   DCHECK(!consumer_awakable_list_);
 }
 
+MojoCreateDataPipeOptions DataPipe::GetCurrentOptionsNoLock() const {
+  lock_.AssertAcquired();
+  MojoCreateDataPipeOptions rv = validated_options_;
+  rv.read_threshold_num_bytes = consumer_read_threshold_num_bytes_;
+  rv.write_threshold_num_bytes = producer_write_threshold_num_bytes_;
+  return rv;
+}
+
 scoped_ptr<DataPipeImpl> DataPipe::ReplaceImplNoLock(
     scoped_ptr<DataPipeImpl> new_impl) {
   lock_.AssertAcquired();
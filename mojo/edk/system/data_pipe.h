@@ -20,6 +20,11 @@
 #include "mojo/public/c/system/types.h"
 
 namespace mojo {
+
+namespace embedder {
+class PlatformSharedBuffer;
+}
+
 namespace system {
 
 class Awakable;
@@ -63,10 +68,15 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipe : public ChannelEndpointClient {
   // existing |ChannelEndpoint| (whose |ReplaceClient()| it'll call) and taking
   // |message_queue|'s contents as already-received incoming messages. If
   // |channel_endpoint| is null, this will create a "half-open" data pipe (with
-  // only the consumer open). Note that this may fail, in which case it returns
-  // null.
+  // only the consumer open). If |shared_ring| is non-null, the producer writes
+  // data directly into it (and the consumer's data already in it is
+  // |shared_ring_num_bytes| bytes starting at |shared_ring_start_index|). Note
+  // that this may fail, in which case it returns null.
   static DataPipe* CreateRemoteProducerFromExisting(
       const MojoCreateDataPipeOptions& validated_options,
+      scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+      size_t shared_ring_start_index,
+      size_t shared_ring_num_bytes,
       MessageInTransitQueue* message_queue,
       ChannelEndpoint* channel_endpoint);
 
@@ -74,29 +84,37 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipe : public ChannelEndpointClient {
   // existing |ChannelEndpoint| (whose |ReplaceClient()| it'll call) and taking
   // |message_queue|'s contents as already-received incoming messages
   // (|message_queue| may be null). If |channel_endpoint| is null, this will
-  // create a "half-open" data pipe (with only the producer open). Note that
-  // this may fail, in which case it returns null.
+  // create a "half-open" data pipe (with only the producer open). If
+  // |shared_ring| is non-null, the producer writes data directly into it,
+  // starting at |shared_ring_write_index|. Note that this may fail, in which
+  // case it returns null.
   static DataPipe* CreateRemoteConsumerFromExisting(
       const MojoCreateDataPipeOptions& validated_options,
       size_t consumer_num_bytes,
+      scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+      size_t shared_ring_write_index,
       MessageInTransitQueue* message_queue,
       ChannelEndpoint* channel_endpoint);
 
   // Used by |DataPipeProducerDispatcher::Deserialize()|. Returns true on
   // success (in which case, |*data_pipe| is set appropriately) and false on
   // failure (in which case |*data_pipe| may or may not be set to null).
-  static bool ProducerDeserialize(Channel* channel,
-                                  const void* source,
-                                  size_t size,
-                                  scoped_refptr<DataPipe>* data_pipe);
+  static bool ProducerDeserialize(
+      Channel* channel,
+      const void* source,
+      size_t size,
+      embedder::PlatformHandleVector* platform_handles,
+      scoped_refptr<DataPipe>* data_pipe);
 
   // Used by |DataPipeConsumerDispatcher::Deserialize()|. Returns true on
   // success (in which case, |*data_pipe| is set appropriately) and false on
   // failure (in which case |*data_pipe| may or may not be set to null).
-  static bool ConsumerDeserialize(Channel* channel,
-                                  const void* source,
-                                  size_t size,
-                                  scoped_refptr<DataPipe>* data_pipe);
+  static bool ConsumerDeserialize(
+      Channel* channel,
+      const void* source,
+      size_t size,
+      embedder::PlatformHandleVector* platform_handles,
+      scoped_refptr<DataPipe>* data_pipe);
 
   // These are called by the producer dispatcher to implement its methods of
   // corresponding names.
@@ -109,6 +127,9 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipe : public ChannelEndpointClient {
                                     UserPointer<uint32_t> buffer_num_bytes,
                                     bool all_or_none);
   MojoResult ProducerEndWriteData(uint32_t num_bytes_written);
+  // This validates |write_threshold_num_bytes| (zero means the default).
+  MojoResult ProducerSetOptions(uint32_t write_threshold_num_bytes);
+  void ProducerGetOptions(uint32_t* write_threshold_num_bytes);
   HandleSignalsState ProducerGetHandleSignalsState();
   MojoResult ProducerAddAwakable(Awakable* awakable,
                                  MojoHandleSignals signals,
@@ -142,6 +163,9 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipe : public ChannelEndpointClient {
                                    UserPointer<uint32_t> buffer_num_bytes,
                                    bool all_or_none);
   MojoResult ConsumerEndReadData(uint32_t num_bytes_read);
+  // This validates |read_threshold_num_bytes| (zero means the default).
+  MojoResult ConsumerSetOptions(uint32_t read_threshold_num_bytes);
+  void ConsumerGetOptions(uint32_t* read_threshold_num_bytes);
   HandleSignalsState ConsumerGetHandleSignalsState();
   MojoResult ConsumerAddAwakable(Awakable* awakable,
                                  MojoHandleSignals signals,
@@ -182,6 +206,11 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipe : public ChannelEndpointClient {
     return validated_options_.capacity_num_bytes;
   }
 
+  // Returns |validated_options()|, but with the current producer and consumer
+  // thresholds (which may have been set since creation). This is what should
+  // be serialized. Must be called under lock.
+  MojoCreateDataPipeOptions GetCurrentOptionsNoLock() const;
+
   // Must be called under lock.
   bool producer_open_no_lock() const {
     lock_.AssertAcquired();
@@ -216,6 +245,22 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipe : public ChannelEndpointClient {
     lock_.AssertAcquired();
     return consumer_two_phase_max_num_bytes_read_ > 0;
   }
+  // The amount of space (for the producer) or data (for the consumer) needed
+  // to satisfy |MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD| or
+  // |MOJO_HANDLE_SIGNAL_READ_THRESHOLD|, respectively. These are always at
+  // least one element.
+  size_t producer_write_threshold_num_bytes_no_lock() const {
+    lock_.AssertAcquired();
+    return producer_write_threshold_num_bytes_
+               ? producer_write_threshold_num_bytes_
+               : element_num_bytes();
+  }
+  size_t consumer_read_threshold_num_bytes_no_lock() const {
+    lock_.AssertAcquired();
+    return consumer_read_threshold_num_bytes_
+               ? consumer_read_threshold_num_bytes_
+               : element_num_bytes();
+  }
 
  private:
   // |validated_options| should be the output of |ValidateOptions()|. In
@@ -266,6 +311,9 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipe : public ChannelEndpointClient {
   // These are nonzero if and only if a two-phase write/read is in progress.
   uint32_t producer_two_phase_max_num_bytes_written_;
   uint32_t consumer_two_phase_max_num_bytes_read_;
+  // As set by the user (so zero means the default).
+  uint32_t producer_write_threshold_num_bytes_;
+  uint32_t consumer_read_threshold_num_bytes_;
   scoped_ptr<DataPipeImpl> impl_;
 
   DISALLOW_COPY_AND_ASSIGN(DataPipe);
@@ -7,6 +7,7 @@
 #include "base/logging.h"
 #include "mojo/edk/system/data_pipe.h"
 #include "mojo/edk/system/memory.h"
+#include "mojo/edk/system/options_validation.h"
 
 namespace mojo {
 namespace system {
@@ -25,11 +26,14 @@ Dispatcher::Type DataPipeConsumerDispatcher::GetType() const {
 
 // static
 scoped_refptr<DataPipeConsumerDispatcher>
-DataPipeConsumerDispatcher::Deserialize(Channel* channel,
-                                        const void* source,
-                                        size_t size) {
+DataPipeConsumerDispatcher::Deserialize(
+    Channel* channel,
+    const void* source,
+    size_t size,
+    embedder::PlatformHandleVector* platform_handles) {
   scoped_refptr<DataPipe> data_pipe;
-  if (!DataPipe::ConsumerDeserialize(channel, source, size, &data_pipe))
+  if (!DataPipe::ConsumerDeserialize(channel, source, size, platform_handles,
+                                   &data_pipe))
     return nullptr;
   DCHECK(data_pipe);
 
@@ -119,6 +123,44 @@ MojoResult DataPipeConsumerDispatcher::EndReadDataImplNoLock(
   return data_pipe_->ConsumerEndReadData(num_bytes_read);
 }
 
+MojoResult DataPipeConsumerDispatcher::SetDataPipeConsumerOptionsImplNoLock(
+    UserPointer<const MojoDataPipeConsumerOptions> options) {
+  lock().AssertAcquired();
+
+  // Null options (or options without |read_threshold_num_bytes|) mean the
+  // default, which is zero.
+  uint32_t read_threshold_num_bytes = 0;
+  if (!options.IsNull()) {
+    UserOptionsReader<MojoDataPipeConsumerOptions> reader(options);
+    if (!reader.is_valid())
+      return MOJO_RESULT_INVALID_ARGUMENT;
+    if (OPTIONS_STRUCT_HAS_MEMBER(MojoDataPipeConsumerOptions,
+                                  read_threshold_num_bytes, reader))
+      read_threshold_num_bytes = reader.options().read_threshold_num_bytes;
+  }
+
+  return data_pipe_->ConsumerSetOptions(read_threshold_num_bytes);
+}
+
+MojoResult DataPipeConsumerDispatcher::GetDataPipeConsumerOptionsImplNoLock(
+    UserPointer<MojoDataPipeConsumerOptions> options,
+    uint32_t options_num_bytes) {
+  lock().AssertAcquired();
+
+  // Note: If |MojoDataPipeConsumerOptions| is ever extended, this will have to
+  // write only as much of it as fits in |options_num_bytes|.
+  static_assert(sizeof(MojoDataPipeConsumerOptions) == 8u,
+                "MojoDataPipeConsumerOptions has been extended");
+  if (options_num_bytes < sizeof(MojoDataPipeConsumerOptions))
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  MojoDataPipeConsumerOptions current_options = {
+      static_cast<uint32_t>(sizeof(MojoDataPipeConsumerOptions))};
+  data_pipe_->ConsumerGetOptions(&current_options.read_threshold_num_bytes);
+  options.Put(current_options);
+  return MOJO_RESULT_OK;
+}
+
 HandleSignalsState DataPipeConsumerDispatcher::GetHandleSignalsStateImplNoLock()
     const {
   lock().AssertAcquired();
@@ -30,8 +30,11 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeConsumerDispatcher : public Dispatcher {
 
   // The "opposite" of |SerializeAndClose()|. (Typically this is called by
   // |Dispatcher::Deserialize()|.)
-  static scoped_refptr<DataPipeConsumerDispatcher>
-  Deserialize(Channel* channel, const void* source, size_t size);
+  static scoped_refptr<DataPipeConsumerDispatcher> Deserialize(
+      Channel* channel,
+      const void* source,
+      size_t size,
+      embedder::PlatformHandleVector* platform_handles);
 
   // Get access to the |DataPipe| for testing.
   DataPipe* GetDataPipeForTest() { return data_pipe_.get(); }
@@ -51,6 +54,11 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeConsumerDispatcher : public Dispatcher {
                                      UserPointer<uint32_t> buffer_num_bytes,
                                      MojoReadDataFlags flags) override;
   MojoResult EndReadDataImplNoLock(uint32_t num_bytes_read) override;
+  MojoResult SetDataPipeConsumerOptionsImplNoLock(
+      UserPointer<const MojoDataPipeConsumerOptions> options) override;
+  MojoResult GetDataPipeConsumerOptionsImplNoLock(
+      UserPointer<MojoDataPipeConsumerOptions> options,
+      uint32_t options_num_bytes) override;
   HandleSignalsState GetHandleSignalsStateImplNoLock() const override;
   MojoResult AddAwakableImplNoLock(Awakable* awakable,
                                    MojoHandleSignals signals,
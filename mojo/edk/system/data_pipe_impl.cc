@@ -8,6 +8,9 @@
 
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
+#include "mojo/edk/embedder/platform_support.h"
+#include "mojo/edk/system/channel.h"
 #include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/message_in_transit.h"
 #include "mojo/edk/system/message_in_transit_queue.h"
@@ -47,5 +50,59 @@ void DataPipeImpl::ConvertDataToMessages(const char* buffer,
   }
 }
 
+// static
+bool DataPipeImpl::ShouldUseSharedRing(size_t capacity_num_bytes) {
+  size_t min_capacity_num_bytes =
+      GetConfiguration().min_shared_memory_data_pipe_capacity_bytes;
+  return min_capacity_num_bytes && capacity_num_bytes >= min_capacity_num_bytes;
+}
+
+// static
+bool DataPipeImpl::CreateSharedRing(
+    Channel* channel,
+    size_t capacity_num_bytes,
+    scoped_refptr<embedder::PlatformSharedBuffer>* shared_ring,
+    scoped_ptr<embedder::PlatformSharedBufferMapping>* shared_ring_mapping) {
+  DCHECK(channel);
+  DCHECK_GT(capacity_num_bytes, 0u);
+
+  scoped_refptr<embedder::PlatformSharedBuffer> new_shared_ring(
+      channel->platform_support()->CreateSharedBuffer(capacity_num_bytes));
+  if (!new_shared_ring) {
+    LOG(WARNING) << "Failed to create shared ring for data pipe";
+    return false;
+  }
+  scoped_ptr<embedder::PlatformSharedBufferMapping> new_shared_ring_mapping(
+      new_shared_ring->Map(0, capacity_num_bytes));
+  if (!new_shared_ring_mapping) {
+    LOG(WARNING) << "Failed to map shared ring for data pipe";
+    return false;
+  }
+
+  *shared_ring = new_shared_ring;
+  *shared_ring_mapping = new_shared_ring_mapping.Pass();
+  return true;
+}
+
+// static
+bool DataPipeImpl::SerializeSharedRing(
+    embedder::PlatformSharedBuffer* shared_ring,
+    embedder::PlatformHandleVector* platform_handles,
+    uint32_t* platform_handle_index) {
+  DCHECK(shared_ring);
+  DCHECK(platform_handles);
+
+  embedder::ScopedPlatformHandle platform_handle(
+      shared_ring->DuplicatePlatformHandle());
+  if (!platform_handle.is_valid()) {
+    LOG(ERROR) << "Failed to duplicate shared ring handle for data pipe";
+    return false;
+  }
+
+  *platform_handle_index = static_cast<uint32_t>(platform_handles->size());
+  platform_handles->push_back(platform_handle.release());
+  return true;
+}
+
 }  // namespace system
 }  // namespace mojo
@@ -9,6 +9,8 @@
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 #include "mojo/edk/embedder/platform_handle_vector.h"
 #include "mojo/edk/system/data_pipe.h"
 #include "mojo/edk/system/handle_signals_state.h"
@@ -18,6 +20,12 @@
 #include "mojo/public/c/system/types.h"
 
 namespace mojo {
+
+namespace embedder {
+class PlatformSharedBuffer;
+class PlatformSharedBufferMapping;
+}
+
 namespace system {
 
 class Channel;
@@ -99,11 +107,38 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeImpl {
                              size_t* current_num_bytes,
                              MessageInTransitQueue* message_queue);
 
+  // Helpers for data pipes whose buffer is a ring in shared memory (see
+  // |embedder::Configuration::min_shared_memory_data_pipe_capacity_bytes|):
+
+  // Returns true if a data pipe with the given capacity should use a shared
+  // ring when one of its ends is sent to another process.
+  static bool ShouldUseSharedRing(size_t capacity_num_bytes);
+
+  // Creates and maps a shared ring of the given capacity. On success, returns
+  // true and sets |*shared_ring| and |*shared_ring_mapping|; on failure (e.g.,
+  // if the system is out of shared memory) returns false, in which case the
+  // caller should fall back to sending data in messages.
+  static bool CreateSharedRing(
+      Channel* channel,
+      size_t capacity_num_bytes,
+      scoped_refptr<embedder::PlatformSharedBuffer>* shared_ring,
+      scoped_ptr<embedder::PlatformSharedBufferMapping>* shared_ring_mapping);
+
+  // Duplicates |shared_ring|'s platform handle into |platform_handles|, setting
+  // |*platform_handle_index| to its index. Returns false on failure.
+  static bool SerializeSharedRing(
+      embedder::PlatformSharedBuffer* shared_ring,
+      embedder::PlatformHandleVector* platform_handles,
+      uint32_t* platform_handle_index);
+
   DataPipe* owner() const { return owner_; }
 
   const MojoCreateDataPipeOptions& validated_options() const {
     return owner_->validated_options();
   }
+  MojoCreateDataPipeOptions current_options() const {
+    return owner_->GetCurrentOptionsNoLock();
+  }
   size_t element_num_bytes() const { return owner_->element_num_bytes(); }
   size_t capacity_num_bytes() const { return owner_->capacity_num_bytes(); }
   bool producer_open() const { return owner_->producer_open_no_lock(); }
@@ -126,6 +161,12 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeImpl {
   bool consumer_in_two_phase_read() const {
     return owner_->consumer_in_two_phase_read_no_lock();
   }
+  size_t producer_write_threshold_num_bytes() const {
+    return owner_->producer_write_threshold_num_bytes_no_lock();
+  }
+  size_t consumer_read_threshold_num_bytes() const {
+    return owner_->consumer_read_threshold_num_bytes_no_lock();
+  }
 
  private:
   DataPipe* owner_;
@@ -136,6 +177,10 @@ class MOJO_SYSTEM_IMPL_EXPORT DataPipeImpl {
 // TODO(vtl): This is not the ideal place for the following structs; find
 // somewhere better.
 
+// Value of |shared_ring_platform_handle_index| (below) for data pipes whose
+// data is sent in messages (instead of through a shared ring).
+const uint32_t kNoSharedRingPlatformHandleIndex = static_cast<uint32_t>(-1);
+
 // Serialized form of a producer dispatcher. This will actually be followed by a
 // serialized |ChannelEndpoint|; we want to preserve alignment guarantees.
 struct ALIGNAS(8) SerializedDataPipeProducerDispatcher {
@@ -146,6 +191,11 @@ struct ALIGNAS(8) SerializedDataPipeProducerDispatcher {
   // |static_cast<size_t>(-1)| if the consumer is already closed, in which case
   // this will *not* be followed by a serialized |ChannelEndpoint|.
   size_t consumer_num_bytes;
+  // Index of the shared ring's platform handle, or
+  // |kNoSharedRingPlatformHandleIndex| if there's no shared ring.
+  uint32_t shared_ring_platform_handle_index;
+  // If there's a shared ring, the index in it at which the next write goes.
+  uint32_t shared_ring_write_index;
 };
 
 // Serialized form of a consumer dispatcher. This will actually be followed by a
@@ -154,6 +204,14 @@ struct ALIGNAS(8) SerializedDataPipeConsumerDispatcher {
   // Only validated (and thus canonicalized) options should be serialized.
   // However, the deserializer must revalidate (as with everything received).
   MojoCreateDataPipeOptions validated_options;
+  // Index of the shared ring's platform handle, or
+  // |kNoSharedRingPlatformHandleIndex| if there's no shared ring (in which case
+  // the following two fields are zero).
+  uint32_t shared_ring_platform_handle_index;
+  // If there's a shared ring, the (circular) range of it holding data not yet
+  // consumed.
+  uint32_t shared_ring_start_index;
+  uint32_t shared_ring_num_bytes;
 };
 
 }  // namespace system
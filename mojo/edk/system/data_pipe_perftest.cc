@@ -0,0 +1,297 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/data_pipe.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/perf_log.h"
+#include "base/test/test_io_thread.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "mojo/edk/embedder/platform_channel_pair.h"
+#include "mojo/edk/embedder/simple_platform_support.h"
+#include "mojo/edk/system/channel.h"
+#include "mojo/edk/system/channel_endpoint.h"
+#include "mojo/edk/system/configuration.h"
+#include "mojo/edk/system/data_pipe_producer_dispatcher.h"
+#include "mojo/edk/system/memory.h"
+#include "mojo/edk/system/message_pipe.h"
+#include "mojo/edk/system/raw_channel.h"
+#include "mojo/edk/system/test_utils.h"
+#include "mojo/edk/system/waiter.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace system {
+namespace {
+
+// The total amount of data to send through each data pipe.
+const size_t kTotalNumBytes = 256 * 1024 * 1024;
+
+// Waits (indefinitely) until |signals| is satisfied for the producer or
+// consumer (depending on |producer|) of |data_pipe|.
+void WaitForSignals(DataPipe* data_pipe,
+                    bool producer,
+                    MojoHandleSignals signals) {
+  Waiter waiter;
+  waiter.Init();
+  MojoResult result =
+      producer ? data_pipe->ProducerAddAwakable(&waiter, signals, 0, nullptr)
+               : data_pipe->ConsumerAddAwakable(&waiter, signals, 0, nullptr);
+  if (result == MOJO_RESULT_ALREADY_EXISTS)
+    return;
+  CHECK_EQ(result, MOJO_RESULT_OK);
+  CHECK_EQ(waiter.Wait(MOJO_DEADLINE_INDEFINITE, nullptr), MOJO_RESULT_OK);
+  if (producer)
+    data_pipe->ProducerRemoveAwakable(&waiter, nullptr);
+  else
+    data_pipe->ConsumerRemoveAwakable(&waiter, nullptr);
+}
+
+// Writes |num_bytes| bytes to the producer of |data_pipe| using two-phase
+// writes (filling in the data), in chunks of at most |max_chunk_num_bytes|.
+class ProducerThread : public base::SimpleThread {
+ public:
+  ProducerThread(DataPipe* data_pipe,
+                 size_t num_bytes,
+                 size_t max_chunk_num_bytes)
+      : base::SimpleThread("producer_thread"),
+        data_pipe_(data_pipe),
+        num_bytes_(num_bytes),
+        max_chunk_num_bytes_(max_chunk_num_bytes) {}
+  ~ProducerThread() override { Join(); }
+
+ private:
+  void Run() override {
+    size_t num_bytes_left = num_bytes_;
+    while (num_bytes_left > 0) {
+      void* buffer = nullptr;
+      uint32_t buffer_num_bytes = 0;
+      MojoResult result = data_pipe_->ProducerBeginWriteData(
+          MakeUserPointer(&buffer), MakeUserPointer(&buffer_num_bytes), false);
+      if (result == MOJO_RESULT_SHOULD_WAIT) {
+        WaitForSignals(data_pipe_, true, MOJO_HANDLE_SIGNAL_WRITABLE);
+        continue;
+      }
+      CHECK_EQ(result, MOJO_RESULT_OK);
+
+      size_t num_bytes_to_write = std::min(
+          static_cast<size_t>(buffer_num_bytes),
+          std::min(max_chunk_num_bytes_, num_bytes_left));
+      memset(buffer, 'x', num_bytes_to_write);
+      CHECK_EQ(data_pipe_->ProducerEndWriteData(
+                   static_cast<uint32_t>(num_bytes_to_write)),
+               MOJO_RESULT_OK);
+      num_bytes_left -= num_bytes_to_write;
+    }
+  }
+
+  DataPipe* const data_pipe_;
+  const size_t num_bytes_;
+  const size_t max_chunk_num_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+// Measures the throughput of data pipes whose producer is on the other side of
+// a |Channel| (in this process), with data either sent in messages or written
+// to a shared ring (see
+// |embedder::Configuration::min_shared_memory_data_pipe_capacity_bytes|).
+class DataPipePerfTest : public testing::Test {
+ public:
+  DataPipePerfTest() : io_thread_(base::TestIOThread::kAutoStart) {}
+  ~DataPipePerfTest() override {}
+
+  void SetUp() override {
+    scoped_refptr<ChannelEndpoint> ep[2];
+    message_pipes_[0] = MessagePipe::CreateLocalProxy(&ep[0]);
+    message_pipes_[1] = MessagePipe::CreateLocalProxy(&ep[1]);
+
+    io_thread_.PostTaskAndWait(
+        FROM_HERE, base::Bind(&DataPipePerfTest::SetUpOnIOThread,
+                              base::Unretained(this), ep[0], ep[1]));
+  }
+
+  void TearDown() override {
+    message_pipes_[0]->Close(0);
+    message_pipes_[1]->Close(0);
+    io_thread_.PostTaskAndWait(
+        FROM_HERE, base::Bind(&DataPipePerfTest::TearDownOnIOThread,
+                              base::Unretained(this)));
+  }
+
+ protected:
+  // Creates a data pipe with the given capacity and sends its producer across
+  // the channel, making |*producer_dispatcher| the (remote) producer and
+  // |*consumer| the (local) consumer.
+  void CreateRemoteProducerDataPipe(
+      uint32_t capacity_num_bytes,
+      scoped_refptr<DataPipeProducerDispatcher>* producer_dispatcher,
+      scoped_refptr<DataPipe>* consumer) {
+    const MojoCreateDataPipeOptions options = {
+        static_cast<uint32_t>(sizeof(MojoCreateDataPipeOptions)),
+        MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE, 1u, capacity_num_bytes};
+    MojoCreateDataPipeOptions validated_options = {};
+    ASSERT_EQ(MOJO_RESULT_OK, DataPipe::ValidateCreateOptions(
+                                  MakeUserPointer(&options),
+                                  &validated_options));
+    scoped_refptr<DataPipe> data_pipe(DataPipe::CreateLocal(validated_options));
+
+    scoped_refptr<DataPipeProducerDispatcher> to_send =
+        new DataPipeProducerDispatcher();
+    to_send->Init(data_pipe);
+
+    Waiter waiter;
+    waiter.Init();
+    ASSERT_EQ(MOJO_RESULT_OK,
+              message_pipes_[1]->AddAwakable(
+                  0, &waiter, MOJO_HANDLE_SIGNAL_READABLE, 0, nullptr));
+    {
+      DispatcherTransport transport(
+          test::DispatcherTryStartTransport(to_send.get()));
+      ASSERT_TRUE(transport.is_valid());
+      std::vector<DispatcherTransport> transports;
+      transports.push_back(transport);
+      ASSERT_EQ(MOJO_RESULT_OK, message_pipes_[0]->WriteMessage(
+                                    0, NullUserPointer(), 0, &transports,
+                                    MOJO_WRITE_MESSAGE_FLAG_NONE));
+      transport.End();
+    }
+    ASSERT_EQ(MOJO_RESULT_OK, waiter.Wait(MOJO_DEADLINE_INDEFINITE, nullptr));
+    message_pipes_[1]->RemoveAwakable(0, &waiter, nullptr);
+
+    uint32_t read_buffer_size = 0;
+    DispatcherVector read_dispatchers;
+    uint32_t read_num_dispatchers = 1;
+    ASSERT_EQ(MOJO_RESULT_OK,
+              message_pipes_[1]->ReadMessage(
+                  0, NullUserPointer(), MakeUserPointer(&read_buffer_size),
+                  &read_dispatchers, &read_num_dispatchers,
+                  MOJO_READ_MESSAGE_FLAG_NONE));
+    ASSERT_EQ(1u, read_dispatchers.size());
+    ASSERT_EQ(Dispatcher::Type::DATA_PIPE_PRODUCER,
+              read_dispatchers[0]->GetType());
+
+    *producer_dispatcher =
+        static_cast<DataPipeProducerDispatcher*>(read_dispatchers[0].get());
+    *consumer = data_pipe;
+  }
+
+  // Sends |kTotalNumBytes| through a data pipe with the given capacity (using
+  // two-phase writes of at most |max_chunk_num_bytes| and two-phase reads), and
+  // logs the throughput.
+  void Measure(const char* test_name_prefix,
+               uint32_t capacity_num_bytes,
+               size_t max_chunk_num_bytes) {
+    scoped_refptr<DataPipeProducerDispatcher> producer_dispatcher;
+    scoped_refptr<DataPipe> consumer;
+    CreateRemoteProducerDataPipe(capacity_num_bytes, &producer_dispatcher,
+                                 &consumer);
+    ASSERT_TRUE(producer_dispatcher);
+
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    {
+      ProducerThread producer_thread(producer_dispatcher->GetDataPipeForTest(),
+                                     kTotalNumBytes, max_chunk_num_bytes);
+      producer_thread.Start();
+
+      size_t num_bytes_left = kTotalNumBytes;
+      while (num_bytes_left > 0) {
+        const void* buffer = nullptr;
+        uint32_t buffer_num_bytes = 0;
+        MojoResult result = consumer->ConsumerBeginReadData(
+            MakeUserPointer(&buffer), MakeUserPointer(&buffer_num_bytes),
+            false);
+        if (result == MOJO_RESULT_SHOULD_WAIT) {
+          WaitForSignals(consumer.get(), false, MOJO_HANDLE_SIGNAL_READABLE);
+          continue;
+        }
+        CHECK_EQ(result, MOJO_RESULT_OK);
+        CHECK_EQ(static_cast<const char*>(buffer)[0], 'x');
+        CHECK_EQ(consumer->ConsumerEndReadData(buffer_num_bytes),
+                 MOJO_RESULT_OK);
+        num_bytes_left -= buffer_num_bytes;
+      }
+    }  // Joins the producer thread.
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+
+    EXPECT_EQ(MOJO_RESULT_OK, producer_dispatcher->Close());
+    consumer->ConsumerClose();
+
+    std::string test_name = base::StringPrintf(
+        "%s_%uCapacity_%uChunk", test_name_prefix,
+        static_cast<unsigned>(capacity_num_bytes),
+        static_cast<unsigned>(max_chunk_num_bytes));
+    base::LogPerfResult(test_name.c_str(),
+                        kTotalNumBytes / elapsed.InSecondsF() /
+                            (1024.0 * 1024.0 * 1024.0),
+                        "GB/s");
+  }
+
+ private:
+  void SetUpOnIOThread(scoped_refptr<ChannelEndpoint> ep0,
+                       scoped_refptr<ChannelEndpoint> ep1) {
+    CHECK_EQ(base::MessageLoop::current(), io_thread_.message_loop());
+
+    embedder::PlatformChannelPair channel_pair;
+    channels_[0] = new Channel(&platform_support_);
+    channels_[0]->Init(RawChannel::Create(channel_pair.PassServerHandle()));
+    channels_[0]->SetBootstrapEndpoint(ep0);
+    channels_[1] = new Channel(&platform_support_);
+    channels_[1]->Init(RawChannel::Create(channel_pair.PassClientHandle()));
+    channels_[1]->SetBootstrapEndpoint(ep1);
+  }
+
+  void TearDownOnIOThread() {
+    CHECK_EQ(base::MessageLoop::current(), io_thread_.message_loop());
+
+    channels_[0]->Shutdown();
+    channels_[0] = nullptr;
+    channels_[1]->Shutdown();
+    channels_[1] = nullptr;
+  }
+
+  embedder::SimplePlatformSupport platform_support_;
+  base::TestIOThread io_thread_;
+  scoped_refptr<Channel> channels_[2];
+  scoped_refptr<MessagePipe> message_pipes_[2];
+
+  DISALLOW_COPY_AND_ASSIGN(DataPipePerfTest);
+};
+
+TEST_F(DataPipePerfTest, RemoteProducerThroughput) {
+  const uint32_t kCapacities[] = {64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+  const size_t kMaxChunkNumBytes[] = {4 * 1024, 64 * 1024};
+
+  size_t old_min_shared_memory_data_pipe_capacity_bytes =
+      GetConfiguration().min_shared_memory_data_pipe_capacity_bytes;
+  for (size_t i = 0; i < arraysize(kCapacities); i++) {
+    for (size_t j = 0; j < arraysize(kMaxChunkNumBytes); j++) {
+      GetMutableConfiguration()->min_shared_memory_data_pipe_capacity_bytes =
+          0;
+      Measure("DataPipe_Messages", kCapacities[i], kMaxChunkNumBytes[j]);
+      GetMutableConfiguration()->min_shared_memory_data_pipe_capacity_bytes =
+          1;
+      Measure("DataPipe_SharedRing", kCapacities[i], kMaxChunkNumBytes[j]);
+    }
+  }
+  GetMutableConfiguration()->min_shared_memory_data_pipe_capacity_bytes =
+      old_min_shared_memory_data_pipe_capacity_bytes;
+}
+
+}  // namespace
+}  // namespace system
+}  // namespace mojo
@@ -7,6 +7,7 @@
 #include "base/logging.h"
 #include "mojo/edk/system/data_pipe.h"
 #include "mojo/edk/system/memory.h"
+#include "mojo/edk/system/options_validation.h"
 
 namespace mojo {
 namespace system {
@@ -25,11 +26,14 @@ Dispatcher::Type DataPipeProducerDispatcher::GetType() const {
 
 // static
 scoped_refptr<DataPipeProducerDispatcher>
-DataPipeProducerDispatcher::Deserialize(Channel* channel,
-                                        const void* source,
-                                        size_t size) {
+DataPipeProducerDispatcher::Deserialize(
+    Channel* channel,
+    const void* source,
+    size_t size,
+    embedder::PlatformHandleVector* platform_handles) {
   scoped_refptr<DataPipe> data_pipe;
-  if (!DataPipe::ProducerDeserialize(channel, source, size, &data_pipe))
+  if (!DataPipe::ProducerDeserialize(channel, source, size, platform_handles,
+                                   &data_pipe))
     return nullptr;
   DCHECK(data_pipe);
 
@@ -92,6 +96,44 @@ MojoResult DataPipeProducerDispatcher::EndWriteDataImplNoLock(
   return data_pipe_->ProducerEndWriteData(num_bytes_written);
 }
 
+MojoResult DataPipeProducerDispatcher::SetDataPipeProducerOptionsImplNoLock(
+    UserPointer<const MojoDataPipeProducerOptions> options) {
+  lock().AssertAcquired();
+
+  // Null options (or options without |write_threshold_num_bytes|) mean the
+  // default, which is zero.
+  uint32_t write_threshold_num_bytes = 0;
+  if (!options.IsNull()) {
+    UserOptionsReader<MojoDataPipeProducerOptions> reader(options);
+    if (!reader.is_valid())
+      return MOJO_RESULT_INVALID_ARGUMENT;
+    if (OPTIONS_STRUCT_HAS_MEMBER(MojoDataPipeProducerOptions,
+                                  write_threshold_num_bytes, reader))
+      write_threshold_num_bytes = reader.options().write_threshold_num_bytes;
+  }
+
+  return data_pipe_->ProducerSetOptions(write_threshold_num_bytes);
+}
+
+MojoResult DataPipeProducerDispatcher::GetDataPipeProducerOptionsImplNoLock(
+    UserPointer<MojoDataPipeProducerOptions> options,
+    uint32_t options_num_bytes) {
+  lock().AssertAcquired();
+
+  // Note: If |MojoDataPipeProducerOptions| is ever extended, this will have to
+  // write only as much of it as fits in |options_num_bytes|.
+  static_assert(sizeof(MojoDataPipeProducerOptions) == 8u,
+                "MojoDataPipeProducerOptions has been extended");
+  if (options_num_bytes < sizeof(MojoDataPipeProducerOptions))
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  MojoDataPipeProducerOptions current_options = {
+      static_cast<uint32_t>(sizeof(MojoDataPipeProducerOptions))};
+  data_pipe_->ProducerGetOptions(&current_options.write_threshold_num_bytes);
+  options.Put(current_options);
+  return MOJO_RESULT_OK;
+}
+
 HandleSignalsState DataPipeProducerDispatcher::GetHandleSignalsStateImplNoLock()
     const {
   lock().AssertAcquired();
@@ -41,6 +41,10 @@ void RevalidateCreateOptions(
   EXPECT_EQ(validated_options.capacity_num_bytes,
             revalidated_options.capacity_num_bytes);
   EXPECT_EQ(validated_options.flags, revalidated_options.flags);
+  EXPECT_EQ(validated_options.read_threshold_num_bytes,
+            revalidated_options.read_threshold_num_bytes);
+  EXPECT_EQ(validated_options.write_threshold_num_bytes,
+            revalidated_options.write_threshold_num_bytes);
 }
 
 // Checks that a default-computed capacity is correct. (Does not duplicate the
@@ -247,6 +251,44 @@ TEST(DataPipeTest, ValidateCreateOptionsValid) {
       }
     }
   }
+
+  // Thresholds.
+  {
+    MojoCreateDataPipeOptions options = {
+        kSizeOfCreateOptions,                     // |struct_size|.
+        MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+        4,                                        // |element_num_bytes|.
+        100,                                      // |capacity_num_bytes|.
+        12,                                       // |read_threshold_num_bytes|.
+        100  // |write_threshold_num_bytes|.
+    };
+    MojoCreateDataPipeOptions validated_options = {};
+    EXPECT_EQ(MOJO_RESULT_OK,
+              DataPipe::ValidateCreateOptions(MakeUserPointer(&options),
+                                              &validated_options));
+    RevalidateCreateOptions(validated_options);
+    EXPECT_EQ(12u, validated_options.read_threshold_num_bytes);
+    EXPECT_EQ(100u, validated_options.write_threshold_num_bytes);
+  }
+  // Thresholds with a default capacity.
+  {
+    MojoCreateDataPipeOptions options = {
+        kSizeOfCreateOptions,                     // |struct_size|.
+        MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+        2,                                        // |element_num_bytes|.
+        0,                                        // |capacity_num_bytes|.
+        0,                                        // |read_threshold_num_bytes|.
+        64  // |write_threshold_num_bytes|.
+    };
+    MojoCreateDataPipeOptions validated_options = {};
+    EXPECT_EQ(MOJO_RESULT_OK,
+              DataPipe::ValidateCreateOptions(MakeUserPointer(&options),
+                                              &validated_options));
+    RevalidateCreateOptions(validated_options);
+    CheckDefaultCapacity(validated_options);
+    EXPECT_EQ(0u, validated_options.read_threshold_num_bytes);
+    EXPECT_EQ(64u, validated_options.write_threshold_num_bytes);
+  }
 }
 
 TEST(DataPipeTest, ValidateCreateOptionsInvalid) {
@@ -367,6 +409,66 @@ TEST(DataPipeTest, ValidateCreateOptionsInvalid) {
         MOJO_RESULT_RESOURCE_EXHAUSTED,
         DataPipe::ValidateCreateOptions(MakeUserPointer(&options), &unused));
   }
+
+  // Invalid |read_threshold_num_bytes|: not a multiple of the element size, or
+  // greater than the capacity.
+  {
+    MojoCreateDataPipeOptions options = {
+        kSizeOfCreateOptions,                     // |struct_size|.
+        MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+        4,                                        // |element_num_bytes|.
+        100,                                      // |capacity_num_bytes|.
+        6,                                        // |read_threshold_num_bytes|.
+        0  // |write_threshold_num_bytes|.
+    };
+    MojoCreateDataPipeOptions unused;
+    EXPECT_EQ(
+        MOJO_RESULT_INVALID_ARGUMENT,
+        DataPipe::ValidateCreateOptions(MakeUserPointer(&options), &unused));
+  }
+  {
+    MojoCreateDataPipeOptions options = {
+        kSizeOfCreateOptions,                     // |struct_size|.
+        MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+        4,                                        // |element_num_bytes|.
+        100,                                      // |capacity_num_bytes|.
+        104,                                      // |read_threshold_num_bytes|.
+        0  // |write_threshold_num_bytes|.
+    };
+    MojoCreateDataPipeOptions unused;
+    EXPECT_EQ(
+        MOJO_RESULT_INVALID_ARGUMENT,
+        DataPipe::ValidateCreateOptions(MakeUserPointer(&options), &unused));
+  }
+  // Invalid |write_threshold_num_bytes|.
+  {
+    MojoCreateDataPipeOptions options = {
+        kSizeOfCreateOptions,                     // |struct_size|.
+        MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+        4,                                        // |element_num_bytes|.
+        100,                                      // |capacity_num_bytes|.
+        0,                                        // |read_threshold_num_bytes|.
+        3  // |write_threshold_num_bytes|.
+    };
+    MojoCreateDataPipeOptions unused;
+    EXPECT_EQ(
+        MOJO_RESULT_INVALID_ARGUMENT,
+        DataPipe::ValidateCreateOptions(MakeUserPointer(&options), &unused));
+  }
+  {
+    MojoCreateDataPipeOptions options = {
+        kSizeOfCreateOptions,                     // |struct_size|.
+        MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,  // |flags|.
+        4,                                        // |element_num_bytes|.
+        100,                                      // |capacity_num_bytes|.
+        0,                                        // |read_threshold_num_bytes|.
+        200  // |write_threshold_num_bytes|.
+    };
+    MojoCreateDataPipeOptions unused;
+    EXPECT_EQ(
+        MOJO_RESULT_INVALID_ARGUMENT,
+        DataPipe::ValidateCreateOptions(MakeUserPointer(&options), &unused));
+  }
 }
 
 }  // namespace
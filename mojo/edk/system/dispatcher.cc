@@ -35,8 +35,8 @@ DispatcherTransport Dispatcher::HandleTableAccess::TryStartTransport(
     return DispatcherTransport();
 
   // We shouldn't race with things that close dispatchers, since closing can
-  // only take place either under |handle_table_lock_| or when the handle is
-  // marked as busy.
+  // only take place either under the handle table (shard) lock or when the
+  // handle is marked as busy.
   DCHECK(!dispatcher->is_closed_);
 
   return DispatcherTransport(dispatcher);
@@ -80,13 +80,19 @@ scoped_refptr<Dispatcher> Dispatcher::TransportDataAccess::Deserialize(
           MessagePipeDispatcher::Deserialize(channel, source, size));
     case Type::DATA_PIPE_PRODUCER:
       return scoped_refptr<Dispatcher>(
-          DataPipeProducerDispatcher::Deserialize(channel, source, size));
+          DataPipeProducerDispatcher::Deserialize(channel, source, size,
+                                                  platform_handles));
     case Type::DATA_PIPE_CONSUMER:
       return scoped_refptr<Dispatcher>(
-          DataPipeConsumerDispatcher::Deserialize(channel, source, size));
+          DataPipeConsumerDispatcher::Deserialize(channel, source, size,
+                                                  platform_handles));
     case Type::SHARED_BUFFER:
       return scoped_refptr<Dispatcher>(SharedBufferDispatcher::Deserialize(
           channel, source, size, platform_handles));
+    case Type::WAIT_SET:
+      // Wait sets can't be sent over message pipes (see |MessagePipe|), so
+      // this must be bad data.
+      break;
     case Type::PLATFORM_HANDLE:
       return scoped_refptr<Dispatcher>(PlatformHandleDispatcher::Deserialize(
           channel, source, size, platform_handles));
@@ -120,6 +126,23 @@ MojoResult Dispatcher::WriteMessage(
   return WriteMessageImplNoLock(bytes, num_bytes, transports, flags);
 }
 
+MojoResult Dispatcher::WriteMessages(
+    UserPointer<const void> bytes,
+    const uint32_t* message_num_bytes,
+    std::vector<DispatcherTransport>* transports,
+    const uint32_t* message_num_transports,
+    uint32_t num_messages,
+    MojoWriteMessageFlags flags) {
+  DCHECK(!transports || (!transports->empty() && message_num_transports));
+
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return WriteMessagesImplNoLock(bytes, message_num_bytes, transports,
+                                 message_num_transports, num_messages, flags);
+}
+
 MojoResult Dispatcher::ReadMessage(UserPointer<void> bytes,
                                    UserPointer<uint32_t> num_bytes,
                                    DispatcherVector* dispatchers,
@@ -136,6 +159,61 @@ MojoResult Dispatcher::ReadMessage(UserPointer<void> bytes,
                                flags);
 }
 
+MojoResult Dispatcher::ReadMessages(
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    DispatcherVector* dispatchers,
+    uint32_t* num_dispatchers,
+    UserPointer<uint32_t> message_num_bytes,
+    UserPointer<uint32_t> message_num_dispatchers,
+    UserPointer<uint32_t> num_messages,
+    MojoReadMessageFlags flags) {
+  DCHECK(!num_dispatchers || *num_dispatchers == 0 ||
+         (dispatchers && dispatchers->empty()));
+
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return ReadMessagesImplNoLock(bytes, num_bytes, dispatchers, num_dispatchers,
+                                message_num_bytes, message_num_dispatchers,
+                                num_messages, flags);
+}
+
+MojoResult Dispatcher::WriteMessageContext(
+    uintptr_t context,
+    const MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  DCHECK(thunks);
+
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return WriteMessageContextImplNoLock(context, thunks, flags);
+}
+
+MojoResult Dispatcher::ReadMessageContext(
+    const MojoMessageContextThunks* thunks,
+    uintptr_t* context,
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    DispatcherVector* dispatchers,
+    uint32_t* num_dispatchers,
+    MojoReadMessageFlags flags) {
+  DCHECK(thunks);
+  DCHECK(context);
+  DCHECK(!num_dispatchers || *num_dispatchers == 0 ||
+         (dispatchers && dispatchers->empty()));
+
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return ReadMessageContextImplNoLock(thunks, context, bytes, num_bytes,
+                                      dispatchers, num_dispatchers, flags);
+}
+
 MojoResult Dispatcher::WriteData(UserPointer<const void> elements,
                                  UserPointer<uint32_t> num_bytes,
                                  MojoWriteDataFlags flags) {
@@ -164,6 +242,25 @@ MojoResult Dispatcher::EndWriteData(uint32_t num_bytes_written) {
   return EndWriteDataImplNoLock(num_bytes_written);
 }
 
+MojoResult Dispatcher::SetDataPipeProducerOptions(
+    UserPointer<const MojoDataPipeProducerOptions> options) {
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return SetDataPipeProducerOptionsImplNoLock(options);
+}
+
+MojoResult Dispatcher::GetDataPipeProducerOptions(
+    UserPointer<MojoDataPipeProducerOptions> options,
+    uint32_t options_num_bytes) {
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return GetDataPipeProducerOptionsImplNoLock(options, options_num_bytes);
+}
+
 MojoResult Dispatcher::ReadData(UserPointer<void> elements,
                                 UserPointer<uint32_t> num_bytes,
                                 MojoReadDataFlags flags) {
@@ -192,6 +289,25 @@ MojoResult Dispatcher::EndReadData(uint32_t num_bytes_read) {
   return EndReadDataImplNoLock(num_bytes_read);
 }
 
+MojoResult Dispatcher::SetDataPipeConsumerOptions(
+    UserPointer<const MojoDataPipeConsumerOptions> options) {
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return SetDataPipeConsumerOptionsImplNoLock(options);
+}
+
+MojoResult Dispatcher::GetDataPipeConsumerOptions(
+    UserPointer<MojoDataPipeConsumerOptions> options,
+    uint32_t options_num_bytes) {
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return GetDataPipeConsumerOptionsImplNoLock(options, options_num_bytes);
+}
+
 MojoResult Dispatcher::DuplicateBufferHandle(
     UserPointer<const MojoDuplicateBufferHandleOptions> options,
     scoped_refptr<Dispatcher>* new_dispatcher) {
@@ -214,6 +330,38 @@ MojoResult Dispatcher::MapBuffer(
   return MapBufferImplNoLock(offset, num_bytes, flags, mapping);
 }
 
+MojoResult Dispatcher::AddWaitingDispatcher(
+    const scoped_refptr<Dispatcher>& dispatcher,
+    MojoHandle handle,
+    MojoHandleSignals signals) {
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return AddWaitingDispatcherImplNoLock(dispatcher, handle, signals);
+}
+
+MojoResult Dispatcher::RemoveWaitingDispatcher(MojoHandle handle) {
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return RemoveWaitingDispatcherImplNoLock(handle);
+}
+
+MojoResult Dispatcher::GetReadyHandles(
+    uint32_t max_count,
+    std::vector<MojoHandle>* handles,
+    std::vector<MojoResult>* results,
+    std::vector<HandleSignalsState>* signals_states) {
+  base::AutoLock locker(lock_);
+  if (is_closed_)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  return GetReadyHandlesImplNoLock(max_count, handles, results,
+                                   signals_states);
+}
+
 HandleSignalsState Dispatcher::GetHandleSignalsState() const {
   base::AutoLock locker(lock_);
   if (is_closed_)
@@ -281,6 +429,34 @@ MojoResult Dispatcher::WriteMessageImplNoLock(
   return MOJO_RESULT_INVALID_ARGUMENT;
 }
 
+MojoResult Dispatcher::WriteMessagesImplNoLock(
+    UserPointer<const void> /*bytes*/,
+    const uint32_t* /*message_num_bytes*/,
+    std::vector<DispatcherTransport>* /*transports*/,
+    const uint32_t* /*message_num_transports*/,
+    uint32_t /*num_messages*/,
+    MojoWriteMessageFlags /*flags*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for message pipe dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
+MojoResult Dispatcher::ReadMessagesImplNoLock(
+    UserPointer<void> /*bytes*/,
+    UserPointer<uint32_t> /*num_bytes*/,
+    DispatcherVector* /*dispatchers*/,
+    uint32_t* /*num_dispatchers*/,
+    UserPointer<uint32_t> /*message_num_bytes*/,
+    UserPointer<uint32_t> /*message_num_dispatchers*/,
+    UserPointer<uint32_t> /*num_messages*/,
+    MojoReadMessageFlags /*flags*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for message pipe dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
 MojoResult Dispatcher::ReadMessageImplNoLock(
     UserPointer<void> /*bytes*/,
     UserPointer<uint32_t> /*num_bytes*/,
@@ -293,6 +469,30 @@ MojoResult Dispatcher::ReadMessageImplNoLock(
   return MOJO_RESULT_INVALID_ARGUMENT;
 }
 
+MojoResult Dispatcher::WriteMessageContextImplNoLock(
+    uintptr_t /*context*/,
+    const MojoMessageContextThunks* /*thunks*/,
+    MojoWriteMessageFlags /*flags*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for message pipe dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
+MojoResult Dispatcher::ReadMessageContextImplNoLock(
+    const MojoMessageContextThunks* /*thunks*/,
+    uintptr_t* /*context*/,
+    UserPointer<void> /*bytes*/,
+    UserPointer<uint32_t> /*num_bytes*/,
+    DispatcherVector* /*dispatchers*/,
+    uint32_t* /*num_dispatchers*/,
+    MojoReadMessageFlags /*flags*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for message pipe dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
 MojoResult Dispatcher::WriteDataImplNoLock(UserPointer<const void> /*elements*/,
                                            UserPointer<uint32_t> /*num_bytes*/,
                                            MojoWriteDataFlags /*flags*/) {
@@ -319,6 +519,23 @@ MojoResult Dispatcher::EndWriteDataImplNoLock(uint32_t /*num_bytes_written*/) {
   return MOJO_RESULT_INVALID_ARGUMENT;
 }
 
+MojoResult Dispatcher::SetDataPipeProducerOptionsImplNoLock(
+    UserPointer<const MojoDataPipeProducerOptions> /*options*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for data pipe dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
+MojoResult Dispatcher::GetDataPipeProducerOptionsImplNoLock(
+    UserPointer<MojoDataPipeProducerOptions> /*options*/,
+    uint32_t /*options_num_bytes*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for data pipe dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
 MojoResult Dispatcher::ReadDataImplNoLock(UserPointer<void> /*elements*/,
                                           UserPointer<uint32_t> /*num_bytes*/,
                                           MojoReadDataFlags /*flags*/) {
@@ -345,6 +562,23 @@ MojoResult Dispatcher::EndReadDataImplNoLock(uint32_t /*num_bytes_read*/) {
   return MOJO_RESULT_INVALID_ARGUMENT;
 }
 
+MojoResult Dispatcher::SetDataPipeConsumerOptionsImplNoLock(
+    UserPointer<const MojoDataPipeConsumerOptions> /*options*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for data pipe dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
+MojoResult Dispatcher::GetDataPipeConsumerOptionsImplNoLock(
+    UserPointer<MojoDataPipeConsumerOptions> /*options*/,
+    uint32_t /*options_num_bytes*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for data pipe dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
 MojoResult Dispatcher::DuplicateBufferHandleImplNoLock(
     UserPointer<const MojoDuplicateBufferHandleOptions> /*options*/,
     scoped_refptr<Dispatcher>* /*new_dispatcher*/) {
@@ -365,6 +599,35 @@ MojoResult Dispatcher::MapBufferImplNoLock(
   return MOJO_RESULT_INVALID_ARGUMENT;
 }
 
+MojoResult Dispatcher::AddWaitingDispatcherImplNoLock(
+    const scoped_refptr<Dispatcher>& /*dispatcher*/,
+    MojoHandle /*handle*/,
+    MojoHandleSignals /*signals*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for wait set dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
+MojoResult Dispatcher::RemoveWaitingDispatcherImplNoLock(
+    MojoHandle /*handle*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for wait set dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
+MojoResult Dispatcher::GetReadyHandlesImplNoLock(
+    uint32_t /*max_count*/,
+    std::vector<MojoHandle>* /*handles*/,
+    std::vector<MojoResult>* /*results*/,
+    std::vector<HandleSignalsState>* /*signals_states*/) {
+  lock_.AssertAcquired();
+  DCHECK(!is_closed_);
+  // By default, not supported. Only needed for wait set dispatchers.
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
 HandleSignalsState Dispatcher::GetHandleSignalsStateImplNoLock() const {
   lock_.AssertAcquired();
   DCHECK(!is_closed_);
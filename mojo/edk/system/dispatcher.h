@@ -66,6 +66,7 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
     DATA_PIPE_PRODUCER,
     DATA_PIPE_CONSUMER,
     SHARED_BUFFER,
+    WAIT_SET,
 
     // "Private" types (not exposed via the public interface):
     PLATFORM_HANDLE = -1
@@ -89,6 +90,16 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
                           uint32_t num_bytes,
                           std::vector<DispatcherTransport>* transports,
                           MojoWriteMessageFlags flags);
+  // Like |WriteMessage()|, but writes |num_messages| messages (see
+  // |MojoWriteMessages()|). |transports| (if non-null) holds the transports
+  // for all the messages, and |message_num_transports| (which must then be
+  // non-null) the number for each message.
+  MojoResult WriteMessages(UserPointer<const void> bytes,
+                           const uint32_t* message_num_bytes,
+                           std::vector<DispatcherTransport>* transports,
+                           const uint32_t* message_num_transports,
+                           uint32_t num_messages,
+                           MojoWriteMessageFlags flags);
   // |dispatchers| must be non-null but empty, if |num_dispatchers| is non-null
   // and nonzero. On success, it will be set to the dispatchers to be received
   // (and assigned handles) as part of the message.
@@ -97,6 +108,34 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
                          DispatcherVector* dispatchers,
                          uint32_t* num_dispatchers,
                          MojoReadMessageFlags flags);
+  // Like |ReadMessage()|, but reads up to |*num_messages| messages (see
+  // |MojoReadMessages()|). The dispatchers for all the messages are appended to
+  // |dispatchers|, and |*num_dispatchers| is set to their total number.
+  MojoResult ReadMessages(UserPointer<void> bytes,
+                          UserPointer<uint32_t> num_bytes,
+                          DispatcherVector* dispatchers,
+                          uint32_t* num_dispatchers,
+                          UserPointer<uint32_t> message_num_bytes,
+                          UserPointer<uint32_t> message_num_dispatchers,
+                          UserPointer<uint32_t> num_messages,
+                          MojoReadMessageFlags flags);
+  // Writes a message given by a context (see |MojoWriteMessageContext()|).
+  // |thunks| must already have been validated. On success, the context is
+  // owned by the message pipe (on failure, it's still owned by the caller).
+  MojoResult WriteMessageContext(uintptr_t context,
+                                 const MojoMessageContextThunks* thunks,
+                                 MojoWriteMessageFlags flags);
+  // Like |ReadMessage()|, but if the next message has a context written with
+  // the same |thunks| (see |MojoReadMessageContext()|), sets |*context| to it
+  // (transferring ownership) instead of reading the message's data. Otherwise
+  // sets |*context| to zero.
+  MojoResult ReadMessageContext(const MojoMessageContextThunks* thunks,
+                                uintptr_t* context,
+                                UserPointer<void> bytes,
+                                UserPointer<uint32_t> num_bytes,
+                                DispatcherVector* dispatchers,
+                                uint32_t* num_dispatchers,
+                                MojoReadMessageFlags flags);
   MojoResult WriteData(UserPointer<const void> elements,
                        UserPointer<uint32_t> elements_num_bytes,
                        MojoWriteDataFlags flags);
@@ -104,6 +143,11 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
                             UserPointer<uint32_t> buffer_num_bytes,
                             MojoWriteDataFlags flags);
   MojoResult EndWriteData(uint32_t num_bytes_written);
+  MojoResult SetDataPipeProducerOptions(
+      UserPointer<const MojoDataPipeProducerOptions> options);
+  MojoResult GetDataPipeProducerOptions(
+      UserPointer<MojoDataPipeProducerOptions> options,
+      uint32_t options_num_bytes);
   MojoResult ReadData(UserPointer<void> elements,
                       UserPointer<uint32_t> num_bytes,
                       MojoReadDataFlags flags);
@@ -111,6 +155,11 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
                            UserPointer<uint32_t> buffer_num_bytes,
                            MojoReadDataFlags flags);
   MojoResult EndReadData(uint32_t num_bytes_read);
+  MojoResult SetDataPipeConsumerOptions(
+      UserPointer<const MojoDataPipeConsumerOptions> options);
+  MojoResult GetDataPipeConsumerOptions(
+      UserPointer<MojoDataPipeConsumerOptions> options,
+      uint32_t options_num_bytes);
   // |options| may be null. |new_dispatcher| must not be null, but
   // |*new_dispatcher| should be null (and will contain the dispatcher for the
   // new handle on success).
@@ -122,6 +171,18 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
       uint64_t num_bytes,
       MojoMapBufferFlags flags,
       scoped_ptr<embedder::PlatformSharedBufferMapping>* mapping);
+  // These are only implemented by wait sets. |dispatcher| is the dispatcher for
+  // |handle| (and must not be |this|). |GetReadyHandles()| appends at most
+  // |max_count| (which must be nonzero) ready handles to |handles|, and their
+  // results and signals states to |results| and |signals_states|.
+  MojoResult AddWaitingDispatcher(const scoped_refptr<Dispatcher>& dispatcher,
+                                  MojoHandle handle,
+                                  MojoHandleSignals signals);
+  MojoResult RemoveWaitingDispatcher(MojoHandle handle);
+  MojoResult GetReadyHandles(uint32_t max_count,
+                             std::vector<MojoHandle>* handles,
+                             std::vector<MojoResult>* results,
+                             std::vector<HandleSignalsState>* signals_states);
 
   // Gets the current handle signals state. (The default implementation simply
   // returns a default-constructed |HandleSignalsState|, i.e., no signals
@@ -168,9 +229,10 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
     // Tests also need this, to avoid needing |Core|.
     friend DispatcherTransport test::DispatcherTryStartTransport(Dispatcher*);
 
-    // This must be called under the handle table lock and only if the handle
-    // table entry is not marked busy. The caller must maintain a reference to
-    // |dispatcher| until |DispatcherTransport::End()| is called.
+    // This must be called under the handle table (shard) lock for the handle
+    // and only if the handle table entry is not marked busy. The caller must
+    // maintain a reference to |dispatcher| until |DispatcherTransport::End()|
+    // is called.
     static DispatcherTransport TryStartTransport(Dispatcher* dispatcher);
   };
 
@@ -238,11 +300,39 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
       uint32_t num_bytes,
       std::vector<DispatcherTransport>* transports,
       MojoWriteMessageFlags flags);
+  virtual MojoResult WriteMessagesImplNoLock(
+      UserPointer<const void> bytes,
+      const uint32_t* message_num_bytes,
+      std::vector<DispatcherTransport>* transports,
+      const uint32_t* message_num_transports,
+      uint32_t num_messages,
+      MojoWriteMessageFlags flags);
   virtual MojoResult ReadMessageImplNoLock(UserPointer<void> bytes,
                                            UserPointer<uint32_t> num_bytes,
                                            DispatcherVector* dispatchers,
                                            uint32_t* num_dispatchers,
                                            MojoReadMessageFlags flags);
+  virtual MojoResult ReadMessagesImplNoLock(
+      UserPointer<void> bytes,
+      UserPointer<uint32_t> num_bytes,
+      DispatcherVector* dispatchers,
+      uint32_t* num_dispatchers,
+      UserPointer<uint32_t> message_num_bytes,
+      UserPointer<uint32_t> message_num_dispatchers,
+      UserPointer<uint32_t> num_messages,
+      MojoReadMessageFlags flags);
+  virtual MojoResult WriteMessageContextImplNoLock(
+      uintptr_t context,
+      const MojoMessageContextThunks* thunks,
+      MojoWriteMessageFlags flags);
+  virtual MojoResult ReadMessageContextImplNoLock(
+      const MojoMessageContextThunks* thunks,
+      uintptr_t* context,
+      UserPointer<void> bytes,
+      UserPointer<uint32_t> num_bytes,
+      DispatcherVector* dispatchers,
+      uint32_t* num_dispatchers,
+      MojoReadMessageFlags flags);
   virtual MojoResult WriteDataImplNoLock(UserPointer<const void> elements,
                                          UserPointer<uint32_t> num_bytes,
                                          MojoWriteDataFlags flags);
@@ -251,6 +341,11 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
       UserPointer<uint32_t> buffer_num_bytes,
       MojoWriteDataFlags flags);
   virtual MojoResult EndWriteDataImplNoLock(uint32_t num_bytes_written);
+  virtual MojoResult SetDataPipeProducerOptionsImplNoLock(
+      UserPointer<const MojoDataPipeProducerOptions> options);
+  virtual MojoResult GetDataPipeProducerOptionsImplNoLock(
+      UserPointer<MojoDataPipeProducerOptions> options,
+      uint32_t options_num_bytes);
   virtual MojoResult ReadDataImplNoLock(UserPointer<void> elements,
                                         UserPointer<uint32_t> num_bytes,
                                         MojoReadDataFlags flags);
@@ -259,6 +354,11 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
       UserPointer<uint32_t> buffer_num_bytes,
       MojoReadDataFlags flags);
   virtual MojoResult EndReadDataImplNoLock(uint32_t num_bytes_read);
+  virtual MojoResult SetDataPipeConsumerOptionsImplNoLock(
+      UserPointer<const MojoDataPipeConsumerOptions> options);
+  virtual MojoResult GetDataPipeConsumerOptionsImplNoLock(
+      UserPointer<MojoDataPipeConsumerOptions> options,
+      uint32_t options_num_bytes);
   virtual MojoResult DuplicateBufferHandleImplNoLock(
       UserPointer<const MojoDuplicateBufferHandleOptions> options,
       scoped_refptr<Dispatcher>* new_dispatcher);
@@ -267,6 +367,16 @@ class MOJO_SYSTEM_IMPL_EXPORT Dispatcher
       uint64_t num_bytes,
       MojoMapBufferFlags flags,
       scoped_ptr<embedder::PlatformSharedBufferMapping>* mapping);
+  virtual MojoResult AddWaitingDispatcherImplNoLock(
+      const scoped_refptr<Dispatcher>& dispatcher,
+      MojoHandle handle,
+      MojoHandleSignals signals);
+  virtual MojoResult RemoveWaitingDispatcherImplNoLock(MojoHandle handle);
+  virtual MojoResult GetReadyHandlesImplNoLock(
+      uint32_t max_count,
+      std::vector<MojoHandle>* handles,
+      std::vector<MojoResult>* results,
+      std::vector<HandleSignalsState>* signals_states);
   virtual HandleSignalsState GetHandleSignalsStateImplNoLock() const;
   virtual MojoResult AddAwakableImplNoLock(Awakable* awakable,
                                            MojoHandleSignals signals,
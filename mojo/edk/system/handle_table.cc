@@ -13,6 +13,9 @@
 namespace mojo {
 namespace system {
 
+// static
+const size_t HandleTable::kNumShards;
+
 HandleTable::Entry::Entry() : busy(false) {
 }
 
@@ -24,7 +27,15 @@ HandleTable::Entry::~Entry() {
   DCHECK(!busy);
 }
 
-HandleTable::HandleTable() : next_handle_(MOJO_HANDLE_INVALID + 1) {
+HandleTable::Shard::Shard() {
+}
+
+HandleTable::Shard::~Shard() {
+}
+
+HandleTable::HandleTable() : size_(0), last_handle_(MOJO_HANDLE_INVALID) {
+  static_assert((kNumShards & (kNumShards - 1)) == 0,
+                "kNumShards must be a power of 2");
 }
 
 HandleTable::~HandleTable() {
@@ -32,13 +43,15 @@ HandleTable::~HandleTable() {
   // the singleton |Core|, which lives forever), except in tests.
 }
 
-Dispatcher* HandleTable::GetDispatcher(MojoHandle handle) {
+scoped_refptr<Dispatcher> HandleTable::GetDispatcher(MojoHandle handle) {
   DCHECK_NE(handle, MOJO_HANDLE_INVALID);
 
-  HandleToEntryMap::iterator it = handle_to_entry_map_.find(handle);
-  if (it == handle_to_entry_map_.end())
+  Shard& shard = GetShard(handle);
+  base::AutoLock locker(shard.lock);
+  HandleToEntryMap::iterator it = shard.handle_to_entry_map.find(handle);
+  if (it == shard.handle_to_entry_map.end())
     return nullptr;
-  return it->second.dispatcher.get();
+  return it->second.dispatcher;
 }
 
 MojoResult HandleTable::GetAndRemoveDispatcher(
@@ -47,20 +60,25 @@ MojoResult HandleTable::GetAndRemoveDispatcher(
   DCHECK_NE(handle, MOJO_HANDLE_INVALID);
   DCHECK(dispatcher);
 
-  HandleToEntryMap::iterator it = handle_to_entry_map_.find(handle);
-  if (it == handle_to_entry_map_.end())
-    return MOJO_RESULT_INVALID_ARGUMENT;
-  if (it->second.busy)
-    return MOJO_RESULT_BUSY;
-  *dispatcher = it->second.dispatcher;
-  handle_to_entry_map_.erase(it);
+  {
+    Shard& shard = GetShard(handle);
+    base::AutoLock locker(shard.lock);
+    HandleToEntryMap::iterator it = shard.handle_to_entry_map.find(handle);
+    if (it == shard.handle_to_entry_map.end())
+      return MOJO_RESULT_INVALID_ARGUMENT;
+    if (it->second.busy)
+      return MOJO_RESULT_BUSY;
+    *dispatcher = it->second.dispatcher;
+    shard.handle_to_entry_map.erase(it);
+  }
+  Unreserve(1);
 
   return MOJO_RESULT_OK;
 }
 
 MojoHandle HandleTable::AddDispatcher(
     const scoped_refptr<Dispatcher>& dispatcher) {
-  if (handle_to_entry_map_.size() >= GetConfiguration().max_handle_table_size)
+  if (!TryReserve(1))
     return MOJO_HANDLE_INVALID;
   return AddDispatcherNoSizeCheck(dispatcher);
 }
@@ -68,8 +86,7 @@ MojoHandle HandleTable::AddDispatcher(
 std::pair<MojoHandle, MojoHandle> HandleTable::AddDispatcherPair(
     const scoped_refptr<Dispatcher>& dispatcher0,
     const scoped_refptr<Dispatcher>& dispatcher1) {
-  if (handle_to_entry_map_.size() + 1 >=
-      GetConfiguration().max_handle_table_size)
+  if (!TryReserve(2))
     return std::make_pair(MOJO_HANDLE_INVALID, MOJO_HANDLE_INVALID);
   return std::make_pair(AddDispatcherNoSizeCheck(dispatcher0),
                         AddDispatcherNoSizeCheck(dispatcher1));
@@ -87,7 +104,12 @@ bool HandleTable::AddDispatcherVector(const DispatcherVector& dispatchers,
       std::numeric_limits<size_t>::max())
       << "Addition may overflow";
 
-  if (handle_to_entry_map_.size() + dispatchers.size() > max_handle_table_size)
+  size_t num_valid_dispatchers = 0;
+  for (size_t i = 0; i < dispatchers.size(); i++) {
+    if (dispatchers[i])
+      num_valid_dispatchers++;
+  }
+  if (!TryReserve(num_valid_dispatchers))
     return false;
 
   for (size_t i = 0; i < dispatchers.size(); i++) {
@@ -112,9 +134,8 @@ MojoResult HandleTable::MarkBusyAndStartTransport(
   DCHECK(transports);
   DCHECK_EQ(transports->size(), num_handles);
 
-  std::vector<Entry*> entries(num_handles);
-
-  // First verify all the handles and get their dispatchers.
+  // Verify all the handles, mark them as busy, and start transport on their
+  // dispatchers (one at a time, each under its shard's lock).
   uint32_t i;
   MojoResult error_result = MOJO_RESULT_INTERNAL;
   for (i = 0; i < num_handles; i++) {
@@ -125,34 +146,31 @@ MojoResult HandleTable::MarkBusyAndStartTransport(
       break;
     }
 
-    HandleToEntryMap::iterator it = handle_to_entry_map_.find(handles[i]);
-    if (it == handle_to_entry_map_.end()) {
+    Shard& shard = GetShard(handles[i]);
+    base::AutoLock locker(shard.lock);
+    HandleToEntryMap::iterator it = shard.handle_to_entry_map.find(handles[i]);
+    if (it == shard.handle_to_entry_map.end()) {
       error_result = MOJO_RESULT_INVALID_ARGUMENT;
       break;
     }
 
-    entries[i] = &it->second;
-    if (entries[i]->busy) {
+    Entry* entry = &it->second;
+    if (entry->busy) {
       error_result = MOJO_RESULT_BUSY;
       break;
     }
-    // Note: By marking the handle as busy here, we're also preventing the
-    // same handle from being sent multiple times in the same message.
-    entries[i]->busy = true;
 
-    // Try to start the transport.
+    // Try to start the transport. (This only tries to take the dispatcher's
+    // lock, so it's okay to do under the shard lock.)
     DispatcherTransport transport =
         Dispatcher::HandleTableAccess::TryStartTransport(
-            entries[i]->dispatcher.get());
+            entry->dispatcher.get());
     if (!transport.is_valid()) {
       // Only log for Debug builds, since this is not a problem with the system
       // code, but with user code.
       DLOG(WARNING) << "Likely race condition in user code detected: attempt "
                        "to transfer handle " << handles[i]
                     << " while it is in use on a different thread";
-
-      // Unset the busy flag (since it won't be unset below).
-      entries[i]->busy = false;
       error_result = MOJO_RESULT_BUSY;
       break;
     }
@@ -160,25 +178,25 @@ MojoResult HandleTable::MarkBusyAndStartTransport(
     // Check if the dispatcher is busy (e.g., in a two-phase read/write).
     // (Note that this must be done after the dispatcher's lock is acquired.)
     if (transport.IsBusy()) {
-      // Unset the busy flag and end the transport (since it won't be done
-      // below).
-      entries[i]->busy = false;
       transport.End();
       error_result = MOJO_RESULT_BUSY;
       break;
     }
 
+    // Note: By marking the handle as busy here, we're also preventing the
+    // same handle from being sent multiple times in the same message.
+    entry->busy = true;
+
     // Hang on to the transport (which we'll need to end the transport).
     (*transports)[i] = transport;
   }
   if (i < num_handles) {
     DCHECK_NE(error_result, MOJO_RESULT_INTERNAL);
 
-    // Unset the busy flags and release the locks.
+    // Release the locks and unset the busy flags.
     for (uint32_t j = 0; j < i; j++) {
-      DCHECK(entries[j]->busy);
-      entries[j]->busy = false;
       (*transports)[j].End();
+      UnmarkBusyHandle(handles[j], false);
     }
     return error_result;
   }
@@ -186,30 +204,61 @@ MojoResult HandleTable::MarkBusyAndStartTransport(
   return MOJO_RESULT_OK;
 }
 
+bool HandleTable::TryReserve(size_t count) {
+  size_t max_handle_table_size = GetConfiguration().max_handle_table_size;
+  base::subtle::Atomic32 old_size = base::subtle::NoBarrier_Load(&size_);
+  for (;;) {
+    if (static_cast<size_t>(old_size) + count > max_handle_table_size)
+      return false;
+    base::subtle::Atomic32 new_size =
+        old_size + static_cast<base::subtle::Atomic32>(count);
+    base::subtle::Atomic32 prev_size =
+        base::subtle::NoBarrier_CompareAndSwap(&size_, old_size, new_size);
+    if (prev_size == old_size)
+      return true;
+    old_size = prev_size;
+  }
+}
+
+void HandleTable::Unreserve(size_t count) {
+  base::subtle::Atomic32 new_size = base::subtle::NoBarrier_AtomicIncrement(
+      &size_, -static_cast<base::subtle::Atomic32>(count));
+  DCHECK_GE(new_size, 0);
+}
+
 MojoHandle HandleTable::AddDispatcherNoSizeCheck(
     const scoped_refptr<Dispatcher>& dispatcher) {
   DCHECK(dispatcher);
-  DCHECK_LT(handle_to_entry_map_.size(),
+  DCHECK_LE(static_cast<size_t>(base::subtle::NoBarrier_Load(&size_)),
             GetConfiguration().max_handle_table_size);
-  DCHECK_NE(next_handle_, MOJO_HANDLE_INVALID);
 
   // TODO(vtl): Maybe we want to do something different/smarter. (Or maybe try
   // assigning randomly?)
-  while (handle_to_entry_map_.find(next_handle_) !=
-         handle_to_entry_map_.end()) {
-    next_handle_++;
-    if (next_handle_ == MOJO_HANDLE_INVALID)
-      next_handle_++;
+  for (;;) {
+    MojoHandle new_handle = static_cast<MojoHandle>(
+        base::subtle::NoBarrier_AtomicIncrement(&last_handle_, 1));
+    if (new_handle == MOJO_HANDLE_INVALID)
+      continue;
+
+    Shard& shard = GetShard(new_handle);
+    base::AutoLock locker(shard.lock);
+    // The handle may only already be in use if |last_handle_| wrapped around.
+    if (shard.handle_to_entry_map.insert(std::make_pair(new_handle,
+                                                        Entry(dispatcher)))
+            .second)
+      return new_handle;
   }
+}
 
-  MojoHandle new_handle = next_handle_;
-  handle_to_entry_map_[new_handle] = Entry(dispatcher);
-
-  next_handle_++;
-  if (next_handle_ == MOJO_HANDLE_INVALID)
-    next_handle_++;
-
-  return new_handle;
+void HandleTable::UnmarkBusyHandle(MojoHandle handle, bool remove) {
+  Shard& shard = GetShard(handle);
+  base::AutoLock locker(shard.lock);
+  HandleToEntryMap::iterator it = shard.handle_to_entry_map.find(handle);
+  DCHECK(it != shard.handle_to_entry_map.end());
+  DCHECK(it->second.busy);
+  it->second.busy = false;  // (Also for the sake of a |DCHECK()|.)
+  if (remove)
+    shard.handle_to_entry_map.erase(it);
 }
 
 void HandleTable::RemoveBusyHandles(const MojoHandle* handles,
@@ -217,13 +266,9 @@ void HandleTable::RemoveBusyHandles(const MojoHandle* handles,
   DCHECK(handles);
   DCHECK_LE(num_handles, GetConfiguration().max_message_num_handles);
 
-  for (uint32_t i = 0; i < num_handles; i++) {
-    HandleToEntryMap::iterator it = handle_to_entry_map_.find(handles[i]);
-    DCHECK(it != handle_to_entry_map_.end());
-    DCHECK(it->second.busy);
-    it->second.busy = false;  // For the sake of a |DCHECK()|.
-    handle_to_entry_map_.erase(it);
-  }
+  for (uint32_t i = 0; i < num_handles; i++)
+    UnmarkBusyHandle(handles[i], true);
+  Unreserve(num_handles);
 }
 
 void HandleTable::RestoreBusyHandles(const MojoHandle* handles,
@@ -231,12 +276,8 @@ void HandleTable::RestoreBusyHandles(const MojoHandle* handles,
   DCHECK(handles);
   DCHECK_LE(num_handles, GetConfiguration().max_message_num_handles);
 
-  for (uint32_t i = 0; i < num_handles; i++) {
-    HandleToEntryMap::iterator it = handle_to_entry_map_.find(handles[i]);
-    DCHECK(it != handle_to_entry_map_.end());
-    DCHECK(it->second.busy);
-    it->second.busy = false;
-  }
+  for (uint32_t i = 0; i < num_handles; i++)
+    UnmarkBusyHandle(handles[i], false);
 }
 
 }  // namespace system
@@ -8,9 +8,11 @@
 #include <utility>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/containers/hash_tables.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
 #include "mojo/edk/system/system_impl_export.h"
 #include "mojo/public/c/system/types.h"
 
@@ -33,9 +35,22 @@ bool ShutdownCheckNoLeaks(Core*);
 // (valid) |MojoHandle|s to |Dispatcher|s. This is abstracted so that, e.g.,
 // caching may be added.
 //
-// This class is NOT thread-safe; locking is left to |Core| (since it may need
-// to make several changes -- "atomically" or in rapid successsion, in which
-// case the extra locking/unlocking would be unnecessary overhead).
+// This class is thread-safe. To avoid a single global lock (which every Mojo
+// system call would otherwise contend on), the table is split into
+// |kNumShards| shards, each with its own lock; a handle's shard is determined
+// by its low bits. Handles are allocated from a single (atomic) counter, so
+// consecutively-allocated handles land in different shards, and handle values
+// are not reused until the counter wraps around (so a stale handle fails
+// lookup instead of silently referring to a newer dispatcher). Operations on
+// several handles (e.g., |MarkBusyAndStartTransport()|) are not atomic with
+// respect to each other; the "busy" mechanism (see |Entry| below) provides the
+// guarantees |Core| needs.
+//
+// Lock order: Shard locks come after |Dispatcher| locks (see core.cc), since
+// |MarkBusyAndStartTransport()| takes each handle's shard lock while holding
+// the locks of the dispatchers it has already started transport on. At most
+// one shard lock is held at a time, and while holding one, |Dispatcher| locks
+// may only be taken with |Try()|.
 
 class MOJO_SYSTEM_IMPL_EXPORT HandleTable {
  public:
@@ -45,10 +60,7 @@ class MOJO_SYSTEM_IMPL_EXPORT HandleTable {
   // Gets the dispatcher for a given handle (which should not be
   // |MOJO_HANDLE_INVALID|). Returns null if there's no dispatcher for the given
   // handle.
-  // WARNING: For efficiency, this returns a dumb pointer. If you're going to
-  // use the result outside |Core|'s lock, you MUST take a reference (e.g., by
-  // storing the result inside a |scoped_refptr|).
-  Dispatcher* GetDispatcher(MojoHandle handle);
+  scoped_refptr<Dispatcher> GetDispatcher(MojoHandle handle);
 
   // On success, gets the dispatcher for a given handle (which should not be
   // |MOJO_HANDLE_INVALID|) and removes it. (On failure, returns an appropriate
@@ -104,15 +116,14 @@ class MOJO_SYSTEM_IMPL_EXPORT HandleTable {
   // The |busy| member is used only to deal with functions (in particular
   // |Core::WriteMessage()|) that want to hold on to a dispatcher and later
   // remove it from the handle table, without holding on to the handle table
-  // lock.
+  // locks.
   //
   // For example, if |Core::WriteMessage()| is called with a handle to be sent,
-  // (under the handle table lock) it must first check that that handle is not
-  // busy (if it is busy, then it fails with |MOJO_RESULT_BUSY|) and then marks
-  // it as busy. To avoid deadlock, it should also try to acquire the locks for
-  // all the dispatchers for the handles that it is sending (and fail with
-  // |MOJO_RESULT_BUSY| if the attempt fails). At this point, it can release the
-  // handle table lock.
+  // (under the handle's shard lock) it must first check that that handle is
+  // not busy (if it is busy, then it fails with |MOJO_RESULT_BUSY|) and then
+  // marks it as busy. To avoid deadlock, it should also try to acquire the lock
+  // for the handle's dispatcher (and fail with |MOJO_RESULT_BUSY| if the
+  // attempt fails). At this point, it can release the shard lock.
   //
   // If |Core::Close()| is simultaneously called on that handle, it too checks
   // if the handle is marked busy. If it is, it fails (with |MOJO_RESULT_BUSY|).
@@ -128,12 +139,42 @@ class MOJO_SYSTEM_IMPL_EXPORT HandleTable {
   };
   using HandleToEntryMap = base::hash_map<MojoHandle, Entry>;
 
-  // Adds the given dispatcher to the handle table, not doing any size checks.
+  // Must be a power of 2.
+  static const size_t kNumShards = 32;
+
+  struct Shard {
+    Shard();
+    ~Shard();
+
+    base::Lock lock;  // Protects |handle_to_entry_map|.
+    HandleToEntryMap handle_to_entry_map;
+  };
+
+  Shard& GetShard(MojoHandle handle) {
+    return shards_[handle & (kNumShards - 1)];
+  }
+
+  // Tries to reserve space for |count| more handles, returning false (and
+  // reserving nothing) if that would make the table exceed its maximum size.
+  bool TryReserve(size_t count);
+  // Releases space for |count| handles (reserved using |TryReserve()|).
+  void Unreserve(size_t count);
+
+  // Adds the given dispatcher to the handle table, not doing any size checks
+  // (space for it must have been reserved using |TryReserve()|).
   MojoHandle AddDispatcherNoSizeCheck(
       const scoped_refptr<Dispatcher>& dispatcher);
 
-  HandleToEntryMap handle_to_entry_map_;
-  MojoHandle next_handle_;  // Invariant: never |MOJO_HANDLE_INVALID|.
+  // Marks the busy handle |handle| as not busy, and removes it if |remove| is
+  // true.
+  void UnmarkBusyHandle(MojoHandle handle, bool remove);
+
+  Shard shards_[kNumShards];
+  // The number of handles in the table (or reserved to be added).
+  base::subtle::Atomic32 size_;
+  // The last handle value allocated. (Handle values are allocated by
+  // incrementing this, skipping |MOJO_HANDLE_INVALID|.)
+  base::subtle::Atomic32 last_handle_;
 
   DISALLOW_COPY_AND_ASSIGN(HandleTable);
 };
@@ -5,6 +5,7 @@
 #include "mojo/edk/system/incoming_endpoint.h"
 
 #include "base/logging.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
 #include "mojo/edk/system/channel_endpoint.h"
 #include "mojo/edk/system/data_pipe.h"
 #include "mojo/edk/system/message_in_transit.h"
@@ -34,20 +35,27 @@ scoped_refptr<MessagePipe> IncomingEndpoint::ConvertToMessagePipe() {
 
 scoped_refptr<DataPipe> IncomingEndpoint::ConvertToDataPipeProducer(
     const MojoCreateDataPipeOptions& validated_options,
-    size_t consumer_num_bytes) {
+    size_t consumer_num_bytes,
+    scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+    size_t shared_ring_write_index) {
   base::AutoLock locker(lock_);
   scoped_refptr<DataPipe> data_pipe(DataPipe::CreateRemoteConsumerFromExisting(
-      validated_options, consumer_num_bytes, &message_queue_, endpoint_.get()));
+      validated_options, consumer_num_bytes, shared_ring,
+      shared_ring_write_index, &message_queue_, endpoint_.get()));
   DCHECK(message_queue_.IsEmpty());
   endpoint_ = nullptr;
   return data_pipe;
 }
 
 scoped_refptr<DataPipe> IncomingEndpoint::ConvertToDataPipeConsumer(
-    const MojoCreateDataPipeOptions& validated_options) {
+    const MojoCreateDataPipeOptions& validated_options,
+    scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+    size_t shared_ring_start_index,
+    size_t shared_ring_num_bytes) {
   base::AutoLock locker(lock_);
   scoped_refptr<DataPipe> data_pipe(DataPipe::CreateRemoteProducerFromExisting(
-      validated_options, &message_queue_, endpoint_.get()));
+      validated_options, shared_ring, shared_ring_start_index,
+      shared_ring_num_bytes, &message_queue_, endpoint_.get()));
   DCHECK(message_queue_.IsEmpty());
   endpoint_ = nullptr;
   return data_pipe;
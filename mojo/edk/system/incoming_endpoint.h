@@ -17,6 +17,11 @@
 struct MojoCreateDataPipeOptions;
 
 namespace mojo {
+
+namespace embedder {
+class PlatformSharedBuffer;
+}
+
 namespace system {
 
 class ChannelEndpoint;
@@ -34,11 +39,19 @@ class MOJO_SYSTEM_IMPL_EXPORT IncomingEndpoint : public ChannelEndpointClient {
   scoped_refptr<ChannelEndpoint> Init();
 
   scoped_refptr<MessagePipe> ConvertToMessagePipe();
+  // See |DataPipe::CreateRemoteConsumerFromExisting()| and
+  // |DataPipe::CreateRemoteProducerFromExisting()|, respectively, for the
+  // meaning of the |shared_ring...| arguments.
   scoped_refptr<DataPipe> ConvertToDataPipeProducer(
       const MojoCreateDataPipeOptions& validated_options,
-      size_t consumer_num_bytes);
+      size_t consumer_num_bytes,
+      scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+      size_t shared_ring_write_index);
   scoped_refptr<DataPipe> ConvertToDataPipeConsumer(
-      const MojoCreateDataPipeOptions& validated_options);
+      const MojoCreateDataPipeOptions& validated_options,
+      scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+      size_t shared_ring_start_index,
+      size_t shared_ring_num_bytes);
 
   // Must be called before destroying this object if |ConvertToMessagePipe()|
   // wasn't called (but |Init()| was).
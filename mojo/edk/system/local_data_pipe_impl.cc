@@ -17,6 +17,7 @@
 #include "base/compiler_specific.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
 #include "mojo/edk/system/channel.h"
 #include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/data_pipe.h"
@@ -146,10 +147,15 @@ MojoResult LocalDataPipeImpl::ProducerEndWriteData(uint32_t num_bytes_written) {
 HandleSignalsState LocalDataPipeImpl::ProducerGetHandleSignalsState() const {
   HandleSignalsState rv;
   if (consumer_open()) {
-    if (current_num_bytes_ < capacity_num_bytes() &&
-        !producer_in_two_phase_write())
-      rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_WRITABLE;
-    rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_WRITABLE;
+    if (!producer_in_two_phase_write()) {
+      size_t num_bytes_available = capacity_num_bytes() - current_num_bytes_;
+      if (num_bytes_available > 0)
+        rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_WRITABLE;
+      if (num_bytes_available >= producer_write_threshold_num_bytes())
+        rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD;
+    }
+    rv.satisfiable_signals |=
+        MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD;
   } else {
     rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_PEER_CLOSED;
   }
@@ -162,7 +168,7 @@ void LocalDataPipeImpl::ProducerStartSerialize(Channel* channel,
                                                size_t* max_platform_handles) {
   *max_size = sizeof(SerializedDataPipeProducerDispatcher) +
               channel->GetSerializedEndpointSize();
-  *max_platform_handles = 0;
+  *max_platform_handles = ShouldUseSharedRing(capacity_num_bytes()) ? 1 : 0;
 }
 
 bool LocalDataPipeImpl::ProducerEndSerialize(
@@ -172,7 +178,9 @@ bool LocalDataPipeImpl::ProducerEndSerialize(
     embedder::PlatformHandleVector* platform_handles) {
   SerializedDataPipeProducerDispatcher* s =
       static_cast<SerializedDataPipeProducerDispatcher*>(destination);
-  s->validated_options = validated_options();
+  s->validated_options = current_options();
+  s->shared_ring_platform_handle_index = kNoSharedRingPlatformHandleIndex;
+  s->shared_ring_write_index = 0;
   void* destination_for_endpoint = static_cast<char*>(destination) +
                                    sizeof(SerializedDataPipeProducerDispatcher);
 
@@ -186,16 +194,48 @@ bool LocalDataPipeImpl::ProducerEndSerialize(
   // Case 2: The consumer isn't closed. We'll replace ourselves with a
   // |RemoteProducerDataPipeImpl|.
 
+  // If the data pipe is large enough, the remote producer will write directly
+  // into a shared ring (otherwise, or if we fail to set one up, it'll send us
+  // the data in messages). The current data is moved to the same place in the
+  // ring.
+  scoped_refptr<embedder::PlatformSharedBuffer> shared_ring;
+  scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping;
+  if (ShouldUseSharedRing(capacity_num_bytes()) &&
+      CreateSharedRing(channel, capacity_num_bytes(), &shared_ring,
+                       &shared_ring_mapping) &&
+      SerializeSharedRing(shared_ring.get(), platform_handles,
+                          &s->shared_ring_platform_handle_index)) {
+    char* ring = static_cast<char*>(shared_ring_mapping->GetBase());
+    size_t num_bytes_first = GetMaxNumBytesToRead();
+    if (num_bytes_first > 0) {
+      memcpy(ring + start_index_, buffer_.get() + start_index_,
+             num_bytes_first);
+    }
+    if (num_bytes_first < current_num_bytes_)
+      memcpy(ring, buffer_.get(), current_num_bytes_ - num_bytes_first);
+    s->shared_ring_write_index = static_cast<uint32_t>(
+        (start_index_ + current_num_bytes_) % capacity_num_bytes());
+    DestroyBuffer();
+  }
+
   s->consumer_num_bytes = current_num_bytes_;
   // Note: We don't use |port|.
   scoped_refptr<ChannelEndpoint> channel_endpoint =
       channel->SerializeEndpointWithLocalPeer(destination_for_endpoint, nullptr,
                                               owner(), 0);
+  scoped_ptr<DataPipeImpl> new_impl;
+  if (shared_ring) {
+    new_impl.reset(new RemoteProducerDataPipeImpl(
+        channel_endpoint.get(), shared_ring, shared_ring_mapping.Pass(),
+        start_index_, current_num_bytes_));
+  } else {
+    new_impl.reset(new RemoteProducerDataPipeImpl(
+        channel_endpoint.get(), buffer_.Pass(), start_index_,
+        current_num_bytes_));
+  }
   // Note: Keep |*this| alive until the end of this method, to make things
   // slightly easier on ourselves.
-  scoped_ptr<DataPipeImpl> self(owner()->ReplaceImplNoLock(make_scoped_ptr(
-      new RemoteProducerDataPipeImpl(channel_endpoint.get(), buffer_.Pass(),
-                                     start_index_, current_num_bytes_))));
+  scoped_ptr<DataPipeImpl> self(owner()->ReplaceImplNoLock(new_impl.Pass()));
 
   *actual_size = sizeof(SerializedDataPipeProducerDispatcher) +
                  channel->GetSerializedEndpointSize();
@@ -323,12 +363,19 @@ MojoResult LocalDataPipeImpl::ConsumerEndReadData(uint32_t num_bytes_read) {
 HandleSignalsState LocalDataPipeImpl::ConsumerGetHandleSignalsState() const {
   HandleSignalsState rv;
   if (current_num_bytes_ > 0) {
-    if (!consumer_in_two_phase_read())
+    if (!consumer_in_two_phase_read()) {
       rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_READABLE;
+      if (current_num_bytes_ >= consumer_read_threshold_num_bytes())
+        rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_READ_THRESHOLD;
+    }
     rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_READABLE;
   } else if (producer_open()) {
     rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_READABLE;
   }
+  // Once the producer is closed, the amount of data can only go down.
+  if (producer_open() ||
+      current_num_bytes_ >= consumer_read_threshold_num_bytes())
+    rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_READ_THRESHOLD;
   if (!producer_open())
     rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_PEER_CLOSED;
   rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_PEER_CLOSED;
@@ -340,7 +387,7 @@ void LocalDataPipeImpl::ConsumerStartSerialize(Channel* channel,
                                                size_t* max_platform_handles) {
   *max_size = sizeof(SerializedDataPipeConsumerDispatcher) +
               channel->GetSerializedEndpointSize();
-  *max_platform_handles = 0;
+  *max_platform_handles = ShouldUseSharedRing(capacity_num_bytes()) ? 1 : 0;
 }
 
 bool LocalDataPipeImpl::ConsumerEndSerialize(
@@ -350,14 +397,39 @@ bool LocalDataPipeImpl::ConsumerEndSerialize(
     embedder::PlatformHandleVector* platform_handles) {
   SerializedDataPipeConsumerDispatcher* s =
       static_cast<SerializedDataPipeConsumerDispatcher*>(destination);
-  s->validated_options = validated_options();
+  s->validated_options = current_options();
+  s->shared_ring_platform_handle_index = kNoSharedRingPlatformHandleIndex;
+  s->shared_ring_start_index = 0;
+  s->shared_ring_num_bytes = 0;
   void* destination_for_endpoint = static_cast<char*>(destination) +
                                    sizeof(SerializedDataPipeConsumerDispatcher);
 
   size_t old_num_bytes = current_num_bytes_;
   MessageInTransitQueue message_queue;
-  ConvertDataToMessages(buffer_.get(), &start_index_, &current_num_bytes_,
-                        &message_queue);
+  // If the producer is still open and the data pipe is large enough, we'll
+  // write directly into a shared ring (otherwise, or if we fail to set one up,
+  // we'll send the data in messages). The current data is moved to the start
+  // of the ring.
+  scoped_refptr<embedder::PlatformSharedBuffer> shared_ring;
+  scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping;
+  if (producer_open() && ShouldUseSharedRing(capacity_num_bytes()) &&
+      CreateSharedRing(channel, capacity_num_bytes(), &shared_ring,
+                       &shared_ring_mapping) &&
+      SerializeSharedRing(shared_ring.get(), platform_handles,
+                          &s->shared_ring_platform_handle_index)) {
+    char* ring = static_cast<char*>(shared_ring_mapping->GetBase());
+    size_t num_bytes_first = GetMaxNumBytesToRead();
+    if (num_bytes_first > 0)
+      memcpy(ring, buffer_.get() + start_index_, num_bytes_first);
+    if (num_bytes_first < current_num_bytes_) {
+      memcpy(ring + num_bytes_first, buffer_.get(),
+             current_num_bytes_ - num_bytes_first);
+    }
+    s->shared_ring_num_bytes = static_cast<uint32_t>(current_num_bytes_);
+  } else {
+    ConvertDataToMessages(buffer_.get(), &start_index_, &current_num_bytes_,
+                          &message_queue);
+  }
   start_index_ = 0;
   current_num_bytes_ = 0;
 
@@ -377,10 +449,18 @@ bool LocalDataPipeImpl::ConsumerEndSerialize(
   scoped_refptr<ChannelEndpoint> channel_endpoint =
       channel->SerializeEndpointWithLocalPeer(destination_for_endpoint,
                                               &message_queue, owner(), 0);
+  scoped_ptr<DataPipeImpl> new_impl;
+  if (shared_ring) {
+    new_impl.reset(new RemoteConsumerDataPipeImpl(
+        channel_endpoint.get(), old_num_bytes, shared_ring,
+        shared_ring_mapping.Pass(), old_num_bytes % capacity_num_bytes()));
+  } else {
+    new_impl.reset(
+        new RemoteConsumerDataPipeImpl(channel_endpoint.get(), old_num_bytes));
+  }
   // Note: Keep |*this| alive until the end of this method, to make things
   // slightly easier on ourselves.
-  scoped_ptr<DataPipeImpl> self(owner()->ReplaceImplNoLock(make_scoped_ptr(
-      new RemoteConsumerDataPipeImpl(channel_endpoint.get(), old_num_bytes))));
+  scoped_ptr<DataPipeImpl> self(owner()->ReplaceImplNoLock(new_impl.Pass()));
 
   *actual_size = sizeof(SerializedDataPipeConsumerDispatcher) +
                  channel->GetSerializedEndpointSize();
@@ -15,14 +15,22 @@ namespace system {
 
 LocalMessagePipeEndpoint::LocalMessagePipeEndpoint(
     MessageInTransitQueue* message_queue)
-    : is_open_(true), is_peer_open_(true) {
-  if (message_queue)
+    : is_open_(true),
+      is_peer_open_(true),
+      message_context_thunks_(nullptr),
+      message_queue_is_empty_(1),
+      has_awakables_(0) {
+  if (message_queue) {
     message_queue_.Swap(message_queue);
+    message_queue_is_empty_ = message_queue_.IsEmpty();
+  }
 }
 
 LocalMessagePipeEndpoint::~LocalMessagePipeEndpoint() {
   DCHECK(!is_open_);
-  DCHECK(message_queue_.IsEmpty());  // Should be implied by not being open.
+  // Should be implied by not being open.
+  DCHECK(ring_.IsEmpty());
+  DCHECK(message_queue_.IsEmpty());
 }
 
 MessagePipeEndpoint::Type LocalMessagePipeEndpoint::GetType() const {
@@ -38,7 +46,7 @@ bool LocalMessagePipeEndpoint::OnPeerClose() {
   HandleSignalsState new_state = GetHandleSignalsState();
 
   if (!new_state.equals(old_state))
-    awakable_list_.AwakeForStateChange(new_state);
+    OnStateChange(new_state);
 
   return true;
 }
@@ -48,21 +56,27 @@ void LocalMessagePipeEndpoint::EnqueueMessage(
   DCHECK(is_open_);
   DCHECK(is_peer_open_);
 
-  bool was_empty = message_queue_.IsEmpty();
+  bool was_empty = !HasMessage();
   message_queue_.AddMessage(message.Pass());
+  // We're the writer, so we may move messages to |ring_|: if the writer is
+  // faster than the reader, this lets the reader keep reading without the
+  // lock.
+  MoveMessageQueueToRing();
   if (was_empty)
-    awakable_list_.AwakeForStateChange(GetHandleSignalsState());
+    OnStateChange(GetHandleSignalsState());
 }
 
 void LocalMessagePipeEndpoint::Close() {
   DCHECK(is_open_);
   is_open_ = false;
+  ring_.Clear();
   message_queue_.Clear();
 }
 
 void LocalMessagePipeEndpoint::CancelAllAwakables() {
   DCHECK(is_open_);
   awakable_list_.CancelAll();
+  UpdateHasAwakables();
 }
 
 MojoResult LocalMessagePipeEndpoint::ReadMessage(
@@ -77,7 +91,7 @@ MojoResult LocalMessagePipeEndpoint::ReadMessage(
   const uint32_t max_bytes = num_bytes.IsNull() ? 0 : num_bytes.Get();
   const uint32_t max_num_dispatchers = num_dispatchers ? *num_dispatchers : 0;
 
-  if (message_queue_.IsEmpty()) {
+  if (!HasMessage()) {
     return is_peer_open_ ? MOJO_RESULT_SHOULD_WAIT
                          : MOJO_RESULT_FAILED_PRECONDITION;
   }
@@ -85,7 +99,9 @@ MojoResult LocalMessagePipeEndpoint::ReadMessage(
   // TODO(vtl): If |flags & MOJO_READ_MESSAGE_FLAG_MAY_DISCARD|, we could pop
   // and release the lock immediately.
   bool enough_space = true;
-  MessageInTransit* message = message_queue_.PeekMessage();
+  MessageInTransit* message = PeekMessage();
+  // (|MessagePipe| serializes any contexts before reading.)
+  DCHECK(!message->has_context());
   if (!num_bytes.IsNull())
     num_bytes.Put(message->num_bytes());
   if (message->num_bytes() <= max_bytes)
@@ -114,13 +130,13 @@ MojoResult LocalMessagePipeEndpoint::ReadMessage(
   message = nullptr;
 
   if (enough_space || (flags & MOJO_READ_MESSAGE_FLAG_MAY_DISCARD)) {
-    message_queue_.DiscardMessage();
+    DiscardMessage();
 
     // Now it's empty, thus no longer readable.
-    if (message_queue_.IsEmpty()) {
+    if (!HasMessage()) {
       // It's currently not possible to wait for non-readability, but we should
       // do the state change anyway.
-      awakable_list_.AwakeForStateChange(GetHandleSignalsState());
+      OnStateChange(GetHandleSignalsState());
     }
   }
 
@@ -130,9 +146,204 @@ MojoResult LocalMessagePipeEndpoint::ReadMessage(
   return MOJO_RESULT_OK;
 }
 
+MojoResult LocalMessagePipeEndpoint::ReadMessages(
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    DispatcherVector* dispatchers,
+    uint32_t* num_dispatchers,
+    UserPointer<uint32_t> message_num_bytes,
+    UserPointer<uint32_t> message_num_dispatchers,
+    UserPointer<uint32_t> num_messages,
+    MojoReadMessageFlags flags) {
+  DCHECK(is_open_);
+  DCHECK(!dispatchers || dispatchers->empty());
+
+  const uint32_t max_bytes = num_bytes.IsNull() ? 0 : num_bytes.Get();
+  const uint32_t max_num_dispatchers = num_dispatchers ? *num_dispatchers : 0;
+  const uint32_t max_messages = num_messages.Get();
+  DCHECK_GT(max_messages, 0u);
+
+  if (!HasMessage()) {
+    return is_peer_open_ ? MOJO_RESULT_SHOULD_WAIT
+                         : MOJO_RESULT_FAILED_PRECONDITION;
+  }
+
+  // Read messages until one doesn't fit (in the remaining space).
+  uint32_t total_bytes = 0;
+  uint32_t total_dispatchers = 0;
+  uint32_t i = 0;
+  for (; i < max_messages && HasMessage(); i++) {
+    MessageInTransit* message = PeekMessage();
+    DCHECK(!message->has_context());
+    DispatcherVector* queued_dispatchers = message->dispatchers();
+    const uint32_t message_dispatchers =
+        queued_dispatchers ? static_cast<uint32_t>(queued_dispatchers->size())
+                           : 0;
+    if (message->num_bytes() > max_bytes - total_bytes ||
+        message_dispatchers > max_num_dispatchers - total_dispatchers) {
+      if (i > 0)
+        break;
+
+      // Like |ReadMessage()|, report the first message's size (and discard it
+      // if requested).
+      if (!num_bytes.IsNull())
+        num_bytes.Put(message->num_bytes());
+      if (num_dispatchers)
+        *num_dispatchers = message_dispatchers;
+      num_messages.Put(0);
+      if (flags & MOJO_READ_MESSAGE_FLAG_MAY_DISCARD) {
+        DiscardMessage();
+        if (!HasMessage())
+          OnStateChange(GetHandleSignalsState());
+      }
+      return MOJO_RESULT_RESOURCE_EXHAUSTED;
+    }
+
+    bytes.At(total_bytes).PutArray(message->bytes(), message->num_bytes());
+    message_num_bytes.At(i).Put(message->num_bytes());
+    if (!message_num_dispatchers.IsNull())
+      message_num_dispatchers.At(i).Put(message_dispatchers);
+    if (message_dispatchers > 0) {
+      DCHECK(dispatchers);
+      dispatchers->insert(dispatchers->end(), queued_dispatchers->begin(),
+                          queued_dispatchers->end());
+      queued_dispatchers->clear();
+    }
+    total_bytes += message->num_bytes();
+    total_dispatchers += message_dispatchers;
+    DiscardMessage();
+  }
+
+  // Now it's empty, thus no longer readable. (See |ReadMessage()|.)
+  if (!HasMessage())
+    OnStateChange(GetHandleSignalsState());
+
+  if (!num_bytes.IsNull())
+    num_bytes.Put(total_bytes);
+  if (num_dispatchers)
+    *num_dispatchers = total_dispatchers;
+  num_messages.Put(i);
+  return MOJO_RESULT_OK;
+}
+
+MojoResult LocalMessagePipeEndpoint::ReadMessageContext(
+    const MojoMessageContextThunks* thunks,
+    uintptr_t* context,
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    DispatcherVector* dispatchers,
+    uint32_t* num_dispatchers,
+    MojoReadMessageFlags flags) {
+  DCHECK(is_open_);
+  DCHECK(thunks);
+
+  message_context_thunks_ = thunks;
+  *context = 0;
+
+  if (HasMessage() && PeekMessage()->context_thunks() == thunks) {
+    *context = PeekMessage()->ReleaseContext();
+    if (!num_bytes.IsNull())
+      num_bytes.Put(0);
+    if (num_dispatchers)
+      *num_dispatchers = 0;
+    DiscardMessage();
+    // (See |ReadMessage()|.)
+    if (!HasMessage())
+      OnStateChange(GetHandleSignalsState());
+    return MOJO_RESULT_OK;
+  }
+
+  return ReadMessage(bytes, num_bytes, dispatchers, num_dispatchers, flags);
+}
+
+void LocalMessagePipeEndpoint::StopMessageContexts(
+    std::vector<MessageInTransit*>* messages) {
+  DCHECK(is_open_);
+
+  // Contexts are only enqueued while |message_context_thunks_| is set.
+  if (!message_context_thunks_)
+    return;
+  message_context_thunks_ = nullptr;
+  // (Messages in |ring_| never have contexts.)
+  message_queue_.GetMessagesWithContexts(messages);
+}
+
+bool LocalMessagePipeEndpoint::TryEnqueueMessageLockFree(
+    scoped_ptr<MessageInTransit>* message,
+    bool* should_awake) {
+  DCHECK(!(*message)->has_dispatchers());
+  DCHECK(!(*message)->has_context());
+
+  if (!base::subtle::Acquire_Load(&message_queue_is_empty_) ||
+      !ring_.TryAddMessage(message))
+    return false;
+
+  // This pairs with the barrier in |AddAwakable()|: either it sees the message
+  // (and doesn't wait), or we see that there may be an awakable to awake. As in
+  // |EnqueueMessage()|, awakables only need awaking if the ring was empty
+  // (otherwise whoever added the earlier message already awoke them); if the
+  // message has already been read, there's nothing to awake them for.
+  base::subtle::MemoryBarrier();
+  *should_awake = base::subtle::NoBarrier_Load(&has_awakables_) &&
+                  ring_.GetSize() == 1;
+  return true;
+}
+
+bool LocalMessagePipeEndpoint::TryReadMessageLockFree(
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    uint32_t* num_dispatchers,
+    MojoReadMessageFlags flags,
+    MojoResult* result) {
+  if (ring_.IsEmpty())
+    return false;
+
+  // Messages in |ring_| have neither dispatchers nor contexts.
+  MessageInTransit* message = ring_.PeekMessage();
+  const uint32_t max_bytes = num_bytes.IsNull() ? 0 : num_bytes.Get();
+  if (!num_bytes.IsNull())
+    num_bytes.Put(message->num_bytes());
+  if (num_dispatchers)
+    *num_dispatchers = 0;
+
+  if (message->num_bytes() <= max_bytes) {
+    bytes.PutArray(message->bytes(), message->num_bytes());
+    *result = MOJO_RESULT_OK;
+  } else {
+    *result = MOJO_RESULT_RESOURCE_EXHAUSTED;
+    if (!(flags & MOJO_READ_MESSAGE_FLAG_MAY_DISCARD))
+      return true;
+  }
+  message = nullptr;
+
+  // Unlike |ReadMessage()|, this doesn't awake awakables if there's no longer
+  // a message (it can't, without the lock), but that's not a state change that
+  // can be waited for anyway.
+  ring_.DiscardMessage();
+  return true;
+}
+
+void LocalMessagePipeEndpoint::AwakeForLockFreeEnqueue() {
+  DCHECK(is_open_);
+  OnStateChange(GetHandleSignalsState());
+}
+
+void LocalMessagePipeEndpoint::MoveRingToMessageQueue() {
+  if (ring_.IsEmpty())
+    return;
+
+  MessageInTransitQueue messages;
+  while (!ring_.IsEmpty())
+    messages.AddMessage(ring_.GetMessage());
+  while (!message_queue_.IsEmpty())
+    messages.AddMessage(message_queue_.GetMessage());
+  message_queue_.Swap(&messages);
+  base::subtle::Release_Store(&message_queue_is_empty_, 0);
+}
+
 HandleSignalsState LocalMessagePipeEndpoint::GetHandleSignalsState() const {
   HandleSignalsState rv;
-  if (!message_queue_.IsEmpty()) {
+  if (HasMessage()) {
     rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_READABLE;
     rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_READABLE;
   }
@@ -154,13 +365,19 @@ MojoResult LocalMessagePipeEndpoint::AddAwakable(
     HandleSignalsState* signals_state) {
   DCHECK(is_open_);
 
+  // This pairs with the barrier in |TryEnqueueMessageLockFree()|.
+  base::subtle::NoBarrier_Store(&has_awakables_, 1);
+  base::subtle::MemoryBarrier();
+
   HandleSignalsState state = GetHandleSignalsState();
   if (state.satisfies(signals)) {
+    UpdateHasAwakables();
     if (signals_state)
       *signals_state = state;
     return MOJO_RESULT_ALREADY_EXISTS;
   }
   if (!state.can_satisfy(signals)) {
+    UpdateHasAwakables();
     if (signals_state)
       *signals_state = state;
     return MOJO_RESULT_FAILED_PRECONDITION;
@@ -175,9 +392,49 @@ void LocalMessagePipeEndpoint::RemoveAwakable(
     HandleSignalsState* signals_state) {
   DCHECK(is_open_);
   awakable_list_.Remove(awakable);
+  UpdateHasAwakables();
   if (signals_state)
     *signals_state = GetHandleSignalsState();
 }
 
+MessageInTransit* LocalMessagePipeEndpoint::PeekMessage() {
+  // Note that if |ring_| is empty, it stays empty while |message_queue_| is
+  // nonempty.
+  return ring_.IsEmpty() ? message_queue_.PeekMessage() : ring_.PeekMessage();
+}
+
+void LocalMessagePipeEndpoint::DiscardMessage() {
+  if (!ring_.IsEmpty()) {
+    ring_.DiscardMessage();
+    return;
+  }
+
+  message_queue_.DiscardMessage();
+  if (message_queue_.IsEmpty())
+    base::subtle::Release_Store(&message_queue_is_empty_, 1);
+}
+
+void LocalMessagePipeEndpoint::MoveMessageQueueToRing() {
+  // Only messages without dispatchers or contexts may go in |ring_|.
+  while (!message_queue_.IsEmpty() && !ring_.IsFull() &&
+         !message_queue_.PeekMessage()->has_dispatchers() &&
+         !message_queue_.PeekMessage()->has_context()) {
+    scoped_ptr<MessageInTransit> message = message_queue_.GetMessage();
+    ring_.TryAddMessage(&message);
+    DCHECK(!message);
+  }
+  base::subtle::Release_Store(&message_queue_is_empty_,
+                              message_queue_.IsEmpty());
+}
+
+void LocalMessagePipeEndpoint::OnStateChange(const HandleSignalsState& state) {
+  awakable_list_.AwakeForStateChange(state);
+  UpdateHasAwakables();
+}
+
+void LocalMessagePipeEndpoint::UpdateHasAwakables() {
+  base::subtle::NoBarrier_Store(&has_awakables_, !awakable_list_.IsEmpty());
+}
+
 }  // namespace system
 }  // namespace mojo
@@ -5,11 +5,16 @@
 #ifndef MOJO_EDK_SYSTEM_LOCAL_MESSAGE_PIPE_ENDPOINT_H_
 #define MOJO_EDK_SYSTEM_LOCAL_MESSAGE_PIPE_ENDPOINT_H_
 
+#include <vector>
+
+#include "base/atomicops.h"
 #include "base/compiler_specific.h"
 #include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
 #include "mojo/edk/system/awakable_list.h"
 #include "mojo/edk/system/handle_signals_state.h"
 #include "mojo/edk/system/message_in_transit_queue.h"
+#include "mojo/edk/system/message_in_transit_ring.h"
 #include "mojo/edk/system/message_pipe_endpoint.h"
 #include "mojo/edk/system/system_impl_export.h"
 
@@ -39,6 +44,14 @@ class MOJO_SYSTEM_IMPL_EXPORT LocalMessagePipeEndpoint
                          DispatcherVector* dispatchers,
                          uint32_t* num_dispatchers,
                          MojoReadMessageFlags flags) override;
+  MojoResult ReadMessages(UserPointer<void> bytes,
+                          UserPointer<uint32_t> num_bytes,
+                          DispatcherVector* dispatchers,
+                          uint32_t* num_dispatchers,
+                          UserPointer<uint32_t> message_num_bytes,
+                          UserPointer<uint32_t> message_num_dispatchers,
+                          UserPointer<uint32_t> num_messages,
+                          MojoReadMessageFlags flags) override;
   HandleSignalsState GetHandleSignalsState() const override;
   MojoResult AddAwakable(Awakable* awakable,
                          MojoHandleSignals signals,
@@ -47,17 +60,92 @@ class MOJO_SYSTEM_IMPL_EXPORT LocalMessagePipeEndpoint
   void RemoveAwakable(Awakable* awakable,
                       HandleSignalsState* signals_state) override;
 
-  // This is only to be used by |MessagePipe|:
+  // These are only to be used by |MessagePipe|:
+  // Note: |MoveRingToMessageQueue()| should be called before this.
   MessageInTransitQueue* message_queue() { return &message_queue_; }
+  // Like |ReadMessage()|, but reads the next message's context instead (see
+  // |MojoReadMessageContext()|) if it was written using the same |thunks|.
+  // This also makes |thunks| this endpoint's |message_context_thunks()|.
+  MojoResult ReadMessageContext(const MojoMessageContextThunks* thunks,
+                                uintptr_t* context,
+                                UserPointer<void> bytes,
+                                UserPointer<uint32_t> num_bytes,
+                                DispatcherVector* dispatchers,
+                                uint32_t* num_dispatchers,
+                                MojoReadMessageFlags flags);
+  // The thunks this endpoint was last read with using |ReadMessageContext()|
+  // (or null): messages written with them may be enqueued unserialized.
+  const MojoMessageContextThunks* message_context_thunks() const {
+    return message_context_thunks_;
+  }
+  // Resets |message_context_thunks()|, so that no more message contexts will
+  // be enqueued, and appends the queued messages that have contexts to
+  // |*messages| (they remain queued; see
+  // |MessagePipe::SerializeMessageContextsNoLock()|).
+  void StopMessageContexts(std::vector<MessageInTransit*>* messages);
+
+  // The following may be called without the lock (see |MessagePipe|), but only
+  // by the writer (i.e., the peer port) and by the reader of this endpoint
+  // respectively, each of which may be on only one thread at a time.
+  //
+  // Enqueues |*message|, which must have no dispatchers or context attached,
+  // unless messages that would have to be read first are in |message_queue_| or
+  // |ring_| is full; in those cases this returns false (and leaves |*message|
+  // alone) and the message should be enqueued under the lock instead. If this
+  // returns true and sets |*should_awake|, |AwakeForLockFreeEnqueue()| must be
+  // called (under the lock).
+  bool TryEnqueueMessageLockFree(scoped_ptr<MessageInTransit>* message,
+                                 bool* should_awake);
+  // Reads like |ReadMessage()| (setting |*result| to what it would return) if
+  // the next message is in |ring_|. Otherwise this returns false, and
+  // |ReadMessage()| should be called (under the lock) instead.
+  bool TryReadMessageLockFree(UserPointer<void> bytes,
+                              UserPointer<uint32_t> num_bytes,
+                              uint32_t* num_dispatchers,
+                              MojoReadMessageFlags flags,
+                              MojoResult* result);
+
+  // These must be called under the lock:
+  void AwakeForLockFreeEnqueue();
+  // Moves any messages in |ring_| to |message_queue_|. This should only be
+  // called once no more messages will be enqueued.
+  void MoveRingToMessageQueue();
 
  private:
+  // These look at the next message to be read, from |ring_| or (if that's
+  // empty) |message_queue_|.
+  bool HasMessage() const {
+    return !ring_.IsEmpty() || !message_queue_.IsEmpty();
+  }
+  MessageInTransit* PeekMessage();
+  void DiscardMessage();
+
+  // Moves messages (that may go there) from the front of |message_queue_| to
+  // |ring_|, while it has room. Only the writer may call this.
+  void MoveMessageQueueToRing();
+
+  // Awakes awakables for a change to |state|.
+  void OnStateChange(const HandleSignalsState& state);
+  void UpdateHasAwakables();
+
   bool is_open_;
   bool is_peer_open_;
+  const MojoMessageContextThunks* message_context_thunks_;
 
-  // Queue of incoming messages.
+  // Queues of incoming messages: messages are only added to |ring_| (with or
+  // without the lock) while |message_queue_| is empty, or moved to it from the
+  // front of |message_queue_|, so all the messages in |ring_| precede those in
+  // |message_queue_|.
+  MessageInTransitRing ring_;
   MessageInTransitQueue message_queue_;
   AwakableList awakable_list_;
 
+  // These may be read without the lock. |message_queue_is_empty_| is whether
+  // |message_queue_| is empty. |has_awakables_| is set if |awakable_list_| may
+  // be nonempty.
+  base::subtle::Atomic32 message_queue_is_empty_;
+  base::subtle::Atomic32 has_awakables_;
+
   DISALLOW_COPY_AND_ASSIGN(LocalMessagePipeEndpoint);
 };
 
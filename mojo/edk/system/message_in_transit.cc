@@ -74,7 +74,10 @@ MessageInTransit::MessageInTransit(Type type,
                                    const void* bytes)
     : main_buffer_size_(RoundUpMessageAlignment(sizeof(Header) + num_bytes)),
       main_buffer_(static_cast<char*>(
-          base::AlignedAlloc(main_buffer_size_, kMessageAlignment))) {
+          base::AlignedAlloc(main_buffer_size_, kMessageAlignment))),
+      context_(0),
+      context_thunks_(nullptr),
+      context_num_bytes_(0) {
   ConstructorHelper(type, subtype, num_bytes);
   if (bytes) {
     memcpy(MessageInTransit::bytes(), bytes, num_bytes);
@@ -91,7 +94,10 @@ MessageInTransit::MessageInTransit(Type type,
                                    UserPointer<const void> bytes)
     : main_buffer_size_(RoundUpMessageAlignment(sizeof(Header) + num_bytes)),
       main_buffer_(static_cast<char*>(
-          base::AlignedAlloc(main_buffer_size_, kMessageAlignment))) {
+          base::AlignedAlloc(main_buffer_size_, kMessageAlignment))),
+      context_(0),
+      context_thunks_(nullptr),
+      context_num_bytes_(0) {
   ConstructorHelper(type, subtype, num_bytes);
   bytes.GetArray(MessageInTransit::bytes(), num_bytes);
   memset(static_cast<char*>(MessageInTransit::bytes()) + num_bytes, 0,
@@ -101,7 +107,10 @@ MessageInTransit::MessageInTransit(Type type,
 MessageInTransit::MessageInTransit(const View& message_view)
     : main_buffer_size_(message_view.main_buffer_size()),
       main_buffer_(static_cast<char*>(
-          base::AlignedAlloc(main_buffer_size_, kMessageAlignment))) {
+          base::AlignedAlloc(main_buffer_size_, kMessageAlignment))),
+      context_(0),
+      context_thunks_(nullptr),
+      context_num_bytes_(0) {
   DCHECK_GE(main_buffer_size_, sizeof(Header));
   DCHECK_EQ(main_buffer_size_ % kMessageAlignment, 0u);
 
@@ -110,7 +119,26 @@ MessageInTransit::MessageInTransit(const View& message_view)
             RoundUpMessageAlignment(sizeof(Header) + num_bytes()));
 }
 
+MessageInTransit::MessageInTransit(Type type,
+                                   Subtype subtype,
+                                   const MojoMessageContextThunks* thunks,
+                                   uintptr_t context,
+                                   uint32_t serialized_num_bytes)
+    : main_buffer_size_(RoundUpMessageAlignment(sizeof(Header))),
+      main_buffer_(static_cast<char*>(
+          base::AlignedAlloc(main_buffer_size_, kMessageAlignment))),
+      context_(context),
+      context_thunks_(thunks),
+      context_num_bytes_(serialized_num_bytes) {
+  DCHECK(context_thunks_);
+  ConstructorHelper(type, subtype, 0);
+}
+
 MessageInTransit::~MessageInTransit() {
+  // (See the note above |SerializeContext()|.)
+  if (context_thunks_)
+    context_thunks_->Destroy(context_);
+
   if (dispatchers_) {
     for (size_t i = 0; i < dispatchers_->size(); i++) {
       if (!(*dispatchers_)[i])
@@ -143,6 +171,26 @@ bool MessageInTransit::GetNextMessageSize(const void* buffer,
   return true;
 }
 
+uintptr_t MessageInTransit::ReleaseContext() {
+  DCHECK(context_thunks_);
+  uintptr_t rv = context_;
+  context_ = 0;
+  context_thunks_ = nullptr;
+  return rv;
+}
+
+scoped_ptr<MessageInTransit> MessageInTransit::SerializeContext() const {
+  DCHECK(context_thunks_);
+  DCHECK(!dispatchers_);
+  DCHECK(!transport_data_);
+
+  scoped_ptr<MessageInTransit> message(
+      new MessageInTransit(type(), subtype(), context_num_bytes_, nullptr));
+  context_thunks_->Serialize(context_, message->bytes(), context_num_bytes_);
+  context_thunks_->Destroy(context_);
+  return message;
+}
+
 void MessageInTransit::SetDispatchers(
     scoped_ptr<DispatcherVector> dispatchers) {
   DCHECK(dispatchers);
@@ -18,6 +18,7 @@
 #include "mojo/edk/system/dispatcher.h"
 #include "mojo/edk/system/memory.h"
 #include "mojo/edk/system/system_impl_export.h"
+#include "mojo/public/c/system/message_pipe.h"
 
 namespace mojo {
 namespace system {
@@ -67,6 +68,9 @@ class MOJO_SYSTEM_IMPL_EXPORT MessageInTransit {
     // Data pipe: consumer -> producer message that data was consumed. Payload
     // is |RemoteDataPipeAck|.
     ENDPOINT_CLIENT_DATA_PIPE_ACK = 1,
+    // Data pipe with a shared ring: producer -> consumer message that data was
+    // written to the ring. Payload is |RemoteDataPipeSharedRingWrite|.
+    ENDPOINT_CLIENT_DATA_PIPE_SHARED_RING_WRITE = 2,
     // Subtypes for type |Type::ENDPOINT|:
     // TODO(vtl): Nothing yet.
     // Subtypes for type |Type::CHANNEL|:
@@ -165,6 +169,15 @@ class MOJO_SYSTEM_IMPL_EXPORT MessageInTransit {
                    UserPointer<const void> bytes);
   // Constructs a |MessageInTransit| from a |View|.
   explicit MessageInTransit(const View& message_view);
+  // Constructs a |MessageInTransit| whose data is given by a message context
+  // (see |MojoWriteMessageContext()|), taking ownership of |context|, whose
+  // serialized size is |serialized_num_bytes|. It has no data itself (see
+  // |SerializeContext()|).
+  MessageInTransit(Type type,
+                   Subtype subtype,
+                   const MojoMessageContextThunks* thunks,
+                   uintptr_t context,
+                   uint32_t serialized_num_bytes);
 
   ~MessageInTransit();
 
@@ -195,6 +208,26 @@ class MOJO_SYSTEM_IMPL_EXPORT MessageInTransit {
   // stays alive through the call.
   void SerializeAndCloseDispatchers(Channel* channel);
 
+  // Returns true if this message has a context (which hasn't been serialized
+  // or released).
+  bool has_context() const { return !!context_thunks_; }
+  const MojoMessageContextThunks* context_thunks() const {
+    return context_thunks_;
+  }
+
+  // Releases this message's context, which the caller then owns.
+  uintptr_t ReleaseContext();
+
+  // Returns a new message (with the same type and subtype) whose data is this
+  // message's context serialized, and destroys the context, which must then be
+  // released (see |ReleaseContext()|) and not otherwise used. This message
+  // itself isn't modified.
+  //
+  // Note: This calls into user code (|context_thunks()|), so it must be done
+  // without holding any |MessagePipe|'s lock. (For the same reason, messages
+  // that still have contexts must not be destroyed with such a lock held.)
+  scoped_ptr<MessageInTransit> SerializeContext() const;
+
   // Gets the main buffer and its size (in number of bytes), respectively.
   const void* main_buffer() const { return main_buffer_.get(); }
   size_t main_buffer_size() const { return main_buffer_size_; }
@@ -273,6 +306,12 @@ class MOJO_SYSTEM_IMPL_EXPORT MessageInTransit {
   const size_t main_buffer_size_;
   const scoped_ptr<char, base::AlignedFreeDeleter> main_buffer_;  // Never null.
 
+  // The message's context, if any. (Note that |context_thunks_| is owned by
+  // the user and is compared by pointer.)
+  uintptr_t context_;
+  const MojoMessageContextThunks* context_thunks_;
+  uint32_t context_num_bytes_;
+
   scoped_ptr<TransportData> transport_data_;  // May be null.
 
   // Any dispatchers that may be attached to this message. These dispatchers
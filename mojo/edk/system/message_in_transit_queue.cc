@@ -4,6 +4,8 @@
 
 #include "mojo/edk/system/message_in_transit_queue.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/stl_util.h"
 
@@ -24,6 +26,24 @@ void MessageInTransitQueue::Clear() {
   STLDeleteElements(&queue_);
 }
 
+void MessageInTransitQueue::GetMessagesWithContexts(
+    std::vector<MessageInTransit*>* messages) {
+  for (MessageInTransit* message : queue_) {
+    if (message->has_context())
+      messages->push_back(message);
+  }
+}
+
+scoped_ptr<MessageInTransit> MessageInTransitQueue::ReplaceMessage(
+    MessageInTransit* message,
+    scoped_ptr<MessageInTransit> new_message) {
+  std::deque<MessageInTransit*>::iterator it =
+      std::find(queue_.begin(), queue_.end(), message);
+  DCHECK(it != queue_.end());
+  *it = new_message.release();
+  return make_scoped_ptr(message);
+}
+
 void MessageInTransitQueue::Swap(MessageInTransitQueue* other) {
   queue_.swap(other->queue_);
 }
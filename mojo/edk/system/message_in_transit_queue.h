@@ -6,6 +6,7 @@
 #define MOJO_EDK_SYSTEM_MESSAGE_IN_TRANSIT_QUEUE_H_
 
 #include <deque>
+#include <vector>
 
 #include "base/macros.h"
 #include "base/memory/scoped_ptr.h"
@@ -44,6 +45,16 @@ class MOJO_SYSTEM_IMPL_EXPORT MessageInTransitQueue {
 
   void Clear();
 
+  // Appends (pointers to) the messages that have contexts to |*messages|, in
+  // order. (They remain owned by this queue.)
+  void GetMessagesWithContexts(std::vector<MessageInTransit*>* messages);
+
+  // Replaces |message|, which must be in this queue, with |new_message| (in the
+  // same position), returning |message|.
+  scoped_ptr<MessageInTransit> ReplaceMessage(
+      MessageInTransit* message,
+      scoped_ptr<MessageInTransit> new_message);
+
   // Efficiently swaps contents with |*other|.
   void Swap(MessageInTransitQueue* other);
 
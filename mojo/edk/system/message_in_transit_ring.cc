@@ -0,0 +1,31 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/message_in_transit_ring.h"
+
+namespace mojo {
+namespace system {
+
+// static
+const uint32_t MessageInTransitRing::kCapacity;
+
+MessageInTransitRing::MessageInTransitRing() : head_(0), tail_(0) {
+  static_assert(!(kCapacity & (kCapacity - 1)),
+                "kCapacity must be a power of 2");
+}
+
+MessageInTransitRing::~MessageInTransitRing() {
+  if (!IsEmpty()) {
+    LOG(WARNING) << "Destroying nonempty message ring";
+    Clear();
+  }
+}
+
+void MessageInTransitRing::Clear() {
+  while (!IsEmpty())
+    DiscardMessage();
+}
+
+}  // namespace system
+}  // namespace mojo
@@ -0,0 +1,108 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_EDK_SYSTEM_MESSAGE_IN_TRANSIT_RING_H_
+#define MOJO_EDK_SYSTEM_MESSAGE_IN_TRANSIT_RING_H_
+
+#include <stdint.h>
+
+#include "base/atomicops.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "mojo/edk/system/message_in_transit.h"
+#include "mojo/edk/system/system_impl_export.h"
+
+namespace mojo {
+namespace system {
+
+// A fixed-capacity, lock-free, single-producer/single-consumer queue for
+// |MessageInTransit|s (that owns its messages). One thread at a time (the
+// producer) may call |TryAddMessage()|, concurrently with one thread at a time
+// (the consumer) calling the other non-const methods. |IsEmpty()| may be called
+// from any thread.
+class MOJO_SYSTEM_IMPL_EXPORT MessageInTransitRing {
+ public:
+  // Must be a power of 2.
+  static const uint32_t kCapacity = 64;
+
+  MessageInTransitRing();
+  ~MessageInTransitRing();
+
+  bool IsEmpty() const { return GetSize() == 0; }
+
+  // Any thread: Gets the number of messages (which may have changed by the time
+  // it's returned, unless called by the producer or consumer).
+  uint32_t GetSize() const {
+    const uint32_t head =
+        static_cast<uint32_t>(base::subtle::Acquire_Load(&head_));
+    return static_cast<uint32_t>(base::subtle::Acquire_Load(&tail_)) - head;
+  }
+
+  // Producer: (Once this returns false, it'll stay false until the producer
+  // adds a message.)
+  bool IsFull() const {
+    return tail() - static_cast<uint32_t>(base::subtle::Acquire_Load(&head_)) >=
+           kCapacity;
+  }
+
+  // Producer: Adds |*message| (taking ownership of it), unless the ring is full
+  // in which case this returns false and leaves |*message| alone.
+  bool TryAddMessage(scoped_ptr<MessageInTransit>* message) {
+    if (IsFull())
+      return false;
+    const uint32_t tail = this->tail();
+    messages_[tail % kCapacity] = message->release();
+    base::subtle::Release_Store(&tail_,
+                                static_cast<base::subtle::Atomic32>(tail + 1));
+    return true;
+  }
+
+  // Consumer: These may only be called if the ring is nonempty.
+  MessageInTransit* PeekMessage() {
+    DCHECK(!IsEmpty());
+    return messages_[head() % kCapacity];
+  }
+
+  scoped_ptr<MessageInTransit> GetMessage() {
+    MessageInTransit* rv = PeekMessage();
+    Pop();
+    return make_scoped_ptr(rv);
+  }
+
+  void DiscardMessage() {
+    delete PeekMessage();
+    Pop();
+  }
+
+  // Consumer: Discards all the messages.
+  void Clear();
+
+ private:
+  uint32_t head() const {
+    return static_cast<uint32_t>(base::subtle::NoBarrier_Load(&head_));
+  }
+  uint32_t tail() const {
+    return static_cast<uint32_t>(base::subtle::NoBarrier_Load(&tail_));
+  }
+
+  void Pop() {
+    base::subtle::Release_Store(
+        &head_, static_cast<base::subtle::Atomic32>(head() + 1));
+  }
+
+  // These are free-running counts of the messages removed and added, so the
+  // ring holds |tail_ - head_| messages (modulo 2^32). |head_| is only written
+  // by the consumer and |tail_| only by the producer.
+  base::subtle::Atomic32 head_;
+  MessageInTransit* messages_[kCapacity];
+  base::subtle::Atomic32 tail_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageInTransitRing);
+};
+
+}  // namespace system
+}  // namespace mojo
+
+#endif  // MOJO_EDK_SYSTEM_MESSAGE_IN_TRANSIT_RING_H_
@@ -0,0 +1,116 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/message_in_transit_ring.h"
+
+#include "base/macros.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "mojo/edk/system/message_in_transit_test_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace system {
+namespace {
+
+TEST(MessageInTransitRingTest, Basic) {
+  MessageInTransitRing ring;
+  EXPECT_TRUE(ring.IsEmpty());
+
+  scoped_ptr<MessageInTransit> message(test::MakeTestMessage(1));
+  EXPECT_TRUE(ring.TryAddMessage(&message));
+  EXPECT_FALSE(message);
+  ASSERT_FALSE(ring.IsEmpty());
+
+  test::VerifyTestMessage(ring.PeekMessage(), 1);
+  ASSERT_FALSE(ring.IsEmpty());
+
+  message = test::MakeTestMessage(2);
+  EXPECT_TRUE(ring.TryAddMessage(&message));
+  message = test::MakeTestMessage(3);
+  EXPECT_TRUE(ring.TryAddMessage(&message));
+
+  test::VerifyTestMessage(ring.GetMessage().get(), 1);
+  test::VerifyTestMessage(ring.PeekMessage(), 2);
+  ring.DiscardMessage();
+  test::VerifyTestMessage(ring.GetMessage().get(), 3);
+  EXPECT_TRUE(ring.IsEmpty());
+
+  message = test::MakeTestMessage(4);
+  EXPECT_TRUE(ring.TryAddMessage(&message));
+  ASSERT_FALSE(ring.IsEmpty());
+  ring.Clear();
+  EXPECT_TRUE(ring.IsEmpty());
+}
+
+TEST(MessageInTransitRingTest, Full) {
+  MessageInTransitRing ring;
+
+  // Go around the ring a few times.
+  for (unsigned i = 0; i < 3; i++) {
+    for (unsigned j = 0; j < MessageInTransitRing::kCapacity; j++) {
+      scoped_ptr<MessageInTransit> message(test::MakeTestMessage(j));
+      EXPECT_TRUE(ring.TryAddMessage(&message));
+    }
+
+    // The ring should be full now.
+    scoped_ptr<MessageInTransit> message(test::MakeTestMessage(12345));
+    EXPECT_FALSE(ring.TryAddMessage(&message));
+    ASSERT_TRUE(message);
+    test::VerifyTestMessage(message.get(), 12345);
+
+    // Remove one, and it should take one more.
+    test::VerifyTestMessage(ring.GetMessage().get(), 0);
+    EXPECT_TRUE(ring.TryAddMessage(&message));
+    EXPECT_FALSE(message);
+
+    for (unsigned j = 1; j < MessageInTransitRing::kCapacity; j++)
+      test::VerifyTestMessage(ring.GetMessage().get(), j);
+    test::VerifyTestMessage(ring.GetMessage().get(), 12345);
+    EXPECT_TRUE(ring.IsEmpty());
+  }
+}
+
+// Adds |num_messages| messages (with IDs 0, 1, ...) to a ring, retrying while
+// it's full.
+class ProducerThread : public base::SimpleThread {
+ public:
+  ProducerThread(MessageInTransitRing* ring, unsigned num_messages)
+      : base::SimpleThread("producer_thread"),
+        ring_(ring),
+        num_messages_(num_messages) {}
+  ~ProducerThread() override { Join(); }
+
+ private:
+  void Run() override {
+    for (unsigned i = 0; i < num_messages_; i++) {
+      scoped_ptr<MessageInTransit> message(test::MakeTestMessage(i));
+      while (!ring_->TryAddMessage(&message))
+        base::PlatformThread::YieldCurrentThread();
+    }
+  }
+
+  MessageInTransitRing* const ring_;
+  const unsigned num_messages_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+TEST(MessageInTransitRingTest, Threaded) {
+  const unsigned kNumMessages = 10000;
+
+  MessageInTransitRing ring;
+  ProducerThread producer(&ring, kNumMessages);
+  producer.Start();
+  for (unsigned i = 0; i < kNumMessages; i++) {
+    while (ring.IsEmpty())
+      base::PlatformThread::YieldCurrentThread();
+    test::VerifyTestMessage(ring.GetMessage().get(), i);
+  }
+  EXPECT_TRUE(ring.IsEmpty());
+}
+
+}  // namespace
+}  // namespace system
+}  // namespace mojo
@@ -5,9 +5,12 @@
 #include "mojo/edk/system/message_pipe.h"
 
 #include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/platform_thread.h"
 #include "mojo/edk/system/channel.h"
 #include "mojo/edk/system/channel_endpoint.h"
 #include "mojo/edk/system/channel_endpoint_id.h"
+#include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/incoming_endpoint.h"
 #include "mojo/edk/system/local_message_pipe_endpoint.h"
 #include "mojo/edk/system/message_in_transit.h"
@@ -23,6 +26,10 @@ MessagePipe* MessagePipe::CreateLocalLocal() {
   MessagePipe* message_pipe = new MessagePipe();
   message_pipe->endpoints_[0].reset(new LocalMessagePipeEndpoint());
   message_pipe->endpoints_[1].reset(new LocalMessagePipeEndpoint());
+  // Each port's writer is the other port, so messages can go through the
+  // endpoints' rings.
+  message_pipe->lock_free_enabled_[0] = 1;
+  message_pipe->lock_free_enabled_[1] = 1;
   return message_pipe;
 }
 
@@ -125,18 +132,32 @@ void MessagePipe::Close(unsigned port) {
 
   unsigned peer_port = GetPeerPort(port);
 
-  base::AutoLock locker(lock_);
-  // The endpoint's |OnPeerClose()| may have been called first and returned
-  // false, which would have resulted in its destruction.
-  if (!endpoints_[port])
-    return;
-
-  endpoints_[port]->Close();
-  if (endpoints_[peer_port]) {
-    if (!endpoints_[peer_port]->OnPeerClose())
-      endpoints_[peer_port].reset();
+  // Queued messages with contexts are destroyed only after |lock_| is released
+  // (destroying a context calls into user code).
+  MessageInTransitQueue messages_with_contexts;
+  {
+    base::AutoLock locker(lock_);
+    // The endpoint's |OnPeerClose()| may have been called first and returned
+    // false, which would have resulted in its destruction.
+    if (!endpoints_[port])
+      return;
+
+    StopLockFreeEnqueueNoLock(port);
+    if (endpoints_[port]->GetType() == MessagePipeEndpoint::kTypeLocal) {
+      LocalMessagePipeEndpoint* endpoint =
+          static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get());
+      // Contexts are only enqueued while |message_context_thunks()| is set.
+      if (endpoint->message_context_thunks())
+        endpoint->message_queue()->Swap(&messages_with_contexts);
+    }
+    endpoints_[port]->Close();
+    if (endpoints_[peer_port]) {
+      if (!endpoints_[peer_port]->OnPeerClose())
+        endpoints_[peer_port].reset();
+    }
+    endpoints_[port].reset();
   }
-  endpoints_[port].reset();
+  messages_with_contexts.Clear();
 }
 
 // TODO(vtl): Handle flags.
@@ -148,13 +169,63 @@ MojoResult MessagePipe::WriteMessage(
     MojoWriteMessageFlags flags) {
   DCHECK(port == 0 || port == 1);
 
+  scoped_ptr<MessageInTransit> message(new MessageInTransit(
+      MessageInTransit::Type::ENDPOINT_CLIENT,
+      MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA, num_bytes, bytes));
+  if (!transports && TryEnqueueMessageLockFree(GetPeerPort(port), &message))
+    return MOJO_RESULT_OK;
+
   base::AutoLock locker(lock_);
-  return EnqueueMessageNoLock(
-      GetPeerPort(port),
-      make_scoped_ptr(new MessageInTransit(
-          MessageInTransit::Type::ENDPOINT_CLIENT,
-          MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA, num_bytes, bytes)),
-      transports);
+  return EnqueueMessageNoLock(GetPeerPort(port), message.Pass(), transports);
+}
+
+MojoResult MessagePipe::WriteMessages(
+    unsigned port,
+    UserPointer<const void> bytes,
+    const uint32_t* message_num_bytes,
+    std::vector<DispatcherTransport>* transports,
+    const uint32_t* message_num_transports,
+    uint32_t num_messages,
+    MojoWriteMessageFlags flags) {
+  DCHECK(port == 0 || port == 1);
+  DCHECK_GT(num_messages, 0u);
+  DCHECK(!transports || message_num_transports);
+
+  base::AutoLock locker(lock_);
+  unsigned peer_port = GetPeerPort(port);
+  DCHECK(endpoints_[port]);
+
+  // The destination port need not be open, unlike the source port.
+  if (!endpoints_[peer_port])
+    return MOJO_RESULT_FAILED_PRECONDITION;
+
+  if (transports) {
+    MojoResult result = CheckTransportsNoLock(peer_port, transports);
+    if (result != MOJO_RESULT_OK)
+      return result;
+  }
+
+  // Nothing can fail from here on.
+  MessageInTransitQueue messages;
+  size_t bytes_offset = 0;
+  size_t transports_offset = 0;
+  for (uint32_t i = 0; i < num_messages; i++) {
+    scoped_ptr<MessageInTransit> message(new MessageInTransit(
+        MessageInTransit::Type::ENDPOINT_CLIENT,
+        MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA, message_num_bytes[i],
+        bytes.At(bytes_offset)));
+    bytes_offset += message_num_bytes[i];
+    if (transports && message_num_transports[i] > 0) {
+      AttachTransportsNoLock(message.get(), transports, transports_offset,
+                             message_num_transports[i]);
+      transports_offset += message_num_transports[i];
+    }
+    messages.AddMessage(message.Pass());
+  }
+  DCHECK(!transports || transports_offset == transports->size());
+
+  endpoints_[peer_port]->EnqueueMessages(&messages);
+  return MOJO_RESULT_OK;
 }
 
 MojoResult MessagePipe::ReadMessage(unsigned port,
@@ -165,13 +236,129 @@ MojoResult MessagePipe::ReadMessage(unsigned port,
                                     MojoReadMessageFlags flags) {
   DCHECK(port == 0 || port == 1);
 
+  // Only we (the reader) clear |lock_free_enabled_[port]|, so this is safe.
+  if (base::subtle::NoBarrier_Load(&lock_free_enabled_[port])) {
+    MojoResult result;
+    if (static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get())
+            ->TryReadMessageLockFree(bytes, num_bytes, num_dispatchers, flags,
+                                     &result))
+      return result;
+  }
+
   base::AutoLock locker(lock_);
   DCHECK(endpoints_[port]);
 
+  SerializeMessageContextsNoLock(port);
   return endpoints_[port]->ReadMessage(bytes, num_bytes, dispatchers,
                                        num_dispatchers, flags);
 }
 
+MojoResult MessagePipe::ReadMessages(
+    unsigned port,
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    DispatcherVector* dispatchers,
+    uint32_t* num_dispatchers,
+    UserPointer<uint32_t> message_num_bytes,
+    UserPointer<uint32_t> message_num_dispatchers,
+    UserPointer<uint32_t> num_messages,
+    MojoReadMessageFlags flags) {
+  DCHECK(port == 0 || port == 1);
+
+  base::AutoLock locker(lock_);
+  DCHECK(endpoints_[port]);
+
+  SerializeMessageContextsNoLock(port);
+  return endpoints_[port]->ReadMessages(
+      bytes, num_bytes, dispatchers, num_dispatchers, message_num_bytes,
+      message_num_dispatchers, num_messages, flags);
+}
+
+MojoResult MessagePipe::WriteMessageContext(
+    unsigned port,
+    uintptr_t context,
+    const MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  DCHECK(port == 0 || port == 1);
+
+  unsigned peer_port = GetPeerPort(port);
+
+  // The thunks are only called without |lock_| (see the class comment).
+  uint32_t num_bytes = thunks->GetSerializedSize(context);
+  if (num_bytes > GetConfiguration().max_message_num_bytes)
+    return MOJO_RESULT_RESOURCE_EXHAUSTED;
+
+  {
+    base::AutoLock locker(lock_);
+    DCHECK(endpoints_[port]);
+
+    // The destination port need not be open, unlike the source port.
+    if (!endpoints_[peer_port])
+      return MOJO_RESULT_FAILED_PRECONDITION;
+
+    if (endpoints_[peer_port]->GetType() == MessagePipeEndpoint::kTypeLocal &&
+        static_cast<LocalMessagePipeEndpoint*>(endpoints_[peer_port].get())
+                ->message_context_thunks() == thunks) {
+      // (Enqueueing a message without transports to a local port can't fail.)
+      return EnqueueMessageNoLock(
+          peer_port, make_scoped_ptr(new MessageInTransit(
+                         MessageInTransit::Type::ENDPOINT_CLIENT,
+                         MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA,
+                         thunks, context, num_bytes)),
+          nullptr);
+    }
+  }
+
+  // Otherwise, serialize it (without |lock_|), and only destroy the context
+  // once the message has been enqueued.
+  scoped_ptr<MessageInTransit> message(new MessageInTransit(
+      MessageInTransit::Type::ENDPOINT_CLIENT,
+      MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA, num_bytes, nullptr));
+  thunks->Serialize(context, message->bytes(), num_bytes);
+  MojoResult result;
+  {
+    base::AutoLock locker(lock_);
+    result = EnqueueMessageNoLock(peer_port, message.Pass(), nullptr);
+  }
+  if (result == MOJO_RESULT_OK)
+    thunks->Destroy(context);
+  return result;
+}
+
+MojoResult MessagePipe::ReadMessageContext(
+    unsigned port,
+    const MojoMessageContextThunks* thunks,
+    uintptr_t* context,
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    DispatcherVector* dispatchers,
+    uint32_t* num_dispatchers,
+    MojoReadMessageFlags flags) {
+  DCHECK(port == 0 || port == 1);
+
+  base::AutoLock locker(lock_);
+  DCHECK(endpoints_[port]);
+  DCHECK_EQ(endpoints_[port]->GetType(), MessagePipeEndpoint::kTypeLocal);
+
+  // Contexts queued with different thunks can't be read with |thunks|.
+  if (static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get())
+          ->message_context_thunks() != thunks)
+    SerializeMessageContextsNoLock(port);
+  return static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get())
+      ->ReadMessageContext(thunks, context, bytes, num_bytes, dispatchers,
+                           num_dispatchers, flags);
+}
+
+void MessagePipe::SerializeMessageContexts(unsigned port) {
+  DCHECK(port == 0 || port == 1);
+
+  base::AutoLock locker(lock_);
+  DCHECK(endpoints_[port]);
+  DCHECK_EQ(endpoints_[port]->GetType(), MessagePipeEndpoint::kTypeLocal);
+
+  SerializeMessageContextsNoLock(port);
+}
+
 HandleSignalsState MessagePipe::GetHandleSignalsState(unsigned port) const {
   DCHECK(port == 0 || port == 1);
 
@@ -229,9 +416,14 @@ bool MessagePipe::EndSerialize(
   DCHECK_EQ(endpoints_[port]->GetType(), MessagePipeEndpoint::kTypeLocal);
 
   unsigned peer_port = GetPeerPort(port);
-  MessageInTransitQueue* message_queue =
-      static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get())
-          ->message_queue();
+  StopLockFreeEnqueueNoLock(port);
+  LocalMessagePipeEndpoint* endpoint =
+      static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get());
+  // Queued messages can't be sent with their contexts, but they were already
+  // serialized when |port|'s dispatcher was transferred (which also stopped any
+  // more being enqueued).
+  DCHECK(!endpoint->message_context_thunks());
+  MessageInTransitQueue* message_queue = endpoint->message_queue();
   // The replacement for |endpoints_[port]|, if any.
   MessagePipeEndpoint* replacement_endpoint = nullptr;
 
@@ -301,6 +493,10 @@ void MessagePipe::OnDetachFromChannel(unsigned port) {
 }
 
 MessagePipe::MessagePipe() {
+  for (size_t i = 0; i < 2; i++) {
+    lock_free_enabled_[i] = 0;
+    lock_free_enqueue_in_progress_[i] = 0;
+  }
 }
 
 MessagePipe::~MessagePipe() {
@@ -326,9 +522,10 @@ MojoResult MessagePipe::EnqueueMessageNoLock(
     return MOJO_RESULT_FAILED_PRECONDITION;
 
   if (transports) {
-    MojoResult result = AttachTransportsNoLock(port, message.get(), transports);
+    MojoResult result = CheckTransportsNoLock(port, transports);
     if (result != MOJO_RESULT_OK)
       return result;
+    AttachTransportsNoLock(message.get(), transports, 0, transports->size());
   }
 
   // The endpoint's |EnqueueMessage()| may not report failure.
@@ -336,12 +533,9 @@ MojoResult MessagePipe::EnqueueMessageNoLock(
   return MOJO_RESULT_OK;
 }
 
-MojoResult MessagePipe::AttachTransportsNoLock(
+MojoResult MessagePipe::CheckTransportsNoLock(
     unsigned port,
-    MessageInTransit* message,
     std::vector<DispatcherTransport>* transports) {
-  DCHECK(!message->has_dispatchers());
-
   // You're not allowed to send either handle to a message pipe over the message
   // pipe, so check for this. (The case of trying to write a handle to itself is
   // taken care of by |Core|. That case kind of makes sense, but leads to
@@ -349,9 +543,15 @@ MojoResult MessagePipe::AttachTransportsNoLock(
   // respective handles simultaneously. The other case, of trying to write the
   // peer handle to a handle, doesn't make sense -- since no handle will be
   // available to read the message from.)
+  //
+  // Wait sets may not be sent at all: they call into their members'
+  // dispatchers under their own dispatcher locks (see wait_set_dispatcher.h),
+  // which is only safe because they stay in the handle table.
   for (size_t i = 0; i < transports->size(); i++) {
     if (!(*transports)[i].is_valid())
       continue;
+    if ((*transports)[i].GetType() == Dispatcher::Type::WAIT_SET)
+      return MOJO_RESULT_INVALID_ARGUMENT;
     if ((*transports)[i].GetType() == Dispatcher::Type::MESSAGE_PIPE) {
       MessagePipeDispatcherTransport mp_transport((*transports)[i]);
       if (mp_transport.GetMessagePipe() == this) {
@@ -362,12 +562,23 @@ MojoResult MessagePipe::AttachTransportsNoLock(
       }
     }
   }
+  return MOJO_RESULT_OK;
+}
 
-  // Clone the dispatchers and attach them to the message. (This must be done as
-  // a separate loop, since we want to leave the dispatchers alone on failure.)
+void MessagePipe::AttachTransportsNoLock(
+    MessageInTransit* message,
+    std::vector<DispatcherTransport>* transports,
+    size_t first,
+    size_t num_transports) {
+  DCHECK(!message->has_dispatchers());
+  DCHECK_LE(first + num_transports, transports->size());
+
+  // Clone the dispatchers and attach them to the message. (This is done
+  // separately from checking them, since we want to leave the dispatchers
+  // alone on failure.)
   scoped_ptr<DispatcherVector> dispatchers(new DispatcherVector());
-  dispatchers->reserve(transports->size());
-  for (size_t i = 0; i < transports->size(); i++) {
+  dispatchers->reserve(num_transports);
+  for (size_t i = first; i < first + num_transports; i++) {
     if ((*transports)[i].is_valid()) {
       dispatchers->push_back(
           (*transports)[i].CreateEquivalentDispatcherAndClose());
@@ -377,7 +588,96 @@ MojoResult MessagePipe::AttachTransportsNoLock(
     }
   }
   message->SetDispatchers(dispatchers.Pass());
-  return MOJO_RESULT_OK;
+}
+
+bool MessagePipe::TryEnqueueMessageLockFree(
+    unsigned port,
+    scoped_ptr<MessageInTransit>* message) {
+  DCHECK(port == 0 || port == 1);
+
+  // This pairs with the barrier in |StopLockFreeEnqueueNoLock()|: either it
+  // sees that we're enqueueing (and waits for us), or we see that we can't.
+  base::subtle::NoBarrier_Store(&lock_free_enqueue_in_progress_[port], 1);
+  base::subtle::MemoryBarrier();
+  bool enqueued = false;
+  bool should_awake = false;
+  if (base::subtle::NoBarrier_Load(&lock_free_enabled_[port])) {
+    enqueued = static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get())
+                   ->TryEnqueueMessageLockFree(message, &should_awake);
+  }
+  base::subtle::Release_Store(&lock_free_enqueue_in_progress_[port], 0);
+
+  if (should_awake) {
+    base::AutoLock locker(lock_);
+    // The port may have been closed or transferred in the meantime, in which
+    // case there's no one to awake anymore.
+    if (endpoints_[port] &&
+        endpoints_[port]->GetType() == MessagePipeEndpoint::kTypeLocal) {
+      static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get())
+          ->AwakeForLockFreeEnqueue();
+    }
+  }
+  return enqueued;
+}
+
+void MessagePipe::StopLockFreeEnqueueNoLock(unsigned port) {
+  DCHECK(port == 0 || port == 1);
+  lock_.AssertAcquired();
+  DCHECK(endpoints_[port]);
+
+  if (endpoints_[port]->GetType() != MessagePipeEndpoint::kTypeLocal) {
+    DCHECK(!base::subtle::NoBarrier_Load(&lock_free_enabled_[port]));
+    return;
+  }
+
+  if (base::subtle::NoBarrier_Load(&lock_free_enabled_[port])) {
+    base::subtle::NoBarrier_Store(&lock_free_enabled_[port], 0);
+    base::subtle::MemoryBarrier();
+    // The writer doesn't take |lock_| while it's enqueueing, so this is short.
+    while (base::subtle::Acquire_Load(&lock_free_enqueue_in_progress_[port]))
+      base::PlatformThread::YieldCurrentThread();
+  }
+
+  // (Messages may be in the endpoint's ring even if it was only ever written
+  // to under |lock_|.)
+  static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get())
+      ->MoveRingToMessageQueue();
+}
+
+void MessagePipe::SerializeMessageContextsNoLock(unsigned port) {
+  lock_.AssertAcquired();
+  DCHECK(endpoints_[port]);
+
+  if (endpoints_[port]->GetType() != MessagePipeEndpoint::kTypeLocal)
+    return;
+  LocalMessagePipeEndpoint* endpoint =
+      static_cast<LocalMessagePipeEndpoint*>(endpoints_[port].get());
+  std::vector<MessageInTransit*> messages;
+  endpoint->StopMessageContexts(&messages);
+  if (messages.empty())
+    return;
+
+  // Serialize (and destroy) the contexts without |lock_|. Meanwhile, the writer
+  // may enqueue more messages (without contexts) and move messages from the
+  // front of the message queue to the ring, but only up to the first message
+  // with a context; the messages themselves aren't modified, and only |port|'s
+  // own calls (which are serialized with this one) remove them.
+  ScopedVector<MessageInTransit> serialized_messages;
+  {
+    base::AutoUnlock unlocker(lock_);
+    for (MessageInTransit* message : messages)
+      serialized_messages.push_back(message->SerializeContext().release());
+  }
+
+  DCHECK_EQ(endpoints_[port].get(), endpoint);
+  for (size_t i = 0; i < messages.size(); i++) {
+    scoped_ptr<MessageInTransit> message =
+        endpoint->message_queue()->ReplaceMessage(
+            messages[i], make_scoped_ptr(serialized_messages[i]));
+    // Its context was destroyed by |SerializeContext()|.
+    message->ReleaseContext();
+  }
+  serialized_messages.weak_clear();
 }
 
 }  // namespace system
@@ -10,6 +10,7 @@
 
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
@@ -35,7 +36,19 @@ class MessageInTransitQueue;
 
 // |MessagePipe| is the secondary object implementing a message pipe (see the
 // explanatory comment in core.cc). It is typically owned by the dispatcher(s)
-// corresponding to the local endpoints. This class is thread-safe.
+// corresponding to the local endpoints. This class is thread-safe, except that
+// calls for any given port (i.e., from its dispatcher) must be serialized.
+//
+// Messages written without handles between two local ports go through a
+// lock-free single-producer/single-consumer ring at the destination endpoint
+// (see |LocalMessagePipeEndpoint|) and are read from it without |lock_|, so
+// that a writer thread and a reader thread don't contend on |lock_|. Anything
+// else (attaching handles, closing or transferring a port, waiting, etc.) takes
+// |lock_|.
+//
+// Message contexts' thunks (see |WriteMessageContext()|) are user code, so they
+// are never called with |lock_| held (though they may be called with the
+// calling port's dispatcher's lock held).
 class MOJO_SYSTEM_IMPL_EXPORT MessagePipe : public ChannelEndpointClient {
  public:
   // Creates a |MessagePipe| with two new |LocalMessagePipeEndpoint|s.
@@ -90,12 +103,53 @@ class MOJO_SYSTEM_IMPL_EXPORT MessagePipe : public ChannelEndpointClient {
                           uint32_t num_bytes,
                           std::vector<DispatcherTransport>* transports,
                           MojoWriteMessageFlags flags);
+  // Writes |num_messages| messages, whose sizes are given by
+  // |message_num_bytes|, taking the given numbers of |*transports| (if
+  // non-null) in order. Either all of them are enqueued or (on failure) none.
+  MojoResult WriteMessages(unsigned port,
+                           UserPointer<const void> bytes,
+                           const uint32_t* message_num_bytes,
+                           std::vector<DispatcherTransport>* transports,
+                           const uint32_t* message_num_transports,
+                           uint32_t num_messages,
+                           MojoWriteMessageFlags flags);
   MojoResult ReadMessage(unsigned port,
                          UserPointer<void> bytes,
                          UserPointer<uint32_t> num_bytes,
                          DispatcherVector* dispatchers,
                          uint32_t* num_dispatchers,
                          MojoReadMessageFlags flags);
+  MojoResult ReadMessages(unsigned port,
+                          UserPointer<void> bytes,
+                          UserPointer<uint32_t> num_bytes,
+                          DispatcherVector* dispatchers,
+                          uint32_t* num_dispatchers,
+                          UserPointer<uint32_t> message_num_bytes,
+                          UserPointer<uint32_t> message_num_dispatchers,
+                          UserPointer<uint32_t> num_messages,
+                          MojoReadMessageFlags flags);
+  // The message is written with its context (unserialized) only if the peer
+  // port is local and was last read using |ReadMessageContext()| with the same
+  // |thunks|; otherwise it's serialized right away. Either way, its serialized
+  // size is checked against |max_message_num_bytes| first. On failure, the
+  // caller retains ownership of |context|.
+  MojoResult WriteMessageContext(unsigned port,
+                                 uintptr_t context,
+                                 const MojoMessageContextThunks* thunks,
+                                 MojoWriteMessageFlags flags);
+  MojoResult ReadMessageContext(unsigned port,
+                                const MojoMessageContextThunks* thunks,
+                                uintptr_t* context,
+                                UserPointer<void> bytes,
+                                UserPointer<uint32_t> num_bytes,
+                                DispatcherVector* dispatchers,
+                                uint32_t* num_dispatchers,
+                                MojoReadMessageFlags flags);
+  // Serializes any message contexts queued at |port| (which must be local), and
+  // stops unserialized messages being written to it until it's next read
+  // using |ReadMessageContext()|. This is called when |port| is transferred
+  // (with its dispatcher's lock held).
+  void SerializeMessageContexts(unsigned port);
   HandleSignalsState GetHandleSignalsState(unsigned port) const;
   MojoResult AddAwakable(unsigned port,
                          Awakable* awakable,
@@ -130,13 +184,48 @@ class MOJO_SYSTEM_IMPL_EXPORT MessagePipe : public ChannelEndpointClient {
                                   scoped_ptr<MessageInTransit> message,
                                   std::vector<DispatcherTransport>* transports);
 
-  // Helper for |EnqueueMessageNoLock()|. Must be called with |lock_| held.
-  MojoResult AttachTransportsNoLock(
+  // Helpers for |EnqueueMessageNoLock()| and |WriteMessages()|. These must be
+  // called with |lock_| held. |CheckTransportsNoLock()| checks that all of
+  // |*transports| may be sent to |port|; |AttachTransportsNoLock()| then
+  // attaches equivalents of |num_transports| of them, starting at |first|, to
+  // |message| (and closes the originals).
+  MojoResult CheckTransportsNoLock(
       unsigned port,
-      MessageInTransit* message,
       std::vector<DispatcherTransport>* transports);
+  void AttachTransportsNoLock(MessageInTransit* message,
+                              std::vector<DispatcherTransport>* transports,
+                              size_t first,
+                              size_t num_transports);
+
+  // Tries to enqueue |*message| (which must have no dispatchers attached) to
+  // |port| without taking |lock_|. Returns false (leaving |*message| alone) if
+  // it couldn't.
+  bool TryEnqueueMessageLockFree(unsigned port,
+                                 scoped_ptr<MessageInTransit>* message);
+  // If |port| is local, stops messages being enqueued to it without |lock_|
+  // (waiting for any such enqueue in progress to finish), and moves any
+  // messages in its endpoint's ring to its message queue. This must be called
+  // (with |lock_| held) before |port|'s endpoint is closed or serialized.
+  void StopLockFreeEnqueueNoLock(unsigned port);
+
+  // Implements |SerializeMessageContexts()| (also used before messages are
+  // read other than by |ReadMessageContext()| with the same thunks). This must
+  // be called with |lock_| held, but releases it while serializing (i.e.,
+  // calling into user code); the queued messages stay put meanwhile, since
+  // only |port|'s own (serialized) calls remove them.
+  void SerializeMessageContextsNoLock(unsigned port);
+
+  // For each port, |lock_free_enabled_| is set while messages may be enqueued
+  // to (and read from) the port's |LocalMessagePipeEndpoint| without |lock_|;
+  // it's only cleared (under |lock_|) by the port's own |Close()| or
+  // |EndSerialize()|. |lock_free_enqueue_in_progress_| is set while the peer
+  // port's writer is (possibly) enqueueing to the port without |lock_|.
+  base::subtle::Atomic32 lock_free_enabled_[2];
+  base::subtle::Atomic32 lock_free_enqueue_in_progress_[2];
 
   base::Lock lock_;  // Protects the following members.
+  // (While |lock_free_enabled_[i]| is set, |endpoints_[i]| doesn't change, and
+  // may be accessed as described above.)
   scoped_ptr<MessagePipeEndpoint> endpoints_[2];
 
   DISALLOW_COPY_AND_ASSIGN(MessagePipe);
@@ -132,6 +132,10 @@ scoped_refptr<Dispatcher>
 MessagePipeDispatcher::CreateEquivalentDispatcherAndCloseImplNoLock() {
   lock().AssertAcquired();
 
+  // The handle may be going to code that doesn't know about any message
+  // contexts queued for it.
+  message_pipe_->SerializeMessageContexts(port_);
+
   // TODO(vtl): Currently, there are no options, so we just use
   // |kDefaultCreateOptions|. Eventually, we'll have to duplicate the options
   // too.
@@ -161,6 +165,25 @@ MojoResult MessagePipeDispatcher::WriteMessageImplNoLock(
                                      flags);
 }
 
+MojoResult MessagePipeDispatcher::WriteMessagesImplNoLock(
+    UserPointer<const void> bytes,
+    const uint32_t* message_num_bytes,
+    std::vector<DispatcherTransport>* transports,
+    const uint32_t* message_num_transports,
+    uint32_t num_messages,
+    MojoWriteMessageFlags flags) {
+  lock().AssertAcquired();
+
+  for (uint32_t i = 0; i < num_messages; i++) {
+    if (message_num_bytes[i] > GetConfiguration().max_message_num_bytes)
+      return MOJO_RESULT_RESOURCE_EXHAUSTED;
+  }
+
+  return message_pipe_->WriteMessages(port_, bytes, message_num_bytes,
+                                      transports, message_num_transports,
+                                      num_messages, flags);
+}
+
 MojoResult MessagePipeDispatcher::ReadMessageImplNoLock(
     UserPointer<void> bytes,
     UserPointer<uint32_t> num_bytes,
@@ -172,6 +195,44 @@ MojoResult MessagePipeDispatcher::ReadMessageImplNoLock(
                                     num_dispatchers, flags);
 }
 
+MojoResult MessagePipeDispatcher::ReadMessagesImplNoLock(
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    DispatcherVector* dispatchers,
+    uint32_t* num_dispatchers,
+    UserPointer<uint32_t> message_num_bytes,
+    UserPointer<uint32_t> message_num_dispatchers,
+    UserPointer<uint32_t> num_messages,
+    MojoReadMessageFlags flags) {
+  lock().AssertAcquired();
+  return message_pipe_->ReadMessages(port_, bytes, num_bytes, dispatchers,
+                                     num_dispatchers, message_num_bytes,
+                                     message_num_dispatchers, num_messages,
+                                     flags);
+}
+
+MojoResult MessagePipeDispatcher::WriteMessageContextImplNoLock(
+    uintptr_t context,
+    const MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  lock().AssertAcquired();
+  return message_pipe_->WriteMessageContext(port_, context, thunks, flags);
+}
+
+MojoResult MessagePipeDispatcher::ReadMessageContextImplNoLock(
+    const MojoMessageContextThunks* thunks,
+    uintptr_t* context,
+    UserPointer<void> bytes,
+    UserPointer<uint32_t> num_bytes,
+    DispatcherVector* dispatchers,
+    uint32_t* num_dispatchers,
+    MojoReadMessageFlags flags) {
+  lock().AssertAcquired();
+  return message_pipe_->ReadMessageContext(port_, thunks, context, bytes,
+                                           num_bytes, dispatchers,
+                                           num_dispatchers, flags);
+}
+
 HandleSignalsState MessagePipeDispatcher::GetHandleSignalsStateImplNoLock()
     const {
   lock().AssertAcquired();
@@ -82,11 +82,39 @@ class MOJO_SYSTEM_IMPL_EXPORT MessagePipeDispatcher : public Dispatcher {
       uint32_t num_bytes,
       std::vector<DispatcherTransport>* transports,
       MojoWriteMessageFlags flags) override;
+  MojoResult WriteMessagesImplNoLock(
+      UserPointer<const void> bytes,
+      const uint32_t* message_num_bytes,
+      std::vector<DispatcherTransport>* transports,
+      const uint32_t* message_num_transports,
+      uint32_t num_messages,
+      MojoWriteMessageFlags flags) override;
   MojoResult ReadMessageImplNoLock(UserPointer<void> bytes,
                                    UserPointer<uint32_t> num_bytes,
                                    DispatcherVector* dispatchers,
                                    uint32_t* num_dispatchers,
                                    MojoReadMessageFlags flags) override;
+  MojoResult ReadMessagesImplNoLock(
+      UserPointer<void> bytes,
+      UserPointer<uint32_t> num_bytes,
+      DispatcherVector* dispatchers,
+      uint32_t* num_dispatchers,
+      UserPointer<uint32_t> message_num_bytes,
+      UserPointer<uint32_t> message_num_dispatchers,
+      UserPointer<uint32_t> num_messages,
+      MojoReadMessageFlags flags) override;
+  MojoResult WriteMessageContextImplNoLock(
+      uintptr_t context,
+      const MojoMessageContextThunks* thunks,
+      MojoWriteMessageFlags flags) override;
+  MojoResult ReadMessageContextImplNoLock(
+      const MojoMessageContextThunks* thunks,
+      uintptr_t* context,
+      UserPointer<void> bytes,
+      UserPointer<uint32_t> num_bytes,
+      DispatcherVector* dispatchers,
+      uint32_t* num_dispatchers,
+      MojoReadMessageFlags flags) override;
   HandleSignalsState GetHandleSignalsStateImplNoLock() const override;
   MojoResult AddAwakableImplNoLock(Awakable* awakable,
                                    MojoHandleSignals signals,
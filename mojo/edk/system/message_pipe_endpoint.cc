@@ -9,6 +9,11 @@
 namespace mojo {
 namespace system {
 
+void MessagePipeEndpoint::EnqueueMessages(MessageInTransitQueue* messages) {
+  while (!messages->IsEmpty())
+    EnqueueMessage(messages->GetMessage());
+}
+
 void MessagePipeEndpoint::CancelAllAwakables() {
   NOTREACHED();
 }
@@ -22,6 +27,19 @@ MojoResult MessagePipeEndpoint::ReadMessage(UserPointer<void> /*bytes*/,
   return MOJO_RESULT_INTERNAL;
 }
 
+MojoResult MessagePipeEndpoint::ReadMessages(
+    UserPointer<void> /*bytes*/,
+    UserPointer<uint32_t> /*num_bytes*/,
+    DispatcherVector* /*dispatchers*/,
+    uint32_t* /*num_dispatchers*/,
+    UserPointer<uint32_t> /*message_num_bytes*/,
+    UserPointer<uint32_t> /*message_num_dispatchers*/,
+    UserPointer<uint32_t> /*num_messages*/,
+    MojoReadMessageFlags /*flags*/) {
+  NOTREACHED();
+  return MOJO_RESULT_INTERNAL;
+}
+
 HandleSignalsState MessagePipeEndpoint::GetHandleSignalsState() const {
   NOTREACHED();
   return HandleSignalsState();
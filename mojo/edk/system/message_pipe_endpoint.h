@@ -15,6 +15,7 @@
 #include "mojo/edk/system/dispatcher.h"
 #include "mojo/edk/system/memory.h"
 #include "mojo/edk/system/message_in_transit.h"
+#include "mojo/edk/system/message_in_transit_queue.h"
 #include "mojo/edk/system/system_impl_export.h"
 #include "mojo/public/c/system/message_pipe.h"
 #include "mojo/public/c/system/types.h"
@@ -50,6 +51,11 @@ class MOJO_SYSTEM_IMPL_EXPORT MessagePipeEndpoint {
   virtual void EnqueueMessage(scoped_ptr<MessageInTransit> message) = 0;
   virtual void Close() = 0;
 
+  // Implements |MessagePipe::WriteMessages()|, taking all the messages from
+  // |*messages| (as for |EnqueueMessage()|). By default, this enqueues them one
+  // at a time.
+  virtual void EnqueueMessages(MessageInTransitQueue* messages);
+
   // Implementations must override these if they represent a local endpoint,
   // i.e., one for which there's a |MessagePipeDispatcher| (and thus a handle).
   // An implementation for a proxy endpoint (for which there's no dispatcher)
@@ -64,6 +70,14 @@ class MOJO_SYSTEM_IMPL_EXPORT MessagePipeEndpoint {
                                  DispatcherVector* dispatchers,
                                  uint32_t* num_dispatchers,
                                  MojoReadMessageFlags flags);
+  virtual MojoResult ReadMessages(UserPointer<void> bytes,
+                                  UserPointer<uint32_t> num_bytes,
+                                  DispatcherVector* dispatchers,
+                                  uint32_t* num_dispatchers,
+                                  UserPointer<uint32_t> message_num_bytes,
+                                  UserPointer<uint32_t> message_num_dispatchers,
+                                  UserPointer<uint32_t> num_messages,
+                                  MojoReadMessageFlags flags);
   virtual HandleSignalsState GetHandleSignalsState() const;
   virtual MojoResult AddAwakable(Awakable* awakable,
                                  MojoHandleSignals signals,
@@ -15,6 +15,7 @@
 #include "base/macros.h"
 #include "base/strings/stringprintf.h"
 #include "base/test/perf_time_logger.h"
+#include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "mojo/edk/embedder/scoped_platform_handle.h"
 #include "mojo/edk/system/channel.h"
@@ -24,6 +25,7 @@
 #include "mojo/edk/system/proxy_message_pipe_endpoint.h"
 #include "mojo/edk/system/raw_channel.h"
 #include "mojo/edk/system/test_utils.h"
+#include "mojo/edk/system/waiter.h"
 #include "mojo/edk/test/test_utils.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -165,6 +167,87 @@ TEST_F(MultiprocessMessagePipePerfTest, MAYBE_PingPong) {
   EXPECT_EQ(0, helper()->WaitForChildShutdown());
 }
 
+// Writes |message_count| messages of |message_size| bytes each to port 0 of
+// the given message pipe, as fast as it can.
+class ThroughputWriterThread : public base::SimpleThread {
+ public:
+  ThroughputWriterThread(scoped_refptr<MessagePipe> mp,
+                         int message_count,
+                         size_t message_size)
+      : base::SimpleThread("throughput_writer_thread"),
+        mp_(mp),
+        message_count_(message_count),
+        payload_(message_size, '*') {}
+  ~ThroughputWriterThread() override { Join(); }
+
+ private:
+  void Run() override {
+    for (int i = 0; i < message_count_; i++) {
+      CHECK_EQ(mp_->WriteMessage(0, UserPointer<const void>(payload_.data()),
+                                 static_cast<uint32_t>(payload_.size()),
+                                 nullptr, MOJO_WRITE_MESSAGE_FLAG_NONE),
+               MOJO_RESULT_OK);
+    }
+  }
+
+  const scoped_refptr<MessagePipe> mp_;
+  const int message_count_;
+  const std::string payload_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThroughputWriterThread);
+};
+
+// Measures how long it takes to read messages (on this thread) from a local
+// message pipe, as they're written by another thread.
+TEST(MessagePipePerfTest, Throughput) {
+  const size_t kMsgSize[3] = {12, 144, 1728};
+  const int kMessageCount[3] = {500000, 500000, 200000};
+
+  for (size_t i = 0; i < arraysize(kMsgSize); i++) {
+    scoped_refptr<MessagePipe> mp(MessagePipe::CreateLocalLocal());
+    std::string read_buffer(kMsgSize[i], '\0');
+
+    std::string test_name =
+        base::StringPrintf("MessagePipe_Throughput_%dx_%u", kMessageCount[i],
+                           static_cast<unsigned>(kMsgSize[i]));
+    base::PerfTimeLogger logger(test_name.c_str());
+    {
+      ThroughputWriterThread writer(mp, kMessageCount[i], kMsgSize[i]);
+      writer.Start();
+
+      int messages_read = 0;
+      while (messages_read < kMessageCount[i]) {
+        uint32_t read_size = static_cast<uint32_t>(read_buffer.size());
+        MojoResult result =
+            mp->ReadMessage(1, UserPointer<void>(&read_buffer[0]),
+                            MakeUserPointer(&read_size), nullptr, nullptr,
+                            MOJO_READ_MESSAGE_FLAG_NONE);
+        if (result == MOJO_RESULT_OK) {
+          CHECK_EQ(read_size, static_cast<uint32_t>(kMsgSize[i]));
+          messages_read++;
+          continue;
+        }
+        CHECK_EQ(result, MOJO_RESULT_SHOULD_WAIT);
+
+        Waiter waiter;
+        waiter.Init();
+        result = mp->AddAwakable(1, &waiter, MOJO_HANDLE_SIGNAL_READABLE, 0,
+                                 nullptr);
+        if (result == MOJO_RESULT_ALREADY_EXISTS)
+          continue;
+        CHECK_EQ(result, MOJO_RESULT_OK);
+        CHECK_EQ(waiter.Wait(MOJO_DEADLINE_INDEFINITE, nullptr),
+                 MOJO_RESULT_OK);
+        mp->RemoveAwakable(1, &waiter, nullptr);
+      }
+    }
+    logger.Done();
+
+    mp->Close(0);
+    mp->Close(1);
+  }
+}
+
 }  // namespace
 }  // namespace system
 }  // namespace mojo
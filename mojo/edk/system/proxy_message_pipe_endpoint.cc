@@ -54,6 +54,13 @@ void ProxyMessagePipeEndpoint::Close() {
   DetachIfNecessary();
 }
 
+void ProxyMessagePipeEndpoint::EnqueueMessages(
+    MessageInTransitQueue* messages) {
+  DCHECK(channel_endpoint_);
+  bool ok = channel_endpoint_->EnqueueMessages(messages);
+  LOG_IF(WARNING, !ok) << "Failed to write enqueue messages to channel";
+}
+
 void ProxyMessagePipeEndpoint::DetachIfNecessary() {
   if (channel_endpoint_) {
     channel_endpoint_->DetachFromClient();
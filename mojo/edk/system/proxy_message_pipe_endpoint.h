@@ -46,6 +46,7 @@ class MOJO_SYSTEM_IMPL_EXPORT ProxyMessagePipeEndpoint
   bool OnPeerClose() override;
   void EnqueueMessage(scoped_ptr<MessageInTransit> message) override;
   void Close() override;
+  void EnqueueMessages(MessageInTransitQueue* messages) override;
 
  private:
   void DetachIfNecessary();
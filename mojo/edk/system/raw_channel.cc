@@ -13,26 +13,79 @@
 #include "base/logging.h"
 #include "base/message_loop/message_loop.h"
 #include "base/stl_util.h"
+#include "mojo/edk/embedder/platform_handle_vector.h"
 #include "mojo/edk/system/message_in_transit.h"
 #include "mojo/edk/system/transport_data.h"
 
 namespace mojo {
 namespace system {
 
-const size_t kReadSize = 4096;
+namespace {
+
+// Reads are never smaller than this.
+const size_t kMinReadSize = 4096;
+// The (adaptive) read size never grows beyond this, even if the next message
+// is known to be bigger. (Reads are bounded by the amount of data buffered in
+// the OS anyway, so there's little point in going much bigger.)
+const size_t kMaxReadSize = 1024 * 1024;
+// The maximum number of reads to do for a single |OnReadCompleted()| (i.e.,
+// I/O thread wakeup), so that other users of the message loop aren't starved.
+const size_t kMaxReadsPerWakeup = 16;
+
+}  // namespace
 
 // RawChannel::ReadBuffer ------------------------------------------------------
 
-RawChannel::ReadBuffer::ReadBuffer() : buffer_(kReadSize), num_valid_bytes_(0) {
+RawChannel::ReadBuffer::ReadBuffer()
+    : buffer_(static_cast<char*>(
+          base::AlignedAlloc(kMinReadSize,
+                             MessageInTransit::kMessageAlignment))),
+      buffer_size_(kMinReadSize),
+      read_start_(0),
+      num_valid_bytes_(0),
+      read_size_(kMinReadSize),
+      preferred_read_size_(kMinReadSize) {
 }
 
 RawChannel::ReadBuffer::~ReadBuffer() {
 }
 
 void RawChannel::ReadBuffer::GetBuffer(char** addr, size_t* size) {
-  DCHECK_GE(buffer_.size(), num_valid_bytes_ + kReadSize);
-  *addr = &buffer_[0] + num_valid_bytes_;
-  *size = kReadSize;
+  DCHECK_GE(buffer_size_, read_start_ + num_valid_bytes_ + read_size_);
+  *addr = buffer_.get() + read_start_ + num_valid_bytes_;
+  *size = read_size_;
+}
+
+void RawChannel::ReadBuffer::EnsureReadSpace() {
+  if (!num_valid_bytes_)
+    read_start_ = 0;
+
+  if (buffer_size_ - read_start_ - num_valid_bytes_ >= read_size_)
+    return;
+
+  if (buffer_size_ - num_valid_bytes_ >= read_size_) {
+    // Move data back to start.
+    DCHECK_GT(read_start_, 0u);
+    memmove(buffer_.get(), buffer_.get() + read_start_, num_valid_bytes_);
+    read_start_ = 0;
+    return;
+  }
+
+  // Use power-of-2 buffer sizes. (The buffer size is effectively bounded by
+  // the maximum message size plus |kMaxReadSize|, since |OnReadCompleted()|
+  // rejects invalid messages.)
+  size_t new_size = buffer_size_;
+  while (new_size < num_valid_bytes_ + read_size_)
+    new_size *= 2;
+
+  // Unlike |std::vector::resize()|, this doesn't zero out the fresh memory.
+  scoped_ptr<char, base::AlignedFreeDeleter> new_buffer(static_cast<char*>(
+      base::AlignedAlloc(new_size, MessageInTransit::kMessageAlignment)));
+  if (num_valid_bytes_ > 0)
+    memcpy(new_buffer.get(), buffer_.get() + read_start_, num_valid_bytes_);
+  buffer_ = new_buffer.Pass();
+  buffer_size_ = new_size;
+  read_start_ = 0;
 }
 
 // RawChannel::WriteBuffer -----------------------------------------------------
@@ -96,58 +149,47 @@ void RawChannel::WriteBuffer::GetPlatformHandlesToSend(
   }
 }
 
-void RawChannel::WriteBuffer::GetBuffers(std::vector<Buffer>* buffers) const {
+void RawChannel::WriteBuffer::GetBuffers(size_t max_num_buffers,
+                                         std::vector<Buffer>* buffers) const {
+  DCHECK_GT(max_num_buffers, 0u);
   buffers->clear();
 
-  if (message_queue_.empty())
-    return;
+  // |offset| is the position in the current message's data to start at; only
+  // the first message may have been partially sent already.
+  size_t offset = data_offset_;
+  for (size_t i = 0;
+       i < message_queue_.size() && buffers->size() < max_num_buffers; i++) {
+    const MessageInTransit* message = message_queue_[i];
+    const TransportData* transport_data = message->transport_data();
+
+    // Any platform handles for a message have to be sent before (or with) its
+    // data, so stop at the next message that has any.
+    if (i > 0 && transport_data && transport_data->platform_handles() &&
+        !transport_data->platform_handles()->empty())
+      break;
 
-  MessageInTransit* message = message_queue_.front();
-  DCHECK_LT(data_offset_, message->total_size());
-  size_t bytes_to_write = message->total_size() - data_offset_;
-
-  size_t transport_data_buffer_size =
-      message->transport_data() ? message->transport_data()->buffer_size() : 0;
-
-  if (!transport_data_buffer_size) {
-    // Only write from the main buffer.
-    DCHECK_LT(data_offset_, message->main_buffer_size());
-    DCHECK_LE(bytes_to_write, message->main_buffer_size());
-    Buffer buffer = {
-        static_cast<const char*>(message->main_buffer()) + data_offset_,
-        bytes_to_write};
-    buffers->push_back(buffer);
-    return;
-  }
+    DCHECK_LT(offset, message->total_size());
+    if (offset < message->main_buffer_size()) {
+      Buffer buffer = {static_cast<const char*>(message->main_buffer()) + offset,
+                       message->main_buffer_size() - offset};
+      buffers->push_back(buffer);
+      offset = message->main_buffer_size();
+    }
 
-  if (data_offset_ >= message->main_buffer_size()) {
-    // Only write from the transport data buffer.
-    DCHECK_LT(data_offset_ - message->main_buffer_size(),
-              transport_data_buffer_size);
-    DCHECK_LE(bytes_to_write, transport_data_buffer_size);
-    Buffer buffer = {
-        static_cast<const char*>(message->transport_data()->buffer()) +
-            (data_offset_ - message->main_buffer_size()),
-        bytes_to_write};
-    buffers->push_back(buffer);
-    return;
-  }
+    size_t transport_data_buffer_size =
+        transport_data ? transport_data->buffer_size() : 0;
+    if (transport_data_buffer_size > 0 && buffers->size() < max_num_buffers) {
+      size_t transport_data_offset = offset - message->main_buffer_size();
+      DCHECK_LT(transport_data_offset, transport_data_buffer_size);
+      Buffer buffer = {
+          static_cast<const char*>(transport_data->buffer()) +
+              transport_data_offset,
+          transport_data_buffer_size - transport_data_offset};
+      buffers->push_back(buffer);
+    }
 
-  // TODO(vtl): We could actually send out buffers from multiple messages, with
-  // the "stopping" condition being reaching a message with platform handles
-  // attached.
-
-  // Write from both buffers.
-  DCHECK_EQ(bytes_to_write, message->main_buffer_size() - data_offset_ +
-                                transport_data_buffer_size);
-  Buffer buffer1 = {
-      static_cast<const char*>(message->main_buffer()) + data_offset_,
-      message->main_buffer_size() - data_offset_};
-  buffers->push_back(buffer1);
-  Buffer buffer2 = {
-      static_cast<const char*>(message->transport_data()->buffer()),
-      transport_data_buffer_size};
-  buffers->push_back(buffer2);
+    offset = 0;
+  }
 }
 
 // RawChannel ------------------------------------------------------------------
@@ -156,7 +198,9 @@ RawChannel::RawChannel()
     : message_loop_for_io_(nullptr),
       delegate_(nullptr),
       set_on_shutdown_(nullptr),
+      num_reads_(0),
       write_stopped_(false),
+      num_writes_(0),
       weak_ptr_factory_(this) {
 }
 
@@ -235,26 +279,21 @@ bool RawChannel::WriteMessage(scoped_ptr<MessageInTransit> message) {
   }
 
   EnqueueMessageNoLock(message.Pass());
-  DCHECK_EQ(write_buffer_->data_offset_, 0u);
+  return StartWriteNoLock();
+}
 
-  size_t platform_handles_written = 0;
-  size_t bytes_written = 0;
-  IOResult io_result = WriteNoLock(&platform_handles_written, &bytes_written);
-  if (io_result == IO_PENDING)
-    return true;
+// Reminder: This must be thread-safe.
+bool RawChannel::WriteMessages(MessageInTransitQueue* messages) {
+  DCHECK(!messages->IsEmpty());
 
-  bool result = OnWriteCompletedNoLock(io_result, platform_handles_written,
-                                       bytes_written);
-  if (!result) {
-    // Even if we're on the I/O thread, don't call |OnError()| in the nested
-    // context.
-    message_loop_for_io_->PostTask(
-        FROM_HERE,
-        base::Bind(&RawChannel::CallOnError, weak_ptr_factory_.GetWeakPtr(),
-                   Delegate::ERROR_WRITE));
-  }
+  base::AutoLock locker(write_lock_);
+  if (write_stopped_)
+    return false;
 
-  return result;
+  bool was_empty = write_buffer_->message_queue_.empty();
+  while (!messages->IsEmpty())
+    EnqueueMessageNoLock(messages->GetMessage());
+  return was_empty ? StartWriteNoLock() : true;
 }
 
 // Reminder: This must be thread-safe.
@@ -263,14 +302,21 @@ bool RawChannel::IsWriteBufferEmpty() {
   return write_buffer_->message_queue_.empty();
 }
 
+// Reminder: This must be thread-safe.
+uint64_t RawChannel::GetNumWritesForTest() {
+  base::AutoLock locker(write_lock_);
+  return num_writes_;
+}
+
 void RawChannel::OnReadCompleted(IOResult io_result, size_t bytes_read) {
   DCHECK_EQ(base::MessageLoop::current(), message_loop_for_io_);
 
-  // Keep reading data in a loop, and dispatch messages if enough data is
-  // received. Exit the loop if any of the following happens:
-  //   - one or more messages were dispatched;
+  // Keep reading data in a loop, and dispatch all complete messages after each
+  // read. Exit the loop if any of the following happens:
   //   - the last read failed, was a partial read or would block;
+  //   - we've done |kMaxReadsPerWakeup| reads;
   //   - |Shutdown()| was called.
+  size_t num_reads = 0;
   do {
     switch (io_result) {
       case IO_SUCCEEDED:
@@ -285,28 +331,31 @@ void RawChannel::OnReadCompleted(IOResult io_result, size_t bytes_read) {
         return;
     }
 
+    // Note: |read_size_| is only changed below, so it's still the size that
+    // was requested for this read.
+    size_t bytes_requested = read_buffer_->read_size_;
+    DCHECK_LE(bytes_read, bytes_requested);
     read_buffer_->num_valid_bytes_ += bytes_read;
+    if (bytes_read > 0)
+      num_reads_++;
+    num_reads++;
 
     // Dispatch all the messages that we can.
-    bool did_dispatch_message = false;
-    // Tracks the offset of the first undispatched message in |read_buffer_|.
-    // Currently, we copy data to ensure that this is zero at the beginning.
-    size_t read_buffer_start = 0;
     size_t remaining_bytes = read_buffer_->num_valid_bytes_;
     size_t message_size;
     // Note that we rely on short-circuit evaluation here:
-    //   - |read_buffer_start| may be an invalid index into
+    //   - |read_buffer_->read_start_| may be an invalid index into
     //     |read_buffer_->buffer_| if |remaining_bytes| is zero.
     //   - |message_size| is only valid if |GetNextMessageSize()| returns true.
-    // TODO(vtl): Use |message_size| more intelligently (e.g., to request the
-    // next read).
     // TODO(vtl): Validate that |message_size| is sane.
-    while (remaining_bytes > 0 && MessageInTransit::GetNextMessageSize(
-                                      &read_buffer_->buffer_[read_buffer_start],
-                                      remaining_bytes, &message_size) &&
+    while (remaining_bytes > 0 &&
+           MessageInTransit::GetNextMessageSize(
+               read_buffer_->buffer_.get() + read_buffer_->read_start_,
+               remaining_bytes, &message_size) &&
            remaining_bytes >= message_size) {
       MessageInTransit::View message_view(
-          message_size, &read_buffer_->buffer_[read_buffer_start]);
+          message_size,
+          read_buffer_->buffer_.get() + read_buffer_->read_start_);
       DCHECK_EQ(message_view.total_size(), message_size);
 
       const char* error_message = nullptr;
@@ -360,46 +409,43 @@ void RawChannel::OnReadCompleted(IOResult io_result, size_t bytes_read) {
         set_on_shutdown_ = nullptr;
       }
 
-      did_dispatch_message = true;
-
       // Update our state.
-      read_buffer_start += message_size;
+      read_buffer_->read_start_ += message_size;
       remaining_bytes -= message_size;
     }
-
-    if (read_buffer_start > 0) {
-      // Move data back to start.
-      read_buffer_->num_valid_bytes_ = remaining_bytes;
-      if (read_buffer_->num_valid_bytes_ > 0) {
-        memmove(&read_buffer_->buffer_[0],
-                &read_buffer_->buffer_[read_buffer_start], remaining_bytes);
-      }
-      read_buffer_start = 0;
+    read_buffer_->num_valid_bytes_ = remaining_bytes;
+
+    // Adapt the read size: If the last read filled the requested area, there's
+    // probably more data waiting, so ask for more next time. If it came back
+    // mostly empty, ask for less.
+    if (bytes_read >= bytes_requested) {
+      read_buffer_->preferred_read_size_ =
+          std::min(2 * read_buffer_->preferred_read_size_, kMaxReadSize);
+    } else if (bytes_read < read_buffer_->preferred_read_size_ / 4) {
+      read_buffer_->preferred_read_size_ =
+          std::max(read_buffer_->preferred_read_size_ / 2, kMinReadSize);
     }
-
-    if (read_buffer_->buffer_.size() - read_buffer_->num_valid_bytes_ <
-        kReadSize) {
-      // Use power-of-2 buffer sizes.
-      // TODO(vtl): Make sure the buffer doesn't get too large (and enforce the
-      // maximum message size to whatever extent necessary).
-      // TODO(vtl): We may often be able to peek at the header and get the real
-      // required extra space (which may be much bigger than |kReadSize|).
-      size_t new_size = std::max(read_buffer_->buffer_.size(), kReadSize);
-      while (new_size < read_buffer_->num_valid_bytes_ + kReadSize)
-        new_size *= 2;
-
-      // TODO(vtl): It's suboptimal to zero out the fresh memory.
-      read_buffer_->buffer_.resize(new_size, 0);
+    read_buffer_->read_size_ = read_buffer_->preferred_read_size_;
+    // If we already have the header of the next message, try to read the rest
+    // of it in one go.
+    if (remaining_bytes > 0 &&
+        MessageInTransit::GetNextMessageSize(
+            read_buffer_->buffer_.get() + read_buffer_->read_start_,
+            remaining_bytes, &message_size) &&
+        message_size > remaining_bytes) {
+      read_buffer_->read_size_ =
+          std::max(read_buffer_->read_size_,
+                   std::min(message_size - remaining_bytes, kMaxReadSize));
     }
-
-    // (1) If we dispatched any messages, stop reading for now (and let the
-    // message loop do its thing for another round).
-    // TODO(vtl): Is this the behavior we want? (Alternatives: i. Dispatch only
-    // a single message. Risks: slower, more complex if we want to avoid lots of
-    // copying. ii. Keep reading until there's no more data and dispatch all the
-    // messages we can. Risks: starvation of other users of the message loop.)
-    // (2) If we didn't max out |kReadSize|, stop reading for now.
-    bool schedule_for_later = did_dispatch_message || bytes_read < kReadSize;
+    read_buffer_->EnsureReadSpace();
+
+    // (1) If we didn't fill the requested area, there's (probably) no more data
+    // for now, so stop reading (and let the message loop do its thing for
+    // another round).
+    // (2) Don't do more than |kMaxReadsPerWakeup| reads in one go, even if
+    // there's more data, to avoid starving other users of the message loop.
+    bool schedule_for_later =
+        bytes_read < bytes_requested || num_reads >= kMaxReadsPerWakeup;
     bytes_read = 0;
     io_result = schedule_for_later ? ScheduleRead() : Read(&bytes_read);
   } while (io_result != IO_PENDING);
@@ -462,6 +508,31 @@ RawChannel::Delegate::Error RawChannel::ReadIOResultToError(
   return Delegate::ERROR_READ_UNKNOWN;
 }
 
+bool RawChannel::StartWriteNoLock() {
+  write_lock_.AssertAcquired();
+  DCHECK(!write_stopped_);
+  DCHECK_EQ(write_buffer_->data_offset_, 0u);
+
+  size_t platform_handles_written = 0;
+  size_t bytes_written = 0;
+  IOResult io_result = WriteNoLock(&platform_handles_written, &bytes_written);
+  if (io_result == IO_PENDING)
+    return true;
+
+  bool result = OnWriteCompletedNoLock(io_result, platform_handles_written,
+                                       bytes_written);
+  if (!result) {
+    // Even if we're on the I/O thread, don't call |OnError()| in the nested
+    // context.
+    message_loop_for_io_->PostTask(
+        FROM_HERE,
+        base::Bind(&RawChannel::CallOnError, weak_ptr_factory_.GetWeakPtr(),
+                   Delegate::ERROR_WRITE));
+  }
+
+  return result;
+}
+
 void RawChannel::CallOnError(Delegate::Error error) {
   DCHECK_EQ(base::MessageLoop::current(), message_loop_for_io_);
   // TODO(vtl): Add a "write_lock_.AssertNotAcquired()"?
@@ -480,21 +551,31 @@ bool RawChannel::OnWriteCompletedNoLock(IOResult io_result,
   DCHECK(!write_buffer_->message_queue_.empty());
 
   if (io_result == IO_SUCCEEDED) {
+    num_writes_++;
     write_buffer_->platform_handles_offset_ += platform_handles_written;
     write_buffer_->data_offset_ += bytes_written;
 
-    MessageInTransit* message = write_buffer_->message_queue_.front();
-    if (write_buffer_->data_offset_ >= message->total_size()) {
+    // A single write may have completed several messages (and possibly
+    // written part of the one after them).
+    while (!write_buffer_->message_queue_.empty()) {
+      MessageInTransit* message = write_buffer_->message_queue_.front();
+      if (write_buffer_->data_offset_ < message->total_size())
+        break;
+
       // Complete write.
-      CHECK_EQ(write_buffer_->data_offset_, message->total_size());
+      write_buffer_->data_offset_ -= message->total_size();
       write_buffer_->message_queue_.pop_front();
       delete message;
       write_buffer_->platform_handles_offset_ = 0;
-      write_buffer_->data_offset_ = 0;
-
-      if (write_buffer_->message_queue_.empty())
-        return true;
     }
+    if (write_buffer_->message_queue_.empty()) {
+      CHECK_EQ(write_buffer_->data_offset_, 0u);
+      return true;
+    }
+    // We never write data past a message that still has platform handles to
+    // send.
+    DCHECK(!write_buffer_->data_offset_ ||
+           !write_buffer_->HavePlatformHandlesToSend());
 
     // Schedule the next write.
     io_result = ScheduleWriteNoLock();
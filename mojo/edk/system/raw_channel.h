@@ -5,16 +5,21 @@
 #ifndef MOJO_EDK_SYSTEM_RAW_CHANNEL_H_
 #define MOJO_EDK_SYSTEM_RAW_CHANNEL_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <deque>
 #include <vector>
 
 #include "base/macros.h"
+#include "base/memory/aligned_memory.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/synchronization/lock.h"
 #include "mojo/edk/embedder/platform_handle_vector.h"
 #include "mojo/edk/embedder/scoped_platform_handle.h"
 #include "mojo/edk/system/message_in_transit.h"
+#include "mojo/edk/system/message_in_transit_queue.h"
 #include "mojo/edk/system/system_impl_export.h"
 
 namespace base {
@@ -101,6 +106,11 @@ class MOJO_SYSTEM_IMPL_EXPORT RawChannel {
   // thread-safe and may be called from any thread. Returns true on success.
   bool WriteMessage(scoped_ptr<MessageInTransit> message);
 
+  // Like |WriteMessage()|, but writes all the messages in |*messages| (which
+  // must not be empty), in order, leaving it empty. If nothing else is being
+  // written, they'll be written together (e.g., with a single |writev()|).
+  bool WriteMessages(MessageInTransitQueue* messages);
+
   // Returns true if the write buffer is empty (i.e., all messages written using
   // |WriteMessage()| have actually been sent.
   // TODO(vtl): We should really also notify our delegate when the write buffer
@@ -112,6 +122,14 @@ class MOJO_SYSTEM_IMPL_EXPORT RawChannel {
   // attached to a message). (This amount may be zero.)
   virtual size_t GetSerializedPlatformHandleSize() const = 0;
 
+  // Returns the number of successful reads (e.g., |recvmsg()|s) done so far.
+  // This is meant for tests and perftests, and must be called on the I/O
+  // thread.
+  uint64_t GetNumReadsForTest() const { return num_reads_; }
+  // Returns the number of successful writes (e.g., |sendmsg()|s) done so far.
+  // This is meant for tests and perftests. This method is thread-safe.
+  uint64_t GetNumWritesForTest();
+
  protected:
   // Result of I/O operations.
   enum IOResult {
@@ -130,18 +148,38 @@ class MOJO_SYSTEM_IMPL_EXPORT RawChannel {
     ReadBuffer();
     ~ReadBuffer();
 
+    // Gets the area into which the next read should be done. |*size| is the
+    // (adaptive) read size; see |RawChannel::OnReadCompleted()|.
     void GetBuffer(char** addr, size_t* size);
 
    private:
     friend class RawChannel;
 
-    // We store data from |[Schedule]Read()|s in |buffer_|. The start of
-    // |buffer_| is always aligned with a message boundary (we will copy memory
-    // to ensure this), but |buffer_| may be larger than the actual number of
-    // bytes we have.
-    std::vector<char> buffer_;
+    // Makes sure that there's room for |read_size_| bytes after the valid
+    // data, moving the valid data back to the start of |buffer_| and/or
+    // growing |buffer_| if necessary.
+    void EnsureReadSpace();
+
+    // We store data from |[Schedule]Read()|s in |buffer_|, which has size
+    // |buffer_size_|. The valid (not yet dispatched) data is in
+    // |[read_start_, read_start_ + num_valid_bytes_)|. |read_start_| is always
+    // on a message boundary (and hence |kMessageAlignment|-aligned). Instead of
+    // moving data back to the start of |buffer_| after every dispatch, we only
+    // do so when there's no longer enough space at the end for the next read
+    // (by which time there's usually little or no valid data left to move).
+    scoped_ptr<char, base::AlignedFreeDeleter> buffer_;
+    size_t buffer_size_;
+    size_t read_start_;
     size_t num_valid_bytes_;
 
+    // The number of bytes that the next read should request. This is at least
+    // |preferred_read_size_|, but may be more if we know (from its header) that
+    // the next message is bigger.
+    size_t read_size_;
+    // The read size suggested by recent reads: it grows while reads fill the
+    // whole requested area and shrinks while they come back mostly empty.
+    size_t preferred_read_size_;
+
     DISALLOW_COPY_AND_ASSIGN(ReadBuffer);
   };
 
@@ -170,11 +208,14 @@ class MOJO_SYSTEM_IMPL_EXPORT RawChannel {
                                   embedder::PlatformHandle** platform_handles,
                                   void** serialization_data);
 
-    // Gets buffers to be written. These buffers will always come from the front
-    // of |message_queue_|. Once they are completely written, the front
-    // |MessageInTransit| should be popped (and destroyed); this is done in
-    // |OnWriteCompletedNoLock()|.
-    void GetBuffers(std::vector<Buffer>* buffers) const;
+    // Gets (at most |max_num_buffers|) buffers to be written. These buffers
+    // will always come from the front of |message_queue_|, but may span several
+    // messages so that they can be written together (e.g., using a single
+    // |writev()|); they will never include data from any message other than the
+    // first that still has platform handles to be sent. Once messages are
+    // completely written, they should be popped (and destroyed) from the front
+    // of |message_queue_|; this is done in |OnWriteCompletedNoLock()|.
+    void GetBuffers(size_t max_num_buffers, std::vector<Buffer>* buffers) const;
 
    private:
     friend class RawChannel;
@@ -190,7 +231,8 @@ class MOJO_SYSTEM_IMPL_EXPORT RawChannel {
     size_t platform_handles_offset_;
     // The first message's data may have been partially sent. |data_offset_|
     // indicates the position in the first message's data to start the next
-    // write.
+    // write. (A single write may complete several messages; see
+    // |OnWriteCompletedNoLock()|.)
     size_t data_offset_;
 
     DISALLOW_COPY_AND_ASSIGN(WriteBuffer);
@@ -296,6 +338,11 @@ class MOJO_SYSTEM_IMPL_EXPORT RawChannel {
   // |write_lock_| held. This object may be destroyed by this call.
   void CallOnError(Delegate::Error error);
 
+  // Starts writing the contents of the write buffer, which must have been empty
+  // before the caller's messages were enqueued. Returns false on error. Must be
+  // called under |write_lock_| and only if |write_stopped_| is false.
+  bool StartWriteNoLock();
+
   // If |io_result| is |IO_SUCCESS|, updates the write buffer and schedules a
   // write operation to run later if there is more to write. If |io_result| is
   // failure or any other error occurs, cancels pending writes and returns
@@ -313,10 +360,12 @@ class MOJO_SYSTEM_IMPL_EXPORT RawChannel {
   Delegate* delegate_;
   bool* set_on_shutdown_;
   scoped_ptr<ReadBuffer> read_buffer_;
+  uint64_t num_reads_;
 
   base::Lock write_lock_;  // Protects the following members.
   bool write_stopped_;
   scoped_ptr<WriteBuffer> write_buffer_;
+  uint64_t num_writes_;
 
   // This is used for posting tasks from write threads to the I/O thread. It
   // must only be accessed under |write_lock_|. The weak pointers it produces
@@ -0,0 +1,182 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/raw_channel.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/perf_log.h"
+#include "base/test/test_io_thread.h"
+#include "base/time/time.h"
+#include "mojo/edk/embedder/platform_channel_pair.h"
+#include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/system/message_in_transit.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace system {
+namespace {
+
+// The total amount of message data to send for each message size.
+const size_t kTotalBytesPerSize = 64 * 1024 * 1024;
+// But always send at least this many messages.
+const size_t kMinNumMessages = 64;
+
+scoped_ptr<MessageInTransit> MakeTestMessage(uint32_t num_bytes) {
+  return make_scoped_ptr(
+      new MessageInTransit(MessageInTransit::Type::ENDPOINT_CLIENT,
+                           MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA,
+                           num_bytes, nullptr));
+}
+
+void InitOnIOThread(RawChannel* raw_channel, RawChannel::Delegate* delegate) {
+  raw_channel->Init(delegate);
+}
+
+void GetNumReadsOnIOThread(RawChannel* raw_channel, uint64_t* num_reads) {
+  *num_reads = raw_channel->GetNumReadsForTest();
+}
+
+class WriteOnlyRawChannelDelegate : public RawChannel::Delegate {
+ public:
+  WriteOnlyRawChannelDelegate() {}
+  ~WriteOnlyRawChannelDelegate() override {}
+
+  // |RawChannel::Delegate| implementation:
+  void OnReadMessage(
+      const MessageInTransit::View& /*message_view*/,
+      embedder::ScopedPlatformHandleVectorPtr /*platform_handles*/) override {
+    CHECK(false);  // Should not get called.
+  }
+  void OnError(Error error) override {
+    // We'll get a read (shutdown) error when the connection is closed.
+    CHECK_EQ(error, ERROR_READ_SHUTDOWN);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(WriteOnlyRawChannelDelegate);
+};
+
+class CountingRawChannelDelegate : public RawChannel::Delegate {
+ public:
+  explicit CountingRawChannelDelegate(size_t expected_count)
+      : done_event_(false, false), expected_count_(expected_count), count_(0) {}
+  ~CountingRawChannelDelegate() override {}
+
+  // |RawChannel::Delegate| implementation (called on the I/O thread):
+  void OnReadMessage(
+      const MessageInTransit::View& /*message_view*/,
+      embedder::ScopedPlatformHandleVectorPtr /*platform_handles*/) override {
+    CHECK_LT(count_, expected_count_);
+    count_++;
+    if (count_ >= expected_count_)
+      done_event_.Signal();
+  }
+  void OnError(Error error) override {
+    // We'll get a read (shutdown) error when the connection is closed.
+    CHECK_EQ(error, ERROR_READ_SHUTDOWN);
+  }
+
+  // Waits for all the messages to have been seen.
+  void Wait() { done_event_.Wait(); }
+
+ private:
+  base::WaitableEvent done_event_;
+  const size_t expected_count_;
+  size_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingRawChannelDelegate);
+};
+
+class RawChannelPerfTest : public testing::Test {
+ public:
+  RawChannelPerfTest() : io_thread_(base::TestIOThread::kAutoStart) {}
+  ~RawChannelPerfTest() override {}
+
+ protected:
+  // Sends a burst of |num_messages| messages of |message_size| bytes each from
+  // one |RawChannel| to another, and logs read and write syscalls per message
+  // and throughput.
+  void MeasureBurst(size_t num_messages, uint32_t message_size) {
+    embedder::PlatformChannelPair channel_pair;
+
+    WriteOnlyRawChannelDelegate writer_delegate;
+    scoped_ptr<RawChannel> writer_rc(
+        RawChannel::Create(channel_pair.PassServerHandle()));
+    io_thread_.PostTaskAndWait(FROM_HERE,
+                               base::Bind(&InitOnIOThread, writer_rc.get(),
+                                          base::Unretained(&writer_delegate)));
+
+    CountingRawChannelDelegate reader_delegate(num_messages);
+    scoped_ptr<RawChannel> reader_rc(
+        RawChannel::Create(channel_pair.PassClientHandle()));
+    io_thread_.PostTaskAndWait(FROM_HERE,
+                               base::Bind(&InitOnIOThread, reader_rc.get(),
+                                          base::Unretained(&reader_delegate)));
+
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    for (size_t i = 0; i < num_messages; i++)
+      CHECK(writer_rc->WriteMessage(MakeTestMessage(message_size)));
+    reader_delegate.Wait();
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+
+    uint64_t num_reads = 0;
+    io_thread_.PostTaskAndWait(
+        FROM_HERE,
+        base::Bind(&GetNumReadsOnIOThread, reader_rc.get(), &num_reads));
+
+    std::string test_name =
+        base::StringPrintf("RawChannel_Burst_%ux_%u",
+                           static_cast<unsigned>(num_messages), message_size);
+    base::LogPerfResult(
+        (test_name + "_ReadsPerMessage").c_str(),
+        static_cast<double>(num_reads) / static_cast<double>(num_messages),
+        "reads/message");
+    base::LogPerfResult((test_name + "_WritesPerMessage").c_str(),
+                        static_cast<double>(writer_rc->GetNumWritesForTest()) /
+                            static_cast<double>(num_messages),
+                        "writes/message");
+    base::LogPerfResult(
+        (test_name + "_Throughput").c_str(),
+        static_cast<double>(num_messages) * message_size /
+            (1024.0 * 1024.0) / elapsed.InSecondsF(),
+        "MB/s");
+
+    io_thread_.PostTaskAndWait(
+        FROM_HERE,
+        base::Bind(&RawChannel::Shutdown, base::Unretained(reader_rc.get())));
+    io_thread_.PostTaskAndWait(
+        FROM_HERE,
+        base::Bind(&RawChannel::Shutdown, base::Unretained(writer_rc.get())));
+  }
+
+ private:
+  base::TestIOThread io_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(RawChannelPerfTest);
+};
+
+TEST_F(RawChannelPerfTest, Burst) {
+  const uint32_t kMessageSizes[] = {64, 1024, 16 * 1024, 256 * 1024,
+                                    1024 * 1024};
+  for (size_t i = 0; i < arraysize(kMessageSizes); i++) {
+    MeasureBurst(std::max(kTotalBytesPerSize / kMessageSizes[i],
+                          kMinNumMessages),
+                 kMessageSizes[i]);
+  }
+}
+
+}  // namespace
+}  // namespace system
+}  // namespace mojo
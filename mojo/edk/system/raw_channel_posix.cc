@@ -5,11 +5,13 @@
 #include "mojo/edk/system/raw_channel.h"
 
 #include <errno.h>
+#include <limits.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
 #include <algorithm>
 #include <deque>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/location.h"
@@ -29,6 +31,11 @@ namespace system {
 
 namespace {
 
+// The maximum number of buffers to write with a single |writev()|/|sendmsg()|.
+// (These may come from many queued messages; see
+// |RawChannel::WriteBuffer::GetBuffers()|.)
+const size_t kMaxWriteBufferCount = IOV_MAX < 1024 ? IOV_MAX : 1024;
+
 class RawChannelPosix : public RawChannel,
                         public base::MessageLoopForIO::Watcher {
  public:
@@ -219,54 +226,43 @@ RawChannel::IOResult RawChannelPosix::WriteNoLock(
 
   DCHECK(!pending_write_);
 
+  // Gather as much queued data as we can into a single write.
+  std::vector<WriteBuffer::Buffer> buffers;
+  write_buffer_no_lock()->GetBuffers(kMaxWriteBufferCount, &buffers);
+  DCHECK(!buffers.empty());
+
   size_t num_platform_handles = 0;
   ssize_t write_result;
-  if (write_buffer_no_lock()->HavePlatformHandlesToSend()) {
-    embedder::PlatformHandle* platform_handles;
-    void* serialization_data;  // Actually unused.
-    write_buffer_no_lock()->GetPlatformHandlesToSend(
-        &num_platform_handles, &platform_handles, &serialization_data);
-    DCHECK_GT(num_platform_handles, 0u);
-    DCHECK_LE(num_platform_handles, embedder::kPlatformChannelMaxNumHandles);
-    DCHECK(platform_handles);
-
-    // TODO(vtl): Reduce code duplication. (This is duplicated from below.)
-    std::vector<WriteBuffer::Buffer> buffers;
-    write_buffer_no_lock()->GetBuffers(&buffers);
-    DCHECK(!buffers.empty());
-    const size_t kMaxBufferCount = 10;
-    iovec iov[kMaxBufferCount];
-    size_t buffer_count = std::min(buffers.size(), kMaxBufferCount);
-    for (size_t i = 0; i < buffer_count; ++i) {
+  if (buffers.size() == 1 &&
+      !write_buffer_no_lock()->HavePlatformHandlesToSend()) {
+    write_result = embedder::PlatformChannelWrite(fd_.get(), buffers[0].addr,
+                                                  buffers[0].size);
+  } else {
+    iovec iov[kMaxWriteBufferCount];
+    for (size_t i = 0; i < buffers.size(); ++i) {
       iov[i].iov_base = const_cast<char*>(buffers[i].addr);
       iov[i].iov_len = buffers[i].size;
     }
 
-    write_result = embedder::PlatformChannelSendmsgWithHandles(
-        fd_.get(), iov, buffer_count, platform_handles, num_platform_handles);
-    if (write_result >= 0) {
-      for (size_t i = 0; i < num_platform_handles; i++)
-        platform_handles[i].CloseIfNecessary();
-    }
-  } else {
-    std::vector<WriteBuffer::Buffer> buffers;
-    write_buffer_no_lock()->GetBuffers(&buffers);
-    DCHECK(!buffers.empty());
-
-    if (buffers.size() == 1) {
-      write_result = embedder::PlatformChannelWrite(fd_.get(), buffers[0].addr,
-                                                    buffers[0].size);
-    } else {
-      const size_t kMaxBufferCount = 10;
-      iovec iov[kMaxBufferCount];
-      size_t buffer_count = std::min(buffers.size(), kMaxBufferCount);
-      for (size_t i = 0; i < buffer_count; ++i) {
-        iov[i].iov_base = const_cast<char*>(buffers[i].addr);
-        iov[i].iov_len = buffers[i].size;
+    if (write_buffer_no_lock()->HavePlatformHandlesToSend()) {
+      embedder::PlatformHandle* platform_handles;
+      void* serialization_data;  // Actually unused.
+      write_buffer_no_lock()->GetPlatformHandlesToSend(
+          &num_platform_handles, &platform_handles, &serialization_data);
+      DCHECK_GT(num_platform_handles, 0u);
+      DCHECK_LE(num_platform_handles, embedder::kPlatformChannelMaxNumHandles);
+      DCHECK(platform_handles);
+
+      write_result = embedder::PlatformChannelSendmsgWithHandles(
+          fd_.get(), iov, buffers.size(), platform_handles,
+          num_platform_handles);
+      if (write_result >= 0) {
+        for (size_t i = 0; i < num_platform_handles; i++)
+          platform_handles[i].CloseIfNecessary();
       }
-
+    } else {
       write_result =
-          embedder::PlatformChannelWritev(fd_.get(), iov, buffer_count);
+          embedder::PlatformChannelWritev(fd_.get(), iov, buffers.size());
     }
   }
 
@@ -856,6 +856,147 @@ TEST_F(RawChannelTest, MAYBE_ReadWritePlatformHandles) {
       base::Bind(&RawChannel::Shutdown, base::Unretained(rc_write.get())));
 }
 
+// RawChannelTest.WriteQueuedMessagesWithPlatformHandles ----------------------
+
+// Checks that messages (some of which have a single platform handle, to a file
+// containing a single character, attached) are received in order.
+class QueuedMessagesCheckerRawChannelDelegate : public RawChannel::Delegate {
+ public:
+  // |expected_sizes[i]| is the size of the i-th message and
+  // |expected_contents[i]| the contents of the file attached to it (or zero if
+  // it has no platform handle attached).
+  QueuedMessagesCheckerRawChannelDelegate(
+      const std::vector<uint32_t>& expected_sizes,
+      const std::vector<char>& expected_contents)
+      : done_event_(false, false),
+        expected_sizes_(expected_sizes),
+        expected_contents_(expected_contents),
+        position_(0) {
+    CHECK_EQ(expected_sizes_.size(), expected_contents_.size());
+  }
+  ~QueuedMessagesCheckerRawChannelDelegate() override {}
+
+  // |RawChannel::Delegate| implementation (called on the I/O thread):
+  void OnReadMessage(
+      const MessageInTransit::View& message_view,
+      embedder::ScopedPlatformHandleVectorPtr platform_handles) override {
+    ASSERT_LT(position_, expected_sizes_.size());
+    size_t position = position_++;
+
+    EXPECT_EQ(expected_sizes_[position], message_view.num_bytes()) << position;
+    if (message_view.num_bytes() == expected_sizes_[position]) {
+      EXPECT_TRUE(
+          CheckMessageData(message_view.bytes(), message_view.num_bytes()))
+          << position;
+    }
+
+    if (!expected_contents_[position]) {
+      EXPECT_FALSE(platform_handles) << position;
+    } else {
+      ASSERT_TRUE(platform_handles) << position;
+      ASSERT_EQ(1u, platform_handles->size()) << position;
+      embedder::ScopedPlatformHandle h(platform_handles->at(0));
+      platform_handles->clear();
+
+      char buffer[100] = {};
+      base::ScopedFILE fp(mojo::test::FILEFromPlatformHandle(h.Pass(), "rb"));
+      EXPECT_TRUE(fp);
+      rewind(fp.get());
+      EXPECT_EQ(1u, fread(buffer, 1, sizeof(buffer), fp.get()));
+      EXPECT_EQ(expected_contents_[position], buffer[0]) << position;
+    }
+
+    if (position_ >= expected_sizes_.size())
+      done_event_.Signal();
+  }
+  void OnError(Error error) override {
+    // We'll get a read (shutdown) error when the connection is closed.
+    CHECK_EQ(error, ERROR_READ_SHUTDOWN);
+  }
+
+  void Wait() { done_event_.Wait(); }
+
+ private:
+  base::WaitableEvent done_event_;
+  const std::vector<uint32_t> expected_sizes_;
+  const std::vector<char> expected_contents_;
+  size_t position_;
+
+  DISALLOW_COPY_AND_ASSIGN(QueuedMessagesCheckerRawChannelDelegate);
+};
+
+// Tests that messages queued up behind a blocked write (which may then be
+// written several at a time) are sent correctly, including when some of them
+// have platform handles attached.
+#if defined(OS_POSIX)
+#define MAYBE_WriteQueuedMessagesWithPlatformHandles \
+  WriteQueuedMessagesWithPlatformHandles
+#else
+// Not yet implemented (on Windows).
+#define MAYBE_WriteQueuedMessagesWithPlatformHandles \
+  DISABLED_WriteQueuedMessagesWithPlatformHandles
+#endif
+TEST_F(RawChannelTest, MAYBE_WriteQueuedMessagesWithPlatformHandles) {
+  static const size_t kNumMessages = 60;
+  // This is big enough that it'll fill up the OS's buffers, so that the
+  // following messages will be queued.
+  static const uint32_t kBigMessageSize = 2 * 1024 * 1024;
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  WriteOnlyRawChannelDelegate write_delegate;
+  scoped_ptr<RawChannel> rc_write(RawChannel::Create(handles[0].Pass()));
+  io_thread()->PostTaskAndWait(FROM_HERE,
+                               base::Bind(&InitOnIOThread, rc_write.get(),
+                                          base::Unretained(&write_delegate)));
+
+  std::vector<uint32_t> expected_sizes(1, kBigMessageSize);
+  std::vector<char> expected_contents(1, 0);
+  EXPECT_TRUE(rc_write->WriteMessage(MakeTestMessage(kBigMessageSize)));
+  EXPECT_FALSE(rc_write->IsWriteBufferEmpty());
+
+  for (size_t i = 0; i < kNumMessages; i++) {
+    uint32_t size = static_cast<uint32_t>(i * 100 + 1);
+    scoped_ptr<MessageInTransit> message(MakeTestMessage(size));
+    char contents = 0;
+    if (i % 3 == 0) {
+      contents = static_cast<char>('A' + i % 26);
+      base::FilePath unused;
+      base::ScopedFILE fp(
+          base::CreateAndOpenTemporaryFileInDir(temp_dir.path(), &unused));
+      EXPECT_EQ(1u, fwrite(&contents, 1, 1, fp.get()));
+      embedder::ScopedPlatformHandleVectorPtr platform_handles(
+          new embedder::PlatformHandleVector());
+      platform_handles->push_back(
+          mojo::test::PlatformHandleFromFILE(fp.Pass()).release());
+      message->SetTransportData(make_scoped_ptr(
+          new TransportData(platform_handles.Pass(),
+                            rc_write->GetSerializedPlatformHandleSize())));
+    }
+    expected_sizes.push_back(size);
+    expected_contents.push_back(contents);
+    EXPECT_TRUE(rc_write->WriteMessage(message.Pass()));
+  }
+
+  QueuedMessagesCheckerRawChannelDelegate read_delegate(expected_sizes,
+                                                        expected_contents);
+  scoped_ptr<RawChannel> rc_read(RawChannel::Create(handles[1].Pass()));
+  io_thread()->PostTaskAndWait(FROM_HERE,
+                               base::Bind(&InitOnIOThread, rc_read.get(),
+                                          base::Unretained(&read_delegate)));
+
+  read_delegate.Wait();
+  EXPECT_TRUE(rc_write->IsWriteBufferEmpty());
+
+  io_thread()->PostTaskAndWait(
+      FROM_HERE,
+      base::Bind(&RawChannel::Shutdown, base::Unretained(rc_read.get())));
+  io_thread()->PostTaskAndWait(
+      FROM_HERE,
+      base::Bind(&RawChannel::Shutdown, base::Unretained(rc_write.get())));
+}
+
 }  // namespace
 }  // namespace system
 }  // namespace mojo
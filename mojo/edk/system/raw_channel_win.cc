@@ -512,11 +512,11 @@ RawChannel::IOResult RawChannelWin::WriteNoLock(
     }
   }
 
+  // TODO(yzshen): Handle multi-segment writes more efficiently.
   std::vector<WriteBuffer::Buffer> buffers;
-  write_buffer_no_lock()->GetBuffers(&buffers);
+  write_buffer_no_lock()->GetBuffers(1, &buffers);
   DCHECK(!buffers.empty());
 
-  // TODO(yzshen): Handle multi-segment writes more efficiently.
   DWORD bytes_written_dword = 0;
   BOOL result =
       WriteFile(io_handler_->handle(), buffers[0].addr,
@@ -10,6 +10,7 @@
 
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
 #include "mojo/edk/system/channel.h"
 #include "mojo/edk/system/channel_endpoint.h"
 #include "mojo/edk/system/configuration.h"
@@ -70,10 +71,28 @@ RemoteConsumerDataPipeImpl::RemoteConsumerDataPipeImpl(
     ChannelEndpoint* channel_endpoint,
     size_t consumer_num_bytes)
     : channel_endpoint_(channel_endpoint),
-      consumer_num_bytes_(consumer_num_bytes) {
+      consumer_num_bytes_(consumer_num_bytes),
+      shared_ring_write_index_(0) {
   // Note: |buffer_| is lazily allocated.
 }
 
+RemoteConsumerDataPipeImpl::RemoteConsumerDataPipeImpl(
+    ChannelEndpoint* channel_endpoint,
+    size_t consumer_num_bytes,
+    scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+    scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping,
+    size_t shared_ring_write_index)
+    : channel_endpoint_(channel_endpoint),
+      consumer_num_bytes_(consumer_num_bytes),
+      shared_ring_(shared_ring),
+      shared_ring_mapping_(shared_ring_mapping.Pass()),
+      shared_ring_write_index_(shared_ring_write_index) {
+  DCHECK(shared_ring_);
+  DCHECK(shared_ring_mapping_);
+  DCHECK_EQ(shared_ring_mapping_->GetLength(), shared_ring_->GetNumBytes());
+  DCHECK_LT(shared_ring_write_index_, shared_ring_->GetNumBytes());
+}
+
 RemoteConsumerDataPipeImpl::~RemoteConsumerDataPipeImpl() {
 }
 
@@ -137,6 +156,25 @@ MojoResult RemoteConsumerDataPipeImpl::ProducerWriteData(
   if (num_bytes_to_write == 0)
     return MOJO_RESULT_SHOULD_WAIT;
 
+  if (shared_ring_) {
+    // The amount we can write in our first copy.
+    size_t num_bytes_to_write_first =
+        std::min(num_bytes_to_write, GetMaxNumBytesToWriteToSharedRing());
+    elements.GetArray(GetSharedRing() + shared_ring_write_index_,
+                      num_bytes_to_write_first);
+    if (num_bytes_to_write_first < num_bytes_to_write) {
+      // The "second write index" is zero.
+      elements.At(num_bytes_to_write_first)
+          .GetArray(GetSharedRing(),
+                    num_bytes_to_write - num_bytes_to_write_first);
+    }
+
+    // (See the note about failure below.)
+    SharedRingDataWritten(num_bytes_to_write);
+    num_bytes.Put(static_cast<uint32_t>(num_bytes_to_write));
+    return MOJO_RESULT_OK;
+  }
+
   // The maximum amount of data to send per message (make it a multiple of the
   // element size.
   // TODO(vtl): Copied from |LocalDataPipeImpl::ConvertDataToMessages()|.
@@ -180,7 +218,11 @@ MojoResult RemoteConsumerDataPipeImpl::ProducerBeginWriteData(
   DCHECK_LE(consumer_num_bytes_, capacity_num_bytes());
   DCHECK_EQ(consumer_num_bytes_ % element_num_bytes(), 0u);
 
-  size_t max_num_bytes_to_write = capacity_num_bytes() - consumer_num_bytes_;
+  // With a shared ring, the caller writes directly into it (so only contiguous
+  // space is available).
+  size_t max_num_bytes_to_write =
+      shared_ring_ ? GetMaxNumBytesToWriteToSharedRing()
+                   : capacity_num_bytes() - consumer_num_bytes_;
   if (min_num_bytes_to_write > max_num_bytes_to_write) {
     // Don't return "should wait" since you can't wait for a specified amount
     // of data.
@@ -191,8 +233,12 @@ MojoResult RemoteConsumerDataPipeImpl::ProducerBeginWriteData(
   if (max_num_bytes_to_write == 0)
     return MOJO_RESULT_SHOULD_WAIT;
 
-  EnsureBuffer();
-  buffer.Put(buffer_.get());
+  if (shared_ring_) {
+    buffer.Put(GetSharedRing() + shared_ring_write_index_);
+  } else {
+    EnsureBuffer();
+    buffer.Put(buffer_.get());
+  }
   buffer_num_bytes.Put(static_cast<uint32_t>(max_num_bytes_to_write));
   set_producer_two_phase_max_num_bytes_written(
       static_cast<uint32_t>(max_num_bytes_to_write));
@@ -206,12 +252,19 @@ MojoResult RemoteConsumerDataPipeImpl::ProducerEndWriteData(
   DCHECK_LE(num_bytes_written, capacity_num_bytes() - consumer_num_bytes_);
 
   if (!consumer_open()) {
-    DCHECK(buffer_);
+    DCHECK(buffer_ || shared_ring_);
     set_producer_two_phase_max_num_bytes_written(0);
     DestroyBuffer();
     return MOJO_RESULT_OK;
   }
 
+  if (shared_ring_) {
+    set_producer_two_phase_max_num_bytes_written(0);
+    if (num_bytes_written > 0)
+      SharedRingDataWritten(num_bytes_written);
+    return MOJO_RESULT_OK;
+  }
+
   // TODO(vtl): The following code is copied almost verbatim from
   // |ProducerWriteData()| (it's touchy to factor it out since it uses a
   // |UserPointer| while we have a plain pointer.
@@ -252,10 +305,15 @@ HandleSignalsState RemoteConsumerDataPipeImpl::ProducerGetHandleSignalsState()
     const {
   HandleSignalsState rv;
   if (consumer_open()) {
-    if (consumer_num_bytes_ < capacity_num_bytes() &&
-        !producer_in_two_phase_write())
-      rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_WRITABLE;
-    rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_WRITABLE;
+    if (!producer_in_two_phase_write()) {
+      size_t num_bytes_available = capacity_num_bytes() - consumer_num_bytes_;
+      if (num_bytes_available > 0)
+        rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_WRITABLE;
+      if (num_bytes_available >= producer_write_threshold_num_bytes())
+        rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD;
+    }
+    rv.satisfiable_signals |=
+        MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD;
   } else {
     rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_PEER_CLOSED;
   }
@@ -269,7 +327,7 @@ void RemoteConsumerDataPipeImpl::ProducerStartSerialize(
     size_t* max_platform_handles) {
   *max_size = sizeof(SerializedDataPipeProducerDispatcher) +
               channel->GetSerializedEndpointSize();
-  *max_platform_handles = 0;
+  *max_platform_handles = shared_ring_ ? 1 : 0;
 }
 
 bool RemoteConsumerDataPipeImpl::ProducerEndSerialize(
@@ -279,7 +337,9 @@ bool RemoteConsumerDataPipeImpl::ProducerEndSerialize(
     embedder::PlatformHandleVector* platform_handles) {
   SerializedDataPipeProducerDispatcher* s =
       static_cast<SerializedDataPipeProducerDispatcher*>(destination);
-  s->validated_options = validated_options();
+  s->validated_options = current_options();
+  s->shared_ring_platform_handle_index = kNoSharedRingPlatformHandleIndex;
+  s->shared_ring_write_index = 0;
   void* destination_for_endpoint = static_cast<char*>(destination) +
                                    sizeof(SerializedDataPipeProducerDispatcher);
 
@@ -294,6 +354,16 @@ bool RemoteConsumerDataPipeImpl::ProducerEndSerialize(
   // |Channel|. There's no reason for us to continue to exist afterwards.
 
   s->consumer_num_bytes = consumer_num_bytes_;
+  if (shared_ring_) {
+    // The new producer continues writing to the same ring.
+    if (!SerializeSharedRing(shared_ring_.get(), platform_handles,
+                             &s->shared_ring_platform_handle_index)) {
+      Disconnect();
+      return false;
+    }
+    s->shared_ring_write_index =
+        static_cast<uint32_t>(shared_ring_write_index_);
+  }
   // Note: We don't use |port|.
   scoped_refptr<ChannelEndpoint> channel_endpoint;
   channel_endpoint.swap(channel_endpoint_);
@@ -407,6 +477,10 @@ void RemoteConsumerDataPipeImpl::EnsureBuffer() {
 }
 
 void RemoteConsumerDataPipeImpl::DestroyBuffer() {
+  // Note: Don't scribble on a shared ring, since it may still be in use in
+  // another process.
+  shared_ring_mapping_.reset();
+  shared_ring_ = nullptr;
 #ifndef NDEBUG
   // Scribble on the buffer to help detect use-after-frees. (This also helps the
   // unit test detect certain bugs without needing ASAN or similar.)
@@ -416,6 +490,39 @@ void RemoteConsumerDataPipeImpl::DestroyBuffer() {
   buffer_.reset();
 }
 
+char* RemoteConsumerDataPipeImpl::GetSharedRing() const {
+  DCHECK(shared_ring_mapping_);
+  return static_cast<char*>(shared_ring_mapping_->GetBase());
+}
+
+size_t RemoteConsumerDataPipeImpl::GetMaxNumBytesToWriteToSharedRing() const {
+  DCHECK(shared_ring_);
+  return std::min(capacity_num_bytes() - consumer_num_bytes_,
+                  capacity_num_bytes() - shared_ring_write_index_);
+}
+
+bool RemoteConsumerDataPipeImpl::SharedRingDataWritten(size_t num_bytes) {
+  DCHECK(shared_ring_);
+  DCHECK_GT(num_bytes, 0u);
+  DCHECK_LE(num_bytes, capacity_num_bytes() - consumer_num_bytes_);
+
+  RemoteDataPipeSharedRingWrite write_data = {};
+  write_data.num_bytes_written = static_cast<uint32_t>(num_bytes);
+  scoped_ptr<MessageInTransit> message(new MessageInTransit(
+      MessageInTransit::Type::ENDPOINT_CLIENT,
+      MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA_PIPE_SHARED_RING_WRITE,
+      static_cast<uint32_t>(sizeof(write_data)), &write_data));
+  if (!channel_endpoint_->EnqueueMessage(message.Pass())) {
+    Disconnect();
+    return false;
+  }
+
+  shared_ring_write_index_ += num_bytes;
+  shared_ring_write_index_ %= capacity_num_bytes();
+  consumer_num_bytes_ += num_bytes;
+  return true;
+}
+
 void RemoteConsumerDataPipeImpl::Disconnect() {
   DCHECK(consumer_open());
   DCHECK(channel_endpoint_);
@@ -14,6 +14,12 @@
 #include "mojo/edk/system/system_impl_export.h"
 
 namespace mojo {
+
+namespace embedder {
+class PlatformSharedBuffer;
+class PlatformSharedBufferMapping;
+}
+
 namespace system {
 
 // |RemoteConsumerDataPipeImpl| is a subclass that "implements" |DataPipe| for
@@ -23,6 +29,16 @@ class MOJO_SYSTEM_IMPL_EXPORT RemoteConsumerDataPipeImpl : public DataPipeImpl {
  public:
   RemoteConsumerDataPipeImpl(ChannelEndpoint* channel_endpoint,
                              size_t consumer_num_bytes);
+  // Constructor for a data pipe whose data is written directly into a ring in
+  // shared memory (also mapped by the remote consumer); |shared_ring_mapping|
+  // must map all of |shared_ring|. |shared_ring_write_index| is the index in
+  // the ring at which the next data is to be written.
+  RemoteConsumerDataPipeImpl(
+      ChannelEndpoint* channel_endpoint,
+      size_t consumer_num_bytes,
+      scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+      scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping,
+      size_t shared_ring_write_index);
   ~RemoteConsumerDataPipeImpl() override;
 
   // Processes messages that were received and queued by an |IncomingEndpoint|.
@@ -86,6 +102,15 @@ class MOJO_SYSTEM_IMPL_EXPORT RemoteConsumerDataPipeImpl : public DataPipeImpl {
   void EnsureBuffer();
   void DestroyBuffer();
 
+  char* GetSharedRing() const;
+  // Gets the maximum (single, contiguous) write to the shared ring possible
+  // right now.
+  size_t GetMaxNumBytesToWriteToSharedRing() const;
+  // Tells the remote consumer that |num_bytes| more data was written to the
+  // shared ring (at |shared_ring_write_index_|), and updates our state.
+  // Returns false (after disconnecting) on failure.
+  bool SharedRingDataWritten(size_t num_bytes);
+
   void Disconnect();
 
   // Should be valid if and only if |consumer_open()| returns true.
@@ -95,9 +120,15 @@ class MOJO_SYSTEM_IMPL_EXPORT RemoteConsumerDataPipeImpl : public DataPipeImpl {
   // consumed.
   size_t consumer_num_bytes_;
 
-  // Used for two-phase writes.
+  // Used for two-phase writes (if there's no shared ring).
   scoped_ptr<char, base::AlignedFreeDeleter> buffer_;
 
+  // If set, data is written directly into this ring (which the remote consumer
+  // also maps), instead of being sent in messages.
+  scoped_refptr<embedder::PlatformSharedBuffer> shared_ring_;
+  scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping_;
+  size_t shared_ring_write_index_;
+
   DISALLOW_COPY_AND_ASSIGN(RemoteConsumerDataPipeImpl);
 };
 
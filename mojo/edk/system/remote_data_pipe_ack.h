@@ -16,6 +16,14 @@ struct RemoteDataPipeAck {
   uint32_t num_bytes_consumed;
 };
 
+// Data payload for
+// |MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA_PIPE_SHARED_RING_WRITE|
+// messages. The data itself is in the shared ring, starting just after the
+// previously-written data.
+struct RemoteDataPipeSharedRingWrite {
+  uint32_t num_bytes_written;
+};
+
 }  // namespace system
 }  // namespace mojo
 
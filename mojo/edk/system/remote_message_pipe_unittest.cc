@@ -307,6 +307,58 @@ TEST_F(RemoteMessagePipeTest, PeerClosed) {
   mp1->Close(1);
 }
 
+TEST_F(RemoteMessagePipeTest, WriteMessages) {
+  static const char kMessages[] = "hello world!!!1!!!1!";
+  static const uint32_t kMessageSizes[] = {5, 1, 14};
+  char buffer[100] = {0};
+  uint32_t buffer_size;
+  Waiter waiter;
+  uint32_t context = 0;
+
+  // Connect message pipes as in the |Basic| test.
+  scoped_refptr<ChannelEndpoint> ep0;
+  scoped_refptr<MessagePipe> mp0(MessagePipe::CreateLocalProxy(&ep0));
+  scoped_refptr<ChannelEndpoint> ep1;
+  scoped_refptr<MessagePipe> mp1(MessagePipe::CreateProxyLocal(&ep1));
+  BootstrapChannelEndpoints(ep0, ep1);
+
+  // Write all the messages at once to MP 0, port 0.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            mp0->WriteMessages(0, UserPointer<const void>(kMessages),
+                               kMessageSizes, nullptr, nullptr,
+                               arraysize(kMessageSizes),
+                               MOJO_WRITE_MESSAGE_FLAG_NONE));
+
+  // Read them, in order, from MP 1, port 1.
+  uint32_t offset = 0;
+  for (size_t i = 0; i < arraysize(kMessageSizes); i++) {
+    waiter.Init();
+    MojoResult result = mp1->AddAwakable(1, &waiter,
+                                         MOJO_HANDLE_SIGNAL_READABLE, 123,
+                                         nullptr);
+    if (result == MOJO_RESULT_OK) {
+      EXPECT_EQ(MOJO_RESULT_OK,
+                waiter.Wait(MOJO_DEADLINE_INDEFINITE, &context));
+      EXPECT_EQ(123u, context);
+      mp1->RemoveAwakable(1, &waiter, nullptr);
+    } else {
+      EXPECT_EQ(MOJO_RESULT_ALREADY_EXISTS, result);
+    }
+
+    buffer_size = static_cast<uint32_t>(sizeof(buffer));
+    EXPECT_EQ(MOJO_RESULT_OK,
+              mp1->ReadMessage(1, UserPointer<void>(buffer),
+                               MakeUserPointer(&buffer_size), nullptr, nullptr,
+                               MOJO_READ_MESSAGE_FLAG_NONE));
+    EXPECT_EQ(kMessageSizes[i], buffer_size);
+    EXPECT_EQ(0, memcmp(buffer, kMessages + offset, buffer_size));
+    offset += kMessageSizes[i];
+  }
+
+  mp0->Close(0);
+  mp1->Close(1);
+}
+
 TEST_F(RemoteMessagePipeTest, Multiplex) {
   static const char kHello[] = "hello";
   static const char kWorld[] = "world!!!1!!!1!";
@@ -10,6 +10,7 @@
 
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "mojo/edk/embedder/platform_shared_buffer.h"
 #include "mojo/edk/system/channel.h"
 #include "mojo/edk/system/channel_endpoint.h"
 #include "mojo/edk/system/configuration.h"
@@ -24,21 +25,42 @@ namespace system {
 
 namespace {
 
+// On success, sets |*num_bytes| to the amount of data written by the producer
+// (which is the message's data if |shared_ring| is false, and is in the shared
+// ring otherwise).
 bool ValidateIncomingMessage(size_t element_num_bytes,
                              size_t capacity_num_bytes,
                              size_t current_num_bytes,
-                             const MessageInTransit* message) {
+                             bool shared_ring,
+                             const MessageInTransit* message,
+                             size_t* num_bytes_written) {
   // We should only receive endpoint client messages.
   DCHECK_EQ(message->type(), MessageInTransit::Type::ENDPOINT_CLIENT);
 
-  // But we should check the subtype; only take data messages.
-  if (message->subtype() != MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA) {
+  // But we should check the subtype; only take data messages (or, with a shared
+  // ring, notifications that data was written).
+  const MessageInTransit::Subtype expected_subtype =
+      shared_ring ? MessageInTransit::Subtype::
+                        ENDPOINT_CLIENT_DATA_PIPE_SHARED_RING_WRITE
+                  : MessageInTransit::Subtype::ENDPOINT_CLIENT_DATA;
+  if (message->subtype() != expected_subtype) {
     LOG(WARNING) << "Received message of unexpected subtype: "
                  << message->subtype();
     return false;
   }
 
-  const size_t num_bytes = message->num_bytes();
+  size_t num_bytes = message->num_bytes();
+  if (shared_ring) {
+    if (message->num_bytes() != sizeof(RemoteDataPipeSharedRingWrite)) {
+      LOG(WARNING) << "Incorrect message size: " << message->num_bytes()
+                   << " bytes (expected: "
+                   << sizeof(RemoteDataPipeSharedRingWrite) << " bytes)";
+      return false;
+    }
+    num_bytes = static_cast<const RemoteDataPipeSharedRingWrite*>(
+                    message->bytes())->num_bytes_written;
+  }
+
   const size_t max_num_bytes = capacity_num_bytes - current_num_bytes;
   if (num_bytes > max_num_bytes) {
     LOG(WARNING) << "Received too much data: " << num_bytes
@@ -53,6 +75,7 @@ bool ValidateIncomingMessage(size_t element_num_bytes,
     return false;
   }
 
+  *num_bytes_written = num_bytes;
   return true;
 }
 
@@ -78,6 +101,22 @@ RemoteProducerDataPipeImpl::RemoteProducerDataPipeImpl(
   DCHECK(buffer_ || !current_num_bytes);
 }
 
+RemoteProducerDataPipeImpl::RemoteProducerDataPipeImpl(
+    ChannelEndpoint* channel_endpoint,
+    scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+    scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping,
+    size_t start_index,
+    size_t current_num_bytes)
+    : channel_endpoint_(channel_endpoint),
+      shared_ring_(shared_ring),
+      shared_ring_mapping_(shared_ring_mapping.Pass()),
+      start_index_(start_index),
+      current_num_bytes_(current_num_bytes) {
+  DCHECK(shared_ring_);
+  DCHECK(shared_ring_mapping_);
+  DCHECK_EQ(shared_ring_mapping_->GetLength(), shared_ring_->GetNumBytes());
+}
+
 // static
 bool RemoteProducerDataPipeImpl::ProcessMessagesFromIncomingEndpoint(
     const MojoCreateDataPipeOptions& validated_options,
@@ -97,15 +136,17 @@ bool RemoteProducerDataPipeImpl::ProcessMessagesFromIncomingEndpoint(
   if (messages) {
     while (!messages->IsEmpty()) {
       scoped_ptr<MessageInTransit> message(messages->GetMessage());
+      size_t num_bytes = 0;
       if (!ValidateIncomingMessage(element_num_bytes, capacity_num_bytes,
-                                   current_num_bytes, message.get())) {
+                                   current_num_bytes, false, message.get(),
+                                   &num_bytes)) {
         messages->Clear();
         return false;
       }
 
       memcpy(new_buffer.get() + current_num_bytes, message->bytes(),
-             message->num_bytes());
-      current_num_bytes += message->num_bytes();
+             num_bytes);
+      current_num_bytes += num_bytes;
     }
   }
 
@@ -114,6 +155,32 @@ bool RemoteProducerDataPipeImpl::ProcessMessagesFromIncomingEndpoint(
   return true;
 }
 
+// static
+bool RemoteProducerDataPipeImpl::ProcessSharedRingMessagesFromIncomingEndpoint(
+    const MojoCreateDataPipeOptions& validated_options,
+    MessageInTransitQueue* messages,
+    size_t* current_num_bytes) {
+  const size_t element_num_bytes = validated_options.element_num_bytes;
+  const size_t capacity_num_bytes = validated_options.capacity_num_bytes;
+
+  if (messages) {
+    while (!messages->IsEmpty()) {
+      scoped_ptr<MessageInTransit> message(messages->GetMessage());
+      size_t num_bytes = 0;
+      if (!ValidateIncomingMessage(element_num_bytes, capacity_num_bytes,
+                                   *current_num_bytes, true, message.get(),
+                                   &num_bytes)) {
+        messages->Clear();
+        return false;
+      }
+
+      *current_num_bytes += num_bytes;
+    }
+  }
+
+  return true;
+}
+
 RemoteProducerDataPipeImpl::~RemoteProducerDataPipeImpl() {
 }
 
@@ -198,12 +265,12 @@ MojoResult RemoteProducerDataPipeImpl::ConsumerReadData(
   // The amount we can read in our first |memcpy()|.
   size_t num_bytes_to_read_first =
       std::min(num_bytes_to_read, GetMaxNumBytesToRead());
-  elements.PutArray(buffer_.get() + start_index_, num_bytes_to_read_first);
+  elements.PutArray(GetBuffer() + start_index_, num_bytes_to_read_first);
 
   if (num_bytes_to_read_first < num_bytes_to_read) {
     // The "second read index" is zero.
     elements.At(num_bytes_to_read_first)
-        .PutArray(buffer_.get(), num_bytes_to_read - num_bytes_to_read_first);
+        .PutArray(GetBuffer(), num_bytes_to_read - num_bytes_to_read_first);
   }
 
   if (!peek)
@@ -265,7 +332,7 @@ MojoResult RemoteProducerDataPipeImpl::ConsumerBeginReadData(
                            : MOJO_RESULT_FAILED_PRECONDITION;
   }
 
-  buffer.Put(buffer_.get() + start_index_);
+  buffer.Put(GetBuffer() + start_index_);
   buffer_num_bytes.Put(static_cast<uint32_t>(max_num_bytes_to_read));
   set_consumer_two_phase_max_num_bytes_read(
       static_cast<uint32_t>(max_num_bytes_to_read));
@@ -286,12 +353,19 @@ HandleSignalsState RemoteProducerDataPipeImpl::ConsumerGetHandleSignalsState()
     const {
   HandleSignalsState rv;
   if (current_num_bytes_ > 0) {
-    if (!consumer_in_two_phase_read())
+    if (!consumer_in_two_phase_read()) {
       rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_READABLE;
+      if (current_num_bytes_ >= consumer_read_threshold_num_bytes())
+        rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_READ_THRESHOLD;
+    }
     rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_READABLE;
   } else if (producer_open()) {
     rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_READABLE;
   }
+  // Once the producer is closed, the amount of data can only go down.
+  if (producer_open() ||
+      current_num_bytes_ >= consumer_read_threshold_num_bytes())
+    rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_READ_THRESHOLD;
   if (!producer_open())
     rv.satisfied_signals |= MOJO_HANDLE_SIGNAL_PEER_CLOSED;
   rv.satisfiable_signals |= MOJO_HANDLE_SIGNAL_PEER_CLOSED;
@@ -304,7 +378,7 @@ void RemoteProducerDataPipeImpl::ConsumerStartSerialize(
     size_t* max_platform_handles) {
   *max_size = sizeof(SerializedDataPipeConsumerDispatcher) +
               channel->GetSerializedEndpointSize();
-  *max_platform_handles = 0;
+  *max_platform_handles = shared_ring_ ? 1 : 0;
 }
 
 bool RemoteProducerDataPipeImpl::ConsumerEndSerialize(
@@ -314,13 +388,30 @@ bool RemoteProducerDataPipeImpl::ConsumerEndSerialize(
     embedder::PlatformHandleVector* platform_handles) {
   SerializedDataPipeConsumerDispatcher* s =
       static_cast<SerializedDataPipeConsumerDispatcher*>(destination);
-  s->validated_options = validated_options();
+  s->validated_options = current_options();
+  s->shared_ring_platform_handle_index = kNoSharedRingPlatformHandleIndex;
+  s->shared_ring_start_index = 0;
+  s->shared_ring_num_bytes = 0;
   void* destination_for_endpoint = static_cast<char*>(destination) +
                                    sizeof(SerializedDataPipeConsumerDispatcher);
 
   MessageInTransitQueue message_queue;
-  ConvertDataToMessages(buffer_.get(), &start_index_, &current_num_bytes_,
-                        &message_queue);
+  if (shared_ring_) {
+    // The data stays where it is; the new consumer maps the same ring (and the
+    // producer keeps writing to it).
+    if (!SerializeSharedRing(shared_ring_.get(), platform_handles,
+                             &s->shared_ring_platform_handle_index)) {
+      if (producer_open())
+        Disconnect();
+      return false;
+    }
+    s->shared_ring_start_index = static_cast<uint32_t>(start_index_);
+    s->shared_ring_num_bytes = static_cast<uint32_t>(current_num_bytes_);
+    current_num_bytes_ = 0;
+  } else {
+    ConvertDataToMessages(buffer_.get(), &start_index_, &current_num_bytes_,
+                          &message_queue);
+  }
 
   if (!producer_open()) {
     // Case 1: The producer is closed.
@@ -357,13 +448,21 @@ bool RemoteProducerDataPipeImpl::OnReadMessage(unsigned /*port*/,
     return true;
   }
 
+  size_t num_bytes = 0;
   if (!ValidateIncomingMessage(element_num_bytes(), capacity_num_bytes(),
-                               current_num_bytes_, msg.get())) {
+                               current_num_bytes_, !!shared_ring_, msg.get(),
+                               &num_bytes)) {
     Disconnect();
     return true;
   }
 
-  size_t num_bytes = msg->num_bytes();
+  if (shared_ring_) {
+    // The producer already put the data in the ring.
+    current_num_bytes_ += num_bytes;
+    DCHECK_LE(current_num_bytes_, capacity_num_bytes());
+    return true;
+  }
+
   // The amount we can write in our first copy.
   size_t num_bytes_to_copy_first = std::min(num_bytes, GetMaxNumBytesToWrite());
   // Do the first (and possibly only) copy.
@@ -394,8 +493,15 @@ void RemoteProducerDataPipeImpl::OnDetachFromChannel(unsigned /*port*/) {
   Disconnect();
 }
 
+char* RemoteProducerDataPipeImpl::GetBuffer() const {
+  if (shared_ring_mapping_)
+    return static_cast<char*>(shared_ring_mapping_->GetBase());
+  return buffer_.get();
+}
+
 void RemoteProducerDataPipeImpl::EnsureBuffer() {
   DCHECK(producer_open());
+  DCHECK(!shared_ring_);
   if (buffer_)
     return;
   buffer_.reset(static_cast<char*>(
@@ -404,6 +510,10 @@ void RemoteProducerDataPipeImpl::EnsureBuffer() {
 }
 
 void RemoteProducerDataPipeImpl::DestroyBuffer() {
+  // Note: Don't scribble on a shared ring, since it may still be in use in
+  // another process.
+  shared_ring_mapping_.reset();
+  shared_ring_ = nullptr;
 #ifndef NDEBUG
   // Scribble on the buffer to help detect use-after-frees. (This also helps the
   // unit test detect certain bugs without needing ASAN or similar.)
@@ -14,6 +14,12 @@
 #include "mojo/edk/system/system_impl_export.h"
 
 namespace mojo {
+
+namespace embedder {
+class PlatformSharedBuffer;
+class PlatformSharedBufferMapping;
+}
+
 namespace system {
 
 class MessageInTransitQueue;
@@ -28,6 +34,15 @@ class MOJO_SYSTEM_IMPL_EXPORT RemoteProducerDataPipeImpl : public DataPipeImpl {
                              scoped_ptr<char, base::AlignedFreeDeleter> buffer,
                              size_t start_index,
                              size_t current_num_bytes);
+  // Constructor for a data pipe whose buffer is a ring in shared memory (also
+  // mapped by the remote producer); |shared_ring_mapping| must map all of
+  // |shared_ring|.
+  RemoteProducerDataPipeImpl(
+      ChannelEndpoint* channel_endpoint,
+      scoped_refptr<embedder::PlatformSharedBuffer> shared_ring,
+      scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping,
+      size_t start_index,
+      size_t current_num_bytes);
   ~RemoteProducerDataPipeImpl() override;
 
   // Processes messages that were received and queued by an |IncomingEndpoint|.
@@ -40,6 +55,16 @@ class MOJO_SYSTEM_IMPL_EXPORT RemoteProducerDataPipeImpl : public DataPipeImpl {
       scoped_ptr<char, base::AlignedFreeDeleter>* buffer,
       size_t* buffer_num_bytes);
 
+  // Like |ProcessMessagesFromIncomingEndpoint()|, but for a data pipe with a
+  // shared ring (so the messages only say how much data was written to the
+  // ring). |*current_num_bytes| should be set to the amount of data already in
+  // the ring; on success, returns true and updates |*current_num_bytes|. On
+  // failure, returns false. Always clears |*messages|.
+  static bool ProcessSharedRingMessagesFromIncomingEndpoint(
+      const MojoCreateDataPipeOptions& validated_options,
+      MessageInTransitQueue* messages,
+      size_t* current_num_bytes);
+
  private:
   // |DataPipeImpl| implementation:
   // Note: None of the |Producer...()| methods should be called, except
@@ -88,6 +113,8 @@ class MOJO_SYSTEM_IMPL_EXPORT RemoteProducerDataPipeImpl : public DataPipeImpl {
   bool OnReadMessage(unsigned port, MessageInTransit* message) override;
   void OnDetachFromChannel(unsigned port) override;
 
+  // Returns the (circular) buffer, which is the shared ring if there is one.
+  char* GetBuffer() const;
   void EnsureBuffer();
   void DestroyBuffer();
 
@@ -106,7 +133,12 @@ class MOJO_SYSTEM_IMPL_EXPORT RemoteProducerDataPipeImpl : public DataPipeImpl {
   // Should be valid if and only if |producer_open()| returns true.
   scoped_refptr<ChannelEndpoint> channel_endpoint_;
 
+  // Exactly one of |buffer_| (which is lazily allocated) and |shared_ring_|
+  // (with |shared_ring_mapping_|) is used, the latter if the producer writes
+  // directly into shared memory.
   scoped_ptr<char, base::AlignedFreeDeleter> buffer_;
+  scoped_refptr<embedder::PlatformSharedBuffer> shared_ring_;
+  scoped_ptr<embedder::PlatformSharedBufferMapping> shared_ring_mapping_;
   // Circular buffer.
   size_t start_index_;
   size_t current_num_bytes_;
@@ -81,6 +81,19 @@ MojoResult SharedBufferDispatcher::Create(
   return MOJO_RESULT_OK;
 }
 
+// static
+MojoResult SharedBufferDispatcher::CreateFromPlatformSharedBuffer(
+    scoped_refptr<embedder::PlatformSharedBuffer> shared_buffer,
+    scoped_refptr<SharedBufferDispatcher>* result) {
+  DCHECK(shared_buffer);
+  if (shared_buffer->GetNumBytes() >
+      GetConfiguration().max_shared_memory_num_bytes)
+    return MOJO_RESULT_RESOURCE_EXHAUSTED;
+
+  *result = new SharedBufferDispatcher(shared_buffer);
+  return MOJO_RESULT_OK;
+}
+
 Dispatcher::Type SharedBufferDispatcher::GetType() const {
   return Type::SHARED_BUFFER;
 }
@@ -46,6 +46,12 @@ class MOJO_SYSTEM_IMPL_EXPORT SharedBufferDispatcher : public SimpleDispatcher {
       uint64_t num_bytes,
       scoped_refptr<SharedBufferDispatcher>* result);
 
+  // Static factory method that wraps an existing |shared_buffer| (which must
+  // be non-null). On failure, |*result| will be left as-is.
+  static MojoResult CreateFromPlatformSharedBuffer(
+      scoped_refptr<embedder::PlatformSharedBuffer> shared_buffer,
+      scoped_refptr<SharedBufferDispatcher>* result);
+
   // |Dispatcher| public methods:
   Type GetType() const override;
 
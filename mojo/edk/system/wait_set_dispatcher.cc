@@ -0,0 +1,341 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/wait_set_dispatcher.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+
+namespace mojo {
+namespace system {
+
+WaitSetDispatcher::Entry::Entry()
+    : signals(MOJO_HANDLE_SIGNAL_NONE),
+      registered(false),
+      ready(false),
+      cancelled(false) {
+}
+
+WaitSetDispatcher::Entry::~Entry() {
+}
+
+WaitSetDispatcher::WaitSetDispatcher() {
+}
+
+Dispatcher::Type WaitSetDispatcher::GetType() const {
+  return Type::WAIT_SET;
+}
+
+bool WaitSetDispatcher::Awake(MojoResult result, uintptr_t context) {
+  MojoHandle handle = static_cast<MojoHandle>(context);
+
+  base::AutoLock locker(awakable_lock_);
+  // We only remove entries after unregistering from their dispatchers (or after
+  // their dispatchers have cancelled us), so the entry must still be present.
+  HandleToEntryMap::iterator it = entries_.find(handle);
+  DCHECK(it != entries_.end());
+  if (result == MOJO_RESULT_CANCELLED)
+    it->second.cancelled = true;
+  MarkReadyNoLock(handle, &it->second);
+  // Stay registered: the wait set is only updated explicitly.
+  return true;
+}
+
+WaitSetDispatcher::~WaitSetDispatcher() {
+  DCHECK(entries_.empty());
+  DCHECK(ready_list_.empty());
+}
+
+void WaitSetDispatcher::CancelAllAwakablesNoLock() {
+  lock().AssertAcquired();
+  base::AutoLock locker(awakable_lock_);
+  awakable_list_.CancelAll();
+}
+
+void WaitSetDispatcher::CloseImplNoLock() {
+  lock().AssertAcquired();
+
+  for (HandleToEntryMap::iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    if (it->second.registered)
+      it->second.dispatcher->RemoveAwakable(this, nullptr);
+  }
+
+  // Release our references to the member dispatchers outside
+  // |awakable_lock_|.
+  HandleToEntryMap entries;
+  {
+    base::AutoLock locker(awakable_lock_);
+    entries.swap(entries_);
+    ready_list_.clear();
+  }
+}
+
+scoped_refptr<Dispatcher>
+WaitSetDispatcher::CreateEquivalentDispatcherAndCloseImplNoLock() {
+  lock().AssertAcquired();
+  // Wait sets may not be sent over message pipes, which should have been
+  // checked (see |MessagePipe::AttachTransportsNoLock()|).
+  NOTREACHED();
+  CloseImplNoLock();
+  return nullptr;
+}
+
+MojoResult WaitSetDispatcher::AddWaitingDispatcherImplNoLock(
+    const scoped_refptr<Dispatcher>& dispatcher,
+    MojoHandle handle,
+    MojoHandleSignals signals) {
+  lock().AssertAcquired();
+  DCHECK(dispatcher);
+
+  // This also disallows adding a wait set to itself. (Nesting wait sets would
+  // violate our lock order.)
+  if (dispatcher->GetType() == Type::WAIT_SET)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+  if (entries_.find(handle) != entries_.end())
+    return MOJO_RESULT_ALREADY_EXISTS;
+
+  Entry* entry;
+  {
+    base::AutoLock locker(awakable_lock_);
+    entry = &entries_[handle];
+  }
+  entry->dispatcher = dispatcher;
+  entry->signals = signals;
+
+  MojoResult rv = dispatcher->AddAwakable(this, signals, handle, nullptr);
+  switch (rv) {
+    case MOJO_RESULT_OK:
+      entry->registered = true;
+      return MOJO_RESULT_OK;
+    case MOJO_RESULT_ALREADY_EXISTS:
+    case MOJO_RESULT_FAILED_PRECONDITION: {
+      // The dispatcher didn't register us, since it's already ready (in one
+      // way or another). Mark it ready; |GetReadyHandlesImplNoLock()| will try
+      // to register us again if/when it stops being ready.
+      base::AutoLock locker(awakable_lock_);
+      MarkReadyNoLock(handle, entry);
+      return MOJO_RESULT_OK;
+    }
+    default:
+      break;
+  }
+
+  // The dispatcher must have been closed in the meantime.
+  DCHECK_EQ(rv, MOJO_RESULT_INVALID_ARGUMENT);
+  scoped_refptr<Dispatcher> unused;
+  {
+    base::AutoLock locker(awakable_lock_);
+    HandleToEntryMap::iterator it = entries_.find(handle);
+    unused.swap(it->second.dispatcher);
+    EraseEntryNoLock(it);
+  }
+  return MOJO_RESULT_INVALID_ARGUMENT;
+}
+
+MojoResult WaitSetDispatcher::RemoveWaitingDispatcherImplNoLock(
+    MojoHandle handle) {
+  lock().AssertAcquired();
+
+  HandleToEntryMap::iterator it = entries_.find(handle);
+  if (it == entries_.end())
+    return MOJO_RESULT_NOT_FOUND;
+
+  scoped_refptr<Dispatcher> dispatcher;
+  dispatcher.swap(it->second.dispatcher);
+  if (it->second.registered)
+    dispatcher->RemoveAwakable(this, nullptr);
+
+  base::AutoLock locker(awakable_lock_);
+  EraseEntryNoLock(it);
+  return MOJO_RESULT_OK;
+}
+
+MojoResult WaitSetDispatcher::GetReadyHandlesImplNoLock(
+    uint32_t max_count,
+    std::vector<MojoHandle>* handles,
+    std::vector<MojoResult>* results,
+    std::vector<HandleSignalsState>* signals_states) {
+  lock().AssertAcquired();
+  DCHECK_GT(max_count, 0u);
+
+  // Take the current ready list. Our member dispatchers may push onto
+  // |ready_list_| again while we (without holding |awakable_lock_|) check
+  // them.
+  std::deque<MojoHandle> candidates;
+  {
+    base::AutoLock locker(awakable_lock_);
+    candidates.swap(ready_list_);
+    for (size_t i = 0; i < candidates.size(); i++)
+      entries_[candidates[i]].ready = false;
+  }
+
+  uint32_t num_ready = 0;
+  std::vector<MojoHandle> still_ready;
+  size_t i = 0;
+  for (; i < candidates.size() && num_ready < max_count; i++) {
+    MojoHandle handle = candidates[i];
+    HandleToEntryMap::iterator it = entries_.find(handle);
+    DCHECK(it != entries_.end());
+    Entry* entry = &it->second;
+
+    bool cancelled;
+    {
+      base::AutoLock locker(awakable_lock_);
+      cancelled = entry->cancelled;
+    }
+
+    HandleSignalsState state;
+    MojoResult result;
+    if (!cancelled && !entry->registered) {
+      // We weren't registered, since the dispatcher was ready when it was
+      // added, so we won't have been told if it was closed. Try to register,
+      // which also tells us whether it's (still) ready or has been closed.
+      result = entry->dispatcher->AddAwakable(this, entry->signals, handle,
+                                              &state);
+      if (result == MOJO_RESULT_OK) {
+        // Not ready any more. It'll be pushed onto the ready list again when
+        // its dispatcher next wakes us.
+        entry->registered = true;
+        continue;
+      }
+      if (result == MOJO_RESULT_ALREADY_EXISTS)
+        result = MOJO_RESULT_OK;
+      else if (result == MOJO_RESULT_INVALID_ARGUMENT)
+        cancelled = true;
+      else
+        DCHECK_EQ(result, MOJO_RESULT_FAILED_PRECONDITION);
+    } else if (!cancelled) {
+      state = entry->dispatcher->GetHandleSignalsState();
+      if (state.satisfies(entry->signals)) {
+        result = MOJO_RESULT_OK;
+      } else if (!state.can_satisfy(entry->signals)) {
+        result = MOJO_RESULT_FAILED_PRECONDITION;
+      } else {
+        // Not ready (any more). It'll be pushed onto the ready list again when
+        // its dispatcher next wakes us.
+        continue;
+      }
+    }
+
+    if (cancelled) {
+      // The handle was closed, so report it this one time and then forget it.
+      // (Its dispatcher has already dropped us.)
+      result = MOJO_RESULT_CANCELLED;
+      state = HandleSignalsState();
+      scoped_refptr<Dispatcher> unused;
+      base::AutoLock locker(awakable_lock_);
+      unused.swap(entry->dispatcher);
+      EraseEntryNoLock(it);
+    } else {
+      still_ready.push_back(handle);
+    }
+
+    handles->push_back(handle);
+    results->push_back(result);
+    signals_states->push_back(state);
+    num_ready++;
+  }
+
+  {
+    base::AutoLock locker(awakable_lock_);
+    // The new ready list consists of the candidates we didn't get to, followed
+    // by the entries that became ready while we were checking, followed by the
+    // entries that we reported and are still ready (so that, if there are more
+    // ready entries than |max_count|, we cycle through them).
+    std::deque<MojoHandle> ready_list;
+    for (; i < candidates.size(); i++) {
+      Entry* entry = &entries_[candidates[i]];
+      if (!entry->ready) {
+        entry->ready = true;
+        ready_list.push_back(candidates[i]);
+      }
+    }
+    ready_list.insert(ready_list.end(), ready_list_.begin(), ready_list_.end());
+    for (size_t j = 0; j < still_ready.size(); j++) {
+      Entry* entry = &entries_[still_ready[j]];
+      if (!entry->ready) {
+        entry->ready = true;
+        ready_list.push_back(still_ready[j]);
+      }
+    }
+    ready_list_.swap(ready_list);
+  }
+
+  return num_ready ? MOJO_RESULT_OK : MOJO_RESULT_SHOULD_WAIT;
+}
+
+HandleSignalsState WaitSetDispatcher::GetHandleSignalsStateImplNoLock() const {
+  lock().AssertAcquired();
+  base::AutoLock locker(awakable_lock_);
+  return GetHandleSignalsStateNoLock();
+}
+
+MojoResult WaitSetDispatcher::AddAwakableImplNoLock(
+    Awakable* awakable,
+    MojoHandleSignals signals,
+    uint32_t context,
+    HandleSignalsState* signals_state) {
+  lock().AssertAcquired();
+  base::AutoLock locker(awakable_lock_);
+
+  HandleSignalsState state(GetHandleSignalsStateNoLock());
+  if (state.satisfies(signals)) {
+    if (signals_state)
+      *signals_state = state;
+    return MOJO_RESULT_ALREADY_EXISTS;
+  }
+  if (!state.can_satisfy(signals)) {
+    if (signals_state)
+      *signals_state = state;
+    return MOJO_RESULT_FAILED_PRECONDITION;
+  }
+
+  awakable_list_.Add(awakable, signals, context);
+  return MOJO_RESULT_OK;
+}
+
+void WaitSetDispatcher::RemoveAwakableImplNoLock(
+    Awakable* awakable,
+    HandleSignalsState* signals_state) {
+  lock().AssertAcquired();
+  base::AutoLock locker(awakable_lock_);
+  awakable_list_.Remove(awakable);
+  if (signals_state)
+    *signals_state = GetHandleSignalsStateNoLock();
+}
+
+void WaitSetDispatcher::MarkReadyNoLock(MojoHandle handle, Entry* entry) {
+  awakable_lock_.AssertAcquired();
+  if (entry->ready)
+    return;
+
+  entry->ready = true;
+  ready_list_.push_back(handle);
+  if (ready_list_.size() == 1u)
+    awakable_list_.AwakeForStateChange(GetHandleSignalsStateNoLock());
+}
+
+void WaitSetDispatcher::EraseEntryNoLock(HandleToEntryMap::iterator it) {
+  lock().AssertAcquired();
+  awakable_lock_.AssertAcquired();
+  if (it->second.ready) {
+    ready_list_.erase(
+        std::find(ready_list_.begin(), ready_list_.end(), it->first));
+  }
+  entries_.erase(it);
+}
+
+HandleSignalsState WaitSetDispatcher::GetHandleSignalsStateNoLock() const {
+  awakable_lock_.AssertAcquired();
+  return HandleSignalsState(
+      ready_list_.empty() ? MOJO_HANDLE_SIGNAL_NONE
+                          : MOJO_HANDLE_SIGNAL_READABLE,
+      MOJO_HANDLE_SIGNAL_READABLE);
+}
+
+}  // namespace system
+}  // namespace mojo
@@ -0,0 +1,123 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_EDK_SYSTEM_WAIT_SET_DISPATCHER_H_
+#define MOJO_EDK_SYSTEM_WAIT_SET_DISPATCHER_H_
+
+#include <stdint.h>
+
+#include <deque>
+#include <vector>
+
+#include "base/containers/hash_tables.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "mojo/edk/system/awakable.h"
+#include "mojo/edk/system/awakable_list.h"
+#include "mojo/edk/system/dispatcher.h"
+#include "mojo/edk/system/system_impl_export.h"
+
+namespace mojo {
+namespace system {
+
+// This is the |Dispatcher| implementation for wait sets (created by the Mojo
+// primitive |MojoCreateWaitSet()|). A wait set registers itself (as an
+// |Awakable|, with the member's handle as context) with each member dispatcher
+// once, when the member is added, and stays registered until it is removed.
+// Members' |AwakableList|s then push the member onto a ready list when they
+// wake it, so |GetReadyHandles()| only has to look at members that are (or
+// recently were) ready.
+//
+// The ready list is "level-triggered": a member stays on it for as long as it
+// is ready when checked by |GetReadyHandles()|, and is dropped from it (to be
+// pushed again by its next wake-up) otherwise.
+//
+// Lock order: Unlike other dispatchers, a wait set calls into its members'
+// dispatchers with its own dispatcher lock held. This is safe since a wait set
+// may not be a member of a wait set or be sent over a message pipe, and a
+// member only ever calls back (via |Awake()|) under its locks, which takes only
+// |awakable_lock_| below. |awakable_lock_| is terminal, except that waiters on
+// the wait set itself are woken under it (and |Waiter| locks are terminal).
+class MOJO_SYSTEM_IMPL_EXPORT WaitSetDispatcher : public Dispatcher,
+                                                  public Awakable {
+ public:
+  WaitSetDispatcher();
+
+  // |Dispatcher| public methods:
+  Type GetType() const override;
+
+  // |Awakable| implementation:
+  bool Awake(MojoResult result, uintptr_t context) override;
+
+ private:
+  // Members are never erased (or inserted) except under both |lock()| and
+  // |awakable_lock_|, so may be looked up under either.
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    scoped_refptr<Dispatcher> dispatcher;
+    MojoHandleSignals signals;
+    // Whether we're in |dispatcher|'s awakable list. (Protected by |lock()|.)
+    bool registered;
+    // Whether this entry is in |ready_list_|. (Protected by |awakable_lock_|.)
+    bool ready;
+    // Whether |dispatcher| has been closed (or transferred), as indicated by
+    // an |Awake()| with |MOJO_RESULT_CANCELLED|. (Protected by
+    // |awakable_lock_|.)
+    bool cancelled;
+  };
+  // Note: |Entry| pointers are stable, since this is a node-based container.
+  using HandleToEntryMap = base::hash_map<MojoHandle, Entry>;
+
+  ~WaitSetDispatcher() override;
+
+  // |Dispatcher| protected methods:
+  void CancelAllAwakablesNoLock() override;
+  void CloseImplNoLock() override;
+  scoped_refptr<Dispatcher> CreateEquivalentDispatcherAndCloseImplNoLock()
+      override;
+  MojoResult AddWaitingDispatcherImplNoLock(
+      const scoped_refptr<Dispatcher>& dispatcher,
+      MojoHandle handle,
+      MojoHandleSignals signals) override;
+  MojoResult RemoveWaitingDispatcherImplNoLock(MojoHandle handle) override;
+  MojoResult GetReadyHandlesImplNoLock(
+      uint32_t max_count,
+      std::vector<MojoHandle>* handles,
+      std::vector<MojoResult>* results,
+      std::vector<HandleSignalsState>* signals_states) override;
+  HandleSignalsState GetHandleSignalsStateImplNoLock() const override;
+  MojoResult AddAwakableImplNoLock(Awakable* awakable,
+                                   MojoHandleSignals signals,
+                                   uint32_t context,
+                                   HandleSignalsState* signals_state) override;
+  void RemoveAwakableImplNoLock(Awakable* awakable,
+                                HandleSignalsState* signals_state) override;
+
+  // Pushes |handle|'s entry onto |ready_list_| (if it isn't already there),
+  // waking our own awakables if the list was empty. Must be called under
+  // |awakable_lock_|.
+  void MarkReadyNoLock(MojoHandle handle, Entry* entry);
+  // Erases |handle|'s entry, removing it from |ready_list_| if necessary. Must
+  // be called under both |lock()| and |awakable_lock_|.
+  void EraseEntryNoLock(HandleToEntryMap::iterator it);
+  HandleSignalsState GetHandleSignalsStateNoLock() const;
+
+  // See the comment above |Entry|.
+  HandleToEntryMap entries_;
+
+  mutable base::Lock awakable_lock_;  // Protects the following members.
+  // Handles of members that (may) be ready, in the order they became ready.
+  std::deque<MojoHandle> ready_list_;
+  // Awakables (i.e., waiters) on the wait set itself.
+  AwakableList awakable_list_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaitSetDispatcher);
+};
+
+}  // namespace system
+}  // namespace mojo
+
+#endif  // MOJO_EDK_SYSTEM_WAIT_SET_DISPATCHER_H_
@@ -0,0 +1,322 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/system/wait_set_dispatcher.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "mojo/edk/system/message_pipe.h"
+#include "mojo/edk/system/message_pipe_dispatcher.h"
+#include "mojo/edk/system/test_utils.h"
+#include "mojo/edk/system/waiter.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace system {
+namespace {
+
+// The wait set dispatcher doesn't care about the handles' values, so long as
+// they're distinct.
+const MojoHandle kHandle0 = 10;
+const MojoHandle kHandle1 = 11;
+const MojoHandle kHandle2 = 12;
+
+void CreateMessagePipeDispatchers(scoped_refptr<MessagePipeDispatcher>* d0,
+                                  scoped_refptr<MessagePipeDispatcher>* d1) {
+  *d0 = new MessagePipeDispatcher(MessagePipeDispatcher::kDefaultCreateOptions);
+  *d1 = new MessagePipeDispatcher(MessagePipeDispatcher::kDefaultCreateOptions);
+  scoped_refptr<MessagePipe> mp(MessagePipe::CreateLocalLocal());
+  (*d0)->Init(mp, 0);
+  (*d1)->Init(mp, 1);
+}
+
+void WriteOneByte(Dispatcher* dispatcher) {
+  char byte = 'x';
+  ASSERT_EQ(MOJO_RESULT_OK,
+            dispatcher->WriteMessage(UserPointer<const void>(&byte), 1u,
+                                     nullptr, MOJO_WRITE_MESSAGE_FLAG_NONE));
+}
+
+void ReadOneByte(Dispatcher* dispatcher) {
+  char byte = 0;
+  uint32_t num_bytes = 1u;
+  ASSERT_EQ(MOJO_RESULT_OK,
+            dispatcher->ReadMessage(UserPointer<void>(&byte),
+                                    MakeUserPointer(&num_bytes), nullptr,
+                                    nullptr, MOJO_READ_MESSAGE_FLAG_NONE));
+  EXPECT_EQ('x', byte);
+}
+
+// Calls |GetReadyHandles()| with the given |max_count|, returning the result
+// and clearing and filling the given vectors.
+MojoResult GetReadyHandles(Dispatcher* wait_set,
+                           uint32_t max_count,
+                           std::vector<MojoHandle>* handles,
+                           std::vector<MojoResult>* results) {
+  handles->clear();
+  results->clear();
+  std::vector<HandleSignalsState> signals_states;
+  MojoResult rv =
+      wait_set->GetReadyHandles(max_count, handles, results, &signals_states);
+  EXPECT_EQ(handles->size(), results->size());
+  EXPECT_EQ(handles->size(), signals_states.size());
+  return rv;
+}
+
+TEST(WaitSetDispatcherTest, Basic) {
+  test::Stopwatch stopwatch;
+  scoped_refptr<WaitSetDispatcher> ws(new WaitSetDispatcher());
+  EXPECT_EQ(Dispatcher::Type::WAIT_SET, ws->GetType());
+  scoped_refptr<MessagePipeDispatcher> d0;
+  scoped_refptr<MessagePipeDispatcher> d1;
+  CreateMessagePipeDispatchers(&d0, &d1);
+  std::vector<MojoHandle> handles;
+  std::vector<MojoResult> results;
+
+  EXPECT_EQ(MOJO_RESULT_OK,
+            ws->AddWaitingDispatcher(d0, kHandle0, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_ALREADY_EXISTS,
+            ws->AddWaitingDispatcher(d0, kHandle0, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            GetReadyHandles(ws.get(), 10u, &handles, &results));
+  EXPECT_TRUE(handles.empty());
+  HandleSignalsState hss = ws->GetHandleSignalsState();
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_NONE, hss.satisfied_signals);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE, hss.satisfiable_signals);
+
+  // Wait on the wait set, and make |d0| readable.
+  Waiter w;
+  w.Init();
+  ASSERT_EQ(MOJO_RESULT_OK,
+            ws->AddAwakable(&w, MOJO_HANDLE_SIGNAL_READABLE, 1, nullptr));
+  WriteOneByte(d1.get());
+  uint32_t context = 0;
+  stopwatch.Start();
+  EXPECT_EQ(MOJO_RESULT_OK, w.Wait(MOJO_DEADLINE_INDEFINITE, &context));
+  EXPECT_EQ(1u, context);
+  EXPECT_LT(stopwatch.Elapsed(), test::EpsilonTimeout());
+  hss = HandleSignalsState();
+  ws->RemoveAwakable(&w, &hss);
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE, hss.satisfied_signals);
+
+  // It stays ready until it's read from.
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(MOJO_RESULT_OK,
+              GetReadyHandles(ws.get(), 10u, &handles, &results));
+    ASSERT_EQ(1u, handles.size());
+    EXPECT_EQ(kHandle0, handles[0]);
+    EXPECT_EQ(MOJO_RESULT_OK, results[0]);
+  }
+  ReadOneByte(d0.get());
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            GetReadyHandles(ws.get(), 10u, &handles, &results));
+  hss = ws->GetHandleSignalsState();
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_NONE, hss.satisfied_signals);
+
+  // It becomes ready again when written to again.
+  WriteOneByte(d1.get());
+  ASSERT_EQ(MOJO_RESULT_OK, GetReadyHandles(ws.get(), 10u, &handles, &results));
+  ASSERT_EQ(1u, handles.size());
+  EXPECT_EQ(kHandle0, handles[0]);
+
+  // Once removed, it's no longer reported.
+  EXPECT_EQ(MOJO_RESULT_OK, ws->RemoveWaitingDispatcher(kHandle0));
+  EXPECT_EQ(MOJO_RESULT_NOT_FOUND, ws->RemoveWaitingDispatcher(kHandle0));
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            GetReadyHandles(ws.get(), 10u, &handles, &results));
+
+  EXPECT_EQ(MOJO_RESULT_OK, ws->Close());
+  EXPECT_EQ(MOJO_RESULT_OK, d0->Close());
+  EXPECT_EQ(MOJO_RESULT_OK, d1->Close());
+}
+
+TEST(WaitSetDispatcherTest, AlreadyReadyWhenAdded) {
+  scoped_refptr<WaitSetDispatcher> ws(new WaitSetDispatcher());
+  scoped_refptr<MessagePipeDispatcher> d0;
+  scoped_refptr<MessagePipeDispatcher> d1;
+  CreateMessagePipeDispatchers(&d0, &d1);
+  std::vector<MojoHandle> handles;
+  std::vector<MojoResult> results;
+
+  WriteOneByte(d1.get());
+  EXPECT_EQ(MOJO_RESULT_OK,
+            ws->AddWaitingDispatcher(d0, kHandle0, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_HANDLE_SIGNAL_READABLE,
+            ws->GetHandleSignalsState().satisfied_signals);
+  ASSERT_EQ(MOJO_RESULT_OK, GetReadyHandles(ws.get(), 10u, &handles, &results));
+  ASSERT_EQ(1u, handles.size());
+  EXPECT_EQ(kHandle0, handles[0]);
+  EXPECT_EQ(MOJO_RESULT_OK, results[0]);
+
+  // Once it's no longer ready, the wait set should register itself with |d0|,
+  // so that it notices when |d0| becomes ready again.
+  ReadOneByte(d0.get());
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            GetReadyHandles(ws.get(), 10u, &handles, &results));
+  Waiter w;
+  w.Init();
+  ASSERT_EQ(MOJO_RESULT_OK,
+            ws->AddAwakable(&w, MOJO_HANDLE_SIGNAL_READABLE, 2, nullptr));
+  WriteOneByte(d1.get());
+  uint32_t context = 0;
+  EXPECT_EQ(MOJO_RESULT_OK, w.Wait(MOJO_DEADLINE_INDEFINITE, &context));
+  EXPECT_EQ(2u, context);
+  ws->RemoveAwakable(&w, nullptr);
+  ASSERT_EQ(MOJO_RESULT_OK, GetReadyHandles(ws.get(), 10u, &handles, &results));
+  ASSERT_EQ(1u, handles.size());
+  EXPECT_EQ(kHandle0, handles[0]);
+
+  EXPECT_EQ(MOJO_RESULT_OK, ws->Close());
+  EXPECT_EQ(MOJO_RESULT_OK, d0->Close());
+  EXPECT_EQ(MOJO_RESULT_OK, d1->Close());
+}
+
+TEST(WaitSetDispatcherTest, UnsatisfiableAndClosed) {
+  scoped_refptr<WaitSetDispatcher> ws(new WaitSetDispatcher());
+  scoped_refptr<MessagePipeDispatcher> d0;
+  scoped_refptr<MessagePipeDispatcher> d1;
+  CreateMessagePipeDispatchers(&d0, &d1);
+  std::vector<MojoHandle> handles;
+  std::vector<MojoResult> results;
+
+  EXPECT_EQ(MOJO_RESULT_OK,
+            ws->AddWaitingDispatcher(d0, kHandle0, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            ws->AddWaitingDispatcher(d1, kHandle1, MOJO_HANDLE_SIGNAL_READABLE));
+
+  // Closing |d1| makes |d0| never readable, and cancels |d1|.
+  EXPECT_EQ(MOJO_RESULT_OK, d1->Close());
+  ASSERT_EQ(MOJO_RESULT_OK, GetReadyHandles(ws.get(), 10u, &handles, &results));
+  ASSERT_EQ(2u, handles.size());
+  for (size_t i = 0; i < handles.size(); i++) {
+    if (handles[i] == kHandle0) {
+      EXPECT_EQ(MOJO_RESULT_FAILED_PRECONDITION, results[i]);
+    } else {
+      EXPECT_EQ(kHandle1, handles[i]);
+      EXPECT_EQ(MOJO_RESULT_CANCELLED, results[i]);
+    }
+  }
+
+  // |d1| was removed after it was reported; |d0| is still reported.
+  ASSERT_EQ(MOJO_RESULT_OK, GetReadyHandles(ws.get(), 10u, &handles, &results));
+  ASSERT_EQ(1u, handles.size());
+  EXPECT_EQ(kHandle0, handles[0]);
+  EXPECT_EQ(MOJO_RESULT_FAILED_PRECONDITION, results[0]);
+  EXPECT_EQ(MOJO_RESULT_NOT_FOUND, ws->RemoveWaitingDispatcher(kHandle1));
+
+  // Closed dispatchers can't be added.
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            ws->AddWaitingDispatcher(d1, kHandle1, MOJO_HANDLE_SIGNAL_READABLE));
+
+  EXPECT_EQ(MOJO_RESULT_OK, ws->Close());
+  EXPECT_EQ(MOJO_RESULT_OK, d0->Close());
+}
+
+TEST(WaitSetDispatcherTest, AlreadyReadyWhenAddedAndClosed) {
+  scoped_refptr<WaitSetDispatcher> ws(new WaitSetDispatcher());
+  scoped_refptr<MessagePipeDispatcher> d0;
+  scoped_refptr<MessagePipeDispatcher> d1;
+  CreateMessagePipeDispatchers(&d0, &d1);
+  std::vector<MojoHandle> handles;
+  std::vector<MojoResult> results;
+
+  // |d0| is readable when it's added, so the wait set doesn't register itself
+  // with it (and so isn't told when it's closed).
+  WriteOneByte(d1.get());
+  EXPECT_EQ(MOJO_RESULT_OK,
+            ws->AddWaitingDispatcher(d0, kHandle0, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_OK, d0->Close());
+
+  // It's reported once, as cancelled, and then removed.
+  ASSERT_EQ(MOJO_RESULT_OK, GetReadyHandles(ws.get(), 10u, &handles, &results));
+  ASSERT_EQ(1u, handles.size());
+  EXPECT_EQ(kHandle0, handles[0]);
+  EXPECT_EQ(MOJO_RESULT_CANCELLED, results[0]);
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            GetReadyHandles(ws.get(), 10u, &handles, &results));
+  EXPECT_EQ(MOJO_RESULT_NOT_FOUND, ws->RemoveWaitingDispatcher(kHandle0));
+
+  EXPECT_EQ(MOJO_RESULT_OK, ws->Close());
+  EXPECT_EQ(MOJO_RESULT_OK, d1->Close());
+}
+
+TEST(WaitSetDispatcherTest, MaxCount) {
+  scoped_refptr<WaitSetDispatcher> ws(new WaitSetDispatcher());
+  scoped_refptr<MessagePipeDispatcher> d[6];
+  const MojoHandle kHandles[3] = {kHandle0, kHandle1, kHandle2};
+  for (size_t i = 0; i < 3; i++) {
+    CreateMessagePipeDispatchers(&d[2 * i], &d[2 * i + 1]);
+    EXPECT_EQ(MOJO_RESULT_OK,
+              ws->AddWaitingDispatcher(d[2 * i], kHandles[i],
+                                       MOJO_HANDLE_SIGNAL_READABLE));
+    WriteOneByte(d[2 * i + 1].get());
+  }
+  std::vector<MojoHandle> handles;
+  std::vector<MojoResult> results;
+
+  // Successive calls should cycle through all the ready handles.
+  std::vector<MojoHandle> seen;
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_EQ(MOJO_RESULT_OK,
+              GetReadyHandles(ws.get(), 1u, &handles, &results));
+    ASSERT_EQ(1u, handles.size());
+    EXPECT_EQ(MOJO_RESULT_OK, results[0]);
+    seen.push_back(handles[0]);
+  }
+  std::sort(seen.begin(), seen.end());
+  EXPECT_EQ(std::vector<MojoHandle>(kHandles, kHandles + 3), seen);
+
+  ASSERT_EQ(MOJO_RESULT_OK, GetReadyHandles(ws.get(), 2u, &handles, &results));
+  EXPECT_EQ(2u, handles.size());
+  ASSERT_EQ(MOJO_RESULT_OK, GetReadyHandles(ws.get(), 3u, &handles, &results));
+  EXPECT_EQ(3u, handles.size());
+
+  EXPECT_EQ(MOJO_RESULT_OK, ws->Close());
+  for (size_t i = 0; i < 6; i++)
+    EXPECT_EQ(MOJO_RESULT_OK, d[i]->Close());
+}
+
+TEST(WaitSetDispatcherTest, InvalidArguments) {
+  scoped_refptr<WaitSetDispatcher> ws(new WaitSetDispatcher());
+  scoped_refptr<WaitSetDispatcher> other_ws(new WaitSetDispatcher());
+  std::vector<MojoHandle> handles;
+  std::vector<MojoResult> results;
+
+  // Wait sets can't be added to wait sets.
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            ws->AddWaitingDispatcher(other_ws, kHandle0,
+                                     MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            ws->AddWaitingDispatcher(ws, kHandle1, MOJO_HANDLE_SIGNAL_READABLE));
+
+  // Other dispatchers aren't wait sets.
+  scoped_refptr<MessagePipeDispatcher> d0;
+  scoped_refptr<MessagePipeDispatcher> d1;
+  CreateMessagePipeDispatchers(&d0, &d1);
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            d0->AddWaitingDispatcher(d1, kHandle1, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT, d0->RemoveWaitingDispatcher(kHandle1));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            GetReadyHandles(d0.get(), 1u, &handles, &results));
+
+  // Closing the wait set unregisters it from its members.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            ws->AddWaitingDispatcher(d0, kHandle0, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_OK, ws->Close());
+  WriteOneByte(d1.get());
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            ws->AddWaitingDispatcher(d1, kHandle1, MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            GetReadyHandles(ws.get(), 1u, &handles, &results));
+
+  EXPECT_EQ(MOJO_RESULT_OK, other_ws->Close());
+  EXPECT_EQ(MOJO_RESULT_OK, d0->Close());
+  EXPECT_EQ(MOJO_RESULT_OK, d1->Close());
+}
+
+}  // namespace
+}  // namespace system
+}  // namespace mojo
@@ -4,20 +4,39 @@
 
 #include "mojo/edk/system/waiter.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "base/logging.h"
+#include "base/threading/platform_thread.h"
 #include "base/time/time.h"
+#include "mojo/edk/system/configuration.h"
 
 namespace mojo {
 namespace system {
 
+namespace {
+
+// While spinning, yield after this many checks of |Waiter::awoken_|.
+const base::subtle::Atomic32 kSpinIterationsPerYield = 32;
+
+// The number of iterations to spin for, adapted after each spin (zero until the
+// first spin). This is shared by all |Waiter|s; races between them updating it
+// are benign.
+base::subtle::Atomic32 g_spin_iterations = 0;
+
+// See |Waiter::GetSpinStats()|.
+base::subtle::Atomic32 g_num_spins = 0;
+base::subtle::Atomic32 g_num_successful_spins = 0;
+
+}  // namespace
+
 Waiter::Waiter()
     : cv_(&lock_),
 #ifndef NDEBUG
       initialized_(false),
 #endif
-      awoken_(false),
+      awoken_(0),
       awake_result_(MOJO_RESULT_INTERNAL),
       awake_context_(static_cast<uint32_t>(-1)) {
 }
@@ -29,7 +48,7 @@ void Waiter::Init() {
 #ifndef NDEBUG
   initialized_ = true;
 #endif
-  awoken_ = false;
+  base::subtle::NoBarrier_Store(&awoken_, 0);
   // NOTE(vtl): If performance ever becomes an issue, we can disable the setting
   // of |awake_result_| (except the first one in |Awake()|) in Release builds.
   awake_result_ = MOJO_RESULT_INTERNAL;
@@ -37,6 +56,9 @@ void Waiter::Init() {
 
 // TODO(vtl): Fast-path the |deadline == 0| case?
 MojoResult Waiter::Wait(MojoDeadline deadline, uint32_t* context) {
+  if (deadline != 0)
+    SpinIfEnabled(&deadline);
+
   base::AutoLock locker(lock_);
 
 #ifndef NDEBUG
@@ -46,7 +68,7 @@ MojoResult Waiter::Wait(MojoDeadline deadline, uint32_t* context) {
 #endif
 
   // Fast-path the already-awoken case:
-  if (awoken_) {
+  if (base::subtle::NoBarrier_Load(&awoken_)) {
     DCHECK_NE(awake_result_, MOJO_RESULT_INTERNAL);
     if (context)
       *context = static_cast<uint32_t>(awake_context_);
@@ -60,7 +82,7 @@ MojoResult Waiter::Wait(MojoDeadline deadline, uint32_t* context) {
   if (deadline > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
     do {
       cv_.Wait();
-    } while (!awoken_);
+    } while (!base::subtle::NoBarrier_Load(&awoken_));
   } else {
     // NOTE(vtl): This is very inefficient on POSIX, since pthreads condition
     // variables take an absolute deadline.
@@ -73,7 +95,7 @@ MojoResult Waiter::Wait(MojoDeadline deadline, uint32_t* context) {
         return MOJO_RESULT_DEADLINE_EXCEEDED;
 
       cv_.TimedWait(end_time - now_time);
-    } while (!awoken_);
+    } while (!base::subtle::NoBarrier_Load(&awoken_));
   }
 
   DCHECK_NE(awake_result_, MOJO_RESULT_INTERNAL);
@@ -85,16 +107,89 @@ MojoResult Waiter::Wait(MojoDeadline deadline, uint32_t* context) {
 bool Waiter::Awake(MojoResult result, uintptr_t context) {
   base::AutoLock locker(lock_);
 
-  if (awoken_)
+  if (base::subtle::NoBarrier_Load(&awoken_))
     return true;
 
-  awoken_ = true;
   awake_result_ = result;
   awake_context_ = context;
+  base::subtle::Release_Store(&awoken_, 1);
   cv_.Signal();
   // |cv_.Wait()|/|cv_.TimedWait()| will return after |lock_| is released.
   return true;
 }
 
+// static
+void Waiter::GetSpinStats(uint32_t* num_spins,
+                          uint32_t* num_successful_spins) {
+  *num_spins =
+      static_cast<uint32_t>(base::subtle::NoBarrier_Load(&g_num_spins));
+  *num_successful_spins = static_cast<uint32_t>(
+      base::subtle::NoBarrier_Load(&g_num_successful_spins));
+}
+
+void Waiter::SpinIfEnabled(MojoDeadline* deadline) {
+  const size_t max_waiter_spin_iterations =
+      GetConfiguration().max_waiter_spin_iterations;
+  if (!max_waiter_spin_iterations)
+    return;
+
+  // Don't count the already-awoken case as a (successful) spin.
+  if (base::subtle::Acquire_Load(&awoken_))
+    return;
+
+  const base::subtle::Atomic32 max_iterations =
+      static_cast<base::subtle::Atomic32>(
+          std::min(max_waiter_spin_iterations, static_cast<size_t>(1 << 30)));
+  const base::subtle::Atomic32 min_iterations =
+      std::max(max_iterations / 16, 1);
+  base::subtle::Atomic32 iterations =
+      base::subtle::NoBarrier_Load(&g_spin_iterations);
+  // It may not have been set yet (or the configuration may have changed).
+  if (iterations < min_iterations || iterations > max_iterations)
+    iterations = max_iterations;
+
+  // Don't spin past the deadline. (As in |Wait()|, treat out-of-range
+  // deadlines as "forever".)
+  const bool has_end_time =
+      *deadline <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+  base::TimeTicks start_time;
+  base::TimeTicks end_time;
+  if (has_end_time) {
+    start_time = base::TimeTicks::Now();
+    end_time = start_time + base::TimeDelta::FromMicroseconds(
+                                static_cast<int64_t>(*deadline));
+  }
+
+  base::subtle::NoBarrier_AtomicIncrement(&g_num_spins, 1);
+  bool awoken = false;
+  for (base::subtle::Atomic32 i = 1; i <= iterations; i++) {
+    if (base::subtle::Acquire_Load(&awoken_)) {
+      awoken = true;
+      break;
+    }
+    if (i % kSpinIterationsPerYield == 0) {
+      if (has_end_time && base::TimeTicks::Now() >= end_time)
+        break;
+      base::PlatformThread::YieldCurrentThread();
+    }
+  }
+
+  // Spin a bit longer next time if spinning paid off, and back off quickly if
+  // it didn't.
+  if (awoken) {
+    base::subtle::NoBarrier_AtomicIncrement(&g_num_successful_spins, 1);
+    iterations = std::min(max_iterations, iterations + iterations / 8 + 1);
+  } else {
+    iterations = std::max(min_iterations, iterations / 2);
+  }
+  base::subtle::NoBarrier_Store(&g_spin_iterations, iterations);
+
+  if (has_end_time) {
+    const int64_t elapsed =
+        (base::TimeTicks::Now() - start_time).InMicroseconds();
+    *deadline -= std::min(*deadline, static_cast<MojoDeadline>(elapsed));
+  }
+}
+
 }  // namespace system
 }  // namespace mojo
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 
+#include "base/atomicops.h"
 #include "base/macros.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
@@ -60,13 +61,25 @@ class MOJO_SYSTEM_IMPL_EXPORT Waiter : public Awakable {
   // woken up already).
   bool Awake(MojoResult result, uintptr_t context) override;
 
+  // Gets statistics about spinning (see
+  // |embedder::Configuration::max_waiter_spin_iterations|) across all
+  // |Waiter|s: the number of waits that spun before blocking, and how many of
+  // those were woken up while spinning (so never blocked). (These counts may
+  // wrap around.)
+  static void GetSpinStats(uint32_t* num_spins, uint32_t* num_successful_spins);
+
  private:
+  // Spins (without |lock_|) for a while, if enabled, until |awoken_| is set or
+  // |*deadline| passes. Reduces |*deadline| by the time spent spinning.
+  void SpinIfEnabled(MojoDeadline* deadline);
+
   base::ConditionVariable cv_;  // Associated to |lock_|.
   base::Lock lock_;             // Protects the following members.
 #ifndef NDEBUG
   bool initialized_;
 #endif
-  bool awoken_;
+  // Only set under |lock_|, but may be read without it (when spinning).
+  base::subtle::Atomic32 awoken_;
   MojoResult awake_result_;
   uintptr_t awake_context_;
 
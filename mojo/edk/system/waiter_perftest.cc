@@ -0,0 +1,254 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This tests the latency of round trips ("ping-pongs") over a message pipe,
+// between two threads in the same process and between two processes, with
+// waiters that block right away and with waiters that spin first (see
+// |embedder::Configuration::max_waiter_spin_iterations|). It reports the 50th
+// and 99th percentile round-trip times.
+
+#include "mojo/edk/system/waiter.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/perf_log.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/embedder/simple_platform_support.h"
+#include "mojo/edk/system/channel_endpoint.h"
+#include "mojo/edk/system/configuration.h"
+#include "mojo/edk/system/message_pipe.h"
+#include "mojo/edk/system/message_pipe_test_utils.h"
+#include "mojo/edk/test/multiprocess_test_helper.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace system {
+namespace {
+
+// Tells the child process what to set |max_waiter_spin_iterations| to.
+const char kMaxWaiterSpinIterationsSwitch[] = "max-waiter-spin-iterations";
+
+const size_t kNumWarmUpRoundTrips = 1000;
+const size_t kNumRoundTrips = 20000;
+
+const struct {
+  const char* name;
+  size_t max_waiter_spin_iterations;
+} kWaiterConfigs[] = {{"Blocking", 0}, {"Spinning", 10000}};
+
+void WriteValue(MessagePipe* mp, unsigned port, uint32_t value) {
+  CHECK_EQ(mp->WriteMessage(port, UserPointer<const void>(&value),
+                            static_cast<uint32_t>(sizeof(value)), nullptr,
+                            MOJO_WRITE_MESSAGE_FLAG_NONE),
+           MOJO_RESULT_OK);
+}
+
+// Waits for a message on |port| of |mp| and reads it into |*value|. Returns
+// false if the other end was closed.
+bool ReadValue(MessagePipe* mp, unsigned port, uint32_t* value) {
+  Waiter waiter;
+  waiter.Init();
+  MojoResult result = mp->AddAwakable(port, &waiter,
+                                      MOJO_HANDLE_SIGNAL_READABLE, 0, nullptr);
+  if (result == MOJO_RESULT_OK) {
+    result = waiter.Wait(MOJO_DEADLINE_INDEFINITE, nullptr);
+    mp->RemoveAwakable(port, &waiter, nullptr);
+  } else if (result == MOJO_RESULT_ALREADY_EXISTS) {
+    result = MOJO_RESULT_OK;
+  }
+  if (result != MOJO_RESULT_OK)
+    return false;
+
+  uint32_t num_bytes = static_cast<uint32_t>(sizeof(*value));
+  CHECK_EQ(mp->ReadMessage(port, UserPointer<void>(value),
+                           MakeUserPointer(&num_bytes), nullptr, nullptr,
+                           MOJO_READ_MESSAGE_FLAG_NONE),
+           MOJO_RESULT_OK);
+  CHECK_EQ(num_bytes, static_cast<uint32_t>(sizeof(*value)));
+  return true;
+}
+
+// Sends back each value received on |port| of |mp|, until the other end is
+// closed.
+void Echo(MessagePipe* mp, unsigned port) {
+  uint32_t value = 0;
+  while (ReadValue(mp, port, &value))
+    WriteValue(mp, port, value);
+}
+
+class EchoThread : public base::SimpleThread {
+ public:
+  EchoThread(scoped_refptr<MessagePipe> mp, unsigned port)
+      : base::SimpleThread("echo_thread"), mp_(mp), port_(port) {}
+  ~EchoThread() override { Join(); }
+
+ private:
+  void Run() override { Echo(mp_.get(), port_); }
+
+  const scoped_refptr<MessagePipe> mp_;
+  const unsigned port_;
+
+  DISALLOW_COPY_AND_ASSIGN(EchoThread);
+};
+
+// Does round trips on |port| of |mp| (whose other end should echo), and logs
+// the 50th and 99th percentile round-trip times, together with the fraction of
+// spins (if any) that ended in a wake-up.
+void MeasureRoundTrips(const std::string& test_name,
+                       MessagePipe* mp,
+                       unsigned port) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < kNumWarmUpRoundTrips; i++) {
+    WriteValue(mp, port, static_cast<uint32_t>(i));
+    CHECK(ReadValue(mp, port, &value));
+  }
+
+  uint32_t start_num_spins = 0;
+  uint32_t start_num_successful_spins = 0;
+  Waiter::GetSpinStats(&start_num_spins, &start_num_successful_spins);
+
+  std::vector<base::TimeDelta> round_trip_times(kNumRoundTrips);
+  for (size_t i = 0; i < kNumRoundTrips; i++) {
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    WriteValue(mp, port, static_cast<uint32_t>(i));
+    CHECK(ReadValue(mp, port, &value));
+    round_trip_times[i] = base::TimeTicks::Now() - start_time;
+    CHECK_EQ(value, static_cast<uint32_t>(i));
+  }
+
+  uint32_t num_spins = 0;
+  uint32_t num_successful_spins = 0;
+  Waiter::GetSpinStats(&num_spins, &num_successful_spins);
+  num_spins -= start_num_spins;
+  num_successful_spins -= start_num_successful_spins;
+
+  std::sort(round_trip_times.begin(), round_trip_times.end());
+  base::LogPerfResult(
+      (test_name + "_p50").c_str(),
+      round_trip_times[kNumRoundTrips / 2].InMillisecondsF() * 1000.0, "us");
+  base::LogPerfResult(
+      (test_name + "_p99").c_str(),
+      round_trip_times[kNumRoundTrips * 99 / 100].InMillisecondsF() * 1000.0,
+      "us");
+  if (num_spins) {
+    base::LogPerfResult((test_name + "_SuccessfulSpins").c_str(),
+                        100.0 * num_successful_spins / num_spins, "%");
+  }
+}
+
+TEST(WaiterPerfTest, InProcessPingPong) {
+  const size_t old_max_waiter_spin_iterations =
+      GetConfiguration().max_waiter_spin_iterations;
+  for (size_t i = 0; i < arraysize(kWaiterConfigs); i++) {
+    GetMutableConfiguration()->max_waiter_spin_iterations =
+        kWaiterConfigs[i].max_waiter_spin_iterations;
+
+    scoped_refptr<MessagePipe> mp(MessagePipe::CreateLocalLocal());
+    {
+      EchoThread echo_thread(mp, 1);
+      echo_thread.Start();
+      MeasureRoundTrips(
+          base::StringPrintf("Waiter_InProcessPingPong_%s",
+                             kWaiterConfigs[i].name),
+          mp.get(), 0);
+      mp->Close(0);
+    }
+    mp->Close(1);
+  }
+  GetMutableConfiguration()->max_waiter_spin_iterations =
+      old_max_waiter_spin_iterations;
+}
+
+// Echoes values on its end of the message pipe, with waiters configured as
+// specified on the command line.
+MOJO_MULTIPROCESS_TEST_CHILD_MAIN(WaiterPingPongClient) {
+  size_t max_waiter_spin_iterations = 0;
+  CHECK(base::StringToSizeT(
+      base::CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+          kMaxWaiterSpinIterationsSwitch),
+      &max_waiter_spin_iterations));
+  GetMutableConfiguration()->max_waiter_spin_iterations =
+      max_waiter_spin_iterations;
+
+  embedder::SimplePlatformSupport platform_support;
+  test::ChannelThread channel_thread(&platform_support);
+  embedder::ScopedPlatformHandle client_platform_handle =
+      mojo::test::MultiprocessTestHelper::client_platform_handle.Pass();
+  CHECK(client_platform_handle.is_valid());
+  scoped_refptr<ChannelEndpoint> ep;
+  scoped_refptr<MessagePipe> mp(MessagePipe::CreateLocalProxy(&ep));
+  channel_thread.Start(client_platform_handle.Pass(), ep);
+
+  Echo(mp.get(), 0);
+  mp->Close(0);
+  return 0;
+}
+
+class MultiprocessWaiterPerfTest
+    : public test::MultiprocessMessagePipeTestBase {
+ public:
+  MultiprocessWaiterPerfTest() {}
+  ~MultiprocessWaiterPerfTest() override {}
+
+ protected:
+  // Measures round trips with both processes configured as |kWaiterConfigs[i]|.
+  void Measure(size_t i) {
+    const size_t old_max_waiter_spin_iterations =
+        GetConfiguration().max_waiter_spin_iterations;
+    GetMutableConfiguration()->max_waiter_spin_iterations =
+        kWaiterConfigs[i].max_waiter_spin_iterations;
+    helper()->StartChildWithExtraSwitch(
+        "WaiterPingPongClient", kMaxWaiterSpinIterationsSwitch,
+        base::SizeTToString(kWaiterConfigs[i].max_waiter_spin_iterations));
+
+    scoped_refptr<ChannelEndpoint> ep;
+    scoped_refptr<MessagePipe> mp(MessagePipe::CreateLocalProxy(&ep));
+    Init(ep);
+    MeasureRoundTrips(base::StringPrintf("Waiter_CrossProcessPingPong_%s",
+                                         kWaiterConfigs[i].name),
+                      mp.get(), 0);
+    mp->Close(0);
+    EXPECT_EQ(0, helper()->WaitForChildShutdown());
+
+    GetMutableConfiguration()->max_waiter_spin_iterations =
+        old_max_waiter_spin_iterations;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MultiprocessWaiterPerfTest);
+};
+
+#if defined(OS_ANDROID)
+// Android multi-process tests are not executing the new process. This is flaky.
+#define MAYBE_CrossProcessPingPongBlocking DISABLED_CrossProcessPingPongBlocking
+#define MAYBE_CrossProcessPingPongSpinning DISABLED_CrossProcessPingPongSpinning
+#else
+#define MAYBE_CrossProcessPingPongBlocking CrossProcessPingPongBlocking
+#define MAYBE_CrossProcessPingPongSpinning CrossProcessPingPongSpinning
+#endif  // defined(OS_ANDROID)
+TEST_F(MultiprocessWaiterPerfTest, MAYBE_CrossProcessPingPongBlocking) {
+  Measure(0);
+}
+
+TEST_F(MultiprocessWaiterPerfTest, MAYBE_CrossProcessPingPongSpinning) {
+  Measure(1);
+}
+
+}  // namespace
+}  // namespace system
+}  // namespace mojo
@@ -16,6 +16,7 @@
 #include "base/threading/platform_thread.h"  // For |Sleep()|.
 #include "base/threading/simple_thread.h"
 #include "base/time/time.h"
+#include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/test_utils.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -297,6 +298,82 @@ TEST(WaiterTest, MultipleAwakes) {
   }
 }
 
+// With spinning enabled, waiters should behave the same, except that a waiter
+// that's awoken while spinning never blocks.
+TEST(WaiterTest, Spinning) {
+  const size_t old_max_waiter_spin_iterations =
+      GetConfiguration().max_waiter_spin_iterations;
+  // Spin for (much) longer than any of the waits below.
+  GetMutableConfiguration()->max_waiter_spin_iterations = 1 << 30;
+
+  test::Stopwatch stopwatch;
+  MojoResult result;
+  uint32_t context;
+  base::TimeDelta elapsed;
+  uint32_t num_spins = 0;
+  uint32_t num_successful_spins = 0;
+  uint32_t new_num_spins = 0;
+  uint32_t new_num_successful_spins = 0;
+
+  // Awake some time after thread start (while it's spinning).
+  Waiter::GetSpinStats(&num_spins, &num_successful_spins);
+  {
+    WaitingThread thread(10 * test::EpsilonTimeout().InMicroseconds());
+    thread.Start();
+    base::PlatformThread::Sleep(2 * test::EpsilonTimeout());
+    thread.waiter()->Awake(1, 1);
+    thread.WaitUntilDone(&result, &context, &elapsed);
+    EXPECT_EQ(1u, result);
+    EXPECT_EQ(1u, context);
+    EXPECT_GT(elapsed, (2 - 1) * test::EpsilonTimeout());
+    EXPECT_LT(elapsed, (2 + 1) * test::EpsilonTimeout());
+  }
+  Waiter::GetSpinStats(&new_num_spins, &new_num_successful_spins);
+  EXPECT_EQ(num_spins + 1, new_num_spins);
+  EXPECT_EQ(num_successful_spins + 1, new_num_successful_spins);
+
+  // Awake before thread start: no need to spin.
+  Waiter::GetSpinStats(&num_spins, &num_successful_spins);
+  {
+    WaitingThread thread(MOJO_DEADLINE_INDEFINITE);
+    thread.waiter()->Awake(MOJO_RESULT_CANCELLED, 2);
+    thread.Start();
+    thread.WaitUntilDone(&result, &context, &elapsed);
+    EXPECT_EQ(MOJO_RESULT_CANCELLED, result);
+    EXPECT_EQ(2u, context);
+    EXPECT_LT(elapsed, test::EpsilonTimeout());
+  }
+  Waiter::GetSpinStats(&new_num_spins, &new_num_successful_spins);
+  EXPECT_EQ(num_spins, new_num_spins);
+  EXPECT_EQ(num_successful_spins, new_num_successful_spins);
+
+  // Time out: spinning shouldn't go past the deadline.
+  Waiter waiter;
+  context = 123;
+  Waiter::GetSpinStats(&num_spins, &num_successful_spins);
+  waiter.Init();
+  stopwatch.Start();
+  EXPECT_EQ(MOJO_RESULT_DEADLINE_EXCEEDED,
+            waiter.Wait(2 * test::EpsilonTimeout().InMicroseconds(), &context));
+  elapsed = stopwatch.Elapsed();
+  EXPECT_GT(elapsed, (2 - 1) * test::EpsilonTimeout());
+  EXPECT_LT(elapsed, (2 + 1) * test::EpsilonTimeout());
+  EXPECT_EQ(123u, context);
+  Waiter::GetSpinStats(&new_num_spins, &new_num_successful_spins);
+  EXPECT_EQ(num_spins + 1, new_num_spins);
+  EXPECT_EQ(num_successful_spins, new_num_successful_spins);
+
+  // A zero deadline never spins.
+  Waiter::GetSpinStats(&num_spins, &num_successful_spins);
+  waiter.Init();
+  EXPECT_EQ(MOJO_RESULT_DEADLINE_EXCEEDED, waiter.Wait(0, &context));
+  Waiter::GetSpinStats(&new_num_spins, &new_num_successful_spins);
+  EXPECT_EQ(num_spins, new_num_spins);
+
+  GetMutableConfiguration()->max_waiter_spin_iterations =
+      old_max_waiter_spin_iterations;
+}
+
 }  // namespace
 }  // namespace system
 }  // namespace mojo
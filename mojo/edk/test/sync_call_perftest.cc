@@ -0,0 +1,240 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This tests the latency of request/response ("ping-pong") calls through the
+// C++ bindings, to a service on another thread and in another process. It
+// compares calls whose responses are received from the message loop (or using
+// |WaitForIncomingResponse()|) with calls to a method with the [Sync=1]
+// attribute, which wait for the response directly.
+//
+// (This lives here rather than with the other bindings perftests since it needs
+// the EDK to connect to the other process.)
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/test_io_thread.h"
+#include "build/build_config.h"
+#include "mojo/edk/embedder/embedder.h"
+#include "mojo/edk/embedder/scoped_platform_handle.h"
+#include "mojo/edk/test/multiprocess_test_helper.h"
+#include "mojo/edk/test/scoped_ipc_support.h"
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/interface_ptr.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/functions.h"
+#include "mojo/public/cpp/test_support/test_support.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "mojo/public/cpp/utility/thread.h"
+#include "mojo/public/interfaces/bindings/tests/test_sync_methods.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+const MojoTimeTicks kPerftestTimeMicroseconds = 1000 * 1000;
+
+class PingServiceImpl : public PingService {
+ public:
+  PingServiceImpl() {}
+  ~PingServiceImpl() override {}
+
+  // |PingService| implementation:
+  void Ping(int32_t value, const PingCallback& callback) override {
+    callback.Run(value);
+  }
+  void SyncPing(int32_t value, const SyncPingCallback& callback) override {
+    callback.Run(value);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PingServiceImpl);
+};
+
+// Serves a |PingService| on |request| until the other end is closed.
+void ServePingService(InterfaceRequest<PingService> request) {
+  RunLoop run_loop;
+  PingServiceImpl impl;
+  Binding<PingService> binding(&impl, request.Pass());
+  while (binding.WaitForIncomingMethodCall()) {
+  }
+}
+
+class PingServiceThread : public Thread {
+ public:
+  explicit PingServiceThread(InterfaceRequest<PingService> request)
+      : request_(request.Pass()) {}
+  ~PingServiceThread() override {}
+
+  void Run() override { ServePingService(request_.Pass()); }
+
+ private:
+  InterfaceRequest<PingService> request_;
+
+  DISALLOW_COPY_AND_ASSIGN(PingServiceThread);
+};
+
+// Creates a channel to another process (on the I/O thread given to
+// |InitIPCSupport()|), and destroys it on destruction.
+class ScopedChannel {
+ public:
+  explicit ScopedChannel(embedder::ScopedPlatformHandle platform_handle)
+      : event_(true, false),  // Manual reset.
+        channel_info_(nullptr) {
+    bootstrap_message_pipe_ = embedder::CreateChannel(
+        platform_handle.Pass(),
+        base::Bind(&ScopedChannel::DidCreateChannel, base::Unretained(this)),
+        nullptr);
+    CHECK(bootstrap_message_pipe_.is_valid());
+    event_.Wait();
+  }
+
+  ~ScopedChannel() {
+    event_.Reset();
+    embedder::DestroyChannel(
+        channel_info_,
+        base::Bind(&ScopedChannel::DidDestroyChannel, base::Unretained(this)),
+        nullptr);
+    event_.Wait();
+  }
+
+  ScopedMessagePipeHandle PassBootstrapMessagePipe() {
+    return bootstrap_message_pipe_.Pass();
+  }
+
+ private:
+  void DidCreateChannel(embedder::ChannelInfo* channel_info) {
+    CHECK(channel_info);
+    channel_info_ = channel_info;
+    event_.Signal();
+  }
+
+  void DidDestroyChannel() { event_.Signal(); }
+
+  ScopedMessagePipeHandle bootstrap_message_pipe_;
+  base::WaitableEvent event_;
+  embedder::ChannelInfo* channel_info_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedChannel);
+};
+
+MOJO_MULTIPROCESS_TEST_CHILD_MAIN(PingServiceChild) {
+  base::TestIOThread test_io_thread(base::TestIOThread::kAutoStart);
+  ScopedIPCSupport ipc_support(test_io_thread.task_runner());
+  ScopedChannel channel(MultiprocessTestHelper::client_platform_handle.Pass());
+
+  Environment env;
+  ServePingService(
+      MakeRequest<PingService>(channel.PassBootstrapMessagePipe()));
+  return 0;
+}
+
+class SyncCallPerftest : public testing::Test {
+ public:
+  SyncCallPerftest() {}
+  ~SyncCallPerftest() override {}
+
+ protected:
+  enum CallType {
+    // Calls |Ping()|, and runs the message loop until the response arrives.
+    CALL_TYPE_ASYNC,
+    // Calls |Ping()|, and waits using |WaitForIncomingResponse()|.
+    CALL_TYPE_ASYNC_WAIT,
+    // Calls |SyncPing()|.
+    CALL_TYPE_SYNC
+  };
+
+  void Call(PingServicePtr* ptr, CallType call_type, int32_t value) {
+    int32_t response = 0;
+    switch (call_type) {
+      case CALL_TYPE_ASYNC:
+        (*ptr)->Ping(value, [&response](int32_t v) {
+          response = v;
+          RunLoop::current()->Quit();
+        });
+        loop_.Run();
+        break;
+      case CALL_TYPE_ASYNC_WAIT:
+        (*ptr)->Ping(value, [&response](int32_t v) { response = v; });
+        CHECK(ptr->WaitForIncomingResponse());
+        break;
+      case CALL_TYPE_SYNC:
+        (*ptr)->SyncPing(value, [&response](int32_t v) { response = v; });
+        break;
+    }
+    CHECK_EQ(value, response);
+  }
+
+  void Measure(const char* test_name, PingServicePtr* ptr) {
+    static const struct {
+      CallType call_type;
+      const char* name;
+    } kCallTypes[] = {{CALL_TYPE_ASYNC, "Async"},
+                      {CALL_TYPE_ASYNC_WAIT, "AsyncWait"},
+                      {CALL_TYPE_SYNC, "Sync"}};
+
+    for (size_t i = 0; i < arraysize(kCallTypes); i++) {
+      // Warm up.
+      Call(ptr, kCallTypes[i].call_type, 1);
+
+      int32_t num_calls = 0;
+      MojoTimeTicks start_time = GetTimeTicksNow();
+      MojoTimeTicks end_time;
+      do {
+        Call(ptr, kCallTypes[i].call_type, ++num_calls);
+        end_time = GetTimeTicksNow();
+      } while (end_time - start_time < kPerftestTimeMicroseconds);
+
+      LogPerfResult(test_name, kCallTypes[i].name,
+                    static_cast<double>(end_time - start_time) / num_calls,
+                    "microseconds/call");
+    }
+  }
+
+ private:
+  Environment env_;
+  RunLoop loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyncCallPerftest);
+};
+
+TEST_F(SyncCallPerftest, SameProcess) {
+  PingServicePtr ptr;
+  PingServiceThread service_thread(GetProxy(&ptr));
+  service_thread.Start();
+
+  Measure("SyncCall_PingPong_SameProcess", &ptr);
+
+  ptr.reset();
+  service_thread.Join();
+}
+
+#if defined(OS_ANDROID)
+// Android multi-process tests are not executing the new process. This is flaky.
+#define MAYBE_CrossProcess DISABLED_CrossProcess
+#else
+#define MAYBE_CrossProcess CrossProcess
+#endif  // defined(OS_ANDROID)
+TEST_F(SyncCallPerftest, MAYBE_CrossProcess) {
+  base::TestIOThread test_io_thread(base::TestIOThread::kAutoStart);
+  ScopedIPCSupport ipc_support(test_io_thread.task_runner());
+
+  MultiprocessTestHelper multiprocess_test_helper;
+  multiprocess_test_helper.StartChild("PingServiceChild");
+  {
+    ScopedChannel channel(
+        multiprocess_test_helper.server_platform_handle.Pass());
+    PingServicePtr ptr = MakeProxy(InterfacePtrInfo<PingService>(
+        channel.PassBootstrapMessagePipe(), 0u));
+
+    Measure("SyncCall_PingPong_CrossProcess", &ptr);
+  }
+  EXPECT_EQ(0, multiprocess_test_helper.WaitForChildShutdown());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
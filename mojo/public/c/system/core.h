@@ -17,5 +17,6 @@
 #include "mojo/public/c/system/message_pipe.h"
 #include "mojo/public/c/system/system_export.h"
 #include "mojo/public/c/system/types.h"
+#include "mojo/public/c/system/wait_set.h"
 
 #endif  // MOJO_PUBLIC_C_SYSTEM_CORE_H_
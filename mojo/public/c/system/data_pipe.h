@@ -28,6 +28,12 @@
 //       always be able to queue AT LEAST this much data. Set to zero to opt for
 //       a system-dependent automatically-calculated capacity (which will always
 //       be at least one element).
+//   |uint32_t read_threshold_num_bytes|: The initial read threshold of the
+//       consumer, in number of bytes (see |MojoDataPipeConsumerOptions|). Set
+//       to zero for the default (one element).
+//   |uint32_t write_threshold_num_bytes|: The initial write threshold of the
+//       producer, in number of bytes (see |MojoDataPipeProducerOptions|). Set
+//       to zero for the default (one element).
 
 typedef uint32_t MojoCreateDataPipeOptionsFlags;
 
@@ -45,10 +51,52 @@ struct MOJO_ALIGNAS(8) MojoCreateDataPipeOptions {
   MojoCreateDataPipeOptionsFlags flags;
   uint32_t element_num_bytes;
   uint32_t capacity_num_bytes;
+  uint32_t read_threshold_num_bytes;
+  uint32_t write_threshold_num_bytes;
 };
-MOJO_STATIC_ASSERT(sizeof(MojoCreateDataPipeOptions) == 16,
+MOJO_STATIC_ASSERT(sizeof(MojoCreateDataPipeOptions) == 24,
                    "MojoCreateDataPipeOptions has wrong size");
 
+// |MojoDataPipeProducerOptions|: Used to get and set options for a data pipe
+// producer (see |MojoGetDataPipeProducerOptions()| and
+// |MojoSetDataPipeProducerOptions()|).
+//   |uint32_t struct_size|: Set to the size of the
+//       |MojoDataPipeProducerOptions| struct. (Used to allow for future
+//       extensions.)
+//   |uint32_t write_threshold_num_bytes|: The minimum amount of space, in
+//       number of bytes, that must be available for writing for the producer to
+//       be signaled with |MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD|; must be a
+//       multiple of the data pipe's element size and at most its capacity. Set
+//       to zero for the default (one element, i.e., the same as
+//       |MOJO_HANDLE_SIGNAL_WRITABLE|).
+
+struct MOJO_ALIGNAS(8) MojoDataPipeProducerOptions {
+  uint32_t struct_size;
+  uint32_t write_threshold_num_bytes;
+};
+MOJO_STATIC_ASSERT(sizeof(MojoDataPipeProducerOptions) == 8,
+                   "MojoDataPipeProducerOptions has wrong size");
+
+// |MojoDataPipeConsumerOptions|: Used to get and set options for a data pipe
+// consumer (see |MojoGetDataPipeConsumerOptions()| and
+// |MojoSetDataPipeConsumerOptions()|).
+//   |uint32_t struct_size|: Set to the size of the
+//       |MojoDataPipeConsumerOptions| struct. (Used to allow for future
+//       extensions.)
+//   |uint32_t read_threshold_num_bytes|: The minimum amount of data, in number
+//       of bytes, that must be available for reading for the consumer to be
+//       signaled with |MOJO_HANDLE_SIGNAL_READ_THRESHOLD|; must be a multiple
+//       of the data pipe's element size and at most its capacity. Set to zero
+//       for the default (one element, i.e., the same as
+//       |MOJO_HANDLE_SIGNAL_READABLE|).
+
+struct MOJO_ALIGNAS(8) MojoDataPipeConsumerOptions {
+  uint32_t struct_size;
+  uint32_t read_threshold_num_bytes;
+};
+MOJO_STATIC_ASSERT(sizeof(MojoDataPipeConsumerOptions) == 8,
+                   "MojoDataPipeConsumerOptions has wrong size");
+
 // |MojoWriteDataFlags|: Used to specify different modes to |MojoWriteData()|
 // and |MojoBeginWriteData()|.
 //   |MOJO_WRITE_DATA_FLAG_NONE| - No flags; default mode.
@@ -130,6 +178,37 @@ MOJO_SYSTEM_EXPORT MojoResult MojoCreateDataPipe(
     MojoHandle* data_pipe_producer_handle,            // Out.
     MojoHandle* data_pipe_consumer_handle);           // Out.
 
+// Sets options for the data pipe producer given by |data_pipe_producer_handle|
+// (see |MojoDataPipeProducerOptions|). |options| may be null to restore the
+// default options. The options stay with the producer if it is sent to
+// another process.
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success.
+//   |MOJO_RESULT_INVALID_ARGUMENT| if some argument was invalid (e.g.,
+//       |data_pipe_producer_handle| is not a handle to a data pipe producer or
+//       |*options| is invalid).
+MOJO_SYSTEM_EXPORT MojoResult MojoSetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    const struct MojoDataPipeProducerOptions* options);  // Optional.
+
+// Gets the options for the data pipe producer given by
+// |data_pipe_producer_handle|. |options| should point to a buffer of
+// |options_num_bytes| bytes, which must be at least the size of the first
+// version of |MojoDataPipeProducerOptions| (8 bytes). On success, as much of
+// the current version of |MojoDataPipeProducerOptions| as fits is written to
+// |*options|, with |options->struct_size| set to the number of bytes written.
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success.
+//   |MOJO_RESULT_INVALID_ARGUMENT| if some argument was invalid (e.g.,
+//       |data_pipe_producer_handle| is not a handle to a data pipe producer or
+//       |options_num_bytes| is too small).
+MOJO_SYSTEM_EXPORT MojoResult
+    MojoGetDataPipeProducerOptions(MojoHandle data_pipe_producer_handle,
+                                   struct MojoDataPipeProducerOptions* options,
+                                   uint32_t options_num_bytes);
+
 // Writes the given data to the data pipe producer given by
 // |data_pipe_producer_handle|. |elements| points to data of size |*num_bytes|;
 // |*num_bytes| should be a multiple of the data pipe's element size. If
@@ -244,6 +323,34 @@ MOJO_SYSTEM_EXPORT MojoResult
     MojoEndWriteData(MojoHandle data_pipe_producer_handle,
                      uint32_t num_bytes_written);
 
+// Sets options for the data pipe consumer given by |data_pipe_consumer_handle|
+// (see |MojoDataPipeConsumerOptions|). |options| may be null to restore the
+// default options. The options stay with the consumer if it is sent to
+// another process.
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success.
+//   |MOJO_RESULT_INVALID_ARGUMENT| if some argument was invalid (e.g.,
+//       |data_pipe_consumer_handle| is not a handle to a data pipe consumer or
+//       |*options| is invalid).
+MOJO_SYSTEM_EXPORT MojoResult MojoSetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    const struct MojoDataPipeConsumerOptions* options);  // Optional.
+
+// Gets the options for the data pipe consumer given by
+// |data_pipe_consumer_handle|. This is like |MojoGetDataPipeProducerOptions()|,
+// but for |MojoDataPipeConsumerOptions|.
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success.
+//   |MOJO_RESULT_INVALID_ARGUMENT| if some argument was invalid (e.g.,
+//       |data_pipe_consumer_handle| is not a handle to a data pipe consumer or
+//       |options_num_bytes| is too small).
+MOJO_SYSTEM_EXPORT MojoResult
+    MojoGetDataPipeConsumerOptions(MojoHandle data_pipe_consumer_handle,
+                                   struct MojoDataPipeConsumerOptions* options,
+                                   uint32_t options_num_bytes);
+
 // Reads data from the data pipe consumer given by |data_pipe_consumer_handle|.
 // May also be used to discard data or query the amount of data available.
 //
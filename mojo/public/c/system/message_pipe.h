@@ -68,6 +68,33 @@ const MojoReadMessageFlags MOJO_READ_MESSAGE_FLAG_MAY_DISCARD = 1 << 0;
 #define MOJO_READ_MESSAGE_FLAG_MAY_DISCARD ((MojoReadMessageFlags)1 << 0)
 #endif
 
+// |MojoMessageContextThunks|: Functions used by the system to deal with the
+// (opaque) context of a message written using |MojoWriteMessageContext()|.
+// These are called on arbitrary threads, from within Mojo functions called on
+// either end of the message pipe (e.g., |MojoWriteMessageContext()|,
+// |MojoReadMessage()|, |MojoClose()|, or a |MojoWriteMessage()| that transfers
+// the handle), so they must not call any Mojo functions. (They are never called
+// with the message pipe's own internal lock held, so they may take a while.)
+//   |uint32_t struct_size|: Set to the size of the |MojoMessageContextThunks|
+//       struct. (Used to allow for future extensions.)
+//   |uint32_t (*GetSerializedSize)(uintptr_t context)|: Returns the number of
+//       bytes in the serialized message. This is called (once) for every
+//       message written, so it should be cheap, i.e., not actually serialize
+//       the message.
+//   |void (*Serialize)(uintptr_t context, void* bytes, uint32_t num_bytes)|:
+//       Serializes the message to |bytes|, which has the number of bytes
+//       returned by |GetSerializedSize()|.
+//   |void (*Destroy)(uintptr_t context)|: Destroys the context. This is called
+//       exactly once for each context that the system takes ownership of (after
+//       it's been serialized, if it is).
+
+struct MojoMessageContextThunks {
+  uint32_t struct_size;
+  uint32_t (*GetSerializedSize)(uintptr_t context);
+  void (*Serialize)(uintptr_t context, void* bytes, uint32_t num_bytes);
+  void (*Destroy)(uintptr_t context);
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -131,6 +158,78 @@ MOJO_SYSTEM_EXPORT MojoResult
                      uint32_t num_handles,
                      MojoWriteMessageFlags flags);
 
+// Writes |num_messages| messages to the message pipe endpoint given by
+// |message_pipe_handle|, in order. This is equivalent to calling
+// |MojoWriteMessage()| for each message, but is cheaper when there are many
+// (e.g., they may be sent to another process together). Either all of the
+// messages are written or none are.
+//
+// |bytes| and |handles| hold the data and attached handles for all the
+// messages, one message's after another; |num_bytes| and |num_handles| are
+// their total sizes. The number of bytes and handles in the i-th message is
+// given by |message_num_bytes[i]| and |message_num_handles[i]|, which must add
+// up to the totals. If no handles are attached, |handles| and
+// |message_num_handles| may be null (and |num_handles| must be zero).
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success (i.e., all the messages were enqueued).
+//   |MOJO_RESULT_INVALID_ARGUMENT| if some argument was invalid (e.g., if
+//       |message_pipe_handle| is not a valid handle, |num_messages| is zero,
+//       or the per-message sizes don't add up).
+//   |MOJO_RESULT_RESOURCE_EXHAUSTED| if some system limit has been reached
+//       (e.g., if |num_messages| is too large), or some message is too large
+//       or has too many handles attached.
+//   |MOJO_RESULT_FAILED_PRECONDITION| if the other endpoint has been closed.
+//   |MOJO_RESULT_BUSY| if some handle to be sent is currently in use.
+MOJO_SYSTEM_EXPORT MojoResult
+    MojoWriteMessages(MojoHandle message_pipe_handle,
+                      const void* bytes,  // Optional.
+                      uint32_t num_bytes,
+                      const MojoHandle* handles,  // Optional.
+                      uint32_t num_handles,
+                      const uint32_t* message_num_bytes,
+                      const uint32_t* message_num_handles,  // Optional.
+                      uint32_t num_messages,
+                      MojoWriteMessageFlags flags);
+
+// Writes a message to the message pipe endpoint given by
+// |message_pipe_handle| without serializing it. The message is given by an
+// opaque |context|, which can be serialized (and must eventually be destroyed)
+// using |thunks|. No handles can be attached to such a message. |*thunks|, and
+// the functions it points to, must remain valid (e.g., be globals) for as long
+// as any such messages may exist, i.e., until they're read or until the message
+// pipe endpoint they were written to is closed. In particular, an application
+// that's a library loaded into another process (e.g., by the shell's
+// in-process runner) must not be unloaded while such messages may exist.
+//
+// If the other endpoint is in this process and is being read using
+// |MojoReadMessageContext()| with the same |thunks|, the message is
+// transferred unserialized and its context is given to the reader. Otherwise
+// the message is serialized: right away, if the other endpoint is in another
+// process or is being read in some other way; or later, if it's read using
+// |MojoReadMessage()| or the other endpoint is transferred (in which case the
+// context may be serialized on another thread).
+//
+// On success, the system takes ownership of |context|; otherwise, it remains
+// owned by the caller.
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success (i.e., the message was enqueued).
+//   |MOJO_RESULT_INVALID_ARGUMENT| if some argument was invalid (e.g., if
+//       |message_pipe_handle| is not a valid handle, or |*thunks| is invalid).
+//   |MOJO_RESULT_RESOURCE_EXHAUSTED| if the serialized message (as given by
+//       |thunks->GetSerializedSize()|) is too large, even if it wouldn't be
+//       serialized.
+//   |MOJO_RESULT_FAILED_PRECONDITION| if the other endpoint has been closed.
+//
+// This is not supported under NaCl (where it always fails with
+// |MOJO_RESULT_INVALID_ARGUMENT|).
+MOJO_SYSTEM_EXPORT MojoResult
+    MojoWriteMessageContext(MojoHandle message_pipe_handle,
+                            uintptr_t context,
+                            const struct MojoMessageContextThunks* thunks,
+                            MojoWriteMessageFlags flags);
+
 // Reads the next message from a message pipe, or indicates the size of the
 // message if it cannot fit in the provided buffers. The message will be read
 // in its entirety or not at all; if it is not, it will remain enqueued unless
@@ -170,6 +269,72 @@ MOJO_SYSTEM_EXPORT MojoResult
                     uint32_t* num_handles,  // Optional in/out.
                     MojoReadMessageFlags flags);
 
+// Reads the next messages from a message pipe, as many as will fit in the
+// provided buffers (but at most |*num_messages| of them). This is equivalent
+// to calling |MojoReadMessage()| repeatedly (stopping at the first message that
+// doesn't fit), but is cheaper when many messages are queued.
+//
+// |*num_messages| must be set to the maximum number of messages to read, which
+// must be nonzero. |message_num_bytes| and |message_num_handles| must point to
+// arrays of at least |*num_messages| elements (though |message_num_handles|
+// may be null, in which case the number of handles in each message isn't
+// reported). |num_bytes|, |num_handles|, |bytes| and |handles| are as for
+// |MojoReadMessage()|, except that the messages' data and handles are stored
+// one after another in |bytes| and |handles|.
+//
+// On success, |*num_messages| is set to the number of messages read, and
+// |*num_bytes| and |*num_handles| to the total number of bytes and handles
+// read. The number of bytes and handles in the i-th message (which follow those
+// of the previous messages) is stored in |message_num_bytes[i]| and
+// |message_num_handles[i]|.
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success (i.e., at least one message was read).
+//   |MOJO_RESULT_INVALID_ARGUMENT| if some argument was invalid (e.g.,
+//       |*num_messages| was zero).
+//   |MOJO_RESULT_FAILED_PRECONDITION| if the other endpoint has been closed
+//       (and there are no messages left to read).
+//   |MOJO_RESULT_RESOURCE_EXHAUSTED| if the first message was too large to fit
+//       in the provided buffer(s). As for |MojoReadMessage()|, |*num_bytes| and
+//       |*num_handles| are set to its size, and it will have been left in the
+//       queue or discarded, depending on flags. |*num_messages| is set to zero.
+//   |MOJO_RESULT_SHOULD_WAIT| if no message was available to be read.
+MOJO_SYSTEM_EXPORT MojoResult
+    MojoReadMessages(MojoHandle message_pipe_handle,
+                     void* bytes,                    // Optional out.
+                     uint32_t* num_bytes,            // Optional in/out.
+                     MojoHandle* handles,            // Optional out.
+                     uint32_t* num_handles,          // Optional in/out.
+                     uint32_t* message_num_bytes,    // Out.
+                     uint32_t* message_num_handles,  // Optional out.
+                     uint32_t* num_messages,         // In/out.
+                     MojoReadMessageFlags flags);
+
+// Like |MojoReadMessage()|, but if the next message was written using
+// |MojoWriteMessageContext()| with the same |thunks|, reads it without
+// serializing it: its context is stored in |*context| (and the caller takes
+// ownership of it), and |*num_bytes| and |*num_handles| are set to zero.
+// Otherwise, |*context| is set to zero and this behaves exactly like
+// |MojoReadMessage()|. (Reading from a message pipe endpoint using this
+// function is what allows messages to be written to it unserialized.)
+//
+// Returns:
+//   As for |MojoReadMessage()|, and:
+//   |MOJO_RESULT_INVALID_ARGUMENT| also if |*thunks| is invalid or |context|
+//       is null.
+//
+// This is not supported under NaCl (where it always fails with
+// |MOJO_RESULT_INVALID_ARGUMENT|).
+MOJO_SYSTEM_EXPORT MojoResult
+    MojoReadMessageContext(MojoHandle message_pipe_handle,
+                           const struct MojoMessageContextThunks* thunks,
+                           uintptr_t* context,     // Out.
+                           void* bytes,            // Optional out.
+                           uint32_t* num_bytes,    // Optional in/out.
+                           MojoHandle* handles,    // Optional out.
+                           uint32_t* num_handles,  // Optional in/out.
+                           MojoReadMessageFlags flags);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -149,6 +149,12 @@ const MojoDeadline MOJO_DEADLINE_INDEFINITE = static_cast<MojoDeadline>(-1);
 //   |MOJO_HANDLE_SIGNAL_READABLE| - Can read (e.g., a message) from the handle.
 //   |MOJO_HANDLE_SIGNAL_WRITABLE| - Can write (e.g., a message) to the handle.
 //   |MOJO_HANDLE_SIGNAL_PEER_CLOSED| - The peer handle is closed.
+//   |MOJO_HANDLE_SIGNAL_READ_THRESHOLD| - Can read a certain amount of data
+//       from the handle (e.g., a data pipe consumer; see
+//       |MojoDataPipeConsumerOptions|).
+//   |MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD| - Can write a certain amount of data
+//       to the handle (e.g., a data pipe producer; see
+//       |MojoDataPipeProducerOptions|).
 
 typedef uint32_t MojoHandleSignals;
 
@@ -157,11 +163,15 @@ const MojoHandleSignals MOJO_HANDLE_SIGNAL_NONE = 0;
 const MojoHandleSignals MOJO_HANDLE_SIGNAL_READABLE = 1 << 0;
 const MojoHandleSignals MOJO_HANDLE_SIGNAL_WRITABLE = 1 << 1;
 const MojoHandleSignals MOJO_HANDLE_SIGNAL_PEER_CLOSED = 1 << 2;
+const MojoHandleSignals MOJO_HANDLE_SIGNAL_READ_THRESHOLD = 1 << 3;
+const MojoHandleSignals MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD = 1 << 4;
 #else
 #define MOJO_HANDLE_SIGNAL_NONE ((MojoHandleSignals)0)
 #define MOJO_HANDLE_SIGNAL_READABLE ((MojoHandleSignals)1 << 0)
 #define MOJO_HANDLE_SIGNAL_WRITABLE ((MojoHandleSignals)1 << 1)
 #define MOJO_HANDLE_SIGNAL_PEER_CLOSED ((MojoHandleSignals)1 << 2)
+#define MOJO_HANDLE_SIGNAL_READ_THRESHOLD ((MojoHandleSignals)1 << 3)
+#define MOJO_HANDLE_SIGNAL_WRITE_THRESHOLD ((MojoHandleSignals)1 << 4)
 #endif
 
 // |MojoHandleSignalsState|: Returned by wait functions to indicate the
@@ -0,0 +1,105 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file contains types/functions for wait sets, which allow waiting on a
+// (possibly large) set of handles that changes incrementally.
+//
+// Note: This header should be compilable as C.
+
+#ifndef MOJO_PUBLIC_C_SYSTEM_WAIT_SET_H_
+#define MOJO_PUBLIC_C_SYSTEM_WAIT_SET_H_
+
+#include "mojo/public/c/system/system_export.h"
+#include "mojo/public/c/system/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Note: See the comment in functions.h about the meaning of the "optional"
+// label for pointer parameters.
+
+// Creates a wait set. A wait set is a handle that holds a set of (handle,
+// signals) pairs; unlike |MojoWaitMany()|, the set is registered with the
+// system once and then updated with |MojoAddHandle()| and |MojoRemoveHandle()|,
+// so the cost of finding out which handles are ready is proportional to the
+// number of ready handles rather than to the size of the set.
+//
+// A wait set satisfies |MOJO_HANDLE_SIGNAL_READABLE| when (it believes that)
+// some handle in it is ready, so it may be waited on using |MojoWait()| (or
+// |MojoWaitMany()|, together with other handles), after which
+// |MojoGetReadyHandles()| retrieves the ready handles. Note that this signal
+// may occasionally be satisfied spuriously, in which case
+// |MojoGetReadyHandles()| will return |MOJO_RESULT_SHOULD_WAIT|.
+//
+// Wait sets may not be sent over message pipes.
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success.
+//   |MOJO_RESULT_RESOURCE_EXHAUSTED| if a process/system/quota/etc. limit has
+//       been reached.
+MOJO_SYSTEM_EXPORT MojoResult
+MojoCreateWaitSet(MojoHandle* wait_set_handle);  // Out.
+
+// Adds |handle| to the wait set |wait_set_handle|, to be reported as ready
+// when some signal in |signals| is satisfied or when it becomes known that no
+// signal in |signals| will ever be satisfied. |handle| stays in the wait set
+// until it is removed using |MojoRemoveHandle()| or until it is closed (in
+// which case it is reported as ready once, with result |MOJO_RESULT_CANCELLED|,
+// and then implicitly removed).
+//
+// Returns:
+//   |MOJO_RESULT_OK| if |handle| was added.
+//   |MOJO_RESULT_INVALID_ARGUMENT| if |wait_set_handle| is not a valid wait
+//       set, or if |handle| is not a valid handle (or is itself a wait set).
+//   |MOJO_RESULT_ALREADY_EXISTS| if |handle| is already in the wait set.
+MOJO_SYSTEM_EXPORT MojoResult MojoAddHandle(MojoHandle wait_set_handle,
+                                            MojoHandle handle,
+                                            MojoHandleSignals signals);
+
+// Removes |handle| from the wait set |wait_set_handle|.
+//
+// Returns:
+//   |MOJO_RESULT_OK| if |handle| was removed.
+//   |MOJO_RESULT_INVALID_ARGUMENT| if |wait_set_handle| is not a valid wait
+//       set.
+//   |MOJO_RESULT_NOT_FOUND| if |handle| is not in the wait set.
+MOJO_SYSTEM_EXPORT MojoResult MojoRemoveHandle(MojoHandle wait_set_handle,
+                                               MojoHandle handle);
+
+// Retrieves (without blocking) some of the ready handles in the wait set
+// |wait_set_handle|. |count| is in/out: on input, |*count| must be the
+// (nonzero) capacity of the |handles|, |results| and |signals_states| arrays
+// (which are out parameters); on success, it is set to the number of handles
+// returned. For each returned handle |handles[i]|,
+// |results[i]| is:
+//   |MOJO_RESULT_OK| if some signal it was added with is satisfied;
+//   |MOJO_RESULT_FAILED_PRECONDITION| if none of them can ever be satisfied; or
+//   |MOJO_RESULT_CANCELLED| if it was closed (in which case it has been removed
+//       from the wait set).
+//
+// Handles remain ready (and will be returned again) for as long as the above
+// holds; if there are more ready handles than |*count|, successive calls
+// cycle through them.
+//
+// |signals_states| (optional): If non-null, |signals_states[i]| is set to the
+//     signals state of |handles[i]|. See |MojoHandleSignalsState|.
+//
+// Returns:
+//   |MOJO_RESULT_OK| if at least one handle was returned.
+//   |MOJO_RESULT_INVALID_ARGUMENT| if |wait_set_handle| is not a valid wait
+//       set or |*count| is zero.
+//   |MOJO_RESULT_SHOULD_WAIT| if no handle is ready.
+MOJO_SYSTEM_EXPORT MojoResult
+MojoGetReadyHandles(MojoHandle wait_set_handle,
+                    uint32_t* count,
+                    MojoHandle* handles,
+                    MojoResult* results,
+                    struct MojoHandleSignalsState* signals_states);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // MOJO_PUBLIC_C_SYSTEM_WAIT_SET_H_
@@ -171,7 +171,10 @@ class Binding {
   // Unbinds the underlying pipe from this binding and returns it so it can be
   // used in another context, such as on another thread or with a different
   // implementation. Put this object into a state where it can be rebound to a
-  // new pipe.
+  // new pipe. This must not be called while messages that arrived during a
+  // synchronous call are waiting to be dispatched (i.e., from when such a call
+  // returns until control returns to the message loop); see
+  // |internal::Connector::PassMessagePipe()|.
   InterfaceRequest<Interface> Unbind() {
     InterfaceRequest<Interface> request =
         MakeRequest<Interface>(internal_router_->PassMessagePipe());
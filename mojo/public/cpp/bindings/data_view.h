@@ -0,0 +1,106 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_DATA_VIEW_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_DATA_VIEW_H_
+
+#include <stddef.h>
+
+#include <type_traits>
+
+#include "mojo/public/cpp/bindings/lib/array_internal.h"
+#include "mojo/public/cpp/bindings/string.h"
+
+// Data views give read-only access to (validated) serialized data in place,
+// without first deserializing it into wrapper objects (|mojo::String|,
+// |mojo::Array|, |FooPtr|, etc.). The bindings generator emits a |FooDataView|
+// for each struct and union |Foo|; arrays and strings are viewed using
+// |mojo::ArrayDataView<T>| and |mojo::StringDataView|.
+//
+// A view is just a pointer into the serialized data, so it is cheap to copy,
+// but it must not outlive the message that it points into.
+
+namespace mojo {
+
+// A view of a serialized string. The characters are *not* NUL-terminated.
+class StringDataView {
+ public:
+  typedef internal::String_Data Data_;
+
+  StringDataView() : data_(nullptr) {}
+  explicit StringDataView(Data_* data) : data_(data) {}
+
+  bool is_null() const { return !data_; }
+  size_t size() const { return data_ ? data_->size() : 0; }
+  const char* data() const { return data_ ? data_->storage() : nullptr; }
+
+  // Copies the string.
+  String ToString() const {
+    return data_ ? String(data_->storage(), data_->size()) : String();
+  }
+
+  // For use by the generated bindings.
+  Data_* internal_data() const { return data_; }
+
+ private:
+  Data_* data_;
+};
+
+namespace internal {
+
+// Maps the view type |T| of an array element to the type stored in the
+// corresponding |Array_Data|.
+template <typename T,
+          bool is_class = std::is_class<T>::value,
+          bool is_enum = std::is_enum<T>::value>
+struct ArrayDataViewTraits {
+  typedef T DataType;
+  static T ToView(DataType data) { return data; }
+};
+
+template <typename T>
+struct ArrayDataViewTraits<T, false, true> {
+  typedef int32_t DataType;
+  static T ToView(DataType data) { return static_cast<T>(data); }
+};
+
+template <typename T>
+struct ArrayDataViewTraits<T, true, false> {
+  typedef typename T::Data_* DataType;
+  static T ToView(DataType data) { return T(data); }
+};
+
+}  // namespace internal
+
+// A view of a serialized array. |T| is the view type of the elements: e.g., a
+// mojom |array<array<string>>| is viewed as an
+// |ArrayDataView<ArrayDataView<StringDataView>>|.
+template <typename T>
+class ArrayDataView {
+ public:
+  typedef internal::ArrayDataViewTraits<T> Traits;
+  typedef internal::Array_Data<typename Traits::DataType> Data_;
+
+  ArrayDataView() : data_(nullptr) {}
+  explicit ArrayDataView(Data_* data) : data_(data) {}
+
+  bool is_null() const { return !data_; }
+  size_t size() const { return data_ ? data_->size() : 0; }
+
+  T operator[](size_t offset) const {
+    MOJO_DCHECK(data_);
+    return Traits::ToView(
+        static_cast<const Data_*>(data_)->at(offset));
+  }
+
+  // For use by the generated bindings.
+  Data_* internal_data() const { return data_; }
+
+ private:
+  Data_* data_;
+};
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_DATA_VIEW_H_
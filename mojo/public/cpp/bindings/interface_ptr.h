@@ -149,7 +149,11 @@ class InterfacePtr {
 
   // Unbinds the InterfacePtr and returns the information which could be used
   // to setup an InterfacePtr again. This method may be used to move the proxy
-  // to a different thread (see class comments for details).
+  // to a different thread (see class comments for details). This must not be
+  // called while messages that arrived during a synchronous call are waiting
+  // to be dispatched (i.e., from when such a call returns until control
+  // returns to the message loop, or until they've been dispatched using
+  // |WaitForIncomingResponse()|); see |internal::Connector::PassMessagePipe()|.
   InterfacePtrInfo<Interface> PassInterface() {
     State state;
     internal_state_.Swap(&state);
@@ -191,6 +195,32 @@ InterfacePtr<Interface> MakeProxy(
   return ptr.Pass();
 }
 
+// Batches the method calls made through an InterfacePtr while it's alive:
+// instead of being written to the message pipe one by one, their messages are
+// written together when the batch ends (or earlier, e.g., if the InterfacePtr
+// has to wait for a response). This is much cheaper when making many calls in a
+// row. Batches may be nested. The InterfacePtr must outlive the batch, and must
+// not be reset or unbound during it.
+//
+//   {
+//     ScopedInterfacePtrBatch<Foo> batch(&foo);
+//     for (size_t i = 0; i < n; i++)
+//       foo->Bar(i);
+//   }  // All the calls to |Bar()| are sent here.
+template <typename Interface>
+class ScopedInterfacePtrBatch {
+ public:
+  explicit ScopedInterfacePtrBatch(InterfacePtr<Interface>* ptr) : ptr_(ptr) {
+    ptr_->internal_state()->Cork();
+  }
+  ~ScopedInterfacePtrBatch() { ptr_->internal_state()->Uncork(); }
+
+ private:
+  InterfacePtr<Interface>* const ptr_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(ScopedInterfacePtrBatch);
+};
+
 }  // namespace mojo
 
 #endif  // MOJO_PUBLIC_CPP_BINDINGS_INTERFACE_PTR_H_
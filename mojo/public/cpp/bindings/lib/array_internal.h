@@ -17,6 +17,7 @@
 #include "mojo/public/cpp/bindings/lib/template_util.h"
 #include "mojo/public/cpp/bindings/lib/validate_params.h"
 #include "mojo/public/cpp/bindings/lib/validation_errors.h"
+#include "mojo/public/cpp/bindings/lib/validation_util.h"
 #include "mojo/public/cpp/environment/logging.h"
 
 namespace mojo {
@@ -193,6 +194,11 @@ struct ArraySerializationHelper<Handle, true> {
     MOJO_DCHECK(!validate_params->element_validate_params)
         << "Handle type should not have array validate params";
 
+    // Usually, all the handles are valid and can be claimed at once. If not,
+    // claim them one by one to find the error.
+    if (bounds_checker->ClaimHandles(elements, header->num_elements))
+      return true;
+
     for (uint32_t i = 0; i < header->num_elements; ++i) {
       if (!validate_params->element_is_nullable &&
           elements[i].value() == kEncodedInvalidHandleValue) {
@@ -262,8 +268,15 @@ struct ArraySerializationHelper<P*, false> {
                                const ElementType* elements,
                                BoundsChecker* bounds_checker,
                                const ArrayValidateParams* validate_params) {
+    // Check all the pointers up front, in a loop that doesn't exit early (so
+    // that it can be vectorized). Only if that fails is each pointer checked
+    // just before validating what it points to, so that the first error is
+    // the one reported.
+    const bool check_each_pointer = !AllPointersAreValid(
+        header, elements, validate_params->element_is_nullable);
     for (uint32_t i = 0; i < header->num_elements; ++i) {
-      if (!validate_params->element_is_nullable && !elements[i].offset) {
+      if (check_each_pointer && !validate_params->element_is_nullable &&
+          !elements[i].offset) {
         ReportValidationError(
             VALIDATION_ERROR_UNEXPECTED_NULL_POINTER,
             MakeMessageWithArrayIndex("null in array expecting valid pointers",
@@ -271,7 +284,7 @@ struct ArraySerializationHelper<P*, false> {
                                       i).c_str());
         return false;
       }
-      if (!ValidateEncodedPointer(&elements[i].offset)) {
+      if (check_each_pointer && !ValidateEncodedPointer(&elements[i].offset)) {
         ReportValidationError(VALIDATION_ERROR_ILLEGAL_POINTER);
         return false;
       }
@@ -285,6 +298,17 @@ struct ArraySerializationHelper<P*, false> {
   }
 
  private:
+  static bool AllPointersAreValid(const ArrayHeader* header,
+                                  const ElementType* elements,
+                                  bool element_is_nullable) {
+    bool valid = true;
+    for (uint32_t i = 0; i < header->num_elements; ++i) {
+      valid &= (element_is_nullable || elements[i].offset) &
+               ValidateEncodedPointer(&elements[i].offset);
+    }
+    return valid;
+  }
+
   template <typename T,
             bool is_union = IsUnionDataType<T>::value>
   struct ValidateCaller {};
@@ -36,17 +36,6 @@ BoundsChecker::BoundsChecker(const void* data,
 BoundsChecker::~BoundsChecker() {
 }
 
-bool BoundsChecker::ClaimMemory(const void* position, uint32_t num_bytes) {
-  uintptr_t begin = reinterpret_cast<uintptr_t>(position);
-  uintptr_t end = begin + num_bytes;
-
-  if (!InternalIsValidRange(begin, end))
-    return false;
-
-  data_begin_ = end;
-  return true;
-}
-
 bool BoundsChecker::ClaimHandle(const Handle& encoded_handle) {
   uint32_t index = encoded_handle.value();
   if (index == kEncodedInvalidHandleValue)
@@ -61,16 +50,31 @@ bool BoundsChecker::ClaimHandle(const Handle& encoded_handle) {
   return true;
 }
 
-bool BoundsChecker::IsValidRange(const void* position,
-                                 uint32_t num_bytes) const {
-  uintptr_t begin = reinterpret_cast<uintptr_t>(position);
-  uintptr_t end = begin + num_bytes;
+bool BoundsChecker::ClaimHandles(const Handle* encoded_handles,
+                                 uint32_t num_handles) {
+  if (!num_handles)
+    return true;
 
-  return InternalIsValidRange(begin, end);
-}
+  static_assert(sizeof(Handle) == sizeof(MojoHandle),
+                "Handle has the wrong size");
+  const MojoHandle* indices =
+      reinterpret_cast<const MojoHandle*>(encoded_handles);
+
+  // The handles can all be claimed if and only if their indices are strictly
+  // increasing and in range. (|kEncodedInvalidHandleValue| is the largest
+  // possible index, so it's either out of order or, if it's last, out of
+  // range.) The loop doesn't exit early, so that it can be vectorized.
+  uint32_t out_of_order = 0;
+  for (uint32_t i = 1; i < num_handles; i++)
+    out_of_order |= indices[i - 1] >= indices[i];
+  if (out_of_order || indices[0] < handle_begin_ ||
+      indices[num_handles - 1] >= handle_end_) {
+    return false;
+  }
 
-bool BoundsChecker::InternalIsValidRange(uintptr_t begin, uintptr_t end) const {
-  return end > begin && begin >= data_begin_ && end <= data_end_;
+  // As in |ClaimHandle()|, this doesn't overflow.
+  handle_begin_ = indices[num_handles - 1] + 1;
+  return true;
 }
 
 }  // namespace internal
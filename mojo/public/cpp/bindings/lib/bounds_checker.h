@@ -30,7 +30,16 @@ class BoundsChecker {
   // the comments for IsValidRange().)
   // On success, the valid memory range is shrinked to begin right after the end
   // of the claimed range.
-  bool ClaimMemory(const void* position, uint32_t num_bytes);
+  bool ClaimMemory(const void* position, uint32_t num_bytes) {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(position);
+    uintptr_t end = begin + num_bytes;
+
+    if (!InternalIsValidRange(begin, end))
+      return false;
+
+    data_begin_ = end;
+    return true;
+  }
 
   // Claims the specified encoded handle (which is basically a handle index).
   // The method succeeds if:
@@ -39,12 +48,26 @@ class BoundsChecker {
   // case, the valid range is shinked to begin right after the claimed handle.
   bool ClaimHandle(const Handle& encoded_handle);
 
+  // Claims |num_handles| encoded handles in order, like calling
+  // |ClaimHandle()| on each of them, except that it fails if any of them is
+  // |kEncodedInvalidHandleValue|. It's faster than claiming the handles one
+  // at a time, which callers should fall back to on failure (e.g., to find
+  // out which handle is bad). On failure, no handles are claimed.
+  bool ClaimHandles(const Handle* encoded_handles, uint32_t num_handles);
+
   // Returns true if the specified range is not empty, and the range is
   // contained inside the valid memory range.
-  bool IsValidRange(const void* position, uint32_t num_bytes) const;
+  bool IsValidRange(const void* position, uint32_t num_bytes) const {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(position);
+    uintptr_t end = begin + num_bytes;
+
+    return InternalIsValidRange(begin, end);
+  }
 
  private:
-  bool InternalIsValidRange(uintptr_t begin, uintptr_t end) const;
+  bool InternalIsValidRange(uintptr_t begin, uintptr_t end) const {
+    return end > begin && begin >= data_begin_ && end <= data_end_;
+  }
 
   // [data_begin_, data_end_) is the valid memory range.
   uintptr_t data_begin_;
@@ -4,12 +4,47 @@
 
 #include "mojo/public/cpp/bindings/lib/connector.h"
 
+#include <string.h>
+
 #include "mojo/public/cpp/bindings/error_handler.h"
 #include "mojo/public/cpp/environment/logging.h"
 
 namespace mojo {
 namespace internal {
 
+namespace {
+
+// The maximum number of messages dispatched before going back to the waiter,
+// so that a busy message pipe doesn't starve everything else.
+const int kMaxMessagesPerTurn = 64;
+
+// Limits for a single |MojoReadMessages()| call in drain mode. (Messages that
+// are bigger than this are read individually.)
+const uint32_t kMaxBurstMessages = 16;
+const uint32_t kMaxBurstBytes = 32 * 1024;
+const uint32_t kMaxBurstHandles = 64;
+
+// Limits on the messages buffered while corked, beyond which they're written
+// anyway.
+const size_t kMaxCorkedMessages = 256;
+const size_t kMaxCorkedBytes = 1024 * 1024;
+const size_t kMaxCorkedHandles = 256;
+
+// Returns true if |message| is the response to the request |request_id|.
+// |message| hasn't been validated yet, so this checks that it has a big enough
+// header first.
+bool IsResponseTo(const Message& message, uint64_t request_id) {
+  if (message.data_num_bytes() < sizeof(MessageHeaderWithRequestID))
+    return false;
+  const MessageHeaderWithRequestID* header =
+      static_cast<const MessageHeaderWithRequestID*>(message.header());
+  return header->num_bytes >= sizeof(MessageHeaderWithRequestID) &&
+         header->version >= 1 && (header->flags & kMessageIsResponse) &&
+         header->request_id == request_id;
+}
+
+}  // namespace
+
 // ----------------------------------------------------------------------------
 
 Connector::Connector(ScopedMessagePipeHandle message_pipe,
@@ -21,6 +56,8 @@ Connector::Connector(ScopedMessagePipeHandle message_pipe,
       error_(false),
       drop_writes_(false),
       enforce_errors_from_incoming_receiver_(true),
+      drain_mode_(false),
+      cork_depth_(0),
       destroyed_flag_(nullptr) {
   // Even though we don't have an incoming receiver, we still want to monitor
   // the message pipe to know if is closed or encounters an error.
@@ -31,35 +68,117 @@ Connector::~Connector() {
   if (destroyed_flag_)
     *destroyed_flag_ = true;
 
+  FlushCorkedMessages();
   CancelWait();
 }
 
 void Connector::CloseMessagePipe() {
+  FlushCorkedMessages();
   CancelWait();
   Close(message_pipe_.Pass());
 }
 
 ScopedMessagePipeHandle Connector::PassMessagePipe() {
+  MOJO_CHECK(pending_messages_.IsEmpty())
+      << "Can't pass a message pipe with undispatched messages";
+
+  FlushCorkedMessages();
   CancelWait();
   return message_pipe_.Pass();
 }
 
+void Connector::Cork() {
+  cork_depth_++;
+}
+
+void Connector::Uncork() {
+  MOJO_DCHECK(cork_depth_ > 0);
+  if (--cork_depth_ == 0)
+    FlushCorkedMessages();
+}
+
 bool Connector::WaitForIncomingMessage(MojoDeadline deadline) {
   if (error_)
     return false;
 
-  MojoResult rv =
-      Wait(message_pipe_.get(), MOJO_HANDLE_SIGNAL_READABLE, deadline, nullptr);
+  // Whatever we're waiting for may depend on messages we haven't written yet.
+  FlushCorkedMessages();
+
+  MojoResult rv;
+  if (!pending_messages_.IsEmpty()) {
+    mojo_ignore_result(ReadSingleMessage(&rv));
+    return (rv == MOJO_RESULT_OK);
+  }
+
+  rv = Wait(message_pipe_.get(), MOJO_HANDLE_SIGNAL_READABLE, deadline,
+            nullptr);
   if (rv == MOJO_RESULT_SHOULD_WAIT)
     return false;
   if (rv != MOJO_RESULT_OK) {
     NotifyError();
     return false;
   }
-  mojo_ignore_result(ReadSingleMessage(&rv));
+  bool destroyed = !ReadSingleMessage(&rv);
+  // In drain mode, the rest of a burst may have been queued.
+  if (!destroyed && !pending_messages_.IsEmpty() && async_wait_id_)
+    WaitToDispatchPendingMessages();
   return (rv == MOJO_RESULT_OK);
 }
 
+bool Connector::WaitForSyncResponse(uint64_t request_id) {
+  if (error_)
+    return false;
+
+  // The request may still be corked.
+  FlushCorkedMessages();
+
+  bool response_dispatched = false;
+  for (;;) {
+    MojoResult rv = Wait(message_pipe_.get(), MOJO_HANDLE_SIGNAL_READABLE,
+                         MOJO_DEADLINE_INDEFINITE, nullptr);
+    if (rv != MOJO_RESULT_OK)
+      break;
+
+    Message message;
+    rv = ReadMessage(message_pipe_.get(), &message);
+    if (rv == MOJO_RESULT_SHOULD_WAIT)
+      continue;
+    if (rv != MOJO_RESULT_OK)
+      break;
+
+    if (!IsResponseTo(message, request_id)) {
+      pending_messages_.Push(&message);
+      continue;
+    }
+
+    bool receiver_result = false;
+    bool was_destroyed_during_dispatch = false;
+    bool* previous_destroyed_flag = destroyed_flag_;
+    destroyed_flag_ = &was_destroyed_during_dispatch;
+    if (incoming_receiver_)
+      receiver_result = incoming_receiver_->Accept(&message);
+    if (was_destroyed_during_dispatch) {
+      if (previous_destroyed_flag)
+        *previous_destroyed_flag = true;  // Propagate flag.
+      return true;
+    }
+    destroyed_flag_ = previous_destroyed_flag;
+
+    if (enforce_errors_from_incoming_receiver_ && !receiver_result) {
+      NotifyError();
+      return false;
+    }
+    response_dispatched = true;
+    break;
+  }
+
+  // Any errors are left for the message loop to notice (after it's dispatched
+  // the queued messages).
+  if (!pending_messages_.IsEmpty() && async_wait_id_)
+    WaitToDispatchPendingMessages();
+  return response_dispatched;
+}
+
 bool Connector::Accept(Message* message) {
   if (error_)
     return false;
@@ -68,16 +187,26 @@ bool Connector::Accept(Message* message) {
   if (drop_writes_)
     return true;
 
-  MojoResult rv =
-      WriteMessageRaw(message_pipe_.get(),
-                      message->data(),
-                      message->data_num_bytes(),
-                      message->mutable_handles()->empty()
-                          ? nullptr
-                          : reinterpret_cast<const MojoHandle*>(
-                                &message->mutable_handles()->front()),
-                      static_cast<uint32_t>(message->mutable_handles()->size()),
-                      MOJO_WRITE_MESSAGE_FLAG_NONE);
+  if (cork_depth_ > 0) {
+    CorkMessage(message);
+    return true;
+  }
+
+  MojoResult rv;
+  if (message->context()) {
+    rv = WriteMessageContext(message_pipe_.get(), message);
+  } else {
+    rv = WriteMessageRaw(
+        message_pipe_.get(),
+        message->data(),
+        message->data_num_bytes(),
+        message->mutable_handles()->empty()
+            ? nullptr
+            : reinterpret_cast<const MojoHandle*>(
+                  &message->mutable_handles()->front()),
+        static_cast<uint32_t>(message->mutable_handles()->size()),
+        MOJO_WRITE_MESSAGE_FLAG_NONE);
+  }
 
   switch (rv) {
     case MOJO_RESULT_OK:
@@ -122,7 +251,11 @@ void Connector::CallOnHandleReady(void* closure, MojoResult result) {
 void Connector::OnHandleReady(MojoResult result) {
   MOJO_CHECK(async_wait_id_ != 0);
   async_wait_id_ = 0;
-  if (result != MOJO_RESULT_OK) {
+  // Messages queued by |WaitForSyncResponse()| should be dispatched even if the
+  // pipe has been closed since. (If so, the error is noticed afterwards.)
+  bool dispatch_pending_messages = result == MOJO_RESULT_FAILED_PRECONDITION &&
+                                   !pending_messages_.IsEmpty();
+  if (result != MOJO_RESULT_OK && !dispatch_pending_messages) {
     NotifyError();
     return;
   }
@@ -139,6 +272,20 @@ void Connector::WaitToReadMore() {
                                       this);
 }
 
+void Connector::WaitToDispatchPendingMessages() {
+  MOJO_DCHECK(!pending_messages_.IsEmpty());
+  // The pipe may never become readable again, since the pending messages have
+  // already been read from it. Wait for it to be writable instead, which it
+  // normally is (and, if it's not, the wait fails), so that we're called back
+  // right away.
+  CancelWait();
+  async_wait_id_ = waiter_->AsyncWait(message_pipe_.get().value(),
+                                      MOJO_HANDLE_SIGNAL_WRITABLE,
+                                      MOJO_DEADLINE_INDEFINITE,
+                                      &Connector::CallOnHandleReady,
+                                      this);
+}
+
 bool Connector::ReadSingleMessage(MojoResult* read_result) {
   bool receiver_result = false;
 
@@ -148,8 +295,15 @@ bool Connector::ReadSingleMessage(MojoResult* read_result) {
   bool* previous_destroyed_flag = destroyed_flag_;
   destroyed_flag_ = &was_destroyed_during_dispatch;
 
-  MojoResult rv = ReadAndDispatchMessage(
-      message_pipe_.get(), incoming_receiver_, &receiver_result);
+  MojoResult rv = MOJO_RESULT_OK;
+  if (pending_messages_.IsEmpty() && drain_mode_)
+    rv = ReadMessageBurst();
+  if (!pending_messages_.IsEmpty()) {
+    DispatchPendingMessage(&receiver_result);
+  } else if (rv == MOJO_RESULT_OK || rv == MOJO_RESULT_RESOURCE_EXHAUSTED) {
+    rv = ReadAndDispatchMessage(
+        message_pipe_.get(), incoming_receiver_, &receiver_result);
+  }
   if (read_result)
     *read_result = rv;
 
@@ -171,8 +325,64 @@ bool Connector::ReadSingleMessage(MojoResult* read_result) {
   return true;
 }
 
+MojoResult Connector::ReadMessageBurst() {
+  MOJO_DCHECK(pending_messages_.IsEmpty());
+
+  if (burst_bytes_.empty()) {
+    burst_bytes_.resize(kMaxBurstBytes / sizeof(uint64_t));
+    burst_handles_.resize(kMaxBurstHandles);
+  }
+  uint32_t num_bytes = kMaxBurstBytes;
+  uint32_t num_handles = kMaxBurstHandles;
+  uint32_t message_num_bytes[kMaxBurstMessages];
+  uint32_t message_num_handles[kMaxBurstMessages];
+  uint32_t num_messages = kMaxBurstMessages;
+  MojoResult rv = ReadMessagesRaw(message_pipe_.get(),
+                                  &burst_bytes_[0],
+                                  &num_bytes,
+                                  &burst_handles_[0],
+                                  &num_handles,
+                                  message_num_bytes,
+                                  message_num_handles,
+                                  &num_messages,
+                                  MOJO_READ_MESSAGE_FLAG_NONE);
+  if (rv != MOJO_RESULT_OK)
+    return rv;
+
+  const char* bytes = reinterpret_cast<const char*>(&burst_bytes_[0]);
+  const MojoHandle* handles = &burst_handles_[0];
+  for (uint32_t i = 0; i < num_messages; i++) {
+    Message message;
+    message.AllocUninitializedData(message_num_bytes[i]);
+    memcpy(message.mutable_data(), bytes, message_num_bytes[i]);
+    bytes += message_num_bytes[i];
+    message.mutable_handles()->resize(message_num_handles[i]);
+    for (uint32_t j = 0; j < message_num_handles[i]; j++)
+      message.mutable_handles()->at(j) = Handle(*handles++);
+    pending_messages_.Push(&message);
+  }
+  return MOJO_RESULT_OK;
+}
+
+void Connector::DispatchPendingMessage(bool* receiver_result) {
+  Message message;
+  pending_messages_.Pop(&message);
+  if (incoming_receiver_)
+    *receiver_result = incoming_receiver_->Accept(&message);
+}
+
 void Connector::ReadAllAvailableMessages() {
-  while (!error_) {
+  for (int i = 0; !error_; i++) {
+    if (i >= kMaxMessagesPerTurn) {
+      // Give others a turn; the waiter will call us back right away if there's
+      // more to read (or to dispatch).
+      if (pending_messages_.IsEmpty())
+        WaitToReadMore();
+      else
+        WaitToDispatchPendingMessages();
+      break;
+    }
+
     MojoResult rv;
 
     // Return immediately if |this| was destroyed. Do not touch any members!
@@ -186,6 +396,115 @@ void Connector::ReadAllAvailableMessages() {
   }
 }
 
+void Connector::CorkMessage(Message* message) {
+  message->SerializeContext();
+
+  const char* data = reinterpret_cast<const char*>(message->data());
+  corked_bytes_.insert(corked_bytes_.end(), data,
+                       data + message->data_num_bytes());
+  corked_message_num_bytes_.push_back(message->data_num_bytes());
+
+  // We now own the handles (until they're written).
+  std::vector<Handle>* handles = message->mutable_handles();
+  uint32_t num_handles = static_cast<uint32_t>(handles->size());
+  for (uint32_t i = 0; i < num_handles; i++)
+    corked_handles_.push_back((*handles)[i].value());
+  corked_message_num_handles_.push_back(num_handles);
+  handles->clear();
+
+  if (corked_message_num_bytes_.size() >= kMaxCorkedMessages ||
+      corked_bytes_.size() >= kMaxCorkedBytes ||
+      corked_handles_.size() >= kMaxCorkedHandles)
+    FlushCorkedMessages();
+}
+
+void Connector::FlushCorkedMessages() {
+  if (corked_message_num_bytes_.empty())
+    return;
+
+  MojoResult rv = MOJO_RESULT_FAILED_PRECONDITION;
+  if (!error_ && !drop_writes_ && message_pipe_.is_valid()) {
+    rv = WriteMessagesRaw(
+        message_pipe_.get(),
+        corked_bytes_.empty() ? nullptr : &corked_bytes_[0],
+        static_cast<uint32_t>(corked_bytes_.size()),
+        corked_handles_.empty() ? nullptr : &corked_handles_[0],
+        static_cast<uint32_t>(corked_handles_.size()),
+        &corked_message_num_bytes_[0], &corked_message_num_handles_[0],
+        static_cast<uint32_t>(corked_message_num_bytes_.size()),
+        MOJO_WRITE_MESSAGE_FLAG_NONE);
+  }
+
+  switch (rv) {
+    case MOJO_RESULT_OK:
+      // The handles were successfully transferred.
+      corked_handles_.clear();
+      break;
+    case MOJO_RESULT_FAILED_PRECONDITION:
+      // As in |Accept()|, hide this from the caller and avoid writing any
+      // future messages.
+      drop_writes_ = true;
+      break;
+    case MOJO_RESULT_BUSY:
+      // See |Accept()|.
+      MOJO_CHECK(false) << "Race condition or other bug detected";
+      break;
+    default:
+      // The messages were rejected (presumably because of bad input). Write
+      // them one by one instead, so that (as in |Accept()|) only the bad ones
+      // are rejected.
+      WriteCorkedMessagesIndividually();
+      break;
+  }
+
+  for (size_t i = 0; i < corked_handles_.size(); i++) {
+    if (corked_handles_[i] != MOJO_HANDLE_INVALID)
+      CloseRaw(Handle(corked_handles_[i]));
+  }
+  corked_bytes_.clear();
+  corked_handles_.clear();
+  corked_message_num_bytes_.clear();
+  corked_message_num_handles_.clear();
+}
+
+void Connector::WriteCorkedMessagesIndividually() {
+  size_t bytes_offset = 0;
+  size_t handles_offset = 0;
+  for (size_t i = 0; i < corked_message_num_bytes_.size(); i++) {
+    uint32_t num_bytes = corked_message_num_bytes_[i];
+    uint32_t num_handles = corked_message_num_handles_[i];
+    MojoHandle* handles =
+        num_handles ? &corked_handles_[handles_offset] : nullptr;
+    MojoResult rv = MOJO_RESULT_FAILED_PRECONDITION;
+    if (!drop_writes_) {
+      rv = WriteMessageRaw(
+          message_pipe_.get(),
+          num_bytes ? &corked_bytes_[bytes_offset] : nullptr, num_bytes,
+          handles, num_handles, MOJO_WRITE_MESSAGE_FLAG_NONE);
+    }
+    switch (rv) {
+      case MOJO_RESULT_OK:
+        // The handles were successfully transferred, so they mustn't be closed.
+        for (uint32_t j = 0; j < num_handles; j++)
+          handles[j] = MOJO_HANDLE_INVALID;
+        break;
+      case MOJO_RESULT_FAILED_PRECONDITION:
+        // See |Accept()|.
+        drop_writes_ = true;
+        break;
+      case MOJO_RESULT_BUSY:
+        // See |Accept()|.
+        MOJO_CHECK(false) << "Race condition or other bug detected";
+        break;
+      default:
+        // This message was rejected; its handles will be closed.
+        break;
+    }
+    bytes_offset += num_bytes;
+    handles_offset += num_handles;
+  }
+}
+
 void Connector::CancelWait() {
   if (!async_wait_id_)
     return;
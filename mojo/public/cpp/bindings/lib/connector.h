@@ -5,6 +5,8 @@
 #ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_CONNECTOR_H_
 #define MOJO_PUBLIC_CPP_BINDINGS_LIB_CONNECTOR_H_
 
+#include <vector>
+
 #include "mojo/public/c/environment/async_waiter.h"
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/public/cpp/bindings/lib/message_queue.h"
@@ -46,6 +48,27 @@ class Connector : public MessageReceiver {
     enforce_errors_from_incoming_receiver_ = enforce;
   }
 
+  // In drain mode, the Connector reads bursts of incoming messages with a
+  // single |MojoReadMessages()| call, instead of one call (or two) per message,
+  // and queues them for dispatch. This is cheaper when messages arrive faster
+  // than they're dispatched. However, the pipe can't be passed (see
+  // |PassMessagePipe()|) while the rest of a burst is queued, so drain mode may
+  // only be used if the pipe is never passed from inside a message handler.
+  // Also, messages can't be passed to it unserialized (see
+  // |MojoWriteMessageContext()|).
+  void set_drain_mode(bool drain_mode) { drain_mode_ = drain_mode; }
+
+  // While the Connector is corked, messages passed to |Accept()| are buffered
+  // instead of being written to the pipe one by one, and are written together
+  // (with a single |MojoWriteMessages()| call) when it's uncorked. They're also
+  // written if too many (or too many bytes or handles) are buffered, or if the
+  // pipe is about to be waited on, passed or closed. Corking may be nested.
+  // Note that since |Accept()| can't report failures to write buffered
+  // messages, a buffered message that's rejected is just dropped (but, as for
+  // |Accept()|, this doesn't affect the other messages).
+  void Cork();
+  void Uncork();
+
   // Sets the error handler to receive notifications when an error is
   // encountered while reading from the pipe or waiting to read from the pipe.
   void set_connection_error_handler(const Closure& error_handler) {
@@ -61,9 +84,18 @@ class Connector : public MessageReceiver {
   void CloseMessagePipe();
 
   // Releases the pipe, not triggering the error state. Connector is put into
-  // a quiescent state.
+  // a quiescent state. This must not be called while messages that have
+  // already been read from the pipe are waiting to be dispatched, since they
+  // can't be put back: i.e., after |WaitForSyncResponse()| has queued messages,
+  // until control has returned to the message loop (or they've been dispatched
+  // using |WaitForIncomingMessage()|), or at all in drain mode (see
+  // |set_drain_mode()|). |has_pending_messages()| tells whether there are any.
   ScopedMessagePipeHandle PassMessagePipe();
 
+  // Returns true if messages have been read from the pipe but not yet
+  // dispatched (see |PassMessagePipe()|).
+  bool has_pending_messages() const { return !pending_messages_.IsEmpty(); }
+
   // Is the connector bound to a MessagePipe handle?
   bool is_valid() const { return message_pipe_.is_valid(); }
 
@@ -72,6 +104,14 @@ class Connector : public MessageReceiver {
   // been delivered, |false| otherwise.
   bool WaitForIncomingMessage(MojoDeadline deadline);
 
+  // Blocks until the response to the request |request_id| (which must already
+  // have been written) arrives, and dispatches it. Other messages that arrive
+  // first are queued, and dispatched later as usual (i.e., once control returns
+  // to the message loop). Returns |true| if the response has been dispatched,
+  // |false| if it won't be (e.g., because the pipe was closed). Note that
+  // |this| may be destroyed while dispatching the response.
+  bool WaitForSyncResponse(uint64_t request_id);
+
   // MessageReceiver implementation:
   bool Accept(Message* message) override;
 
@@ -82,13 +122,34 @@ class Connector : public MessageReceiver {
   void OnHandleReady(MojoResult result);
 
   void WaitToReadMore();
+  // Waits so that |pending_messages_| (which must be nonempty) will be
+  // dispatched from the message loop.
+  void WaitToDispatchPendingMessages();
 
   // Returns false if |this| was destroyed during message dispatch.
   MOJO_WARN_UNUSED_RESULT bool ReadSingleMessage(MojoResult* read_result);
 
+  // Reads as many messages as possible (up to a limit) into
+  // |pending_messages_|. Returns |MOJO_RESULT_RESOURCE_EXHAUSTED| if the next
+  // message is too big to read this way.
+  MojoResult ReadMessageBurst();
+
+  // Dispatches the next message in |pending_messages_|, setting
+  // |*receiver_result| to the result.
+  void DispatchPendingMessage(bool* receiver_result);
+
   // |this| can be destroyed during message dispatch.
   void ReadAllAvailableMessages();
 
+  // Adds |message| to the messages buffered while corked.
+  void CorkMessage(Message* message);
+  // Writes any messages buffered while corked.
+  void FlushCorkedMessages();
+  // Writes the messages buffered while corked one by one (after writing them
+  // together failed), invalidating the entries in |corked_handles_| that are
+  // transferred.
+  void WriteCorkedMessagesIndividually();
+
   void NotifyError();
 
   // Cancels any calls made to |waiter_|.
@@ -104,6 +165,23 @@ class Connector : public MessageReceiver {
   bool error_;
   bool drop_writes_;
   bool enforce_errors_from_incoming_receiver_;
+  bool drain_mode_;
+
+  // Messages that have been read from the pipe (in drain mode, or while
+  // waiting for a sync response) but not yet dispatched. They're always
+  // dispatched before any more are read.
+  MessageQueue pending_messages_;
+  // The buffers that bursts of messages are read into (allocated on first
+  // use).
+  std::vector<uint64_t> burst_bytes_;
+  std::vector<MojoHandle> burst_handles_;
+
+  int cork_depth_;
+  // The messages buffered while corked, stored as for |MojoWriteMessages()|.
+  std::vector<char> corked_bytes_;
+  std::vector<MojoHandle> corked_handles_;
+  std::vector<uint32_t> corked_message_num_bytes_;
+  std::vector<uint32_t> corked_message_num_handles_;
 
   // If non-null, this will be set to true when the Connector is destroyed.  We
   // use this flag to allow for the Connector to be destroyed as a side-effect
@@ -5,10 +5,12 @@
 #include "mojo/public/cpp/bindings/lib/fixed_buffer.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <algorithm>
 
 #include "mojo/public/cpp/bindings/lib/bindings_serialization.h"
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
 #include "mojo/public/cpp/environment/logging.h"
 
 namespace mojo {
@@ -46,5 +48,79 @@ void* FixedBuffer::Leak() {
   return ptr;
 }
 
+PooledBuffer::PooledBuffer(size_t size) {
+  Init(size);
+}
+
+PooledBuffer::~PooledBuffer() {
+  FreeMemory();
+}
+
+void* PooledBuffer::Allocate(size_t delta) {
+  delta = internal::Align(delta);
+  MOJO_DCHECK(delta > 0);
+  size_ += delta;
+
+  if (delta > capacity_ - cursor_)
+    return AllocateFromOverflowBlock(delta);
+
+  char* result = ptr_ + cursor_;
+  cursor_ += delta;
+  // Zero the memory to avoid info leaks (it may have been used before). Only
+  // the memory that's actually used is zeroed, since |capacity_| may be an
+  // overestimate.
+  memset(result, 0, delta);
+  return result;
+}
+
+void PooledBuffer::Reset(size_t size) {
+  FreeMemory();
+  Init(size);
+}
+
+void* PooledBuffer::Leak() {
+  MOJO_DCHECK(is_contiguous());
+  char* ptr = ptr_;
+  ptr_ = nullptr;
+  cursor_ = 0;
+  capacity_ = 0;
+  size_ = 0;
+  return ptr;
+}
+
+void PooledBuffer::Init(size_t size) {
+  capacity_ = internal::Align(size);
+  ptr_ = static_cast<char*>(MessageBufferPool::Allocate(capacity_));
+  cursor_ = 0;
+  size_ = 0;
+  overflow_cursor_ = 0;
+  overflow_capacity_ = 0;
+}
+
+void PooledBuffer::FreeMemory() {
+  MessageBufferPool::Free(ptr_);
+  ptr_ = nullptr;
+  for (void* block : overflow_blocks_)
+    free(block);
+  overflow_blocks_.clear();
+}
+
+void* PooledBuffer::AllocateFromOverflowBlock(size_t delta) {
+  if (delta > overflow_capacity_ - overflow_cursor_) {
+    // Make each block at least twice as big as the last, so that the number of
+    // blocks stays small.
+    const size_t kMinOverflowBlockSize = 4096;
+    overflow_capacity_ = std::max(
+        delta, std::max(2 * overflow_capacity_, kMinOverflowBlockSize));
+    // calloc() required to zero memory and thus avoid info leaks.
+    overflow_blocks_.push_back(calloc(overflow_capacity_, 1));
+    overflow_cursor_ = 0;
+  }
+
+  char* result = static_cast<char*>(overflow_blocks_.back()) + overflow_cursor_;
+  overflow_cursor_ += delta;
+  return result;
+}
+
 }  // namespace internal
 }  // namespace mojo
@@ -5,6 +5,8 @@
 #ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_FIXED_BUFFER_H_
 #define MOJO_PUBLIC_CPP_BINDINGS_LIB_FIXED_BUFFER_H_
 
+#include <vector>
+
 #include "mojo/public/cpp/bindings/lib/buffer.h"
 #include "mojo/public/cpp/system/macros.h"
 
@@ -61,6 +63,59 @@ class FixedBuffer : public Buffer {
   MOJO_DISALLOW_COPY_AND_ASSIGN(FixedBuffer);
 };
 
+// PooledBuffer is used for building messages. Like FixedBuffer, it allocates
+// from a single block of memory, which comes from the calling thread's
+// |MessageBufferPool| (so the memory returned by |Leak()| must be freed using
+// |MessageBufferPool::Free()|).
+//
+// Unlike FixedBuffer, allocations that don't fit in the block succeed: they're
+// made from separate, heap-allocated "overflow" blocks, and |is_contiguous()|
+// becomes false. Such a buffer can't be used as a message, but the objects in
+// it are still valid. This lets a message be built using an estimate of its
+// size (without first walking the data to compute its exact size): if the
+// estimate is too small, the data can be deserialized from the buffer and
+// serialized again after |Reset()|ing it to the right size.
+class PooledBuffer : public Buffer {
+ public:
+  explicit PooledBuffer(size_t size);
+  ~PooledBuffer() override;
+
+  // Like |FixedBuffer::Allocate()|, but never fails (see above).
+  void* Allocate(size_t num_bytes) override;
+
+  // Returns the number of bytes allocated so far (all in the main block, if
+  // the buffer is contiguous).
+  size_t size() const { return size_; }
+
+  bool is_contiguous() const { return overflow_blocks_.empty(); }
+
+  // Returns the main block.
+  const void* data() const { return ptr_; }
+
+  // Frees all the memory, and starts again with a |size|-byte block.
+  void Reset(size_t size);
+
+  // Returns the main block (which the caller must free), resetting the buffer
+  // to be empty. The buffer must be contiguous.
+  void* Leak();
+
+ private:
+  void Init(size_t size);
+  void FreeMemory();
+  void* AllocateFromOverflowBlock(size_t num_bytes);
+
+  char* ptr_;
+  size_t cursor_;
+  size_t capacity_;
+  size_t size_;
+
+  std::vector<void*> overflow_blocks_;
+  size_t overflow_cursor_;
+  size_t overflow_capacity_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(PooledBuffer);
+};
+
 }  // namespace internal
 }  // namespace mojo
 
@@ -99,6 +99,18 @@ class InterfacePtrState {
     return router_->WaitForIncomingMessage(MOJO_DEADLINE_INDEFINITE);
   }
 
+  void Cork() {
+    ConfigureProxyIfNecessary();
+
+    if (router_)
+      router_->Cork();
+  }
+
+  void Uncork() {
+    if (router_)
+      router_->Uncork();
+  }
+
   // After this method is called, the object is in an invalid state and
   // shouldn't be reused.
   InterfacePtrInfo<Interface> PassInterface() {
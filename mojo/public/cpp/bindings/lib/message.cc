@@ -4,19 +4,61 @@
 
 #include "mojo/public/cpp/bindings/message.h"
 
-#include <stdlib.h>
+#include <string.h>
 
 #include <algorithm>
 
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
 #include "mojo/public/cpp/environment/logging.h"
 
 namespace mojo {
 
-Message::Message() : data_num_bytes_(0), data_(nullptr) {
+namespace {
+
+#if !defined(__native_client__)
+// The context of a message written using |MojoWriteMessageContext()| is a
+// heap-allocated |Message| with a context, which is serialized (by the system,
+// possibly on another thread) only if the message is read by something other
+// than |ReadMessage()| in this process. (Since the system calls these, message
+// pipes with such messages queued on them must be closed before the code is
+// unloaded.)
+
+uint32_t GetMessageContextSerializedSize(uintptr_t context) {
+  // This is called for every message written, so it mustn't serialize it.
+  const Message* message = reinterpret_cast<const Message*>(context);
+  if (!message->context())
+    return message->data_num_bytes();
+  return static_cast<uint32_t>(message->context()->GetSerializedSize());
+}
+
+void SerializeMessageContext(uintptr_t context,
+                             void* bytes,
+                             uint32_t num_bytes) {
+  Message* message = reinterpret_cast<Message*>(context);
+  message->SerializeContext();
+  MOJO_DCHECK(num_bytes == message->data_num_bytes());
+  memcpy(bytes, message->data(), num_bytes);
+}
+
+void DestroyMessageContext(uintptr_t context) {
+  delete reinterpret_cast<Message*>(context);
+}
+
+const MojoMessageContextThunks kMessageContextThunks = {
+    static_cast<uint32_t>(sizeof(MojoMessageContextThunks)),
+    &GetMessageContextSerializedSize,
+    &SerializeMessageContext,
+    &DestroyMessageContext};
+#endif  // !defined(__native_client__)
+
+}  // namespace
+
+Message::Message() : data_num_bytes_(0), data_(nullptr), context_(nullptr) {
 }
 
 Message::~Message() {
-  free(data_);
+  delete context_;
+  internal::MessageBufferPool::Free(data_);
 
   for (std::vector<Handle>::iterator it = handles_.begin();
        it != handles_.end();
@@ -29,7 +71,8 @@ Message::~Message() {
 void Message::AllocUninitializedData(uint32_t num_bytes) {
   MOJO_DCHECK(!data_);
   data_num_bytes_ = num_bytes;
-  data_ = static_cast<internal::MessageData*>(malloc(num_bytes));
+  data_ = static_cast<internal::MessageData*>(
+      internal::MessageBufferPool::Allocate(num_bytes));
 }
 
 void Message::AdoptData(uint32_t num_bytes, internal::MessageData* data) {
@@ -42,36 +85,114 @@ void Message::Swap(Message* other) {
   std::swap(data_num_bytes_, other->data_num_bytes_);
   std::swap(data_, other->data_);
   std::swap(handles_, other->handles_);
+  std::swap(context_, other->context_);
 }
 
-MojoResult ReadAndDispatchMessage(MessagePipeHandle handle,
-                                  MessageReceiver* receiver,
-                                  bool* receiver_result) {
+void Message::set_context(internal::MessageContext* context) {
+  MOJO_DCHECK(!context_);
+  MOJO_DCHECK(data_ && data_num_bytes_ == data_->header.num_bytes);
+  MOJO_DCHECK(handles_.empty());
+  context_ = context;
+}
+
+void Message::SerializeContext() {
+  if (!context_)
+    return;
+
+  Message serialized;
+  context_->Serialize(&serialized);
+  // The request ID may have been set since the context was created.
+  if (has_request_id())
+    serialized.set_request_id(request_id());
+  delete context_;
+  context_ = nullptr;
+  std::swap(data_num_bytes_, serialized.data_num_bytes_);
+  std::swap(data_, serialized.data_);
+  std::swap(handles_, serialized.handles_);
+}
+
+bool MessageReceiverWithResponder::AcceptWithResponderSync(
+    Message* message,
+    MessageReceiver* responder) {
+  return AcceptWithResponder(message, responder);
+}
+
+MojoResult ReadMessage(MessagePipeHandle handle, Message* message) {
   MojoResult rv;
 
   uint32_t num_bytes = 0, num_handles = 0;
+#if defined(__native_client__)
   rv = ReadMessageRaw(handle,
                       nullptr,
                       &num_bytes,
                       nullptr,
                       &num_handles,
                       MOJO_READ_MESSAGE_FLAG_NONE);
+#else
+  // Reading this way also lets messages be written unserialized to |handle|.
+  uintptr_t context = 0;
+  rv = MojoReadMessageContext(handle.value(), &kMessageContextThunks, &context,
+                              nullptr, &num_bytes, nullptr, &num_handles,
+                              MOJO_READ_MESSAGE_FLAG_NONE);
+  if (rv == MOJO_RESULT_OK && context) {
+    Message* context_message = reinterpret_cast<Message*>(context);
+    message->Swap(context_message);
+    delete context_message;
+    return MOJO_RESULT_OK;
+  }
+#endif
   if (rv != MOJO_RESULT_RESOURCE_EXHAUSTED)
     return rv;
 
-  Message message;
-  message.AllocUninitializedData(num_bytes);
-  message.mutable_handles()->resize(num_handles);
+  message->AllocUninitializedData(num_bytes);
+  message->mutable_handles()->resize(num_handles);
 
-  rv = ReadMessageRaw(
+  return ReadMessageRaw(
       handle,
-      message.mutable_data(),
+      message->mutable_data(),
       &num_bytes,
-      message.mutable_handles()->empty()
+      message->mutable_handles()->empty()
           ? nullptr
-          : reinterpret_cast<MojoHandle*>(&message.mutable_handles()->front()),
+          : reinterpret_cast<MojoHandle*>(&message->mutable_handles()->front()),
       &num_handles,
       MOJO_READ_MESSAGE_FLAG_NONE);
+}
+
+MojoResult WriteMessageContext(MessagePipeHandle handle, Message* message) {
+  MOJO_DCHECK(message->context());
+  MOJO_DCHECK(message->handles()->empty());
+
+#if defined(__native_client__)
+  // Not supported under NaCl, so just write the serialized message.
+  message->SerializeContext();
+  MojoResult rv =
+      WriteMessageRaw(handle, message->data(), message->data_num_bytes(),
+                      nullptr, 0, MOJO_WRITE_MESSAGE_FLAG_NONE);
+  if (rv == MOJO_RESULT_OK) {
+    Message empty;
+    message->Swap(&empty);
+  }
+  return rv;
+#else
+  Message* context_message = new Message();
+  context_message->Swap(message);
+  MojoResult rv = MojoWriteMessageContext(
+      handle.value(), reinterpret_cast<uintptr_t>(context_message),
+      &kMessageContextThunks, MOJO_WRITE_MESSAGE_FLAG_NONE);
+  if (rv != MOJO_RESULT_OK) {
+    // We still own |context_message|.
+    message->Swap(context_message);
+    delete context_message;
+  }
+  return rv;
+#endif
+}
+
+MojoResult ReadAndDispatchMessage(MessagePipeHandle handle,
+                                  MessageReceiver* receiver,
+                                  bool* receiver_result) {
+  Message message;
+  MojoResult rv = ReadMessage(handle, &message);
   if (receiver && rv == MOJO_RESULT_OK)
     *receiver_result = receiver->Accept(&message);
 
@@ -0,0 +1,157 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
+
+#include <stdlib.h>
+
+#include "mojo/public/cpp/environment/logging.h"
+#include "mojo/public/cpp/utility/lib/thread_local.h"
+
+namespace mojo {
+namespace internal {
+namespace {
+
+// Each buffer is preceded by a header, which records the buffer's size class.
+// (This keeps the buffer 8-byte aligned.)
+struct BlockHeader {
+  uint32_t size_class;
+  uint32_t padding;
+};
+static_assert(sizeof(BlockHeader) == 8, "BlockHeader has the wrong size");
+
+// Blocks (including the header) in size class |i| are |kMinBlockSize << i|
+// bytes. Larger buffers have size class |kUnpooledSizeClass|.
+const size_t kMinBlockSize = 64;
+const uint32_t kNumSizeClasses = 11;  // Up to 64 KB.
+const uint32_t kUnpooledSizeClass = kNumSizeClasses;
+
+// The most (in bytes, including headers) that each thread will cache.
+const size_t kMaxCachedBytesPerThread = 256 * 1024;
+
+size_t GetBlockSize(uint32_t size_class) {
+  return kMinBlockSize << size_class;
+}
+
+uint32_t GetSizeClass(size_t num_bytes) {
+  size_t block_size = num_bytes + sizeof(BlockHeader);
+  for (uint32_t size_class = 0; size_class < kNumSizeClasses; size_class++) {
+    if (block_size <= GetBlockSize(size_class))
+      return size_class;
+  }
+  return kUnpooledSizeClass;
+}
+
+// A free block (in a thread's cache) stores the next free block of the same
+// size class just past its header.
+BlockHeader*& NextFreeBlock(BlockHeader* block) {
+  return *reinterpret_cast<BlockHeader**>(block + 1);
+}
+
+struct ThreadCache {
+  ThreadCache() : cached_bytes(0) {
+    for (uint32_t i = 0; i < kNumSizeClasses; i++)
+      free_blocks[i] = nullptr;
+  }
+
+  ~ThreadCache() {
+    for (uint32_t i = 0; i < kNumSizeClasses; i++) {
+      while (BlockHeader* block = free_blocks[i]) {
+        free_blocks[i] = NextFreeBlock(block);
+        free(block);
+      }
+    }
+  }
+
+  BlockHeader* free_blocks[kNumSizeClasses];
+  size_t cached_bytes;
+  MessageBufferPool::Stats stats;
+};
+
+ThreadLocalPlatform::OnceType g_thread_cache_once =
+    MOJO_THREAD_LOCAL_ONCE_INIT;
+ThreadLocalPointer<ThreadCache> g_thread_cache;
+
+void MOJO_THREAD_LOCAL_DESTRUCTOR_CALL DeleteThreadCache(void* thread_cache) {
+  delete static_cast<ThreadCache*>(thread_cache);
+}
+
+void AllocateThreadCacheSlot() {
+  g_thread_cache.Allocate(&DeleteThreadCache);
+}
+
+ThreadCache* GetThreadCache() {
+  ThreadLocalPlatform::CallOnce(&g_thread_cache_once,
+                                &AllocateThreadCacheSlot);
+  ThreadCache* thread_cache = g_thread_cache.Get();
+  if (!thread_cache) {
+    thread_cache = new ThreadCache();
+    g_thread_cache.Set(thread_cache);
+  }
+  return thread_cache;
+}
+
+}  // namespace
+
+// static
+void* MessageBufferPool::Allocate(size_t num_bytes) {
+  ThreadCache* thread_cache = GetThreadCache();
+  thread_cache->stats.num_allocations++;
+
+  uint32_t size_class = GetSizeClass(num_bytes);
+  BlockHeader* block = nullptr;
+  if (size_class != kUnpooledSizeClass) {
+    block = thread_cache->free_blocks[size_class];
+    if (block) {
+      thread_cache->free_blocks[size_class] = NextFreeBlock(block);
+      thread_cache->cached_bytes -= GetBlockSize(size_class);
+      return block + 1;
+    }
+  }
+
+  thread_cache->stats.num_heap_allocations++;
+  size_t block_size = (size_class == kUnpooledSizeClass)
+                          ? sizeof(BlockHeader) + num_bytes
+                          : GetBlockSize(size_class);
+  block = static_cast<BlockHeader*>(malloc(block_size));
+  block->size_class = size_class;
+  return block + 1;
+}
+
+// static
+void MessageBufferPool::Free(void* buffer) {
+  if (!buffer)
+    return;
+
+  ThreadCache* thread_cache = GetThreadCache();
+  thread_cache->stats.num_frees++;
+
+  BlockHeader* block = static_cast<BlockHeader*>(buffer) - 1;
+  uint32_t size_class = block->size_class;
+  MOJO_DCHECK(size_class <= kUnpooledSizeClass);
+  if (size_class != kUnpooledSizeClass &&
+      thread_cache->cached_bytes + GetBlockSize(size_class) <=
+          kMaxCachedBytesPerThread) {
+    NextFreeBlock(block) = thread_cache->free_blocks[size_class];
+    thread_cache->free_blocks[size_class] = block;
+    thread_cache->cached_bytes += GetBlockSize(size_class);
+    return;
+  }
+
+  thread_cache->stats.num_heap_frees++;
+  free(block);
+}
+
+// static
+MessageBufferPool::Stats MessageBufferPool::GetThreadStats() {
+  return GetThreadCache()->stats;
+}
+
+// static
+void MessageBufferPool::ResetThreadStats() {
+  GetThreadCache()->stats = Stats();
+}
+
+}  // namespace internal
+}  // namespace mojo
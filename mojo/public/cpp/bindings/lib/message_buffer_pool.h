@@ -0,0 +1,60 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_MESSAGE_BUFFER_POOL_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_MESSAGE_BUFFER_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mojo {
+namespace internal {
+
+// MessageBufferPool provides the memory for message data (see |Message|), both
+// for outgoing messages (built using a |MessageBuilder|) and incoming ones
+// (read by |ReadAndDispatchMessage()|). Freed buffers are cached per thread,
+// by size class, so that a thread sending and receiving messages of similar
+// sizes doesn't hit the heap in the steady state.
+//
+// Buffers may be freed on any thread (they are then cached by that thread).
+// Large buffers, and buffers freed when the calling thread's cache is full, go
+// directly to/from the heap.
+class MessageBufferPool {
+ public:
+  // Per-thread counters, for tests and benchmarks.
+  struct Stats {
+    Stats()
+        : num_allocations(0),
+          num_frees(0),
+          num_heap_allocations(0),
+          num_heap_frees(0) {}
+
+    // Calls to |Allocate()| and |Free()| (with a non-null buffer).
+    uint64_t num_allocations;
+    uint64_t num_frees;
+    // How many of those went to the heap (i.e., called malloc()/free()).
+    uint64_t num_heap_allocations;
+    uint64_t num_heap_frees;
+  };
+
+  // Returns an (uninitialized) buffer of at least |num_bytes| bytes, 8-byte
+  // aligned. It must be freed using |Free()|.
+  static void* Allocate(size_t num_bytes);
+
+  // Frees a buffer obtained from |Allocate()|. Does nothing if |buffer| is
+  // null.
+  static void Free(void* buffer);
+
+  // Gets/resets the calling thread's counters.
+  static Stats GetThreadStats();
+  static void ResetThreadStats();
+
+ private:
+  MessageBufferPool();
+};
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_MESSAGE_BUFFER_POOL_H_
@@ -4,7 +4,10 @@
 
 #include "mojo/public/cpp/bindings/lib/message_builder.h"
 
+#include <string.h>
+
 #include "mojo/public/cpp/bindings/message.h"
+#include "mojo/public/cpp/environment/logging.h"
 
 namespace mojo {
 namespace internal {
@@ -26,6 +29,18 @@ MessageBuilder::MessageBuilder(uint32_t name, size_t payload_size)
 MessageBuilder::~MessageBuilder() {
 }
 
+void MessageBuilder::Reset(size_t payload_size) {
+  // Save the header, which is at the start of the main block.
+  MessageHeaderWithRequestID header;
+  uint32_t header_size =
+      static_cast<const MessageHeader*>(buf_.data())->num_bytes;
+  MOJO_DCHECK(header_size <= sizeof(header));
+  memcpy(&header, buf_.data(), header_size);
+
+  buf_.Reset(header_size + payload_size);
+  memcpy(buf_.Allocate(header_size), &header, header_size);
+}
+
 void MessageBuilder::Finish(Message* message) {
   uint32_t num_bytes = static_cast<uint32_t>(buf_.size());
   message->AdoptData(num_bytes, static_cast<MessageData*>(buf_.Leak()));
@@ -34,6 +49,18 @@ void MessageBuilder::Finish(Message* message) {
 MessageBuilder::MessageBuilder(size_t size) : buf_(size) {
 }
 
+void MessageSizeHint::Update(size_t payload_size) {
+  // Leave some room for growth.
+  size_t target = payload_size + payload_size / 4;
+  if (target > payload_size_) {
+    payload_size_ = target;
+  } else {
+    // Shrink slowly, so that an occasional small message doesn't cause the
+    // next large one not to fit.
+    payload_size_ -= (payload_size_ - target) / 8;
+  }
+}
+
 MessageWithRequestIDBuilder::MessageWithRequestIDBuilder(uint32_t name,
                                                          size_t payload_size,
                                                          uint32_t flags,
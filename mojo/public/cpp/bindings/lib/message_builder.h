@@ -22,18 +22,47 @@ class MessageBuilder {
 
   Buffer* buffer() { return &buf_; }
 
-  // Call Finish when done making allocations in |buffer()|. Upon return,
-  // |message| will contain the message data, and |buffer()| will no longer be
-  // valid to reference.
+  // Returns false if more than |payload_size| bytes (as given to the
+  // constructor or |Reset()|) have been allocated in |buffer()|, in which case
+  // the message can't be finished. (See |PooledBuffer|.)
+  bool is_contiguous() const { return buf_.is_contiguous(); }
+
+  // Frees everything allocated in |buffer()| (except for the message header),
+  // and makes room for a |payload_size|-byte payload.
+  void Reset(size_t payload_size);
+
+  // Call Finish when done making allocations in |buffer()|, which must be
+  // contiguous. Upon return, |message| will contain the message data, and
+  // |buffer()| will no longer be valid to reference.
   void Finish(Message* message);
 
  protected:
   explicit MessageBuilder(size_t size);
-  FixedBuffer buf_;
+  PooledBuffer buf_;
 
   MOJO_DISALLOW_COPY_AND_ASSIGN(MessageBuilder);
 };
 
+// Estimates the payload size of messages of one kind (e.g., the requests for
+// one method) from the sizes of recent ones. A |MessageBuilder| created with
+// the estimate can usually be filled in without computing the exact size of
+// the payload first (which takes a walk over all the data in it).
+class MessageSizeHint {
+ public:
+  MessageSizeHint() : payload_size_(0) {}
+
+  // Returns 0 if there's no estimate yet.
+  size_t payload_size() const { return payload_size_; }
+
+  // Updates the estimate given the actual size of a payload.
+  void Update(size_t payload_size);
+
+ private:
+  size_t payload_size_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(MessageSizeHint);
+};
+
 class MessageWithRequestIDBuilder : public MessageBuilder {
  public:
   MessageWithRequestIDBuilder(uint32_t name,
@@ -0,0 +1,104 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/lib/responder_table.h"
+
+#include "mojo/public/cpp/bindings/message.h"
+#include "mojo/public/cpp/environment/logging.h"
+
+namespace mojo {
+namespace internal {
+namespace {
+
+const size_t kInitialNumSlots = 16;
+
+}  // namespace
+
+ResponderTable::ResponderTable() : size_(0), num_deleted_(0) {
+}
+
+ResponderTable::~ResponderTable() {
+  Clear();
+}
+
+void ResponderTable::Insert(uint64_t request_id, MessageReceiver* responder) {
+  MOJO_DCHECK(request_id);
+  MOJO_DCHECK(responder);
+
+  if (2 * (size_ + num_deleted_ + 1) > entries_.size())
+    Rehash();
+  MOJO_DCHECK(!entries_[FindSlot(request_id)].responder)
+      << "Duplicate request ID";
+
+  // Use the first free slot, which may be a deleted one.
+  const size_t mask = entries_.size() - 1;
+  size_t slot = static_cast<size_t>(request_id) & mask;
+  while (entries_[slot].responder)
+    slot = (slot + 1) & mask;
+  if (entries_[slot].request_id)
+    num_deleted_--;
+  entries_[slot].request_id = request_id;
+  entries_[slot].responder = responder;
+  size_++;
+}
+
+MessageReceiver* ResponderTable::Remove(uint64_t request_id) {
+  if (!request_id || empty())
+    return nullptr;
+
+  size_t slot = FindSlot(request_id);
+  MessageReceiver* responder = entries_[slot].responder;
+  if (!responder)
+    return nullptr;
+
+  entries_[slot].responder = nullptr;
+  size_--;
+  // If the search for an ID would end at the next slot anyway, this slot can
+  // be made empty instead of deleted.
+  const size_t mask = entries_.size() - 1;
+  if (!entries_[(slot + 1) & mask].request_id)
+    entries_[slot].request_id = 0;
+  else
+    num_deleted_++;
+  return responder;
+}
+
+void ResponderTable::Clear() {
+  // Deleting a responder may run arbitrary code, so take them all out of the
+  // table first.
+  std::vector<Entry> entries;
+  entries.swap(entries_);
+  size_ = 0;
+  num_deleted_ = 0;
+  for (const Entry& entry : entries)
+    delete entry.responder;
+}
+
+size_t ResponderTable::FindSlot(uint64_t request_id) const {
+  MOJO_DCHECK(!entries_.empty());
+  const size_t mask = entries_.size() - 1;
+  size_t slot = static_cast<size_t>(request_id) & mask;
+  while (entries_[slot].request_id && entries_[slot].request_id != request_id)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+void ResponderTable::Rehash() {
+  // Keep the table at most a quarter full after rehashing, so that it's
+  // rehashed at most once every |entries_.size() / 4| insertions.
+  size_t num_slots = entries_.empty() ? kInitialNumSlots : entries_.size();
+  while (4 * (size_ + 1) > num_slots)
+    num_slots *= 2;
+
+  std::vector<Entry> old_entries(num_slots);
+  old_entries.swap(entries_);
+  num_deleted_ = 0;
+  for (const Entry& entry : old_entries) {
+    if (entry.responder)
+      entries_[FindSlot(entry.request_id)] = entry;
+  }
+}
+
+}  // namespace internal
+}  // namespace mojo
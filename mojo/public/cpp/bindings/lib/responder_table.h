@@ -0,0 +1,79 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_RESPONDER_TABLE_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_RESPONDER_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+
+class MessageReceiver;
+
+namespace internal {
+
+// ResponderTable holds (and owns) the responders for a |Router|'s outstanding
+// requests, keyed by request ID.
+//
+// It's a hash table using open addressing (with linear probing), hashing
+// request IDs by taking their low bits. Request IDs are handed out
+// sequentially, so the outstanding ones are usually close together and
+// rarely collide; lookups usually touch just one slot, and insertions and
+// removals don't allocate (except when the table is resized).
+class ResponderTable {
+ public:
+  ResponderTable();
+  ~ResponderTable();
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Adds |responder| (taking ownership of it) for |request_id|, which must be
+  // nonzero and not already in the table.
+  void Insert(uint64_t request_id, MessageReceiver* responder);
+
+  // Removes the responder for |request_id|, passing ownership of it to the
+  // caller. Returns null if there's no such responder.
+  MessageReceiver* Remove(uint64_t request_id);
+
+  // Deletes all the responders.
+  void Clear();
+
+ private:
+  // A slot is empty if |request_id| is 0. If |request_id| is nonzero but
+  // |responder| is null, the slot is "deleted": it's free, but lookups must
+  // probe past it.
+  struct Entry {
+    Entry() : request_id(0), responder(nullptr) {}
+
+    uint64_t request_id;
+    MessageReceiver* responder;
+  };
+
+  // Returns the slot that contains |request_id| (possibly deleted), or the
+  // empty slot where the search for it ended. The table must not be empty.
+  size_t FindSlot(uint64_t request_id) const;
+
+  // Makes enough room to insert another entry, by getting rid of the deleted
+  // slots and, if necessary, adding more.
+  void Rehash();
+
+  // The number of slots is always a power of 2, and at most half of them are
+  // in use or deleted.
+  std::vector<Entry> entries_;
+  size_t size_;
+  size_t num_deleted_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(ResponderTable);
+};
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_RESPONDER_TABLE_H_
@@ -4,6 +4,7 @@
 
 #include "mojo/public/cpp/bindings/lib/router.h"
 
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
 #include "mojo/public/cpp/environment/logging.h"
 
 namespace mojo {
@@ -15,6 +16,13 @@ class ResponderThunk : public MessageReceiverWithStatus {
  public:
   explicit ResponderThunk(const SharedData<Router*>& router)
       : router_(router), accept_was_invoked_(false) {}
+  // One of these is created for each incoming request that expects a
+  // response, so they're allocated from the thread's |MessageBufferPool|.
+  static void* operator new(size_t size) {
+    return MessageBufferPool::Allocate(size);
+  }
+  static void operator delete(void* ptr) { MessageBufferPool::Free(ptr); }
+
   ~ResponderThunk() override {
     if (!accept_was_invoked_) {
       // The Mojo application handled a message that was expecting a response
@@ -86,12 +94,7 @@ Router::Router(ScopedMessagePipeHandle message_pipe,
 
 Router::~Router() {
   weak_self_.set_value(nullptr);
-
-  for (ResponderMap::const_iterator i = responders_.begin();
-       i != responders_.end();
-       ++i) {
-    delete i->second;
-  }
+  responders_.Clear();
 }
 
 bool Router::Accept(Message* message) {
@@ -112,7 +115,18 @@ bool Router::AcceptWithResponder(Message* message, MessageReceiver* responder) {
     return false;
 
   // We assume ownership of |responder|.
-  responders_[request_id] = responder;
+  responders_.Insert(request_id, responder);
+  return true;
+}
+
+bool Router::AcceptWithResponderSync(Message* message,
+                                     MessageReceiver* responder) {
+  if (!AcceptWithResponder(message, responder))
+    return false;
+
+  // If the response isn't dispatched, |responder| is simply deleted along with
+  // |this|, as for an asynchronous request. Don't touch |this| afterwards.
+  mojo_ignore_result(connector_.WaitForSyncResponse(message->request_id()));
   return true;
 }
 
@@ -135,14 +149,11 @@ bool Router::HandleIncomingMessage(Message* message) {
     // listening, then we have no choice but to tear down the pipe.
     connector_.CloseMessagePipe();
   } else if (message->has_flag(kMessageIsResponse)) {
-    uint64_t request_id = message->request_id();
-    ResponderMap::iterator it = responders_.find(request_id);
-    if (it == responders_.end()) {
+    MessageReceiver* responder = responders_.Remove(message->request_id());
+    if (!responder) {
       MOJO_DCHECK(testing_mode_);
       return false;
     }
-    MessageReceiver* responder = it->second;
-    responders_.erase(it);
     bool ok = responder->Accept(message);
     delete responder;
     return ok;
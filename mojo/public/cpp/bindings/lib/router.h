@@ -5,11 +5,10 @@
 #ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_ROUTER_H_
 #define MOJO_PUBLIC_CPP_BINDINGS_LIB_ROUTER_H_
 
-#include <map>
-
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/public/cpp/bindings/lib/connector.h"
 #include "mojo/public/cpp/bindings/lib/filter_chain.h"
+#include "mojo/public/cpp/bindings/lib/responder_table.h"
 #include "mojo/public/cpp/bindings/lib/shared_data.h"
 #include "mojo/public/cpp/environment/environment.h"
 
@@ -44,14 +43,29 @@ class Router : public MessageReceiverWithResponder {
 
   void CloseMessagePipe() { connector_.CloseMessagePipe(); }
 
+  // See |Connector::PassMessagePipe()| (which has preconditions).
   ScopedMessagePipeHandle PassMessagePipe() {
     return connector_.PassMessagePipe();
   }
 
+  // See |Connector::set_drain_mode()|.
+  void set_drain_mode(bool drain_mode) {
+    connector_.set_drain_mode(drain_mode);
+  }
+
+  // See |Connector::Cork()|.
+  void Cork() { connector_.Cork(); }
+  void Uncork() { connector_.Uncork(); }
+
   // MessageReceiver implementation:
   bool Accept(Message* message) override;
   bool AcceptWithResponder(Message* message,
                            MessageReceiver* responder) override;
+  // Waits for the response directly on the pipe, rather than going back to
+  // the message loop; see |Connector::WaitForSyncResponse()|. |this| may be
+  // destroyed while the response is dispatched.
+  bool AcceptWithResponderSync(Message* message,
+                               MessageReceiver* responder) override;
 
   // Blocks the current thread until the first incoming method call, i.e.,
   // either a call to a client method or a callback method, or |deadline|.
@@ -69,8 +83,6 @@ class Router : public MessageReceiverWithResponder {
   MessagePipeHandle handle() const { return connector_.handle(); }
 
  private:
-  typedef std::map<uint64_t, MessageReceiver*> ResponderMap;
-
   class HandleIncomingMessageThunk : public MessageReceiver {
    public:
     HandleIncomingMessageThunk(Router* router);
@@ -90,7 +102,7 @@ class Router : public MessageReceiverWithResponder {
   Connector connector_;
   SharedData<Router*> weak_self_;
   MessageReceiverWithResponderStatus* incoming_receiver_;
-  ResponderMap responders_;
+  ResponderTable responders_;
   uint64_t next_request_id_;
   bool testing_mode_;
 };
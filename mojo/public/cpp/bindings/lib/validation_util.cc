@@ -12,12 +12,6 @@
 namespace mojo {
 namespace internal {
 
-bool ValidateEncodedPointer(const uint64_t* offset) {
-  // Cast to uintptr_t so overflow behavior is well defined.
-  return reinterpret_cast<uintptr_t>(offset) + *offset >=
-         reinterpret_cast<uintptr_t>(offset);
-}
-
 bool ValidateStructHeaderAndClaimMemory(const void* data,
                                         BoundsChecker* bounds_checker) {
   if (!IsAligned(data)) {
@@ -12,6 +12,40 @@
 
 namespace mojo {
 
+class Message;
+
+namespace internal {
+
+// The unserialized parameters of a message sent by a proxy in this process
+// (see |Message::context()|). Generated for methods with the [LocalDispatch=1]
+// attribute.
+class MessageContext {
+ public:
+  explicit MessageContext(const char* interface_name)
+      : interface_name_(interface_name) {}
+  virtual ~MessageContext() {}
+
+  // The |Name_| of the interface that the message is for. (This is compared by
+  // pointer, so it only matches if the message was sent using the same copy of
+  // the bindings.)
+  const char* interface_name() const { return interface_name_; }
+
+  // Returns the number of bytes (including the header) of the message that
+  // |Serialize()| would build, without building it.
+  virtual size_t GetSerializedSize() const = 0;
+
+  // Builds the serialized message in |message|, which is newly created. This
+  // may move the parameters out of the context.
+  virtual void Serialize(Message* message) = 0;
+
+ private:
+  const char* const interface_name_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(MessageContext);
+};
+
+}  // namespace internal
+
 // Message is a holder for the data and handles to be sent over a MessagePipe.
 // Message owns its data and handles, but a consumer of Message is free to
 // mutate the data and handles. The message's data is comprised of a header
@@ -21,13 +55,27 @@ class Message {
   Message();
   ~Message();
 
-  // These may only be called on a newly created Message object.
+  // These may only be called on a newly created Message object. The data given
+  // to |AdoptData()| must have been allocated using
+  // |internal::MessageBufferPool::Allocate()|.
   void AllocUninitializedData(uint32_t num_bytes);
   void AdoptData(uint32_t num_bytes, internal::MessageData* data);
 
-  // Swaps data and handles between this Message and another.
+  // Swaps data, handles and contexts between this Message and another.
   void Swap(Message* other);
 
+  // A message may have a context instead of a payload, in which case its data
+  // is just the header. It can then be passed to a message pipe endpoint in
+  // this process without being serialized (see |WriteMessageContext()|);
+  // receivers that need the payload must call |SerializeContext()| first.
+  // |set_context()| takes ownership of |context|, and may only be called on a
+  // message with no payload or handles.
+  internal::MessageContext* context() const { return context_; }
+  void set_context(internal::MessageContext* context);
+
+  // Replaces the context (if any) with the serialized payload.
+  void SerializeContext();
+
   uint32_t data_num_bytes() const { return data_num_bytes_; }
 
   // Access the raw bytes of the message.
@@ -73,8 +121,10 @@ class Message {
 
  private:
   uint32_t data_num_bytes_;
-  internal::MessageData* data_;  // Heap-allocated using malloc.
+  // Allocated using |internal::MessageBufferPool|.
+  internal::MessageData* data_;
   std::vector<Handle> handles_;
+  internal::MessageContext* context_;  // Owned.
 
   MOJO_DISALLOW_COPY_AND_ASSIGN(Message);
 };
@@ -104,6 +154,15 @@ class MessageReceiverWithResponder : public MessageReceiver {
   //
   virtual bool AcceptWithResponder(Message* message, MessageReceiver* responder)
       MOJO_WARN_UNUSED_RESULT = 0;
+
+  // Like AcceptWithResponder, but doesn't return until the responder's Accept
+  // method has been called with the response (or until it's known that it
+  // never will be, e.g., because the pipe was closed). This is used for
+  // methods with the [Sync=1] attribute. By default, it just calls
+  // AcceptWithResponder, i.e., it doesn't wait.
+  virtual bool AcceptWithResponderSync(Message* message,
+                                       MessageReceiver* responder)
+      MOJO_WARN_UNUSED_RESULT;
 };
 
 // A MessageReceiver that is also able to provide status about the state
@@ -139,6 +198,20 @@ class MessageReceiverWithResponderStatus : public MessageReceiver {
       MOJO_WARN_UNUSED_RESULT = 0;
 };
 
+// Reads a single message from the pipe into |message|, which must be newly
+// created. Returns MOJO_RESULT_SHOULD_WAIT if there's no message to read,
+// MOJO_RESULT_OK if a message was read, and otherwise an error code. A message
+// written using |WriteMessageContext()| in this process may be read with its
+// context (see |Message::context()|).
+MojoResult ReadMessage(MessagePipeHandle handle, Message* message);
+
+// Writes |message|, which must have a context and no handles, to the pipe. The
+// context is passed along unserialized if the message is read (using
+// |ReadMessage()|) in this process, and is serialized otherwise (see
+// |MojoWriteMessageContext()|). On success, |message| is left empty. Returns
+// the result of writing the message.
+MojoResult WriteMessageContext(MessagePipeHandle handle, Message* message);
+
 // Read a single message from the pipe and dispatch to the given receiver.  The
 // receiver may be null, in which case the message is simply discarded.
 // Returns MOJO_RESULT_SHOULD_WAIT if the caller should wait on the handle to
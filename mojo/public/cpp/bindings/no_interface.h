@@ -20,6 +20,7 @@ class NoInterfaceStub;
 class NoInterface {
  public:
   static const char* Name_;
+  static const bool HasLocalDispatchMethods_ = false;
   typedef NoInterfaceProxy Proxy_;
   typedef NoInterfaceStub Stub_;
   typedef PassThroughFilter RequestValidator_;
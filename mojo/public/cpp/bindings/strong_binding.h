@@ -58,7 +58,7 @@ class StrongBinding {
       ScopedMessagePipeHandle handle,
       const MojoAsyncWaiter* waiter = Environment::GetDefaultAsyncWaiter())
       : StrongBinding(impl) {
-    binding_.Bind(handle.Pass(), waiter);
+    Bind(handle.Pass(), waiter);
   }
 
   StrongBinding(
@@ -66,7 +66,7 @@ class StrongBinding {
       InterfacePtr<Interface>* ptr,
       const MojoAsyncWaiter* waiter = Environment::GetDefaultAsyncWaiter())
       : StrongBinding(impl) {
-    binding_.Bind(ptr, waiter);
+    Bind(ptr, waiter);
   }
 
   StrongBinding(
@@ -74,7 +74,7 @@ class StrongBinding {
       InterfaceRequest<Interface> request,
       const MojoAsyncWaiter* waiter = Environment::GetDefaultAsyncWaiter())
       : StrongBinding(impl) {
-    binding_.Bind(request.Pass(), waiter);
+    Bind(request.Pass(), waiter);
   }
 
   ~StrongBinding() {}
@@ -84,6 +84,7 @@ class StrongBinding {
       const MojoAsyncWaiter* waiter = Environment::GetDefaultAsyncWaiter()) {
     assert(!binding_.is_bound());
     binding_.Bind(handle.Pass(), waiter);
+    OnBound();
   }
 
   void Bind(
@@ -91,6 +92,7 @@ class StrongBinding {
       const MojoAsyncWaiter* waiter = Environment::GetDefaultAsyncWaiter()) {
     assert(!binding_.is_bound());
     binding_.Bind(ptr, waiter);
+    OnBound();
   }
 
   void Bind(
@@ -98,6 +100,7 @@ class StrongBinding {
       const MojoAsyncWaiter* waiter = Environment::GetDefaultAsyncWaiter()) {
     assert(!binding_.is_bound());
     binding_.Bind(request.Pass(), waiter);
+    OnBound();
   }
 
   bool WaitForIncomingMethodCall() {
@@ -129,6 +132,13 @@ class StrongBinding {
   }
 
  private:
+  // The pipe is never passed (there's no |Unbind()|), so incoming calls can be
+  // read in bursts, unless some may be passed unserialized.
+  void OnBound() {
+    if (!Interface::HasLocalDispatchMethods_)
+      binding_.internal_router()->set_drain_mode(true);
+  }
+
   Closure connection_error_handler_;
   Binding<Interface> binding_;
 };
@@ -161,6 +161,52 @@ TEST(BoundsCheckerTest, ClaimHandle) {
   }
 }
 
+TEST(BoundsCheckerTest, ClaimHandles) {
+  const Handle kInvalid(internal::kEncodedInvalidHandleValue);
+
+  {
+    internal::BoundsChecker checker(ToPtr(0), 0, 10);
+
+    // Basics.
+    EXPECT_TRUE(checker.ClaimHandles(nullptr, 0));
+    Handle handles1[] = {Handle(0), Handle(2), Handle(3)};
+    EXPECT_TRUE(checker.ClaimHandles(handles1, 3));
+    EXPECT_FALSE(checker.ClaimHandle(Handle(3)));
+
+    // Should fail, claiming nothing, if any handle can't be claimed.
+    Handle handles2[] = {Handle(4), Handle(6), Handle(5)};
+    EXPECT_FALSE(checker.ClaimHandles(handles2, 3));
+    Handle handles3[] = {Handle(4), Handle(4)};
+    EXPECT_FALSE(checker.ClaimHandles(handles3, 2));
+    Handle handles4[] = {Handle(3), Handle(4)};
+    EXPECT_FALSE(checker.ClaimHandles(handles4, 2));
+    Handle handles5[] = {Handle(4), Handle(10)};
+    EXPECT_FALSE(checker.ClaimHandles(handles5, 2));
+    EXPECT_TRUE(checker.ClaimHandle(Handle(4)));
+
+    // Should fail for invalid handles, even though |ClaimHandle()| would
+    // succeed.
+    Handle handles6[] = {Handle(5), kInvalid};
+    EXPECT_FALSE(checker.ClaimHandles(handles6, 2));
+    Handle handles7[] = {kInvalid, Handle(5)};
+    EXPECT_FALSE(checker.ClaimHandles(handles7, 2));
+    EXPECT_FALSE(checker.ClaimHandles(&kInvalid, 1));
+
+    Handle handles8[] = {Handle(5), Handle(9)};
+    EXPECT_TRUE(checker.ClaimHandles(handles8, 2));
+    EXPECT_FALSE(checker.ClaimHandle(Handle(9)));
+  }
+
+  {
+    // No handle to claim.
+    internal::BoundsChecker checker(ToPtr(0), 0, 0);
+
+    EXPECT_TRUE(checker.ClaimHandles(nullptr, 0));
+    Handle handle(0);
+    EXPECT_FALSE(checker.ClaimHandles(&handle, 1));
+  }
+}
+
 TEST(BoundsCheckerTest, ClaimMemory) {
   {
     internal::BoundsChecker checker(ToPtr(1000), 2000, 0);
@@ -2,10 +2,13 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
 #include <limits>
 
 #include "mojo/public/cpp/bindings/lib/bindings_serialization.h"
 #include "mojo/public/cpp/bindings/lib/fixed_buffer.h"
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace mojo {
@@ -66,6 +69,72 @@ TEST(FixedBufferTest, Leak) {
   free(buf_ptr);
 }
 
+// Tests that PooledBuffer zero-fills memory, even if it's been used before,
+// and that |Leak()| passes ownership to the caller.
+TEST(PooledBufferTest, ZeroFillAndLeak) {
+  for (int i = 0; i < 2; i++) {
+    internal::PooledBuffer buf(internal::Align(10) * 2);
+    EXPECT_EQ(0u, buf.size());
+
+    void* a = buf.Allocate(10);
+    ASSERT_TRUE(a);
+    EXPECT_TRUE(IsZero(a, 10));
+    EXPECT_EQ(0, reinterpret_cast<ptrdiff_t>(a) % 8);
+
+    void* b = buf.Allocate(10);
+    ASSERT_TRUE(b);
+    EXPECT_TRUE(IsZero(b, 10));
+    EXPECT_EQ(0, reinterpret_cast<ptrdiff_t>(b) % 8);
+    EXPECT_EQ(32u, buf.size());
+    EXPECT_TRUE(buf.is_contiguous());
+
+    void* buf_ptr = buf.Leak();
+    EXPECT_EQ(a, buf_ptr);
+    EXPECT_EQ(0u, buf.size());
+    EXPECT_FALSE(buf.Leak());
+
+    // Dirty the memory before returning it to the pool.
+    memset(buf_ptr, 1, 32);
+    internal::MessageBufferPool::Free(buf_ptr);
+  }
+}
+
+// Tests that allocations that don't fit in a PooledBuffer still succeed, and
+// that it can then be reset.
+TEST(PooledBufferTest, Overflow) {
+  internal::PooledBuffer buf(16);
+  void* a = buf.Allocate(16);
+  ASSERT_TRUE(a);
+  EXPECT_TRUE(buf.is_contiguous());
+
+  const size_t kNumAllocations = 14;
+  char* allocations[kNumAllocations];
+  for (size_t i = 0; i < kNumAllocations; i++) {
+    size_t size = 8u << i;
+    allocations[i] = static_cast<char*>(buf.Allocate(size));
+    ASSERT_TRUE(allocations[i]);
+    EXPECT_TRUE(IsZero(allocations[i], size));
+    EXPECT_EQ(0, reinterpret_cast<ptrdiff_t>(allocations[i]) % 8);
+    memset(allocations[i], static_cast<int>(i + 1), size);
+  }
+  EXPECT_FALSE(buf.is_contiguous());
+  EXPECT_EQ(a, buf.data());
+  // The allocations don't overlap.
+  for (size_t i = 0; i < kNumAllocations; i++) {
+    EXPECT_EQ(static_cast<char>(i + 1), allocations[i][0]);
+    EXPECT_EQ(static_cast<char>(i + 1), allocations[i][(8u << i) - 1]);
+  }
+
+  buf.Reset(64);
+  EXPECT_TRUE(buf.is_contiguous());
+  EXPECT_EQ(0u, buf.size());
+  void* b = buf.Allocate(64);
+  ASSERT_TRUE(b);
+  EXPECT_TRUE(IsZero(b, 64));
+  EXPECT_TRUE(buf.is_contiguous());
+  EXPECT_EQ(64u, buf.size());
+}
+
 #if defined(NDEBUG) && !defined(DCHECK_ALWAYS_ON)
 TEST(FixedBufferTest, TooBig) {
   internal::FixedBuffer buf(24);
@@ -5,6 +5,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <string>
+#include <vector>
+
 #include "mojo/public/cpp/bindings/lib/connector.h"
 #include "mojo/public/cpp/bindings/lib/message_builder.h"
 #include "mojo/public/cpp/bindings/lib/message_queue.h"
@@ -71,6 +74,22 @@ class ReentrantMessageAccumulator : public MessageAccumulator {
   int number_of_calls_;
 };
 
+// Appends its tag to a shared log for each message it receives.
+class TaggingMessageReceiver : public MessageReceiver {
+ public:
+  TaggingMessageReceiver(int tag, std::vector<int>* log)
+      : tag_(tag), log_(log) {}
+
+  bool Accept(Message* message) override {
+    log_->push_back(tag_);
+    return true;
+  }
+
+ private:
+  int tag_;
+  std::vector<int>* log_;
+};
+
 class ConnectorTest : public testing::Test {
  public:
   ConnectorTest() {}
@@ -90,6 +109,39 @@ class ConnectorTest : public testing::Test {
 
   void PumpMessages() { loop_.RunUntilIdle(); }
 
+  void TestFairness(bool drain_mode) {
+    MessagePipe other_pipe;
+    internal::Connector busy_sender(handle0_.Pass());
+    internal::Connector busy_receiver(handle1_.Pass());
+    internal::Connector other_sender(other_pipe.handle0.Pass());
+    internal::Connector other_receiver(other_pipe.handle1.Pass());
+    busy_receiver.set_drain_mode(drain_mode);
+    other_receiver.set_drain_mode(drain_mode);
+
+    std::vector<int> log;
+    TaggingMessageReceiver busy_log(0, &log);
+    TaggingMessageReceiver other_log(1, &log);
+    busy_receiver.set_incoming_receiver(&busy_log);
+    other_receiver.set_incoming_receiver(&other_log);
+
+    const size_t kNumBusyMessages = 1000;
+    for (size_t i = 0; i < kNumBusyMessages; i++) {
+      internal::MessageBuilder builder(1, 8);
+      Message message;
+      builder.Finish(&message);
+      busy_sender.Accept(&message);
+    }
+    internal::MessageBuilder builder(1, 8);
+    Message message;
+    builder.Finish(&message);
+    other_sender.Accept(&message);
+
+    PumpMessages();
+
+    ASSERT_EQ(kNumBusyMessages + 1, log.size());
+    EXPECT_NE(1, log.back());
+  }
+
  protected:
   ScopedMessagePipeHandle handle0_;
   ScopedMessagePipeHandle handle1_;
@@ -389,6 +441,310 @@ TEST_F(ConnectorTest, WaitForIncomingMessageWithReentrancy) {
   ASSERT_EQ(2, accumulator.number_of_calls());
 }
 
+TEST_F(ConnectorTest, PassMessagePipeWithPendingMessages) {
+  internal::Connector connector0(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+
+  MessageAccumulator accumulator;
+  connector1.set_incoming_receiver(&accumulator);
+
+  Message message;
+  AllocMessage("hello", &message);
+  connector0.Accept(&message);
+  internal::ResponseMessageBuilder builder(1, 8, 123u);
+  Message response;
+  builder.Finish(&response);
+  connector0.Accept(&response);
+
+  // Waiting for the response reads (but doesn't dispatch) the first message.
+  ASSERT_TRUE(connector1.WaitForSyncResponse(123u));
+  ASSERT_FALSE(accumulator.IsEmpty());
+  Message message_received;
+  accumulator.Pop(&message_received);
+  EXPECT_TRUE(accumulator.IsEmpty());
+
+  // So the pipe can't be passed yet.
+  EXPECT_TRUE(connector1.has_pending_messages());
+  EXPECT_DEATH_IF_SUPPORTED(connector1.PassMessagePipe(),
+                            "undispatched messages");
+
+  PumpMessages();
+  ASSERT_FALSE(accumulator.IsEmpty());
+  accumulator.Pop(&message_received);
+  EXPECT_EQ(std::string("hello"), std::string(reinterpret_cast<const char*>(
+                                      message_received.payload())));
+
+  // Now it can.
+  EXPECT_FALSE(connector1.has_pending_messages());
+  EXPECT_TRUE(connector1.PassMessagePipe().is_valid());
+  EXPECT_FALSE(connector1.is_valid());
+}
+
+TEST_F(ConnectorTest, Cork) {
+  internal::Connector connector0(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+
+  MessageAccumulator accumulator;
+  connector1.set_incoming_receiver(&accumulator);
+
+  const char* kText[] = {"hello", "cruel", "world"};
+  MessagePipe pipe;
+
+  connector0.Cork();
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kText); ++i) {
+    // Nested corking shouldn't write anything either.
+    if (i == 1)
+      connector0.Cork();
+
+    Message message;
+    AllocMessage(kText[i], &message);
+    if (i == 1)
+      message.mutable_handles()->push_back(pipe.handle0.release());
+    EXPECT_TRUE(connector0.Accept(&message));
+    // The handles now belong to the connector.
+    EXPECT_TRUE(message.handles()->empty());
+
+    if (i == 1)
+      connector0.Uncork();
+  }
+
+  PumpMessages();
+  EXPECT_TRUE(accumulator.IsEmpty());
+
+  connector0.Uncork();
+  PumpMessages();
+
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kText); ++i) {
+    ASSERT_FALSE(accumulator.IsEmpty());
+
+    Message message_received;
+    accumulator.Pop(&message_received);
+
+    EXPECT_EQ(
+        std::string(kText[i]),
+        std::string(reinterpret_cast<const char*>(message_received.payload())));
+    EXPECT_EQ(i == 1 ? 1u : 0u, message_received.handles()->size());
+  }
+  EXPECT_TRUE(accumulator.IsEmpty());
+}
+
+TEST_F(ConnectorTest, Cork_TooManyMessages) {
+  internal::Connector connector0(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+
+  std::vector<int> log;
+  TaggingMessageReceiver receiver(0, &log);
+  connector1.set_incoming_receiver(&receiver);
+
+  // Eventually, messages should be written even while corked.
+  const size_t kNumMessages = 1000;
+  connector0.Cork();
+  for (size_t i = 0; i < kNumMessages; i++) {
+    Message message;
+    AllocMessage("hello", &message);
+    EXPECT_TRUE(connector0.Accept(&message));
+  }
+  PumpMessages();
+  EXPECT_GT(log.size(), 0u);
+  EXPECT_LT(log.size(), kNumMessages);
+
+  connector0.Uncork();
+  PumpMessages();
+  EXPECT_EQ(kNumMessages, log.size());
+}
+
+TEST_F(ConnectorTest, Cork_TooManyHandles) {
+  internal::Connector connector0(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+
+  std::vector<int> log;
+  TaggingMessageReceiver receiver(0, &log);
+  connector1.set_incoming_receiver(&receiver);
+
+  // Messages should also be written while corked if they have too many handles
+  // attached in total (even if there aren't too many messages).
+  const size_t kNumMessages = 100;
+  connector0.Cork();
+  for (size_t i = 0; i < kNumMessages; i++) {
+    Message message;
+    AllocMessage("hello", &message);
+    for (size_t j = 0; j < 5; j++) {
+      MessagePipe pipe;
+      message.mutable_handles()->push_back(pipe.handle0.release());
+    }
+    EXPECT_TRUE(connector0.Accept(&message));
+  }
+  PumpMessages();
+  EXPECT_GT(log.size(), 0u);
+  EXPECT_LT(log.size(), kNumMessages);
+
+  connector0.Uncork();
+  PumpMessages();
+  EXPECT_EQ(kNumMessages, log.size());
+}
+
+TEST_F(ConnectorTest, Cork_BadMessage) {
+  internal::Connector connector0(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+
+  MessageAccumulator accumulator;
+  connector1.set_incoming_receiver(&accumulator);
+
+  const char* kText[] = {"hello", "bad", "world"};
+  MessagePipe pipe;
+
+  // The second message has an invalid handle attached, so it should be
+  // rejected when written, but the others should still be written.
+  connector0.Cork();
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kText); ++i) {
+    Message message;
+    AllocMessage(kText[i], &message);
+    if (i == 0)
+      message.mutable_handles()->push_back(pipe.handle0.release());
+    if (i == 1)
+      message.mutable_handles()->push_back(Handle(0x7fffffff));
+    EXPECT_TRUE(connector0.Accept(&message));
+  }
+  connector0.Uncork();
+  PumpMessages();
+
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kText); ++i) {
+    if (i == 1)
+      continue;
+    ASSERT_FALSE(accumulator.IsEmpty());
+
+    Message message_received;
+    accumulator.Pop(&message_received);
+
+    EXPECT_EQ(
+        std::string(kText[i]),
+        std::string(reinterpret_cast<const char*>(message_received.payload())));
+    EXPECT_EQ(i == 0 ? 1u : 0u, message_received.handles()->size());
+  }
+  EXPECT_TRUE(accumulator.IsEmpty());
+  EXPECT_FALSE(connector0.encountered_error());
+}
+
+TEST_F(ConnectorTest, Cork_ClosePipe) {
+  internal::Connector* connector0 = new internal::Connector(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+
+  MessageAccumulator accumulator;
+  connector1.set_incoming_receiver(&accumulator);
+
+  // Messages should be written before the pipe is closed (here, by destroying
+  // the connector).
+  connector0->Cork();
+  Message message;
+  AllocMessage("hello", &message);
+  EXPECT_TRUE(connector0->Accept(&message));
+  delete connector0;
+
+  PumpMessages();
+  EXPECT_FALSE(accumulator.IsEmpty());
+  EXPECT_TRUE(connector1.encountered_error());
+}
+
+// A pipe with a long backlog of messages shouldn't keep others from being
+// serviced.
+TEST_F(ConnectorTest, Fairness) {
+  TestFairness(false);
+}
+
+TEST_F(ConnectorTest, DrainMode) {
+  internal::Connector connector0(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+  connector1.set_drain_mode(true);
+
+  // Enough messages for several bursts, one too big to be read in a burst, and
+  // one with a handle.
+  const size_t kNumMessages = 100;
+  const size_t kBigMessage = 40;
+  const size_t kMessageWithHandle = 70;
+  MessagePipe pipe;
+  for (size_t i = 0; i < kNumMessages; i++) {
+    std::string text(i == kBigMessage ? 64 * 1024 : 10, 'a' + i % 26);
+    Message message;
+    AllocMessage(text.c_str(), &message);
+    if (i == kMessageWithHandle)
+      message.mutable_handles()->push_back(pipe.handle0.release());
+    connector0.Accept(&message);
+  }
+
+  MessageAccumulator accumulator;
+  connector1.set_incoming_receiver(&accumulator);
+
+  PumpMessages();
+
+  for (size_t i = 0; i < kNumMessages; i++) {
+    ASSERT_FALSE(accumulator.IsEmpty());
+
+    Message message_received;
+    accumulator.Pop(&message_received);
+
+    std::string text(i == kBigMessage ? 64 * 1024 : 10, 'a' + i % 26);
+    EXPECT_EQ(text, std::string(reinterpret_cast<const char*>(
+                        message_received.payload())));
+    EXPECT_EQ(i == kMessageWithHandle ? 1u : 0u,
+              message_received.handles()->size());
+  }
+  EXPECT_TRUE(accumulator.IsEmpty());
+  EXPECT_FALSE(connector1.encountered_error());
+}
+
+TEST_F(ConnectorTest, DrainMode_WaitForIncomingMessage) {
+  internal::Connector connector0(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+  connector1.set_drain_mode(true);
+
+  const char* kText[] = {"hello", "cruel", "world", "!"};
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kText); ++i) {
+    Message message;
+    AllocMessage(kText[i], &message);
+    connector0.Accept(&message);
+  }
+
+  MessageAccumulator accumulator;
+  connector1.set_incoming_receiver(&accumulator);
+
+  // Each call should deliver exactly one message, even though all of them are
+  // read from the pipe by the first.
+  for (size_t i = 0; i < 2; ++i) {
+    ASSERT_TRUE(connector1.WaitForIncomingMessage(MOJO_DEADLINE_INDEFINITE));
+
+    ASSERT_FALSE(accumulator.IsEmpty());
+    Message message_received;
+    accumulator.Pop(&message_received);
+    EXPECT_TRUE(accumulator.IsEmpty());
+    EXPECT_EQ(
+        std::string(kText[i]),
+        std::string(reinterpret_cast<const char*>(message_received.payload())));
+  }
+  EXPECT_TRUE(connector1.has_pending_messages());
+
+  // The rest should be dispatched from the message loop, even though the pipe
+  // isn't readable anymore.
+  PumpMessages();
+  for (size_t i = 2; i < MOJO_ARRAYSIZE(kText); ++i) {
+    ASSERT_FALSE(accumulator.IsEmpty());
+    Message message_received;
+    accumulator.Pop(&message_received);
+    EXPECT_EQ(
+        std::string(kText[i]),
+        std::string(reinterpret_cast<const char*>(message_received.payload())));
+  }
+  EXPECT_TRUE(accumulator.IsEmpty());
+
+  // Closing the other end should be noticed once everything's been read.
+  connector0.CloseMessagePipe();
+  EXPECT_FALSE(connector1.WaitForIncomingMessage(MOJO_DEADLINE_INDEFINITE));
+  EXPECT_TRUE(connector1.encountered_error());
+}
+
+TEST_F(ConnectorTest, DrainMode_Fairness) {
+  TestFairness(true);
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace mojo
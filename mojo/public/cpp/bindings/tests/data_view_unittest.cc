@@ -0,0 +1,292 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/data_view.h"
+#include "mojo/public/cpp/bindings/lib/fixed_buffer.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "mojo/public/interfaces/bindings/tests/test_data_view.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace data_view {
+namespace {
+
+std::string ToStdString(StringDataView view) {
+  return std::string(view.data(), view.size());
+}
+
+TestStructPtr MakeTestStruct() {
+  TestStructPtr s(TestStruct::New());
+  s->f_string = "hello";
+  s->f_struct = NestedStruct::New();
+  s->f_struct->f_int32 = 42;
+  s->f_enum = TEST_ENUM_VALUE_1;
+  s->f_bool = true;
+  s->f_double = 1.5;
+  s->f_string_array.push_back("a");
+  s->f_string_array.push_back("bc");
+  s->f_int32_array.push_back(1);
+  s->f_int32_array.push_back(-2);
+  s->f_bool_array.push_back(false);
+  s->f_bool_array.push_back(true);
+  s->f_enum_array.push_back(TEST_ENUM_VALUE_1);
+  s->f_struct_array.push_back(NestedStruct::New());
+  s->f_struct_array[0]->f_int32 = 7;
+  s->f_struct_array.push_back(nullptr);
+  s->f_array_array.push_back(Array<uint8_t>(3));
+  s->f_array_array[0][2] = 9;
+  s->f_union = TestUnion::New();
+  s->f_union->set_f_string("union");
+  s->f_map.insert("x", 10);
+  return s.Pass();
+}
+
+void CheckTestStructView(TestStructDataView view) {
+  ASSERT_FALSE(view.is_null());
+  EXPECT_EQ("hello", ToStdString(view.f_string()));
+  EXPECT_EQ(42, view.f_struct().f_int32());
+  EXPECT_EQ(TEST_ENUM_VALUE_1, view.f_enum());
+  EXPECT_TRUE(view.f_bool());
+  EXPECT_EQ(1.5, view.f_double());
+
+  ArrayDataView<StringDataView> string_array = view.f_string_array();
+  ASSERT_EQ(2u, string_array.size());
+  EXPECT_EQ("a", ToStdString(string_array[0]));
+  EXPECT_EQ("bc", string_array[1].ToString());
+
+  ArrayDataView<int32_t> int32_array = view.f_int32_array();
+  ASSERT_EQ(2u, int32_array.size());
+  EXPECT_EQ(1, int32_array[0]);
+  EXPECT_EQ(-2, int32_array[1]);
+
+  ArrayDataView<bool> bool_array = view.f_bool_array();
+  ASSERT_EQ(2u, bool_array.size());
+  EXPECT_FALSE(bool_array[0]);
+  EXPECT_TRUE(bool_array[1]);
+
+  ASSERT_EQ(1u, view.f_enum_array().size());
+  EXPECT_EQ(TEST_ENUM_VALUE_1, view.f_enum_array()[0]);
+
+  ArrayDataView<NestedStructDataView> struct_array = view.f_struct_array();
+  ASSERT_EQ(2u, struct_array.size());
+  EXPECT_EQ(7, struct_array[0].f_int32());
+  EXPECT_TRUE(struct_array[1].is_null());
+
+  ArrayDataView<ArrayDataView<uint8_t>> array_array = view.f_array_array();
+  ASSERT_EQ(1u, array_array.size());
+  ASSERT_EQ(3u, array_array[0].size());
+  EXPECT_EQ(0u, array_array[0][0]);
+  EXPECT_EQ(9u, array_array[0][2]);
+
+  TestUnionDataView union_view = view.f_union();
+  ASSERT_FALSE(union_view.is_null());
+  EXPECT_EQ(TestUnion::Tag::F_STRING, union_view.which());
+  EXPECT_TRUE(union_view.is_f_string());
+  EXPECT_EQ("union", ToStdString(union_view.get_f_string()));
+}
+
+TEST(DataViewTest, ReadInPlace) {
+  Environment env;
+  TestStructPtr s = MakeTestStruct();
+  mojo::internal::FixedBuffer buf(GetSerializedSize_(s));
+  internal::TestStruct_Data* data = nullptr;
+  Serialize_(s.Pass(), &buf, &data);
+
+  std::vector<Handle> handles;
+  data->EncodePointersAndHandles(&handles);
+  data->DecodePointersAndHandles(&handles);
+
+  TestStructDataView view(data);
+  CheckTestStructView(view);
+
+  // Views point into the serialized data.
+  EXPECT_EQ(data->f_string.ptr->storage(), view.f_string().data());
+
+  Map<String, int32_t> map;
+  view.ReadFMap(&map);
+  ASSERT_EQ(1u, map.size());
+  EXPECT_EQ(10, map.at("x"));
+}
+
+TEST(DataViewTest, NullFields) {
+  Environment env;
+  TestStructPtr s(TestStruct::New());
+  mojo::internal::FixedBuffer buf(GetSerializedSize_(s));
+  internal::TestStruct_Data* data = nullptr;
+  Serialize_(s.Pass(), &buf, &data);
+
+  TestStructDataView view(data);
+  EXPECT_TRUE(view.f_string().is_null());
+  EXPECT_EQ(0u, view.f_string().size());
+  EXPECT_TRUE(view.f_string().ToString().is_null());
+  EXPECT_TRUE(view.f_struct().is_null());
+  EXPECT_TRUE(view.f_int32_array().is_null());
+  EXPECT_EQ(0u, view.f_int32_array().size());
+  EXPECT_TRUE(view.f_union().is_null());
+  EXPECT_FALSE(view.TakeFMessagePipe().is_valid());
+
+  Map<String, int32_t> map;
+  view.ReadFMap(&map);
+  EXPECT_TRUE(map.is_null());
+}
+
+TEST(DataViewTest, TakeHandle) {
+  Environment env;
+  MessagePipe pipe;
+  MojoHandle raw_handle = pipe.handle0.get().value();
+  TestStructPtr s(TestStruct::New());
+  s->f_message_pipe = pipe.handle0.Pass();
+  mojo::internal::FixedBuffer buf(GetSerializedSize_(s));
+  internal::TestStruct_Data* data = nullptr;
+  Serialize_(s.Pass(), &buf, &data);
+
+  TestStructDataView view(data);
+  ScopedMessagePipeHandle handle = view.TakeFMessagePipe();
+  EXPECT_EQ(raw_handle, handle.get().value());
+  // The handle can only be taken once.
+  EXPECT_FALSE(view.TakeFMessagePipe().is_valid());
+}
+
+// Checks the parameters of |Echo()| and sends them back.
+class DataViewTestInterfaceImpl : public TestInterface {
+ public:
+  explicit DataViewTestInterfaceImpl(InterfaceRequest<TestInterface> request)
+      : binding_(this, request.Pass()), num_echo_calls_(0) {}
+  ~DataViewTestInterfaceImpl() override {}
+
+  int num_echo_calls() const { return num_echo_calls_; }
+
+  // |TestInterface| implementation:
+  void Echo(TestStructPtr s,
+            const String& str,
+            Array<int32_t> values,
+            ScopedMessagePipeHandle pipe,
+            Map<String, int32_t> counts,
+            const EchoCallback& callback) override {
+    num_echo_calls_++;
+    callback.Run(s.Pass(), str, values.Pass(), pipe.Pass(), counts.Pass());
+  }
+
+ private:
+  Binding<TestInterface> binding_;
+  int num_echo_calls_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(DataViewTestInterfaceImpl);
+};
+
+// Reads the parameters of |Echo()| in place.
+class DataViewTestInterfaceViewImpl : public DataViewTestInterfaceImpl {
+ public:
+  explicit DataViewTestInterfaceViewImpl(
+      InterfaceRequest<TestInterface> request)
+      : DataViewTestInterfaceImpl(request.Pass()), num_view_calls_(0) {}
+  ~DataViewTestInterfaceViewImpl() override {}
+
+  int num_view_calls() const { return num_view_calls_; }
+
+  // |TestInterface| implementation:
+  void EchoWithDataView(TestStructDataView s,
+                        StringDataView str,
+                        ArrayDataView<int32_t> values,
+                        ScopedMessagePipeHandle pipe,
+                        Map<String, int32_t> counts,
+                        const EchoCallback& callback) override {
+    num_view_calls_++;
+    CheckTestStructView(s);
+    Array<int32_t> values_copy(values.size());
+    for (size_t i = 0; i < values.size(); i++)
+      values_copy[i] = values[i];
+    callback.Run(MakeTestStruct(), str.ToString(), values_copy.Pass(),
+                 pipe.Pass(), counts.Pass());
+  }
+
+ private:
+  int num_view_calls_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(DataViewTestInterfaceViewImpl);
+};
+
+class DataViewInterfaceTest : public testing::Test {
+ public:
+  DataViewInterfaceTest() {}
+
+ protected:
+  // Calls |Echo()| on |ptr| with |num_values| values and checks the
+  // response.
+  void CallEcho(TestInterfacePtr* ptr, size_t num_values = 2) {
+    Array<int32_t> values(num_values);
+    for (size_t i = 0; i < num_values; i++)
+      values[i] = static_cast<int32_t>(i + 3);
+    MessagePipe pipe;
+    Map<String, int32_t> counts;
+    counts.insert("y", 5);
+
+    bool called = false;
+    (*ptr)->Echo(
+        MakeTestStruct(), "str", values.Pass(), pipe.handle0.Pass(),
+        counts.Pass(),
+        [&called, num_values](TestStructPtr s, const String& str,
+                              Array<int32_t> values,
+                              ScopedMessagePipeHandle pipe,
+                              Map<String, int32_t> counts) {
+          called = true;
+          EXPECT_TRUE(s->Equals(*MakeTestStruct()));
+          EXPECT_EQ("str", str);
+          ASSERT_EQ(num_values, values.size());
+          for (size_t i = 0; i < num_values; i++)
+            EXPECT_EQ(static_cast<int32_t>(i + 3), values[i]);
+          EXPECT_TRUE(pipe.is_valid());
+          EXPECT_EQ(5, counts.at("y"));
+        });
+    PumpMessages();
+    EXPECT_TRUE(called);
+  }
+
+  void PumpMessages() { loop_.RunUntilIdle(); }
+
+ private:
+  Environment env_;
+  RunLoop loop_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(DataViewInterfaceTest);
+};
+
+TEST_F(DataViewInterfaceTest, WithDataView) {
+  TestInterfacePtr ptr;
+  DataViewTestInterfaceViewImpl impl(GetProxy(&ptr));
+  CallEcho(&ptr);
+  EXPECT_EQ(1, impl.num_view_calls());
+  EXPECT_EQ(0, impl.num_echo_calls());
+}
+
+// Tests that handles survive when a request turns out to be bigger than the
+// proxy expects, and has to be serialized again.
+TEST_F(DataViewInterfaceTest, GrowingRequests) {
+  TestInterfacePtr ptr;
+  DataViewTestInterfaceImpl impl(GetProxy(&ptr));
+  CallEcho(&ptr, 1);
+  CallEcho(&ptr, 1000);
+  CallEcho(&ptr, 100000);
+  EXPECT_EQ(3, impl.num_echo_calls());
+}
+
+// By default, the parameters are deserialized and passed to |Echo()|.
+TEST_F(DataViewInterfaceTest, DefaultImplementation) {
+  TestInterfacePtr ptr;
+  DataViewTestInterfaceImpl impl(GetProxy(&ptr));
+  CallEcho(&ptr);
+  EXPECT_EQ(1, impl.num_echo_calls());
+}
+
+}  // namespace
+}  // namespace data_view
+}  // namespace test
+}  // namespace mojo
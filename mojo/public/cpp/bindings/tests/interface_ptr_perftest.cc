@@ -0,0 +1,108 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This tests the performance of sending bursts of method calls through an
+// |InterfacePtr|, one at a time and batched using |ScopedInterfacePtrBatch|.
+
+#include <stdio.h>
+
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/interface_ptr.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/test_support/test_support.h"
+#include "mojo/public/cpp/test_support/test_utils.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "mojo/public/interfaces/bindings/tests/test_unions.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+const MojoTimeTicks kPerftestTimeMicroseconds = 1000 * 1000;
+
+class SmallCacheImpl : public SmallCache {
+ public:
+  SmallCacheImpl() : int_value_(0) {}
+  ~SmallCacheImpl() override {}
+
+  int64_t int_value() const { return int_value_; }
+
+ private:
+  // |SmallCache| implementation:
+  void SetIntValue(int64_t int_value) override { int_value_ = int_value; }
+  void GetIntValue(const GetIntValueCallback& callback) override {
+    callback.Run(int_value_);
+  }
+
+  int64_t int_value_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(SmallCacheImpl);
+};
+
+class InterfacePtrPerftest : public testing::Test {
+ public:
+  InterfacePtrPerftest() : binding_(&impl_, GetProxy(&ptr_)) {}
+  ~InterfacePtrPerftest() override {}
+
+ protected:
+  // Makes |num_calls| calls, batched if |batched| is true, and then dispatches
+  // them.
+  void SendBurst(size_t num_calls, bool batched) {
+    if (batched) {
+      ScopedInterfacePtrBatch<SmallCache> batch(&ptr_);
+      for (size_t i = 0; i < num_calls; i++)
+        ptr_->SetIntValue(static_cast<int64_t>(i));
+    } else {
+      for (size_t i = 0; i < num_calls; i++)
+        ptr_->SetIntValue(static_cast<int64_t>(i));
+    }
+    for (size_t i = 0; i < num_calls; i++)
+      ASSERT_TRUE(binding_.WaitForIncomingMethodCall());
+    ASSERT_EQ(static_cast<int64_t>(num_calls - 1), impl_.int_value());
+  }
+
+  void Measure(size_t num_calls, bool batched) {
+    // Warm up.
+    SendBurst(num_calls, batched);
+
+    size_t num_bursts = 0;
+    MojoTimeTicks start_time = GetTimeTicksNow();
+    MojoTimeTicks end_time;
+    do {
+      SendBurst(num_calls, batched);
+      num_bursts++;
+      end_time = GetTimeTicksNow();
+    } while (end_time - start_time < kPerftestTimeMicroseconds);
+
+    char sub_test_name[64];
+    sprintf(sub_test_name, "%s_%u_calls", batched ? "batched" : "unbatched",
+            static_cast<unsigned>(num_calls));
+    double elapsed_ns = (end_time - start_time) * 1000.0;
+    LogPerfResult("InterfacePtr_CallBurst", sub_test_name,
+                  elapsed_ns / (num_bursts * num_calls), "ns/call");
+  }
+
+ private:
+  Environment env_;
+  RunLoop loop_;
+  SmallCacheImpl impl_;
+  SmallCachePtr ptr_;
+  Binding<SmallCache> binding_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(InterfacePtrPerftest);
+};
+
+TEST_F(InterfacePtrPerftest, CallBurst) {
+  const size_t kNumCalls[] = {1, 10, 100};
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kNumCalls); i++) {
+    Measure(kNumCalls[i], false);
+    Measure(kNumCalls[i], true);
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
@@ -229,6 +229,30 @@ TEST_F(InterfacePtrTest, EndToEnd_Synchronous) {
   EXPECT_EQ(10.0, calculator_ui.GetOutput());
 }
 
+TEST_F(InterfacePtrTest, ScopedBatch) {
+  math::CalculatorPtr calc;
+  MathCalculatorImpl calc_impl(GetProxy(&calc));
+
+  double output = 0.0;
+  auto callback = [&output](double value) { output = value; };
+  {
+    ScopedInterfacePtrBatch<math::Calculator> batch(&calc);
+    calc->Add(2.0, callback);
+    {
+      ScopedInterfacePtrBatch<math::Calculator> nested_batch(&calc);
+      calc->Multiply(5.0, callback);
+    }
+    calc->Add(1.0, callback);
+
+    // Nothing should have been sent yet.
+    PumpMessages();
+    EXPECT_EQ(0.0, output);
+  }
+
+  PumpMessages();
+  EXPECT_EQ(11.0, output);
+}
+
 TEST_F(InterfacePtrTest, Movable) {
   math::CalculatorPtr a;
   math::CalculatorPtr b;
@@ -0,0 +1,206 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/interface_ptr.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/system/message_pipe.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "mojo/public/interfaces/bindings/tests/test_local_dispatch.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+LocalDispatchPointPtr MakePoint(int32_t x, int32_t y) {
+  LocalDispatchPointPtr point(LocalDispatchPoint::New());
+  point->x = x;
+  point->y = y;
+  return point.Pass();
+}
+
+class PointRecorderImpl : public PointRecorder {
+ public:
+  PointRecorderImpl() {}
+  ~PointRecorderImpl() override {}
+
+  const Array<LocalDispatchPointPtr>& points() const { return points_; }
+  const String& label() const { return label_; }
+
+  // |PointRecorder| implementation:
+  void Record(Array<LocalDispatchPointPtr> points,
+              const String& label) override {
+    points_ = points.Pass();
+    label_ = label;
+  }
+  void Sum(Array<LocalDispatchPointPtr> points,
+           const SumCallback& callback) override {
+    LocalDispatchPointPtr sum(MakePoint(0, 0));
+    for (size_t i = 0; i < points.size(); i++) {
+      sum->x += points[i]->x;
+      sum->y += points[i]->y;
+    }
+    callback.Run(sum.Pass());
+  }
+  void RecordSerialized(Array<LocalDispatchPointPtr> points,
+                        const String& label) override {
+    Record(points.Pass(), label);
+  }
+
+ private:
+  Array<LocalDispatchPointPtr> points_;
+  String label_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(PointRecorderImpl);
+};
+
+class LocalDispatchTest : public testing::Test {
+ public:
+  LocalDispatchTest() {}
+  ~LocalDispatchTest() override {}
+
+ protected:
+  void PumpMessages() { loop_.RunUntilIdle(); }
+
+  // Records two points, and returns the first one (which is owned by the
+  // implementation once the call has been dispatched).
+  const LocalDispatchPoint* RecordPoints(PointRecorderPtr* ptr) {
+    Array<LocalDispatchPointPtr> points(2);
+    points[0] = MakePoint(1, 2);
+    points[1] = MakePoint(3, 4);
+    const LocalDispatchPoint* first = points[0].get();
+    (*ptr)->Record(points.Pass(), "hello");
+    return first;
+  }
+
+  void ExpectRecordedPoints() {
+    ASSERT_EQ(2u, impl_.points().size());
+    EXPECT_EQ(1, impl_.points()[0]->x);
+    EXPECT_EQ(2, impl_.points()[0]->y);
+    EXPECT_EQ(3, impl_.points()[1]->x);
+    EXPECT_EQ(4, impl_.points()[1]->y);
+    EXPECT_EQ("hello", impl_.label());
+  }
+
+  PointRecorderImpl impl_;
+
+ private:
+  Environment env_;
+  RunLoop loop_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(LocalDispatchTest);
+};
+
+TEST_F(LocalDispatchTest, Unserialized) {
+  PointRecorderPtr ptr;
+  Binding<PointRecorder> binding(&impl_, GetProxy(&ptr));
+  // Nothing has been read from the pipe yet, so the first call is serialized.
+  const LocalDispatchPoint* first = RecordPoints(&ptr);
+  PumpMessages();
+  ExpectRecordedPoints();
+  EXPECT_NE(first, impl_.points()[0].get());
+
+  // The implementation should get the very same objects.
+  first = RecordPoints(&ptr);
+  PumpMessages();
+  ExpectRecordedPoints();
+  EXPECT_EQ(first, impl_.points()[0].get());
+
+  // ... unless the method doesn't have the [LocalDispatch=1] attribute.
+  Array<LocalDispatchPointPtr> points(1);
+  points[0] = MakePoint(5, 6);
+  first = points[0].get();
+  ptr->RecordSerialized(points.Pass(), "world");
+  PumpMessages();
+  ASSERT_EQ(1u, impl_.points().size());
+  EXPECT_NE(first, impl_.points()[0].get());
+  EXPECT_EQ(5, impl_.points()[0]->x);
+  EXPECT_EQ("world", impl_.label());
+
+  // Methods with responses work too.
+  Array<LocalDispatchPointPtr> to_sum(3);
+  for (size_t i = 0; i < to_sum.size(); i++)
+    to_sum[i] = MakePoint(static_cast<int32_t>(i), 10);
+  LocalDispatchPointPtr sum;
+  ptr->Sum(to_sum.Pass(),
+           [&sum](LocalDispatchPointPtr result) { sum = result.Pass(); });
+  PumpMessages();
+  ASSERT_TRUE(sum);
+  EXPECT_EQ(3, sum->x);
+  EXPECT_EQ(30, sum->y);
+}
+
+// Calls made in a batch are always serialized.
+TEST_F(LocalDispatchTest, Batched) {
+  PointRecorderPtr ptr;
+  Binding<PointRecorder> binding(&impl_, GetProxy(&ptr));
+  RecordPoints(&ptr);
+  PumpMessages();
+
+  const LocalDispatchPoint* first;
+  {
+    ScopedInterfacePtrBatch<PointRecorder> batch(&ptr);
+    first = RecordPoints(&ptr);
+  }
+  PumpMessages();
+  ExpectRecordedPoints();
+  EXPECT_NE(first, impl_.points()[0].get());
+}
+
+// Calls that are still queued when the pipe is passed elsewhere are serialized
+// (by the system) then.
+TEST_F(LocalDispatchTest, PipeTransferred) {
+  PointRecorderPtr ptr;
+  Binding<PointRecorder> binding(&impl_, GetProxy(&ptr));
+  RecordPoints(&ptr);
+  PumpMessages();
+
+  RecordPoints(&ptr);
+  InterfaceRequest<PointRecorder> request = binding.Unbind();
+
+  // Send the request over another message pipe, and get it back.
+  MessagePipe pipe;
+  MojoHandle handle = request.PassMessagePipe().release().value();
+  ASSERT_EQ(MOJO_RESULT_OK,
+            WriteMessageRaw(pipe.handle0.get(), nullptr, 0, &handle, 1,
+                            MOJO_WRITE_MESSAGE_FLAG_NONE));
+  uint32_t num_handles = 1;
+  ASSERT_EQ(MOJO_RESULT_OK,
+            ReadMessageRaw(pipe.handle1.get(), nullptr, nullptr, &handle,
+                           &num_handles, MOJO_READ_MESSAGE_FLAG_NONE));
+  ASSERT_EQ(1u, num_handles);
+
+  PointRecorderImpl other_impl;
+  Binding<PointRecorder> other_binding(
+      &other_impl,
+      MakeRequest<PointRecorder>(
+          ScopedMessagePipeHandle(MessagePipeHandle(handle))));
+  PumpMessages();
+  ASSERT_EQ(2u, other_impl.points().size());
+  EXPECT_EQ(1, other_impl.points()[0]->x);
+  EXPECT_EQ(4, other_impl.points()[1]->y);
+  EXPECT_EQ("hello", other_impl.label());
+}
+
+// Calls made after the other end is closed are dropped.
+TEST_F(LocalDispatchTest, PeerClosed) {
+  PointRecorderPtr ptr;
+  {
+    Binding<PointRecorder> binding(&impl_, GetProxy(&ptr));
+    RecordPoints(&ptr);
+    PumpMessages();
+  }
+  bool error_handler_called = false;
+  ptr.set_connection_error_handler(
+      [&error_handler_called]() { error_handler_called = true; });
+  RecordPoints(&ptr);
+  PumpMessages();
+  EXPECT_TRUE(error_handler_called);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
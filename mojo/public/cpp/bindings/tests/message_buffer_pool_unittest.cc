@@ -0,0 +1,140 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include "mojo/public/cpp/bindings/lib/connector.h"
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
+#include "mojo/public/cpp/bindings/lib/message_builder.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+using internal::MessageBufferPool;
+
+TEST(MessageBufferPoolTest, Reuse) {
+  void* buffer = MessageBufferPool::Allocate(100);
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ(0, reinterpret_cast<ptrdiff_t>(buffer) % 8);
+  memset(buffer, 1, 100);
+  MessageBufferPool::Free(buffer);
+
+  // Buffers of similar sizes should be reused, without touching the heap.
+  MessageBufferPool::ResetThreadStats();
+  void* buffer2 = MessageBufferPool::Allocate(90);
+  EXPECT_EQ(buffer, buffer2);
+  MessageBufferPool::Free(buffer2);
+
+  MessageBufferPool::Stats stats = MessageBufferPool::GetThreadStats();
+  EXPECT_EQ(1u, stats.num_allocations);
+  EXPECT_EQ(1u, stats.num_frees);
+  EXPECT_EQ(0u, stats.num_heap_allocations);
+  EXPECT_EQ(0u, stats.num_heap_frees);
+}
+
+TEST(MessageBufferPoolTest, LargeBuffersAreNotCached) {
+  const size_t kSize = 1024 * 1024;
+
+  MessageBufferPool::ResetThreadStats();
+  for (int i = 0; i < 2; i++) {
+    void* buffer = MessageBufferPool::Allocate(kSize);
+    ASSERT_TRUE(buffer);
+    EXPECT_EQ(0, reinterpret_cast<ptrdiff_t>(buffer) % 8);
+    memset(buffer, 1, kSize);
+    MessageBufferPool::Free(buffer);
+  }
+
+  MessageBufferPool::Stats stats = MessageBufferPool::GetThreadStats();
+  EXPECT_EQ(2u, stats.num_allocations);
+  EXPECT_EQ(2u, stats.num_frees);
+  EXPECT_EQ(2u, stats.num_heap_allocations);
+  EXPECT_EQ(2u, stats.num_heap_frees);
+}
+
+TEST(MessageBufferPoolTest, FreeNull) {
+  MessageBufferPool::ResetThreadStats();
+  MessageBufferPool::Free(nullptr);
+  EXPECT_EQ(0u, MessageBufferPool::GetThreadStats().num_frees);
+}
+
+class NullMessageReceiver : public MessageReceiver {
+ public:
+  NullMessageReceiver() {}
+
+  bool Accept(Message* message) override { return true; }
+
+ private:
+  MOJO_DISALLOW_COPY_AND_ASSIGN(NullMessageReceiver);
+};
+
+class MessageBufferPoolConnectorTest : public testing::Test {
+ public:
+  MessageBufferPoolConnectorTest() {}
+
+  void SetUp() override { CreateMessagePipe(nullptr, &handle0_, &handle1_); }
+
+ protected:
+  // Sends a message with a |payload_size|-byte payload over |sender| and
+  // dispatches it on |receiver|.
+  void SendAndReceive(size_t payload_size,
+                      internal::Connector* sender,
+                      internal::Connector* receiver) {
+    Message message;
+    {
+      internal::MessageBuilder builder(1, payload_size);
+      memset(builder.buffer()->Allocate(payload_size), 'x', payload_size);
+      builder.Finish(&message);
+    }
+    ASSERT_TRUE(sender->Accept(&message));
+    ASSERT_TRUE(receiver->WaitForIncomingMessage(MOJO_DEADLINE_INDEFINITE));
+  }
+
+  ScopedMessagePipeHandle handle0_;
+  ScopedMessagePipeHandle handle1_;
+
+ private:
+  Environment env_;
+  RunLoop loop_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(MessageBufferPoolConnectorTest);
+};
+
+// Tests that in the steady state, sending and receiving messages doesn't
+// allocate message buffers from the heap.
+TEST_F(MessageBufferPoolConnectorTest, SteadyState) {
+  const size_t kPayloadSizes[] = {8, 100, 1000, 10000};
+  const size_t kNumMessages = 100;
+
+  internal::Connector connector0(handle0_.Pass());
+  internal::Connector connector1(handle1_.Pass());
+  NullMessageReceiver receiver;
+  connector1.set_incoming_receiver(&receiver);
+
+  // Warm up.
+  for (size_t payload_size : kPayloadSizes)
+    SendAndReceive(payload_size, &connector0, &connector1);
+
+  MessageBufferPool::ResetThreadStats();
+  for (size_t i = 0; i < kNumMessages; i++) {
+    SendAndReceive(kPayloadSizes[i % MOJO_ARRAYSIZE(kPayloadSizes)],
+                   &connector0, &connector1);
+  }
+
+  // Each message is allocated (and freed) once when it's built and once when
+  // it's read.
+  MessageBufferPool::Stats stats = MessageBufferPool::GetThreadStats();
+  EXPECT_EQ(2 * kNumMessages, stats.num_allocations);
+  EXPECT_EQ(2 * kNumMessages, stats.num_frees);
+  EXPECT_EQ(0u, stats.num_heap_allocations);
+  EXPECT_EQ(0u, stats.num_heap_frees);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string>
+
 #include "mojo/public/cpp/environment/environment.h"
 #include "mojo/public/cpp/test_support/test_utils.h"
 #include "mojo/public/cpp/utility/run_loop.h"
@@ -118,6 +120,25 @@ TEST_F(RequestResponseTest, EchoStrings) {
   EXPECT_EQ(std::string("hello world"), buf);
 }
 
+// Tests requests that are bigger than the proxy expects (from the sizes of
+// earlier ones), as well as ones that are smaller.
+TEST_F(RequestResponseTest, EchoStringsOfChangingSizes) {
+  sample::ProviderPtr provider;
+  ProviderImpl provider_impl(GetProxy(&provider));
+
+  const size_t kSizes[] = {1, 10, 100, 10000, 1, 100000, 10};
+  for (size_t size : kSizes) {
+    std::string a(size, 'a');
+    std::string b(size / 2, 'b');
+    std::string buf;
+    provider->EchoStrings(String(a), String(b), StringRecorder(&buf));
+
+    PumpMessages();
+
+    EXPECT_EQ(a + b, buf);
+  }
+}
+
 TEST_F(RequestResponseTest, EchoMessagePipeHandle) {
   sample::ProviderPtr provider;
   ProviderImpl provider_impl(GetProxy(&provider));
@@ -0,0 +1,129 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <map>
+
+#include "mojo/public/cpp/bindings/lib/responder_table.h"
+#include "mojo/public/cpp/bindings/message.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+using internal::ResponderTable;
+
+// Counts how many instances are alive.
+class CountedResponder : public MessageReceiver {
+ public:
+  explicit CountedResponder(int* num_alive) : num_alive_(num_alive) {
+    (*num_alive_)++;
+  }
+  ~CountedResponder() override { (*num_alive_)--; }
+
+  // |MessageReceiver| implementation:
+  bool Accept(Message* message) override { return true; }
+
+ private:
+  int* const num_alive_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(CountedResponder);
+};
+
+TEST(ResponderTableTest, InsertAndRemove) {
+  int num_alive = 0;
+  ResponderTable table;
+  EXPECT_TRUE(table.empty());
+  EXPECT_FALSE(table.Remove(1));
+
+  MessageReceiver* responder1 = new CountedResponder(&num_alive);
+  MessageReceiver* responder2 = new CountedResponder(&num_alive);
+  table.Insert(1, responder1);
+  table.Insert(2, responder2);
+  EXPECT_EQ(2u, table.size());
+
+  EXPECT_FALSE(table.Remove(3));
+  EXPECT_FALSE(table.Remove(0));
+  EXPECT_EQ(responder2, table.Remove(2));
+  EXPECT_FALSE(table.Remove(2));
+  EXPECT_EQ(responder1, table.Remove(1));
+  EXPECT_TRUE(table.empty());
+
+  // Removing passes ownership to the caller.
+  EXPECT_EQ(2, num_alive);
+  delete responder1;
+  delete responder2;
+}
+
+TEST(ResponderTableTest, DeletesResponders) {
+  int num_alive = 0;
+  {
+    ResponderTable table;
+    for (uint64_t i = 1; i <= 100; i++)
+      table.Insert(i, new CountedResponder(&num_alive));
+    EXPECT_EQ(100, num_alive);
+
+    table.Clear();
+    EXPECT_EQ(0, num_alive);
+    EXPECT_TRUE(table.empty());
+
+    for (uint64_t i = 1; i <= 100; i++)
+      table.Insert(i, new CountedResponder(&num_alive));
+  }
+  EXPECT_EQ(0, num_alive);
+}
+
+// Checks the table against a |std::map| while inserting and removing in
+// patterns that cause collisions (and wrap around the end of the table).
+TEST(ResponderTableTest, Collisions) {
+  int num_alive = 0;
+  ResponderTable table;
+  std::map<uint64_t, MessageReceiver*> expected;
+
+  // IDs that are multiples of a large power of 2 all want the same slot.
+  for (uint64_t i = 1; i <= 40; i++) {
+    uint64_t request_id = i << 20;
+    MessageReceiver* responder = new CountedResponder(&num_alive);
+    table.Insert(request_id, responder);
+    expected[request_id] = responder;
+  }
+  // Sequential IDs, some of which collide with the ones above.
+  for (uint64_t request_id = 1; request_id <= 200; request_id++) {
+    MessageReceiver* responder = new CountedResponder(&num_alive);
+    table.Insert(request_id, responder);
+    expected[request_id] = responder;
+  }
+  EXPECT_EQ(expected.size(), table.size());
+
+  // Remove every third entry, then check that the rest can all be found.
+  size_t i = 0;
+  for (auto it = expected.begin(); it != expected.end(); i++) {
+    if (i % 3 == 0) {
+      MessageReceiver* responder = table.Remove(it->first);
+      EXPECT_EQ(it->second, responder);
+      delete responder;
+      expected.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  EXPECT_EQ(expected.size(), table.size());
+  EXPECT_EQ(static_cast<int>(expected.size()), num_alive);
+
+  for (auto it = expected.rbegin(); it != expected.rend(); ++it) {
+    MessageReceiver* responder = table.Remove(it->first);
+    EXPECT_EQ(it->second, responder);
+    EXPECT_FALSE(table.Remove(it->first));
+    delete responder;
+  }
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(0, num_alive);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
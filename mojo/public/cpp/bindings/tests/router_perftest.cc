@@ -0,0 +1,143 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This tests the performance of pipelined requests (and their responses)
+// through |Router|s, with varying numbers of requests outstanding.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mojo/public/cpp/bindings/lib/message_builder.h"
+#include "mojo/public/cpp/bindings/lib/router.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/test_support/test_support.h"
+#include "mojo/public/cpp/test_support/test_utils.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+const MojoTimeTicks kPerftestTimeMicroseconds = 1000 * 1000;
+const size_t kPayloadSize = 16;
+
+// Responds to each request immediately, with an empty response.
+class Responder : public MessageReceiverWithResponderStatus {
+ public:
+  Responder() {}
+  ~Responder() override {}
+
+  // |MessageReceiverWithResponderStatus| implementation:
+  bool Accept(Message* message) override { return false; }
+  bool AcceptWithResponder(Message* message,
+                           MessageReceiverWithStatus* responder) override {
+    Message response;
+    internal::ResponseMessageBuilder builder(message->name(), 0,
+                                             message->request_id());
+    builder.Finish(&response);
+    bool result = responder->Accept(&response);
+    delete responder;
+    return result;
+  }
+
+ private:
+  MOJO_DISALLOW_COPY_AND_ASSIGN(Responder);
+};
+
+// Counts the responses to requests. (One of these is created for each
+// request, like the responders for generated interfaces.)
+class ResponseCounter : public MessageReceiver {
+ public:
+  explicit ResponseCounter(size_t* num_responses)
+      : num_responses_(num_responses) {}
+  ~ResponseCounter() override {}
+
+  // |MessageReceiver| implementation:
+  bool Accept(Message* message) override {
+    (*num_responses_)++;
+    return true;
+  }
+
+ private:
+  size_t* const num_responses_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(ResponseCounter);
+};
+
+class RouterPerftest : public testing::Test {
+ public:
+  RouterPerftest()
+      : client_(pipe_.handle0.Pass(), internal::FilterChain()),
+        service_(pipe_.handle1.Pass(), internal::FilterChain()) {
+    service_.set_incoming_receiver(&responder_);
+  }
+  ~RouterPerftest() override {}
+
+ protected:
+  // Sends |num_requests| requests, and only then processes them and their
+  // responses, so that |num_requests| requests are outstanding at once.
+  void SendPipelinedRequests(size_t num_requests) {
+    size_t num_responses = 0;
+    for (size_t i = 0; i < num_requests; i++) {
+      Message request;
+      internal::RequestMessageBuilder builder(1, kPayloadSize);
+      memset(builder.buffer()->Allocate(kPayloadSize), 'x', kPayloadSize);
+      builder.Finish(&request);
+      ASSERT_TRUE(client_.AcceptWithResponder(
+          &request, new ResponseCounter(&num_responses)));
+    }
+    for (size_t i = 0; i < num_requests; i++)
+      ASSERT_TRUE(service_.WaitForIncomingMessage(MOJO_DEADLINE_INDEFINITE));
+    for (size_t i = 0; i < num_requests; i++)
+      ASSERT_TRUE(client_.WaitForIncomingMessage(MOJO_DEADLINE_INDEFINITE));
+    ASSERT_EQ(num_requests, num_responses);
+  }
+
+  void Measure(size_t num_outstanding) {
+    // Warm up.
+    SendPipelinedRequests(num_outstanding);
+
+    size_t num_batches = 0;
+    MojoTimeTicks start_time = GetTimeTicksNow();
+    MojoTimeTicks end_time;
+    do {
+      SendPipelinedRequests(num_outstanding);
+      num_batches++;
+      end_time = GetTimeTicksNow();
+    } while (end_time - start_time < kPerftestTimeMicroseconds);
+
+    char sub_test_name[64];
+    sprintf(sub_test_name, "%u_outstanding",
+            static_cast<unsigned>(num_outstanding));
+    double elapsed_ns = (end_time - start_time) * 1000.0;
+    LogPerfResult("Router_PipelinedRequests", sub_test_name,
+                  elapsed_ns / (num_batches * num_outstanding), "ns/request");
+    // The time from sending the first request of a batch to receiving the
+    // last response.
+    LogPerfResult("Router_PipelinedRequests_BatchLatency", sub_test_name,
+                  elapsed_ns / num_batches / 1000.0, "microseconds");
+  }
+
+ private:
+  Environment env_;
+  RunLoop loop_;
+  MessagePipe pipe_;
+  Responder responder_;
+  internal::Router client_;
+  internal::Router service_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(RouterPerftest);
+};
+
+TEST_F(RouterPerftest, PipelinedRequests) {
+  Measure(1);
+  Measure(100);
+  Measure(10000);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
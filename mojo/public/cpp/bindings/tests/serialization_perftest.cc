@@ -0,0 +1,251 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This tests the performance of building request messages from mojom structs,
+// arrays, maps and unions of various sizes.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "mojo/public/cpp/bindings/message.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/environment/logging.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/test_support/test_support.h"
+#include "mojo/public/cpp/test_support/test_utils.h"
+#include "mojo/public/interfaces/bindings/tests/serialization_perf_test.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace serialization_perf {
+namespace {
+
+const MojoTimeTicks kPerftestTimeMicroseconds = 250 * 1000;
+
+// Records the size of the messages that it's given, and drops them.
+class MessageSink : public MessageReceiverWithResponder {
+ public:
+  MessageSink() : message_num_bytes_(0) {}
+  ~MessageSink() override {}
+
+  uint32_t message_num_bytes() const { return message_num_bytes_; }
+
+  // |MessageReceiverWithResponder| implementation:
+  bool Accept(Message* message) override {
+    message_num_bytes_ = message->data_num_bytes();
+    return true;
+  }
+  bool AcceptWithResponder(Message* message,
+                           MessageReceiver* responder) override {
+    MOJO_CHECK(false);
+    return false;
+  }
+
+ private:
+  uint32_t message_num_bytes_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(MessageSink);
+};
+
+enum RecordShape {
+  RECORD_SHAPE_POINTS,  // |array<Point>|.
+  RECORD_SHAPE_ROWS,    // |array<array<int32>>|.
+  RECORD_SHAPE_COUNTS,  // |map<string, int32>|.
+  RECORD_SHAPE_VALUES,  // |array<Value>|.
+};
+
+const char* GetRecordShapeName(RecordShape shape) {
+  switch (shape) {
+    case RECORD_SHAPE_POINTS:
+      return "Points";
+    case RECORD_SHAPE_ROWS:
+      return "Rows";
+    case RECORD_SHAPE_COUNTS:
+      return "Counts";
+    case RECORD_SHAPE_VALUES:
+      return "Values";
+  }
+  MOJO_CHECK(false);
+  return nullptr;
+}
+
+PointPtr MakePoint(size_t i) {
+  PointPtr point(Point::New());
+  point->x = static_cast<int32_t>(i);
+  point->y = -static_cast<int32_t>(i);
+  point->weight = 0.5f;
+  return point.Pass();
+}
+
+// Makes a |Record| whose field for |shape| has |num_elements| elements (and
+// whose other fields are null).
+RecordPtr MakeRecord(RecordShape shape, size_t num_elements) {
+  RecordPtr record(Record::New());
+  record->name = "record";
+  switch (shape) {
+    case RECORD_SHAPE_POINTS:
+      record->points = Array<PointPtr>::New(num_elements);
+      for (size_t i = 0; i < num_elements; i++)
+        record->points[i] = MakePoint(i);
+      break;
+    case RECORD_SHAPE_ROWS:
+      // Rows of 1, 2, ..., 8 elements.
+      record->rows = Array<Array<int32_t>>::New(num_elements);
+      for (size_t i = 0; i < num_elements; i++) {
+        record->rows[i] = Array<int32_t>::New(i % 8 + 1);
+        for (size_t j = 0; j < record->rows[i].size(); j++)
+          record->rows[i][j] = static_cast<int32_t>(i + j);
+      }
+      break;
+    case RECORD_SHAPE_COUNTS:
+      record->counts = Map<String, int32_t>();
+      for (size_t i = 0; i < num_elements; i++) {
+        char key[32];
+        sprintf(key, "key%u", static_cast<unsigned>(i));
+        record->counts.insert(key, static_cast<int32_t>(i));
+      }
+      break;
+    case RECORD_SHAPE_VALUES:
+      record->values = Array<ValuePtr>::New(num_elements);
+      for (size_t i = 0; i < num_elements; i++) {
+        record->values[i] = Value::New();
+        switch (i % 3) {
+          case 0:
+            record->values[i]->set_int_value(static_cast<int64_t>(i));
+            break;
+          case 1:
+            record->values[i]->set_string_value("value");
+            break;
+          case 2:
+            record->values[i]->set_point_value(MakePoint(i));
+            break;
+        }
+      }
+      break;
+  }
+  return record.Pass();
+}
+
+class SerializationPerftest : public testing::Test {
+ public:
+  SerializationPerftest() {}
+  ~SerializationPerftest() override {}
+
+ protected:
+  // Measures building |Put()| requests for copies of |record| for a while.
+  // If |reuse_proxy| is true, all the requests are built by one proxy, which
+  // (after the first request) estimates their size instead of computing it
+  // exactly. Otherwise, each request is built by a new proxy, which doesn't
+  // have an estimate: this is the same as building messages in two passes,
+  // first computing the exact size and then serializing.
+  void Measure(RecordShape shape, size_t num_elements, bool reuse_proxy) {
+    RecordPtr record = MakeRecord(shape, num_elements);
+    MessageSink sink;
+    RecordSinkProxy reused_proxy(&sink);
+
+    // Copies of |record| are made before the clock is started, in batches of
+    // up to about 1 MB.
+    reused_proxy.Put(record.Clone());
+    const size_t batch_size =
+        std::max<size_t>(16, (1024 * 1024) / sink.message_num_bytes());
+    std::vector<RecordPtr> batch(batch_size);
+
+    MojoTimeTicks elapsed = 0;
+    size_t num_messages = 0;
+    while (elapsed < kPerftestTimeMicroseconds) {
+      for (size_t i = 0; i < batch_size; i++)
+        batch[i] = record.Clone();
+
+      MojoTimeTicks start_time = GetTimeTicksNow();
+      if (reuse_proxy) {
+        for (size_t i = 0; i < batch_size; i++)
+          reused_proxy.Put(batch[i].Pass());
+      } else {
+        for (size_t i = 0; i < batch_size; i++)
+          RecordSinkProxy(&sink).Put(batch[i].Pass());
+      }
+      elapsed += GetTimeTicksNow() - start_time;
+      num_messages += batch_size;
+    }
+
+    const char* test_name =
+        reuse_proxy ? "Serialization_SinglePass" : "Serialization_TwoPass";
+    char sub_test_name[64];
+    sprintf(sub_test_name, "%s_%u", GetRecordShapeName(shape),
+            static_cast<unsigned>(num_elements));
+    double seconds = elapsed / 1000000.0;
+    LogPerfResult(test_name, sub_test_name, seconds * 1e9 / num_messages,
+                  "ns/message");
+    LogPerfResult(test_name, sub_test_name,
+                  sink.message_num_bytes() * num_messages / seconds,
+                  "bytes/second");
+  }
+
+  void MeasureAllSizes(RecordShape shape) {
+    const size_t kNumElements[] = {1, 16, 256, 4096};
+    for (size_t num_elements : kNumElements) {
+      Measure(shape, num_elements, false);
+      Measure(shape, num_elements, true);
+    }
+  }
+
+ private:
+  Environment env_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(SerializationPerftest);
+};
+
+TEST_F(SerializationPerftest, Points) {
+  MeasureAllSizes(RECORD_SHAPE_POINTS);
+}
+
+TEST_F(SerializationPerftest, Rows) {
+  MeasureAllSizes(RECORD_SHAPE_ROWS);
+}
+
+TEST_F(SerializationPerftest, Counts) {
+  MeasureAllSizes(RECORD_SHAPE_COUNTS);
+}
+
+TEST_F(SerializationPerftest, Values) {
+  MeasureAllSizes(RECORD_SHAPE_VALUES);
+}
+
+// Measures the cost of a request that's bigger than the proxy expects, in
+// which case the proxy has to serialize it again.
+TEST_F(SerializationPerftest, Growing) {
+  MessageSink sink;
+  const size_t kNumElements = 256;
+  const size_t kBatchSize = 1000;
+  std::vector<RecordPtr> batch(kBatchSize);
+  for (size_t i = 0; i < kBatchSize; i++)
+    batch[i] = MakeRecord(RECORD_SHAPE_POINTS, kNumElements);
+  RecordPtr small_record = MakeRecord(RECORD_SHAPE_POINTS, 1);
+
+  // New proxies, which have only seen small requests.
+  std::vector<RecordSinkProxy*> proxies(kBatchSize);
+  for (size_t i = 0; i < kBatchSize; i++) {
+    proxies[i] = new RecordSinkProxy(&sink);
+    proxies[i]->Put(small_record.Clone());
+  }
+
+  MojoTimeTicks start_time = GetTimeTicksNow();
+  for (size_t i = 0; i < kBatchSize; i++)
+    proxies[i]->Put(batch[i].Pass());
+  MojoTimeTicks elapsed = GetTimeTicksNow() - start_time;
+
+  for (size_t i = 0; i < kBatchSize; i++)
+    delete proxies[i];
+
+  LogPerfResult("Serialization_Growing", "Points_256",
+                elapsed * 1000.0 / kBatchSize, "ns/message");
+}
+
+}  // namespace
+}  // namespace serialization_perf
+}  // namespace test
+}  // namespace mojo
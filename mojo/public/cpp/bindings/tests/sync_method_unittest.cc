@@ -0,0 +1,159 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/interface_ptr.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "mojo/public/cpp/utility/thread.h"
+#include "mojo/public/interfaces/bindings/tests/test_sync_methods.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+class PingServiceImpl : public PingService {
+ public:
+  PingServiceImpl() {}
+  ~PingServiceImpl() override {}
+
+  // |PingService| implementation:
+  void Ping(int32_t value, const PingCallback& callback) override {
+    callback.Run(value);
+  }
+  void SyncPing(int32_t value, const SyncPingCallback& callback) override {
+    callback.Run(value);
+  }
+
+ private:
+  MOJO_DISALLOW_COPY_AND_ASSIGN(PingServiceImpl);
+};
+
+// Serves a |PingService| on its own thread (since a sync call would never
+// return if the implementation ran on the calling thread), until the other
+// end of the pipe is closed.
+class PingServiceThread : public Thread {
+ public:
+  explicit PingServiceThread(InterfaceRequest<PingService> request)
+      : request_(request.Pass()) {}
+  ~PingServiceThread() override {}
+
+  void Run() override {
+    RunLoop run_loop;
+    PingServiceImpl impl;
+    Binding<PingService> binding(&impl, request_.Pass());
+    while (binding.WaitForIncomingMethodCall()) {
+    }
+  }
+
+ private:
+  InterfaceRequest<PingService> request_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(PingServiceThread);
+};
+
+class SyncMethodTest : public testing::Test {
+ public:
+  SyncMethodTest() : service_thread_(GetProxy(&ptr_)) {
+    service_thread_.Start();
+  }
+  ~SyncMethodTest() override {
+    ptr_.reset();
+    service_thread_.Join();
+  }
+
+ protected:
+  void PumpMessages() { loop_.RunUntilIdle(); }
+
+  PingServicePtr ptr_;
+
+ private:
+  Environment env_;
+  RunLoop loop_;
+  PingServiceThread service_thread_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(SyncMethodTest);
+};
+
+TEST_F(SyncMethodTest, Basic) {
+  int32_t value = 0;
+  ptr_->SyncPing(123, [&value](int32_t v) { value = v; });
+  EXPECT_EQ(123, value);
+
+  ptr_->SyncPing(456, [&value](int32_t v) { value = v; });
+  EXPECT_EQ(456, value);
+}
+
+// Other messages received while waiting for the response to a sync call should
+// be dispatched later, from the message loop.
+TEST_F(SyncMethodTest, QueuesOtherMessages) {
+  int32_t async_value = 0;
+  int32_t sync_value = 0;
+  ptr_->Ping(1, [&async_value](int32_t v) { async_value = v; });
+  ptr_->SyncPing(2, [&sync_value](int32_t v) { sync_value = v; });
+  EXPECT_EQ(2, sync_value);
+  EXPECT_EQ(0, async_value);
+
+  PumpMessages();
+  EXPECT_EQ(1, async_value);
+
+  // Queued messages shouldn't be reordered with later ones.
+  std::vector<int32_t> values;
+  ptr_->Ping(3, [&values](int32_t v) { values.push_back(v); });
+  ptr_->Ping(4, [&values](int32_t v) { values.push_back(v); });
+  ptr_->SyncPing(5, [&sync_value](int32_t v) { sync_value = v; });
+  ptr_->Ping(6, [&values](int32_t v) { values.push_back(v); });
+  EXPECT_EQ(5, sync_value);
+  EXPECT_TRUE(values.empty());
+  while (values.size() < 3u)
+    ASSERT_TRUE(ptr_.WaitForIncomingResponse());
+  ASSERT_EQ(3u, values.size());
+  EXPECT_EQ(3, values[0]);
+  EXPECT_EQ(4, values[1]);
+  EXPECT_EQ(6, values[2]);
+}
+
+// Calls made in a batch should be written before waiting for the response.
+TEST_F(SyncMethodTest, InBatch) {
+  int32_t async_value = 0;
+  int32_t sync_value = 0;
+  {
+    ScopedInterfacePtrBatch<PingService> batch(&ptr_);
+    ptr_->Ping(1, [&async_value](int32_t v) { async_value = v; });
+    ptr_->SyncPing(2, [&sync_value](int32_t v) { sync_value = v; });
+    EXPECT_EQ(2, sync_value);
+  }
+
+  PumpMessages();
+  EXPECT_EQ(1, async_value);
+}
+
+TEST(SyncMethodPeerClosedTest, PeerClosed) {
+  Environment env;
+  RunLoop loop;
+
+  PingServicePtr ptr;
+  // Close the other end right away.
+  GetProxy(&ptr);
+  bool error_handler_called = false;
+  ptr.set_connection_error_handler(
+      [&error_handler_called]() { error_handler_called = true; });
+
+  bool callback_called = false;
+  ptr->SyncPing(123, [&callback_called](int32_t v) { callback_called = true; });
+  EXPECT_FALSE(callback_called);
+
+  loop.RunUntilIdle();
+  EXPECT_FALSE(callback_called);
+  EXPECT_TRUE(error_handler_called);
+  EXPECT_TRUE(ptr.encountered_error());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
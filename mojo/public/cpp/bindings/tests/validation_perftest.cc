@@ -0,0 +1,258 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This tests the performance of validating incoming messages: both the
+// messages used by the validation tests, and large messages built from
+// arrays of handles, arrays of arrays and arrays of strings.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "mojo/public/cpp/bindings/lib/filter_chain.h"
+#include "mojo/public/cpp/bindings/lib/message_header_validator.h"
+#include "mojo/public/cpp/bindings/lib/validation_errors.h"
+#include "mojo/public/cpp/bindings/message.h"
+#include "mojo/public/cpp/bindings/tests/validation_test_input_parser.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/environment/logging.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/test_support/test_support.h"
+#include "mojo/public/cpp/test_support/test_utils.h"
+#include "mojo/public/interfaces/bindings/tests/validation_test_interfaces.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+using mojo::internal::FilterChain;
+using mojo::internal::MessageHeaderValidator;
+using mojo::internal::ValidationErrorObserverForTesting;
+
+const MojoTimeTicks kPerftestTimeMicroseconds = 500 * 1000;
+
+class DummyMessageReceiver : public MessageReceiver {
+ public:
+  DummyMessageReceiver() {}
+
+  bool Accept(Message* message) override { return true; }
+
+ private:
+  MOJO_DISALLOW_COPY_AND_ASSIGN(DummyMessageReceiver);
+};
+
+// Keeps the last message that it's given.
+class MessageCapturer : public MessageReceiverWithResponder {
+ public:
+  MessageCapturer() {}
+  ~MessageCapturer() override {}
+
+  Message* message() { return &message_; }
+
+  // |MessageReceiverWithResponder| implementation:
+  bool Accept(Message* message) override {
+    message_.Swap(message);
+    return true;
+  }
+  bool AcceptWithResponder(Message* message,
+                           MessageReceiver* responder) override {
+    MOJO_CHECK(false);
+    return false;
+  }
+
+ private:
+  Message message_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(MessageCapturer);
+};
+
+bool ReadFile(const std::string& path, std::string* result) {
+  FILE* fp = OpenSourceRootRelativeFile(path);
+  if (!fp)
+    return false;
+  char buffer[4096];
+  size_t num_bytes;
+  result->clear();
+  while ((num_bytes = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    result->append(buffer, num_bytes);
+  fclose(fp);
+  return true;
+}
+
+// Appends the messages in the validation test inputs (in
+// mojo/public/interfaces/bindings/tests/data/validation) whose names start
+// with |prefix| to |messages|.
+void ReadValidationTestMessages(const std::string& prefix,
+                                std::vector<Message*>* messages) {
+  const std::string dir =
+      "mojo/public/interfaces/bindings/tests/data/validation/";
+  const std::string suffix = ".data";
+  std::vector<std::string> names = EnumerateSourceRootRelativeDirectory(dir);
+  for (const std::string& name : names) {
+    if (name.compare(0, prefix.size(), prefix) != 0 ||
+        name.size() < suffix.size() ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) !=
+            0) {
+      continue;
+    }
+
+    std::string input;
+    ASSERT_TRUE(ReadFile(dir + name, &input)) << name;
+    std::vector<uint8_t> data;
+    size_t num_handles = 0;
+    std::string error_message;
+    ASSERT_TRUE(
+        ParseValidationTestInput(input, &data, &num_handles, &error_message))
+        << name << ": " << error_message;
+
+    Message* message = new Message();
+    message->AllocUninitializedData(static_cast<uint32_t>(data.size()));
+    if (!data.empty())
+      memcpy(message->mutable_data(), &data[0], data.size());
+    message->mutable_handles()->resize(num_handles);
+    messages->push_back(message);
+  }
+}
+
+// Passes each of |messages| to |validators| repeatedly, for a while, and
+// reports the time per message.
+void MeasureValidation(const char* test_name,
+                       const char* sub_test_name,
+                       const std::vector<Message*>& messages,
+                       MessageReceiver* validators) {
+  ASSERT_FALSE(messages.empty());
+
+  // Don't log validation errors.
+  ValidationErrorObserverForTesting observer;
+
+  size_t num_messages = 0;
+  MojoTimeTicks start_time = GetTimeTicksNow();
+  MojoTimeTicks end_time;
+  do {
+    for (Message* message : messages)
+      mojo_ignore_result(validators->Accept(message));
+    num_messages += messages.size();
+    end_time = GetTimeTicksNow();
+  } while (end_time - start_time < kPerftestTimeMicroseconds);
+
+  LogPerfResult(test_name, sub_test_name,
+                (end_time - start_time) * 1000.0 / num_messages, "ns/message");
+}
+
+class ValidationPerftest : public testing::Test {
+ public:
+  ValidationPerftest() : validators_(&dummy_receiver_) {
+    validators_.Append<MessageHeaderValidator>();
+    validators_.Append<ConformanceTestInterface::RequestValidator_>();
+  }
+  ~ValidationPerftest() override {}
+
+ protected:
+  // Validates the request captured by |capturer_|, which must be valid.
+  void MeasureCapturedRequest(const char* sub_test_name) {
+    {
+      ValidationErrorObserverForTesting observer;
+      ASSERT_TRUE(validators_.GetHead()->Accept(capturer_.message()));
+      ASSERT_EQ(mojo::internal::VALIDATION_ERROR_NONE, observer.last_error());
+    }
+
+    std::vector<Message*> messages(1, capturer_.message());
+    MeasureValidation("Validation_LargeRequest", sub_test_name, messages,
+                      validators_.GetHead());
+  }
+
+  Environment env_;
+  DummyMessageReceiver dummy_receiver_;
+  FilterChain validators_;
+  MessageCapturer capturer_;
+};
+
+// The messages in the validation tests include both valid and invalid
+// messages, covering many different types.
+TEST_F(ValidationPerftest, TestInputs) {
+  FilterChain response_validators(&dummy_receiver_);
+  response_validators.Append<MessageHeaderValidator>();
+  response_validators.Append<ConformanceTestInterface::ResponseValidator_>();
+
+  FilterChain bounds_check_validators(&dummy_receiver_);
+  bounds_check_validators.Append<MessageHeaderValidator>();
+  bounds_check_validators.Append<BoundsCheckTestInterface::RequestValidator_>();
+
+  FilterChain bounds_check_response_validators(&dummy_receiver_);
+  bounds_check_response_validators.Append<MessageHeaderValidator>();
+  bounds_check_response_validators
+      .Append<BoundsCheckTestInterface::ResponseValidator_>();
+
+  const struct {
+    const char* prefix;
+    MessageReceiver* validators;
+  } test_inputs[] = {
+      {"conformance_", validators_.GetHead()},
+      {"resp_conformance_", response_validators.GetHead()},
+      {"boundscheck_", bounds_check_validators.GetHead()},
+      {"resp_boundscheck_", bounds_check_response_validators.GetHead()},
+  };
+
+  for (const auto& test_input : test_inputs) {
+    std::vector<Message*> messages;
+    ReadValidationTestMessages(test_input.prefix, &messages);
+    MeasureValidation("Validation_TestInputs", test_input.prefix, messages,
+                      test_input.validators);
+    for (Message* message : messages)
+      delete message;
+  }
+}
+
+TEST_F(ValidationPerftest, ArrayOfHandles) {
+  const size_t kNumHandles[] = {16, 256, 4096};
+  for (size_t num_handles : kNumHandles) {
+    Array<Array<ScopedHandle>> handles(1);
+    handles[0] = Array<ScopedHandle>::New(num_handles);
+    for (size_t i = 0; i < num_handles; i++) {
+      MessagePipe pipe;
+      handles[0][i] = ScopedHandle::From(pipe.handle0.Pass());
+    }
+    ConformanceTestInterfaceProxy(&capturer_).Method9(handles.Pass());
+
+    char sub_test_name[64];
+    sprintf(sub_test_name, "Handles_%u", static_cast<unsigned>(num_handles));
+    MeasureCapturedRequest(sub_test_name);
+  }
+}
+
+TEST_F(ValidationPerftest, ArrayOfArrays) {
+  const size_t kNumArrays[] = {16, 256, 4096};
+  for (size_t num_arrays : kNumArrays) {
+    Array<Array<uint8_t>> arrays(num_arrays);
+    for (size_t i = 0; i < num_arrays; i++)
+      arrays[i] = Array<uint8_t>::New(i % 16);
+    ConformanceTestInterfaceProxy(&capturer_).Method6(arrays.Pass());
+
+    char sub_test_name[64];
+    sprintf(sub_test_name, "Arrays_%u", static_cast<unsigned>(num_arrays));
+    MeasureCapturedRequest(sub_test_name);
+  }
+}
+
+TEST_F(ValidationPerftest, ArrayOfStrings) {
+  const size_t kNumStrings[] = {16, 256, 4096};
+  for (size_t num_strings : kNumStrings) {
+    Array<Array<String>> strings(1);
+    strings[0] = Array<String>::New(num_strings);
+    for (size_t i = 0; i < num_strings; i++)
+      strings[0][i] = "string";
+    ConformanceTestInterfaceProxy(&capturer_).Method8(strings.Pass());
+
+    char sub_test_name[64];
+    sprintf(sub_test_name, "Strings_%u", static_cast<unsigned>(num_strings));
+    MeasureCapturedRequest(sub_test_name);
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
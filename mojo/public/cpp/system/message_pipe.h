@@ -75,6 +75,22 @@ inline MojoResult WriteMessageRaw(MessagePipeHandle message_pipe,
       message_pipe.value(), bytes, num_bytes, handles, num_handles, flags);
 }
 
+// Writes multiple messages to a message pipe. See |MojoWriteMessages()| for
+// complete documentation.
+inline MojoResult WriteMessagesRaw(MessagePipeHandle message_pipe,
+                                   const void* bytes,
+                                   uint32_t num_bytes,
+                                   const MojoHandle* handles,
+                                   uint32_t num_handles,
+                                   const uint32_t* message_num_bytes,
+                                   const uint32_t* message_num_handles,
+                                   uint32_t num_messages,
+                                   MojoWriteMessageFlags flags) {
+  return MojoWriteMessages(message_pipe.value(), bytes, num_bytes, handles,
+                           num_handles, message_num_bytes, message_num_handles,
+                           num_messages, flags);
+}
+
 // Reads from a message pipe. See |MojoReadMessage()| for complete
 // documentation.
 inline MojoResult ReadMessageRaw(MessagePipeHandle message_pipe,
@@ -87,6 +103,22 @@ inline MojoResult ReadMessageRaw(MessagePipeHandle message_pipe,
       message_pipe.value(), bytes, num_bytes, handles, num_handles, flags);
 }
 
+// Reads multiple messages from a message pipe. See |MojoReadMessages()| for
+// complete documentation.
+inline MojoResult ReadMessagesRaw(MessagePipeHandle message_pipe,
+                                  void* bytes,
+                                  uint32_t* num_bytes,
+                                  MojoHandle* handles,
+                                  uint32_t* num_handles,
+                                  uint32_t* message_num_bytes,
+                                  uint32_t* message_num_handles,
+                                  uint32_t* num_messages,
+                                  MojoReadMessageFlags flags) {
+  return MojoReadMessages(message_pipe.value(), bytes, num_bytes, handles,
+                          num_handles, message_num_bytes, message_num_handles,
+                          num_messages, flags);
+}
+
 // A wrapper class that automatically creates a message pipe and owns both
 // handles.
 class MessagePipe {
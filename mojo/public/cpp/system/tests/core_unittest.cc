@@ -136,6 +136,7 @@ TEST(CoreCppTest, Basic) {
     EXPECT_FALSE(MakeScopedHandle(DataPipeProducerHandle()).is_valid());
     EXPECT_FALSE(MakeScopedHandle(DataPipeConsumerHandle()).is_valid());
     EXPECT_FALSE(MakeScopedHandle(SharedBufferHandle()).is_valid());
+    EXPECT_FALSE(MakeScopedHandle(WaitSetHandle()).is_valid());
   }
 
   // |MessagePipeHandle|/|ScopedMessagePipeHandle| functions:
@@ -489,6 +490,114 @@ TEST(CoreCppTest, ScopedHandleMoveCtorSelf) {
   EXPECT_TRUE(buffer1.is_valid());
 }
 
+TEST(CoreCppTest, WaitSet) {
+  ScopedWaitSetHandle wait_set;
+  EXPECT_EQ(MOJO_RESULT_OK, CreateWaitSet(&wait_set));
+  EXPECT_TRUE(wait_set.is_valid());
+
+  MessagePipe mp0;
+  MessagePipe mp1;
+  EXPECT_EQ(MOJO_RESULT_OK, AddHandle(wait_set.get(), mp0.handle0.get(),
+                                      MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_OK, AddHandle(wait_set.get(), mp1.handle0.get(),
+                                      MOJO_HANDLE_SIGNAL_READABLE));
+  EXPECT_EQ(MOJO_RESULT_ALREADY_EXISTS,
+            AddHandle(wait_set.get(), mp1.handle0.get(),
+                      MOJO_HANDLE_SIGNAL_READABLE));
+
+  Handle handles[2];
+  MojoResult results[2];
+  MojoHandleSignalsState states[2];
+  uint32_t count = 2;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            GetReadyHandles(wait_set.get(), &count, handles, results, states));
+  EXPECT_EQ(MOJO_RESULT_DEADLINE_EXCEEDED,
+            Wait(wait_set.get(), MOJO_HANDLE_SIGNAL_READABLE, 0, nullptr));
+
+  // Make both readable; both should be returned by a single call.
+  EXPECT_EQ(MOJO_RESULT_OK,
+            WriteMessageRaw(mp0.handle1.get(), "a", 1, nullptr, 0,
+                            MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            WriteMessageRaw(mp1.handle1.get(), "b", 1, nullptr, 0,
+                            MOJO_WRITE_MESSAGE_FLAG_NONE));
+  EXPECT_EQ(MOJO_RESULT_OK, Wait(wait_set.get(), MOJO_HANDLE_SIGNAL_READABLE,
+                                 MOJO_DEADLINE_INDEFINITE, nullptr));
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            GetReadyHandles(wait_set.get(), &count, handles, results, states));
+  EXPECT_EQ(2u, count);
+  EXPECT_EQ(mp0.handle0.get().value(), handles[0].value());
+  EXPECT_EQ(mp1.handle0.get().value(), handles[1].value());
+  for (size_t i = 0; i < 2; i++) {
+    EXPECT_EQ(MOJO_RESULT_OK, results[i]);
+    EXPECT_EQ(kSignalReadableWritable, states[i].satisfied_signals);
+    EXPECT_EQ(kSignalAll, states[i].satisfiable_signals);
+  }
+
+  // With room for only one handle, successive calls cycle through the ready
+  // handles.
+  count = 1;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            GetReadyHandles(wait_set.get(), &count, handles, results, nullptr));
+  EXPECT_EQ(1u, count);
+  EXPECT_EQ(mp0.handle0.get().value(), handles[0].value());
+  count = 1;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            GetReadyHandles(wait_set.get(), &count, handles, results, nullptr));
+  EXPECT_EQ(1u, count);
+  EXPECT_EQ(mp1.handle0.get().value(), handles[0].value());
+
+  // Once read from, |mp0.handle0| is no longer ready.
+  char buffer[1];
+  uint32_t num_bytes = static_cast<uint32_t>(sizeof(buffer));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            ReadMessageRaw(mp0.handle0.get(), buffer, &num_bytes, nullptr,
+                           nullptr, MOJO_READ_MESSAGE_FLAG_NONE));
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            GetReadyHandles(wait_set.get(), &count, handles, results, nullptr));
+  EXPECT_EQ(1u, count);
+  EXPECT_EQ(mp1.handle0.get().value(), handles[0].value());
+
+  EXPECT_EQ(MOJO_RESULT_OK, RemoveHandle(wait_set.get(), mp1.handle0.get()));
+  EXPECT_EQ(MOJO_RESULT_NOT_FOUND,
+            RemoveHandle(wait_set.get(), mp1.handle0.get()));
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            GetReadyHandles(wait_set.get(), &count, handles, results, nullptr));
+
+  // Closing the peer makes |mp0.handle0| unsatisfiable.
+  mp0.handle1.reset();
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            GetReadyHandles(wait_set.get(), &count, handles, results, nullptr));
+  EXPECT_EQ(1u, count);
+  EXPECT_EQ(mp0.handle0.get().value(), handles[0].value());
+  EXPECT_EQ(MOJO_RESULT_FAILED_PRECONDITION, results[0]);
+
+  // Closing |mp0.handle0| itself reports it as cancelled (once).
+  const Handle closed_handle = mp0.handle0.get();
+  mp0.handle0.reset();
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            GetReadyHandles(wait_set.get(), &count, handles, results, nullptr));
+  EXPECT_EQ(1u, count);
+  EXPECT_EQ(closed_handle.value(), handles[0].value());
+  EXPECT_EQ(MOJO_RESULT_CANCELLED, results[0]);
+  count = 2;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            GetReadyHandles(wait_set.get(), &count, handles, results, nullptr));
+  EXPECT_EQ(MOJO_RESULT_NOT_FOUND, RemoveHandle(wait_set.get(), closed_handle));
+
+  // Wait sets can't be added to wait sets.
+  WaitSet wait_set2;
+  EXPECT_TRUE(wait_set2.handle.is_valid());
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            AddHandle(wait_set.get(), wait_set2.handle.get(),
+                      MOJO_HANDLE_SIGNAL_READABLE));
+}
+
 // TODO(vtl): Write data pipe tests.
 
 }  // namespace
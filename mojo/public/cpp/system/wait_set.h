@@ -0,0 +1,99 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file provides a C++ wrapping around the Mojo C API for wait sets,
+// replacing the prefix of "Mojo" with a "mojo" namespace, and using more
+// strongly-typed representations of |MojoHandle|s.
+//
+// Please see "mojo/public/c/system/wait_set.h" for complete documentation of
+// the API.
+
+#ifndef MOJO_PUBLIC_CPP_SYSTEM_WAIT_SET_H_
+#define MOJO_PUBLIC_CPP_SYSTEM_WAIT_SET_H_
+
+#include <assert.h>
+
+#include "mojo/public/c/system/wait_set.h"
+#include "mojo/public/cpp/system/handle.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+
+// A strongly-typed representation of a |MojoHandle| referring to a wait set.
+class WaitSetHandle : public Handle {
+ public:
+  WaitSetHandle() {}
+  explicit WaitSetHandle(MojoHandle value) : Handle(value) {}
+
+  // Copying and assignment allowed.
+};
+
+static_assert(sizeof(WaitSetHandle) == sizeof(Handle),
+              "Bad size for C++ WaitSetHandle");
+
+typedef ScopedHandleBase<WaitSetHandle> ScopedWaitSetHandle;
+static_assert(sizeof(ScopedWaitSetHandle) == sizeof(WaitSetHandle),
+              "Bad size for C++ ScopedWaitSetHandle");
+
+// Creates a wait set. See |MojoCreateWaitSet()| for complete documentation.
+inline MojoResult CreateWaitSet(ScopedWaitSetHandle* wait_set) {
+  assert(wait_set);
+  WaitSetHandle handle;
+  MojoResult rv = MojoCreateWaitSet(handle.mutable_value());
+  // Reset even on failure (reduces the chances that a "stale"/incorrect handle
+  // will be used).
+  wait_set->reset(handle);
+  return rv;
+}
+
+// Adds |handle| to |wait_set|. See |MojoAddHandle()| for complete
+// documentation.
+inline MojoResult AddHandle(WaitSetHandle wait_set,
+                            Handle handle,
+                            MojoHandleSignals signals) {
+  return MojoAddHandle(wait_set.value(), handle.value(), signals);
+}
+
+// Removes |handle| from |wait_set|. See |MojoRemoveHandle()| for complete
+// documentation.
+inline MojoResult RemoveHandle(WaitSetHandle wait_set, Handle handle) {
+  return MojoRemoveHandle(wait_set.value(), handle.value());
+}
+
+// Retrieves some of the ready handles in |wait_set|. |*count| is in/out, and
+// |handles| and |results| (and |signals_states|, which is optional) must have
+// room for |*count| elements. See |MojoGetReadyHandles()| for complete
+// documentation.
+inline MojoResult GetReadyHandles(WaitSetHandle wait_set,
+                                  uint32_t* count,
+                                  Handle* handles,
+                                  MojoResult* results,
+                                  MojoHandleSignalsState* signals_states) {
+  assert(count);
+  return MojoGetReadyHandles(wait_set.value(), count,
+                             reinterpret_cast<MojoHandle*>(handles), results,
+                             signals_states);
+}
+
+// A wrapper class that automatically creates a wait set and owns the handle.
+class WaitSet {
+ public:
+  WaitSet();
+  ~WaitSet();
+
+  ScopedWaitSetHandle handle;
+};
+
+inline WaitSet::WaitSet() {
+  MojoResult result = CreateWaitSet(&handle);
+  MOJO_ALLOW_UNUSED_LOCAL(result);
+  assert(result == MOJO_RESULT_OK);
+}
+
+inline WaitSet::~WaitSet() {
+}
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_SYSTEM_WAIT_SET_H_
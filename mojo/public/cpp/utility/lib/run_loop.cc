@@ -21,15 +21,6 @@ const MojoTimeTicks kInvalidTimeTicks = static_cast<MojoTimeTicks>(0);
 
 }  // namespace
 
-// State needed for one iteration of WaitMany().
-struct RunLoop::WaitState {
-  WaitState() : deadline(MOJO_DEADLINE_INDEFINITE) {}
-
-  std::vector<Handle> handles;
-  std::vector<MojoHandleSignals> handle_signals;
-  MojoDeadline deadline;
-};
-
 struct RunLoop::RunState {
   RunState() : should_quit(false) {}
 
@@ -37,9 +28,16 @@ struct RunLoop::RunState {
 };
 
 RunLoop::RunLoop()
-    : run_state_(nullptr), next_handler_id_(0), next_sequence_number_(0) {
+    : num_handlers_with_deadline_(0),
+      run_state_(nullptr),
+      next_handler_id_(0),
+      next_sequence_number_(0) {
   assert(!current());
   current_run_loop.Set(this);
+
+  MojoResult result = CreateWaitSet(&wait_set_);
+  MOJO_ALLOW_UNUSED_LOCAL(result);
+  assert(result == MOJO_RESULT_OK);
 }
 
 RunLoop::~RunLoop() {
@@ -82,11 +80,16 @@ void RunLoop::AddHandler(RunLoopHandler* handler,
           : GetTimeTicksNow() + static_cast<MojoTimeTicks>(deadline);
   handler_data.id = next_handler_id_++;
   handler_data_[handle] = handler_data;
+  if (handler_data.deadline != kInvalidTimeTicks)
+    num_handlers_with_deadline_++;
+  if (AddHandle(wait_set_.get(), handle, handle_signals) != MOJO_RESULT_OK)
+    invalid_handles_.push_back(handle);
 }
 
 void RunLoop::RemoveHandler(const Handle& handle) {
   assert(current() == this);
-  handler_data_.erase(handle);
+  if (handler_data_.find(handle) != handler_data_.end())
+    EraseHandler(handle);
 }
 
 bool RunLoop::HasHandler(const Handle& handle) const {
@@ -143,36 +146,48 @@ void RunLoop::PostDelayedTask(const Closure& task, MojoTimeTicks delay) {
 }
 
 bool RunLoop::Wait(bool non_blocking) {
-  const WaitState wait_state = GetWaitState(non_blocking);
-  if (wait_state.handles.empty()) {
+  if (handler_data_.empty()) {
     if (delayed_tasks_.empty())
       Quit();
     return false;
   }
 
-  const WaitManyResult wmr =
-      WaitMany(wait_state.handles, wait_state.handle_signals,
-               wait_state.deadline, nullptr);
-
-  if (!wmr.IsIndexValid()) {
-    assert(wmr.result == MOJO_RESULT_DEADLINE_EXCEEDED);
-    return NotifyHandlers(MOJO_RESULT_DEADLINE_EXCEEDED, CHECK_DEADLINE);
+  Handle handle;
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  if (!invalid_handles_.empty()) {
+    handle = invalid_handles_.back();
+    invalid_handles_.pop_back();
+  } else {
+    MojoResult wait_result =
+        mojo::Wait(wait_set_.get(), MOJO_HANDLE_SIGNAL_READABLE,
+                   GetDeadline(non_blocking), nullptr);
+    if (wait_result == MOJO_RESULT_DEADLINE_EXCEEDED)
+      return NotifyHandlers(MOJO_RESULT_DEADLINE_EXCEEDED, CHECK_DEADLINE);
+    assert(wait_result == MOJO_RESULT_OK);
+
+    uint32_t num_ready = 1;
+    wait_result = GetReadyHandles(wait_set_.get(), &num_ready, &handle,
+                                  &result, nullptr);
+    // The wait set's readiness may have been spurious.
+    if (wait_result == MOJO_RESULT_SHOULD_WAIT)
+      return false;
+    assert(wait_result == MOJO_RESULT_OK);
   }
 
-  Handle handle = wait_state.handles[wmr.index];
   assert(handler_data_.find(handle) != handler_data_.end());
   RunLoopHandler* handler = handler_data_[handle].handler;
 
-  switch (wmr.result) {
+  switch (result) {
     case MOJO_RESULT_OK:
       handler->OnHandleReady(handle);
       return true;
     case MOJO_RESULT_INVALID_ARGUMENT:
     case MOJO_RESULT_FAILED_PRECONDITION:
+    case MOJO_RESULT_CANCELLED:
       // Remove the handle first, this way if OnHandleError() tries to remove
       // the handle our iterator isn't invalidated.
-      handler_data_.erase(handle);
-      handler->OnHandleError(handle, wmr.result);
+      EraseHandler(handle);
+      handler->OnHandleError(handle, result);
       return true;
     default:
       assert(false);
@@ -182,6 +197,8 @@ bool RunLoop::Wait(bool non_blocking) {
 
 bool RunLoop::NotifyHandlers(MojoResult error, CheckDeadline check) {
   bool notified = false;
+  if (check == CHECK_DEADLINE && !num_handlers_with_deadline_)
+    return notified;
 
   // Make a copy in case someone tries to add/remove new handlers as part of
   // notifying.
@@ -204,7 +221,7 @@ bool RunLoop::NotifyHandlers(MojoResult error, CheckDeadline check) {
     }
 
     RunLoopHandler* handler = i->second.handler;
-    handler_data_.erase(i->first);
+    EraseHandler(i->first);
     handler->OnHandleError(i->first, error);
     notified = true;
   }
@@ -212,17 +229,38 @@ bool RunLoop::NotifyHandlers(MojoResult error, CheckDeadline check) {
   return notified;
 }
 
-RunLoop::WaitState RunLoop::GetWaitState(bool non_blocking) const {
-  WaitState wait_state;
+void RunLoop::EraseHandler(const Handle& handle) {
+  HandleToHandlerData::iterator it = handler_data_.find(handle);
+  assert(it != handler_data_.end());
+  if (it->second.deadline != kInvalidTimeTicks)
+    num_handlers_with_deadline_--;
+  handler_data_.erase(it);
+
+  // This fails (harmlessly) if |handle| was never added to the wait set or if
+  // the wait set has already dropped it (after reporting that it was closed).
+  if (RemoveHandle(wait_set_.get(), handle) != MOJO_RESULT_OK) {
+    for (size_t i = 0; i < invalid_handles_.size(); i++) {
+      if (invalid_handles_[i].value() == handle.value()) {
+        invalid_handles_.erase(invalid_handles_.begin() + i);
+        break;
+      }
+    }
+  }
+}
+
+MojoDeadline RunLoop::GetDeadline(bool non_blocking) const {
+  if (non_blocking)
+    return static_cast<MojoDeadline>(0);
+
   MojoTimeTicks min_time = kInvalidTimeTicks;
-  for (HandleToHandlerData::const_iterator i = handler_data_.begin();
-       i != handler_data_.end();
-       ++i) {
-    wait_state.handles.push_back(i->first);
-    wait_state.handle_signals.push_back(i->second.handle_signals);
-    if (!non_blocking && i->second.deadline != kInvalidTimeTicks &&
-        (min_time == kInvalidTimeTicks || i->second.deadline < min_time)) {
-      min_time = i->second.deadline;
+  if (num_handlers_with_deadline_) {
+    for (HandleToHandlerData::const_iterator i = handler_data_.begin();
+         i != handler_data_.end();
+         ++i) {
+      if (i->second.deadline != kInvalidTimeTicks &&
+          (min_time == kInvalidTimeTicks || i->second.deadline < min_time)) {
+        min_time = i->second.deadline;
+      }
     }
   }
   if (!delayed_tasks_.empty()) {
@@ -232,16 +270,12 @@ RunLoop::WaitState RunLoop::GetWaitState(bool non_blocking) const {
     else
       min_time = std::min(min_time, delayed_min_time);
   }
-  if (non_blocking) {
-    wait_state.deadline = static_cast<MojoDeadline>(0);
-  } else if (min_time != kInvalidTimeTicks) {
-    const MojoTimeTicks now = GetTimeTicksNow();
-    if (min_time < now)
-      wait_state.deadline = static_cast<MojoDeadline>(0);
-    else
-      wait_state.deadline = static_cast<MojoDeadline>(min_time - now);
-  }
-  return wait_state;
+  if (min_time == kInvalidTimeTicks)
+    return MOJO_DEADLINE_INDEFINITE;
+  const MojoTimeTicks now = GetTimeTicksNow();
+  if (min_time < now)
+    return static_cast<MojoDeadline>(0);
+  return static_cast<MojoDeadline>(min_time - now);
 }
 
 RunLoop::PendingTask::PendingTask(const Closure& task,
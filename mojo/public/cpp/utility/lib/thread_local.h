@@ -14,6 +14,14 @@
 namespace mojo {
 namespace internal {
 
+// Calling convention for slot destructors (Windows calls them as fiber local
+// storage callbacks).
+#ifdef _WIN32
+#define MOJO_THREAD_LOCAL_DESTRUCTOR_CALL __stdcall
+#else
+#define MOJO_THREAD_LOCAL_DESTRUCTOR_CALL
+#endif
+
 // Helper functions that abstract the cross-platform APIs.
 struct ThreadLocalPlatform {
 #ifdef _WIN32
@@ -21,8 +29,25 @@ struct ThreadLocalPlatform {
 #else
   typedef pthread_key_t SlotType;
 #endif
+  typedef void(MOJO_THREAD_LOCAL_DESTRUCTOR_CALL* DestructorType)(void* value);
+#ifdef _WIN32
+  // Really an |INIT_ONCE| (which is pointer-sized); this avoids including
+  // <windows.h>.
+  typedef void* OnceType;
+#define MOJO_THREAD_LOCAL_ONCE_INIT nullptr
+#else
+  typedef pthread_once_t OnceType;
+#define MOJO_THREAD_LOCAL_ONCE_INIT PTHREAD_ONCE_INIT
+#endif
+
+  // Runs |function| the first time this is called with |once| (which must be
+  // statically initialized to |MOJO_THREAD_LOCAL_ONCE_INIT|). Concurrent
+  // callers wait until it has run. This is useful for allocating slots lazily.
+  static void CallOnce(OnceType* once, void (*function)());
 
-  static void AllocateSlot(SlotType* slot);
+  // If |destructor| is non-null, it's called with a thread's value (if it's
+  // non-null) when that thread exits.
+  static void AllocateSlot(SlotType* slot, DestructorType destructor);
   static void FreeSlot(SlotType slot);
   static void* GetValueFromSlot(SlotType slot);
   static void SetValueInSlot(SlotType slot, void* value);
@@ -34,7 +59,13 @@ class ThreadLocalPointer {
  public:
   ThreadLocalPointer() : slot_() {}
 
-  void Allocate() { ThreadLocalPlatform::AllocateSlot(&slot_); }
+  void Allocate() { ThreadLocalPlatform::AllocateSlot(&slot_, nullptr); }
+
+  // As above, but |destructor| is called with each thread's (non-null) value
+  // when that thread exits.
+  void Allocate(ThreadLocalPlatform::DestructorType destructor) {
+    ThreadLocalPlatform::AllocateSlot(&slot_, destructor);
+  }
 
   void Free() { ThreadLocalPlatform::FreeSlot(slot_); }
 
@@ -10,8 +10,16 @@ namespace mojo {
 namespace internal {
 
 // static
-void ThreadLocalPlatform::AllocateSlot(SlotType* slot) {
-  if (pthread_key_create(slot, nullptr) != 0) {
+void ThreadLocalPlatform::AllocateSlot(SlotType* slot,
+                                       DestructorType destructor) {
+  if (pthread_key_create(slot, destructor) != 0) {
+    assert(false);
+  }
+}
+
+// static
+void ThreadLocalPlatform::CallOnce(OnceType* once, void (*function)()) {
+  if (pthread_once(once, function) != 0) {
     assert(false);
   }
 }
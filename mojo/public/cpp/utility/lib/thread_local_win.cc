@@ -9,28 +9,52 @@
 
 namespace mojo {
 namespace internal {
+namespace {
+
+static_assert(sizeof(INIT_ONCE) == sizeof(ThreadLocalPlatform::OnceType),
+              "OnceType has the wrong size");
+
+BOOL CALLBACK RunOnce(PINIT_ONCE /*init_once*/,
+                      PVOID parameter,
+                      PVOID* /*context*/) {
+  reinterpret_cast<void (*)()>(parameter)();
+  return TRUE;
+}
+
+}  // namespace
 
 // static
-void ThreadLocalPlatform::AllocateSlot(SlotType* slot) {
-  *slot = TlsAlloc();
-  assert(*slot != TLS_OUT_OF_INDEXES);
+void ThreadLocalPlatform::AllocateSlot(SlotType* slot,
+                                       DestructorType destructor) {
+  // Use fiber local storage, since (unlike thread local storage) it supports
+  // destructors. (On threads that aren't running fibers, it's equivalent.)
+  *slot = FlsAlloc(destructor);
+  assert(*slot != FLS_OUT_OF_INDEXES);
+}
+
+// static
+void ThreadLocalPlatform::CallOnce(OnceType* once, void (*function)()) {
+  if (!InitOnceExecuteOnce(reinterpret_cast<PINIT_ONCE>(once), &RunOnce,
+                           reinterpret_cast<PVOID>(function), nullptr)) {
+    assert(false);
+  }
 }
 
 // static
 void ThreadLocalPlatform::FreeSlot(SlotType slot) {
-  if (!TlsFree(slot)) {
+  if (!FlsFree(slot)) {
     assert(false);
   }
 }
 
 // static
 void* ThreadLocalPlatform::GetValueFromSlot(SlotType slot) {
-  return TlsGetValue(slot);
+  return FlsGetValue(slot);
 }
 
 // static
 void ThreadLocalPlatform::SetValueInSlot(SlotType slot, void* value) {
-  if (!TlsSetValue(slot, value)) {
+  if (!FlsSetValue(slot, value)) {
     assert(false);
   }
 }
@@ -5,8 +5,11 @@
 #ifndef MOJO_PUBLIC_CPP_UTILITY_RUN_LOOP_H_
 #define MOJO_PUBLIC_CPP_UTILITY_RUN_LOOP_H_
 
+#include <stddef.h>
+
 #include <map>
 #include <queue>
+#include <vector>
 
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/public/cpp/system/core.h"
@@ -17,6 +20,10 @@ class RunLoopHandler;
 
 // Watches handles for signals and calls event handlers when they occur. Also
 // executes delayed tasks. This class should only be used by a single thread.
+//
+// Handles are kept in a wait set (see mojo/public/c/system/wait_set.h), so the
+// cost of waiting depends on the number of ready handles rather than on the
+// number of registered ones.
 class RunLoop {
  public:
   RunLoop();
@@ -68,7 +75,6 @@ class RunLoop {
 
  private:
   struct RunState;
-  struct WaitState;
 
   // Contains the data needed to track a request to AddHandler().
   struct HandlerData {
@@ -114,11 +120,27 @@ class RunLoop {
   // Returns true if a RunLoopHandler was notified.
   bool NotifyHandlers(MojoResult error, CheckDeadline check);
 
-  // Returns the state needed to pass to WaitMany().
-  WaitState GetWaitState(bool non_blocking) const;
+  // Removes the handler for |handle| from |handler_data_| and |handle| from
+  // |wait_set_|.
+  void EraseHandler(const Handle& handle);
+
+  // Returns the deadline to wait on |wait_set_| with.
+  MojoDeadline GetDeadline(bool non_blocking) const;
 
   HandleToHandlerData handler_data_;
 
+  // Contains the handles of |handler_data_| (except those in
+  // |invalid_handles_|).
+  ScopedWaitSetHandle wait_set_;
+
+  // Handles that couldn't be added to |wait_set_| since they were invalid.
+  // Their handlers are notified of the error on the next Wait().
+  std::vector<Handle> invalid_handles_;
+
+  // The number of handlers in |handler_data_| with a deadline. Handler
+  // deadlines are only looked at if this is nonzero.
+  size_t num_handlers_with_deadline_;
+
   // If non-null we're running (inside Run()). Member references a value on the
   // stack.
   RunState* run_state_;
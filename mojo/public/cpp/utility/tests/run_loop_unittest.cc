@@ -174,6 +174,32 @@ TEST_F(RunLoopTest, QuitWhenDeadlineExpired) {
   EXPECT_FALSE(run_loop.HasHandler(test_pipe.handle0.get()));
 }
 
+// Verifies that handlers are notified (and removed) if their handle is closed,
+// whether before or after being added.
+TEST_F(RunLoopTest, ClosedHandles) {
+  TestRunLoopHandler handler0;
+  TestRunLoopHandler handler1;
+  MessagePipe test_pipe;
+  const Handle handle0 = test_pipe.handle0.get();
+  const Handle handle1 = test_pipe.handle1.get();
+  RunLoop run_loop;
+  run_loop.AddHandler(&handler0, handle0, MOJO_HANDLE_SIGNAL_READABLE,
+                      MOJO_DEADLINE_INDEFINITE);
+  test_pipe.handle0.reset();
+  test_pipe.handle1.reset();
+  run_loop.AddHandler(&handler1, handle1, MOJO_HANDLE_SIGNAL_READABLE,
+                      MOJO_DEADLINE_INDEFINITE);
+  run_loop.Run();
+  EXPECT_EQ(0, handler0.ready_count());
+  EXPECT_EQ(1, handler0.error_count());
+  EXPECT_EQ(MOJO_RESULT_CANCELLED, handler0.last_error_result());
+  EXPECT_FALSE(run_loop.HasHandler(handle0));
+  EXPECT_EQ(0, handler1.ready_count());
+  EXPECT_EQ(1, handler1.error_count());
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT, handler1.last_error_result());
+  EXPECT_FALSE(run_loop.HasHandler(handle1));
+}
+
 // Test that handlers are notified of loop destruction.
 TEST_F(RunLoopTest, Destruction) {
   TestRunLoopHandler handler;
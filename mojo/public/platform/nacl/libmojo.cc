@@ -218,6 +218,41 @@ MojoResult MojoReadMessage(MojoHandle message_pipe_handle,
                                    handles, num_handles, flags);
 }
 
+MojoResult MojoCreateWaitSet(MojoHandle* wait_set_handle) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoCreateWaitSet(wait_set_handle);
+}
+
+MojoResult MojoAddHandle(MojoHandle wait_set_handle,
+                         MojoHandle handle,
+                         MojoHandleSignals signals) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoAddHandle(wait_set_handle, handle, signals);
+}
+
+MojoResult MojoRemoveHandle(MojoHandle wait_set_handle, MojoHandle handle) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoRemoveHandle(wait_set_handle, handle);
+}
+
+MojoResult MojoGetReadyHandles(MojoHandle wait_set_handle,
+                               uint32_t* count,
+                               MojoHandle* handles,
+                               MojoResult* results,
+                               struct MojoHandleSignalsState* signals_states) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoGetReadyHandles(wait_set_handle, count, handles, results,
+                                       signals_states);
+}
+
 MojoResult _MojoGetInitialHandle(MojoHandle* handle) {
   struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
   if (irt_mojo == NULL)
@@ -225,3 +260,106 @@ MojoResult _MojoGetInitialHandle(MojoHandle* handle) {
   return irt_mojo->_MojoGetInitialHandle(handle);
 }
 
+MojoResult MojoReadMessages(MojoHandle message_pipe_handle,
+                            void* bytes,
+                            uint32_t* num_bytes,
+                            MojoHandle* handles,
+                            uint32_t* num_handles,
+                            uint32_t* message_num_bytes,
+                            uint32_t* message_num_handles,
+                            uint32_t* num_messages,
+                            MojoReadMessageFlags flags) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoReadMessages(message_pipe_handle, bytes, num_bytes,
+                                    handles, num_handles, message_num_bytes,
+                                    message_num_handles, num_messages, flags);
+}
+
+MojoResult MojoWriteMessages(MojoHandle message_pipe_handle,
+                             const void* bytes,
+                             uint32_t num_bytes,
+                             const MojoHandle* handles,
+                             uint32_t num_handles,
+                             const uint32_t* message_num_bytes,
+                             const uint32_t* message_num_handles,
+                             uint32_t num_messages,
+                             MojoWriteMessageFlags flags) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoWriteMessages(message_pipe_handle, bytes, num_bytes,
+                                     handles, num_handles, message_num_bytes,
+                                     message_num_handles, num_messages, flags);
+}
+
+MojoResult MojoWriteMessageContext(
+    MojoHandle message_pipe_handle,
+    uintptr_t context,
+    const struct MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoWriteMessageContext(message_pipe_handle, context, thunks,
+                                           flags);
+}
+
+MojoResult MojoReadMessageContext(MojoHandle message_pipe_handle,
+                                  const struct MojoMessageContextThunks* thunks,
+                                  uintptr_t* context,
+                                  void* bytes,
+                                  uint32_t* num_bytes,
+                                  MojoHandle* handles,
+                                  uint32_t* num_handles,
+                                  MojoReadMessageFlags flags) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoReadMessageContext(message_pipe_handle, thunks, context,
+                                          bytes, num_bytes, handles,
+                                          num_handles, flags);
+}
+
+MojoResult MojoSetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    const struct MojoDataPipeProducerOptions* options) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoSetDataPipeProducerOptions(data_pipe_producer_handle,
+                                                  options);
+}
+
+MojoResult MojoGetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    struct MojoDataPipeProducerOptions* options,
+    uint32_t options_num_bytes) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoGetDataPipeProducerOptions(data_pipe_producer_handle,
+                                                  options, options_num_bytes);
+}
+
+MojoResult MojoSetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    const struct MojoDataPipeConsumerOptions* options) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoSetDataPipeConsumerOptions(data_pipe_consumer_handle,
+                                                  options);
+}
+
+MojoResult MojoGetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    struct MojoDataPipeConsumerOptions* options,
+    uint32_t options_num_bytes) {
+  struct nacl_irt_mojo* irt_mojo = get_irt_mojo();
+  if (irt_mojo == NULL)
+    return MOJO_RESULT_INTERNAL;
+  return irt_mojo->MojoGetDataPipeConsumerOptions(data_pipe_consumer_handle,
+                                                  options, options_num_bytes);
+}
@@ -82,7 +82,64 @@ struct nacl_irt_mojo {
                                 MojoHandle* handles,
                                 uint32_t* num_handles,
                                 MojoReadMessageFlags flags);
+  MojoResult (*MojoCreateWaitSet)(MojoHandle* wait_set_handle);
+  MojoResult (*MojoAddHandle)(MojoHandle wait_set_handle,
+                              MojoHandle handle,
+                              MojoHandleSignals signals);
+  MojoResult (*MojoRemoveHandle)(MojoHandle wait_set_handle, MojoHandle handle);
+  MojoResult (*MojoGetReadyHandles)(
+      MojoHandle wait_set_handle,
+      uint32_t* count,
+      MojoHandle* handles,
+      MojoResult* results,
+      struct MojoHandleSignalsState* signals_states);
   MojoResult (*_MojoGetInitialHandle)(MojoHandle* handle);
+  MojoResult (*MojoReadMessages)(MojoHandle message_pipe_handle,
+                                 void* bytes,
+                                 uint32_t* num_bytes,
+                                 MojoHandle* handles,
+                                 uint32_t* num_handles,
+                                 uint32_t* message_num_bytes,
+                                 uint32_t* message_num_handles,
+                                 uint32_t* num_messages,
+                                 MojoReadMessageFlags flags);
+  MojoResult (*MojoWriteMessages)(MojoHandle message_pipe_handle,
+                                  const void* bytes,
+                                  uint32_t num_bytes,
+                                  const MojoHandle* handles,
+                                  uint32_t num_handles,
+                                  const uint32_t* message_num_bytes,
+                                  const uint32_t* message_num_handles,
+                                  uint32_t num_messages,
+                                  MojoWriteMessageFlags flags);
+  MojoResult (*MojoWriteMessageContext)(
+      MojoHandle message_pipe_handle,
+      uintptr_t context,
+      const struct MojoMessageContextThunks* thunks,
+      MojoWriteMessageFlags flags);
+  MojoResult (*MojoReadMessageContext)(
+      MojoHandle message_pipe_handle,
+      const struct MojoMessageContextThunks* thunks,
+      uintptr_t* context,
+      void* bytes,
+      uint32_t* num_bytes,
+      MojoHandle* handles,
+      uint32_t* num_handles,
+      MojoReadMessageFlags flags);
+  MojoResult (*MojoSetDataPipeProducerOptions)(
+      MojoHandle data_pipe_producer_handle,
+      const struct MojoDataPipeProducerOptions* options);
+  MojoResult (*MojoGetDataPipeProducerOptions)(
+      MojoHandle data_pipe_producer_handle,
+      struct MojoDataPipeProducerOptions* options,
+      uint32_t options_num_bytes);
+  MojoResult (*MojoSetDataPipeConsumerOptions)(
+      MojoHandle data_pipe_consumer_handle,
+      const struct MojoDataPipeConsumerOptions* options);
+  MojoResult (*MojoGetDataPipeConsumerOptions)(
+      MojoHandle data_pipe_consumer_handle,
+      struct MojoDataPipeConsumerOptions* options,
+      uint32_t options_num_bytes);
 };
 
 #ifdef __cplusplus
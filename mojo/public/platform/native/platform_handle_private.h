@@ -0,0 +1,50 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Note: This header should be compilable as C.
+
+#ifndef MOJO_PUBLIC_PLATFORM_NATIVE_PLATFORM_HANDLE_PRIVATE_H_
+#define MOJO_PUBLIC_PLATFORM_NATIVE_PLATFORM_HANDLE_PRIVATE_H_
+
+#include "mojo/public/c/system/system_export.h"
+#include "mojo/public/c/system/types.h"
+
+// This interface provides (private) APIs for interacting with platform handles
+// (i.e., file descriptors; only POSIX is supported), for use by, e.g., system
+// services.
+
+typedef int MojoPlatformHandle;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Creates a shared buffer backed by the regular file |platform_handle| (taking
+// ownership of it, even on failure), which must be exactly |num_bytes| bytes in
+// size. The shared buffer may then be mapped (using |MojoMapBuffer()|), sent
+// over message pipes, etc., as usual; writes to a mapping are writes to the
+// file. If |platform_handle| is not writable, the shared buffer may only be
+// mapped read-only (i.e., writing to a mapping will crash), and it can't be
+// sent to another process (the receiver will get an invalid handle), since
+// shared buffers received over message pipes must be mappable read-write.
+// Accessing a mapping beyond the end of the file (e.g., if it's truncated) will
+// crash.
+//
+// Returns:
+//   |MOJO_RESULT_OK| on success, in which case |*shared_buffer_handle| is set
+//       to a handle to the new shared buffer.
+//   |MOJO_RESULT_INVALID_ARGUMENT| if |num_bytes| is zero or |platform_handle|
+//       is not a readable regular file of size |num_bytes|.
+//   |MOJO_RESULT_RESOURCE_EXHAUSTED| if |num_bytes| is too big or the handle
+//       table is full.
+MOJO_SYSTEM_EXPORT MojoResult
+MojoCreateSharedBufferFromPlatformHandle(MojoPlatformHandle platform_handle,
+                                         uint64_t num_bytes,
+                                         MojoHandle* shared_buffer_handle);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // MOJO_PUBLIC_PLATFORM_NATIVE_PLATFORM_HANDLE_PRIVATE_H_
@@ -0,0 +1,31 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/platform/native/platform_handle_private_thunks.h"
+
+#include <assert.h>
+
+#include "mojo/public/platform/native/thunk_export.h"
+
+extern "C" {
+
+static MojoPlatformHandlePrivateThunks g_platform_handle_thunks = {0};
+
+MojoResult MojoCreateSharedBufferFromPlatformHandle(
+    MojoPlatformHandle platform_handle,
+    uint64_t num_bytes,
+    MojoHandle* shared_buffer_handle) {
+  assert(g_platform_handle_thunks.CreateSharedBufferFromPlatformHandle);
+  return g_platform_handle_thunks.CreateSharedBufferFromPlatformHandle(
+      platform_handle, num_bytes, shared_buffer_handle);
+}
+
+extern "C" THUNK_EXPORT size_t MojoSetPlatformHandlePrivateThunks(
+    const MojoPlatformHandlePrivateThunks* platform_handle_thunks) {
+  if (platform_handle_thunks->size >= sizeof(g_platform_handle_thunks))
+    g_platform_handle_thunks = *platform_handle_thunks;
+  return sizeof(g_platform_handle_thunks);
+}
+
+}  // extern "C"
@@ -0,0 +1,52 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Note: This header should be compilable as C.
+
+#ifndef MOJO_PUBLIC_PLATFORM_NATIVE_PLATFORM_HANDLE_PRIVATE_THUNKS_H_
+#define MOJO_PUBLIC_PLATFORM_NATIVE_PLATFORM_HANDLE_PRIVATE_THUNKS_H_
+
+#include <stddef.h>
+
+#include "mojo/public/platform/native/platform_handle_private.h"
+
+// Structure used to bind the platform handle functions of a DSO to those of the
+// embedder.
+// This is the ABI between the embedder and the DSO. It can only have new
+// functions added to the end. No other changes are supported.
+#pragma pack(push, 8)
+struct MojoPlatformHandlePrivateThunks {
+  size_t size;  // Should be set to sizeof(MojoPlatformHandlePrivateThunks).
+  MojoResult (*CreateSharedBufferFromPlatformHandle)(
+      MojoPlatformHandle platform_handle,
+      uint64_t num_bytes,
+      MojoHandle* shared_buffer_handle);
+};
+#pragma pack(pop)
+
+#ifdef __cplusplus
+// Intended to be called from the embedder. Returns a
+// |MojoPlatformHandlePrivateThunks| initialized to contain pointers to each of
+// the embedder's functions.
+inline MojoPlatformHandlePrivateThunks MojoMakePlatformHandlePrivateThunks() {
+  MojoPlatformHandlePrivateThunks platform_handle_thunks = {
+      sizeof(MojoPlatformHandlePrivateThunks),
+      MojoCreateSharedBufferFromPlatformHandle};
+  return platform_handle_thunks;
+}
+#endif
+
+// Use this type for the function found by dynamically discovering it in
+// a DSO linked with mojo_system.
+// For example:
+// MojoSetPlatformHandlePrivateThunksFn mojo_set_platform_handle_thunks_fn =
+//     reinterpret_cast<MojoSetPlatformHandlePrivateThunksFn>(
+//         app_library.GetFunctionPointer(
+//             "MojoSetPlatformHandlePrivateThunks"));
+// The expected size of |platform_handle_thunks| is returned.
+// The contents of |platform_handle_thunks| are copied.
+typedef size_t (*MojoSetPlatformHandlePrivateThunksFn)(
+    const struct MojoPlatformHandlePrivateThunks* platform_handle_thunks);
+
+#endif  // MOJO_PUBLIC_PLATFORM_NATIVE_PLATFORM_HANDLE_PRIVATE_THUNKS_H_
@@ -137,6 +137,80 @@ MOJO_SYSTEM_EXPORT MojoResult MojoSystemImplMapBuffer(MojoSystemImpl system,
                                                       MojoMapBufferFlags flags);
 MOJO_SYSTEM_EXPORT MojoResult
 MojoSystemImplUnmapBuffer(MojoSystemImpl system, void* buffer);
+MOJO_SYSTEM_EXPORT MojoResult
+MojoSystemImplCreateWaitSet(MojoSystemImpl system, MojoHandle* wait_set_handle);
+MOJO_SYSTEM_EXPORT MojoResult
+MojoSystemImplAddHandle(MojoSystemImpl system,
+                        MojoHandle wait_set_handle,
+                        MojoHandle handle,
+                        MojoHandleSignals signals);
+MOJO_SYSTEM_EXPORT MojoResult
+MojoSystemImplRemoveHandle(MojoSystemImpl system,
+                           MojoHandle wait_set_handle,
+                           MojoHandle handle);
+MOJO_SYSTEM_EXPORT MojoResult
+MojoSystemImplGetReadyHandles(MojoSystemImpl system,
+                              MojoHandle wait_set_handle,
+                              uint32_t* count,
+                              MojoHandle* handles,
+                              MojoResult* results,
+                              struct MojoHandleSignalsState* signals_states);
+MOJO_SYSTEM_EXPORT MojoResult
+MojoSystemImplReadMessages(MojoSystemImpl system,
+                           MojoHandle message_pipe_handle,
+                           void* bytes,
+                           uint32_t* num_bytes,
+                           MojoHandle* handles,
+                           uint32_t* num_handles,
+                           uint32_t* message_num_bytes,
+                           uint32_t* message_num_handles,
+                           uint32_t* num_messages,
+                           MojoReadMessageFlags flags);
+MOJO_SYSTEM_EXPORT MojoResult
+MojoSystemImplWriteMessages(MojoSystemImpl system,
+                            MojoHandle message_pipe_handle,
+                            const void* bytes,
+                            uint32_t num_bytes,
+                            const MojoHandle* handles,
+                            uint32_t num_handles,
+                            const uint32_t* message_num_bytes,
+                            const uint32_t* message_num_handles,
+                            uint32_t num_messages,
+                            MojoWriteMessageFlags flags);
+MOJO_SYSTEM_EXPORT MojoResult
+MojoSystemImplWriteMessageContext(MojoSystemImpl system,
+                                  MojoHandle message_pipe_handle,
+                                  uintptr_t context,
+                                  const struct MojoMessageContextThunks* thunks,
+                                  MojoWriteMessageFlags flags);
+MOJO_SYSTEM_EXPORT MojoResult
+MojoSystemImplReadMessageContext(MojoSystemImpl system,
+                                 MojoHandle message_pipe_handle,
+                                 const struct MojoMessageContextThunks* thunks,
+                                 uintptr_t* context,
+                                 void* bytes,
+                                 uint32_t* num_bytes,
+                                 MojoHandle* handles,
+                                 uint32_t* num_handles,
+                                 MojoReadMessageFlags flags);
+MOJO_SYSTEM_EXPORT MojoResult MojoSystemImplSetDataPipeProducerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_producer_handle,
+    const struct MojoDataPipeProducerOptions* options);
+MOJO_SYSTEM_EXPORT MojoResult MojoSystemImplGetDataPipeProducerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_producer_handle,
+    struct MojoDataPipeProducerOptions* options,
+    uint32_t options_num_bytes);
+MOJO_SYSTEM_EXPORT MojoResult MojoSystemImplSetDataPipeConsumerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_consumer_handle,
+    const struct MojoDataPipeConsumerOptions* options);
+MOJO_SYSTEM_EXPORT MojoResult MojoSystemImplGetDataPipeConsumerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_consumer_handle,
+    struct MojoDataPipeConsumerOptions* options,
+    uint32_t options_num_bytes);
 }  // extern "C"
 
 #endif  // MOJO_PUBLIC_PLATFORM_NATIVE_SYSTEM_IMPL_PRIVATE_H_
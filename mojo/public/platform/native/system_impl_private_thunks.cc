@@ -203,6 +203,137 @@ MojoResult MojoSystemImplUnmapBuffer(MojoSystemImpl system, void* buffer) {
   return g_system_impl_thunks.UnmapBuffer(system, buffer);
 }
 
+MojoResult MojoSystemImplCreateWaitSet(MojoSystemImpl system,
+                                       MojoHandle* wait_set_handle) {
+  assert(g_system_impl_thunks.CreateWaitSet);
+  return g_system_impl_thunks.CreateWaitSet(system, wait_set_handle);
+}
+
+MojoResult MojoSystemImplAddHandle(MojoSystemImpl system,
+                                   MojoHandle wait_set_handle,
+                                   MojoHandle handle,
+                                   MojoHandleSignals signals) {
+  assert(g_system_impl_thunks.AddHandle);
+  return g_system_impl_thunks.AddHandle(system, wait_set_handle, handle,
+                                        signals);
+}
+
+MojoResult MojoSystemImplRemoveHandle(MojoSystemImpl system,
+                                      MojoHandle wait_set_handle,
+                                      MojoHandle handle) {
+  assert(g_system_impl_thunks.RemoveHandle);
+  return g_system_impl_thunks.RemoveHandle(system, wait_set_handle, handle);
+}
+
+MojoResult MojoSystemImplGetReadyHandles(
+    MojoSystemImpl system,
+    MojoHandle wait_set_handle,
+    uint32_t* count,
+    MojoHandle* handles,
+    MojoResult* results,
+    struct MojoHandleSignalsState* signals_states) {
+  assert(g_system_impl_thunks.GetReadyHandles);
+  return g_system_impl_thunks.GetReadyHandles(system, wait_set_handle, count,
+                                              handles, results, signals_states);
+}
+
+MojoResult MojoSystemImplReadMessages(MojoSystemImpl system,
+                                      MojoHandle message_pipe_handle,
+                                      void* bytes,
+                                      uint32_t* num_bytes,
+                                      MojoHandle* handles,
+                                      uint32_t* num_handles,
+                                      uint32_t* message_num_bytes,
+                                      uint32_t* message_num_handles,
+                                      uint32_t* num_messages,
+                                      MojoReadMessageFlags flags) {
+  assert(g_system_impl_thunks.ReadMessages);
+  return g_system_impl_thunks.ReadMessages(
+      system, message_pipe_handle, bytes, num_bytes, handles, num_handles,
+      message_num_bytes, message_num_handles, num_messages, flags);
+}
+
+MojoResult MojoSystemImplWriteMessages(MojoSystemImpl system,
+                                       MojoHandle message_pipe_handle,
+                                       const void* bytes,
+                                       uint32_t num_bytes,
+                                       const MojoHandle* handles,
+                                       uint32_t num_handles,
+                                       const uint32_t* message_num_bytes,
+                                       const uint32_t* message_num_handles,
+                                       uint32_t num_messages,
+                                       MojoWriteMessageFlags flags) {
+  assert(g_system_impl_thunks.WriteMessages);
+  return g_system_impl_thunks.WriteMessages(
+      system, message_pipe_handle, bytes, num_bytes, handles, num_handles,
+      message_num_bytes, message_num_handles, num_messages, flags);
+}
+
+MojoResult MojoSystemImplWriteMessageContext(
+    MojoSystemImpl system,
+    MojoHandle message_pipe_handle,
+    uintptr_t context,
+    const struct MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  assert(g_system_impl_thunks.WriteMessageContext);
+  return g_system_impl_thunks.WriteMessageContext(system, message_pipe_handle,
+                                                  context, thunks, flags);
+}
+
+MojoResult MojoSystemImplReadMessageContext(
+    MojoSystemImpl system,
+    MojoHandle message_pipe_handle,
+    const struct MojoMessageContextThunks* thunks,
+    uintptr_t* context,
+    void* bytes,
+    uint32_t* num_bytes,
+    MojoHandle* handles,
+    uint32_t* num_handles,
+    MojoReadMessageFlags flags) {
+  assert(g_system_impl_thunks.ReadMessageContext);
+  return g_system_impl_thunks.ReadMessageContext(
+      system, message_pipe_handle, thunks, context, bytes, num_bytes, handles,
+      num_handles, flags);
+}
+
+MojoResult MojoSystemImplSetDataPipeProducerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_producer_handle,
+    const struct MojoDataPipeProducerOptions* options) {
+  assert(g_system_impl_thunks.SetDataPipeProducerOptions);
+  return g_system_impl_thunks.SetDataPipeProducerOptions(
+      system, data_pipe_producer_handle, options);
+}
+
+MojoResult MojoSystemImplGetDataPipeProducerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_producer_handle,
+    struct MojoDataPipeProducerOptions* options,
+    uint32_t options_num_bytes) {
+  assert(g_system_impl_thunks.GetDataPipeProducerOptions);
+  return g_system_impl_thunks.GetDataPipeProducerOptions(
+      system, data_pipe_producer_handle, options, options_num_bytes);
+}
+
+MojoResult MojoSystemImplSetDataPipeConsumerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_consumer_handle,
+    const struct MojoDataPipeConsumerOptions* options) {
+  assert(g_system_impl_thunks.SetDataPipeConsumerOptions);
+  return g_system_impl_thunks.SetDataPipeConsumerOptions(
+      system, data_pipe_consumer_handle, options);
+}
+
+MojoResult MojoSystemImplGetDataPipeConsumerOptions(
+    MojoSystemImpl system,
+    MojoHandle data_pipe_consumer_handle,
+    struct MojoDataPipeConsumerOptions* options,
+    uint32_t options_num_bytes) {
+  assert(g_system_impl_thunks.GetDataPipeConsumerOptions);
+  return g_system_impl_thunks.GetDataPipeConsumerOptions(
+      system, data_pipe_consumer_handle, options, options_num_bytes);
+}
+
 extern "C" THUNK_EXPORT size_t MojoSetSystemImplControlThunksPrivate(
     const MojoSystemImplControlThunksPrivate* system_thunks) {
   if (system_thunks->size >= sizeof(g_system_impl_control_thunks))
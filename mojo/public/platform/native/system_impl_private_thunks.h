@@ -107,6 +107,75 @@ struct MojoSystemImplThunksPrivate {
                           void** buffer,
                           MojoMapBufferFlags flags);
   MojoResult (*UnmapBuffer)(MojoSystemImpl system, void* buffer);
+  MojoResult (*CreateWaitSet)(MojoSystemImpl system,
+                              MojoHandle* wait_set_handle);
+  MojoResult (*AddHandle)(MojoSystemImpl system,
+                          MojoHandle wait_set_handle,
+                          MojoHandle handle,
+                          MojoHandleSignals signals);
+  MojoResult (*RemoveHandle)(MojoSystemImpl system,
+                             MojoHandle wait_set_handle,
+                             MojoHandle handle);
+  MojoResult (*GetReadyHandles)(MojoSystemImpl system,
+                                MojoHandle wait_set_handle,
+                                uint32_t* count,
+                                MojoHandle* handles,
+                                MojoResult* results,
+                                struct MojoHandleSignalsState* signals_states);
+  MojoResult (*ReadMessages)(MojoSystemImpl system,
+                             MojoHandle message_pipe_handle,
+                             void* bytes,
+                             uint32_t* num_bytes,
+                             MojoHandle* handles,
+                             uint32_t* num_handles,
+                             uint32_t* message_num_bytes,
+                             uint32_t* message_num_handles,
+                             uint32_t* num_messages,
+                             MojoReadMessageFlags flags);
+  MojoResult (*WriteMessages)(MojoSystemImpl system,
+                              MojoHandle message_pipe_handle,
+                              const void* bytes,
+                              uint32_t num_bytes,
+                              const MojoHandle* handles,
+                              uint32_t num_handles,
+                              const uint32_t* message_num_bytes,
+                              const uint32_t* message_num_handles,
+                              uint32_t num_messages,
+                              MojoWriteMessageFlags flags);
+  MojoResult (*WriteMessageContext)(
+      MojoSystemImpl system,
+      MojoHandle message_pipe_handle,
+      uintptr_t context,
+      const struct MojoMessageContextThunks* thunks,
+      MojoWriteMessageFlags flags);
+  MojoResult (*ReadMessageContext)(
+      MojoSystemImpl system,
+      MojoHandle message_pipe_handle,
+      const struct MojoMessageContextThunks* thunks,
+      uintptr_t* context,
+      void* bytes,
+      uint32_t* num_bytes,
+      MojoHandle* handles,
+      uint32_t* num_handles,
+      MojoReadMessageFlags flags);
+  MojoResult (*SetDataPipeProducerOptions)(
+      MojoSystemImpl system,
+      MojoHandle data_pipe_producer_handle,
+      const struct MojoDataPipeProducerOptions* options);
+  MojoResult (*GetDataPipeProducerOptions)(
+      MojoSystemImpl system,
+      MojoHandle data_pipe_producer_handle,
+      struct MojoDataPipeProducerOptions* options,
+      uint32_t options_num_bytes);
+  MojoResult (*SetDataPipeConsumerOptions)(
+      MojoSystemImpl system,
+      MojoHandle data_pipe_consumer_handle,
+      const struct MojoDataPipeConsumerOptions* options);
+  MojoResult (*GetDataPipeConsumerOptions)(
+      MojoSystemImpl system,
+      MojoHandle data_pipe_consumer_handle,
+      struct MojoDataPipeConsumerOptions* options,
+      uint32_t options_num_bytes);
 };
 #pragma pack(pop)
 
@@ -141,7 +210,19 @@ inline MojoSystemImplThunksPrivate MojoMakeSystemImplThunksPrivate() {
       MojoSystemImplCreateSharedBuffer,
       MojoSystemImplDuplicateBufferHandle,
       MojoSystemImplMapBuffer,
-      MojoSystemImplUnmapBuffer};
+      MojoSystemImplUnmapBuffer,
+      MojoSystemImplCreateWaitSet,
+      MojoSystemImplAddHandle,
+      MojoSystemImplRemoveHandle,
+      MojoSystemImplGetReadyHandles,
+      MojoSystemImplReadMessages,
+      MojoSystemImplWriteMessages,
+      MojoSystemImplWriteMessageContext,
+      MojoSystemImplReadMessageContext,
+      MojoSystemImplSetDataPipeProducerOptions,
+      MojoSystemImplGetDataPipeProducerOptions,
+      MojoSystemImplSetDataPipeConsumerOptions,
+      MojoSystemImplGetDataPipeConsumerOptions};
   return system_thunks;
 }
 
@@ -158,6 +158,121 @@ MojoResult MojoUnmapBuffer(void* buffer) {
   return g_thunks.UnmapBuffer(buffer);
 }
 
+MojoResult MojoCreateWaitSet(MojoHandle* wait_set_handle) {
+  assert(g_thunks.CreateWaitSet);
+  return g_thunks.CreateWaitSet(wait_set_handle);
+}
+
+MojoResult MojoAddHandle(MojoHandle wait_set_handle,
+                         MojoHandle handle,
+                         MojoHandleSignals signals) {
+  assert(g_thunks.AddHandle);
+  return g_thunks.AddHandle(wait_set_handle, handle, signals);
+}
+
+MojoResult MojoRemoveHandle(MojoHandle wait_set_handle, MojoHandle handle) {
+  assert(g_thunks.RemoveHandle);
+  return g_thunks.RemoveHandle(wait_set_handle, handle);
+}
+
+MojoResult MojoGetReadyHandles(MojoHandle wait_set_handle,
+                               uint32_t* count,
+                               MojoHandle* handles,
+                               MojoResult* results,
+                               struct MojoHandleSignalsState* signals_states) {
+  assert(g_thunks.GetReadyHandles);
+  return g_thunks.GetReadyHandles(wait_set_handle, count, handles, results,
+                                  signals_states);
+}
+
+MojoResult MojoReadMessages(MojoHandle message_pipe_handle,
+                            void* bytes,
+                            uint32_t* num_bytes,
+                            MojoHandle* handles,
+                            uint32_t* num_handles,
+                            uint32_t* message_num_bytes,
+                            uint32_t* message_num_handles,
+                            uint32_t* num_messages,
+                            MojoReadMessageFlags flags) {
+  assert(g_thunks.ReadMessages);
+  return g_thunks.ReadMessages(message_pipe_handle, bytes, num_bytes, handles,
+                               num_handles, message_num_bytes,
+                               message_num_handles, num_messages, flags);
+}
+
+MojoResult MojoWriteMessages(MojoHandle message_pipe_handle,
+                             const void* bytes,
+                             uint32_t num_bytes,
+                             const MojoHandle* handles,
+                             uint32_t num_handles,
+                             const uint32_t* message_num_bytes,
+                             const uint32_t* message_num_handles,
+                             uint32_t num_messages,
+                             MojoWriteMessageFlags flags) {
+  assert(g_thunks.WriteMessages);
+  return g_thunks.WriteMessages(message_pipe_handle, bytes, num_bytes, handles,
+                                num_handles, message_num_bytes,
+                                message_num_handles, num_messages, flags);
+}
+
+MojoResult MojoWriteMessageContext(
+    MojoHandle message_pipe_handle,
+    uintptr_t context,
+    const struct MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  assert(g_thunks.WriteMessageContext);
+  return g_thunks.WriteMessageContext(message_pipe_handle, context, thunks,
+                                      flags);
+}
+
+MojoResult MojoReadMessageContext(MojoHandle message_pipe_handle,
+                                  const struct MojoMessageContextThunks* thunks,
+                                  uintptr_t* context,
+                                  void* bytes,
+                                  uint32_t* num_bytes,
+                                  MojoHandle* handles,
+                                  uint32_t* num_handles,
+                                  MojoReadMessageFlags flags) {
+  assert(g_thunks.ReadMessageContext);
+  return g_thunks.ReadMessageContext(message_pipe_handle, thunks, context,
+                                     bytes, num_bytes, handles, num_handles,
+                                     flags);
+}
+
+MojoResult MojoSetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    const struct MojoDataPipeProducerOptions* options) {
+  assert(g_thunks.SetDataPipeProducerOptions);
+  return g_thunks.SetDataPipeProducerOptions(data_pipe_producer_handle,
+                                             options);
+}
+
+MojoResult MojoGetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    struct MojoDataPipeProducerOptions* options,
+    uint32_t options_num_bytes) {
+  assert(g_thunks.GetDataPipeProducerOptions);
+  return g_thunks.GetDataPipeProducerOptions(data_pipe_producer_handle,
+                                             options, options_num_bytes);
+}
+
+MojoResult MojoSetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    const struct MojoDataPipeConsumerOptions* options) {
+  assert(g_thunks.SetDataPipeConsumerOptions);
+  return g_thunks.SetDataPipeConsumerOptions(data_pipe_consumer_handle,
+                                             options);
+}
+
+MojoResult MojoGetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    struct MojoDataPipeConsumerOptions* options,
+    uint32_t options_num_bytes) {
+  assert(g_thunks.GetDataPipeConsumerOptions);
+  return g_thunks.GetDataPipeConsumerOptions(data_pipe_consumer_handle,
+                                             options, options_num_bytes);
+}
+
 extern "C" THUNK_EXPORT size_t MojoSetSystemThunks(
     const MojoSystemThunks* system_thunks) {
   if (system_thunks->size >= sizeof(g_thunks))
@@ -101,6 +101,62 @@ struct MojoSystemThunks {
                           void** buffer,
                           MojoMapBufferFlags flags);
   MojoResult (*UnmapBuffer)(void* buffer);
+  MojoResult (*CreateWaitSet)(MojoHandle* wait_set_handle);
+  MojoResult (*AddHandle)(MojoHandle wait_set_handle,
+                          MojoHandle handle,
+                          MojoHandleSignals signals);
+  MojoResult (*RemoveHandle)(MojoHandle wait_set_handle, MojoHandle handle);
+  MojoResult (*GetReadyHandles)(MojoHandle wait_set_handle,
+                                uint32_t* count,
+                                MojoHandle* handles,
+                                MojoResult* results,
+                                struct MojoHandleSignalsState* signals_states);
+  MojoResult (*ReadMessages)(MojoHandle message_pipe_handle,
+                             void* bytes,
+                             uint32_t* num_bytes,
+                             MojoHandle* handles,
+                             uint32_t* num_handles,
+                             uint32_t* message_num_bytes,
+                             uint32_t* message_num_handles,
+                             uint32_t* num_messages,
+                             MojoReadMessageFlags flags);
+  MojoResult (*WriteMessages)(MojoHandle message_pipe_handle,
+                              const void* bytes,
+                              uint32_t num_bytes,
+                              const MojoHandle* handles,
+                              uint32_t num_handles,
+                              const uint32_t* message_num_bytes,
+                              const uint32_t* message_num_handles,
+                              uint32_t num_messages,
+                              MojoWriteMessageFlags flags);
+  MojoResult (*WriteMessageContext)(
+      MojoHandle message_pipe_handle,
+      uintptr_t context,
+      const struct MojoMessageContextThunks* thunks,
+      MojoWriteMessageFlags flags);
+  MojoResult (*ReadMessageContext)(
+      MojoHandle message_pipe_handle,
+      const struct MojoMessageContextThunks* thunks,
+      uintptr_t* context,
+      void* bytes,
+      uint32_t* num_bytes,
+      MojoHandle* handles,
+      uint32_t* num_handles,
+      MojoReadMessageFlags flags);
+  MojoResult (*SetDataPipeProducerOptions)(
+      MojoHandle data_pipe_producer_handle,
+      const struct MojoDataPipeProducerOptions* options);
+  MojoResult (*GetDataPipeProducerOptions)(
+      MojoHandle data_pipe_producer_handle,
+      struct MojoDataPipeProducerOptions* options,
+      uint32_t options_num_bytes);
+  MojoResult (*SetDataPipeConsumerOptions)(
+      MojoHandle data_pipe_consumer_handle,
+      const struct MojoDataPipeConsumerOptions* options);
+  MojoResult (*GetDataPipeConsumerOptions)(
+      MojoHandle data_pipe_consumer_handle,
+      struct MojoDataPipeConsumerOptions* options,
+      uint32_t options_num_bytes);
 };
 #pragma pack(pop)
 
@@ -127,7 +183,19 @@ inline MojoSystemThunks MojoMakeSystemThunks() {
                                     MojoCreateSharedBuffer,
                                     MojoDuplicateBufferHandle,
                                     MojoMapBuffer,
-                                    MojoUnmapBuffer};
+                                    MojoUnmapBuffer,
+                                    MojoCreateWaitSet,
+                                    MojoAddHandle,
+                                    MojoRemoveHandle,
+                                    MojoGetReadyHandles,
+                                    MojoReadMessages,
+                                    MojoWriteMessages,
+                                    MojoWriteMessageContext,
+                                    MojoReadMessageContext,
+                                    MojoSetDataPipeProducerOptions,
+                                    MojoGetDataPipeProducerOptions,
+                                    MojoSetDataPipeConsumerOptions,
+                                    MojoGetDataPipeConsumerOptions};
   return system_thunks;
 }
 #endif
@@ -246,6 +246,57 @@ def GetUnionGetterReturnType(kind):
     return "%s&" % GetCppWrapperType(kind)
   return GetCppResultWrapperType(kind)
 
+def IsDataViewableKind(kind):
+  """Returns whether a field of the given kind can be read in place using a
+  data view (see mojo/public/cpp/bindings/data_view.h). Handles, interfaces
+  and maps must be taken out of or deserialized from the message instead."""
+  if mojom.IsArrayKind(kind):
+    return (not mojom.IsUnionKind(kind.kind) and
+            IsDataViewableKind(kind.kind))
+  if (mojom.IsStringKind(kind) or mojom.IsStructKind(kind) or
+      mojom.IsUnionKind(kind) or mojom.IsEnumKind(kind)):
+    return True
+  return kind in _kind_to_cpp_type and not mojom.IsAnyHandleKind(kind)
+
+def GetCppDataViewType(kind):
+  if mojom.IsEnumKind(kind):
+    return GetNameForKind(kind)
+  if mojom.IsStructKind(kind) or mojom.IsUnionKind(kind):
+    return "%sDataView" % GetNameForKind(kind)
+  if mojom.IsArrayKind(kind):
+    return "mojo::ArrayDataView<%s>" % GetCppDataViewType(kind.kind)
+  if mojom.IsStringKind(kind):
+    return "mojo::StringDataView"
+  return _kind_to_cpp_type[kind]
+
+def UsesDataView(method):
+  """Returns whether the stub should pass views of |method|'s parameters to
+  the implementation (the method has the [CppDataView=1] attribute)."""
+  return bool(method.attributes and method.attributes.get("CppDataView"))
+
+def IsSyncMethod(method):
+  """Returns whether the proxy should wait for |method|'s response before
+  returning (the method has a response and the [Sync=1] attribute)."""
+  return (method.response_parameters is not None and
+          bool(method.attributes and method.attributes.get("Sync")))
+
+def UsesLocalDispatch(method):
+  """Returns whether the proxy should pass |method|'s parameters to the stub
+  unserialized when they're in the same process (the method has the
+  [LocalDispatch=1] attribute). This isn't supported for methods that take data
+  views or whose parameters may contain handles."""
+  return (bool(method.attributes and method.attributes.get("LocalDispatch")) and
+          not UsesDataView(method) and
+          all(mojom.IsCloneableKind(param.kind)
+              for param in method.parameters))
+
+def HasLocalDispatchMethods(interface):
+  return any(UsesLocalDispatch(method) for method in interface.methods)
+
+def ToCamel(name):
+  return ''.join(word[0].upper() + word[1:] for word in name.split('_')
+                 if word)
+
 def TranslateConstants(token, kind):
   if isinstance(token, mojom.NamedValue):
     # Both variable and enum constants are constructed like:
@@ -344,6 +395,7 @@ class Generator(generator.Generator):
   cpp_filters = {
     "constant_value": ConstantValue,
     "cpp_const_wrapper_type": GetCppConstWrapperType,
+    "cpp_data_view_type": GetCppDataViewType,
     "cpp_field_type": GetCppFieldType,
     "cpp_union_field_type": GetCppUnionFieldType,
     "cpp_pod_type": GetCppPodType,
@@ -358,10 +410,12 @@ class Generator(generator.Generator):
     "get_name_for_kind": GetNameForKind,
     "get_pad": pack.GetPad,
     "has_callbacks": mojom.HasCallbacks,
+    "has_local_dispatch_methods": HasLocalDispatchMethods,
     "should_inline": ShouldInlineStruct,
     "should_inline_union": ShouldInlineUnion,
     "is_array_kind": mojom.IsArrayKind,
     "is_cloneable_kind": mojom.IsCloneableKind,
+    "is_data_viewable_kind": IsDataViewableKind,
     "is_enum_kind": mojom.IsEnumKind,
     "is_integral_kind": mojom.IsIntegralKind,
     "is_move_only_kind": mojom.IsMoveOnlyKind,
@@ -373,11 +427,15 @@ class Generator(generator.Generator):
     "is_object_kind": mojom.IsObjectKind,
     "is_string_kind": mojom.IsStringKind,
     "is_struct_kind": mojom.IsStructKind,
+    "is_sync_method": IsSyncMethod,
     "is_union_kind": mojom.IsUnionKind,
     "struct_size": lambda ps: ps.GetTotalSize() + _HEADER_SIZE,
     "stylize_method": generator.StudlyCapsToCamel,
     "to_all_caps": generator.CamelCaseToAllCaps,
+    "to_camel": ToCamel,
     "under_to_camel": generator.UnderToCamel,
+    "uses_data_view": UsesDataView,
+    "uses_local_dispatch": UsesLocalDispatch,
   }
 
   def GetJinjaExports(self):
@@ -327,6 +327,15 @@ void ViewManagerClientImpl::OnViewBoundsChanged(Id view_id,
   ViewPrivate(view).LocalSetBounds(*old_bounds, *new_bounds);
 }
 
+void ViewManagerClientImpl::OnViewsBoundsChanged(
+    Array<ViewBoundsChangePtr> changes) {
+  for (size_t i = 0; i < changes.size(); ++i) {
+    View* view = GetViewById(changes[i]->view_id);
+    ViewPrivate(view).LocalSetBounds(*changes[i]->old_bounds,
+                                     *changes[i]->new_bounds);
+  }
+}
+
 namespace {
 
 void SetViewportMetricsOnDecendants(View* root,
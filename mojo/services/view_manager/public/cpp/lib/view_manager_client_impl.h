@@ -101,6 +101,7 @@ class ViewManagerClientImpl : public ViewManager,
   void OnViewBoundsChanged(Id view_id,
                            RectPtr old_bounds,
                            RectPtr new_bounds) override;
+  void OnViewsBoundsChanged(Array<ViewBoundsChangePtr> changes) override;
   void OnViewViewportMetricsChanged(ViewportMetricsPtr old_metrics,
                                     ViewportMetricsPtr new_metrics) override;
   void OnViewHierarchyChanged(Id view_id,
@@ -310,16 +310,225 @@ static MojoResult irt_MojoReadMessage(
   return result;
 };
 
-static MojoResult irt__MojoGetInitialHandle(MojoHandle* handle) {
+static MojoResult irt_MojoCreateWaitSet(MojoHandle* wait_set_handle) {
   uint32_t params[3];
   MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
   params[0] = 18;
+  params[1] = (uint32_t)(wait_set_handle);
+  params[2] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoAddHandle(
+    MojoHandle wait_set_handle,
+    MojoHandle handle,
+    MojoHandleSignals signals) {
+  uint32_t params[5];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 19;
+  params[1] = (uint32_t)(&wait_set_handle);
+  params[2] = (uint32_t)(&handle);
+  params[3] = (uint32_t)(&signals);
+  params[4] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoRemoveHandle(
+    MojoHandle wait_set_handle,
+    MojoHandle handle) {
+  uint32_t params[4];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 20;
+  params[1] = (uint32_t)(&wait_set_handle);
+  params[2] = (uint32_t)(&handle);
+  params[3] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoGetReadyHandles(
+    MojoHandle wait_set_handle,
+    uint32_t* count,
+    MojoHandle* handles,
+    MojoResult* results,
+    struct MojoHandleSignalsState* signals_states) {
+  uint32_t params[7];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 21;
+  params[1] = (uint32_t)(&wait_set_handle);
+  params[2] = (uint32_t)(count);
+  params[3] = (uint32_t)(handles);
+  params[4] = (uint32_t)(results);
+  params[5] = (uint32_t)(signals_states);
+  params[6] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt__MojoGetInitialHandle(MojoHandle* handle) {
+  uint32_t params[3];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 22;
   params[1] = (uint32_t)(handle);
   params[2] = (uint32_t)(&result);
   DoMojoCall(params, sizeof(params));
   return result;
 };
 
+static MojoResult irt_MojoReadMessages(
+    MojoHandle message_pipe_handle,
+    void* bytes,
+    uint32_t* num_bytes,
+    MojoHandle* handles,
+    uint32_t* num_handles,
+    uint32_t* message_num_bytes,
+    uint32_t* message_num_handles,
+    uint32_t* num_messages,
+    MojoReadMessageFlags flags) {
+  uint32_t params[11];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 23;
+  params[1] = (uint32_t)(&message_pipe_handle);
+  params[2] = (uint32_t)(bytes);
+  params[3] = (uint32_t)(num_bytes);
+  params[4] = (uint32_t)(handles);
+  params[5] = (uint32_t)(num_handles);
+  params[6] = (uint32_t)(message_num_bytes);
+  params[7] = (uint32_t)(message_num_handles);
+  params[8] = (uint32_t)(num_messages);
+  params[9] = (uint32_t)(&flags);
+  params[10] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoWriteMessages(
+    MojoHandle message_pipe_handle,
+    const void* bytes,
+    uint32_t num_bytes,
+    const MojoHandle* handles,
+    uint32_t num_handles,
+    const uint32_t* message_num_bytes,
+    const uint32_t* message_num_handles,
+    uint32_t num_messages,
+    MojoWriteMessageFlags flags) {
+  uint32_t params[11];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 24;
+  params[1] = (uint32_t)(&message_pipe_handle);
+  params[2] = (uint32_t)(bytes);
+  params[3] = (uint32_t)(&num_bytes);
+  params[4] = (uint32_t)(handles);
+  params[5] = (uint32_t)(&num_handles);
+  params[6] = (uint32_t)(message_num_bytes);
+  params[7] = (uint32_t)(message_num_handles);
+  params[8] = (uint32_t)(&num_messages);
+  params[9] = (uint32_t)(&flags);
+  params[10] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoWriteMessageContext(
+    MojoHandle message_pipe_handle,
+    uintptr_t context,
+    const struct MojoMessageContextThunks* thunks,
+    MojoWriteMessageFlags flags) {
+  uint32_t params[6];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 25;
+  params[1] = (uint32_t)(&message_pipe_handle);
+  params[2] = (uint32_t)(&context);
+  params[3] = (uint32_t)(&thunks);
+  params[4] = (uint32_t)(&flags);
+  params[5] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoReadMessageContext(
+    MojoHandle message_pipe_handle,
+    const struct MojoMessageContextThunks* thunks,
+    uintptr_t* context,
+    void* bytes,
+    uint32_t* num_bytes,
+    MojoHandle* handles,
+    uint32_t* num_handles,
+    MojoReadMessageFlags flags) {
+  uint32_t params[10];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 26;
+  params[1] = (uint32_t)(&message_pipe_handle);
+  params[2] = (uint32_t)(&thunks);
+  params[3] = (uint32_t)(context);
+  params[4] = (uint32_t)(bytes);
+  params[5] = (uint32_t)(num_bytes);
+  params[6] = (uint32_t)(handles);
+  params[7] = (uint32_t)(num_handles);
+  params[8] = (uint32_t)(&flags);
+  params[9] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoSetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    const struct MojoDataPipeProducerOptions* options) {
+  uint32_t params[4];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 27;
+  params[1] = (uint32_t)(&data_pipe_producer_handle);
+  params[2] = (uint32_t)(options);
+  params[3] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoGetDataPipeProducerOptions(
+    MojoHandle data_pipe_producer_handle,
+    struct MojoDataPipeProducerOptions* options,
+    uint32_t options_num_bytes) {
+  uint32_t params[5];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 28;
+  params[1] = (uint32_t)(&data_pipe_producer_handle);
+  params[2] = (uint32_t)(options);
+  params[3] = (uint32_t)(&options_num_bytes);
+  params[4] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoSetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    const struct MojoDataPipeConsumerOptions* options) {
+  uint32_t params[4];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 29;
+  params[1] = (uint32_t)(&data_pipe_consumer_handle);
+  params[2] = (uint32_t)(options);
+  params[3] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
+static MojoResult irt_MojoGetDataPipeConsumerOptions(
+    MojoHandle data_pipe_consumer_handle,
+    struct MojoDataPipeConsumerOptions* options,
+    uint32_t options_num_bytes) {
+  uint32_t params[5];
+  MojoResult result = MOJO_RESULT_INVALID_ARGUMENT;
+  params[0] = 30;
+  params[1] = (uint32_t)(&data_pipe_consumer_handle);
+  params[2] = (uint32_t)(options);
+  params[3] = (uint32_t)(&options_num_bytes);
+  params[4] = (uint32_t)(&result);
+  DoMojoCall(params, sizeof(params));
+  return result;
+};
+
 struct nacl_irt_mojo kIrtMojo = {
   &irt_MojoCreateSharedBuffer,
   &irt_MojoDuplicateBufferHandle,
@@ -339,7 +548,19 @@ struct nacl_irt_mojo kIrtMojo = {
   &irt_MojoCreateMessagePipe,
   &irt_MojoWriteMessage,
   &irt_MojoReadMessage,
+  &irt_MojoCreateWaitSet,
+  &irt_MojoAddHandle,
+  &irt_MojoRemoveHandle,
+  &irt_MojoGetReadyHandles,
   &irt__MojoGetInitialHandle,
+  &irt_MojoReadMessages,
+  &irt_MojoWriteMessages,
+  &irt_MojoWriteMessageContext,
+  &irt_MojoReadMessageContext,
+  &irt_MojoSetDataPipeProducerOptions,
+  &irt_MojoGetDataPipeProducerOptions,
+  &irt_MojoSetDataPipeConsumerOptions,
+  &irt_MojoGetDataPipeConsumerOptions,
 };
 
 
@@ -639,6 +639,152 @@ ssize_t MojoDescSendMsg(void* handle,
       return 0;
     }
     case 18: {
+      if (num_params != 3) {
+        return -1;
+      }
+      MojoHandle volatile* wait_set_handle_ptr;
+      MojoHandle wait_set_handle_value;
+      MojoResult volatile* result_ptr;
+      MojoResult result_value;
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (!ConvertScalarInOut(nap, params[1], false, &wait_set_handle_value,
+                                &wait_set_handle_ptr)) {
+          return -1;
+        }
+        if (!ConvertScalarOutput(nap, params[2], false, &result_ptr)) {
+          return -1;
+        }
+      }
+
+      result_value =
+          MojoSystemImplCreateWaitSet(g_mojo_system, &wait_set_handle_value);
+
+      {
+        ScopedCopyLock copy_lock(nap);
+        *wait_set_handle_ptr = wait_set_handle_value;
+        *result_ptr = result_value;
+      }
+
+      return 0;
+    }
+    case 19: {
+      if (num_params != 5) {
+        return -1;
+      }
+      MojoHandle wait_set_handle_value;
+      MojoHandle handle_value;
+      MojoHandleSignals signals_value;
+      MojoResult volatile* result_ptr;
+      MojoResult result_value;
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (!ConvertScalarInput(nap, params[1], &wait_set_handle_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInput(nap, params[2], &handle_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInput(nap, params[3], &signals_value)) {
+          return -1;
+        }
+        if (!ConvertScalarOutput(nap, params[4], false, &result_ptr)) {
+          return -1;
+        }
+      }
+
+      result_value = MojoSystemImplAddHandle(
+          g_mojo_system, wait_set_handle_value, handle_value, signals_value);
+
+      {
+        ScopedCopyLock copy_lock(nap);
+        *result_ptr = result_value;
+      }
+
+      return 0;
+    }
+    case 20: {
+      if (num_params != 4) {
+        return -1;
+      }
+      MojoHandle wait_set_handle_value;
+      MojoHandle handle_value;
+      MojoResult volatile* result_ptr;
+      MojoResult result_value;
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (!ConvertScalarInput(nap, params[1], &wait_set_handle_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInput(nap, params[2], &handle_value)) {
+          return -1;
+        }
+        if (!ConvertScalarOutput(nap, params[3], false, &result_ptr)) {
+          return -1;
+        }
+      }
+
+      result_value = MojoSystemImplRemoveHandle(
+          g_mojo_system, wait_set_handle_value, handle_value);
+
+      {
+        ScopedCopyLock copy_lock(nap);
+        *result_ptr = result_value;
+      }
+
+      return 0;
+    }
+    case 21: {
+      if (num_params != 7) {
+        return -1;
+      }
+      MojoHandle wait_set_handle_value;
+      uint32_t volatile* count_ptr;
+      uint32_t count_value;
+      MojoHandle* handles;
+      MojoResult* results;
+      struct MojoHandleSignalsState* signals_states;
+      MojoResult volatile* result_ptr;
+      MojoResult result_value;
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (!ConvertScalarInput(nap, params[1], &wait_set_handle_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInOut(nap, params[2], false, &count_value,
+                                &count_ptr)) {
+          return -1;
+        }
+        if (!ConvertScalarOutput(nap, params[6], false, &result_ptr)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[3], count_value, sizeof(*handles), false,
+                          &handles)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[4], count_value, sizeof(*results), false,
+                          &results)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[5], count_value, sizeof(*signals_states),
+                          true, &signals_states)) {
+          return -1;
+        }
+      }
+
+      result_value = MojoSystemImplGetReadyHandles(
+          g_mojo_system, wait_set_handle_value, &count_value, handles, results,
+          signals_states);
+
+      {
+        ScopedCopyLock copy_lock(nap);
+        *count_ptr = count_value;
+        *result_ptr = result_value;
+      }
+
+      return 0;
+    }
+    case 22: {
       if (num_params != 3) {
         return -1;
       }
@@ -667,6 +813,228 @@ ssize_t MojoDescSendMsg(void* handle,
 
       return 0;
     }
+    case 23: {
+      if (num_params != 11) {
+        return -1;
+      }
+      MojoHandle message_pipe_handle_value;
+      void* bytes;
+      uint32_t volatile* num_bytes_ptr;
+      uint32_t num_bytes_value;
+      MojoHandle* handles;
+      uint32_t volatile* num_handles_ptr;
+      uint32_t num_handles_value;
+      uint32_t* message_num_bytes;
+      uint32_t* message_num_handles;
+      uint32_t volatile* num_messages_ptr;
+      uint32_t num_messages_value;
+      MojoReadMessageFlags flags_value;
+      MojoResult volatile* result_ptr;
+      MojoResult result_value;
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (!ConvertScalarInput(nap, params[1], &message_pipe_handle_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInOut(nap, params[3], true, &num_bytes_value,
+                                &num_bytes_ptr)) {
+          return -1;
+        }
+        if (!ConvertScalarInOut(nap, params[5], true, &num_handles_value,
+                                &num_handles_ptr)) {
+          return -1;
+        }
+        if (!ConvertScalarInOut(nap, params[8], false, &num_messages_value,
+                                &num_messages_ptr)) {
+          return -1;
+        }
+        if (!ConvertScalarInput(nap, params[9], &flags_value)) {
+          return -1;
+        }
+        if (!ConvertScalarOutput(nap, params[10], false, &result_ptr)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[2], num_bytes_value, 1, true, &bytes)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[4], num_handles_value, sizeof(*handles),
+                          true, &handles)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[6], num_messages_value,
+                          sizeof(*message_num_bytes), false,
+                          &message_num_bytes)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[7], num_messages_value,
+                          sizeof(*message_num_handles), true,
+                          &message_num_handles)) {
+          return -1;
+        }
+      }
+
+      result_value = MojoSystemImplReadMessages(
+          g_mojo_system, message_pipe_handle_value, bytes,
+          num_bytes_ptr ? &num_bytes_value : NULL, handles,
+          num_handles_ptr ? &num_handles_value : NULL, message_num_bytes,
+          message_num_handles, &num_messages_value, flags_value);
+
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (num_bytes_ptr != NULL) {
+          *num_bytes_ptr = num_bytes_value;
+        }
+        if (num_handles_ptr != NULL) {
+          *num_handles_ptr = num_handles_value;
+        }
+        *num_messages_ptr = num_messages_value;
+        *result_ptr = result_value;
+      }
+
+      return 0;
+    }
+    case 24: {
+      if (num_params != 11) {
+        return -1;
+      }
+      MojoHandle message_pipe_handle_value;
+      const void* bytes;
+      uint32_t num_bytes_value;
+      const MojoHandle* handles;
+      uint32_t num_handles_value;
+      const uint32_t* message_num_bytes;
+      const uint32_t* message_num_handles;
+      uint32_t num_messages_value;
+      MojoWriteMessageFlags flags_value;
+      MojoResult volatile* result_ptr;
+      MojoResult result_value;
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (!ConvertScalarInput(nap, params[1], &message_pipe_handle_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInput(nap, params[3], &num_bytes_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInput(nap, params[5], &num_handles_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInput(nap, params[8], &num_messages_value)) {
+          return -1;
+        }
+        if (!ConvertScalarInput(nap, params[9], &flags_value)) {
+          return -1;
+        }
+        if (!ConvertScalarOutput(nap, params[10], false, &result_ptr)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[2], num_bytes_value, 1, true, &bytes)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[4], num_handles_value, sizeof(*handles),
+                          true, &handles)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[6], num_messages_value,
+                          sizeof(*message_num_bytes), false,
+                          &message_num_bytes)) {
+          return -1;
+        }
+        if (!ConvertArray(nap, params[7], num_messages_value,
+                          sizeof(*message_num_handles), true,
+                          &message_num_handles)) {
+          return -1;
+        }
+      }
+
+      result_value = MojoSystemImplWriteMessages(
+          g_mojo_system, message_pipe_handle_value, bytes, num_bytes_value,
+          handles, num_handles_value, message_num_bytes, message_num_handles,
+          num_messages_value, flags_value);
+
+      {
+        ScopedCopyLock copy_lock(nap);
+        *result_ptr = result_value;
+      }
+
+      return 0;
+    }
+    case 25:
+      fprintf(stderr, "MojoWriteMessageContext not implemented\n");
+      return -1;
+    case 26:
+      fprintf(stderr, "MojoReadMessageContext not implemented\n");
+      return -1;
+    case 27: {
+      if (num_params != 4) {
+        return -1;
+      }
+      MojoHandle data_pipe_producer_handle_value;
+      const struct MojoDataPipeProducerOptions* options;
+      MojoResult volatile* result_ptr;
+      MojoResult result_value;
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (!ConvertScalarInput(nap, params[1],
+                                &data_pipe_producer_handle_value)) {
+          return -1;
+        }
+        if (!ConvertExtensibleStructInput(nap, params[2], true, &options)) {
+          return -1;
+        }
+        if (!ConvertScalarOutput(nap, params[3], false, &result_ptr)) {
+          return -1;
+        }
+      }
+
+      result_value = MojoSystemImplSetDataPipeProducerOptions(
+          g_mojo_system, data_pipe_producer_handle_value, options);
+
+      {
+        ScopedCopyLock copy_lock(nap);
+        *result_ptr = result_value;
+      }
+
+      return 0;
+    }
+    case 28:
+      fprintf(stderr, "MojoGetDataPipeProducerOptions not implemented\n");
+      return -1;
+    case 29: {
+      if (num_params != 4) {
+        return -1;
+      }
+      MojoHandle data_pipe_consumer_handle_value;
+      const struct MojoDataPipeConsumerOptions* options;
+      MojoResult volatile* result_ptr;
+      MojoResult result_value;
+      {
+        ScopedCopyLock copy_lock(nap);
+        if (!ConvertScalarInput(nap, params[1],
+                                &data_pipe_consumer_handle_value)) {
+          return -1;
+        }
+        if (!ConvertExtensibleStructInput(nap, params[2], true, &options)) {
+          return -1;
+        }
+        if (!ConvertScalarOutput(nap, params[3], false, &result_ptr)) {
+          return -1;
+        }
+      }
+
+      result_value = MojoSystemImplSetDataPipeConsumerOptions(
+          g_mojo_system, data_pipe_consumer_handle_value, options);
+
+      {
+        ScopedCopyLock copy_lock(nap);
+        *result_ptr = result_value;
+      }
+
+      return 0;
+    }
+    case 30:
+      fprintf(stderr, "MojoGetDataPipeConsumerOptions not implemented\n");
+      return -1;
   }
 
   return -1;
@@ -123,12 +123,97 @@ def MakeInterface():
   f.Param('num_handles').InOut('uint32_t').Optional()
   f.Param('flags').In('MojoReadMessageFlags')
 
+  f = mojo.Func('MojoCreateWaitSet', 'MojoResult')
+  f.Param('wait_set_handle').Out('MojoHandle')
+
+  f = mojo.Func('MojoAddHandle', 'MojoResult')
+  f.Param('wait_set_handle').In('MojoHandle')
+  f.Param('handle').In('MojoHandle')
+  f.Param('signals').In('MojoHandleSignals')
+
+  f = mojo.Func('MojoRemoveHandle', 'MojoResult')
+  f.Param('wait_set_handle').In('MojoHandle')
+  f.Param('handle').In('MojoHandle')
+
+  f = mojo.Func('MojoGetReadyHandles', 'MojoResult')
+  f.Param('wait_set_handle').In('MojoHandle')
+  f.Param('count').InOut('uint32_t')
+  f.Param('handles').OutArray('MojoHandle', 'count')
+  f.Param('results').OutArray('MojoResult', 'count')
+  p = f.Param('signals_states')
+  p.OutFixedStructArray('MojoHandleSignalsState', 'count').Optional()
+
   # This function is not provided by the Mojo system APIs, but instead allows
   # trusted code to provide a handle for use by untrusted code. See the
   # implementation in mojo_syscall.cc.tmpl.
   f = mojo.Func('_MojoGetInitialHandle', 'MojoResult')
   f.Param('handle').Out('MojoHandle')
 
+  f = mojo.Func('MojoReadMessages', 'MojoResult')
+  f.Param('message_pipe_handle').In('MojoHandle')
+  f.Param('bytes').OutArray('void', 'num_bytes').Optional()
+  f.Param('num_bytes').InOut('uint32_t').Optional()
+  f.Param('handles').OutArray('MojoHandle', 'num_handles').Optional()
+  f.Param('num_handles').InOut('uint32_t').Optional()
+  f.Param('message_num_bytes').OutArray('uint32_t', 'num_messages')
+  f.Param('message_num_handles').OutArray('uint32_t', 'num_messages').Optional()
+  f.Param('num_messages').InOut('uint32_t')
+  f.Param('flags').In('MojoReadMessageFlags')
+
+  f = mojo.Func('MojoWriteMessages', 'MojoResult')
+  f.Param('message_pipe_handle').In('MojoHandle')
+  f.Param('bytes').InArray('void', 'num_bytes').Optional()
+  f.Param('num_bytes').In('uint32_t')
+  f.Param('handles').InArray('MojoHandle', 'num_handles').Optional()
+  f.Param('num_handles').In('uint32_t')
+  f.Param('message_num_bytes').InArray('uint32_t', 'num_messages')
+  f.Param('message_num_handles').InArray('uint32_t', 'num_messages').Optional()
+  f.Param('num_messages').In('uint32_t')
+  f.Param('flags').In('MojoWriteMessageFlags')
+
+  # The thunks point to untrusted code, which trusted code can't call.
+  f = mojo.Func('MojoWriteMessageContext', 'MojoResult')
+  f.Param('message_pipe_handle').In('MojoHandle')
+  f.Param('context').In('uintptr_t')
+  f.Param('thunks').In('const struct MojoMessageContextThunks*')
+  f.Param('flags').In('MojoWriteMessageFlags')
+  f.IsBrokenInNaCl()
+
+  f = mojo.Func('MojoReadMessageContext', 'MojoResult')
+  f.Param('message_pipe_handle').In('MojoHandle')
+  f.Param('thunks').In('const struct MojoMessageContextThunks*')
+  f.Param('context').Out('uintptr_t')
+  f.Param('bytes').OutArray('void', 'num_bytes').Optional()
+  f.Param('num_bytes').InOut('uint32_t').Optional()
+  f.Param('handles').OutArray('MojoHandle', 'num_handles').Optional()
+  f.Param('num_handles').InOut('uint32_t').Optional()
+  f.Param('flags').In('MojoReadMessageFlags')
+  f.IsBrokenInNaCl()
+
+  f = mojo.Func('MojoSetDataPipeProducerOptions', 'MojoResult')
+  f.Param('data_pipe_producer_handle').In('MojoHandle')
+  p = f.Param('options')
+  p.InExtensibleStruct('MojoDataPipeProducerOptions').Optional()
+
+  # Output extensible structs (which are written only up to a caller-given size,
+  # and not at all on failure) aren't supported yet.
+  f = mojo.Func('MojoGetDataPipeProducerOptions', 'MojoResult')
+  f.Param('data_pipe_producer_handle').In('MojoHandle')
+  f.Param('options').Out('struct MojoDataPipeProducerOptions')
+  f.Param('options_num_bytes').In('uint32_t')
+  f.IsBrokenInNaCl()
+
+  f = mojo.Func('MojoSetDataPipeConsumerOptions', 'MojoResult')
+  f.Param('data_pipe_consumer_handle').In('MojoHandle')
+  p = f.Param('options')
+  p.InExtensibleStruct('MojoDataPipeConsumerOptions').Optional()
+
+  f = mojo.Func('MojoGetDataPipeConsumerOptions', 'MojoResult')
+  f.Param('data_pipe_consumer_handle').In('MojoHandle')
+  f.Param('options').Out('struct MojoDataPipeConsumerOptions')
+  f.Param('options_num_bytes').In('uint32_t')
+  f.IsBrokenInNaCl()
+
   mojo.Finalize()
 
   return mojo
@@ -10,11 +10,18 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <limits>
 
+#include "base/bind.h"
 #include "base/files/scoped_file.h"
 #include "base/logging.h"
 #include "base/posix/eintr_wrapper.h"
+#include "mojo/common/handle_watcher.h"
+#include "mojo/public/cpp/system/buffer.h"
+#include "mojo/public/cpp/system/data_pipe.h"
+#include "mojo/public/cpp/system/handle.h"
+#include "mojo/public/platform/native/platform_handle_private.h"
 #include "services/files/shared_impl.h"
 #include "services/files/util.h"
 
@@ -26,6 +33,287 @@ namespace files {
 
 const size_t kMaxReadSize = 1 * 1024 * 1024;  // 1 MB.
 
+namespace {
+
+// Maps the result of a failed data pipe operation on a stream's data pipe to
+// an |Error|.
+Error DataPipeResultToError(MojoResult result) {
+  switch (result) {
+    case MOJO_RESULT_INVALID_ARGUMENT:
+      return ERROR_INVALID_ARGUMENT;
+    case MOJO_RESULT_FAILED_PRECONDITION:
+      return ERROR_CLOSED;
+    default:
+      return ERROR_UNKNOWN;
+  }
+}
+
+// Reads (at most) |num_bytes_to_read| bytes from |fd|, starting at |offset|,
+// into |source|. Data is read (using |pread()|, so the file position is
+// neither used nor changed) directly into the data pipe's buffer (using
+// two-phase writes), so the number of bytes in flight is bounded by the data
+// pipe's capacity. This runs on the service thread, waiting asynchronously
+// whenever the data pipe is full. It owns itself, and deletes itself after
+// running |callback|.
+class ReadToStreamTransfer {
+ public:
+  static void Start(base::ScopedFD fd,
+                    ScopedDataPipeProducerHandle source,
+                    int64_t offset,
+                    int64_t num_bytes_to_read,
+                    const Callback<void(Error)>& callback) {
+    (new ReadToStreamTransfer(fd.Pass(), source.Pass(), offset,
+                              num_bytes_to_read, callback))
+        ->Transfer();
+  }
+
+ private:
+  ReadToStreamTransfer(base::ScopedFD fd,
+                       ScopedDataPipeProducerHandle source,
+                       int64_t offset,
+                       int64_t num_bytes_to_read,
+                       const Callback<void(Error)>& callback)
+      : fd_(fd.Pass()),
+        source_(source.Pass()),
+        offset_(offset),
+        num_bytes_left_(num_bytes_to_read),
+        callback_(callback) {}
+  ~ReadToStreamTransfer() {}
+
+  void Transfer() {
+    while (num_bytes_left_ > 0) {
+      void* buffer = nullptr;
+      uint32_t buffer_num_bytes = 0;
+      MojoResult result = BeginWriteDataRaw(source_.get(), &buffer,
+                                            &buffer_num_bytes,
+                                            MOJO_WRITE_DATA_FLAG_NONE);
+      if (result == MOJO_RESULT_SHOULD_WAIT) {
+        handle_watcher_.Start(
+            source_.get(), MOJO_HANDLE_SIGNAL_WRITABLE,
+            MOJO_DEADLINE_INDEFINITE,
+            base::Bind(&ReadToStreamTransfer::OnWritable,
+                       base::Unretained(this)));
+        return;
+      }
+      if (result != MOJO_RESULT_OK) {
+        Finish(DataPipeResultToError(result));
+        return;
+      }
+
+      size_t num_bytes = static_cast<size_t>(
+          std::min(static_cast<int64_t>(buffer_num_bytes), num_bytes_left_));
+      ssize_t num_bytes_read = HANDLE_EINTR(
+          pread(fd_.get(), buffer, num_bytes, static_cast<off_t>(offset_)));
+      if (num_bytes_read < 0) {
+        Error error = ErrnoToError(errno);
+        EndWriteDataRaw(source_.get(), 0u);
+        Finish(error);
+        return;
+      }
+      EndWriteDataRaw(source_.get(), static_cast<uint32_t>(num_bytes_read));
+      if (num_bytes_read == 0)
+        break;  // End of file.
+      offset_ += num_bytes_read;
+      num_bytes_left_ -= num_bytes_read;
+    }
+    Finish(ERROR_OK);
+  }
+
+  void OnWritable(MojoResult result) {
+    if (result != MOJO_RESULT_OK) {
+      Finish(DataPipeResultToError(result));
+      return;
+    }
+    Transfer();
+  }
+
+  void Finish(Error error) {
+    // Close the producer before responding.
+    source_.reset();
+    callback_.Run(error);
+    delete this;
+  }
+
+  base::ScopedFD fd_;
+  ScopedDataPipeProducerHandle source_;
+  int64_t offset_;
+  int64_t num_bytes_left_;
+  const Callback<void(Error)> callback_;
+  common::HandleWatcher handle_watcher_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadToStreamTransfer);
+};
+
+// Writes all the data from |sink| to |fd|, starting at |offset|, until the
+// producer is closed. Data is written (using |pwrite()|, so the file position
+// is neither used nor changed) directly from the data pipe's buffer (using
+// two-phase reads). Like |ReadToStreamTransfer|, this runs on the service
+// thread, waiting asynchronously whenever the data pipe is empty, and deletes
+// itself after running |callback|.
+class WriteFromStreamTransfer {
+ public:
+  static void Start(base::ScopedFD fd,
+                    ScopedDataPipeConsumerHandle sink,
+                    int64_t offset,
+                    const Callback<void(Error)>& callback) {
+    (new WriteFromStreamTransfer(fd.Pass(), sink.Pass(), offset, callback))
+        ->Transfer();
+  }
+
+ private:
+  WriteFromStreamTransfer(base::ScopedFD fd,
+                          ScopedDataPipeConsumerHandle sink,
+                          int64_t offset,
+                          const Callback<void(Error)>& callback)
+      : fd_(fd.Pass()),
+        sink_(sink.Pass()),
+        offset_(offset),
+        callback_(callback) {}
+  ~WriteFromStreamTransfer() {}
+
+  void Transfer() {
+    for (;;) {
+      const void* buffer = nullptr;
+      uint32_t buffer_num_bytes = 0;
+      MojoResult result = BeginReadDataRaw(sink_.get(), &buffer,
+                                           &buffer_num_bytes,
+                                           MOJO_READ_DATA_FLAG_NONE);
+      if (result == MOJO_RESULT_SHOULD_WAIT) {
+        handle_watcher_.Start(
+            sink_.get(), MOJO_HANDLE_SIGNAL_READABLE, MOJO_DEADLINE_INDEFINITE,
+            base::Bind(&WriteFromStreamTransfer::OnReadable,
+                       base::Unretained(this)));
+        return;
+      }
+      if (result == MOJO_RESULT_FAILED_PRECONDITION) {
+        // The producer was closed (and all the data was consumed).
+        Finish(ERROR_OK);
+        return;
+      }
+      if (result != MOJO_RESULT_OK) {
+        Finish(DataPipeResultToError(result));
+        return;
+      }
+
+      const char* p = static_cast<const char*>(buffer);
+      size_t num_bytes_left = buffer_num_bytes;
+      while (num_bytes_left > 0) {
+        ssize_t num_bytes_written = HANDLE_EINTR(pwrite(
+            fd_.get(), p, num_bytes_left, static_cast<off_t>(offset_)));
+        if (num_bytes_written < 0) {
+          Error error = ErrnoToError(errno);
+          EndReadDataRaw(sink_.get(), 0u);
+          Finish(error);
+          return;
+        }
+        p += num_bytes_written;
+        num_bytes_left -= static_cast<size_t>(num_bytes_written);
+        offset_ += num_bytes_written;
+      }
+      EndReadDataRaw(sink_.get(), buffer_num_bytes);
+    }
+  }
+
+  void OnReadable(MojoResult result) {
+    // If the producer was closed, the next read will say so (once all the data
+    // has been consumed).
+    if (result != MOJO_RESULT_OK &&
+        result != MOJO_RESULT_FAILED_PRECONDITION) {
+      Finish(DataPipeResultToError(result));
+      return;
+    }
+    Transfer();
+  }
+
+  void Finish(Error error) {
+    callback_.Run(error);
+    delete this;
+  }
+
+  base::ScopedFD fd_;
+  ScopedDataPipeConsumerHandle sink_;
+  int64_t offset_;
+  const Callback<void(Error)> callback_;
+  common::HandleWatcher handle_watcher_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriteFromStreamTransfer);
+};
+
+// Maps the result of creating a shared buffer to an |Error|.
+Error SharedBufferResultToError(MojoResult result) {
+  switch (result) {
+    case MOJO_RESULT_INVALID_ARGUMENT:
+      return ERROR_UNAVAILABLE;
+    case MOJO_RESULT_RESOURCE_EXHAUSTED:
+      return ERROR_OUT_OF_RANGE;
+    default:
+      return ERROR_INTERNAL;
+  }
+}
+
+// Creates a shared buffer backed by the (regular, read-write) file |fd|, which
+// must be |num_bytes| in size, without copying; writes to mappings of it are
+// writes to the file. (This is only done for read-write files, since shared
+// buffers received from other processes must always be mappable read-write.)
+Error CreateFileBackedBuffer(int fd,
+                             uint64_t num_bytes,
+                             ScopedSharedBufferHandle* buffer) {
+  // The shared buffer takes ownership of the duplicate.
+  int buffer_fd = dup(fd);
+  if (buffer_fd < 0)
+    return ErrnoToError(errno);
+  MojoHandle buffer_handle = MOJO_HANDLE_INVALID;
+  MojoResult result = MojoCreateSharedBufferFromPlatformHandle(
+      buffer_fd, num_bytes, &buffer_handle);
+  if (result != MOJO_RESULT_OK)
+    return SharedBufferResultToError(result);
+  buffer->reset(SharedBufferHandle(buffer_handle));
+  return ERROR_OK;
+}
+
+// Creates a shared buffer containing a copy of the first |num_bytes| bytes of
+// the file |fd| (using |pread()|, so the file position isn't changed).
+Error CopyToBuffer(int fd,
+                   uint64_t num_bytes,
+                   ScopedSharedBufferHandle* buffer) {
+  if (num_bytes > std::numeric_limits<size_t>::max())
+    return ERROR_OUT_OF_RANGE;
+
+  ScopedSharedBufferHandle new_buffer;
+  MojoResult result = CreateSharedBuffer(nullptr, num_bytes, &new_buffer);
+  if (result != MOJO_RESULT_OK)
+    return SharedBufferResultToError(result);
+  void* pointer = nullptr;
+  result = MapBuffer(new_buffer.get(), 0, num_bytes, &pointer,
+                     MOJO_MAP_BUFFER_FLAG_NONE);
+  if (result != MOJO_RESULT_OK)
+    return ERROR_INTERNAL;
+
+  Error error = ERROR_OK;
+  size_t num_bytes_copied = 0;
+  while (num_bytes_copied < num_bytes) {
+    ssize_t num_bytes_read =
+        HANDLE_EINTR(pread(fd, static_cast<char*>(pointer) + num_bytes_copied,
+                           static_cast<size_t>(num_bytes) - num_bytes_copied,
+                           static_cast<off_t>(num_bytes_copied)));
+    if (num_bytes_read < 0) {
+      error = ErrnoToError(errno);
+      break;
+    }
+    // If the file has shrunk in the meantime, the rest is left zero-filled.
+    if (num_bytes_read == 0)
+      break;
+    num_bytes_copied += static_cast<size_t>(num_bytes_read);
+  }
+
+  UnmapBuffer(pointer);
+  if (error == ERROR_OK)
+    *buffer = new_buffer.Pass();
+  return error;
+}
+
+}  // namespace
+
 FileImpl::FileImpl(InterfaceRequest<File> request, base::ScopedFD file_fd)
     : binding_(this, request.Pass()), file_fd_(file_fd.Pass()) {
   DCHECK(file_fd_.is_valid());
@@ -180,10 +468,19 @@ void FileImpl::ReadToStream(ScopedDataPipeProducerHandle source,
     callback.Run(error);
     return;
   }
+  if (num_bytes_to_read < 0 || !source.is_valid()) {
+    callback.Run(ERROR_INVALID_ARGUMENT);
+    return;
+  }
 
-  // TODO(vtl): FIXME soon
-  NOTIMPLEMENTED();
-  callback.Run(ERROR_UNIMPLEMENTED);
+  base::ScopedFD fd;
+  int64_t position = 0;
+  if (Error error = PrepareForStream(offset, whence, &fd, &position)) {
+    callback.Run(error);
+    return;
+  }
+  ReadToStreamTransfer::Start(fd.Pass(), source.Pass(), position,
+                              num_bytes_to_read, callback);
 }
 
 void FileImpl::WriteFromStream(ScopedDataPipeConsumerHandle sink,
@@ -202,10 +499,18 @@ void FileImpl::WriteFromStream(ScopedDataPipeConsumerHandle sink,
     callback.Run(error);
     return;
   }
+  if (!sink.is_valid()) {
+    callback.Run(ERROR_INVALID_ARGUMENT);
+    return;
+  }
 
-  // TODO(vtl): FIXME soon
-  NOTIMPLEMENTED();
-  callback.Run(ERROR_UNIMPLEMENTED);
+  base::ScopedFD fd;
+  int64_t position = 0;
+  if (Error error = PrepareForStream(offset, whence, &fd, &position)) {
+    callback.Run(error);
+    return;
+  }
+  WriteFromStreamTransfer::Start(fd.Pass(), sink.Pass(), position, callback);
 }
 
 void FileImpl::Tell(const TellCallback& callback) {
@@ -313,9 +618,42 @@ void FileImpl::AsBuffer(const AsBufferCallback& callback) {
     return;
   }
 
-  // TODO(vtl): FIXME soon
-  NOTIMPLEMENTED();
-  callback.Run(ERROR_UNIMPLEMENTED, ScopedSharedBufferHandle());
+  struct stat buf;
+  if (fstat(file_fd_.get(), &buf) != 0) {
+    callback.Run(ErrnoToError(errno), ScopedSharedBufferHandle());
+    return;
+  }
+  // Only regular files can be mapped, and shared buffers can't be empty.
+  if (!S_ISREG(buf.st_mode) || buf.st_size <= 0) {
+    callback.Run(ERROR_UNAVAILABLE, ScopedSharedBufferHandle());
+    return;
+  }
+
+  // Note: |fcntl()| isn't interruptible for |F_GETFL|.
+  int flags = fcntl(file_fd_.get(), F_GETFL);
+  if (flags == -1) {
+    callback.Run(ErrnoToError(errno), ScopedSharedBufferHandle());
+    return;
+  }
+
+  ScopedSharedBufferHandle buffer;
+  Error error = ERROR_OK;
+  switch (flags & O_ACCMODE) {
+    case O_RDWR:
+      error = CreateFileBackedBuffer(
+          file_fd_.get(), static_cast<uint64_t>(buf.st_size), &buffer);
+      break;
+    case O_RDONLY:
+      // A shared buffer backed by a read-only file could only be mapped
+      // read-only, which other processes won't accept, so give a copy instead.
+      error = CopyToBuffer(file_fd_.get(), static_cast<uint64_t>(buf.st_size),
+                           &buffer);
+      break;
+    default:
+      error = ERROR_PERMISSION_DENIED;
+      break;
+  }
+  callback.Run(error, buffer.Pass());
 }
 
 void FileImpl::Ioctl(uint32_t request,
@@ -331,5 +669,45 @@ void FileImpl::Ioctl(uint32_t request,
   callback.Run(ERROR_UNAVAILABLE, Array<uint32_t>());
 }
 
+Error FileImpl::PrepareForStream(int64_t offset,
+                                 Whence whence,
+                                 base::ScopedFD* fd,
+                                 int64_t* position) {
+  DCHECK(file_fd_.is_valid());
+
+  // Work out the starting position without changing the file position (the
+  // transfer uses |pread()|/|pwrite()| with its own position).
+  int64_t base = 0;
+  switch (whence) {
+    case WHENCE_FROM_START:
+      break;
+    case WHENCE_FROM_CURRENT: {
+      off_t current = lseek(file_fd_.get(), 0, SEEK_CUR);
+      if (current < 0)
+        return ErrnoToError(errno);
+      base = static_cast<int64_t>(current);
+      break;
+    }
+    case WHENCE_FROM_END: {
+      struct stat buf;
+      if (fstat(file_fd_.get(), &buf) != 0)
+        return ErrnoToError(errno);
+      base = static_cast<int64_t>(buf.st_size);
+      break;
+    }
+  }
+  if ((offset > 0 && base > std::numeric_limits<int64_t>::max() - offset) ||
+      base + offset < 0)
+    return ERROR_INVALID_ARGUMENT;
+  *position = base + offset;
+
+  // The duplicate stays valid even if we're closed or destroyed while the
+  // transfer is in progress.
+  fd->reset(dup(file_fd_.get()));
+  if (!fd->is_valid())
+    return ErrnoToError(errno);
+  return ERROR_OK;
+}
+
 }  // namespace files
 }  // namespace mojo
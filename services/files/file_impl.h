@@ -58,6 +58,15 @@ class FileImpl : public File {
              const IoctlCallback& callback) override;
 
  private:
+  // Gets the position specified by |offset|/|whence| (without changing the file
+  // position) into |*position| and duplicates |file_fd_| into |*fd|, for use by
+  // |ReadToStream()| and |WriteFromStream()| (whose transfers may outlive this
+  // object).
+  Error PrepareForStream(int64_t offset,
+                         Whence whence,
+                         base::ScopedFD* fd,
+                         int64_t* position);
+
   StrongBinding<File> binding_;
   base::ScopedFD file_fd_;
 
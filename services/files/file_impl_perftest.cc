@@ -0,0 +1,190 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the throughput of streaming a file over a data pipe (using
+// |File::ReadToStream()|/|File::WriteFromStream()|) with that of a loop of
+// |File::Read()|s/|File::Write()|s.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "mojo/public/cpp/bindings/interface_request.h"
+#include "mojo/public/cpp/system/data_pipe.h"
+#include "services/files/files_test_base.h"
+#include "testing/perf/perf_test.h"
+
+namespace mojo {
+namespace files {
+namespace {
+
+const uint32_t kChunkSize = 1024 * 1024;  // 1 MB.
+const uint32_t kNumChunks = 64;
+const uint64_t kFileSize = static_cast<uint64_t>(kChunkSize) * kNumChunks;
+
+void ReportThroughput(const std::string& trace, base::TimeDelta elapsed) {
+  double megabytes = static_cast<double>(kFileSize) / (1024.0 * 1024.0);
+  perf_test::PrintResult("files_throughput", "", trace,
+                         megabytes / elapsed.InSecondsF(), "MB/s", true);
+}
+
+// Makes a data pipe whose capacity is |kChunkSize|, so that the streaming and
+// non-streaming variants have the same amount of data "in flight".
+void CreateChunkSizedDataPipe(ScopedDataPipeProducerHandle* producer,
+                              ScopedDataPipeConsumerHandle* consumer) {
+  MojoCreateDataPipeOptions options = {
+      static_cast<uint32_t>(sizeof(MojoCreateDataPipeOptions)),
+      MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE, 1u, kChunkSize};
+  ASSERT_EQ(MOJO_RESULT_OK, CreateDataPipe(&options, producer, consumer));
+}
+
+class FileImplPerfTest : public FilesTestBase {
+ public:
+  FileImplPerfTest() {}
+  ~FileImplPerfTest() override {}
+
+ protected:
+  // Opens (creating, if necessary) "my_file" for reading and writing.
+  void OpenFile(FilePtr* file) {
+    DirectoryPtr directory;
+    GetTemporaryRoot(&directory);
+    Error error = ERROR_INTERNAL;
+    directory->OpenFile("my_file", GetProxy(file),
+                        kOpenFlagRead | kOpenFlagWrite | kOpenFlagCreate,
+                        Capture(&error));
+    ASSERT_TRUE(directory.WaitForIncomingResponse());
+    ASSERT_EQ(ERROR_OK, error);
+  }
+
+  // Writes |kFileSize| bytes to |file| (from the start) using |Write()|s.
+  void WriteLoop(FilePtr* file) {
+    std::vector<uint8_t> chunk(kChunkSize, 'x');
+    for (uint32_t i = 0; i < kNumChunks; i++) {
+      Error error = ERROR_INTERNAL;
+      uint32_t num_bytes_written = 0;
+      (*file)->Write(Array<uint8_t>::From(chunk), 0,
+                     i == 0 ? WHENCE_FROM_START : WHENCE_FROM_CURRENT,
+                     Capture(&error, &num_bytes_written));
+      ASSERT_TRUE(file->WaitForIncomingResponse());
+      ASSERT_EQ(ERROR_OK, error);
+      ASSERT_EQ(kChunkSize, num_bytes_written);
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(FileImplPerfTest);
+};
+
+TEST_F(FileImplPerfTest, ReadLoopVsReadToStream) {
+  FilePtr file;
+  OpenFile(&file);
+  WriteLoop(&file);
+
+  // Read it using |Read()|s.
+  {
+    base::TimeTicks start = base::TimeTicks::Now();
+    uint64_t total_bytes_read = 0;
+    for (uint32_t i = 0; i < kNumChunks; i++) {
+      Error error = ERROR_INTERNAL;
+      Array<uint8_t> bytes_read;
+      file->Read(kChunkSize, 0,
+                 i == 0 ? WHENCE_FROM_START : WHENCE_FROM_CURRENT,
+                 Capture(&error, &bytes_read));
+      ASSERT_TRUE(file.WaitForIncomingResponse());
+      ASSERT_EQ(ERROR_OK, error);
+      total_bytes_read += bytes_read.size();
+    }
+    ReportThroughput("Read", base::TimeTicks::Now() - start);
+    EXPECT_EQ(kFileSize, total_bytes_read);
+  }
+
+  // Read it using |ReadToStream()|, consuming the data as it arrives.
+  {
+    base::TimeTicks start = base::TimeTicks::Now();
+    ScopedDataPipeProducerHandle producer;
+    ScopedDataPipeConsumerHandle consumer;
+    CreateChunkSizedDataPipe(&producer, &consumer);
+    Error error = ERROR_INTERNAL;
+    file->ReadToStream(producer.Pass(), 0, WHENCE_FROM_START,
+                       static_cast<int64_t>(kFileSize), Capture(&error));
+    uint64_t total_bytes_read = 0;
+    for (;;) {
+      const void* buffer = nullptr;
+      uint32_t buffer_num_bytes = 0;
+      MojoResult result = BeginReadDataRaw(consumer.get(), &buffer,
+                                           &buffer_num_bytes,
+                                           MOJO_READ_DATA_FLAG_NONE);
+      if (result == MOJO_RESULT_SHOULD_WAIT) {
+        result = Wait(consumer.get(), MOJO_HANDLE_SIGNAL_READABLE,
+                      MOJO_DEADLINE_INDEFINITE, nullptr);
+        if (result == MOJO_RESULT_OK)
+          continue;
+      }
+      if (result != MOJO_RESULT_OK)
+        break;
+      total_bytes_read += buffer_num_bytes;
+      EndReadDataRaw(consumer.get(), buffer_num_bytes);
+    }
+    ASSERT_TRUE(file.WaitForIncomingResponse());
+    ReportThroughput("ReadToStream", base::TimeTicks::Now() - start);
+    EXPECT_EQ(ERROR_OK, error);
+    EXPECT_EQ(kFileSize, total_bytes_read);
+  }
+}
+
+TEST_F(FileImplPerfTest, WriteLoopVsWriteFromStream) {
+  FilePtr file;
+  OpenFile(&file);
+
+  // Write it using |Write()|s.
+  {
+    base::TimeTicks start = base::TimeTicks::Now();
+    WriteLoop(&file);
+    ReportThroughput("Write", base::TimeTicks::Now() - start);
+  }
+
+  // Write it using |WriteFromStream()|, producing the data as it's consumed.
+  {
+    base::TimeTicks start = base::TimeTicks::Now();
+    ScopedDataPipeProducerHandle producer;
+    ScopedDataPipeConsumerHandle consumer;
+    CreateChunkSizedDataPipe(&producer, &consumer);
+    Error error = ERROR_INTERNAL;
+    file->WriteFromStream(consumer.Pass(), 0, WHENCE_FROM_START,
+                          Capture(&error));
+    uint64_t total_bytes_written = 0;
+    while (total_bytes_written < kFileSize) {
+      void* buffer = nullptr;
+      uint32_t buffer_num_bytes = 0;
+      MojoResult result = BeginWriteDataRaw(producer.get(), &buffer,
+                                            &buffer_num_bytes,
+                                            MOJO_WRITE_DATA_FLAG_NONE);
+      if (result == MOJO_RESULT_SHOULD_WAIT) {
+        result = Wait(producer.get(), MOJO_HANDLE_SIGNAL_WRITABLE,
+                      MOJO_DEADLINE_INDEFINITE, nullptr);
+        if (result == MOJO_RESULT_OK)
+          continue;
+      }
+      ASSERT_EQ(MOJO_RESULT_OK, result);
+      if (buffer_num_bytes > kFileSize - total_bytes_written) {
+        buffer_num_bytes =
+            static_cast<uint32_t>(kFileSize - total_bytes_written);
+      }
+      memset(buffer, 'x', buffer_num_bytes);
+      total_bytes_written += buffer_num_bytes;
+      EndWriteDataRaw(producer.get(), buffer_num_bytes);
+    }
+    producer.reset();
+    ASSERT_TRUE(file.WaitForIncomingResponse());
+    ReportThroughput("WriteFromStream", base::TimeTicks::Now() - start);
+    EXPECT_EQ(ERROR_OK, error);
+  }
+}
+
+}  // namespace
+}  // namespace files
+}  // namespace mojo
@@ -2,10 +2,15 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
+#include <algorithm>
 #include <vector>
 
 #include "mojo/public/cpp/bindings/interface_request.h"
 #include "mojo/public/cpp/bindings/type_converter.h"
+#include "mojo/public/cpp/system/buffer.h"
+#include "mojo/public/cpp/system/data_pipe.h"
 #include "services/files/files_test_base.h"
 
 namespace mojo {
@@ -688,6 +693,193 @@ TEST_F(FileImplTest, Ioctl) {
   EXPECT_TRUE(out_values.is_null());
 }
 
+TEST_F(FileImplTest, WriteFromStreamReadToStream) {
+  DirectoryPtr directory;
+  GetTemporaryRoot(&directory);
+  Error error;
+
+  // Create my_file.
+  FilePtr file;
+  error = ERROR_INTERNAL;
+  directory->OpenFile("my_file", GetProxy(&file),
+                      kOpenFlagRead | kOpenFlagWrite | kOpenFlagCreate,
+                      Capture(&error));
+  ASSERT_TRUE(directory.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_OK, error);
+
+  const uint32_t kDataSize = 12345;
+  std::vector<uint8_t> data(kDataSize);
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = static_cast<uint8_t>(i * 7);
+
+  // Write to it from a data pipe. (The data fits in the data pipe, so we can
+  // write all of it before closing the producer.)
+  {
+    DataPipe data_pipe;
+    uint32_t num_bytes = kDataSize;
+    EXPECT_EQ(MOJO_RESULT_OK,
+              WriteDataRaw(data_pipe.producer_handle.get(), &data[0],
+                           &num_bytes, MOJO_WRITE_DATA_FLAG_ALL_OR_NONE));
+    EXPECT_EQ(kDataSize, num_bytes);
+    data_pipe.producer_handle.reset();
+
+    error = ERROR_INTERNAL;
+    file->WriteFromStream(data_pipe.consumer_handle.Pass(), 0,
+                          WHENCE_FROM_CURRENT, Capture(&error));
+    ASSERT_TRUE(file.WaitForIncomingResponse());
+    EXPECT_EQ(ERROR_OK, error);
+  }
+
+  // Streaming doesn't change the file position.
+  {
+    error = ERROR_INTERNAL;
+    int64_t position = -1;
+    file->Tell(Capture(&error, &position));
+    ASSERT_TRUE(file.WaitForIncomingResponse());
+    EXPECT_EQ(ERROR_OK, error);
+    EXPECT_EQ(0, position);
+  }
+
+  // Read (part of) it back into a data pipe.
+  const int64_t kOffset = 100;
+  {
+    DataPipe data_pipe;
+    error = ERROR_INTERNAL;
+    file->ReadToStream(data_pipe.producer_handle.Pass(), kOffset,
+                       WHENCE_FROM_START, kDataSize, Capture(&error));
+    ASSERT_TRUE(file.WaitForIncomingResponse());
+    EXPECT_EQ(ERROR_OK, error);
+
+    // The producer should have been closed at EOF, so we can just read until
+    // we get "failed precondition".
+    std::vector<uint8_t> bytes_read;
+    for (;;) {
+      uint8_t buffer[1000];
+      uint32_t num_bytes = static_cast<uint32_t>(sizeof(buffer));
+      MojoResult result = ReadDataRaw(data_pipe.consumer_handle.get(), buffer,
+                                      &num_bytes, MOJO_READ_DATA_FLAG_NONE);
+      if (result == MOJO_RESULT_SHOULD_WAIT) {
+        result = Wait(data_pipe.consumer_handle.get(),
+                      MOJO_HANDLE_SIGNAL_READABLE, MOJO_DEADLINE_INDEFINITE,
+                      nullptr);
+        if (result == MOJO_RESULT_OK)
+          continue;
+      }
+      if (result != MOJO_RESULT_OK) {
+        EXPECT_EQ(MOJO_RESULT_FAILED_PRECONDITION, result);
+        break;
+      }
+      bytes_read.insert(bytes_read.end(), buffer, buffer + num_bytes);
+    }
+    ASSERT_EQ(kDataSize - kOffset, bytes_read.size());
+    EXPECT_TRUE(std::equal(bytes_read.begin(), bytes_read.end(),
+                           data.begin() + kOffset));
+  }
+
+  // Reading with a negative number of bytes is invalid.
+  {
+    DataPipe data_pipe;
+    error = ERROR_INTERNAL;
+    file->ReadToStream(data_pipe.producer_handle.Pass(), 0, WHENCE_FROM_START,
+                       -1, Capture(&error));
+    ASSERT_TRUE(file.WaitForIncomingResponse());
+    EXPECT_EQ(ERROR_INVALID_ARGUMENT, error);
+  }
+}
+
+TEST_F(FileImplTest, AsBuffer) {
+  DirectoryPtr directory;
+  GetTemporaryRoot(&directory);
+  Error error;
+
+  // Create my_file.
+  FilePtr file;
+  error = ERROR_INTERNAL;
+  directory->OpenFile("my_file", GetProxy(&file),
+                      kOpenFlagRead | kOpenFlagWrite | kOpenFlagCreate,
+                      Capture(&error));
+  ASSERT_TRUE(directory.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_OK, error);
+
+  // An empty file can't be mapped.
+  ScopedSharedBufferHandle buffer;
+  error = ERROR_INTERNAL;
+  file->AsBuffer(Capture(&error, &buffer));
+  ASSERT_TRUE(file.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_UNAVAILABLE, error);
+  EXPECT_FALSE(buffer.is_valid());
+
+  // Write to it.
+  std::vector<uint8_t> bytes_to_write;
+  bytes_to_write.push_back(static_cast<uint8_t>('h'));
+  bytes_to_write.push_back(static_cast<uint8_t>('e'));
+  bytes_to_write.push_back(static_cast<uint8_t>('l'));
+  bytes_to_write.push_back(static_cast<uint8_t>('l'));
+  bytes_to_write.push_back(static_cast<uint8_t>('o'));
+  error = ERROR_INTERNAL;
+  uint32_t num_bytes_written = 0;
+  file->Write(Array<uint8_t>::From(bytes_to_write), 0, WHENCE_FROM_CURRENT,
+              Capture(&error, &num_bytes_written));
+  ASSERT_TRUE(file.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_OK, error);
+  EXPECT_EQ(bytes_to_write.size(), num_bytes_written);
+
+  // Get it as a shared buffer.
+  error = ERROR_INTERNAL;
+  file->AsBuffer(Capture(&error, &buffer));
+  ASSERT_TRUE(file.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_OK, error);
+  ASSERT_TRUE(buffer.is_valid());
+
+  // Map it and check its contents.
+  void* pointer = nullptr;
+  EXPECT_EQ(MOJO_RESULT_OK, MapBuffer(buffer.get(), 0, bytes_to_write.size(),
+                                      &pointer, MOJO_MAP_BUFFER_FLAG_NONE));
+  ASSERT_TRUE(pointer);
+  EXPECT_EQ(0, memcmp(pointer, &bytes_to_write[0], bytes_to_write.size()));
+
+  // Writes to the mapping are writes to the file.
+  static_cast<char*>(pointer)[0] = 'j';
+  EXPECT_EQ(MOJO_RESULT_OK, UnmapBuffer(pointer));
+  Array<uint8_t> bytes_read;
+  error = ERROR_INTERNAL;
+  file->Read(1, 0, WHENCE_FROM_START, Capture(&error, &bytes_read));
+  ASSERT_TRUE(file.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_OK, error);
+  ASSERT_EQ(1u, bytes_read.size());
+  EXPECT_EQ(static_cast<uint8_t>('j'), bytes_read[0]);
+
+  // Open my_file again, read-only.
+  FilePtr file_ro;
+  error = ERROR_INTERNAL;
+  directory->OpenFile("my_file", GetProxy(&file_ro), kOpenFlagRead,
+                      Capture(&error));
+  ASSERT_TRUE(directory.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_OK, error);
+
+  // Get it as a shared buffer: this is a copy (which may be mapped read-write).
+  error = ERROR_INTERNAL;
+  file_ro->AsBuffer(Capture(&error, &buffer));
+  ASSERT_TRUE(file_ro.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_OK, error);
+  ASSERT_TRUE(buffer.is_valid());
+  pointer = nullptr;
+  EXPECT_EQ(MOJO_RESULT_OK, MapBuffer(buffer.get(), 0, bytes_to_write.size(),
+                                      &pointer, MOJO_MAP_BUFFER_FLAG_NONE));
+  ASSERT_TRUE(pointer);
+  EXPECT_EQ(0, memcmp(pointer, "jello", 5));
+
+  // Writes to the mapping aren't writes to the file.
+  static_cast<char*>(pointer)[0] = 'y';
+  EXPECT_EQ(MOJO_RESULT_OK, UnmapBuffer(pointer));
+  error = ERROR_INTERNAL;
+  file_ro->Read(1, 0, WHENCE_FROM_START, Capture(&error, &bytes_read));
+  ASSERT_TRUE(file_ro.WaitForIncomingResponse());
+  EXPECT_EQ(ERROR_OK, error);
+  ASSERT_EQ(1u, bytes_read.size());
+  EXPECT_EQ(static_cast<uint8_t>('j'), bytes_read[0]);
+}
+
 }  // namespace
 }  // namespace files
 }  // namespace mojo
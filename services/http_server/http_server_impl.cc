@@ -37,13 +37,16 @@ void HttpServerImpl::AddBinding(mojo::InterfaceRequest<HttpServer> request) {
 void HttpServerImpl::SetHandler(const mojo::String& path,
                                 HttpHandlerPtr http_handler,
                                 const mojo::Callback<void(bool)>& callback) {
-  for (const auto& handler : handlers_) {
-    if (handler->pattern->pattern() == path)
+  for (size_t i = 0; i < routes_.size(); i++) {
+    if (routes_.pattern(i) == path) {
       callback.Run(false);
+      return;
+    }
   }
 
   http_handler.set_error_handler(this);
-  handlers_.push_back(new Handler(path, http_handler.Pass()));
+  handlers_.push_back(new Handler(http_handler.Pass()));
+  routes_.AddRoute(path);
   callback.Run(true);
 }
 
@@ -56,10 +59,14 @@ void HttpServerImpl::GetPort(const GetPortCallback& callback) {
 }
 
 void HttpServerImpl::OnConnectionError() {
-  handlers_.erase(
-      std::remove_if(handlers_.begin(), handlers_.end(), [](Handler* h) {
-    return h->http_handler.encountered_error();
-  }), handlers_.end());
+  // Iterate backwards, so that removing a route doesn't renumber the routes
+  // that are still to be checked.
+  for (size_t i = handlers_.size(); i > 0; i--) {
+    if (handlers_[i - 1]->http_handler.encountered_error()) {
+      handlers_.erase(handlers_.begin() + (i - 1));
+      routes_.RemoveRoute(i - 1);
+    }
+  }
 
   if (handlers_.empty()) {
     // The call deregisters the server from the factory and deletes |this|.
@@ -142,16 +149,16 @@ void HttpServerImpl::Start() {
 
 void HttpServerImpl::HandleRequest(Connection* connection,
                                    HttpRequestPtr request) {
-  for (auto& handler : handlers_) {
-    if (RE2::FullMatch(request->relative_url.data(), *handler->pattern)) {
-      handler->http_handler->HandleRequest(
-          request.Pass(), base::Bind(&HttpServerImpl::OnResponse,
-                                     base::Unretained(this), connection));
-      return;
-    }
+  size_t route = routes_.Match(request->relative_url.get());
+  if (route == RouteTable::kNoMatch) {
+    connection->SendResponse(
+        CreateHttpResponse(404, "No registered handler\n"));
+    return;
   }
 
-  connection->SendResponse(CreateHttpResponse(404, "No registered handler\n"));
+  handlers_[route]->http_handler->HandleRequest(
+      request.Pass(), base::Bind(&HttpServerImpl::OnResponse,
+                                 base::Unretained(this), connection));
 }
 
 void HttpServerImpl::OnResponse(Connection* connection,
@@ -159,9 +166,8 @@ void HttpServerImpl::OnResponse(Connection* connection,
   connection->SendResponse(response.Pass());
 }
 
-HttpServerImpl::Handler::Handler(const std::string& pattern,
-                                 HttpHandlerPtr http_handler)
-    : pattern(new RE2(pattern.c_str())), http_handler(http_handler.Pass()) {
+HttpServerImpl::Handler::Handler(HttpHandlerPtr http_handler)
+    : http_handler(http_handler.Pass()) {
 }
 
 HttpServerImpl::Handler::~Handler() {
@@ -13,7 +13,7 @@
 #include "mojo/services/http_server/public/interfaces/http_server.mojom.h"
 #include "mojo/services/network/public/interfaces/net_address.mojom.h"
 #include "mojo/services/network/public/interfaces/network_service.mojom.h"
-#include "third_party/re2/re2/re2.h"
+#include "services/http_server/route_table.h"
 
 namespace mojo {
 class ApplicationImpl;
@@ -61,9 +61,8 @@ class HttpServerImpl : public HttpServer, public mojo::ErrorHandler {
   void OnResponse(Connection* connection, HttpResponsePtr response);
 
   struct Handler {
-    Handler(const std::string& pattern, HttpHandlerPtr http_handler);
+    explicit Handler(HttpHandlerPtr http_handler);
     ~Handler();
-    scoped_ptr<re2::RE2> pattern;
     HttpHandlerPtr http_handler;
 
    private:
@@ -86,7 +85,9 @@ class HttpServerImpl : public HttpServer, public mojo::ErrorHandler {
   mojo::ScopedDataPipeConsumerHandle pending_receive_handle_;
   mojo::TCPConnectedSocketPtr pending_connected_socket_;
 
+  // |handlers_[i]| handles the requests for which |routes_| matches route |i|.
   ScopedVector<Handler> handlers_;
+  RouteTable routes_;
 
   base::WeakPtrFactory<HttpServerImpl> weak_ptr_factory_;
   DISALLOW_COPY_AND_ASSIGN(HttpServerImpl);
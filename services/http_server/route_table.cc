@@ -0,0 +1,225 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/http_server/route_table.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace http_server {
+
+namespace {
+
+// Characters that have a special meaning (outside a character class) in RE2
+// patterns. (This is conservative: e.g., '}' is only special after '{'.)
+const char kMetacharacters[] = "\\^$.|?*+()[]{}";
+
+bool IsMetacharacter(char c) {
+  return c != '\0' && strchr(kMetacharacters, c) != nullptr;
+}
+
+// Returns true if |pattern| has a '|' that's not inside a group or a character
+// class (in which case it has no required prefix).
+bool HasTopLevelAlternation(const std::string& pattern) {
+  int depth = 0;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    switch (pattern[i]) {
+      case '\\':
+        i++;
+        break;
+      case '[':
+        // Skip the character class. Note that a ']' right after the '[' (or
+        // "[^") is a literal.
+        i++;
+        if (i < pattern.size() && pattern[i] == '^')
+          i++;
+        if (i < pattern.size() && pattern[i] == ']')
+          i++;
+        for (; i < pattern.size() && pattern[i] != ']'; i++) {
+          if (pattern[i] == '\\')
+            i++;
+        }
+        break;
+      case '(':
+        depth++;
+        break;
+      case ')':
+        depth--;
+        break;
+      case '|':
+        if (depth <= 0)
+          return true;
+        break;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+// static
+const size_t RouteTable::kNoMatch;
+
+RouteTable::TrieNode::TrieNode()
+    : literal_route(kNoMatch), min_regexp_route(kNoMatch) {
+}
+
+RouteTable::TrieNode::~TrieNode() {
+}
+
+RouteTable::RouteTable() : compiled_(false) {
+}
+
+RouteTable::~RouteTable() {
+}
+
+void RouteTable::AddRoute(const std::string& pattern) {
+  routes_.push_back(new re2::RE2(pattern));
+  compiled_ = false;
+}
+
+void RouteTable::RemoveRoute(size_t index) {
+  DCHECK_LT(index, routes_.size());
+  routes_.erase(routes_.begin() + index);
+  compiled_ = false;
+}
+
+size_t RouteTable::Match(const std::string& url) {
+  if (!compiled_)
+    Compile();
+
+  // Walk the trie as far as |url| goes, keeping track of the first regexp
+  // route that might match.
+  size_t node = 0;
+  size_t first_candidate = trie_[0].min_regexp_route;
+  size_t i = 0;
+  for (; i < url.size(); i++) {
+    std::map<char, size_t>::const_iterator it =
+        trie_[node].children.find(url[i]);
+    if (it == trie_[node].children.end())
+      break;
+    node = it->second;
+    first_candidate = std::min(first_candidate, trie_[node].min_regexp_route);
+  }
+  size_t result = (i == url.size()) ? trie_[node].literal_route : kNoMatch;
+
+  // Fast path: No regexp route before |result| can match.
+  if (first_candidate >= result)
+    return result;
+
+  if (regexp_set_) {
+    if (regexp_set_->Match(url, &set_matches_)) {
+      for (int set_index : set_matches_)
+        result = std::min(result, regexp_set_routes_[set_index]);
+    }
+    return result;
+  }
+
+  // Fall back to trying the routes in order.
+  for (size_t route = first_candidate; route < result; route++) {
+    if (re2::RE2::FullMatch(url, *routes_[route]))
+      return route;
+  }
+  return result;
+}
+
+// static
+std::string RouteTable::GetLiteralPrefix(const std::string& pattern,
+                                         bool* is_literal) {
+  *is_literal = false;
+  if (HasTopLevelAlternation(pattern))
+    return std::string();
+
+  std::string prefix;
+  size_t i = 0;
+  while (i < pattern.size()) {
+    char c = pattern[i];
+    size_t next = i + 1;
+    if (c == '\\') {
+      // Only escaped punctuation is a literal (e.g., "\d" isn't).
+      if (next >= pattern.size() || !ispunct(pattern[next]))
+        return prefix;
+      c = pattern[next];
+      next++;
+    } else if (IsMetacharacter(c)) {
+      return prefix;
+    }
+    // Be conservative about non-ASCII characters, since a repetition applies to
+    // an entire UTF-8 sequence.
+    if (static_cast<unsigned char>(c) >= 0x80)
+      return prefix;
+
+    // A literal that's repeated may be optional (and is definitely the last
+    // one that's required).
+    if (next < pattern.size()) {
+      char op = pattern[next];
+      if (op == '+') {
+        prefix.push_back(c);
+        return prefix;
+      }
+      if (op == '*' || op == '?' || op == '{')
+        return prefix;
+    }
+
+    prefix.push_back(c);
+    i = next;
+  }
+  *is_literal = true;
+  return prefix;
+}
+
+void RouteTable::Compile() {
+  trie_.clear();
+  trie_.push_back(TrieNode());
+  regexp_set_.reset();
+  regexp_set_routes_.clear();
+
+  scoped_ptr<re2::RE2::Set> regexp_set(
+      new re2::RE2::Set(re2::RE2::DefaultOptions, re2::RE2::ANCHOR_BOTH));
+  bool regexp_set_ok = true;
+  for (size_t route = 0; route < routes_.size(); route++) {
+    // Invalid patterns never match.
+    if (!routes_[route]->ok())
+      continue;
+
+    const std::string& pattern = routes_[route]->pattern();
+    bool is_literal = false;
+    std::string prefix = GetLiteralPrefix(pattern, &is_literal);
+    TrieNode* node = &trie_[GetOrAddTrieNode(prefix)];
+    if (is_literal) {
+      node->literal_route = std::min(node->literal_route, route);
+      continue;
+    }
+
+    node->min_regexp_route = std::min(node->min_regexp_route, route);
+    if (regexp_set->Add(pattern, nullptr) < 0)
+      regexp_set_ok = false;
+    regexp_set_routes_.push_back(route);
+  }
+  if (regexp_set_ok && !regexp_set_routes_.empty() && regexp_set->Compile())
+    regexp_set_ = regexp_set.Pass();
+
+  compiled_ = true;
+}
+
+size_t RouteTable::GetOrAddTrieNode(const std::string& prefix) {
+  size_t node = 0;
+  for (char c : prefix) {
+    std::map<char, size_t>::const_iterator it = trie_[node].children.find(c);
+    if (it != trie_[node].children.end()) {
+      node = it->second;
+      continue;
+    }
+    size_t child = trie_.size();
+    trie_.push_back(TrieNode());
+    trie_[node].children[c] = child;
+    node = child;
+  }
+  return node;
+}
+
+}  // namespace http_server
@@ -0,0 +1,97 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SERVICES_HTTP_SERVER_ROUTE_TABLE_H_
+#define SERVICES_HTTP_SERVER_ROUTE_TABLE_H_
+
+#include <stddef.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "third_party/re2/re2/re2.h"
+#include "third_party/re2/re2/set.h"
+
+namespace http_server {
+
+// Selects the first (in registration order) of a list of RE2 patterns that
+// fully matches a given URL, without trying each pattern in turn:
+//   - Routes that are plain literals (e.g., "/foo/bar") and the required
+//     literal prefixes of the other routes (e.g., "/static/" for
+//     "/static/.*") are stored in a trie, so that a single walk over the URL
+//     finds any exactly-matching literal route and the set of regexp routes
+//     that might match.
+//   - The regexp routes are compiled into a single |RE2::Set|, which finds all
+//     the matching ones in one pass. (This is skipped if the walk over the trie
+//     shows that no regexp route could beat the literal route found. If the
+//     set can't be built, the candidate routes are tried in order instead.)
+// The table is compiled lazily, on the first |Match()| after a change.
+class RouteTable {
+ public:
+  static const size_t kNoMatch = static_cast<size_t>(-1);
+
+  RouteTable();
+  ~RouteTable();
+
+  // Adds a route for |pattern| (which should fully match URLs), with the next
+  // index (i.e., |size()|). Invalid patterns never match.
+  void AddRoute(const std::string& pattern);
+
+  // Removes the route with the given index; the indices of later routes are
+  // decremented.
+  void RemoveRoute(size_t index);
+
+  // Returns the index of the first route that fully matches |url|, or
+  // |kNoMatch| if none does.
+  size_t Match(const std::string& url);
+
+  size_t size() const { return routes_.size(); }
+  const std::string& pattern(size_t index) const {
+    return routes_[index]->pattern();
+  }
+
+ private:
+  struct TrieNode {
+    TrieNode();
+    ~TrieNode();
+
+    std::map<char, size_t> children;  // Indices into |trie_|.
+    // The smallest index of a literal route ending at this node, if any.
+    size_t literal_route;
+    // The smallest index of a regexp route whose required prefix ends at this
+    // node, if any.
+    size_t min_regexp_route;
+  };
+
+  // Computes the literal prefix that any string fully matching |pattern| must
+  // start with; sets |*is_literal| if the whole pattern is a literal.
+  static std::string GetLiteralPrefix(const std::string& pattern,
+                                      bool* is_literal);
+
+  void Compile();
+
+  // Returns the trie node for |prefix|, adding nodes as needed.
+  size_t GetOrAddTrieNode(const std::string& prefix);
+
+  ScopedVector<re2::RE2> routes_;
+
+  // Everything below is computed by |Compile()|.
+  bool compiled_;
+  std::vector<TrieNode> trie_;  // The root is |trie_[0]|.
+  scoped_ptr<re2::RE2::Set> regexp_set_;
+  // Maps indices in |regexp_set_| to route indices.
+  std::vector<size_t> regexp_set_routes_;
+  // Scratch space for |Match()|.
+  std::vector<int> set_matches_;
+
+  DISALLOW_COPY_AND_ASSIGN(RouteTable);
+};
+
+}  // namespace http_server
+
+#endif  // SERVICES_HTTP_SERVER_ROUTE_TABLE_H_
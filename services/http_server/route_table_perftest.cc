@@ -0,0 +1,115 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares selecting a handler using |RouteTable| with trying each pattern in
+// turn (as |HttpServerImpl| used to), for various numbers of routes.
+
+#include <string>
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/memory/scoped_vector.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "services/http_server/route_table.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace http_server {
+namespace {
+
+const int kNumIterations = 20000;
+
+// Makes |num_routes| routes, a mix of literal ("/api/v1/3/items") and regexp
+// ("/static/5/.*", "/users/7/[0-9]+") patterns, plus a list of URLs that
+// (mostly) match them, with an unmatched URL every so often.
+void MakeRoutes(size_t num_routes,
+                std::vector<std::string>* patterns,
+                std::vector<std::string>* urls) {
+  for (size_t i = 0; i < num_routes; i++) {
+    switch (i % 3) {
+      case 0:
+        patterns->push_back(
+            base::StringPrintf("/api/v1/%" PRIuS "/items", i));
+        urls->push_back(patterns->back());
+        break;
+      case 1:
+        patterns->push_back(base::StringPrintf("/static/%" PRIuS "/.*", i));
+        urls->push_back(base::StringPrintf("/static/%" PRIuS "/app.js", i));
+        break;
+      case 2:
+        patterns->push_back(
+            base::StringPrintf("/users/%" PRIuS "/[0-9]+", i));
+        urls->push_back(base::StringPrintf("/users/%" PRIuS "/12345", i));
+        break;
+    }
+    if (i % 10 == 9)
+      urls->push_back(base::StringPrintf("/missing/%" PRIuS, i));
+  }
+}
+
+void RunTest(size_t num_routes) {
+  std::vector<std::string> patterns;
+  std::vector<std::string> urls;
+  MakeRoutes(num_routes, &patterns, &urls);
+  std::string trace = base::StringPrintf("%" PRIuS "_routes", num_routes);
+
+  // Try each pattern in turn.
+  {
+    ScopedVector<re2::RE2> regexps;
+    for (const auto& pattern : patterns)
+      regexps.push_back(new re2::RE2(pattern));
+    size_t num_matches = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kNumIterations; i++) {
+      const std::string& url = urls[i % urls.size()];
+      for (const re2::RE2* regexp : regexps) {
+        if (re2::RE2::FullMatch(url, *regexp)) {
+          num_matches++;
+          break;
+        }
+      }
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    perf_test::PrintResult("route_match_linear", "", trace,
+                           1000.0 * elapsed.InMicroseconds() / kNumIterations,
+                           "ns", true);
+    EXPECT_GT(num_matches, 0u);
+  }
+
+  // Use a |RouteTable|.
+  {
+    RouteTable routes;
+    for (const auto& pattern : patterns)
+      routes.AddRoute(pattern);
+    // Compile it outside the timed loop.
+    routes.Match(urls[0]);
+    size_t num_matches = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kNumIterations; i++) {
+      if (routes.Match(urls[i % urls.size()]) != RouteTable::kNoMatch)
+        num_matches++;
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    perf_test::PrintResult("route_match_table", "", trace,
+                           1000.0 * elapsed.InMicroseconds() / kNumIterations,
+                           "ns", true);
+    EXPECT_GT(num_matches, 0u);
+  }
+}
+
+TEST(RouteTablePerfTest, Match1Route) {
+  RunTest(1);
+}
+
+TEST(RouteTablePerfTest, Match50Routes) {
+  RunTest(50);
+}
+
+TEST(RouteTablePerfTest, Match500Routes) {
+  RunTest(500);
+}
+
+}  // namespace
+}  // namespace http_server
@@ -0,0 +1,182 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/http_server/route_table.h"
+
+#include "base/strings/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace http_server {
+namespace {
+
+TEST(RouteTableTest, Empty) {
+  RouteTable routes;
+  EXPECT_EQ(0u, routes.size());
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match(""));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/"));
+}
+
+TEST(RouteTableTest, Literals) {
+  RouteTable routes;
+  routes.AddRoute("/");
+  routes.AddRoute("/foo");
+  routes.AddRoute("/foo/bar");
+  routes.AddRoute("/foo\\.html");
+  EXPECT_EQ(4u, routes.size());
+  EXPECT_EQ("/foo", routes.pattern(1));
+
+  EXPECT_EQ(0u, routes.Match("/"));
+  EXPECT_EQ(1u, routes.Match("/foo"));
+  EXPECT_EQ(2u, routes.Match("/foo/bar"));
+  EXPECT_EQ(3u, routes.Match("/foo.html"));
+  // Patterns must match fully.
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match(""));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/fo"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/foo/"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/foo/bar/baz"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/fooxhtml"));
+}
+
+TEST(RouteTableTest, Regexps) {
+  RouteTable routes;
+  routes.AddRoute("/static/.*");
+  routes.AddRoute("/items/[0-9]+");
+  routes.AddRoute("/a+b");
+  routes.AddRoute("/x?y");
+  routes.AddRoute("/(cat|dog)s");
+  routes.AddRoute("/p\\d");
+
+  EXPECT_EQ(0u, routes.Match("/static/"));
+  EXPECT_EQ(0u, routes.Match("/static/foo/bar.css"));
+  EXPECT_EQ(1u, routes.Match("/items/123"));
+  EXPECT_EQ(2u, routes.Match("/ab"));
+  EXPECT_EQ(2u, routes.Match("/aaab"));
+  EXPECT_EQ(3u, routes.Match("/y"));
+  EXPECT_EQ(3u, routes.Match("/xy"));
+  EXPECT_EQ(4u, routes.Match("/cats"));
+  EXPECT_EQ(4u, routes.Match("/dogs"));
+  EXPECT_EQ(5u, routes.Match("/p7"));
+
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/static"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/items/"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/items/12a"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/b"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/xxy"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/cows"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/pp"));
+}
+
+// Patterns with a top-level alternation have no required prefix.
+TEST(RouteTableTest, TopLevelAlternation) {
+  RouteTable routes;
+  routes.AddRoute("/foo|/bar");
+  routes.AddRoute("[|]x|/baz");
+
+  EXPECT_EQ(0u, routes.Match("/foo"));
+  EXPECT_EQ(0u, routes.Match("/bar"));
+  EXPECT_EQ(1u, routes.Match("|x"));
+  EXPECT_EQ(1u, routes.Match("/baz"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/foo|/bar"));
+}
+
+// The first matching route (in registration order) wins, whether it's a
+// literal or not.
+TEST(RouteTableTest, RegistrationOrder) {
+  RouteTable routes;
+  routes.AddRoute("/a/.*");
+  routes.AddRoute("/a/b");
+  routes.AddRoute("/c/d");
+  routes.AddRoute("/c/.*");
+  routes.AddRoute(".*");
+  routes.AddRoute("/e");
+
+  EXPECT_EQ(0u, routes.Match("/a/b"));
+  EXPECT_EQ(0u, routes.Match("/a/x"));
+  EXPECT_EQ(2u, routes.Match("/c/d"));
+  EXPECT_EQ(3u, routes.Match("/c/x"));
+  EXPECT_EQ(4u, routes.Match("/e"));
+  EXPECT_EQ(4u, routes.Match(""));
+  EXPECT_EQ(4u, routes.Match("/anything"));
+}
+
+TEST(RouteTableTest, DuplicatePatterns) {
+  RouteTable routes;
+  routes.AddRoute("/a");
+  routes.AddRoute("/b.*");
+  routes.AddRoute("/a");
+  routes.AddRoute("/b.*");
+
+  EXPECT_EQ(0u, routes.Match("/a"));
+  EXPECT_EQ(1u, routes.Match("/bcd"));
+}
+
+TEST(RouteTableTest, InvalidPatterns) {
+  RouteTable routes;
+  routes.AddRoute("/a(");
+  routes.AddRoute("/b");
+  routes.AddRoute("[");
+  routes.AddRoute("/c.*");
+
+  EXPECT_EQ("/a(", routes.pattern(0));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/a("));
+  EXPECT_EQ(1u, routes.Match("/b"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("["));
+  EXPECT_EQ(3u, routes.Match("/c"));
+}
+
+TEST(RouteTableTest, AddAndRemove) {
+  RouteTable routes;
+  routes.AddRoute("/a.*");
+  routes.AddRoute("/ab");
+  EXPECT_EQ(0u, routes.Match("/ab"));
+
+  routes.RemoveRoute(0);
+  EXPECT_EQ(1u, routes.size());
+  EXPECT_EQ("/ab", routes.pattern(0));
+  EXPECT_EQ(0u, routes.Match("/ab"));
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/ac"));
+
+  routes.AddRoute("/a.");
+  EXPECT_EQ(0u, routes.Match("/ab"));
+  EXPECT_EQ(1u, routes.Match("/ac"));
+
+  routes.RemoveRoute(0);
+  routes.RemoveRoute(0);
+  EXPECT_EQ(0u, routes.size());
+  EXPECT_EQ(RouteTable::kNoMatch, routes.Match("/ab"));
+}
+
+// Checks that the table agrees with trying each pattern in turn, for many
+// routes.
+TEST(RouteTableTest, ManyRoutes) {
+  std::vector<std::string> patterns;
+  RouteTable routes;
+  for (int i = 0; i < 100; i++) {
+    if (i % 3 == 0)
+      patterns.push_back(base::StringPrintf("/r%d", i));
+    else if (i % 3 == 1)
+      patterns.push_back(base::StringPrintf("/r%d/.*", i));
+    else
+      patterns.push_back(base::StringPrintf("/r[0-9]*%d", i));
+    routes.AddRoute(patterns.back());
+  }
+
+  for (int i = 0; i < 120; i++) {
+    const char* const kFormats[] = {"/r%d", "/r%d/", "/r%d/x", "/r1%d"};
+    for (const char* format : kFormats) {
+      std::string url = base::StringPrintf(format, i);
+      size_t expected = RouteTable::kNoMatch;
+      for (size_t j = 0; j < patterns.size(); j++) {
+        if (re2::RE2::FullMatch(url, patterns[j])) {
+          expected = j;
+          break;
+        }
+      }
+      EXPECT_EQ(expected, routes.Match(url)) << url;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace http_server
@@ -230,6 +230,19 @@ bool ConnectionManager::DidConnectionMessageClient(
   return current_change_ && current_change_->DidMessageConnection(id);
 }
 
+void ConnectionManager::OnConnectionHasPendingChanges() {
+  if (!flush_timer_.IsRunning()) {
+    flush_timer_.Start(FROM_HERE, base::TimeDelta(), this,
+                       &ConnectionManager::FlushPendingChanges);
+  }
+}
+
+void ConnectionManager::FlushPendingChanges() {
+  flush_timer_.Stop();
+  for (auto& pair : connection_map_)
+    pair.second->service()->FlushPendingChanges();
+}
+
 const ViewManagerServiceImpl* ConnectionManager::GetConnectionWithRoot(
     const ViewId& id) const {
   for (auto& pair : connection_map_) {
@@ -490,6 +503,7 @@ void ConnectionManager::DispatchInputEventToView(mojo::Id transport_view_id,
   if (!connection)
     connection = GetConnection(view_id.connection_id);
   if (connection) {
+    connection->FlushPendingChanges();
     connection->client()->OnViewInputEvent(
         transport_view_id, event.Pass(), base::Bind(&base::DoNothing));
   }
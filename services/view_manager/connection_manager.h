@@ -115,6 +115,15 @@ class ConnectionManager : public ServerViewDelegate,
   // Returns true if OnConnectionMessagedClient() was invoked for id.
   bool DidConnectionMessageClient(mojo::ConnectionSpecificId id) const;
 
+  // Invoked when a connection has batched up a change for its client rather
+  // than sending it. Pending changes are sent once the current task is done, so
+  // that the changes made by a batch of requests (e.g., a client animating a
+  // number of views) result in one message per client.
+  void OnConnectionHasPendingChanges();
+
+  // Sends all pending changes to the clients now.
+  void FlushPendingChanges();
+
   // Returns the ViewManagerServiceImpl that has |id| as a root.
   ViewManagerServiceImpl* GetConnectionWithRoot(const ViewId& id) {
     return const_cast<ViewManagerServiceImpl*>(
@@ -242,6 +251,9 @@ class ConnectionManager : public ServerViewDelegate,
   // TODO(sky): nuke! Just a proof of concept until get real animation api.
   base::RepeatingTimer<ConnectionManager> animation_timer_;
 
+  // Runs FlushPendingChanges() after the current task.
+  base::OneShotTimer<ConnectionManager> flush_timer_;
+
   AnimationRunner animation_runner_;
 
   DISALLOW_COPY_AND_ASSIGN(ConnectionManager);
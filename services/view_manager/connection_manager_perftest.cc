@@ -0,0 +1,310 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Counts the messages (and bytes) sent to clients per frame of an animation
+// that changes the bounds of many views across many clients, with bounds
+// changes sent one per change and batched up per frame.
+
+#include <string>
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "mojo/public/cpp/bindings/message.h"
+#include "mojo/services/view_manager/public/interfaces/view_manager.mojom.h"
+#include "mojo/services/window_manager/public/interfaces/window_manager_internal.mojom.h"
+#include "services/view_manager/client_connection.h"
+#include "services/view_manager/connection_manager.h"
+#include "services/view_manager/connection_manager_delegate.h"
+#include "services/view_manager/display_manager.h"
+#include "services/view_manager/ids.h"
+#include "services/view_manager/server_view.h"
+#include "services/view_manager/view_manager_service_impl.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gfx/geometry/rect.h"
+
+namespace view_manager {
+namespace {
+
+const int kNumWarmUpFrames = 5;
+const int kNumFrames = 50;
+
+// MessageReceiver that counts (and drops) the messages sent to a client.
+class CountingMessageReceiver : public mojo::MessageReceiverWithResponder {
+ public:
+  CountingMessageReceiver() : num_messages_(0), num_bytes_(0) {}
+  ~CountingMessageReceiver() override {}
+
+  size_t num_messages() const { return num_messages_; }
+  size_t num_bytes() const { return num_bytes_; }
+
+  void Reset() {
+    num_messages_ = 0;
+    num_bytes_ = 0;
+  }
+
+  // mojo::MessageReceiverWithResponder:
+  bool Accept(mojo::Message* message) override {
+    num_messages_++;
+    num_bytes_ += message->data_num_bytes();
+    return true;
+  }
+  bool AcceptWithResponder(mojo::Message* message,
+                           mojo::MessageReceiver* responder) override {
+    delete responder;
+    return Accept(message);
+  }
+
+ private:
+  size_t num_messages_;
+  size_t num_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingMessageReceiver);
+};
+
+// ClientConnection whose client serializes calls to a CountingMessageReceiver.
+class CountingClientConnection : public ClientConnection {
+ public:
+  explicit CountingClientConnection(
+      scoped_ptr<ViewManagerServiceImpl> service_impl)
+      : ClientConnection(service_impl.Pass(), &client_), client_(&receiver_) {}
+  ~CountingClientConnection() override {}
+
+  CountingMessageReceiver* receiver() { return &receiver_; }
+
+ private:
+  CountingMessageReceiver receiver_;
+  mojo::ViewManagerClientProxy client_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingClientConnection);
+};
+
+// ConnectionManagerDelegate that creates CountingClientConnections.
+class CountingConnectionManagerDelegate : public ConnectionManagerDelegate {
+ public:
+  CountingConnectionManagerDelegate() {}
+  ~CountingConnectionManagerDelegate() override {}
+
+  const std::vector<CountingClientConnection*>& connections() const {
+    return connections_;
+  }
+
+ private:
+  // ConnectionManagerDelegate:
+  void OnLostConnectionToWindowManager() override {}
+
+  ClientConnection* CreateClientConnectionForEmbedAtView(
+      ConnectionManager* connection_manager,
+      mojo::InterfaceRequest<mojo::ViewManagerService> service_request,
+      mojo::ConnectionSpecificId creator_id,
+      const std::string& creator_url,
+      const std::string& url,
+      const ViewId& root_id) override {
+    scoped_ptr<ViewManagerServiceImpl> service(new ViewManagerServiceImpl(
+        connection_manager, creator_id, creator_url, url, root_id));
+    connections_.push_back(new CountingClientConnection(service.Pass()));
+    return connections_.back();
+  }
+  ClientConnection* CreateClientConnectionForEmbedAtView(
+      ConnectionManager* connection_manager,
+      mojo::InterfaceRequest<mojo::ViewManagerService> service_request,
+      mojo::ConnectionSpecificId creator_id,
+      const std::string& creator_url,
+      const ViewId& root_id,
+      mojo::ViewManagerClientPtr client) override {
+    NOTIMPLEMENTED();
+    return nullptr;
+  }
+
+  // Owned by the ConnectionManager.
+  std::vector<CountingClientConnection*> connections_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingConnectionManagerDelegate);
+};
+
+// Empty implementation of DisplayManager (with valid metrics, since they're
+// serialized).
+class TestDisplayManager : public DisplayManager {
+ public:
+  TestDisplayManager() { display_metrics_.size = mojo::Size::New(); }
+  ~TestDisplayManager() override {}
+
+  // DisplayManager:
+  void Init(ConnectionManager* connection_manager) override {}
+  void SchedulePaint(const ServerView* view, const gfx::Rect& bounds) override {
+  }
+  void SetViewportSize(const gfx::Size& size) override {}
+  const mojo::ViewportMetrics& GetViewportMetrics() override {
+    return display_metrics_;
+  }
+
+ private:
+  mojo::ViewportMetrics display_metrics_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestDisplayManager);
+};
+
+// Empty implementation of WindowManagerInternal.
+class TestWindowManagerInternal : public mojo::WindowManagerInternal {
+ public:
+  TestWindowManagerInternal() {}
+  ~TestWindowManagerInternal() override {}
+
+  // WindowManagerInternal:
+  void CreateWindowManagerForViewManagerClient(
+      uint16_t connection_id,
+      mojo::ScopedMessagePipeHandle window_manager_pipe) override {}
+  void SetViewManagerClient(mojo::ScopedMessagePipeHandle) override {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TestWindowManagerInternal);
+};
+
+class ConnectionManagerPerfTest : public testing::Test {
+ public:
+  ConnectionManagerPerfTest() {}
+  ~ConnectionManagerPerfTest() override {}
+
+ protected:
+  // testing::Test:
+  void SetUp() override {
+    connection_manager_.reset(new ConnectionManager(
+        &delegate_, scoped_ptr<DisplayManager>(new TestDisplayManager),
+        &wm_internal_));
+    scoped_ptr<ViewManagerServiceImpl> service(new ViewManagerServiceImpl(
+        connection_manager_.get(), kInvalidConnectionId, std::string(),
+        std::string("mojo:window_manager"), RootViewId()));
+    connection_manager_->SetWindowManagerClientConnection(
+        make_scoped_ptr(new CountingClientConnection(service.Pass())));
+  }
+
+  void TearDown() override { connection_manager_.reset(); }
+
+  // Embeds |num_clients| clients (each at a view of the window manager), each
+  // of which creates |num_views_per_client| views.
+  void CreateViews(size_t num_clients, size_t num_views_per_client) {
+    ViewManagerServiceImpl* wm_connection =
+        connection_manager_->GetConnection(1);
+    for (size_t i = 0; i < num_clients; i++) {
+      const ViewId embed_view_id(
+          wm_connection->id(), static_cast<mojo::ConnectionSpecificId>(i + 1));
+      ASSERT_EQ(mojo::ERROR_CODE_NONE,
+                wm_connection->CreateView(embed_view_id));
+      ASSERT_TRUE(wm_connection->SetViewVisibility(embed_view_id, true));
+      ASSERT_TRUE(
+          wm_connection->AddView(*wm_connection->root(), embed_view_id));
+      ASSERT_TRUE(wm_connection->EmbedUrl(std::string(), embed_view_id,
+                                          nullptr, nullptr));
+      ViewManagerServiceImpl* connection =
+          connection_manager_->GetConnectionWithRoot(embed_view_id);
+      ASSERT_TRUE(connection);
+      for (size_t j = 0; j < num_views_per_client; j++) {
+        const ViewId view_id(connection->id(),
+                             static_cast<mojo::ConnectionSpecificId>(j + 1));
+        ASSERT_EQ(mojo::ERROR_CODE_NONE, connection->CreateView(view_id));
+        ASSERT_TRUE(connection->SetViewVisibility(view_id, true));
+        ASSERT_TRUE(connection->AddView(embed_view_id, view_id));
+        views_.push_back(connection->GetView(view_id));
+      }
+    }
+    connection_manager_->FlushPendingChanges();
+  }
+
+  // Moves every view |num_changes_per_view| times, as the window manager would
+  // in a frame of an animation (a separate change each time). If |batched| is
+  // false, each change is sent right away, otherwise they're sent at the end of
+  // the frame.
+  void AnimateFrame(int frame, size_t num_changes_per_view, bool batched) {
+    ViewManagerServiceImpl* wm_connection =
+        connection_manager_->GetConnection(1);
+    for (size_t i = 0; i < num_changes_per_view; i++) {
+      for (size_t j = 0; j < views_.size(); j++) {
+        {
+          ConnectionManager::ScopedChange change(
+              wm_connection, connection_manager_.get(), false);
+          views_[j]->SetBounds(gfx::Rect(frame, static_cast<int>(j),
+                                         100 + frame,
+                                         100 + static_cast<int>(i)));
+        }
+        if (!batched)
+          connection_manager_->FlushPendingChanges();
+      }
+    }
+    connection_manager_->FlushPendingChanges();
+  }
+
+  void Measure(size_t num_clients,
+               size_t num_views_per_client,
+               size_t num_changes_per_view,
+               bool batched) {
+    CreateViews(num_clients, num_views_per_client);
+
+    int frame = 0;
+    for (; frame < kNumWarmUpFrames; frame++)
+      AnimateFrame(frame, num_changes_per_view, batched);
+
+    for (CountingClientConnection* connection : delegate_.connections())
+      connection->receiver()->Reset();
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    for (int i = 0; i < kNumFrames; i++, frame++)
+      AnimateFrame(frame, num_changes_per_view, batched);
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+
+    size_t num_messages = 0;
+    size_t num_bytes = 0;
+    for (CountingClientConnection* connection : delegate_.connections()) {
+      num_messages += connection->receiver()->num_messages();
+      num_bytes += connection->receiver()->num_bytes();
+    }
+    EXPECT_GT(num_messages, 0u);
+
+    const std::string trace = base::StringPrintf(
+        "%" PRIuS "_clients_%" PRIuS "_views_%" PRIuS "_changes_%s",
+        num_clients, num_clients * num_views_per_client, num_changes_per_view,
+        batched ? "batched" : "unbatched");
+    perf_test::PrintResult("view_manager_messages_per_frame", "", trace,
+                           static_cast<double>(num_messages) / kNumFrames,
+                           "messages", true);
+    perf_test::PrintResult("view_manager_bytes_per_frame", "", trace,
+                           static_cast<double>(num_bytes) / kNumFrames,
+                           "bytes", true);
+    perf_test::PrintResult("view_manager_time_per_frame", "", trace,
+                           static_cast<double>(elapsed.InMicroseconds()) /
+                               kNumFrames,
+                           "us", true);
+  }
+
+ private:
+  base::MessageLoop message_loop_;
+  TestWindowManagerInternal wm_internal_;
+  CountingConnectionManagerDelegate delegate_;
+  scoped_ptr<ConnectionManager> connection_manager_;
+  std::vector<ServerView*> views_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConnectionManagerPerfTest);
+};
+
+TEST_F(ConnectionManagerPerfTest, AnimateUnbatched) {
+  Measure(20, 10, 1, false);
+}
+
+TEST_F(ConnectionManagerPerfTest, AnimateBatched) {
+  Measure(20, 10, 1, true);
+}
+
+// Each view is moved more than once per frame (e.g., by more than one
+// animation).
+TEST_F(ConnectionManagerPerfTest, AnimateRepeatedChangesUnbatched) {
+  Measure(20, 10, 3, false);
+}
+
+TEST_F(ConnectionManagerPerfTest, AnimateRepeatedChangesBatched) {
+  Measure(20, 10, 3, true);
+}
+
+}  // namespace
+}  // namespace view_manager
@@ -202,6 +202,14 @@ void TestChangeTracker::OnViewBoundsChanged(Id view_id,
   AddChange(change);
 }
 
+void TestChangeTracker::OnViewsBoundsChanged(
+    mojo::Array<mojo::ViewBoundsChangePtr> changes) {
+  for (size_t i = 0; i < changes.size(); ++i) {
+    OnViewBoundsChanged(changes[i]->view_id, changes[i]->old_bounds.Pass(),
+                        changes[i]->new_bounds.Pass());
+  }
+}
+
 void TestChangeTracker::OnViewViewportMetricsChanged(
     mojo::ViewportMetricsPtr old_metrics,
     mojo::ViewportMetricsPtr new_metrics) {
@@ -125,6 +125,9 @@ class TestChangeTracker {
   void OnViewBoundsChanged(mojo::Id view_id,
                            mojo::RectPtr old_bounds,
                            mojo::RectPtr new_bounds);
+  // Generates a change per element of |changes|, as if OnViewBoundsChanged()
+  // were called for each.
+  void OnViewsBoundsChanged(mojo::Array<mojo::ViewBoundsChangePtr> changes);
   void OnViewViewportMetricsChanged(mojo::ViewportMetricsPtr old_bounds,
                                     mojo::ViewportMetricsPtr new_bounds);
   void OnViewHierarchyChanged(mojo::Id view_id,
@@ -31,6 +31,7 @@ using mojo::RectPtr;
 using mojo::ServiceProvider;
 using mojo::ServiceProviderPtr;
 using mojo::String;
+using mojo::ViewBoundsChangePtr;
 using mojo::ViewDataPtr;
 using mojo::ViewManagerClient;
 using mojo::ViewManagerService;
@@ -305,6 +306,9 @@ class ViewManagerClientImpl : public mojo::ViewManagerClient,
     tracker()->OnViewBoundsChanged(view_id, old_bounds.Pass(),
                                    new_bounds.Pass());
   }
+  void OnViewsBoundsChanged(Array<ViewBoundsChangePtr> changes) override {
+    tracker()->OnViewsBoundsChanged(changes.Pass());
+  }
   void OnViewViewportMetricsChanged(ViewportMetricsPtr old_metrics,
                                     ViewportMetricsPtr new_metrics) override {
     tracker()->OnViewViewportMetricsChanged(old_metrics.Pass(),
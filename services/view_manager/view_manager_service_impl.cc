@@ -89,6 +89,7 @@ void ViewManagerServiceImpl::OnWillDestroyViewManagerServiceImpl(
     creator_id_ = kInvalidConnectionId;
   if (connection->root_ && connection->root_->connection_id == id_ &&
       view_map_.count(connection->root_->view_id) > 0) {
+    FlushPendingChanges();
     client()->OnEmbeddedAppDisconnected(
         ViewIdToTransportId(*connection->root_));
   }
@@ -96,6 +97,38 @@ void ViewManagerServiceImpl::OnWillDestroyViewManagerServiceImpl(
     root_.reset();
 }
 
+void ViewManagerServiceImpl::FlushPendingChanges() {
+  if (pending_bounds_changes_.empty())
+    return;
+
+  std::vector<PendingBoundsChange> changes;
+  changes.swap(pending_bounds_changes_);
+  pending_bounds_change_indices_.clear();
+
+  // Views may have become unknown since they changed, and bounds may have been
+  // changed back.
+  Array<mojo::ViewBoundsChangePtr> to_send(0);
+  for (const PendingBoundsChange& change : changes) {
+    if (!known_views_.count(change.view_id) ||
+        change.old_bounds == change.new_bounds) {
+      continue;
+    }
+    mojo::ViewBoundsChangePtr change_data(mojo::ViewBoundsChange::New());
+    change_data->view_id = change.view_id;
+    change_data->old_bounds = Rect::From(change.old_bounds);
+    change_data->new_bounds = Rect::From(change.new_bounds);
+    to_send.push_back(change_data.Pass());
+  }
+
+  if (to_send.size() == 1u) {
+    client()->OnViewBoundsChanged(to_send[0]->view_id,
+                                  to_send[0]->old_bounds.Pass(),
+                                  to_send[0]->new_bounds.Pass());
+  } else if (to_send.size() > 1u) {
+    client()->OnViewsBoundsChanged(to_send.Pass());
+  }
+}
+
 mojo::ErrorCode ViewManagerServiceImpl::CreateView(const ViewId& view_id) {
   if (view_id.connection_id != id_)
     return mojo::ERROR_CODE_ILLEGAL_ARGUMENT;
@@ -167,15 +200,24 @@ void ViewManagerServiceImpl::ProcessViewBoundsChanged(
     bool originated_change) {
   if (originated_change || !IsViewKnown(view))
     return;
-  client()->OnViewBoundsChanged(ViewIdToTransportId(view->id()),
-                                Rect::From(old_bounds),
-                                Rect::From(new_bounds));
+
+  const Id view_id = ViewIdToTransportId(view->id());
+  auto it = pending_bounds_change_indices_.find(view_id);
+  if (it != pending_bounds_change_indices_.end()) {
+    pending_bounds_changes_[it->second].new_bounds = new_bounds;
+    return;
+  }
+  pending_bounds_change_indices_[view_id] = pending_bounds_changes_.size();
+  PendingBoundsChange change = {view_id, old_bounds, new_bounds};
+  pending_bounds_changes_.push_back(change);
+  connection_manager_->OnConnectionHasPendingChanges();
 }
 
 void ViewManagerServiceImpl::ProcessViewportMetricsChanged(
     const mojo::ViewportMetrics& old_metrics,
     const mojo::ViewportMetrics& new_metrics,
     bool originated_change) {
+  FlushPendingChanges();
   client()->OnViewViewportMetricsChanged(old_metrics.Clone(),
                                          new_metrics.Clone());
 }
@@ -209,6 +251,7 @@ void ViewManagerServiceImpl::ProcessViewPropertyChanged(
   if (new_data)
     data = Array<uint8_t>::From(*new_data);
 
+  FlushPendingChanges();
   client()->OnViewSharedPropertyChanged(ViewIdToTransportId(view->id()),
                                         String(name), data.Pass());
 }
@@ -218,6 +261,8 @@ void ViewManagerServiceImpl::ProcessViewHierarchyChanged(
     const ServerView* new_parent,
     const ServerView* old_parent,
     bool originated_change) {
+  // This may change the set of known views, so send pending changes first.
+  FlushPendingChanges();
   if (originated_change && !IsViewKnown(view) && new_parent &&
       IsViewKnown(new_parent)) {
     std::vector<const ServerView*> unused;
@@ -253,6 +298,7 @@ void ViewManagerServiceImpl::ProcessViewReorder(const ServerView* view,
   if (originated_change || !IsViewKnown(view) || !IsViewKnown(relative_view))
     return;
 
+  FlushPendingChanges();
   client()->OnViewReordered(ViewIdToTransportId(view->id()),
                             ViewIdToTransportId(relative_view->id()),
                             direction);
@@ -260,6 +306,7 @@ void ViewManagerServiceImpl::ProcessViewReorder(const ServerView* view,
 
 void ViewManagerServiceImpl::ProcessViewDeleted(const ViewId& view,
                                                 bool originated_change) {
+  FlushPendingChanges();
   if (view.connection_id == id_)
     view_map_.erase(view.view_id);
 
@@ -284,6 +331,7 @@ void ViewManagerServiceImpl::ProcessWillChangeViewVisibility(
     return;
 
   if (IsViewKnown(view)) {
+    FlushPendingChanges();
     client()->OnViewVisibilityChanged(ViewIdToTransportId(view->id()),
                                       !view->visible());
     return;
@@ -377,6 +425,7 @@ void ViewManagerServiceImpl::RemoveRoot() {
   if (root_id.connection_id == id_)
     return;
 
+  FlushPendingChanges();
   client()->OnViewDeleted(ViewIdToTransportId(root_id));
   connection_manager_->OnConnectionMessagedClient(id_);
 
@@ -455,6 +504,7 @@ void ViewManagerServiceImpl::NotifyDrawnStateChanged(const ServerView* view,
   DCHECK(root);
   if (view->Contains(root) &&
       (new_drawn_value != root->IsDrawn(connection_manager_->root()))) {
+    FlushPendingChanges();
     client()->OnViewDrawnStateChanged(ViewIdToTransportId(root->id()),
                                       new_drawn_value);
   }
@@ -494,7 +544,10 @@ bool ViewManagerServiceImpl::PrepareForEmbed(const ViewId& view_id) {
 void ViewManagerServiceImpl::CreateView(
     Id transport_view_id,
     const Callback<void(mojo::ErrorCode)>& callback) {
-  callback.Run(CreateView(ViewIdFromTransportId(transport_view_id)));
+  const mojo::ErrorCode result =
+      CreateView(ViewIdFromTransportId(transport_view_id));
+  FlushPendingChanges();
+  callback.Run(result);
 }
 
 void ViewManagerServiceImpl::DeleteView(
@@ -507,6 +560,7 @@ void ViewManagerServiceImpl::DeleteView(
         connection_manager_->GetConnection(view->id().connection_id);
     success = connection && connection->DeleteViewImpl(this, view);
   }
+  FlushPendingChanges();
   callback.Run(success);
 }
 
@@ -514,8 +568,10 @@ void ViewManagerServiceImpl::AddView(
     Id parent_id,
     Id child_id,
     const Callback<void(bool)>& callback) {
-  callback.Run(AddView(ViewIdFromTransportId(parent_id),
-                       ViewIdFromTransportId(child_id)));
+  const bool success = AddView(ViewIdFromTransportId(parent_id),
+                               ViewIdFromTransportId(child_id));
+  FlushPendingChanges();
+  callback.Run(success);
 }
 
 void ViewManagerServiceImpl::RemoveViewFromParent(
@@ -528,6 +584,7 @@ void ViewManagerServiceImpl::RemoveViewFromParent(
     ConnectionManager::ScopedChange change(this, connection_manager_, false);
     view->parent()->Remove(view);
   }
+  FlushPendingChanges();
   callback.Run(success);
 }
 
@@ -544,6 +601,7 @@ void ViewManagerServiceImpl::ReorderView(Id view_id,
     view->parent()->Reorder(view, relative_view, direction);
     connection_manager_->ProcessViewReorder(view, relative_view, direction);
   }
+  FlushPendingChanges();
   callback.Run(success);
 }
 
@@ -552,6 +610,7 @@ void ViewManagerServiceImpl::GetViewTree(
     const Callback<void(Array<ViewDataPtr>)>& callback) {
   std::vector<const ServerView*> views(
       GetViewTree(ViewIdFromTransportId(view_id)));
+  FlushPendingChanges();
   callback.Run(ViewsToViewDatas(views));
 }
 
@@ -561,12 +620,11 @@ void ViewManagerServiceImpl::SetViewSurfaceId(
     const Callback<void(bool)>& callback) {
   // TODO(sky): add coverage of not being able to set for random node.
   ServerView* view = GetView(ViewIdFromTransportId(view_id));
-  if (!view || !access_policy_->CanSetViewSurfaceId(view)) {
-    callback.Run(false);
-    return;
-  }
-  view->SetSurfaceId(surface_id.To<cc::SurfaceId>());
-  callback.Run(true);
+  const bool success = view && access_policy_->CanSetViewSurfaceId(view);
+  if (success)
+    view->SetSurfaceId(surface_id.To<cc::SurfaceId>());
+  FlushPendingChanges();
+  callback.Run(success);
 }
 
 void ViewManagerServiceImpl::SetViewBounds(
@@ -579,6 +637,7 @@ void ViewManagerServiceImpl::SetViewBounds(
     ConnectionManager::ScopedChange change(this, connection_manager_, false);
     view->SetBounds(bounds.To<gfx::Rect>());
   }
+  FlushPendingChanges();
   callback.Run(success);
 }
 
@@ -586,8 +645,10 @@ void ViewManagerServiceImpl::SetViewVisibility(
     Id transport_view_id,
     bool visible,
     const Callback<void(bool)>& callback) {
-  callback.Run(
-      SetViewVisibility(ViewIdFromTransportId(transport_view_id), visible));
+  const bool success =
+      SetViewVisibility(ViewIdFromTransportId(transport_view_id), visible);
+  FlushPendingChanges();
+  callback.Run(success);
 }
 
 void ViewManagerServiceImpl::SetViewProperty(
@@ -607,6 +668,7 @@ void ViewManagerServiceImpl::SetViewProperty(
       view->SetProperty(name, &data);
     }
   }
+  FlushPendingChanges();
   callback.Run(success);
 }
 
@@ -616,21 +678,27 @@ void ViewManagerServiceImpl::EmbedUrl(
     InterfaceRequest<ServiceProvider> services,
     ServiceProviderPtr exposed_services,
     const Callback<void(bool)>& callback) {
-  callback.Run(EmbedUrl(url.To<std::string>(),
-                        ViewIdFromTransportId(transport_view_id),
-                        services.Pass(), exposed_services.Pass()));
+  const bool success = EmbedUrl(url.To<std::string>(),
+                                ViewIdFromTransportId(transport_view_id),
+                                services.Pass(), exposed_services.Pass());
+  FlushPendingChanges();
+  callback.Run(success);
 }
 
 void ViewManagerServiceImpl::Embed(mojo::Id transport_view_id,
                                    mojo::ViewManagerClientPtr client,
                                    const mojo::Callback<void(bool)>& callback) {
-  callback.Run(Embed(ViewIdFromTransportId(transport_view_id), client.Pass()));
+  const bool success =
+      Embed(ViewIdFromTransportId(transport_view_id), client.Pass());
+  FlushPendingChanges();
+  callback.Run(success);
 }
 
 void ViewManagerServiceImpl::PerformAction(
     mojo::Id transport_view_id,
     const mojo::String& action,
     const mojo::Callback<void(bool)>& callback) {
+  connection_manager_->FlushPendingChanges();
   connection_manager_->GetWindowManagerViewManagerClient()->OnPerformAction(
       transport_view_id, action, callback);
 }
@@ -16,10 +16,7 @@
 #include "mojo/services/view_manager/public/interfaces/view_manager.mojom.h"
 #include "services/view_manager/access_policy_delegate.h"
 #include "services/view_manager/ids.h"
-
-namespace gfx {
-class Rect;
-}
+#include "ui/gfx/geometry/rect.h"
 
 namespace view_manager {
 
@@ -73,6 +70,12 @@ class ViewManagerServiceImpl : public mojo::ViewManagerService,
   // Invoked when a connection is about to be destroyed.
   void OnWillDestroyViewManagerServiceImpl(ViewManagerServiceImpl* connection);
 
+  // Sends the changes that have been batched up (see
+  // ProcessViewBoundsChanged()) to the client. This is done before any other
+  // message is sent to the client, and before any response to a
+  // ViewManagerService call, so the client sees changes in order.
+  void FlushPendingChanges();
+
   // These functions are synchronous variants of those defined in the mojom. The
   // ViewManagerService implementations all call into these. See the mojom for
   // details.
@@ -88,7 +91,8 @@ class ViewManagerServiceImpl : public mojo::ViewManagerService,
 
   // The following methods are invoked after the corresponding change has been
   // processed. They do the appropriate bookkeeping and update the client as
-  // necessary.
+  // necessary. Bounds changes aren't sent right away; they're batched up (and
+  // repeated changes to the same view collapsed) until FlushPendingChanges().
   void ProcessViewBoundsChanged(const ServerView* view,
                                 const gfx::Rect& old_bounds,
                                 const gfx::Rect& new_bounds,
@@ -121,6 +125,13 @@ class ViewManagerServiceImpl : public mojo::ViewManagerService,
  private:
   typedef std::map<mojo::ConnectionSpecificId, ServerView*> ViewMap;
 
+  // A bounds change that hasn't been sent to the client yet.
+  struct PendingBoundsChange {
+    mojo::Id view_id;
+    gfx::Rect old_bounds;
+    gfx::Rect new_bounds;
+  };
+
   bool IsViewKnown(const ServerView* view) const;
 
   // These functions return true if the corresponding mojom function is allowed
@@ -247,6 +258,11 @@ class ViewManagerServiceImpl : public mojo::ViewManagerService,
   // The set of views that has been communicated to the client.
   ViewIdSet known_views_;
 
+  // Bounds changes not yet sent to the client, in the order the views first
+  // changed, and the index in |pending_bounds_changes_| of each view's change.
+  std::vector<PendingBoundsChange> pending_bounds_changes_;
+  base::hash_map<mojo::Id, size_t> pending_bounds_change_indices_;
+
   // The root of this connection. This is a scoped_ptr to reinforce the
   // connection may have no root. A connection has no root if either the root
   // is destroyed or Embed() is invoked on the root.
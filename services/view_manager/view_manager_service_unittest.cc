@@ -65,6 +65,10 @@ class TestViewManagerClient : public mojo::ViewManagerClient {
                            mojo::RectPtr new_bounds) override {
     tracker_.OnViewBoundsChanged(view, old_bounds.Pass(), new_bounds.Pass());
   }
+  void OnViewsBoundsChanged(
+      Array<mojo::ViewBoundsChangePtr> changes) override {
+    tracker_.OnViewsBoundsChanged(changes.Pass());
+  }
   void OnViewViewportMetricsChanged(
       mojo::ViewportMetricsPtr old_metrics,
       mojo::ViewportMetricsPtr new_metrics) override {
@@ -468,4 +472,123 @@ TEST_F(ViewManagerServiceTest, CloneAndAnimateLargerDepth) {
   EXPECT_TRUE(cloned_view_child->id() == ClonedViewId());
 }
 
+// Verifies bounds changes are batched up, with repeated changes to a view
+// collapsed, until they're flushed or another change is sent.
+TEST_F(ViewManagerServiceTest, BatchBoundsChanges) {
+  const ViewId embed_view_id(wm_connection()->id(), 1);
+  EXPECT_EQ(ERROR_CODE_NONE, wm_connection()->CreateView(embed_view_id));
+  EXPECT_TRUE(wm_connection()->SetViewVisibility(embed_view_id, true));
+  EXPECT_TRUE(
+      wm_connection()->AddView(*(wm_connection()->root()), embed_view_id));
+  wm_connection()->EmbedUrl(std::string(), embed_view_id, nullptr, nullptr);
+  ViewManagerServiceImpl* connection1 =
+      connection_manager()->GetConnectionWithRoot(embed_view_id);
+  ASSERT_TRUE(connection1 != nullptr);
+  ASSERT_NE(connection1, wm_connection());
+
+  const ViewId child1(connection1->id(), 1);
+  EXPECT_EQ(ERROR_CODE_NONE, connection1->CreateView(child1));
+  const ViewId child2(connection1->id(), 2);
+  EXPECT_EQ(ERROR_CODE_NONE, connection1->CreateView(child2));
+  EXPECT_TRUE(connection1->AddView(embed_view_id, child1));
+  EXPECT_TRUE(connection1->AddView(embed_view_id, child2));
+  ServerView* v1 = connection1->GetView(child1);
+  ServerView* v2 = connection1->GetView(child2);
+
+  TestViewManagerClient* connection1_client = last_view_manager_client();
+  connection1_client->tracker()->changes()->clear();
+  std::vector<Change>* wm_changes = wm_client()->tracker()->changes();
+  wm_changes->clear();
+
+  // Changes by |connection1| to the bounds of |v1| collapse into one.
+  for (int i = 1; i <= 3; i++) {
+    ConnectionManager::ScopedChange change(connection1, connection_manager(),
+                                           false);
+    v1->SetBounds(gfx::Rect(0, 0, i * 10, i * 10));
+  }
+  EXPECT_TRUE(wm_changes->empty());
+  connection_manager()->FlushPendingChanges();
+  EXPECT_EQ("BoundsChanged view=2,1 old_bounds=0,0 0x0 new_bounds=0,0 30x30",
+            SingleChangeToDescription(*wm_changes));
+  wm_changes->clear();
+
+  // Changes to more than one view are sent together, in the order the views
+  // first changed.
+  {
+    ConnectionManager::ScopedChange change(connection1, connection_manager(),
+                                           false);
+    v2->SetBounds(gfx::Rect(1, 2, 3, 4));
+    v1->SetBounds(gfx::Rect(5, 6, 7, 8));
+    v2->SetBounds(gfx::Rect(2, 3, 4, 5));
+  }
+  EXPECT_TRUE(wm_changes->empty());
+  connection_manager()->FlushPendingChanges();
+  std::vector<std::string> descriptions = ChangesToDescription1(*wm_changes);
+  ASSERT_EQ(2u, descriptions.size());
+  EXPECT_EQ("BoundsChanged view=2,2 old_bounds=0,0 0x0 new_bounds=2,3 4x5",
+            descriptions[0]);
+  EXPECT_EQ("BoundsChanged view=2,1 old_bounds=0,0 30x30 new_bounds=5,6 7x8",
+            descriptions[1]);
+  wm_changes->clear();
+
+  // A change that's undone isn't sent at all.
+  {
+    ConnectionManager::ScopedChange change(connection1, connection_manager(),
+                                           false);
+    v1->SetBounds(gfx::Rect(0, 0, 30, 30));
+    v1->SetBounds(gfx::Rect(5, 6, 7, 8));
+  }
+  connection_manager()->FlushPendingChanges();
+  EXPECT_TRUE(wm_changes->empty());
+
+  // Pending changes are sent before any other change.
+  {
+    ConnectionManager::ScopedChange change(connection1, connection_manager(),
+                                           false);
+    v1->SetBounds(gfx::Rect(1, 1, 30, 30));
+    v2->SetBounds(gfx::Rect(1, 1, 4, 5));
+    v2->SetVisible(true);
+  }
+  descriptions = ChangesToDescription1(*wm_changes);
+  ASSERT_EQ(3u, descriptions.size());
+  EXPECT_EQ("BoundsChanged view=2,1 old_bounds=5,6 7x8 new_bounds=1,1 30x30",
+            descriptions[0]);
+  EXPECT_EQ("BoundsChanged view=2,2 old_bounds=2,3 4x5 new_bounds=1,1 4x5",
+            descriptions[1]);
+  EXPECT_EQ("VisibilityChanged view=2,2 visible=true", descriptions[2]);
+  wm_changes->clear();
+
+  // Otherwise pending changes are sent once the current task is done.
+  {
+    ConnectionManager::ScopedChange change(connection1, connection_manager(),
+                                           false);
+    v1->SetBounds(gfx::Rect(2, 2, 30, 30));
+  }
+  EXPECT_TRUE(wm_changes->empty());
+  base::MessageLoop::current()->RunUntilIdle();
+  EXPECT_EQ("BoundsChanged view=2,1 old_bounds=1,1 30x30 new_bounds=2,2 30x30",
+            SingleChangeToDescription(*wm_changes));
+  wm_changes->clear();
+
+  // Pending changes are sent before the response to any call.
+  {
+    ConnectionManager::ScopedChange change(connection1, connection_manager(),
+                                           false);
+    v1->SetBounds(gfx::Rect(3, 3, 30, 30));
+  }
+  size_t num_changes_at_response = 0;
+  static_cast<mojo::ViewManagerService*>(wm_connection())
+      ->GetViewTree(ViewIdToTransportId(child1),
+                    [wm_changes, &num_changes_at_response](
+                        Array<ViewDataPtr> views) {
+                      num_changes_at_response = wm_changes->size();
+                    });
+  EXPECT_EQ(1u, num_changes_at_response);
+  EXPECT_EQ("BoundsChanged view=2,1 old_bounds=2,2 30x30 new_bounds=3,3 30x30",
+            SingleChangeToDescription(*wm_changes));
+
+  // The connection that made the changes isn't told about them.
+  EXPECT_TRUE(connection1_client->tracker()->changes()->empty());
+}
+
 }  // namespace view_manager
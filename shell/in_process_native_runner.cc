@@ -20,7 +20,10 @@ InProcessNativeRunner::InProcessNativeRunner(Context* context)
 InProcessNativeRunner::~InProcessNativeRunner() {
   // It is important to let the thread exit before unloading the DSO (when
   // app_library_ is destructed), because the library may have registered
-  // thread-local data and destructors to run on thread termination.
+  // thread-local data and destructors to run on thread termination. (Likewise,
+  // the app must not leave message pipes open with unserialized messages that
+  // it wrote (see |MojoWriteMessageContext()|) queued on them, since the system
+  // would later call into the DSO to destroy them.)
   if (thread_) {
     DCHECK(thread_->HasBeenStarted());
     DCHECK(!thread_->HasBeenJoined());
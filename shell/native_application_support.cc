@@ -14,6 +14,7 @@
 #include "mojo/public/platform/native/gles2_impl_occlusion_query_ext_thunks.h"
 #include "mojo/public/platform/native/gles2_impl_thunks.h"
 #include "mojo/public/platform/native/gles2_thunks.h"
+#include "mojo/public/platform/native/platform_handle_private_thunks.h"
 #include "mojo/public/platform/native/system_impl_private_thunks.h"
 #include "mojo/public/platform/native/system_thunks.h"
 
@@ -69,6 +70,8 @@ bool RunNativeApplication(
             "MojoSetSystemImplControlThunksPrivate", app_library);
   SetThunks(&MojoMakeSystemImplThunksPrivate, "MojoSetSystemImplThunksPrivate",
             app_library);
+  SetThunks(&MojoMakePlatformHandlePrivateThunks,
+            "MojoSetPlatformHandlePrivateThunks", app_library);
 
   if (SetThunks(&MojoMakeGLES2ControlThunks, "MojoSetGLES2ControlThunks",
                 app_library)) {